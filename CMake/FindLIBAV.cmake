@@ -0,0 +1,43 @@
+#ckwg +4
+# Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+# KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+# Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+
+# Locate the system installed FFmpeg/libav libraries used for decoding
+# (libavformat, libavcodec, libavutil and libswscale). The
+# send/receive decoding API is required, which is FFmpeg 3.1 or newer.
+#
+# The following variables will guide the build:
+#
+# LIBAV_ROOT         - Set to the install prefix of the libraries
+#
+# The following variables will be set:
+#
+# LIBAV_FOUND        - Set to true if all libraries can be found
+# LIBAV_INCLUDE_DIRS - The path to the libav header files
+# LIBAV_LIBRARIES    - The full paths to all libav libraries
+
+if( NOT LIBAV_FOUND )
+  include(CommonFindMacros)
+
+  setup_find_root_context(LIBAV)
+  find_path(LIBAV_INCLUDE_DIR libavcodec/avcodec.h
+    PATH_SUFFIXES ffmpeg ${LIBAV_FIND_OPTS})
+  find_library(LIBAV_AVFORMAT_LIBRARY avformat ${LIBAV_FIND_OPTS})
+  find_library(LIBAV_AVCODEC_LIBRARY avcodec ${LIBAV_FIND_OPTS})
+  find_library(LIBAV_AVUTIL_LIBRARY avutil ${LIBAV_FIND_OPTS})
+  find_library(LIBAV_SWSCALE_LIBRARY swscale ${LIBAV_FIND_OPTS})
+  restore_find_root_context(LIBAV)
+
+  include( FindPackageHandleStandardArgs )
+  FIND_PACKAGE_HANDLE_STANDARD_ARGS( LIBAV LIBAV_INCLUDE_DIR
+    LIBAV_AVFORMAT_LIBRARY LIBAV_AVCODEC_LIBRARY
+    LIBAV_AVUTIL_LIBRARY LIBAV_SWSCALE_LIBRARY )
+
+  if( LIBAV_FOUND )
+    set( LIBAV_INCLUDE_DIRS ${LIBAV_INCLUDE_DIR} )
+    # Link order matters for static builds
+    set( LIBAV_LIBRARIES ${LIBAV_AVFORMAT_LIBRARY} ${LIBAV_AVCODEC_LIBRARY}
+                         ${LIBAV_SWSCALE_LIBRARY} ${LIBAV_AVUTIL_LIBRARY} )
+  endif()
+endif()
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -15,6 +15,7 @@
 #include <vector>
 #include <limits>
 #include <fstream>
+#include <string>
 
 #include <boost/shared_ptr.hpp>
 
@@ -66,6 +67,12 @@ public:
 
   // Normalize internal histogram weights to a given absolute sum
   void normalize( weight_t total_weight = 1.0 );
+
+  // Serialize the model into a compact binary buffer
+  void write_binary( std::string& data ) const;
+
+  // Load a model written by write_binary, returns false if it is invalid
+  bool read_binary( const std::string& data );
 };
 
 
@@ -1,14 +1,17 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include "hashed_image_classifier.h"
 
+#include <utilities/config_snapshot.h>
+
 #include <boost/lexical_cast.hpp>
 
 #include <cmath>
+#include <cstring>
 
 #include <logger/logger.h>
 
@@ -135,6 +138,20 @@ bool hashed_image_classifier<FeatureType, OutputType>
 {
   model_.reset( new model_t() );
 
+  // Use the pre-parsed copy of the model from the active snapshot, if any
+  config_snapshot_sptr snapshot = config_snapshot::active();
+  std::string binary_model;
+
+  if( snapshot && snapshot->find_model( "hashed_image_classifier", file, binary_model ) )
+  {
+    if( model_->read_binary( binary_model ) )
+    {
+      return true;
+    }
+
+    model_.reset( new model_t() );
+  }
+
   // Open model file for reading
   std::ifstream input( file.c_str() );
 
@@ -268,6 +285,12 @@ bool hashed_image_classifier<FeatureType, OutputType>
     }
   }
 
+  if( snapshot && snapshot->is_recording() )
+  {
+    model_->write_binary( binary_model );
+    snapshot->add_model( "hashed_image_classifier", file, binary_model );
+  }
+
   return true;
 }
 
@@ -369,6 +392,86 @@ hashed_image_classifier_model<FloatType>
   }
 }
 
+template <typename FloatType>
+void
+hashed_image_classifier_model<FloatType>
+::write_binary( std::string& data ) const
+{
+  // Layout: weight size, feature count, values per feature, all weights
+  const unsigned header[2] = { sizeof( weight_t ), num_features };
+
+  data.assign( reinterpret_cast< const char* >( header ), sizeof( header ) );
+
+  if( num_features > 0 )
+  {
+    data.append( reinterpret_cast< const char* >( &max_feature_value[0] ),
+                 num_features * sizeof( unsigned ) );
+  }
+
+  if( !weights.empty() )
+  {
+    data.append( reinterpret_cast< const char* >( &weights[0] ),
+                 weights.size() * sizeof( weight_t ) );
+  }
+}
+
+template <typename FloatType>
+bool
+hashed_image_classifier_model<FloatType>
+::read_binary( const std::string& data )
+{
+  unsigned header[2];
+
+  if( data.size() < sizeof( header ) )
+  {
+    return false;
+  }
+
+  std::memcpy( header, data.data(), sizeof( header ) );
+
+  const std::size_t table_size = header[1] * sizeof( unsigned );
+
+  if( header[0] != sizeof( weight_t ) || header[1] == 0 ||
+      data.size() < sizeof( header ) + table_size )
+  {
+    return false;
+  }
+
+  std::vector< unsigned > values( header[1] );
+  std::memcpy( &values[0], data.data() + sizeof( header ), table_size );
+
+  std::size_t total_weight_bins = 0;
+
+  for( unsigned i = 0; i < values.size(); i++ )
+  {
+    total_weight_bins += values[i];
+  }
+
+  if( total_weight_bins == 0 ||
+      data.size() != sizeof( header ) + table_size + total_weight_bins * sizeof( weight_t ) )
+  {
+    return false;
+  }
+
+  num_features = header[1];
+  max_feature_value.swap( values );
+  weights.resize( total_weight_bins );
+  feature_weights.resize( num_features );
+
+  std::memcpy( &weights[0], data.data() + sizeof( header ) + table_size,
+               total_weight_bins * sizeof( weight_t ) );
+
+  std::size_t position = 0;
+
+  for( unsigned i = 0; i < num_features; i++ )
+  {
+    feature_weights[i] = &weights[0] + position;
+    position += max_feature_value[i];
+  }
+
+  return is_valid();
+}
+
 template <typename FloatType>
 hashed_image_classifier_model<FloatType>&
 hashed_image_classifier_model<FloatType>
@@ -24,7 +24,8 @@ namespace vidtk
 
 /// Classify every pixel in an image according to a hashed_image_feature
 /// classifier. Can also optionally select different classifiers based on
-/// modality and/or GSD range.
+/// modality and/or GSD range. If a region of interest mask is supplied,
+/// only pixels within it are classified.
 template< typename HashType = vxl_byte, typename OutputType = double >
 class hashed_image_classifier_process
   : public process
@@ -54,6 +55,10 @@ public:
   void set_modality( vidtk::video_modality vm );
   VIDTK_INPUT_PORT( set_modality, vidtk::video_modality );
 
+  /// Set input mask of pixels with computed features, if used
+  void set_roi_mask( vil_image_view<bool> const& mask );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_mask, vil_image_view<bool> const& );
+
   /// Classified output image
   vil_image_view<OutputType> classified_image() const;
   VIDTK_OUTPUT_PORT( vil_image_view<OutputType>, classified_image );
@@ -69,6 +74,7 @@ private:
   // Other parameters
   double lower_gsd_threshold_;
   double upper_gsd_threshold_;
+  OutputType roi_fill_value_;
 
   // Default model
   classifier default_clfr_;
@@ -85,6 +91,7 @@ private:
   const input_features* input_features_;
   double input_gsd_;
   vidtk::video_modality input_modality_;
+  vil_image_view<bool> input_roi_mask_;
 
   // Algorithm outputs
   vil_image_view<OutputType> output_img_;
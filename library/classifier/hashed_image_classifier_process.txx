@@ -20,7 +20,8 @@ hashed_image_classifier_process<HashType,OutputType>
   : process( _name, "hashed_image_classifier_process" ),
     use_variable_models_( false ),
     lower_gsd_threshold_( 0.11 ),
-    upper_gsd_threshold_( 0.22 )
+    upper_gsd_threshold_( 0.22 ),
+    roi_fill_value_( 0 )
 {
   config_.add_parameter( "use_variable_models",
                          "false",
@@ -34,6 +35,10 @@ hashed_image_classifier_process<HashType,OutputType>
                          "0.22",
                          "GSD threshold seperating the middle from highest "
                          "GSD intervals used with variable model selection." );
+  config_.add_parameter( "roi_fill_value",
+                         "0",
+                         "Output value for pixels outside of the region of "
+                         "interest mask, which are not classified." );
   config_.add_parameter( "default_filename",
                          "",
                          "Filename for the default model to use." );
@@ -77,6 +82,7 @@ hashed_image_classifier_process<HashType,OutputType>
   try
   {
     use_variable_models_ = blk.get<bool>( "use_variable_models" );
+    roi_fill_value_ = blk.get<OutputType>( "roi_fill_value" );
 
     // Load default model
 #define LOAD_MODEL_FILE( MODEL, CONFIG_KEY ) \
@@ -193,7 +199,22 @@ hashed_image_classifier_process<HashType,OutputType>
   }
 
   // Perform classification if possible
-  if( to_use->is_valid() )
+  if( to_use->is_valid() && input_roi_mask_ && !input_features_->empty() )
+  {
+    if( input_roi_mask_.ni() != (*input_features_)[0].ni() ||
+        input_roi_mask_.nj() != (*input_features_)[0].nj() )
+    {
+      LOG_ERROR( this->name() << ": roi mask and feature sizes do not match!" );
+      this->reset_inputs();
+      return false;
+    }
+
+    output_img_.set_size( input_roi_mask_.ni(), input_roi_mask_.nj() );
+    output_img_.fill( roi_fill_value_ );
+
+    to_use->classify_images( *input_features_, input_roi_mask_, output_img_, 0.0 );
+  }
+  else if( to_use->is_valid() )
   {
     to_use->classify_images( *input_features_, output_img_, 0.0 );
   }
@@ -218,6 +239,7 @@ hashed_image_classifier_process<HashType,OutputType>
   input_features_ = NULL;
   input_modality_ = VIDTK_INVALID;
   input_gsd_ = -1;
+  input_roi_mask_ = vil_image_view<bool>();
 }
 
 
@@ -238,6 +260,14 @@ hashed_image_classifier_process<HashType,OutputType>
   input_modality_ = vm;
 }
 
+template <typename HashType, typename OutputType>
+void
+hashed_image_classifier_process<HashType,OutputType>
+::set_roi_mask( vil_image_view<bool> const& mask )
+{
+  input_roi_mask_ = mask;
+}
+
 template <typename HashType, typename OutputType>
 void
 hashed_image_classifier_process<HashType,OutputType>
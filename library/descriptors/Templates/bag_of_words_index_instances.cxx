@@ -0,0 +1,10 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <descriptors/bag_of_words_index.txx>
+
+template class vidtk::bag_of_words_index< float >;
+template class vidtk::bag_of_words_index< double >;
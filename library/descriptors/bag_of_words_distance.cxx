@@ -0,0 +1,143 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "bag_of_words_distance.h"
+
+#if VIDTK_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace vidtk
+{
+
+float bow_dot_product( const float* a, const float* b, unsigned n )
+{
+  unsigned i = 0;
+  double sum = 0.0;
+
+#if VIDTK_SSE2
+  // Products of floats are exact in double precision, so the values are
+  // widened before multiplying and accumulated in double precision.
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  for( ; i + 4 <= n; i += 4 )
+  {
+    const __m128 va = _mm_loadu_ps( a + i );
+    const __m128 vb = _mm_loadu_ps( b + i );
+
+    acc0 = _mm_add_pd( acc0, _mm_mul_pd( _mm_cvtps_pd( va ), _mm_cvtps_pd( vb ) ) );
+    acc1 = _mm_add_pd( acc1, _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( va, va ) ),
+                                         _mm_cvtps_pd( _mm_movehl_ps( vb, vb ) ) ) );
+  }
+
+  double lanes[2];
+  _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+  sum = lanes[0] + lanes[1];
+#endif
+
+  for( ; i < n; ++i )
+  {
+    sum += static_cast< double >( a[i] ) * b[i];
+  }
+  return static_cast< float >( sum );
+}
+
+
+double bow_dot_product( const double* a, const double* b, unsigned n )
+{
+  unsigned i = 0;
+  double sum = 0.0;
+
+#if VIDTK_SSE2
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  for( ; i + 4 <= n; i += 4 )
+  {
+    acc0 = _mm_add_pd( acc0, _mm_mul_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) ) );
+    acc1 = _mm_add_pd( acc1, _mm_mul_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) ) );
+  }
+
+  double lanes[2];
+  _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+  sum = lanes[0] + lanes[1];
+#endif
+
+  for( ; i < n; ++i )
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+
+float bow_squared_distance( const float* a, const float* b, unsigned n )
+{
+  unsigned i = 0;
+  double sum = 0.0;
+
+#if VIDTK_SSE2
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  for( ; i + 4 <= n; i += 4 )
+  {
+    const __m128 va = _mm_loadu_ps( a + i );
+    const __m128 vb = _mm_loadu_ps( b + i );
+
+    const __m128d d0 = _mm_sub_pd( _mm_cvtps_pd( va ), _mm_cvtps_pd( vb ) );
+    const __m128d d1 = _mm_sub_pd( _mm_cvtps_pd( _mm_movehl_ps( va, va ) ),
+                                   _mm_cvtps_pd( _mm_movehl_ps( vb, vb ) ) );
+    acc0 = _mm_add_pd( acc0, _mm_mul_pd( d0, d0 ) );
+    acc1 = _mm_add_pd( acc1, _mm_mul_pd( d1, d1 ) );
+  }
+
+  double lanes[2];
+  _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+  sum = lanes[0] + lanes[1];
+#endif
+
+  for( ; i < n; ++i )
+  {
+    const double d = static_cast< double >( a[i] ) - b[i];
+    sum += d * d;
+  }
+  return static_cast< float >( sum );
+}
+
+
+double bow_squared_distance( const double* a, const double* b, unsigned n )
+{
+  unsigned i = 0;
+  double sum = 0.0;
+
+#if VIDTK_SSE2
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128d d0 = _mm_sub_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) );
+    __m128d d1 = _mm_sub_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) );
+    acc0 = _mm_add_pd( acc0, _mm_mul_pd( d0, d0 ) );
+    acc1 = _mm_add_pd( acc1, _mm_mul_pd( d1, d1 ) );
+  }
+
+  double lanes[2];
+  _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+  sum = lanes[0] + lanes[1];
+#endif
+
+  for( ; i < n; ++i )
+  {
+    const double d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+} // end namespace vidtk
@@ -0,0 +1,30 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_descriptor_bag_of_words_distance
+#define vidtk_descriptor_bag_of_words_distance
+
+namespace vidtk
+{
+
+/// \file
+/// Distance kernels used when mapping features onto BoW words. When built
+/// with SSE2 support these process several bins per instruction; the
+/// vectors do not need to be aligned. The float kernels accumulate in
+/// double precision, so their results do not depend on the vector length
+/// beyond the final rounding.
+
+/// Dot product of two vectors of length \a n.
+float bow_dot_product( const float* a, const float* b, unsigned n );
+double bow_dot_product( const double* a, const double* b, unsigned n );
+
+/// Squared euclidean distance between two vectors of length \a n.
+float bow_squared_distance( const float* a, const float* b, unsigned n );
+double bow_squared_distance( const double* a, const double* b, unsigned n );
+
+} // end namespace vidtk
+
+#endif
@@ -0,0 +1,124 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_descriptor_bag_of_words_index
+#define vidtk_descriptor_bag_of_words_index
+
+#include <vector>
+
+class vnl_random;
+
+namespace vidtk
+{
+
+/// An index over the words of a BoW vocabulary for approximate nearest
+/// word queries.
+///
+/// The index is a forest of randomized kd-trees. Each tree splits on a
+/// dimension drawn from those with the highest variance, so the trees
+/// partition the vocabulary differently. A query descends every tree and
+/// then visits the remaining branches of all trees in order of their
+/// distance to the feature, until a given number of words was compared.
+///
+/// Words are also stored contiguously, so that an exhaustive search can
+/// use the index's copy of the vocabulary.
+template < typename WordType >
+class bag_of_words_index
+{
+
+public:
+
+  typedef std::vector< std::vector< WordType > > vocabulary_type;
+
+  /// How features are compared to words. EUCLIDEAN finds the words with
+  /// the smallest euclidean distance, INNER_PRODUCT those with the largest
+  /// dot product with the feature.
+  enum metric_type { EUCLIDEAN, INNER_PRODUCT };
+
+  /// A branch of a tree which remains to be searched.
+  struct branch
+  {
+    unsigned node;
+    WordType distance;
+
+    bool operator>( const branch& other ) const { return distance > other.distance; }
+  };
+
+  /// Working memory of a query, reused across queries to avoid allocations.
+  struct search_buffer
+  {
+    std::vector< unsigned char > checked;
+    std::vector< unsigned > checked_ids;
+    std::vector< branch > branches;
+    std::vector< WordType > distances;
+  };
+
+  bag_of_words_index() : word_length_( 0 ), word_count_( 0 ) {}
+
+  /// Build \a tree_count trees over the given words, replacing any previous
+  /// index. The trees are randomized with the given seed.
+  void build( const vocabulary_type& words, unsigned tree_count, unsigned seed = 0 );
+
+  /// Remove all words and trees.
+  void clear();
+
+  /// \brief Find the nearest words of a feature.
+  ///
+  /// At most \a max_checks words are compared to the feature. The ids of
+  /// the up to \a k nearest words found are written to \a ids, nearest
+  /// first, and their number is returned.
+  unsigned find_nearest( const WordType* feature,
+                         metric_type metric,
+                         unsigned k,
+                         unsigned max_checks,
+                         unsigned* ids,
+                         search_buffer& buffer ) const;
+
+  /// Contiguous copy of the word with the given id.
+  const WordType* word( unsigned id ) const { return &words_[ id * word_length_ ]; }
+
+  unsigned word_count() const { return word_count_; }
+  unsigned word_length() const { return word_length_; }
+  unsigned tree_count() const { return static_cast< unsigned >( roots_.size() ); }
+  bool empty() const { return roots_.empty(); }
+
+private:
+
+  // A split of a tree, or when dim is negative a leaf holding the words
+  // leaf_ids_[ child[0] ] to leaf_ids_[ child[1] - 1 ]
+  struct node
+  {
+    int dim;
+    WordType split;
+    unsigned child[2];
+  };
+
+  // Search state of a query
+  struct query;
+
+  unsigned build_tree( unsigned* ids, unsigned count, vnl_random& rng );
+  void search_tree( unsigned node_id, WordType min_distance, query& q ) const;
+
+  unsigned word_length_;
+  unsigned word_count_;
+
+  // Words stored row by row
+  std::vector< WordType > words_;
+
+  // Difference between the largest squared norm of any word and the
+  // squared norm of each word. Adding it to the euclidean distance of a
+  // word gives a distance which orders words by their dot product with a
+  // feature, so the same trees can answer both metrics.
+  std::vector< WordType > norm_offsets_;
+
+  std::vector< node > nodes_;
+  std::vector< unsigned > leaf_ids_;
+  std::vector< unsigned > roots_;
+};
+
+} // end namespace vidtk
+
+#endif
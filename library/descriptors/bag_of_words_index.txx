@@ -0,0 +1,382 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "bag_of_words_index.h"
+
+#include <descriptors/bag_of_words_distance.h>
+
+#include <vnl/vnl_random.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace vidtk
+{
+
+namespace
+{
+
+// Nodes with at most this many words are not split further
+const unsigned max_leaf_size = 8;
+
+// Number of words sampled to choose the split of a node
+const unsigned split_sample_size = 100;
+
+// The split dimension is drawn from this many dimensions of highest variance
+const unsigned split_candidate_dims = 5;
+
+
+// Word ids ordered by one dimension of the words
+template < typename WordType >
+struct compare_in_dim
+{
+  compare_in_dim( const WordType* w, unsigned l, unsigned d )
+    : words( w ), length( l ), dim( d ) {}
+
+  bool operator()( unsigned a, unsigned b ) const
+  {
+    return words[ a * length + dim ] < words[ b * length + dim ];
+  }
+
+  const WordType* words;
+  unsigned length;
+  unsigned dim;
+};
+
+
+// Word ids with one dimension below a split value
+template < typename WordType >
+struct less_in_dim
+{
+  less_in_dim( const WordType* w, unsigned l, unsigned d, WordType s )
+    : words( w ), length( l ), dim( d ), split( s ) {}
+
+  bool operator()( unsigned id ) const
+  {
+    return words[ id * length + dim ] < split;
+  }
+
+  const WordType* words;
+  unsigned length;
+  unsigned dim;
+  WordType split;
+};
+
+}
+
+
+template < typename WordType >
+struct bag_of_words_index< WordType >::query
+{
+  const WordType* feature;
+  metric_type metric;
+  unsigned k;
+  unsigned max_checks;
+  unsigned* ids;
+  WordType* distances;
+  unsigned found;
+  search_buffer* buffer;
+
+  // Distance a word must beat to enter the result, once it is full
+  WordType worst() const
+  {
+    return found < k ? std::numeric_limits< WordType >::max() : distances[ k - 1 ];
+  }
+
+  bool done() const
+  {
+    return buffer->checked_ids.size() >= max_checks && found == k;
+  }
+};
+
+
+template < typename WordType >
+void
+bag_of_words_index< WordType >
+::build( const vocabulary_type& words, unsigned tree_count, unsigned seed )
+{
+  this->clear();
+
+  if( words.empty() || words[0].empty() )
+  {
+    return;
+  }
+
+  word_count_ = static_cast< unsigned >( words.size() );
+  word_length_ = static_cast< unsigned >( words[0].size() );
+
+  words_.resize( word_count_ * word_length_ );
+  norm_offsets_.resize( word_count_ );
+
+  WordType max_norm = 0;
+  for( unsigned i = 0; i < word_count_; ++i )
+  {
+    std::copy( words[i].begin(), words[i].end(), words_.begin() + i * word_length_ );
+    norm_offsets_[i] = bow_dot_product( word( i ), word( i ), word_length_ );
+    max_norm = std::max( max_norm, norm_offsets_[i] );
+  }
+
+  for( unsigned i = 0; i < word_count_; ++i )
+  {
+    norm_offsets_[i] = max_norm - norm_offsets_[i];
+  }
+
+  vnl_random rng( seed );
+  std::vector< unsigned > ids( word_count_ );
+  nodes_.reserve( 2 * word_count_ * tree_count );
+  leaf_ids_.reserve( word_count_ * tree_count );
+
+  for( unsigned t = 0; t < tree_count; ++t )
+  {
+    for( unsigned i = 0; i < word_count_; ++i )
+    {
+      ids[i] = i;
+    }
+
+    // Shuffle so that each tree samples different words for its splits
+    for( unsigned i = word_count_ - 1; i > 0; --i )
+    {
+      std::swap( ids[i], ids[ rng.lrand32( 0, static_cast< int >( i ) ) ] );
+    }
+
+    const unsigned offset = static_cast< unsigned >( leaf_ids_.size() );
+    leaf_ids_.insert( leaf_ids_.end(), ids.begin(), ids.end() );
+    roots_.push_back( build_tree( &leaf_ids_[ offset ], word_count_, rng ) );
+  }
+}
+
+
+template < typename WordType >
+void
+bag_of_words_index< WordType >
+::clear()
+{
+  word_length_ = 0;
+  word_count_ = 0;
+  words_.clear();
+  norm_offsets_.clear();
+  nodes_.clear();
+  leaf_ids_.clear();
+  roots_.clear();
+}
+
+
+// Build the subtree over the given words and return the id of its root
+template < typename WordType >
+unsigned
+bag_of_words_index< WordType >
+::build_tree( unsigned* ids, unsigned count, vnl_random& rng )
+{
+  const unsigned node_id = static_cast< unsigned >( nodes_.size() );
+  nodes_.push_back( node() );
+
+  if( count <= max_leaf_size )
+  {
+    nodes_[ node_id ].dim = -1;
+    nodes_[ node_id ].child[0] = static_cast< unsigned >( ids - &leaf_ids_[0] );
+    nodes_[ node_id ].child[1] = nodes_[ node_id ].child[0] + count;
+    return node_id;
+  }
+
+  // Mean and variance of each dimension over a sample of the words
+  const unsigned samples = std::min( count, split_sample_size );
+  std::vector< double > mean( word_length_, 0.0 );
+  std::vector< double > var( word_length_, 0.0 );
+
+  for( unsigned i = 0; i < samples; ++i )
+  {
+    const WordType* w = word( ids[i] );
+    for( unsigned d = 0; d < word_length_; ++d )
+    {
+      mean[d] += w[d];
+    }
+  }
+  for( unsigned d = 0; d < word_length_; ++d )
+  {
+    mean[d] /= samples;
+  }
+  for( unsigned i = 0; i < samples; ++i )
+  {
+    const WordType* w = word( ids[i] );
+    for( unsigned d = 0; d < word_length_; ++d )
+    {
+      const double diff = w[d] - mean[d];
+      var[d] += diff * diff;
+    }
+  }
+
+  // Draw the split dimension among those of highest variance
+  std::vector< std::pair< double, unsigned > > dims( word_length_ );
+  for( unsigned d = 0; d < word_length_; ++d )
+  {
+    dims[d] = std::make_pair( var[d], d );
+  }
+
+  const unsigned candidates = std::min( word_length_, split_candidate_dims );
+  std::partial_sort( dims.begin(), dims.begin() + candidates, dims.end(),
+                     std::greater< std::pair< double, unsigned > >() );
+
+  const unsigned dim = dims[ rng.lrand32( 0, static_cast< int >( candidates ) - 1 ) ].second;
+  WordType split = static_cast< WordType >( mean[ dim ] );
+
+  // Words below the split go left
+  unsigned* middle = std::partition( ids, ids + count, less_in_dim< WordType >( &words_[0], word_length_, dim, split ) );
+  unsigned left_count = static_cast< unsigned >( middle - ids );
+
+  // All words on one side, e.g. duplicated words: split the words evenly
+  if( left_count == 0 || left_count == count )
+  {
+    left_count = count / 2;
+    std::nth_element( ids, ids + left_count, ids + count, compare_in_dim< WordType >( &words_[0], word_length_, dim ) );
+    split = word( ids[ left_count ] )[ dim ];
+  }
+
+  const unsigned left = build_tree( ids, left_count, rng );
+  const unsigned right = build_tree( ids + left_count, count - left_count, rng );
+
+  node& n = nodes_[ node_id ];
+  n.dim = static_cast< int >( dim );
+  n.split = split;
+  n.child[0] = left;
+  n.child[1] = right;
+  return node_id;
+}
+
+
+template < typename WordType >
+unsigned
+bag_of_words_index< WordType >
+::find_nearest( const WordType* feature,
+                metric_type metric,
+                unsigned k,
+                unsigned max_checks,
+                unsigned* ids,
+                search_buffer& buffer ) const
+{
+  if( this->empty() || k == 0 )
+  {
+    return 0;
+  }
+
+  query q;
+  q.feature = feature;
+  q.metric = metric;
+  q.k = std::min( k, word_count_ );
+  q.max_checks = std::max( max_checks, 1u );
+  q.ids = ids;
+  q.found = 0;
+  q.buffer = &buffer;
+
+  buffer.distances.resize( q.k );
+  q.distances = &buffer.distances[0];
+  buffer.checked.resize( word_count_, 0 );
+  buffer.checked_ids.clear();
+  buffer.branches.clear();
+
+  for( unsigned t = 0; t < roots_.size(); ++t )
+  {
+    search_tree( roots_[t], 0, q );
+  }
+
+  // Visit the closest remaining branch of any tree
+  std::greater< branch > order;
+
+  while( !buffer.branches.empty() && !q.done() )
+  {
+    std::pop_heap( buffer.branches.begin(), buffer.branches.end(), order );
+    const branch next = buffer.branches.back();
+    buffer.branches.pop_back();
+
+    search_tree( next.node, next.distance, q );
+  }
+
+  for( unsigned i = 0; i < buffer.checked_ids.size(); ++i )
+  {
+    buffer.checked[ buffer.checked_ids[i] ] = 0;
+  }
+
+  return q.found;
+}
+
+
+// Descend to the leaf nearest to the feature, queuing the other branches
+template < typename WordType >
+void
+bag_of_words_index< WordType >
+::search_tree( unsigned node_id, WordType min_distance, query& q ) const
+{
+  search_buffer& buffer = *q.buffer;
+  std::greater< branch > order;
+
+  while( true )
+  {
+    if( min_distance >= q.worst() )
+    {
+      return;
+    }
+
+    const node& n = nodes_[ node_id ];
+
+    if( n.dim >= 0 )
+    {
+      const WordType diff = q.feature[ n.dim ] - n.split;
+      const unsigned near_side = ( diff < 0 ? 0 : 1 );
+
+      branch far;
+      far.node = n.child[ 1 - near_side ];
+      far.distance = min_distance + diff * diff;
+
+      if( far.distance < q.worst() )
+      {
+        buffer.branches.push_back( far );
+        std::push_heap( buffer.branches.begin(), buffer.branches.end(), order );
+      }
+
+      node_id = n.child[ near_side ];
+      continue;
+    }
+
+    // Leaf: compare the words no other tree led to yet
+    for( unsigned i = n.child[0]; i < n.child[1] && !q.done(); ++i )
+    {
+      const unsigned id = leaf_ids_[i];
+
+      if( buffer.checked[ id ] )
+      {
+        continue;
+      }
+
+      buffer.checked[ id ] = 1;
+      buffer.checked_ids.push_back( id );
+
+      WordType distance = bow_squared_distance( q.feature, word( id ), word_length_ );
+      if( q.metric == INNER_PRODUCT )
+      {
+        distance += norm_offsets_[ id ];
+      }
+
+      if( distance >= q.worst() )
+      {
+        continue;
+      }
+
+      // Insert into the sorted result
+      unsigned pos = ( q.found < q.k ? q.found++ : q.k - 1 );
+      while( pos > 0 && q.distances[ pos - 1 ] > distance )
+      {
+        q.distances[ pos ] = q.distances[ pos - 1 ];
+        q.ids[ pos ] = q.ids[ pos - 1 ];
+        --pos;
+      }
+      q.distances[ pos ] = distance;
+      q.ids[ pos ] = id;
+    }
+    return;
+  }
+}
+
+} // end namespace vidtk
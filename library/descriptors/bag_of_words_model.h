@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -7,6 +7,8 @@
 #ifndef vidtk_descriptor_bag_of_words_model
 #define vidtk_descriptor_bag_of_words_model
 
+#include <descriptors/bag_of_words_index.h>
+
 #include <vector>
 #include <string>
 #include <iostream>
@@ -25,9 +27,21 @@ struct bow_mapping_settings
   /// into the top 3 matches based on their simularities.
   enum{ SINGLE_VOTE_UNWEIGHTED, TOP_3_WEIGHTED } voting_method_;
 
+  /// Nearest word search. EXACT compares each feature to every BoW word,
+  /// APPROXIMATE searches the randomized kd-trees built when the model is
+  /// loaded, and may miss the nearest words.
+  enum{ EXACT, APPROXIMATE } search_method_;
+
+  /// Maximum number of words each feature is compared to when using
+  /// APPROXIMATE search. Zero, or at least the vocabulary size, gives an
+  /// exact search.
+  unsigned max_checks_;
+
   // Default values
   bow_mapping_settings() : norm_type_( L1 ),
-                           voting_method_( TOP_3_WEIGHTED ) {}
+                           voting_method_( TOP_3_WEIGHTED ),
+                           search_method_( EXACT ),
+                           max_checks_( 256 ) {}
 };
 
 
@@ -79,7 +93,7 @@ public:
   typedef std::vector< WordType > input_type;
   typedef std::vector< input_type > input_vector_type;
 
-  bag_of_words_model() : is_valid_(false) {}
+  bag_of_words_model() : is_valid_(false), index_tree_count_(4) {}
   virtual ~bag_of_words_model() {}
 
   /// Load a bag of words model from some file
@@ -119,6 +133,13 @@ public:
   /// Return the number of features per word in the loaded vocabulary
   unsigned features_per_word() const;
 
+  /// Set the number of kd-trees used for APPROXIMATE search, rebuilding
+  /// the index of a loaded vocabulary.
+  void set_index_tree_count( unsigned count );
+
+  /// Returns a reference to the index of the loaded vocabulary
+  bag_of_words_index< WordType > const& index() const { return index_; }
+
   // Stream operator overload
   template< typename W, typename M >
   friend std::ostream& operator<<( std::ostream& out, bag_of_words_model<W,M>& model );
@@ -131,6 +152,11 @@ protected:
   // The loaded vocabulary model
   vocabulary_type vocabulary_;
 
+  // Contiguous copy of the vocabulary and kd-trees over it, rebuilt
+  // whenever the vocabulary changes
+  bag_of_words_index< WordType > index_;
+  unsigned index_tree_count_;
+
   // Perform actual mapping between the input features and the BoW model
   virtual bool map_to_model( const WordType** features,
                              const unsigned num_features,
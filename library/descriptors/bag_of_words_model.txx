@@ -1,11 +1,13 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include "bag_of_words_model.h"
 
+#include <descriptors/bag_of_words_distance.h>
+
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -98,6 +100,7 @@ bool bag_of_words_model< WordType, MappingType >
   }
 
   // Mark internal model as being valid
+  index_.build( vocabulary_, index_tree_count_ );
   is_valid_ = true;
   return true;
 }
@@ -108,6 +111,7 @@ bool bag_of_words_model< WordType, MappingType >
 ::set_model( const vocabulary_type& model )
 {
   vocabulary_ = model;
+  index_.build( vocabulary_, index_tree_count_ );
   is_valid_ = true;
   return true;
 }
@@ -180,6 +184,15 @@ bool bag_of_words_model< WordType, MappingType >
   mapping_output.resize( vocabulary_.size() );
   std::fill( mapping_output.begin(), mapping_output.end(), 0 );
 
+  // Searching the trees only pays off when it skips most words
+  const bool use_index = options.search_method_ == bow_mapping_settings::APPROXIMATE &&
+                         !index_.empty() &&
+                         options.max_checks_ > 0 &&
+                         options.max_checks_ < index_.word_count();
+
+  typename bag_of_words_index< WordType >::search_buffer buffer;
+  unsigned found_ids[3];
+
   // Vote into bow descriptor
   if( options.voting_method_ == bow_mapping_settings::TOP_3_WEIGHTED )
   {
@@ -190,34 +203,51 @@ bool bag_of_words_model< WordType, MappingType >
       MappingType top_scores[4] = {-2, -2, -2, -2};
       int top_word_ids[4] = {-1, -1, -1, -1};
 
-      for( int j = 0; j < vocab_size; j++ )
+      if( use_index )
       {
-        int k;
-        MappingType sum = 0;
+        const unsigned found = index_.find_nearest( input_word,
+                                                    bag_of_words_index< WordType >::INNER_PRODUCT,
+                                                    3, options.max_checks_, found_ids, buffer );
 
-        for( k = 0; k < word_size; k++ )
+        for( unsigned k = 0; k < found; k++ )
         {
-          sum += input_word[k] * vocabulary_[j][k];
+          top_word_ids[k] = found_ids[k];
+          top_scores[k] = bow_dot_product( input_word, index_.word( found_ids[k] ), word_size );
         }
-
-        for( k = 2; k >= 0; k-- )
+      }
+      else
+      {
+        for( int j = 0; j < vocab_size; j++ )
         {
-          if( sum > top_scores[k] )
-          {
-            top_scores[k+1] = top_scores[k];
-            top_word_ids[k+1] = top_word_ids[k];
-            top_scores[k] = sum;
-            top_word_ids[k] = j;
-          }
-          else
+          int k;
+          MappingType sum = bow_dot_product( input_word, index_.word( j ), word_size );
+
+          for( k = 2; k >= 0; k-- )
           {
-            break;
+            if( sum > top_scores[k] )
+            {
+              top_scores[k+1] = top_scores[k];
+              top_word_ids[k+1] = top_word_ids[k];
+              top_scores[k] = sum;
+              top_word_ids[k] = j;
+            }
+            else
+            {
+              break;
+            }
           }
         }
       }
-      mapping_output[top_word_ids[0]] += top_scores[0];
-      mapping_output[top_word_ids[1]] += top_scores[1] * 0.5f;
-      mapping_output[top_word_ids[2]] += top_scores[2] * 0.25f;
+
+      // Vocabularies of less than 3 words leave some ids unset
+      const MappingType weights[3] = { 1.0, 0.5, 0.25 };
+      for( int k = 0; k < 3; k++ )
+      {
+        if( top_word_ids[k] >= 0 )
+        {
+          mapping_output[top_word_ids[k]] += top_scores[k] * weights[k];
+        }
+      }
     }
   }
   else if( options.voting_method_ == bow_mapping_settings::SINGLE_VOTE_UNWEIGHTED )
@@ -225,25 +255,36 @@ bool bag_of_words_model< WordType, MappingType >
     for( unsigned int i = 0; i < num_features; i++ )
     {
       int best_id = -1;
-      MappingType min_dist = std::numeric_limits< MappingType >::max();
 
-      for( int j = 0; j < vocab_size; j++ )
+      if( use_index )
       {
-        MappingType sum = 0.0;
-
-        for( int k = 0; k < word_size; k++ )
+        if( index_.find_nearest( features[i],
+                                 bag_of_words_index< WordType >::EUCLIDEAN,
+                                 1, options.max_checks_, found_ids, buffer ) > 0 )
         {
-          MappingType t1 = vocabulary_[ j ][ k ] - features[ i ][ k ];
-          sum += t1 * t1;
+          best_id = found_ids[0];
         }
+      }
+      else
+      {
+        MappingType min_dist = std::numeric_limits< MappingType >::max();
 
-        if( sum < min_dist )
+        for( int j = 0; j < vocab_size; j++ )
         {
-          min_dist = sum;
-          best_id = j;
+          MappingType sum = bow_squared_distance( index_.word( j ), features[ i ], word_size );
+
+          if( sum < min_dist )
+          {
+            min_dist = sum;
+            best_id = j;
+          }
         }
       }
-      mapping_output[ best_id ]++;
+
+      if( best_id >= 0 )
+      {
+        mapping_output[ best_id ]++;
+      }
     }
   }
 
@@ -370,6 +411,7 @@ bool bag_of_words_model< WordType, MappingType >
 
   if( vocabulary_.size() > 0 && vocabulary_[0].size() == options.bins_per_word_ )
   {
+    index_.build( vocabulary_, index_tree_count_ );
     is_valid_ = true;
   }
   return true;
@@ -400,6 +442,18 @@ unsigned bag_of_words_model< WordType, MappingType >
   return ( vocabulary_.empty() ? 0 : vocabulary_[0].size() );
 }
 
+template < typename WordType, typename MappingType >
+void bag_of_words_model< WordType, MappingType >
+::set_index_tree_count( unsigned count )
+{
+  index_tree_count_ = count;
+
+  if( is_valid_ )
+  {
+    index_.build( vocabulary_, index_tree_count_ );
+  }
+}
+
 // Stream operator
 template < typename W, typename M >
 std::ostream& operator<<( std::ostream& out, bag_of_words_model<W,M>& model )
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -29,6 +29,20 @@ namespace vidtk
     std::string, \
     "", \
     "Filename of the BoW vocabulary file" ); \
+  add_param( \
+    approximate_bow_search, \
+    bool, \
+    false, \
+    "Map features to BoW words with a randomized kd-tree search instead " \
+    "of comparing them to every word. Faster on large vocabularies, but " \
+    "may miss the nearest words." ); \
+  add_param( \
+    bow_search_checks, \
+    unsigned int, \
+    256, \
+    "Maximum number of BoW words each feature is compared to when using " \
+    "approximate_bow_search. Larger values find the nearest words more " \
+    "often." ); \
   add_param( \
     num_threads, \
     unsigned int, \
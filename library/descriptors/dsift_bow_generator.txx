@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -56,7 +56,17 @@ dsift_bow_generator<PixType>
 
   if( settings_.bow_filename.size() > 0 && !is_training_mode_ )
   {
-    is_model_loaded_ = computer_.configure( settings_.bow_filename );
+    dsift_settings computer_settings;
+
+    computer_settings.bow_filename = settings_.bow_filename;
+
+    if( settings_.approximate_bow_search )
+    {
+      computer_settings.bow_settings.search_method_ = bow_mapping_settings::APPROXIMATE;
+      computer_settings.bow_settings.max_checks_ = settings_.bow_search_checks;
+    }
+
+    is_model_loaded_ = computer_.configure( computer_settings );
 
     if( !is_model_loaded_ )
     {
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -87,6 +87,20 @@ namespace vidtk
     unsigned, \
     16, \
     "Minimum final image chip dimension required to compute features" ); \
+  add_param( \
+    approximate_bow_search, \
+    bool, \
+    false, \
+    "Map features to BoW words with a randomized kd-tree search instead " \
+    "of comparing them to every word. Faster on large vocabularies, but " \
+    "may miss the nearest words." ); \
+  add_param( \
+    bow_search_checks, \
+    unsigned int, \
+    256, \
+    "Maximum number of BoW words each feature is compared to when using " \
+    "approximate_bow_search. Larger values find the nearest words more " \
+    "often." ); \
   add_param( \
     compute_hessian, \
     bool, \
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -57,6 +57,12 @@ bool mfeat_bow_generator<PixType>
     computer_settings.compute_multiscale_harris = settings_.compute_multiscale_harris;
     computer_settings.compute_mser = settings_.compute_mser;
 
+    if( settings_.approximate_bow_search )
+    {
+      computer_settings.bow_settings.search_method_ = bow_mapping_settings::APPROXIMATE;
+      computer_settings.bow_settings.max_checks_ = settings_.bow_search_checks;
+    }
+
     is_model_loaded_ = computer_.configure( computer_settings );
 
     if( !is_model_loaded_ )
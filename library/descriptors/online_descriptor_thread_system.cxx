@@ -7,6 +7,8 @@
 #include "online_descriptor_thread_system.h"
 #include "online_descriptor_generator.h"
 
+#include <utilities/compute_pool.h>
+
 #include <logger/logger.h>
 
 namespace vidtk
@@ -52,24 +54,6 @@ online_descriptor_thread_system
   LOG_ASSERT( thread_count > 0, "Thread count must exceed 0" );
 
   thread_count_ = thread_count;
-  thread_worker_queues_= new std::queue< task_t >[ thread_count_ ];
-  thread_cond_var_ = new boost::condition_variable[ thread_count_ ];
-  thread_muti_ = new boost::mutex[ thread_count_ ];
-  thread_status_ = new thread_status[ thread_count_ ];
-
-  // Launch worker threads
-  for( unsigned id = 0; id < thread_count_; id++ )
-  {
-    thread_status_[ id ] = THREAD_WAITING;
-
-    threads_.create_thread(
-      boost::bind(
-        &online_descriptor_thread_system::worker_thread,
-        this,
-        id
-      )
-    );
-  }
 }
 
 online_descriptor_thread_system
@@ -82,77 +66,21 @@ void
 online_descriptor_thread_system
 ::shutdown()
 {
-  if( thread_worker_queues_ != NULL )
-  {
-    threads_.interrupt_all();
-    threads_.join_all();
-
-    delete[] thread_worker_queues_;
-    delete[] thread_cond_var_;
-    delete[] thread_muti_;
-    delete[] thread_status_;
-  }
-
-  thread_worker_queues_ = NULL;
-  thread_cond_var_ = NULL;
-  thread_muti_ = NULL;
-  thread_status_ = NULL;
+  // Threads are owned by the shared compute pool, and process_tasks
+  // does not return until all of its tasks have completed.
 }
 
 void
 online_descriptor_thread_system
-::worker_thread( unsigned thread_id )
+::process_range( const std::vector< task_t >* tasks,
+                 std::vector< char >* success,
+                 unsigned first, unsigned last )
 {
-  try
-  {
-    // Get pointers to required objects
-    boost::mutex *thread_mutex = &thread_muti_[thread_id];
-    std::queue< task_t > *thread_queue = &thread_worker_queues_[thread_id];
-    boost::condition_variable *thread_cond_var = &thread_cond_var_[thread_id];
-    thread_status *current_status = &thread_status_[thread_id];
-
-    // Initiate main loop which will execute until interrupted when we are shutting down
-    while( *current_status != THREAD_TERMINATED )
-    {
-      // Wait until we have new data to process
-      {
-        boost::unique_lock<boost::mutex> lock( *thread_mutex );
-        while( *current_status != THREAD_TASKED )
-        {
-          thread_cond_var->timed_wait( lock, boost::posix_time::milliseconds(1000) );
-        }
-      }
-
-      // Update thread status
-      *current_status = THREAD_RUNNING;
-
-      // While there is still data left in our queue
-      bool success = true;
-
-      while( !thread_queue->empty() )
-      {
-        // Pop an entry
-        task_t to_do = thread_queue->front();
-        thread_queue->pop();
-
-        if( !to_do.execute() )
-        {
-          success = false;
-        }
-      }
-
-      // Signal that processing is complete for this thread
-      *current_status = ( success ? THREAD_FINISHED_W_SUCCESS : THREAD_FINISHED_W_FAILURE );
-      thread_cond_var->notify_one();
-    }
-  }
-  catch( boost::thread_interrupted const& )
+  for( unsigned i = first; i < last; ++i )
   {
-    LOG_DEBUG( "Descriptor worker thread " << thread_id << " shutting down." );
-  }
-  catch(...)
-  {
-    LOG_ERROR( "Descriptor worker thread " << thread_id << " has crashed!" );
+    // Tasks only modify the data they reference, so a copy is executed
+    task_t to_do = (*tasks)[i];
+    (*success)[i] = to_do.execute();
   }
 }
 
@@ -160,48 +88,22 @@ bool
 online_descriptor_thread_system
 ::process_tasks( const std::vector< task_t >& tasks )
 {
-  bool ret_flag = true;
-
-  // Assign tasks to threads
-  for( unsigned i = 0; i < tasks.size(); i++ )
-  {
-    thread_worker_queues_[ i % thread_count_ ].push( tasks[i] );
-  }
+  std::vector< char > success( tasks.size(), 1 );
 
-  // Start threads
-  for( unsigned thread_id = 0; thread_id < thread_count_; thread_id++ )
+  try
   {
-    if( thread_worker_queues_[ thread_id ].size() != 0 )
-    {
-      thread_status_[ thread_id ] = THREAD_TASKED;
-      thread_cond_var_[ thread_id ].notify_one();
-    }
-    else
-    {
-      thread_status_[ thread_id ] = THREAD_FINISHED_W_SUCCESS;
-    }
+    compute_pool::instance()->parallel_for(
+      0, tasks.size(),
+      boost::bind( &online_descriptor_thread_system::process_range, &tasks, &success, _1, _2 ),
+      "online_descriptor_generator", thread_count_ );
   }
-
-  // Wait for all threads to finish their jobs
-  for( unsigned thread_id = 0; thread_id < thread_count_; thread_id++ )
+  catch( std::exception const& e )
   {
-    boost::unique_lock<boost::mutex> lock( this->thread_muti_[ thread_id ] );
-
-    while( thread_status_[ thread_id ] != THREAD_FINISHED_W_SUCCESS &&
-           thread_status_[ thread_id ] != THREAD_FINISHED_W_FAILURE )
-    {
-      thread_cond_var_[ thread_id ].timed_wait( lock, boost::posix_time::milliseconds(1000) );
-    }
-
-    if( thread_status_[ thread_id ] == THREAD_FINISHED_W_FAILURE )
-    {
-      ret_flag = false;
-    }
-
-    thread_status_[ thread_id ] = THREAD_WAITING;
+    LOG_ERROR( "Descriptor worker task has crashed: " << e.what() );
+    return false;
   }
 
-  return ret_flag;
+  return std::find( success.begin(), success.end(), 0 ) == success.end();
 }
 
 } // end namespace vidtk
@@ -75,7 +75,10 @@ private:
 
 };
 
-/// Variables used for the online_descriptor_generator threading sub-system.
+/// \brief The online_descriptor_generator threading sub-system.
+///
+/// Tasks are split into contiguous groups, one per thread, which are run
+/// on the shared compute_pool.
 class online_descriptor_thread_system
 {
 public:
@@ -93,29 +96,13 @@ public:
 
 private:
 
-  // Thread status definition
-  enum thread_status
-  {
-    THREAD_WAITING = 0,
-    THREAD_TASKED = 1,
-    THREAD_RUNNING = 2,
-    THREAD_FINISHED_W_SUCCESS = 3,
-    THREAD_FINISHED_W_FAILURE = 4,
-    THREAD_TERMINATED = 5
-  };
-
-  // Number of threads
+  // Maximum number of threads to use
   unsigned thread_count_;
 
-  // Each of these will have thread_count instances
-  boost::thread_group threads_;
-  boost::condition_variable *thread_cond_var_;
-  boost::mutex *thread_muti_;
-  thread_status *thread_status_;
-  std::queue< task_t > *thread_worker_queues_;
-
-  // Worker thread main execution definition
-  void worker_thread( unsigned thread_id );
+  // Execute a contiguous range of tasks, recording failures
+  static void process_range( const std::vector< task_t >* tasks,
+                             std::vector< char >* success,
+                             unsigned first, unsigned last );
 };
 
 } // end namespace vidtk
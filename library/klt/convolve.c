@@ -551,4 +551,84 @@ void _KLTComputeSmoothedImage(
 
 
 
+
+/*********************************************************************
+ * _KLTComputeSubsampledSmoothedImage
+ *
+ * Equivalent to smoothing with _KLTComputeSmoothedImage and then
+ * keeping every subsampling-th pixel, starting at subsampling/2, but
+ * only convolves the columns and rows which are kept.  The output
+ * image is (ncols/subsampling) x (nrows/subsampling).
+ */
+
+void _KLTComputeSubsampledSmoothedImage(
+  _KLT_FloatImage img,
+  float sigma,
+  int subsampling,
+  _KLT_FloatImage smooth)
+{
+  _KLT_FloatImage tmpimg;
+  ConvolutionKernel kernel;
+  int radius;
+  int ncols = img->ncols, nrows = img->nrows;
+  int sub_ncols = ncols / subsampling, sub_nrows = nrows / subsampling;
+  int subhalf = subsampling / 2;
+  int i, j, k, c, r;
+  float *ppp, *ptrout;
+  float sum;
+
+  assert(subsampling > 0);
+
+  /* Output image must be large enough to hold result */
+  assert(smooth->ncols >= sub_ncols);
+  assert(smooth->nrows >= sub_nrows);
+
+  /* Compute kernel, if necessary; gauss_deriv is not used */
+  if (fabs(sigma - sigma_last) > 0.05)
+    _computeKernels(sigma, &gauss_kernel, &gaussderiv_kernel);
+
+  kernel = gauss_kernel;
+  radius = kernel.width / 2;
+
+  /* Horizontal pass over all rows, but only the kept columns */
+  tmpimg = _KLTCreateFloatImage(sub_ncols, nrows);
+  ptrout = tmpimg->data;
+
+  for (j = 0 ; j < nrows ; j++)  {
+    for (i = 0 ; i < sub_ncols ; i++)  {
+      c = subsampling * i + subhalf;
+      sum = 0.0f;
+      if (c >= radius && c < ncols - radius)  {
+        ppp = img->data + j * ncols + c - radius;
+        for (k = kernel.width-1 ; k >= 0 ; k--)
+          sum += *ppp++ * kernel.data[k];
+      }
+      *ptrout++ = sum;
+    }
+  }
+
+  /* Vertical pass over the kept rows */
+  smooth->ncols = sub_ncols;
+  smooth->nrows = sub_nrows;
+  ptrout = smooth->data;
+
+  for (j = 0 ; j < sub_nrows ; j++)  {
+    r = subsampling * j + subhalf;
+    for (i = 0 ; i < sub_ncols ; i++)  {
+      sum = 0.0f;
+      if (r >= radius && r < nrows - radius)  {
+        ppp = tmpimg->data + (r - radius) * sub_ncols + i;
+        for (k = kernel.width-1 ; k >= 0 ; k--)  {
+          sum += *ppp * kernel.data[k];
+          ppp += sub_ncols;
+        }
+      }
+      *ptrout++ = sum;
+    }
+  }
+
+  _KLTFreeFloatImage(tmpimg);
+}
+
+
 /* Copyright: public domain */
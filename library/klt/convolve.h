@@ -33,6 +33,12 @@ void _KLTComputeSmoothedImage(
   float sigma,
   _KLT_FloatImage smooth);
 
+void _KLTComputeSubsampledSmoothedImage(
+  _KLT_FloatImage img,
+  float sigma,
+  int subsampling,
+  _KLT_FloatImage smooth);
+
 #ifdef __cplusplus
 }
 #endif
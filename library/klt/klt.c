@@ -125,6 +125,10 @@ KLT_TrackingContext KLTCreateTrackingContext()
   tc->affine_max_residue = affine_max_residue;
   tc->affine_min_displacement = affine_min_displacement;
   tc->affine_max_displacement_differ = affine_max_displacement_differ;
+  tc->grid_cols = 0;
+  tc->grid_rows = 0;
+  tc->parallel_for = NULL;
+  tc->parallel_for_data = NULL;
 
   /* Change nPyramidLevels and subsampling */
   KLTChangeTCPyramid(tc, search_range);
@@ -272,6 +276,8 @@ void KLTPrintTrackingContext(
   fprintf(stderr, "\tbordery = %d\n", tc->bordery);
   fprintf(stderr, "\tnPyramidLevels = %d\n", tc->nPyramidLevels);
   fprintf(stderr, "\tsubsampling = %d\n", tc->subsampling);
+  fprintf(stderr, "\tgrid_cols = %d\n", tc->grid_cols);
+  fprintf(stderr, "\tgrid_rows = %d\n", tc->grid_rows);
 
   fprintf(stderr, "\n\tpyramid_last = %s\n", (tc->pyramid_last!=NULL) ?
           "points to old image" : "NULL");
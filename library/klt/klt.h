@@ -39,6 +39,14 @@ typedef unsigned char KLT_PixelType;
  * Structures
  */
 
+/* Called with a range [begin,end) of work items, such as features to track */
+typedef void (*KLT_RangeFunction)(void *data, int begin, int end);
+
+/* Calls func on disjoint ranges covering [begin,end), possibly concurrently, */
+/* and returns once all of them are done */
+typedef void (*KLT_ParallelFor)(void *user_data, int begin, int end,
+                                KLT_RangeFunction func, void *func_data);
+
 typedef struct  {
   /* Available to user */
   int mindist;               /* min distance b/w features */
@@ -83,6 +91,14 @@ typedef struct  {
   float affine_max_displacement_differ; /* th for the difference between the displacement calculated
   by the affine tracker and the frame to frame tracker in pel*/
 
+  /* for selecting features per cell of a grid (not in original algorithm) */
+  int grid_cols, grid_rows;      /* cells across and down the image, 0 to select over */
+                                 /* the whole image */
+
+  /* for tracking and selecting features on several threads (not in original algorithm) */
+  KLT_ParallelFor parallel_for;  /* NULL to track and select on the calling thread */
+  void *parallel_for_data;       /* passed to parallel_for */
+
   /* User must not touch these */
   _KLT_Pyramid pyramid_last;
   _KLT_Pyramid pyramid_last_gradx;
@@ -191,6 +207,16 @@ void KLTTrackFeaturesPyramid(
   int nrows,
   const float *homog_initial,
   KLT_FeatureList fl);
+void KLTTrackFeaturesPyramidLevels(
+  KLT_TrackingContext tc,
+  KLT_TrackingPyramid pyramid1,
+  KLT_TrackingPyramid pyramid2,
+  int ncols,
+  int nrows,
+  const float *homog_initial,
+  int coarsest_level,
+  int finest_level,
+  KLT_FeatureList fl);
 void KLTReplaceLostFeatures(
   KLT_TrackingContext tc,
   KLT_PixelType *img,
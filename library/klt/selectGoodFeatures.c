@@ -19,8 +19,17 @@
 #include "klt_util.h"
 #include "pyramid.h"
 
+#if VIDTK_SSE2
+#include <xmmintrin.h>
+#endif
+
 extern int KLT_verbose;
 
+/* Number of candidates kept per cell of the selection grid, for each */
+/* feature the cell would get if features were spread evenly.  The */
+/* extra candidates replace those removed by the minimum distance. */
+#define GRID_CANDIDATES_PER_FEATURE 4
+
 typedef enum {SELECTING_ALL, REPLACING_SOME} selectionMode;
 
 
@@ -292,6 +301,357 @@ static float _minEigenvalue(float gxx, float gxy, float gyy)
 }
 	
 
+/*********************************************************************
+ * _computeResponseRows
+ *
+ * Computes the minimum eigenvalue of the gradient matrix of the window
+ * around each pixel of the rows [begin,end) of a _ResponseArgs.  The
+ * window sums are box filtered: each row of the window is summed
+ * down the columns, then along the row, four pixels at a time with SSE.
+ */
+
+typedef struct  {
+  _KLT_FloatImage gradx;
+  _KLT_FloatImage grady;
+  int window_hw, window_hh;
+  int borderx;                 /* columns [borderx,ncols-borderx) are computed */
+  float *response;             /* output, ncols by nrows */
+}  _ResponseArgs;
+
+static void _computeResponseRows(
+  void *data,
+  int begin,
+  int end)
+{
+  _ResponseArgs *args = (_ResponseArgs *) data;
+  int ncols = args->gradx->ncols;
+  int hw = args->window_hw, hh = args->window_hh;
+  int x0 = args->borderx, x1 = ncols - args->borderx;
+  int c0 = x0 - hw, c1 = x1 + hw;    /* columns summed down the window */
+  float *sxx, *sxy, *syy;
+  register float gx, gy;
+  register int x, y, yy, k;
+
+  sxx = (float *) malloc(3 * ncols * sizeof(float));
+  if (sxx == NULL)  KLTError("(_computeResponseRows) Out of memory.");
+  sxy = sxx + ncols;
+  syy = sxy + ncols;
+
+  for (y = begin ; y < end ; y++)  {
+    float *out = args->response + y * ncols;
+
+    /* Sum down the columns of the window */
+    x = c0;
+#if VIDTK_SSE2
+    for ( ; x + 4 <= c1 ; x += 4)  {
+      __m128 vxx = _mm_setzero_ps(), vxy = _mm_setzero_ps(), vyy = _mm_setzero_ps();
+      for (yy = y - hh ; yy <= y + hh ; yy++)  {
+        __m128 vgx = _mm_loadu_ps(args->gradx->data + yy * ncols + x);
+        __m128 vgy = _mm_loadu_ps(args->grady->data + yy * ncols + x);
+        vxx = _mm_add_ps(vxx, _mm_mul_ps(vgx, vgx));
+        vxy = _mm_add_ps(vxy, _mm_mul_ps(vgx, vgy));
+        vyy = _mm_add_ps(vyy, _mm_mul_ps(vgy, vgy));
+      }
+      _mm_storeu_ps(sxx + x, vxx);
+      _mm_storeu_ps(sxy + x, vxy);
+      _mm_storeu_ps(syy + x, vyy);
+    }
+#endif
+    for ( ; x < c1 ; x++)  {
+      float gxx = 0, gxy = 0, gyy = 0;
+      for (yy = y - hh ; yy <= y + hh ; yy++)  {
+        gx = args->gradx->data[yy * ncols + x];
+        gy = args->grady->data[yy * ncols + x];
+        gxx += gx * gx;
+        gxy += gx * gy;
+        gyy += gy * gy;
+      }
+      sxx[x] = gxx;  sxy[x] = gxy;  syy[x] = gyy;
+    }
+
+    /* Sum along the row, and take the minimum eigenvalue */
+    x = x0;
+#if VIDTK_SSE2
+    {
+      __m128 half = _mm_set1_ps(0.5f), four = _mm_set1_ps(4.0f);
+      for ( ; x + 4 <= x1 ; x += 4)  {
+        __m128 vxx = _mm_setzero_ps(), vxy = _mm_setzero_ps(), vyy = _mm_setzero_ps();
+        __m128 diff, root;
+        for (k = -hw ; k <= hw ; k++)  {
+          vxx = _mm_add_ps(vxx, _mm_loadu_ps(sxx + x + k));
+          vxy = _mm_add_ps(vxy, _mm_loadu_ps(sxy + x + k));
+          vyy = _mm_add_ps(vyy, _mm_loadu_ps(syy + x + k));
+        }
+        diff = _mm_sub_ps(vxx, vyy);
+        root = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(diff, diff),
+                                      _mm_mul_ps(four, _mm_mul_ps(vxy, vxy))));
+        _mm_storeu_ps(out + x,
+                      _mm_mul_ps(half, _mm_sub_ps(_mm_add_ps(vxx, vyy), root)));
+      }
+    }
+#endif
+    for ( ; x < x1 ; x++)  {
+      float gxx = 0, gxy = 0, gyy = 0;
+      for (k = -hw ; k <= hw ; k++)  {
+        gxx += sxx[x + k];
+        gxy += sxy[x + k];
+        gyy += syy[x + k];
+      }
+      out[x] = _minEigenvalue(gxx, gxy, gyy);
+    }
+  }
+
+  free(sxx);
+}
+
+
+/*********************************************************************
+ * _selectTopPoints
+ *
+ * Partially orders a pointlist so that its first k points are those
+ * with the largest values, in no particular order.
+ */
+
+static void _swapPoints(int *pointlist, int i, int j)
+{
+  int tmp, n;
+  for (n = 0 ; n < 3 ; n++)  {
+    tmp = pointlist[3*i+n];
+    pointlist[3*i+n] = pointlist[3*j+n];
+    pointlist[3*j+n] = tmp;
+  }
+}
+
+static void _selectTopPoints(int *pointlist, int npoints, int k)
+{
+  int lo = 0, hi = npoints - 1;
+
+  while (lo < hi)  {
+    int pivot = pointlist[3*((lo + hi)/2)+2];
+    int i = lo, j = hi;
+
+    while (i <= j)  {
+      while (pointlist[3*i+2] > pivot)  i++;
+      while (pointlist[3*j+2] < pivot)  j--;
+      if (i <= j)  {
+        _swapPoints(pointlist, i, j);
+        i++;  j--;
+      }
+    }
+
+    /* Now [lo,j] are at least, and [i,hi] at most, the pivot */
+    if (k - 1 <= j)  hi = j;
+    else if (k - 1 >= i)  lo = i;
+    else  break;
+  }
+}
+
+
+/*********************************************************************
+ * _selectCellCandidates
+ *
+ * Finds the local maxima of the response in each cell [begin,end) of
+ * the grid of a _CellArgs, and keeps the best max_per_cell of them,
+ * sorted in descending order of value.
+ */
+
+typedef struct  {
+  const float *response;
+  int ncols;
+  int x0, x1, y0, y1;          /* region of the image covered by the grid */
+  int grid_cols, grid_rows;
+  int min_eigenvalue;
+  int max_per_cell;
+  int *cell_points;            /* max_per_cell points for each cell */
+  int *cell_count;             /* number of points kept for each cell */
+}  _CellArgs;
+
+static void _selectCellCandidates(
+  void *data,
+  int begin,
+  int end)
+{
+  _CellArgs *args = (_CellArgs *) data;
+  int ncols = args->ncols;
+  int width = args->x1 - args->x0, height = args->y1 - args->y0;
+  int max_cell = (width / args->grid_cols + 1) * (height / args->grid_rows + 1);
+  int *candidates;
+  int cell;
+
+  /* Largest float which converts to an int */
+  const float limit = 2147483520.0f;
+
+  candidates = (int *) malloc(max_cell * 3 * sizeof(int));
+  if (candidates == NULL)  KLTError("(_selectCellCandidates) Out of memory.");
+
+  for (cell = begin ; cell < end ; cell++)  {
+    int cx = cell % args->grid_cols, cy = cell / args->grid_cols;
+    int xs = args->x0 + cx * width / args->grid_cols;
+    int xe = args->x0 + (cx + 1) * width / args->grid_cols;
+    int ys = args->y0 + cy * height / args->grid_rows;
+    int ye = args->y0 + (cy + 1) * height / args->grid_rows;
+    int npoints = 0;
+    int x, y;
+
+    for (y = ys ; y < ye ; y++)  {
+      const float *ptr = args->response + y * ncols;
+      for (x = xs ; x < xe ; x++)  {
+        float val = ptr[x];
+
+        /* Keep the local maxima, breaking ties in raster order */
+        if (val < args->min_eigenvalue ||
+            !(val > ptr[x-1] && val >= ptr[x+1] &&
+              val > ptr[x-ncols-1] && val > ptr[x-ncols] && val > ptr[x-ncols+1] &&
+              val >= ptr[x+ncols-1] && val >= ptr[x+ncols] && val >= ptr[x+ncols+1]))
+          continue;
+
+        candidates[3*npoints]   = x;
+        candidates[3*npoints+1] = y;
+        candidates[3*npoints+2] = (int) ((val > limit) ? limit : val);
+        npoints++;
+      }
+    }
+
+    if (npoints > args->max_per_cell)  {
+      _selectTopPoints(candidates, npoints, args->max_per_cell);
+      npoints = args->max_per_cell;
+    }
+    _quicksort(candidates, npoints);
+
+    memcpy(args->cell_points + 3 * args->max_per_cell * cell, candidates,
+           3 * npoints * sizeof(int));
+    args->cell_count[cell] = npoints;
+  }
+
+  free(candidates);
+}
+
+
+/*********************************************************************
+ * _gridPointList
+ *
+ * Creates the pointlist for selecting features per cell of a grid.
+ * Rather than sorting every pixel, only the best local maxima of each
+ * cell are kept, and the list is ordered by their rank within their
+ * cell, then by value.  The best point of every cell thus comes
+ * before the second best of any, and so on.  When replacing features,
+ * the features still tracked count towards the rank, so the cells
+ * with the fewest features are filled first.
+ *
+ * The response is computed, and the cells searched, on several
+ * threads if tc->parallel_for is set.  The nSkippedPixels field is
+ * not used.
+ *
+ * RETURNS
+ * The number of points in the list.
+ */
+
+static int _gridPointList(
+  KLT_TrackingContext tc,
+  _KLT_FloatImage gradx,
+  _KLT_FloatImage grady,
+  KLT_FeatureList featurelist,
+  KLT_BOOL overwriteAllFeatures,
+  int borderx,
+  int bordery,
+  int **pointlist)
+{
+  int ncols = gradx->ncols, nrows = gradx->nrows;
+  int ncells = tc->grid_cols * tc->grid_rows;
+  int *existing, *ptr;
+  int npoints = 0, total = 0, max_rank = 0;
+  int cell, rank, indx;
+  _ResponseArgs response_args;
+  _CellArgs cell_args;
+
+  if (ncols - 2*borderx <= 0 || nrows - 2*bordery <= 0)  {
+    *pointlist = (int *) malloc(3 * sizeof(int));
+    return 0;
+  }
+
+  /* Response is zero outside the computed region, so that points */
+  /* on its edge can be compared to their neighbors */
+  response_args.gradx = gradx;
+  response_args.grady = grady;
+  response_args.window_hw = tc->window_width/2;
+  response_args.window_hh = tc->window_height/2;
+  response_args.borderx = borderx;
+  response_args.response = (float *) calloc(ncols * nrows, sizeof(float));
+  if (response_args.response == NULL)
+    KLTError("(_gridPointList) Out of memory.");
+
+  cell_args.response = response_args.response;
+  cell_args.ncols = ncols;
+  cell_args.x0 = borderx;
+  cell_args.x1 = ncols - borderx;
+  cell_args.y0 = bordery;
+  cell_args.y1 = nrows - bordery;
+  cell_args.grid_cols = tc->grid_cols;
+  cell_args.grid_rows = tc->grid_rows;
+  cell_args.min_eigenvalue = (tc->min_eigenvalue < 1) ? 1 : tc->min_eigenvalue;
+  cell_args.max_per_cell = GRID_CANDIDATES_PER_FEATURE *
+    ((featurelist->nFeatures + ncells - 1) / ncells);
+  cell_args.cell_points = (int *) malloc(ncells * cell_args.max_per_cell * 3 * sizeof(int));
+  cell_args.cell_count = (int *) malloc(ncells * sizeof(int));
+  existing = (int *) calloc(ncells, sizeof(int));
+  if (cell_args.cell_points == NULL || cell_args.cell_count == NULL || existing == NULL)
+    KLTError("(_gridPointList) Out of memory.");
+
+  if (tc->parallel_for != NULL)  {
+    tc->parallel_for(tc->parallel_for_data, bordery, nrows - bordery,
+                     _computeResponseRows, &response_args);
+    tc->parallel_for(tc->parallel_for_data, 0, ncells,
+                     _selectCellCandidates, &cell_args);
+  } else  {
+    _computeResponseRows(&response_args, bordery, nrows - bordery);
+    _selectCellCandidates(&cell_args, 0, ncells);
+  }
+
+  /* Count the features kept in each cell */
+  if (!overwriteAllFeatures)
+    for (indx = 0 ; indx < featurelist->nFeatures ; indx++)  {
+      KLT_Feature f = featurelist->feature[indx];
+      int cx, cy;
+      if (f->val < 0)  continue;
+      cx = ((int) f->x - cell_args.x0) * tc->grid_cols / (cell_args.x1 - cell_args.x0);
+      cy = ((int) f->y - cell_args.y0) * tc->grid_rows / (cell_args.y1 - cell_args.y0);
+      if (cx >= 0 && cx < tc->grid_cols && cy >= 0 && cy < tc->grid_rows)
+        existing[cy * tc->grid_cols + cx]++;
+    }
+
+  for (cell = 0 ; cell < ncells ; cell++)  {
+    total += cell_args.cell_count[cell];
+    if (existing[cell] + cell_args.cell_count[cell] > max_rank)
+      max_rank = existing[cell] + cell_args.cell_count[cell];
+  }
+
+  /* Order the points by rank in their cell, then by value */
+  *pointlist = (int *) malloc((total > 0 ? total : 1) * 3 * sizeof(int));
+  if (*pointlist == NULL)  KLTError("(_gridPointList) Out of memory.");
+  ptr = *pointlist;
+  for (rank = 0 ; rank < max_rank ; rank++)  {
+    int first = npoints;
+    for (cell = 0 ; cell < ncells ; cell++)  {
+      int i = rank - existing[cell];
+      if (i >= 0 && i < cell_args.cell_count[cell])  {
+        memcpy(ptr, cell_args.cell_points + 3 * (cell_args.max_per_cell * cell + i),
+               3 * sizeof(int));
+        ptr += 3;
+        npoints++;
+      }
+    }
+    _quicksort(*pointlist + 3 * first, npoints - first);
+  }
+
+  free(response_args.response);
+  free(cell_args.cell_points);
+  free(cell_args.cell_count);
+  free(existing);
+
+  return npoints;
+}
+
+
 /*********************************************************************/
 
 void _KLTSelectGoodFeaturesRaw(
@@ -305,13 +665,10 @@ void _KLTSelectGoodFeaturesRaw(
   int window_hw, window_hh;
   int *pointlist;
   int npoints = 0;
+  int borderx, bordery;
   KLT_BOOL overwriteAllFeatures = (mode == SELECTING_ALL) ?
     TRUE : FALSE;
 
-  /* Create pointlist, which is a simplified version of a featurelist, */
-  /* for speed.  Contains only integer locations and values. */
-  pointlist = (int *) malloc(img->ncols * img->nrows * 3 * sizeof(int));
-
   /* Check window size (and correct if necessary) */
   if (tc->window_width % 2 != 1) {
     tc->window_width = tc->window_width+1;
@@ -335,23 +692,32 @@ void _KLTSelectGoodFeaturesRaw(
   }
   window_hw = tc->window_width/2; 
   window_hh = tc->window_height/2;
-		
+
+  borderx = tc->borderx;	/* Must not touch cols */
+  bordery = tc->bordery;	/* lost by convolution */
+  if (borderx < window_hw)  borderx = window_hw;
+  if (bordery < window_hh)  bordery = window_hh;
+
   /* Compute trackability of each image pixel as the minimum
-     of the two eigenvalues of the Z matrix */
-  {
+     of the two eigenvalues of the Z matrix, and sort the pixels */
+  if (tc->grid_cols > 0 && tc->grid_rows > 0)  {
+    /* Only keep the best points of each cell of a grid */
+    npoints = _gridPointList(tc, gradx, grady, featurelist,
+                             overwriteAllFeatures, borderx, bordery,
+                             &pointlist);
+  } else  {
     register float gx, gy;
     register float gxx, gxy, gyy;
     register int xx, yy;
     register int *ptr;
     float val;
     unsigned int limit = 1;
-    int borderx = tc->borderx;	/* Must not touch cols */
-    int bordery = tc->bordery;	/* lost by convolution */
     int x, y;
     int i;
-	
-    if (borderx < window_hw)  borderx = window_hw;
-    if (bordery < window_hh)  bordery = window_hh;
+
+    /* Create pointlist, which is a simplified version of a featurelist, */
+    /* for speed.  Contains only integer locations and values. */
+    pointlist = (int *) malloc(img->ncols * img->nrows * 3 * sizeof(int));
 
     /* Find largest value of an int */
     for (i = 0 ; i < sizeof(int) ; i++)  limit *= 256;
@@ -390,10 +756,10 @@ void _KLTSelectGoodFeaturesRaw(
         *ptr++ = (int) val;
         npoints++;
       }
+
+    /* Sort the features  */
+    _sortPointList(pointlist, npoints);
   }
-			
-  /* Sort the features  */
-  _sortPointList(pointlist, npoints);
 
   /* Check tc->mindist */
   if (tc->mindist < 0)  {
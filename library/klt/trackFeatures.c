@@ -17,10 +17,30 @@
 #include "klt_util.h" /* _KLT_FloatImage */
 #include "pyramid.h" /* _KLT_Pyramid */
 
+#if VIDTK_SSE2
+#include <xmmintrin.h>
+#endif
+
 extern int KLT_verbose;
 
+/* Fewer features are tracked on the calling thread, since splitting */
+/* them costs more than it saves */
+#define KLT_MIN_PARALLEL_FEATURES 256
+
 typedef float *_FloatWindow;
 
+/* Windows and sampling tables used while tracking features.  One */
+/* workspace is allocated for all the features tracked by a thread. */
+typedef struct  {
+  int width, height;
+  _FloatWindow img1, gradx1, grady1;  /* first image, sampled once per level */
+  _FloatWindow img2, gradx2, grady2;  /* second image, sampled per iteration */
+  _FloatWindow imgdiff, gradx, grady;
+  int *xt, *yt;       /* integer part of the sample coordinates */
+  float *ax, *ay;     /* fractional part of the sample coordinates */
+  float *bx, *by;     /* one minus the fractional part */
+}  _TrackWorkspaceRec, *_TrackWorkspace;
+
 /*********************************************************************
  * _interpolate
  *
@@ -57,6 +77,158 @@ static float _interpolate(
 }
 
 
+/*********************************************************************
+ * _sampleWindows
+ *
+ * Computes the bilinear interpolated gray-level values of a window
+ * centered at (x,y) in one or more images of the same size.  The
+ * interpolation weights only depend on the row and column within the
+ * window, so they are computed once and shared by all the images, and
+ * each row is interpolated four pixels at a time with SSE.  The
+ * arithmetic is that of _interpolate(), so the values are identical.
+ */
+
+static void _sampleWindows(
+  _KLT_FloatImage *imgs,  /* images, all of the same size */
+  _FloatWindow *out,      /* output windows, one per image */
+  int nimgs,
+  float x, float y,       /* center of window */
+  _TrackWorkspace ws)
+{
+  int width = ws->width, height = ws->height;
+  int hw = width/2, hh = height/2;
+  int ncols = imgs[0]->ncols;
+  KLT_BOOL contiguous = TRUE;
+  register int i, j, k;
+
+  /* Sample coordinates, computed as in _interpolate() */
+  for (i = 0 ; i < width ; i++)  {
+    float xi = x + (i - hw);
+    ws->xt[i] = (int) xi;
+    ws->ax[i] = xi - ws->xt[i];
+    ws->bx[i] = 1 - ws->ax[i];
+    if (ws->xt[i] != ws->xt[0] + i)  contiguous = FALSE;
+  }
+  for (j = 0 ; j < height ; j++)  {
+    float yj = y + (j - hh);
+    ws->yt[j] = (int) yj;
+    ws->ay[j] = yj - ws->yt[j];
+    ws->by[j] = 1 - ws->ay[j];
+  }
+
+  /* Rounding can make two columns share a pixel; rare enough to */
+  /* simply interpolate each pixel */
+  if (!contiguous)  {
+    for (k = 0 ; k < nimgs ; k++)  {
+      float *ptrout = out[k];
+      for (j = -hh ; j <= hh ; j++)
+        for (i = -hw ; i <= hw ; i++)
+          *ptrout++ = _interpolate(x+i, y+j, imgs[k]);
+    }
+    return;
+  }
+
+  assert(ws->xt[0] >= 0 && ws->yt[0] >= 0);
+  assert(ws->xt[width-1] <= ncols - 2 && ws->yt[height-1] <= imgs[0]->nrows - 2);
+
+  for (j = 0 ; j < height ; j++)  {
+    float by = ws->by[j], ay = ws->ay[j];
+    int offset = ws->yt[j] * ncols + ws->xt[0];
+
+    i = 0;
+#if VIDTK_SSE2
+    {
+      __m128 vby = _mm_set1_ps(by), vay = _mm_set1_ps(ay);
+      for ( ; i + 4 <= width ; i += 4)  {
+        __m128 vax = _mm_loadu_ps(ws->ax + i);
+        __m128 vbx = _mm_loadu_ps(ws->bx + i);
+        __m128 w00 = _mm_mul_ps(vbx, vby);
+        __m128 w01 = _mm_mul_ps(vax, vby);
+        __m128 w10 = _mm_mul_ps(vbx, vay);
+        __m128 w11 = _mm_mul_ps(vax, vay);
+        for (k = 0 ; k < nimgs ; k++)  {
+          const float *ptr = imgs[k]->data + offset + i;
+          __m128 sum = _mm_mul_ps(w00, _mm_loadu_ps(ptr));
+          sum = _mm_add_ps(sum, _mm_mul_ps(w01, _mm_loadu_ps(ptr+1)));
+          sum = _mm_add_ps(sum, _mm_mul_ps(w10, _mm_loadu_ps(ptr+ncols)));
+          sum = _mm_add_ps(sum, _mm_mul_ps(w11, _mm_loadu_ps(ptr+ncols+1)));
+          _mm_storeu_ps(out[k] + j*width + i, sum);
+        }
+      }
+    }
+#endif
+    for ( ; i < width ; i++)  {
+      float w00 = ws->bx[i] * by, w01 = ws->ax[i] * by;
+      float w10 = ws->bx[i] * ay, w11 = ws->ax[i] * ay;
+      for (k = 0 ; k < nimgs ; k++)  {
+        const float *ptr = imgs[k]->data + offset + i;
+        out[k][j*width + i] = w00 * *ptr + w01 * *(ptr+1) +
+                              w10 * *(ptr+ncols) + w11 * *(ptr+ncols+1);
+      }
+    }
+  }
+}
+
+
+/*********************************************************************
+ * _sampleFirstWindows
+ *
+ * Samples the image and gradient windows of the first image.  These
+ * do not change while the feature is tracked at one pyramid level.
+ */
+
+static void _sampleFirstWindows(
+  _KLT_FloatImage img1,
+  _KLT_FloatImage gradx1,
+  _KLT_FloatImage grady1,
+  float x1, float y1,     /* center of window in 1st img */
+  _TrackWorkspace ws)
+{
+  _KLT_FloatImage imgs[3];
+  _FloatWindow out[3];
+
+  imgs[0] = img1;  imgs[1] = gradx1;  imgs[2] = grady1;
+  out[0] = ws->img1;  out[1] = ws->gradx1;  out[2] = ws->grady1;
+  _sampleWindows(imgs, out, 3, x1, y1, ws);
+}
+
+
+/*********************************************************************
+ * _computeWindowDifferenceAndSum
+ *
+ * Same as _computeIntensityDifference() and _computeGradientSum(),
+ * using the windows of the first image already in the workspace.
+ * Pass NULL gradients to only compute the intensity difference.
+ */
+
+static void _computeWindowDifferenceAndSum(
+  _KLT_FloatImage img2,
+  _KLT_FloatImage gradx2,
+  _KLT_FloatImage grady2,
+  float x2, float y2,     /* center of window in 2nd img */
+  _TrackWorkspace ws)
+{
+  _KLT_FloatImage imgs[3];
+  _FloatWindow out[3];
+  int n = ws->width * ws->height;
+  register int i;
+
+  imgs[0] = img2;  imgs[1] = gradx2;  imgs[2] = grady2;
+  out[0] = ws->img2;  out[1] = ws->gradx2;  out[2] = ws->grady2;
+  _sampleWindows(imgs, out, (gradx2 != NULL) ? 3 : 1, x2, y2, ws);
+
+  for (i = 0 ; i < n ; i++)
+    ws->imgdiff[i] = ws->img1[i] - ws->img2[i];
+
+  if (gradx2 == NULL)  return;
+
+  for (i = 0 ; i < n ; i++)  {
+    ws->gradx[i] = ws->gradx1[i] + ws->gradx2[i];
+    ws->grady[i] = ws->grady1[i] + ws->grady2[i];
+  }
+}
+
+
 /*********************************************************************
  * _computeIntensityDifference
  *
@@ -65,6 +237,7 @@ static float _interpolate(
  * between the two overlaid images.
  */
 
+#ifdef BUILD_KLT_AFFINE
 static void _computeIntensityDifference(
   _KLT_FloatImage img1,   /* images */
   _KLT_FloatImage img2,
@@ -85,6 +258,7 @@ static void _computeIntensityDifference(
       *imgdiff++ = g1 - g2;
     }
 }
+#endif
 
 
 /*********************************************************************
@@ -95,6 +269,7 @@ static void _computeIntensityDifference(
  * overlaid gradients.
  */
 
+#ifdef BUILD_KLT_AFFINE
 static void _computeGradientSum(
   _KLT_FloatImage gradx1,  /* gradient images */
   _KLT_FloatImage grady1,
@@ -121,6 +296,7 @@ static void _computeGradientSum(
       *grady++ = g1 + g2;
     }
 }
+#endif
 
 /*********************************************************************
  * _computeIntensityDifferenceLightingInsensitive
@@ -327,6 +503,60 @@ static _FloatWindow _allocateFloatWindow(
 }
 
 
+/*********************************************************************
+ * _createTrackWorkspace
+ */
+
+static _TrackWorkspace _createTrackWorkspace(
+  int width,
+  int height)
+{
+  _TrackWorkspace ws;
+
+  ws = (_TrackWorkspace) malloc(sizeof(_TrackWorkspaceRec));
+  if (ws == NULL)  KLTError("(_createTrackWorkspace) Out of memory.");
+
+  ws->width = width;
+  ws->height = height;
+  ws->img1    = _allocateFloatWindow(width, height);
+  ws->gradx1  = _allocateFloatWindow(width, height);
+  ws->grady1  = _allocateFloatWindow(width, height);
+  ws->img2    = _allocateFloatWindow(width, height);
+  ws->gradx2  = _allocateFloatWindow(width, height);
+  ws->grady2  = _allocateFloatWindow(width, height);
+  ws->imgdiff = _allocateFloatWindow(width, height);
+  ws->gradx   = _allocateFloatWindow(width, height);
+  ws->grady   = _allocateFloatWindow(width, height);
+  ws->xt = (int *) malloc(width*sizeof(int));
+  ws->yt = (int *) malloc(height*sizeof(int));
+  ws->ax = _allocateFloatWindow(width, 1);
+  ws->ay = _allocateFloatWindow(height, 1);
+  ws->bx = _allocateFloatWindow(width, 1);
+  ws->by = _allocateFloatWindow(height, 1);
+  if (ws->xt == NULL || ws->yt == NULL)
+    KLTError("(_createTrackWorkspace) Out of memory.");
+
+  return ws;
+}
+
+
+/*********************************************************************
+ * _freeTrackWorkspace
+ */
+
+static void _freeTrackWorkspace(
+  _TrackWorkspace ws)
+{
+  free(ws->img1);  free(ws->gradx1);  free(ws->grady1);
+  free(ws->img2);  free(ws->gradx2);  free(ws->grady2);
+  free(ws->imgdiff);  free(ws->gradx);  free(ws->grady);
+  free(ws->xt);  free(ws->yt);
+  free(ws->ax);  free(ws->ay);
+  free(ws->bx);  free(ws->by);
+  free(ws);
+}
+
+
 /*********************************************************************
  * _printFloatWindow
  * (for debugging purposes)
@@ -393,8 +623,7 @@ static int _trackFeature(
   _KLT_FloatImage img2,
   _KLT_FloatImage gradx2,
   _KLT_FloatImage grady2,
-  int width,           /* size of window */
-  int height,
+  _TrackWorkspace ws,  /* windows, and size of window */
   float step_factor, /* 2.0 comes from equations, 1.0 seems to avoid overshooting */
   int max_iterations,
   float small,         /* determinant threshold for declaring KLT_SMALL_DET */
@@ -406,10 +635,12 @@ static int _trackFeature(
   int Unused )
 #endif
 {
-  _FloatWindow imgdiff, gradx, grady;
+  _FloatWindow imgdiff = ws->imgdiff, gradx = ws->gradx, grady = ws->grady;
   float gxx, gxy, gyy, ex, ey, dx, dy;
   int iteration = 0;
   int status;
+  int width = ws->width;
+  int height = ws->height;
   int hw = width/2;
   int hh = height/2;
   int nc1= img1->ncols;
@@ -417,12 +648,7 @@ static int _trackFeature(
   int nc2 = img2->ncols;
   int nr2 = img2->nrows;
   float one_plus_eps = 1.001f;   /* To prevent rounding errors */
-
-
-  /* Allocate memory for windows */
-  imgdiff = _allocateFloatWindow(width, height);
-  gradx   = _allocateFloatWindow(width, height);
-  grady   = _allocateFloatWindow(width, height);
+  KLT_BOOL first_sampled = FALSE;
 
   /* Iteratively update the window position */
   do  {
@@ -445,10 +671,12 @@ static int _trackFeature(
                                              img1, img2, x1, y1, *x2, *y2, width, height, gradx, grady);
     } else {
 #endif
-      _computeIntensityDifference(img1, img2, x1, y1, *x2, *y2,
-                                  width, height, imgdiff);
-      _computeGradientSum(gradx1, grady1, gradx2, grady2,
-                          x1, y1, *x2, *y2, width, height, gradx, grady);
+      /* The first window does not move, so is only sampled once */
+      if (!first_sampled)  {
+        _sampleFirstWindows(img1, gradx1, grady1, x1, y1, ws);
+        first_sampled = TRUE;
+      }
+      _computeWindowDifferenceAndSum(img2, gradx2, grady2, *x2, *y2, ws);
 #ifdef KLT_BUILD_LIGHT_INSENS
     }
 #endif
@@ -483,15 +711,11 @@ static int _trackFeature(
                                                      width, height, imgdiff);
     else
 #endif
-      _computeIntensityDifference(img1, img2, x1, y1, *x2, *y2,
-                                  width, height, imgdiff);
+      _computeWindowDifferenceAndSum(img2, NULL, NULL, *x2, *y2, ws);
     if (_sumAbsFloatWindow(imgdiff, width, height)/(width*height) > max_residue)
       status = KLT_LARGE_RESIDUE;
   }
 
-  /* Free memory */
-  free(imgdiff);  free(gradx);  free(grady);
-
   /* Return appropriate value */
   if (status == KLT_SMALL_DET)  return KLT_SMALL_DET;
   else if (status == KLT_OOB)  return KLT_OOB;
@@ -1262,6 +1486,235 @@ static int _am_trackFeatureAffine(
 
 
 
+/*********************************************************************
+ * _trackFeatureRange
+ *
+ * Tracks the features [begin,end) of the list in a _TrackRangeArgs.
+ * Each call uses a workspace of its own, so disjoint ranges can be
+ * tracked concurrently.
+ */
+
+typedef struct  {
+  KLT_TrackingContext tc;
+  KLT_TrackingPyramid pyramid1;
+  KLT_TrackingPyramid pyramid2;
+  int ncols;
+  int nrows;
+  int coarsestLevel;
+  int finestLevel;
+  float subsampling;
+  const float *homog_initial;
+  KLT_FeatureList featurelist;
+}  _TrackRangeArgs;
+
+static void _trackFeatureRange(
+  void *data,
+  int begin,
+  int end)
+{
+  _TrackRangeArgs *args = (_TrackRangeArgs *) data;
+  KLT_TrackingContext tc = args->tc;
+  KLT_TrackingPyramid pyramid1 = args->pyramid1;
+  KLT_TrackingPyramid pyramid2 = args->pyramid2;
+  int const ncols = args->ncols;
+  int const nrows = args->nrows;
+  int const coarsestLevel = args->coarsestLevel;
+  int const finestLevel = args->finestLevel;
+  float const subsampling = args->subsampling;
+  const float *homog_initial = args->homog_initial;
+  KLT_FeatureList featurelist = args->featurelist;
+  _TrackWorkspace ws;
+
+  int val;
+  int indx, r;
+
+  float xloc, yloc, xlocout, ylocout;
+
+  ws = _createTrackWorkspace(tc->window_width, tc->window_height);
+
+  /* avoid "may be used uninitialized" warning with gcc -O3 */
+  val = 0;
+
+  /* For each feature, do ... */
+  for (indx = begin ; indx < end ; indx++)  {
+
+    /* Only track features that are not lost */
+    if (featurelist->feature[indx]->val >= 0)  {
+
+      xloc = featurelist->feature[indx]->x;
+      yloc = featurelist->feature[indx]->y;
+      xlocout = xloc;
+      ylocout = yloc;
+      _KLTApply3x3HomogToXY(xloc, yloc, homog_initial, &xlocout, &ylocout);
+
+      /* Transform location to coarsest resolution */
+      for (r = coarsestLevel ; r >= 0 ; r--)  {
+        xloc /= subsampling;
+        yloc /= subsampling;
+        xlocout /= subsampling;
+        ylocout /= subsampling;
+      }
+
+      /* Beginning with coarsest resolution, do ... */
+      for (r = coarsestLevel ; r >= finestLevel ; r--)  {
+
+        /* Track feature at current resolution */
+        xloc *= subsampling;  yloc *= subsampling;
+        xlocout *= subsampling;  ylocout *= subsampling;
+
+        val = _trackFeature(xloc, yloc,
+        &xlocout, &ylocout,
+        pyramid1->pyramid->img[r],
+        pyramid1->pyramid_gradx->img[r], pyramid1->pyramid_grady->img[r],
+        pyramid2->pyramid->img[r],
+        pyramid2->pyramid_gradx->img[r], pyramid2->pyramid_grady->img[r],
+        ws,
+        tc->step_factor,
+        tc->max_iterations,
+        tc->min_determinant,
+        tc->min_displacement,
+        tc->max_residue,
+        tc->lighting_insensitive);
+
+        if (val==KLT_SMALL_DET || val==KLT_OOB)
+        break;
+      }
+
+      /* Transform location back to full resolution if tracking stopped */
+      /* at a coarser level */
+      for (r = finestLevel ; r > 0 ; r--)  {
+        xloc *= subsampling;  yloc *= subsampling;
+        xlocout *= subsampling;  ylocout *= subsampling;
+      }
+
+      /* Record feature */
+      if (val == KLT_OOB) {
+        featurelist->feature[indx]->x   = -1.0;
+        featurelist->feature[indx]->y   = -1.0;
+        featurelist->feature[indx]->val = KLT_OOB;
+        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+        featurelist->feature[indx]->aff_img = NULL;
+        featurelist->feature[indx]->aff_img_gradx = NULL;
+        featurelist->feature[indx]->aff_img_grady = NULL;
+
+      } else if (_outOfBounds(xlocout, ylocout, ncols, nrows, tc->borderx, tc->bordery))  {
+        featurelist->feature[indx]->x   = -1.0;
+        featurelist->feature[indx]->y   = -1.0;
+        featurelist->feature[indx]->val = KLT_OOB;
+        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+        featurelist->feature[indx]->aff_img = NULL;
+        featurelist->feature[indx]->aff_img_gradx = NULL;
+        featurelist->feature[indx]->aff_img_grady = NULL;
+      } else if (val == KLT_SMALL_DET)  {
+        featurelist->feature[indx]->x   = -1.0;
+        featurelist->feature[indx]->y   = -1.0;
+        featurelist->feature[indx]->val = KLT_SMALL_DET;
+        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+        featurelist->feature[indx]->aff_img = NULL;
+        featurelist->feature[indx]->aff_img_gradx = NULL;
+        featurelist->feature[indx]->aff_img_grady = NULL;
+      } else if (val == KLT_LARGE_RESIDUE)  {
+        featurelist->feature[indx]->x   = -1.0;
+        featurelist->feature[indx]->y   = -1.0;
+        featurelist->feature[indx]->val = KLT_LARGE_RESIDUE;
+        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+        featurelist->feature[indx]->aff_img = NULL;
+        featurelist->feature[indx]->aff_img_gradx = NULL;
+        featurelist->feature[indx]->aff_img_grady = NULL;
+      } else if (val == KLT_MAX_ITERATIONS)  {
+        featurelist->feature[indx]->x   = -1.0;
+        featurelist->feature[indx]->y   = -1.0;
+        featurelist->feature[indx]->val = KLT_MAX_ITERATIONS;
+        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+        featurelist->feature[indx]->aff_img = NULL;
+        featurelist->feature[indx]->aff_img_gradx = NULL;
+        featurelist->feature[indx]->aff_img_grady = NULL;
+      }
+      else
+      {
+        featurelist->feature[indx]->x = xlocout;
+        featurelist->feature[indx]->y = ylocout;
+        featurelist->feature[indx]->val = KLT_TRACKED;
+#ifdef BUILD_KLT_AFFINE
+        if (tc->affineConsistencyCheck >= 0 && val == KLT_TRACKED && finestLevel == 0)  { /*for affine mapping*/
+          int border = 2; /* add border for interpolation */
+
+      #ifdef DEBUG_AFFINE_MAPPING
+          glob_index = indx;
+      #endif
+
+          if(!featurelist->feature[indx]->aff_img){
+            /* save image and gradient for each feature at finest resolution after first successful track */
+            featurelist->feature[indx]->aff_img = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
+            featurelist->feature[indx]->aff_img_gradx = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
+            featurelist->feature[indx]->aff_img_grady = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
+            _am_getSubFloatImage(pyramid1->pyramid->img[0],xloc,yloc,featurelist->feature[indx]->aff_img);
+            _am_getSubFloatImage(pyramid1->pyramid_gradx->img[0],xloc,yloc,featurelist->feature[indx]->aff_img_gradx);
+            _am_getSubFloatImage(pyramid1->pyramid_grady->img[0],xloc,yloc,featurelist->feature[indx]->aff_img_grady);
+            featurelist->feature[indx]->aff_x = xloc - (int) xloc + (tc->affine_window_width+border)/2;
+            featurelist->feature[indx]->aff_y = yloc - (int) yloc + (tc->affine_window_height+border)/2;;
+          }else{
+            /* affine tracking */
+            val = _am_trackFeatureAffine(featurelist->feature[indx]->aff_x, featurelist->feature[indx]->aff_y,
+            &xlocout, &ylocout,
+            featurelist->feature[indx]->aff_img,
+            featurelist->feature[indx]->aff_img_gradx,
+            featurelist->feature[indx]->aff_img_grady,
+            pyramid2->pyramid->img[0],
+            pyramid2->pyramid_gradx->img[0], pyramid2->pyramid_grady->img[0],
+            tc->affine_window_width, tc->affine_window_height,
+            tc->step_factor,
+            tc->affine_max_iterations,
+            tc->min_determinant,
+            tc->min_displacement,
+            tc->affine_min_displacement,
+            tc->affine_max_residue,
+            tc->lighting_insensitive,
+            tc->affineConsistencyCheck,
+            tc->affine_max_displacement_differ,
+            &featurelist->feature[indx]->aff_Axx,
+            &featurelist->feature[indx]->aff_Ayx,
+            &featurelist->feature[indx]->aff_Axy,
+            &featurelist->feature[indx]->aff_Ayy
+            );
+            featurelist->feature[indx]->val = val;
+            if(val != KLT_TRACKED){
+            featurelist->feature[indx]->x   = -1.0;
+            featurelist->feature[indx]->y   = -1.0;
+            featurelist->feature[indx]->aff_x = -1.0;
+            featurelist->feature[indx]->aff_y = -1.0;
+            /* free image and gradient for lost feature */
+            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
+            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
+            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
+            featurelist->feature[indx]->aff_img = NULL;
+            featurelist->feature[indx]->aff_img_gradx = NULL;
+            featurelist->feature[indx]->aff_img_grady = NULL;
+            }else{
+            /*featurelist->feature[indx]->x = xlocout;*/
+            /*featurelist->feature[indx]->y = ylocout;*/
+            }
+          }
+        }
+#endif
+      }
+    }
+  }
+  _freeTrackWorkspace(ws);
+}
+
+
+
 /*********************************************************************
  * KLTTrackFeatures
  *
@@ -1384,21 +1837,53 @@ void KLTTrackFeaturesPyramid(
        int nrows,
        const float *homog_initial,
        KLT_FeatureList featurelist)
+{
+  KLTTrackFeaturesPyramidLevels(tc, pyramid1, pyramid2, ncols, nrows,
+                                homog_initial, -1, 0, featurelist);
+}
+
+
+/*********************************************************************
+ * KLTTrackFeaturesPyramidLevels
+ *
+ * Tracks feature points from one image pyramid to the next, using only
+ * the levels from coarsest_level down to finest_level.  A negative
+ * coarsest_level starts at the top of the pyramids.  Feature locations
+ * are always in full resolution coordinates, so stopping at a coarser
+ * level trades accuracy for time.  Starting at a finer level is only
+ * safe when homog_initial predicts the motion to within the search
+ * range of that level.
+ */
+
+void KLTTrackFeaturesPyramidLevels(
+       KLT_TrackingContext tc,
+       KLT_TrackingPyramid pyramid1,
+       KLT_TrackingPyramid pyramid2,
+       int ncols,
+       int nrows,
+       const float *homog_initial,
+       int coarsest_level,
+       int finest_level,
+       KLT_FeatureList featurelist)
 {
   int const p1Subsampling = pyramid1->pyramid->subsampling;
   int const p2Subsampling = pyramid2->pyramid->subsampling;
 
   float const subsampling = (float) p1Subsampling;
 
-  int val;
-  int indx, r;
-
   const int p1nLevels = pyramid1->pyramid->nLevels;
   const int p2nLevels = pyramid1->pyramid->nLevels;
 
   const int nLevels = (p1nLevels < p2nLevels) ? p1nLevels : p2nLevels;
 
-  float xloc, yloc, xlocout, ylocout;
+  _TrackRangeArgs args;
+
+  if (coarsest_level < 0 || coarsest_level > nLevels - 1)
+    coarsest_level = nLevels - 1;
+  if (finest_level < 0)
+    finest_level = 0;
+  if (finest_level > coarsest_level)
+    finest_level = coarsest_level;
 
   if (p1Subsampling != p2Subsampling) {
     printf("Error: The first pyramid (%d) and second pyramid (%d) subsamplings are not the same.", p1Subsampling, p2Subsampling);
@@ -1411,9 +1896,6 @@ void KLTTrackFeaturesPyramid(
   }
   #endif
 
-  /* avoid "may be used uninitialized" warning with gcc -O3 */
-  val = 0;
-
   if (KLT_verbose >= 1)  {
     fprintf(stderr,  "(KLT) Tracking %d features in a %d by %d image...  \n",
     KLTCountRemainingFeatures(featurelist), ncols, nrows);
@@ -1454,174 +1936,29 @@ void KLTTrackFeaturesPyramid(
   }
   #endif
 
-  /* For each feature, do ... */
-  for (indx = 0 ; indx < featurelist->nFeatures ; indx++)  {
-
-    /* Only track features that are not lost */
-    if (featurelist->feature[indx]->val >= 0)  {
-
-      xloc = featurelist->feature[indx]->x;
-      yloc = featurelist->feature[indx]->y;
-      xlocout = xloc;
-      ylocout = yloc;
-      _KLTApply3x3HomogToXY(xloc, yloc, homog_initial, &xlocout, &ylocout);
-
-      /* Transform location to coarsest resolution */
-      for (r = nLevels - 1 ; r >= 0 ; r--)  {
-        xloc /= subsampling;
-        yloc /= subsampling;
-        xlocout /= subsampling;
-        ylocout /= subsampling;
-      }
-
-      /* Beginning with coarsest resolution, do ... */
-      for (r = nLevels - 1 ; r >= 0 ; r--)  {
-
-        /* Track feature at current resolution */
-        xloc *= subsampling;  yloc *= subsampling;
-        xlocout *= subsampling;  ylocout *= subsampling;
-
-        val = _trackFeature(xloc, yloc,
-        &xlocout, &ylocout,
-        pyramid1->pyramid->img[r],
-        pyramid1->pyramid_gradx->img[r], pyramid1->pyramid_grady->img[r],
-        pyramid2->pyramid->img[r],
-        pyramid2->pyramid_gradx->img[r], pyramid2->pyramid_grady->img[r],
-        tc->window_width, tc->window_height,
-        tc->step_factor,
-        tc->max_iterations,
-        tc->min_determinant,
-        tc->min_displacement,
-        tc->max_residue,
-        tc->lighting_insensitive);
-
-        if (val==KLT_SMALL_DET || val==KLT_OOB)
-        break;
-      }
-
-      /* Record feature */
-      if (val == KLT_OOB) {
-        featurelist->feature[indx]->x   = -1.0;
-        featurelist->feature[indx]->y   = -1.0;
-        featurelist->feature[indx]->val = KLT_OOB;
-        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-        featurelist->feature[indx]->aff_img = NULL;
-        featurelist->feature[indx]->aff_img_gradx = NULL;
-        featurelist->feature[indx]->aff_img_grady = NULL;
-
-      } else if (_outOfBounds(xlocout, ylocout, ncols, nrows, tc->borderx, tc->bordery))  {
-        featurelist->feature[indx]->x   = -1.0;
-        featurelist->feature[indx]->y   = -1.0;
-        featurelist->feature[indx]->val = KLT_OOB;
-        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-        featurelist->feature[indx]->aff_img = NULL;
-        featurelist->feature[indx]->aff_img_gradx = NULL;
-        featurelist->feature[indx]->aff_img_grady = NULL;
-      } else if (val == KLT_SMALL_DET)  {
-        featurelist->feature[indx]->x   = -1.0;
-        featurelist->feature[indx]->y   = -1.0;
-        featurelist->feature[indx]->val = KLT_SMALL_DET;
-        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-        featurelist->feature[indx]->aff_img = NULL;
-        featurelist->feature[indx]->aff_img_gradx = NULL;
-        featurelist->feature[indx]->aff_img_grady = NULL;
-      } else if (val == KLT_LARGE_RESIDUE)  {
-        featurelist->feature[indx]->x   = -1.0;
-        featurelist->feature[indx]->y   = -1.0;
-        featurelist->feature[indx]->val = KLT_LARGE_RESIDUE;
-        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-        featurelist->feature[indx]->aff_img = NULL;
-        featurelist->feature[indx]->aff_img_gradx = NULL;
-        featurelist->feature[indx]->aff_img_grady = NULL;
-      } else if (val == KLT_MAX_ITERATIONS)  {
-        featurelist->feature[indx]->x   = -1.0;
-        featurelist->feature[indx]->y   = -1.0;
-        featurelist->feature[indx]->val = KLT_MAX_ITERATIONS;
-        if( featurelist->feature[indx]->aff_img ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-        if( featurelist->feature[indx]->aff_img_gradx ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-        if( featurelist->feature[indx]->aff_img_grady ) _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-        featurelist->feature[indx]->aff_img = NULL;
-        featurelist->feature[indx]->aff_img_gradx = NULL;
-        featurelist->feature[indx]->aff_img_grady = NULL;
-      }
-      else
-      {
-        featurelist->feature[indx]->x = xlocout;
-        featurelist->feature[indx]->y = ylocout;
-        featurelist->feature[indx]->val = KLT_TRACKED;
-#ifdef BUILD_KLT_AFFINE
-        if (tc->affineConsistencyCheck >= 0 && val == KLT_TRACKED)  { /*for affine mapping*/
-          int border = 2; /* add border for interpolation */
-
-      #ifdef DEBUG_AFFINE_MAPPING
-          glob_index = indx;
-      #endif
-
-          if(!featurelist->feature[indx]->aff_img){
-            /* save image and gradient for each feature at finest resolution after first successful track */
-            featurelist->feature[indx]->aff_img = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
-            featurelist->feature[indx]->aff_img_gradx = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
-            featurelist->feature[indx]->aff_img_grady = _KLTCreateFloatImage((tc->affine_window_width+border), (tc->affine_window_height+border));
-            _am_getSubFloatImage(pyramid1->pyramid->img[0],xloc,yloc,featurelist->feature[indx]->aff_img);
-            _am_getSubFloatImage(pyramid1->pyramid_gradx->img[0],xloc,yloc,featurelist->feature[indx]->aff_img_gradx);
-            _am_getSubFloatImage(pyramid1->pyramid_grady->img[0],xloc,yloc,featurelist->feature[indx]->aff_img_grady);
-            featurelist->feature[indx]->aff_x = xloc - (int) xloc + (tc->affine_window_width+border)/2;
-            featurelist->feature[indx]->aff_y = yloc - (int) yloc + (tc->affine_window_height+border)/2;;
-          }else{
-            /* affine tracking */
-            val = _am_trackFeatureAffine(featurelist->feature[indx]->aff_x, featurelist->feature[indx]->aff_y,
-            &xlocout, &ylocout,
-            featurelist->feature[indx]->aff_img,
-            featurelist->feature[indx]->aff_img_gradx,
-            featurelist->feature[indx]->aff_img_grady,
-            pyramid2->pyramid->img[0],
-            pyramid2->pyramid_gradx->img[0], pyramid2->pyramid_grady->img[0],
-            tc->affine_window_width, tc->affine_window_height,
-            tc->step_factor,
-            tc->affine_max_iterations,
-            tc->min_determinant,
-            tc->min_displacement,
-            tc->affine_min_displacement,
-            tc->affine_max_residue,
-            tc->lighting_insensitive,
-            tc->affineConsistencyCheck,
-            tc->affine_max_displacement_differ,
-            &featurelist->feature[indx]->aff_Axx,
-            &featurelist->feature[indx]->aff_Ayx,
-            &featurelist->feature[indx]->aff_Axy,
-            &featurelist->feature[indx]->aff_Ayy
-            );
-            featurelist->feature[indx]->val = val;
-            if(val != KLT_TRACKED){
-            featurelist->feature[indx]->x   = -1.0;
-            featurelist->feature[indx]->y   = -1.0;
-            featurelist->feature[indx]->aff_x = -1.0;
-            featurelist->feature[indx]->aff_y = -1.0;
-            /* free image and gradient for lost feature */
-            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img);
-            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_gradx);
-            _KLTFreeFloatImage(featurelist->feature[indx]->aff_img_grady);
-            featurelist->feature[indx]->aff_img = NULL;
-            featurelist->feature[indx]->aff_img_gradx = NULL;
-            featurelist->feature[indx]->aff_img_grady = NULL;
-            }else{
-            /*featurelist->feature[indx]->x = xlocout;*/
-            /*featurelist->feature[indx]->y = ylocout;*/
-            }
-          }
-        }
+  /* Track the features, on several threads if the caller provided */
+  /* a way to run them and there are enough features to be worth it. */
+  /* The affine debug output numbers features globally, so is only */
+  /* written when tracking on one thread. */
+  args.tc = tc;
+  args.pyramid1 = pyramid1;
+  args.pyramid2 = pyramid2;
+  args.ncols = ncols;
+  args.nrows = nrows;
+  args.coarsestLevel = coarsest_level;
+  args.finestLevel = finest_level;
+  args.subsampling = subsampling;
+  args.homog_initial = homog_initial;
+  args.featurelist = featurelist;
+
+#ifndef DEBUG_AFFINE_MAPPING
+  if (tc->parallel_for != NULL && featurelist->nFeatures >= KLT_MIN_PARALLEL_FEATURES)
+    tc->parallel_for(tc->parallel_for_data, 0, featurelist->nFeatures,
+                     _trackFeatureRange, &args);
+  else
 #endif
-      }
-    }
-  }
+    _trackFeatureRange(&args, 0, featurelist->nFeatures);
+
 
   if (tc->sequentialMode)  {
     tc->pyramid_last = pyramid2->pyramid;
@@ -0,0 +1,243 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+
+#include "klt_pyramid_cache.h"
+
+#include <kwklt/klt_util.h>
+#include <kwklt/klt_mutex.h>
+
+#include <boost/thread/locks.hpp>
+
+namespace vidtk
+{
+
+//
+// pointer to our instance
+//
+klt_pyramid_cache_t klt_pyramid_cache::s_instance = klt_pyramid_cache_t();
+
+
+klt_pyramid_set_sptr
+build_klt_pyramid_set( const vil_image_view<vxl_byte>& img,
+                       const klt_pyramid_params& params )
+{
+  boost::shared_ptr<klt_pyramid_set> output( new klt_pyramid_set );
+
+  // create_klt_pyramid does not modify its input, it is just not const-correct
+  vil_image_view<vxl_byte> input = img;
+
+  output->image = create_klt_pyramid( input, params.levels, params.subsampling,
+                                      params.sigma_factor, params.init_sigma );
+
+  double scale = 1;
+
+  for( int i = 0; i < params.levels; ++i )
+  {
+    vil_image_view<float> level = output->image( i );
+
+    std::pair<vil_image_view<float>, vil_image_view<float> > const grads =
+      compute_gradients( level, params.grad_sigma );
+
+    vil_image_view_base_sptr gradx( new vil_image_view<float>( grads.first ) );
+    output->gradx.add_view( gradx, scale );
+
+    vil_image_view_base_sptr grady( new vil_image_view<float>( grads.second ) );
+    output->grady.add_view( grady, scale );
+
+    scale /= params.subsampling;
+  }
+
+  return output;
+}
+
+
+namespace
+{
+
+// FNV-1a hash of the pixels of an image, independent of its memory layout.
+vxl_uint_64
+image_content_hash( const vil_image_view<vxl_byte>& img )
+{
+  vxl_uint_64 hash = 14695981039346656037ULL;
+
+  for( unsigned p = 0; p < img.nplanes(); ++p )
+  {
+    for( unsigned j = 0; j < img.nj(); ++j )
+    {
+      const vxl_byte* pixel = &img( 0, j, p );
+
+      for( unsigned i = 0; i < img.ni(); ++i, pixel += img.istep() )
+      {
+        hash = ( hash ^ *pixel ) * 1099511628211ULL;
+      }
+    }
+  }
+
+  return hash;
+}
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------
+/** Constructor
+ *
+ *
+ */
+klt_pyramid_cache::klt_pyramid_cache()
+  : capacity_( 4 ),
+    hit_count_( 0 ),
+    build_count_( 0 )
+{
+}
+
+
+klt_pyramid_cache::~klt_pyramid_cache()
+{
+}
+
+
+// ----------------------------------------------------------------
+/** Get the instance
+ *
+ *
+ */
+klt_pyramid_cache_t klt_pyramid_cache
+::instance()
+{
+  static boost::mutex local_lock;          // synchronization lock
+
+  if (s_instance)
+  {
+    return s_instance;
+  }
+
+  boost::lock_guard<boost::mutex> lock(local_lock);
+  if (!s_instance)
+  {
+    // create new object
+    s_instance = klt_pyramid_cache_t(new klt_pyramid_cache);
+  }
+
+  return s_instance;
+}
+
+
+// ----------------------------------------------------------------
+/** Get the pyramids of a frame
+ *
+ * The content hash is computed before taking the cache lock, which is
+ * then only held while searching the entry list, so pyramids of
+ * different frames or parameters can be built concurrently. The actual build is still serialized by the
+ * klt_mutex, since the underlying KLT code uses global state.
+ */
+klt_pyramid_set_sptr klt_pyramid_cache
+::get( const timestamp& ts,
+       const vil_image_view<vxl_byte>& img,
+       const klt_pyramid_params& params )
+{
+  boost::shared_ptr<entry> found;
+  const vxl_uint_64 content_hash = image_content_hash( img );
+
+  {
+    boost::lock_guard<boost::mutex> lock( lock_ );
+
+    for( entry_list_t::iterator it = entries_.begin(); it != entries_.end(); ++it )
+    {
+      if( (*it)->ts == ts && (*it)->params == params &&
+          (*it)->ni == img.ni() && (*it)->nj == img.nj() &&
+          (*it)->nplanes == img.nplanes() &&
+          (*it)->content_hash == content_hash )
+      {
+        found = *it;
+        entries_.erase( it );
+        break;
+      }
+    }
+
+    if( !found )
+    {
+      found.reset( new entry );
+      found->ts = ts;
+      found->params = params;
+      found->ni = img.ni();
+      found->nj = img.nj();
+      found->nplanes = img.nplanes();
+      found->content_hash = content_hash;
+      found->build_lock.reset( new boost::mutex );
+    }
+
+    entries_.push_front( found );
+
+    while( entries_.size() > capacity_ )
+    {
+      entries_.pop_back();
+    }
+  }
+
+  boost::lock_guard<boost::mutex> build_lock( *found->build_lock );
+
+  if( found->pyramids )
+  {
+    boost::lock_guard<boost::mutex> lock( lock_ );
+    ++hit_count_;
+    return found->pyramids;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> klt_lock( klt_mutex::instance()->get_lock() );
+    found->pyramids = build_klt_pyramid_set( img, params );
+  }
+
+  boost::lock_guard<boost::mutex> lock( lock_ );
+  ++build_count_;
+  return found->pyramids;
+}
+
+
+void klt_pyramid_cache
+::set_capacity( unsigned capacity )
+{
+  boost::lock_guard<boost::mutex> lock( lock_ );
+
+  capacity_ = capacity;
+
+  while( entries_.size() > capacity_ )
+  {
+    entries_.pop_back();
+  }
+}
+
+
+void klt_pyramid_cache
+::clear()
+{
+  boost::lock_guard<boost::mutex> lock( lock_ );
+
+  entries_.clear();
+  hit_count_ = 0;
+  build_count_ = 0;
+}
+
+
+unsigned klt_pyramid_cache
+::hit_count() const
+{
+  boost::lock_guard<boost::mutex> lock( lock_ );
+  return hit_count_;
+}
+
+
+unsigned klt_pyramid_cache
+::build_count() const
+{
+  boost::lock_guard<boost::mutex> lock( lock_ );
+  return build_count_;
+}
+
+
+} // end namespace vidtk
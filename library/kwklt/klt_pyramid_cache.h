@@ -0,0 +1,144 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_kwklt_pyramid_cache_h_
+#define vidtk_kwklt_pyramid_cache_h_
+
+#include <vil/vil_image_view.h>
+#include <vil/vil_pyramid_image_view.h>
+#include <vxl_config.h>
+
+#include <utilities/timestamp.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+
+namespace vidtk
+{
+
+/// Parameters which fully describe the contents of a KLT pyramid.
+struct klt_pyramid_params
+{
+  klt_pyramid_params()
+    : levels( 2 ),
+      subsampling( 4 ),
+      init_sigma( 0.7f ),
+      sigma_factor( 0.9f ),
+      grad_sigma( 1.0f )
+  {}
+
+  bool operator==( const klt_pyramid_params& other ) const
+  {
+    return levels == other.levels &&
+           subsampling == other.subsampling &&
+           init_sigma == other.init_sigma &&
+           sigma_factor == other.sigma_factor &&
+           grad_sigma == other.grad_sigma;
+  }
+
+  int levels;
+  int subsampling;
+  float init_sigma;
+  float sigma_factor;
+  float grad_sigma;
+};
+
+
+/// Image and gradient pyramids of a single frame.
+struct klt_pyramid_set
+{
+  vil_pyramid_image_view<float> image;
+  vil_pyramid_image_view<float> gradx;
+  vil_pyramid_image_view<float> grady;
+};
+
+typedef boost::shared_ptr< const klt_pyramid_set > klt_pyramid_set_sptr;
+
+/// Compute the image and gradient pyramids of an image.
+///
+/// The caller must hold the klt_mutex lock.
+klt_pyramid_set_sptr build_klt_pyramid_set( const vil_image_view<vxl_byte>& img,
+                                            const klt_pyramid_params& params );
+
+
+class klt_pyramid_cache;
+typedef boost::shared_ptr<klt_pyramid_cache> klt_pyramid_cache_t;
+
+
+// ----------------------------------------------------------------
+/** Singleton cache of KLT pyramids for recent frames.
+ *
+ * Multiple nodes in a pipeline (stabilization, shot stitching, ...)
+ * frequently build identical pyramids of the same frame. Entries in
+ * this cache are keyed by frame timestamp and pyramid parameters, and
+ * are only built by the first consumer to request them. Consumers
+ * which arrive while an entry is being built wait on that entry
+ * instead of building their own copy.
+ *
+ * Returned pyramids are reference counted, so evicting an entry never
+ * invalidates data still held by a consumer. To guard against two
+ * streams with identical timestamps sharing a cache, an entry is only
+ * reused when the size and a content hash of its source image match;
+ * the source pixels themselves are not retained.
+ */
+class klt_pyramid_cache
+{
+public:
+  static klt_pyramid_cache_t instance();
+  virtual ~klt_pyramid_cache();
+
+  /// Return the pyramids for the given frame, building them if needed.
+  klt_pyramid_set_sptr get( const timestamp& ts,
+                            const vil_image_view<vxl_byte>& img,
+                            const klt_pyramid_params& params );
+
+  /// Set the maximum number of entries retained, defaults to 4.
+  void set_capacity( unsigned capacity );
+
+  /// Remove all entries from the cache.
+  void clear();
+
+  /// Number of requests served from an existing entry.
+  unsigned hit_count() const;
+
+  /// Number of requests which required a new pyramid to be built.
+  unsigned build_count() const;
+
+
+protected:
+  klt_pyramid_cache();
+
+
+private:
+  struct entry
+  {
+    timestamp ts;
+    klt_pyramid_params params;
+    unsigned ni;
+    unsigned nj;
+    unsigned nplanes;
+    vxl_uint_64 content_hash;
+    klt_pyramid_set_sptr pyramids;
+    boost::shared_ptr<boost::mutex> build_lock;
+  };
+
+  typedef std::list< boost::shared_ptr<entry> > entry_list_t;
+
+  entry_list_t entries_;       // most recently used first
+  unsigned capacity_;
+  unsigned hit_count_;
+  unsigned build_count_;
+  mutable boost::mutex lock_;  // synchronization lock
+
+
+  static klt_pyramid_cache_t s_instance;
+}; // end class klt_pyramid_cache
+
+} // end namespace vidtk
+
+#endif // vidtk_kwklt_pyramid_cache_h_
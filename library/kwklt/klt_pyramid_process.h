@@ -13,6 +13,7 @@
 #include <process_framework/pipeline_aid.h>
 #include <process_framework/process.h>
 #include <utilities/config_block.h>
+#include <utilities/timestamp.h>
 
 namespace vidtk
 {
@@ -49,6 +50,12 @@ public:
 
   VIDTK_INPUT_PORT(set_image, vil_image_view<PixType> const&);
 
+  /// Set the timestamp of the next image. Optional, but required for
+  /// pyramids to be shared with other consumers of the same frame.
+  void set_timestamp(timestamp const& ts);
+
+  VIDTK_OPTIONAL_INPUT_PORT(set_timestamp, timestamp const&);
+
   /// The image pyramid of the input image.
   vil_pyramid_image_view<float> image_pyramid() const;
   VIDTK_OUTPUT_PORT(vil_pyramid_image_view<float>, image_pyramid);
@@ -63,6 +70,7 @@ public:
 
 protected:
   vil_image_view<vxl_byte> img_; //This should be templated, but some of the klt code is assuming uchar images.
+  timestamp ts_;
   vil_pyramid_image_view<float> pyramid_;
   vil_pyramid_image_view<float> pgradx_;
   vil_pyramid_image_view<float> pgrady_;
@@ -87,6 +95,9 @@ protected:
 
   /// Sigma factor for computation of the image gradient pyramids.
   float grad_sigma_;
+
+  /// Share pyramids with other nodes through the klt_pyramid_cache.
+  bool use_shared_cache_;
 };
 
 template<>
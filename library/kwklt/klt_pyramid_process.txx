@@ -13,6 +13,7 @@
 
 #include "klt_util.h"
 #include <kwklt/klt_mutex.h>
+#include <kwklt/klt_pyramid_cache.h>
 
 #include <vil/vil_convert.h>
 #include <logger/logger.h>
@@ -35,6 +36,7 @@ klt_pyramid_process<PixType>::klt_pyramid_process(std::string const& _name)
   , init_sigma_(0.7f)
   , sigma_factor_(0.9f)
   , grad_sigma_(1.0f)
+  , use_shared_cache_(false)
 {
   config_.add_parameter("levels", "2", "UNDOCUMENTED");
   config_.add_parameter("subsampling", "4", "UNDOCUMENTED");
@@ -42,6 +44,11 @@ klt_pyramid_process<PixType>::klt_pyramid_process(std::string const& _name)
   config_.add_parameter("sigma_factor", "0.9", "UNDOCUMENTED");
   config_.add_parameter("grad_sigma", "1.0", "UNDOCUMENTED");
   config_.add_parameter("disabled", "false", "UNDOCUMENTED");
+  config_.add_parameter("use_shared_cache", "false",
+                        "Reuse pyramids built by other nodes for the same frame and "
+                        "parameters, instead of building them again. Only used when "
+                        "the timestamp port is connected, and only worth enabling "
+                        "when more than one node builds pyramids of the same frames.");
 }
 
 template< class PixType >
@@ -68,6 +75,7 @@ bool klt_pyramid_process<PixType>::set_params(config_block const& blk)
       init_sigma_ = blk.get<float>("init_sigma");
       sigma_factor_ = blk.get<float>("sigma_factor");
       grad_sigma_ = blk.get<float>("grad_sigma");
+      use_shared_cache_ = blk.get<bool>("use_shared_cache");
     }
   }
   catch(config_block_parse_error& e)
@@ -87,6 +95,7 @@ bool klt_pyramid_process<PixType>::initialize()
   //Currently, we are using vxl_byte because the KLT code make way too many 8 bit image
   //assumptions.  TODO: This should be changed.
   img_ = vil_image_view<vxl_byte>();
+  ts_ = timestamp();
 
   return true;
 }
@@ -97,6 +106,7 @@ bool klt_pyramid_process<PixType>::step()
   if (disabled_)
   {
     img_ = vil_image_view<vxl_byte>();
+    ts_ = timestamp();
     return true;
   }
 
@@ -106,32 +116,35 @@ bool klt_pyramid_process<PixType>::step()
   }
 
 
-  // critical region
-  boost::lock_guard<boost::mutex> lock(vidtk::klt_mutex::instance()->get_lock());
+  klt_pyramid_params params;
+  params.levels = levels_;
+  params.subsampling = subsampling_;
+  params.init_sigma = init_sigma_;
+  params.sigma_factor = sigma_factor_;
+  params.grad_sigma = grad_sigma_;
 
-  pyramid_ = create_klt_pyramid(img_, levels_, subsampling_, sigma_factor_, init_sigma_);
+  klt_pyramid_set_sptr pyramids;
 
-  pgradx_ = vil_pyramid_image_view<float>();
-  pgrady_ = vil_pyramid_image_view<float>();
-
-  double scale = 1;
-
-  for (int i = 0; i < levels_; ++i)
+  if (use_shared_cache_ && ts_.is_valid())
   {
-    std::pair<vil_image_view<float>, vil_image_view<float> > const grads = compute_gradients(pyramid_(i), grad_sigma_);
-
-    vil_image_view_base_sptr gradx(new vil_image_view<float>(grads.first));
-    pgradx_.add_view(gradx, scale);
-
-    vil_image_view_base_sptr grady(new vil_image_view<float>(grads.second));
-    pgrady_.add_view(grady, scale);
+    pyramids = klt_pyramid_cache::instance()->get(ts_, img_, params);
+  }
+  else
+  {
+    // critical region
+    boost::lock_guard<boost::mutex> lock(vidtk::klt_mutex::instance()->get_lock());
 
-    scale /= subsampling_;
+    pyramids = build_klt_pyramid_set(img_, params);
   }
 
+  pyramid_ = pyramids->image;
+  pgradx_ = pyramids->gradx;
+  pgrady_ = pyramids->grady;
+
   //Currently, we are using vxl_byte because the KLT code make way too many 8 bit image
   //assumptions.  TODO: This should be changed.
   img_ = vil_image_view<vxl_byte>();
+  ts_ = timestamp();
 
   return true;
 }
@@ -160,6 +173,12 @@ void klt_pyramid_process<vxl_byte>::set_image(vil_image_view<vxl_byte> const& im
   img_ = img;
 }
 
+template< class PixType >
+void klt_pyramid_process<PixType>::set_timestamp(timestamp const& ts)
+{
+  ts_ = ts;
+}
+
 template< class PixType >
 vil_pyramid_image_view<float> klt_pyramid_process<PixType>::image_pyramid() const
 {
@@ -34,6 +34,34 @@ config_block klt_tracking_process_impl::params()
   config_.add_parameter("window_height", "7", "The height of the search window for correspondence (must be odd)");
   config_.add_parameter("min_distance", "10", "The minimum distance allowed between two feature points");
   config_.add_parameter("num_skipped_pixels", "0", "The number of pixels to skip when searching for feature points");
+  config_.add_parameter("feature_selection", "full",
+      "How new feature points are selected: \"full\" takes the best points of the whole image, "
+      "\"grid\" takes the best points of each cell of a grid, for a more even coverage of the image");
+  config_.add_parameter("selection_grid_cols", "8", "The number of grid cells across the image, for grid feature_selection");
+  config_.add_parameter("selection_grid_rows", "6", "The number of grid cells down the image, for grid feature_selection");
+  config_.add_parameter("thread_count", "0",
+      "The maximum number of threads used to track features, or 0 for the compute pool core budget");
+  config_.add_parameter("coarse_to_fine", "false",
+      "Estimate the frame to frame motion from coarse_feature_count features tracked down to coarse_level "
+      "of the pyramid, then track all features on only the refine_levels finest levels, starting from that estimate");
+  config_.add_parameter("coarse_feature_count", "50",
+      "The number of features used to estimate the coarse motion, for coarse_to_fine tracking");
+  config_.add_parameter("coarse_level", "1",
+      "The finest pyramid level used to estimate the coarse motion, for coarse_to_fine tracking. "
+      "Levels above the top of the pyramid use the top level");
+  config_.add_parameter("refine_levels", "1",
+      "The number of finest pyramid levels on which features are tracked from the coarse motion, "
+      "for coarse_to_fine tracking");
+  config_.add_parameter("frame_time_target", "0",
+      "The time in seconds to aim for when tracking and replacing features on a frame. The number of "
+      "features is lowered, down to min_feature_budget, while tracking is slower than this, and raised "
+      "back to feature_count while it is faster. 0 always uses feature_count features");
+  config_.add_parameter("min_feature_budget", "50",
+      "The fewest features tracked when meeting frame_time_target");
+  config_.add_parameter("compare_single_scale", "false",
+      "Also track the features on every pyramid level from the input prediction, and periodically log "
+      "how far the coarse_to_fine results are from those and how long each took. This doubles the "
+      "tracking cost, so it is only meant for evaluating coarse_to_fine settings");
   config_.add_parameter("disabled", "false", "Self-explanitory");
 
   return config_;
@@ -52,12 +80,62 @@ bool klt_tracking_process_impl::set_params(config_block const& blk)
     window_height_ = blk.get<int>("window_height");
     min_distance_ = blk.get<int>("min_distance");
     num_skipped_pixels_ = blk.get<int>("num_skipped_pixels");
+    thread_count_ = blk.get<unsigned>("thread_count");
+    coarse_to_fine_ = blk.get<bool>("coarse_to_fine");
+    coarse_feature_count_ = blk.get<int>("coarse_feature_count");
+    coarse_level_ = blk.get<int>("coarse_level");
+    refine_levels_ = blk.get<int>("refine_levels");
+    frame_time_target_ = blk.get<double>("frame_time_target");
+    min_feature_budget_ = blk.get<int>("min_feature_budget");
+    compare_single_scale_ = blk.get<bool>("compare_single_scale");
+
+    std::string const selection = blk.get<std::string>("feature_selection");
+    if (selection == "full")
+    {
+      selection_grid_cols_ = 0;
+      selection_grid_rows_ = 0;
+    }
+    else if (selection == "grid")
+    {
+      selection_grid_cols_ = blk.get<int>("selection_grid_cols");
+      selection_grid_rows_ = blk.get<int>("selection_grid_rows");
+      if (selection_grid_cols_ < 1 || selection_grid_rows_ < 1)
+      {
+        throw config_block_parse_error(" selection grid must have at least one cell.");
+      }
+    }
+    else
+    {
+      throw config_block_parse_error(" Unknown feature_selection: " + selection);
+    }
 
     if (min_feature_count_percent <= 0 || 1 < min_feature_count_percent)
     {
       throw config_block_parse_error(" min_feature_count_percent must be within (0, 1].");
     }
+    min_feature_count_percent_ = min_feature_count_percent;
     min_feature_count_ = static_cast<int>(min_feature_count_percent * feature_count_);
+
+    if (coarse_to_fine_)
+    {
+      if (coarse_feature_count_ < 4)
+      {
+        throw config_block_parse_error(" coarse_feature_count must be at least 4.");
+      }
+      if (coarse_level_ < 1 || refine_levels_ < 1)
+      {
+        throw config_block_parse_error(" coarse_level and refine_levels must be at least 1.");
+      }
+    }
+
+    if (frame_time_target_ < 0)
+    {
+      throw config_block_parse_error(" frame_time_target must not be negative.");
+    }
+    if (frame_time_target_ > 0 && (min_feature_budget_ < 1 || feature_count_ < min_feature_budget_))
+    {
+      throw config_block_parse_error(" min_feature_budget must be within [1, feature_count].");
+    }
   }
   return true;
 }
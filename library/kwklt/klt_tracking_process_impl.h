@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2011-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2011-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -50,10 +50,22 @@ public:
 
   int feature_count_;
   int min_feature_count_;
+  double min_feature_count_percent_;
   int window_width_;
   int window_height_;
   int min_distance_;
   int num_skipped_pixels_;
+  unsigned thread_count_;
+  int selection_grid_cols_;
+  int selection_grid_rows_;
+
+  bool coarse_to_fine_;
+  int coarse_feature_count_;
+  int coarse_level_;
+  int refine_levels_;
+  double frame_time_target_;
+  int min_feature_budget_;
+  bool compare_single_scale_;
 
   std::vector<klt_track_ptr> active_;
   std::vector<klt_track_ptr> terminated_;
@@ -11,18 +11,114 @@
 
 #include <klt/pyramid.h>
 
+#include <utilities/compute_pool.h>
 #include <utilities/timestamp.h>
 
+#include <vgl/algo/vgl_h_matrix_2d_compute_linear.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <logger/logger.h>
+#undef VIDTK_DEFAULT_LOGGER
+#define VIDTK_DEFAULT_LOGGER __vidtk_logger_auto_klt_tracking_process_impl_klt_cxx__
+VIDTK_LOGGER("klt_tracking_process_impl_klt_cxx");
+
+
 namespace vidtk
 {
 
+namespace
+{
+
+// Frames between reports of the comparison with single scale tracking
+unsigned const compare_report_interval = 100;
+
+
+double seconds_since( boost::posix_time::ptime const& start )
+{
+  return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1e6;
+}
+
+
+void reset_homog( float* homog )
+{
+  homog[0] = 1.0f;
+  homog[1] = 0.0f;
+  homog[2] = 0.0f;
+  homog[3] = 0.0f;
+  homog[4] = 1.0f;
+  homog[5] = 0.0f;
+  homog[6] = 0.0f;
+  homog[7] = 0.0f;
+  homog[8] = 1.0f;
+}
+
+
+// Copy the locations and states of the first features of a list,
+// leaving any affine tracking state of the destination alone
+void copy_features( KLT_FeatureList from, KLT_FeatureList to, int count )
+{
+  for (int i = 0; i < count; ++i)
+  {
+    to->feature[i]->x = from->feature[i]->x;
+    to->feature[i]->y = from->feature[i]->y;
+    to->feature[i]->val = from->feature[i]->val;
+  }
+  to->nFeatures = count;
+}
+
+
+void clear_feature( KLT_Feature feature )
+{
+  feature->x = -1.0f;
+  feature->y = -1.0f;
+  feature->val = KLT_NOT_FOUND;
+
+  if (feature->aff_img)
+  {
+    _KLTFreeFloatImage(feature->aff_img);
+    _KLTFreeFloatImage(feature->aff_img_gradx);
+    _KLTFreeFloatImage(feature->aff_img_grady);
+    feature->aff_img = NULL;
+    feature->aff_img_gradx = NULL;
+    feature->aff_img_grady = NULL;
+  }
+}
+
+
+void track_range( KLT_RangeFunction func, void* func_data, unsigned begin, unsigned end )
+{
+  func( func_data, static_cast<int>(begin), static_cast<int>(end) );
+}
+
+
+// KLT_ParallelFor running the ranges on the compute pool
+void klt_parallel_for( void* user_data, int begin, int end,
+                       KLT_RangeFunction func, void* func_data )
+{
+  unsigned const max_threads = *static_cast<unsigned*>(user_data);
+
+  compute_pool::instance()->parallel_for( begin, end,
+                                          boost::bind( &track_range, func, func_data, _1, _2 ),
+                                          "klt_tracking", max_threads );
+}
+
+} // end anonymous namespace
+
+
 klt_tracking_process_impl_klt::klt_tracking_process_impl_klt()
   : klt_tracking_process_impl()
 {
   klt_feature_list_ = NULL;
+  coarse_feature_list_ = NULL;
+  single_scale_feature_list_ = NULL;
 
   klt_tracking_context_ = NULL;
 
@@ -39,6 +135,8 @@ klt_tracking_process_impl_klt::~klt_tracking_process_impl_klt()
     KLTFreeTrackingContext(klt_tracking_context_);
   }
   KLTFreeFeatureList(klt_feature_list_);
+  KLTFreeFeatureList(coarse_feature_list_);
+  KLTFreeFeatureList(single_scale_feature_list_);
 }
 
 
@@ -46,6 +144,18 @@ bool klt_tracking_process_impl_klt::initialize()
 { // critical region
   boost::lock_guard<boost::mutex> lock(vidtk::klt_mutex::instance()->get_lock());
 
+  feature_budget_ = feature_count_;
+  frame_seconds_ = 0.0;
+  average_frame_seconds_ = -1.0;
+
+  compare_frames_ = 0;
+  compare_features_ = 0;
+  compare_mismatches_ = 0;
+  compare_distance_sum_ = 0.0;
+  compare_distance_max_ = 0.0;
+  compare_coarse_to_fine_seconds_ = 0.0;
+  compare_single_scale_seconds_ = 0.0;
+
   klt_tracking_process_impl::initialize();
 
   if (klt_tracking_context_)
@@ -59,6 +169,14 @@ bool klt_tracking_process_impl_klt::initialize()
   klt_tracking_context_->window_height = window_height_;
   klt_tracking_context_->mindist = min_distance_;
   klt_tracking_context_->nSkippedPixels = num_skipped_pixels_;
+  klt_tracking_context_->grid_cols = selection_grid_cols_;
+  klt_tracking_context_->grid_rows = selection_grid_rows_;
+
+  if (thread_count_ != 1)
+  {
+    klt_tracking_context_->parallel_for = &klt_parallel_for;
+    klt_tracking_context_->parallel_for_data = &thread_count_;
+  }
 
   // The input pyramids are trusted, so search_range can be bogus here.
   KLTChangeTCPyramid(klt_tracking_context_, 0);
@@ -82,18 +200,25 @@ bool klt_tracking_process_impl_klt::reinitialize()
   klt_prev_.pyramid = NULL;
   klt_prev_.pyramid_gradx = NULL;
   klt_prev_.pyramid_grady = NULL;
-  homog_predict_[0] = 1.0f;
-  homog_predict_[1] = 0.0f;
-  homog_predict_[2] = 0.0f;
-  homog_predict_[3] = 0.0f;
-  homog_predict_[4] = 1.0f;
-  homog_predict_[5] = 0.0f;
-  homog_predict_[6] = 0.0f;
-  homog_predict_[7] = 0.0f;
-  homog_predict_[8] = 1.0f;
+  reset_homog(homog_predict_);
 
   KLTFreeFeatureList(klt_feature_list_);
   klt_feature_list_ = KLTCreateFeatureList(feature_count_);
+  klt_feature_list_->nFeatures = feature_budget_;
+
+  KLTFreeFeatureList(coarse_feature_list_);
+  coarse_feature_list_ = NULL;
+  if (coarse_to_fine_)
+  {
+    coarse_feature_list_ = KLTCreateFeatureList(coarse_feature_count_);
+  }
+
+  KLTFreeFeatureList(single_scale_feature_list_);
+  single_scale_feature_list_ = NULL;
+  if (compare_single_scale_)
+  {
+    single_scale_feature_list_ = KLTCreateFeatureList(feature_count_);
+  }
 
   return true;
 }
@@ -110,19 +235,53 @@ bool klt_tracking_process_impl_klt::is_ready()
 
 int klt_tracking_process_impl_klt::track_features()
 {
-  KLTTrackFeaturesPyramid(klt_tracking_context_, &klt_prev_, &klt_cur_, klt_cur_.pyramid->ncols[0], klt_cur_.pyramid->nrows[0], homog_predict_, klt_feature_list_);
+  apply_feature_budget();
+
+  double single_scale_seconds = 0.0;
+  if (compare_single_scale_)
+  {
+    boost::posix_time::ptime const start = boost::posix_time::microsec_clock::universal_time();
+
+    copy_features(klt_feature_list_, single_scale_feature_list_, klt_feature_list_->nFeatures);
+    KLTTrackFeaturesPyramid(klt_tracking_context_, &klt_prev_, &klt_cur_, klt_cur_.pyramid->ncols[0], klt_cur_.pyramid->nrows[0], homog_predict_, single_scale_feature_list_);
+
+    single_scale_seconds = seconds_since(start);
+  }
+
+  boost::posix_time::ptime const start = boost::posix_time::microsec_clock::universal_time();
+
+  if (coarse_to_fine_)
+  {
+    track_coarse_to_fine();
+  }
+  else
+  {
+    KLTTrackFeaturesPyramid(klt_tracking_context_, &klt_prev_, &klt_cur_, klt_cur_.pyramid->ncols[0], klt_cur_.pyramid->nrows[0], homog_predict_, klt_feature_list_);
+  }
+
+  double const seconds = seconds_since(start);
+  frame_seconds_ += seconds;
+
+  if (compare_single_scale_)
+  {
+    compare_single_scale(seconds, single_scale_seconds);
+  }
 
   return find_tracked_features();
 }
 
 void klt_tracking_process_impl_klt::replace_features()
 {
+  boost::posix_time::ptime const start = boost::posix_time::microsec_clock::universal_time();
+
   _KLT_FloatImage image = klt_cur_.pyramid->img[0];
   _KLT_FloatImage image_gradx = klt_cur_.pyramid_gradx->img[0];
   _KLT_FloatImage image_grady = klt_cur_.pyramid_grady->img[0];
 
   KLTReplaceLostFeaturesRaw(klt_tracking_context_, image, image_gradx, image_grady, klt_feature_list_);
 
+  frame_seconds_ += seconds_since(start);
+
   find_new_features();
 }
 
@@ -155,15 +314,14 @@ void klt_tracking_process_impl_klt::post_step()
   klt_cur_.pyramid_gradx = NULL;
   klt_cur_.pyramid_grady = NULL;
   ts_ = NULL;
-  homog_predict_[0] = 1.0f;
-  homog_predict_[1] = 0.0f;
-  homog_predict_[2] = 0.0f;
-  homog_predict_[3] = 0.0f;
-  homog_predict_[4] = 1.0f;
-  homog_predict_[5] = 0.0f;
-  homog_predict_[6] = 0.0f;
-  homog_predict_[7] = 0.0f;
-  homog_predict_[8] = 1.0f;
+  reset_homog(homog_predict_);
+
+  // Only frames on which features were tracked are timed
+  if (frame_time_target_ > 0 && frame_seconds_ > 0)
+  {
+    update_feature_budget();
+  }
+  frame_seconds_ = 0.0;
 
   klt_tracking_process_impl::post_step();
 }
@@ -207,6 +365,253 @@ void klt_tracking_process_impl_klt::set_homog_predict(vgl_h_matrix_2d<double> co
   homog_predict_[8] = static_cast<float>(h.get(2,2));
 }
 
+/// Estimate the motion from a few features tracked down to a coarse
+/// level, then track all features on the finest levels from there.
+void klt_tracking_process_impl_klt::track_coarse_to_fine()
+{
+  int const ncols = klt_cur_.pyramid->ncols[0];
+  int const nrows = klt_cur_.pyramid->nrows[0];
+  int const levels = std::min(klt_prev_.pyramid->nLevels, klt_cur_.pyramid->nLevels);
+
+  // Without levels to skip, this is single scale tracking
+  if (levels < 2)
+  {
+    KLTTrackFeaturesPyramid(klt_tracking_context_, &klt_prev_, &klt_cur_, ncols, nrows, homog_predict_, klt_feature_list_);
+    return;
+  }
+
+  int const coarse_level = std::min(coarse_level_, levels - 1);
+
+  // Take features spread evenly through the list, which is ordered by
+  // cell when features are selected on a grid
+  int tracked = 0;
+  for (int i = 0; i < klt_feature_list_->nFeatures; ++i)
+  {
+    if (klt_feature_list_->feature[i]->val >= 0)
+    {
+      ++tracked;
+    }
+  }
+
+  int const stride = std::max(1, tracked / coarse_feature_count_);
+  std::vector< vgl_homg_point_2d<double> > from;
+  int seen = 0;
+  int count = 0;
+
+  for (int i = 0; i < klt_feature_list_->nFeatures && count < coarse_feature_count_; ++i)
+  {
+    KLT_Feature const feature = klt_feature_list_->feature[i];
+    if (feature->val < 0 || seen++ % stride != 0)
+    {
+      continue;
+    }
+
+    coarse_feature_list_->feature[count]->x = feature->x;
+    coarse_feature_list_->feature[count]->y = feature->y;
+    coarse_feature_list_->feature[count]->val = KLT_TRACKED;
+    from.push_back(vgl_homg_point_2d<double>(feature->x, feature->y));
+    ++count;
+  }
+  coarse_feature_list_->nFeatures = count;
+
+  KLTTrackFeaturesPyramidLevels(klt_tracking_context_, &klt_prev_, &klt_cur_, ncols, nrows,
+                                homog_predict_, -1, coarse_level, coarse_feature_list_);
+
+  // One pixel at the coarse level
+  double const tolerance = std::pow(static_cast<double>(klt_cur_.pyramid->subsampling), coarse_level);
+
+  float coarse_homog[9];
+  if (!estimate_coarse_motion(from, tolerance, coarse_homog))
+  {
+    LOG_DEBUG("Could not estimate the coarse motion, tracking on all levels");
+    KLTTrackFeaturesPyramid(klt_tracking_context_, &klt_prev_, &klt_cur_, ncols, nrows, homog_predict_, klt_feature_list_);
+    return;
+  }
+
+  KLTTrackFeaturesPyramidLevels(klt_tracking_context_, &klt_prev_, &klt_cur_, ncols, nrows,
+                                coarse_homog, refine_levels_ - 1, 0, klt_feature_list_);
+}
+
+/// Fit a homography to the tracked coarse features, refitting once
+/// without the features which disagree with the first fit, such as
+/// those on moving objects.
+bool klt_tracking_process_impl_klt::estimate_coarse_motion(std::vector< vgl_homg_point_2d<double> > const& from,
+                                                           double tolerance, float* homog) const
+{
+  std::vector< vgl_homg_point_2d<double> > src;
+  std::vector< vgl_homg_point_2d<double> > dst;
+
+  for (size_t i = 0; i < from.size(); ++i)
+  {
+    KLT_Feature const feature = coarse_feature_list_->feature[i];
+    if (feature->val == KLT_TRACKED)
+    {
+      src.push_back(from[i]);
+      dst.push_back(vgl_homg_point_2d<double>(feature->x, feature->y));
+    }
+  }
+
+  vgl_h_matrix_2d_compute_linear compute;
+  vgl_h_matrix_2d<double> H;
+
+  if (src.size() < 4 || !compute.compute(src, dst, H))
+  {
+    return false;
+  }
+
+  std::vector<double> residuals(src.size());
+  for (size_t i = 0; i < src.size(); ++i)
+  {
+    vgl_homg_point_2d<double> const p = H(src[i]);
+    residuals[i] = (p.w() == 0.0)
+      ? std::numeric_limits<double>::infinity()
+      : std::sqrt(std::pow(p.x() / p.w() - dst[i].x(), 2) + std::pow(p.y() / p.w() - dst[i].y(), 2));
+  }
+
+  std::vector<double> sorted(residuals);
+  std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+  double const threshold = std::max(3.0 * sorted[sorted.size() / 2], tolerance);
+
+  std::vector< vgl_homg_point_2d<double> > src_inliers;
+  std::vector< vgl_homg_point_2d<double> > dst_inliers;
+  for (size_t i = 0; i < src.size(); ++i)
+  {
+    if (residuals[i] <= threshold)
+    {
+      src_inliers.push_back(src[i]);
+      dst_inliers.push_back(dst[i]);
+    }
+  }
+
+  if (src_inliers.size() < 4)
+  {
+    return false;
+  }
+
+  if (src_inliers.size() < src.size() && !compute.compute(src_inliers, dst_inliers, H))
+  {
+    return false;
+  }
+
+  vnl_matrix_fixed<double, 3, 3> const& m = H.get_matrix();
+  if (std::fabs(m(2, 2)) < 1e-12)
+  {
+    return false;
+  }
+
+  for (unsigned r = 0; r < 3; ++r)
+  {
+    for (unsigned c = 0; c < 3; ++c)
+    {
+      homog[r * 3 + c] = static_cast<float>(m(r, c) / m(2, 2));
+    }
+  }
+
+  return true;
+}
+
+/// Accumulate how far the features are from where single scale
+/// tracking put them, and log it every compare_report_interval frames.
+void klt_tracking_process_impl_klt::compare_single_scale(double coarse_to_fine_seconds, double single_scale_seconds)
+{
+  for (int i = 0; i < klt_feature_list_->nFeatures; ++i)
+  {
+    KLT_Feature const feature = klt_feature_list_->feature[i];
+    KLT_Feature const single = single_scale_feature_list_->feature[i];
+
+    bool const tracked = (feature->val == KLT_TRACKED);
+    if (tracked != (single->val == KLT_TRACKED))
+    {
+      ++compare_mismatches_;
+    }
+    else if (tracked)
+    {
+      double const dx = feature->x - single->x;
+      double const dy = feature->y - single->y;
+      double const distance = std::sqrt(dx * dx + dy * dy);
+
+      compare_distance_sum_ += distance;
+      compare_distance_max_ = std::max(compare_distance_max_, distance);
+      ++compare_features_;
+    }
+  }
+
+  compare_coarse_to_fine_seconds_ += coarse_to_fine_seconds;
+  compare_single_scale_seconds_ += single_scale_seconds;
+
+  if (++compare_frames_ < compare_report_interval)
+  {
+    return;
+  }
+
+  LOG_INFO("Tracking over " << compare_frames_ << " frames, "
+           << (coarse_to_fine_ ? "coarse to fine" : "single scale") << " against single scale: "
+           << "mean distance " << (compare_features_ ? compare_distance_sum_ / compare_features_ : 0.0)
+           << " px, max distance " << compare_distance_max_
+           << " px over " << compare_features_ << " features, "
+           << compare_mismatches_ << " features tracked by only one, "
+           << 1000.0 * compare_coarse_to_fine_seconds_ / compare_frames_ << " ms against "
+           << 1000.0 * compare_single_scale_seconds_ / compare_frames_ << " ms per frame");
+
+  compare_frames_ = 0;
+  compare_features_ = 0;
+  compare_mismatches_ = 0;
+  compare_distance_sum_ = 0.0;
+  compare_distance_max_ = 0.0;
+  compare_coarse_to_fine_seconds_ = 0.0;
+  compare_single_scale_seconds_ = 0.0;
+}
+
+/// Resize the feature list to the budget, terminating the tracks of
+/// features beyond it.
+void klt_tracking_process_impl_klt::apply_feature_budget()
+{
+  int const current = klt_feature_list_->nFeatures;
+
+  for (int i = feature_budget_; i < current; ++i)
+  {
+    if (current_[i])
+    {
+      terminated_.push_back(current_[i]);
+      current_[i] = klt_track_ptr();
+    }
+    clear_feature(klt_feature_list_->feature[i]);
+  }
+
+  // Features added back to the budget are found when lost features are
+  // next replaced
+  for (int i = current; i < feature_budget_; ++i)
+  {
+    clear_feature(klt_feature_list_->feature[i]);
+  }
+
+  klt_feature_list_->nFeatures = feature_budget_;
+}
+
+/// Scale the budget towards the frame time target, by at most a tenth
+/// per frame, following a moving average of the frame time.
+void klt_tracking_process_impl_klt::update_feature_budget()
+{
+  average_frame_seconds_ = (average_frame_seconds_ < 0)
+    ? frame_seconds_
+    : 0.8 * average_frame_seconds_ + 0.2 * frame_seconds_;
+
+  double const ratio = frame_time_target_ / average_frame_seconds_;
+  int budget = feature_budget_;
+
+  if (ratio < 0.95)
+  {
+    budget = static_cast<int>(budget * std::max(ratio, 0.9));
+  }
+  else if (ratio > 1.05)
+  {
+    budget = std::max(budget + 1, static_cast<int>(budget * std::min(ratio, 1.1)));
+  }
+
+  feature_budget_ = std::max(min_feature_budget_, std::min(feature_count_, budget));
+  min_feature_count_ = static_cast<int>(min_feature_count_percent_ * feature_budget_);
+}
+
 void klt_tracking_process_impl_klt::find_new_features()
 {
   for (int i = 0; i < klt_feature_list_->nFeatures; ++i)
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2011-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2011-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -12,6 +12,7 @@
 #include <klt/klt.h>
 
 #include <vil/vil_pyramid_image_view.h>
+#include <vgl/vgl_homg_point_2d.h>
 
 #include <utilities/config_block.h>
 #include <utilities/timestamp.h>
@@ -51,6 +52,14 @@ protected:
   void find_new_features();
   int find_tracked_features();
 
+  void track_coarse_to_fine();
+  bool estimate_coarse_motion(std::vector< vgl_homg_point_2d<double> > const& from,
+                              double tolerance, float* homog) const;
+  void compare_single_scale(double coarse_to_fine_seconds, double single_scale_seconds);
+
+  void apply_feature_budget();
+  void update_feature_budget();
+
   timestamp const* ts_;
   float homog_predict_[9];
 
@@ -59,7 +68,26 @@ protected:
   KLT_TrackingContext klt_tracking_context_;
   KLT_FeatureList klt_feature_list_;
 
+  // Features used to estimate the coarse motion, and copies of the
+  // features tracked the single scale way, for comparison
+  KLT_FeatureList coarse_feature_list_;
+  KLT_FeatureList single_scale_feature_list_;
+
   std::vector<klt_track_ptr> current_;
+
+  // Number of features tracked to meet the frame time target
+  int feature_budget_;
+  double frame_seconds_;
+  double average_frame_seconds_;
+
+  // Differences from single scale tracking since the last report
+  unsigned compare_frames_;
+  unsigned compare_features_;
+  unsigned compare_mismatches_;
+  double compare_distance_sum_;
+  double compare_distance_max_;
+  double compare_coarse_to_fine_seconds_;
+  double compare_single_scale_seconds_;
 };
 
 
@@ -44,10 +44,8 @@ create_klt_pyramid(vil_image_view<PixType> /*const*/& img, int levels, int subsa
   vil_pyramid_image_view<float> pyramid;
 
   const float sigma = subsampling * sigma_factor;
-  const int subhalf = subsampling / 2;
   int cols = img.ni();
   int rows = img.nj();
-  int old_cols;
   double scale = 1;
 
   vil_image_view_base_sptr img_ptr;
@@ -68,33 +66,21 @@ create_klt_pyramid(vil_image_view<PixType> /*const*/& img, int levels, int subsa
   }
   for (int i = 1; i < levels; ++i)
   {
-    _KLT_FloatImage smooth = _KLTCreateFloatImage(cur_img->ncols, cur_img->nrows);
-
-    // FIXME: Inefficient (pixels tossed away below).
-    _KLTComputeSmoothedImage(cur_img, sigma, smooth);
-
-    old_cols = cols;
     cols /= subsampling;
     rows /= subsampling;
-    cur_img->ncols = cols;
-    cur_img->nrows = rows;
 
-    for(int y = 0; y < rows; ++y)
-    {
-      const size_t off_sub = cols * y;
-      const size_t off_sm = (subsampling * y + subhalf)*old_cols;
-      for(int x = 0; x < cols; ++x)
-      {
-        cur_img->data[off_sub+x] = smooth->data[ off_sm + subsampling * x + subhalf ];
-      }
-    }
+    // Only the pixels kept in the subsampled level are convolved.
+    _KLT_FloatImage smooth = _KLTCreateFloatImage(cols, rows);
+
+    _KLTComputeSubsampledSmoothedImage(cur_img, sigma, subsampling, smooth);
 
-    img_ptr = new vil_image_view<float>( klt_img_to_vil(cur_img));
+    img_ptr = new vil_image_view<float>( klt_img_to_vil(smooth));
     pyramid.add_view(img_ptr, scale);
 
     scale /= subsampling;
 
-    _KLTFreeFloatImage(smooth);
+    _KLTFreeFloatImage(cur_img);
+    cur_img = smooth;
   }
 
   _KLTFreeFloatImage(cur_img);
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -28,6 +28,8 @@
 #include <learning/histogram_weak_learners.h>
 #include <learning/tree_weak_learners.h>
 
+#include <utilities/config_snapshot.h>
+
 #include <logger/logger.h>
 #undef VIDTK_DEFAULT_LOGGER
 #define VIDTK_DEFAULT_LOGGER __vidtk_logger_auto_adaboost_cxx__
@@ -342,17 +344,43 @@ adaboost::~adaboost()
 bool
 adaboost::read_from_file(const std::string& fn)
 {
+  // The weak learners are polymorphic and only have a text format, so
+  // snapshots hold a copy of the model text rather than a binary form.
+  config_snapshot_sptr snapshot = config_snapshot::active();
+  std::string text;
+
+  if( snapshot && snapshot->find_model( "adaboost", fn, text ) )
+  {
+    std::istringstream cached( text );
+    return this->read( cached );
+  }
+
   std::ifstream input( fn.c_str() );
 
-  if( input )
+  if( !input )
+  {
+    LOG_ERROR( "Unable to open: " << fn );
+    return false;
+  }
+
+  if( !snapshot || !snapshot->is_recording() )
+  {
+    return this->read( input );
+  }
+
+  std::ostringstream contents;
+  contents << input.rdbuf();
+  text = contents.str();
+
+  std::istringstream parsed( text );
+  bool status = this->read( parsed );
+
+  if( status )
   {
-    bool status = this->read( input );
-    input.close();
-    return status;
+    snapshot->add_model( "adaboost", fn, text );
   }
 
-  LOG_ERROR( "Unable to open: " << fn );
-  return false;
+  return status;
 }
 
 bool
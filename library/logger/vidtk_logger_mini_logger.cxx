@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -9,6 +9,7 @@
 
 #include <logger/vidtk_mini_logger_formatter.h>
 #include <logger/vidtk_mini_logger_formatter_int.h>
+#include <logger/vidtk_mini_logger_async_writer.h>
 
 #include <logger/logger_factory.h>
 #include <logger/location_info.h>
@@ -65,6 +66,9 @@ vidtk_logger_mini_logger
 vidtk_logger_mini_logger
 ::~vidtk_logger_mini_logger()
 {
+  // Queued messages refer to this logger
+  flush_async_output();
+
   delete m_formatter;
 }
 
@@ -173,10 +177,44 @@ std::ostream& vidtk_logger_mini_logger
 void vidtk_logger_mini_logger
 ::set_output_stream( std::ostream* str )
 {
+  // Queued messages go to the stream in use when they were logged
+  flush_async_output();
+
   s_output_stream = str;
 }
 
 
+// ----------------------------------------------------------------
+/** Asynchronous output control.
+ *
+ *
+ */
+bool vidtk_logger_mini_logger
+::enable_async_output( unsigned capacity )
+{
+  return mini_logger_async_writer::enable( capacity );
+}
+
+
+void vidtk_logger_mini_logger
+::flush_async_output()
+{
+  mini_logger_async_writer* writer = mini_logger_async_writer::instance();
+  if ( writer )
+  {
+    writer->flush();
+  }
+}
+
+
+unsigned long vidtk_logger_mini_logger
+::dropped_message_count()
+{
+  mini_logger_async_writer* writer = mini_logger_async_writer::instance();
+  return ( writer ? writer->dropped_count() : 0 );
+}
+
+
 // ----------------------------------------------------------------
 /* Log messages
  *
@@ -315,55 +353,146 @@ void vidtk_logger_mini_logger
 void vidtk_logger_mini_logger
 ::log_message ( vidtk_logger::log_level_t level, std::string const& msg)
 {
-  // If a formatter is specified, then use it.
-  if (0 != m_formatter)
+  dispatch_message (level, msg, 0);
+}
+
+
+// ----------------------------------------------------------------
+/** Format log message.
+ *
+ *
+ */
+void vidtk_logger_mini_logger
+::log_message ( vidtk_logger::log_level_t level,
+                std::string const& msg,
+                vidtk::logger_ns::location_info const & location)
+{
+  dispatch_message (level, msg, &location);
+}
+
+
+// ----------------------------------------------------------------
+/** Queue or write a message.
+ *
+ * The time is taken here, so that it is the time the message was
+ * logged even if it is written later.
+ */
+void vidtk_logger_mini_logger
+::dispatch_message ( vidtk_logger::log_level_t level,
+                     std::string const& msg,
+                     vidtk::logger_ns::location_info const * location)
+{
+  ptime now = microsec_clock::local_time();
+
+  mini_logger_async_writer* writer = mini_logger_async_writer::instance();
+  if (0 != writer)
+  {
+    mini_logger_record* rec = new mini_logger_record;
+    rec->logger = this;
+    rec->level = level;
+    rec->message = msg;
+    rec->time = now;
+    rec->has_location = (0 != location);
+    rec->file_name = (location ? location->get_file_name_ptr() : 0);
+    rec->method_name = (location ? location->get_method_name_ptr() : 0);
+    rec->line_number = (location ? location->get_line_number() : 0);
+
+    if (writer->push(rec))
+    {
+      // Make sure the reason for stopping reaches the log
+      if (LEVEL_FATAL == level)
+      {
+        writer->flush();
+      }
+      return;
+    }
+
+    // The writer is shutting down, write directly
+    delete rec;
+  }
+
+  std::ostream *s = &get_stream();
   {
     boost::lock_guard<boost::mutex> formatter_lock(m_formatter_mtx);
-    log_message (level, msg, *m_formatter);
-    return;
+    boost::lock_guard<boost::mutex> stream_lock(get_stream_mtx(*s));
+    format_message(*s, level, msg, location, now);
   }
+}
 
-  // Format this message on the stream
 
-  // Get the current time in milliseconds, creating a formated
-  // string for log message.
-  ptime now = microsec_clock::local_time();
+// ----------------------------------------------------------------
+/** Format a message on a stream.
+ *
+ * The formatter mutex must be held by the caller.
+ */
+void vidtk_logger_mini_logger
+::format_message ( std::ostream& str,
+                   vidtk_logger::log_level_t level,
+                   std::string const& msg,
+                   vidtk::logger_ns::location_info const * location,
+                   ptime const& time)
+{
+  // If a formatter is specified, then use it.
+  if (0 != m_formatter)
+  {
+    m_formatter->get_impl()->m_level = level;
+    m_formatter->get_impl()->m_message = &msg;
+    m_formatter->get_impl()->m_location = location;
+    m_formatter->get_impl()->m_realm = &m_loggingRealm;
+    m_formatter->get_impl()->m_time = time;
+
+    m_formatter->format_message(str);
+    return;
+  }
 
   // Ensure that multi-line messages still get the time and level prefix
   std::string level_str = get_level_string(level);
   std::string msg_part;
   std::istringstream ss(msg);
 
-  std::ostream *s = &get_stream();
+  while(getline(ss, msg_part))
   {
-    boost::lock_guard<boost::mutex> stream_lock(get_stream_mtx(*s));
-    while(getline(ss, msg_part))
-    {
-      *s << now << ' ' << level_str << ' ' << msg_part << '\n';
-    }
+    str << time << ' ' << level_str << ' ' << msg_part << '\n';
   }
 }
 
 
 // ----------------------------------------------------------------
-/** Format log message.
- *
+/** Format a queued message.
  *
+ * Called on the writer thread.
  */
 void vidtk_logger_mini_logger
-::log_message ( vidtk_logger::log_level_t level,
-                std::string const& msg,
-                vidtk::logger_ns::location_info const & location)
+::write_record ( std::ostream& str, mini_logger_record const& rec )
 {
-  // If a formatter is specified, then use it.
-  if (0 != m_formatter)
+  boost::lock_guard<boost::mutex> formatter_lock(m_formatter_mtx);
+
+  if (rec.has_location)
   {
-    boost::lock_guard<boost::mutex> formatter_lock(m_formatter_mtx);
-    log_message (level, msg, location, *m_formatter);
-    return;
+    location_info location(rec.file_name, rec.method_name, rec.line_number);
+    format_message(str, rec.level, rec.message, &location, rec.time);
+  }
+  else
+  {
+    format_message(str, rec.level, rec.message, 0, rec.time);
   }
+}
+
 
-  log_message(level, msg);
+// ----------------------------------------------------------------
+/** Write formatted messages to the logging stream.
+ *
+ *
+ */
+void vidtk_logger_mini_logger
+::write_text( std::string const& text )
+{
+  std::ostream *s = &get_stream();
+  {
+    boost::lock_guard<boost::mutex> stream_lock(get_stream_mtx(*s));
+    *s << text;
+    s->flush();
+  }
 }
 
 
@@ -400,6 +529,7 @@ void vidtk_logger_mini_logger
   formatter.get_impl()->m_message = &msg;
   formatter.get_impl()->m_location = 0;
   formatter.get_impl()->m_realm = &m_loggingRealm;
+  formatter.get_impl()->m_time = microsec_clock::local_time();
 
   std::ostream *s = &get_stream();
   {
@@ -424,6 +554,7 @@ void vidtk_logger_mini_logger
   formatter.get_impl()->m_message = &msg;
   formatter.get_impl()->m_location = &location;
   formatter.get_impl()->m_realm = &m_loggingRealm;
+  formatter.get_impl()->m_time = microsec_clock::local_time();
 
   std::ostream *s = &get_stream();
   {
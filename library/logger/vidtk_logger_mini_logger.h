@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -11,6 +11,7 @@
 #include <map>
 #include <logger/vidtk_logger.h>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/thread/mutex.hpp>
 
 
@@ -19,6 +20,8 @@ namespace logger_ns {
 
 class vidtk_mini_logger_formatter;
 class logger_factory;
+class mini_logger_async_writer;
+struct mini_logger_record;
 
 // ----------------------------------------------------------------
 /** Minimal logging class.
@@ -27,6 +30,10 @@ class logger_factory;
  * vidtk_logger interface.  The output is just sent to a stream and
  * you have no way of redirecting the output.
  *
+ * Messages are normally formatted and written by the thread that logs
+ * them. When asynchronous output is enabled, they are queued and
+ * written by a background thread instead (see
+ * mini_logger_async_writer).
  */
 class vidtk_logger_mini_logger
   : public vidtk_logger
@@ -74,9 +81,26 @@ public:
   void register_formatter( vidtk_mini_logger_formatter* fmt );
   void set_output_stream( std::ostream* str );
 
+  /** Write messages on a background thread.
+   *
+   * Must be called before the first message is logged. The same can
+   * be done by setting VIDTK_LOGGER_ASYNC in the environment.
+   *
+   * @param capacity Number of messages each thread can queue before
+   * further messages are dropped, 0 for the default.
+   * @return True if messages are written asynchronously.
+   */
+  static bool enable_async_output( unsigned capacity = 0 );
+
+  /** Wait for all queued messages to be written. */
+  static void flush_async_output();
+
+  /** Number of messages dropped because a queue was full. */
+  static unsigned long dropped_message_count();
+
 
 protected:
-  std::ostream& get_stream();
+  static std::ostream& get_stream();
 
   virtual void log_message( log_level_t level, std::string const& msg );
   virtual void log_message( log_level_t level, std::string const& msg,
@@ -90,6 +114,16 @@ protected:
                             vidtk_mini_logger_formatter& formatter );
 
 private:
+  friend class mini_logger_async_writer;
+
+  void dispatch_message( log_level_t level, std::string const& msg,
+                         vidtk::logger_ns::location_info const* location );
+  void format_message( std::ostream& str, log_level_t level, std::string const& msg,
+                       vidtk::logger_ns::location_info const* location,
+                       boost::posix_time::ptime const& time );
+  void write_record( std::ostream& str, mini_logger_record const& rec );
+  static void write_text( std::string const& text );
+
   log_level_t                  m_logLevel;       // current logging level
 
   boost::mutex                 m_formatter_mtx;
@@ -0,0 +1,477 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+
+#include <logger/vidtk_mini_logger_async_writer.h>
+
+#include <logger/vidtk_logger_mini_logger.h>
+
+#include <boost/thread/once.hpp>
+#include <boost/version.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+// Lock free queues and atomics first appeared in boost 1.53
+#if BOOST_VERSION >= 105300
+#  define VIDTK_MINI_LOGGER_ASYNC
+#endif
+
+#ifdef VIDTK_MINI_LOGGER_ASYNC
+#  include <boost/atomic.hpp>
+#  include <boost/bind.hpp>
+#  include <boost/date_time/posix_time/posix_time.hpp>
+#  include <boost/lockfree/spsc_queue.hpp>
+#  include <boost/thread/condition_variable.hpp>
+#  include <boost/thread/locks.hpp>
+#  include <boost/thread/mutex.hpp>
+#  include <boost/thread/thread.hpp>
+#  include <boost/thread/tss.hpp>
+
+#  include <algorithm>
+#  include <sstream>
+#  include <vector>
+#endif
+
+using namespace boost::posix_time;
+
+namespace vidtk {
+namespace logger_ns {
+
+namespace {
+
+// Set once, before any message is logged
+boost::once_flag s_init_flag = BOOST_ONCE_INIT;
+mini_logger_async_writer* s_writer = 0;
+unsigned s_requested_capacity = 0;
+
+} // end namespace
+
+
+#ifdef VIDTK_MINI_LOGGER_ASYNC
+
+namespace {
+
+// How long the writer sleeps when there is nothing to write
+const long idle_wait_ms = 10;
+
+
+// Messages queued by one thread, only written by that thread and only
+// read by the writer thread.
+struct thread_buffer
+{
+  explicit thread_buffer( unsigned capacity )
+    : queue( capacity ),
+      dropped( 0 ),
+      closed( false )
+  { }
+
+  boost::lockfree::spsc_queue< mini_logger_record* > queue;
+  boost::atomic< unsigned long > dropped;
+
+  // Set when the owning thread exits; the writer then deletes the
+  // buffer once it is empty.
+  boost::atomic< bool > closed;
+};
+
+
+void close_buffer( thread_buffer* buf )
+{
+  buf->closed.store( true, boost::memory_order_release );
+}
+
+
+bool record_before( mini_logger_record const* a, mini_logger_record const* b )
+{
+  return a->time < b->time;
+}
+
+
+void shutdown_writer()
+{
+  if ( s_writer )
+  {
+    s_writer->shutdown();
+  }
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------
+class mini_logger_async_writer::priv
+{
+public:
+  explicit priv( unsigned cap )
+    : capacity( cap ),
+      local_buffer( &close_buffer ),
+      accepting( true ),
+      flush_requested( 0 ),
+      flush_completed( 0 ),
+      stop( false ),
+      running( true ),
+      dropped_total( 0 )
+  { }
+
+  thread_buffer* buffer_for_thread();
+  size_t drain();
+  void run();
+
+  const unsigned capacity;
+
+  boost::thread_specific_ptr< thread_buffer > local_buffer;
+
+  boost::mutex buffers_mtx;
+  std::vector< thread_buffer* > buffers;
+
+  boost::atomic< bool > accepting;
+
+  // Writer thread state, guarded by state_mtx
+  boost::mutex state_mtx;
+  boost::condition_variable wake;
+  boost::condition_variable done;
+  unsigned long flush_requested;
+  unsigned long flush_completed;
+  bool stop;
+  bool running;
+  unsigned long dropped_total;
+
+  boost::thread thread;
+};
+
+
+// ----------------------------------------------------------------
+/** Get the buffer of the calling thread, creating it on first use.
+ *
+ *
+ */
+thread_buffer*
+mini_logger_async_writer::priv
+::buffer_for_thread()
+{
+  thread_buffer* buf = local_buffer.get();
+
+  if ( ! buf )
+  {
+    buf = new thread_buffer( capacity );
+    local_buffer.reset( buf );
+
+    boost::lock_guard< boost::mutex > lock( buffers_mtx );
+    buffers.push_back( buf );
+  }
+
+  return buf;
+}
+
+
+// ----------------------------------------------------------------
+/** Write one batch of messages.
+ *
+ * Takes up to one buffer's capacity of messages from each thread,
+ * so that a single busy thread can not hold up the others.
+ * Returns the number of lines written.
+ */
+size_t
+mini_logger_async_writer::priv
+::drain()
+{
+  std::vector< mini_logger_record* > batch;
+  unsigned long dropped = 0;
+
+  {
+    boost::lock_guard< boost::mutex > lock( buffers_mtx );
+
+    for ( size_t i = 0; i < buffers.size(); )
+    {
+      thread_buffer* buf = buffers[i];
+
+      // Anything pushed before the thread exited is seen below
+      const bool closed = buf->closed.load( boost::memory_order_acquire );
+
+      mini_logger_record* rec;
+      for ( unsigned n = 0; n < capacity && buf->queue.pop( rec ); ++n )
+      {
+        batch.push_back( rec );
+      }
+
+      dropped += buf->dropped.exchange( 0 );
+
+      if ( closed && buf->queue.read_available() == 0 )
+      {
+        delete buf;
+        buffers.erase( buffers.begin() + i );
+      }
+      else
+      {
+        ++i;
+      }
+    }
+  }
+
+  if ( batch.empty() && dropped == 0 )
+  {
+    return 0;
+  }
+
+  // Interleave the threads' messages in the order they were logged
+  std::stable_sort( batch.begin(), batch.end(), &record_before );
+
+  std::ostringstream text;
+  text.imbue( vidtk_logger_mini_logger::get_stream().getloc() );
+
+  for ( size_t i = 0; i < batch.size(); ++i )
+  {
+    batch[i]->logger->write_record( text, *batch[i] );
+    delete batch[i];
+  }
+
+  if ( dropped != 0 )
+  {
+    text << microsec_clock::local_time() << " WARN "
+         << "Log buffer full, dropped " << dropped << " messages\n";
+
+    boost::lock_guard< boost::mutex > lock( state_mtx );
+    dropped_total += dropped;
+  }
+
+  vidtk_logger_mini_logger::write_text( text.str() );
+
+  return batch.size() + ( dropped != 0 ? 1 : 0 );
+}
+
+
+// ----------------------------------------------------------------
+/** Writer thread main loop.
+ *
+ *
+ */
+void
+mini_logger_async_writer::priv
+::run()
+{
+  while ( true )
+  {
+    unsigned long request;
+    bool stopping;
+
+    {
+      boost::lock_guard< boost::mutex > lock( state_mtx );
+      request = flush_requested;
+      stopping = stop;
+    }
+
+    const size_t written = drain();
+
+    boost::unique_lock< boost::mutex > lock( state_mtx );
+    flush_completed = request;
+    done.notify_all();
+
+    if ( written == 0 )
+    {
+      if ( stopping )
+      {
+        break;
+      }
+
+      if ( flush_requested == request && ! stop )
+      {
+        wake.timed_wait( lock, milliseconds( idle_wait_ms ) );
+      }
+    }
+  }
+
+  boost::lock_guard< boost::mutex > lock( state_mtx );
+  running = false;
+  done.notify_all();
+}
+
+
+// ----------------------------------------------------------------
+mini_logger_async_writer
+::mini_logger_async_writer( unsigned capacity )
+  : d( new priv( capacity ) )
+{
+  d->thread = boost::thread( boost::bind( &priv::run, d.get() ) );
+}
+
+
+mini_logger_async_writer
+::~mini_logger_async_writer()
+{
+}
+
+
+bool mini_logger_async_writer
+::push( mini_logger_record* rec )
+{
+  if ( ! d->accepting.load( boost::memory_order_acquire ) )
+  {
+    return false;
+  }
+
+  thread_buffer* buf = d->buffer_for_thread();
+
+  if ( ! buf->queue.push( rec ) )
+  {
+    // Never block the logging thread; count what is lost instead
+    buf->dropped.fetch_add( 1, boost::memory_order_relaxed );
+    delete rec;
+  }
+
+  return true;
+}
+
+
+void mini_logger_async_writer
+::flush()
+{
+  // Messages logged while formatting can not wait for themselves
+  if ( boost::this_thread::get_id() == d->thread.get_id() )
+  {
+    return;
+  }
+
+  boost::unique_lock< boost::mutex > lock( d->state_mtx );
+  const unsigned long target = ++d->flush_requested;
+  d->wake.notify_one();
+
+  while ( d->running && d->flush_completed < target )
+  {
+    d->done.wait( lock );
+  }
+}
+
+
+unsigned long mini_logger_async_writer
+::dropped_count() const
+{
+  boost::lock_guard< boost::mutex > lock( d->state_mtx );
+  return d->dropped_total;
+}
+
+
+void mini_logger_async_writer
+::shutdown()
+{
+  d->accepting.store( false, boost::memory_order_release );
+
+  {
+    boost::lock_guard< boost::mutex > lock( d->state_mtx );
+    d->stop = true;
+    d->wake.notify_one();
+  }
+
+  if ( d->thread.joinable() )
+  {
+    d->thread.join();
+  }
+
+  // Catch anything pushed while the writer was stopping
+  d->drain();
+}
+
+
+void mini_logger_async_writer
+::initialize()
+{
+  unsigned capacity = s_requested_capacity;
+
+  char const* env = std::getenv( "VIDTK_LOGGER_ASYNC" );
+  if ( env && std::atoi( env ) != 0 && capacity == 0 )
+  {
+    char const* cap = std::getenv( "VIDTK_LOGGER_ASYNC_CAPACITY" );
+    capacity = ( cap ? std::atoi( cap ) : 0 );
+    capacity = ( capacity > 0 ? capacity : default_capacity );
+  }
+
+  if ( capacity != 0 )
+  {
+    // Never deleted, so that it can be used while statics are destroyed
+    s_writer = new mini_logger_async_writer( capacity );
+    std::atexit( &shutdown_writer );
+  }
+}
+
+#else // VIDTK_MINI_LOGGER_ASYNC
+
+// ----------------------------------------------------------------
+// Messages are always written synchronously with older boost versions
+
+class mini_logger_async_writer::priv
+{
+};
+
+
+mini_logger_async_writer
+::mini_logger_async_writer( unsigned )
+{
+}
+
+
+mini_logger_async_writer
+::~mini_logger_async_writer()
+{
+}
+
+
+bool mini_logger_async_writer
+::push( mini_logger_record* )
+{
+  return false;
+}
+
+
+void mini_logger_async_writer
+::flush()
+{
+}
+
+
+unsigned long mini_logger_async_writer
+::dropped_count() const
+{
+  return 0;
+}
+
+
+void mini_logger_async_writer
+::shutdown()
+{
+}
+
+
+void mini_logger_async_writer
+::initialize()
+{
+  if ( s_requested_capacity != 0 || std::getenv( "VIDTK_LOGGER_ASYNC" ) )
+  {
+    std::cerr << "WARNING: Asynchronous logging requires boost 1.53 or later, "
+              << "messages are written synchronously\n";
+  }
+}
+
+#endif // VIDTK_MINI_LOGGER_ASYNC
+
+
+// ----------------------------------------------------------------
+mini_logger_async_writer*
+mini_logger_async_writer
+::instance()
+{
+  boost::call_once( &mini_logger_async_writer::initialize, s_init_flag );
+  return s_writer;
+}
+
+
+bool mini_logger_async_writer
+::enable( unsigned capacity )
+{
+  s_requested_capacity = ( capacity ? capacity : default_capacity );
+  return instance() != 0;
+}
+
+} // end namespace
+} // end namespace
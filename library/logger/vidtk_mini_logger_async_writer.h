@@ -0,0 +1,115 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+
+#ifndef _VIDTK_MINI_LOGGER_ASYNC_WRITER_H_
+#define _VIDTK_MINI_LOGGER_ASYNC_WRITER_H_
+
+#include <logger/vidtk_logger.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+
+namespace vidtk {
+namespace logger_ns {
+
+class vidtk_logger_mini_logger;
+
+// ----------------------------------------------------------------
+/** Log message waiting to be written.
+ *
+ * The message is formatted on the writer thread, so everything the
+ * formatter needs is copied into the record.
+ */
+struct mini_logger_record
+{
+  // The logger waits for its queued messages to be written before
+  // it is destroyed, so it and its formatter outlive the record.
+  vidtk_logger_mini_logger* logger;
+
+  vidtk_logger::log_level_t level;
+  std::string message;
+  boost::posix_time::ptime time;
+
+  // Location of the log statement, file and method names are literals
+  bool has_location;
+  char const* file_name;
+  char const* method_name;
+  int line_number;
+};
+
+
+// ----------------------------------------------------------------
+/** Background writer for the mini logger.
+ *
+ * Each logging thread queues its messages in its own bounded ring
+ * buffer, which is lock free when built with Boost 1.53 or later.
+ * A single writer thread drains all buffers, orders the messages by
+ * time, formats them with the logger's formatter (or the default
+ * format) and writes each batch to the output stream with one lock.
+ *
+ * When a thread's buffer is full, new messages from that thread are
+ * dropped rather than blocking it. Dropped messages are counted, and
+ * the writer reports how many were lost in the log itself.
+ *
+ * The writer is enabled by setting the VIDTK_LOGGER_ASYNC environment
+ * variable to a non-zero value, or by calling enable() before the
+ * first message is logged. VIDTK_LOGGER_ASYNC_CAPACITY optionally
+ * sets the number of messages each thread can queue.
+ */
+class mini_logger_async_writer
+{
+public:
+  /// Default number of messages each thread can queue.
+  static const unsigned default_capacity = 8192;
+
+  /** Get the writer, NULL if messages are written synchronously. */
+  static mini_logger_async_writer* instance();
+
+  /** Write messages asynchronously from now on.
+   *
+   * @param capacity Number of messages each thread can queue, 0 for
+   * the default.
+   * @return False if messages have already been logged synchronously
+   * or asynchronous output is not supported by this build.
+   */
+  static bool enable( unsigned capacity );
+
+  /** Queue a message to be written.
+   *
+   * The writer takes ownership of the record, which is deleted if
+   * the message is dropped.
+   * @return False if the writer is shutting down, in which case the
+   * caller keeps the record and should write it directly.
+   */
+  bool push( mini_logger_record* rec );
+
+  /** Wait until every message queued before this call is written. */
+  void flush();
+
+  /** Total number of messages dropped because a buffer was full. */
+  unsigned long dropped_count() const;
+
+  /** Write all queued messages and stop the writer thread. */
+  void shutdown();
+
+private:
+  explicit mini_logger_async_writer( unsigned capacity );
+  ~mini_logger_async_writer();
+
+  static void initialize();
+
+  class priv;
+  boost::scoped_ptr< priv > d;
+
+}; // end class mini_logger_async_writer
+
+} // end namespace
+} // end namespace
+
+#endif /* _VIDTK_MINI_LOGGER_ASYNC_WRITER_H_ */
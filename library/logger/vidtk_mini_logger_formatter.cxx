@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -271,7 +271,11 @@ std::string const& vidtk_mini_logger_formatter
 std::string vidtk_mini_logger_formatter
 ::get_time_stamp() const
 {
-  boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
+  boost::posix_time::ptime now = m_impl->m_time;
+  if ( now.is_not_a_date_time() )
+  {
+    now = boost::posix_time::microsec_clock::local_time();
+  }
 
   std::string time_stamp(boost::posix_time::to_simple_string( now ) );
   return time_stamp;
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010,2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010,2015-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -10,6 +10,8 @@
 
 #include <logger/vidtk_logger.h>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 
 namespace vidtk {
 namespace logger_ns {
@@ -40,6 +42,10 @@ public:
   std::string const* m_message;
   std::string const* m_realm;
 
+  // Time the message was logged, which may be well before it is
+  // formatted when output is asynchronous
+  boost::posix_time::ptime m_time;
+
 }; // end class formatter_impl
 
 
@@ -0,0 +1,10 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <object_detectors/osd_mask_cache.txx>
+
+template class vidtk::osd_mask_cache<vxl_byte>;
+template class vidtk::osd_mask_cache<vxl_uint_16>;
@@ -0,0 +1,14 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <object_detectors/pixel_feature_roi_process.txx>
+
+template class vidtk::pixel_feature_roi_pack_process< vxl_byte, vxl_byte >;
+template class vidtk::pixel_feature_roi_pack_process< vxl_uint_16, vxl_byte >;
+template class vidtk::pixel_feature_roi_pack_process< vxl_uint_16, vxl_uint_16 >;
+
+template class vidtk::pixel_feature_roi_unpack_process< vxl_byte >;
+template class vidtk::pixel_feature_roi_unpack_process< vxl_uint_16 >;
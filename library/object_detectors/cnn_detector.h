@@ -91,6 +91,21 @@ namespace vidtk
     0, \
     "Set a manual chip height, if the image width is a greater size than this " \
     "then the image will be processes in multiple subregions seperately." ); \
+  add_param( \
+    batch_size, \
+    unsigned, \
+    1, \
+    "Maximum number of chips to input to the CNN in a single forward pass. " \
+    "Chips from all subregions of an image, and from all images given to a " \
+    "single batch detection call, are grouped into batches of this size." ); \
+  add_param( \
+    thread_count, \
+    unsigned, \
+    1, \
+    "Number of CPU threads used for formatting CNN inputs, stitching output " \
+    "heatmaps and generating detections. If 0, the core budget of the " \
+    "shared compute pool is used. Threading within the CNN itself is controlled by the " \
+    "BLAS library caffe was built against." ); \
   add_array( \
     bbox_side_dims, \
     unsigned, 2, \
@@ -288,12 +303,32 @@ private:
 
   void gen_detections_box( const detection_map_t& map,
                            const detection_mask_t& mask,
-                           detection_vec_t& detections );
+                           detection_vec_t& detections,
+                           bool use_threads = false );
 
   void gen_detections_blob( const detection_map_t& map,
                             const detection_mask_t& mask,
                             detection_vec_t& detections );
 
+  // Helpers run over a range of indices, potentially on multiple threads
+  void fill_input_blob( unsigned batch_start, unsigned first, unsigned last );
+
+  void extract_responses( unsigned batch_start, unsigned first, unsigned last );
+
+  void stitch_maps( std::vector< detection_map_t >* maps,
+                    unsigned first, unsigned last );
+
+  void generate_detections( const std::vector< detection_map_t >* maps,
+                            std::vector< detection_mask_t >* masks,
+                            std::vector< detection_vec_t >* detections,
+                            bool use_threads,
+                            unsigned first, unsigned last );
+
+  void scan_detection_rows( const detection_map_t* map,
+                            const detection_mask_t* mask,
+                            std::vector< detection_vec_t >* bands,
+                            unsigned first, unsigned last );
+
 };
 
 } // end namespace vidtk
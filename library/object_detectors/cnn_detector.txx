@@ -22,10 +22,14 @@
 #include <vil/algo/vil_blob.h>
 
 #include <utilities/point_view_to_region.h>
+#include <utilities/compute_pool.h>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/function.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <algorithm>
 #include <map>
@@ -55,11 +59,24 @@ template< class PixType >
 class cnn_detector< PixType >::priv
 {
 public:
-  priv() {}
+  priv()
+  : thread_count_( 1 ),
+    batch_size_( 1 ),
+    input_data_( NULL ),
+    output_data_( NULL )
+  {}
   ~priv() {}
 
   typedef caffe::Net< cnn_float_t > detector_t;
   typedef boost::shared_ptr< detector_t > detector_sptr_t;
+  typedef boost::function< void ( unsigned, unsigned ) > range_function_t;
+
+  // A single chip input to the CNN, with the frames which form its planes
+  struct chip_t
+  {
+    std::vector< input_image_t > frames;
+    image_region region;
+  };
 
   // Internal frame counter
   unsigned frame_counter_;
@@ -92,6 +109,29 @@ public:
   // the full input image resolution?
   bool scaling_required_;
   bool cropping_required_;
+
+  // Threading and batching parameters
+  unsigned thread_count_;
+  unsigned batch_size_;
+
+  // State for the current batch detection call
+  unsigned ni_;
+  unsigned nj_;
+  unsigned nplanes_;
+  unsigned batch_chip_ni_;
+  unsigned batch_chip_nj_;
+  std::vector< image_region > regions_;
+  std::vector< chip_t > chips_;
+  std::vector< float_image_t > chip_responses_;
+  cnn_float_t* input_data_;
+  const cnn_float_t* output_data_;
+
+  // Split [0,count) into contiguous ranges, one per thread, which are
+  // run on the shared compute pool.
+  void run_ranges( const range_function_t& func, unsigned count ) const
+  {
+    compute_pool::instance()->parallel_for( 0, count, func, "cnn_detector", thread_count_ );
+  }
 };
 
 template< class PixType >
@@ -291,6 +331,11 @@ cnn_detector< PixType >
     d->averager_.reset();
   }
 
+  d->batch_size_ = std::max( 1u, settings.batch_size );
+
+  // Zero lets the compute pool use its full core budget
+  d->thread_count_ = settings.thread_count;
+
   d->frame_counter_ = 0;
   d->settings_ = settings;
   return true;
@@ -510,17 +555,21 @@ cnn_detector< PixType >
     regions.push_back( image_region( 0, ni, 0, nj ) );
   }
 
-  // Process all regions
-  std::vector< float_image_t > roi_resp;
+  d->ni_ = ni;
+  d->nj_ = nj;
+  d->nplanes_ = nplanes;
+  d->batch_chip_ni_ = chip_ni;
+  d->batch_chip_nj_ = chip_nj;
+  d->regions_ = regions;
 
-  LOG_DEBUG( "Converting vxl image(s) to caffe blob" );
-
-  Blob< cnn_float_t >* input_blob = d->cnn_->input_blobs()[0];
-
-  input_blob->Reshape( 1, planes_per_entry, chip_nj, chip_ni );
+  // Assemble all chips from all entries, so that they can be batched together
+  d->chips_.clear();
+  d->chips_.reserve( entry_count * regions.size() );
 
   for( unsigned e = buffered_only_entries; e < images.size(); ++e )
   {
+    typename priv::chip_t chip;
+
     if( buffering_enabled )
     {
       d->buffer_.insert( images[e] );
@@ -533,130 +582,205 @@ cnn_detector< PixType >
       {
         debug_output( d->buffer_.datum_at( d->settings_.detection_image_offset ), "input", e );
       }
+
+      for( unsigned j = 0; j < d->buffer_.size(); ++j )
+      {
+        const unsigned index = ( d->settings_.recent_frame_first ? j : d->buffer_.size() - j - 1 );
+        chip.frames.push_back( d->buffer_.datum_at( index ) );
+      }
     }
     else
     {
       debug_output( images[e], "input", e );
+
+      chip.frames.push_back( images[e] );
     }
 
     for( unsigned r = 0; r < regions.size(); ++r )
     {
-      cnn_float_t* entry_start = input_blob->mutable_cpu_data();
-      const image_region& region = regions[r];
+      chip.region = regions[r];
+      d->chips_.push_back( chip );
+    }
+  }
 
-      if( buffering_enabled )
-      {
-        for( unsigned j = 0; j < d->buffer_.size(); ++j )
-        {
-          const unsigned offset = chip_ni * chip_nj * nplanes * j;
-          const unsigned index = ( d->settings_.recent_frame_first ? j : d->buffer_.size() - j - 1 );
+  // Process all chips, up to the batch size at a time
+  const unsigned chip_count = d->chips_.size();
 
-          input_image_t image = d->buffer_.datum_at( index );
-          input_image_t roi = point_view_to_region( image, region );
+  d->chip_responses_.clear();
+  d->chip_responses_.resize( chip_count );
 
-          float_image_t tmp(
-            entry_start + offset,
-            chip_ni, chip_nj,
-            nplanes, 1, chip_ni,
-            chip_ni*chip_nj );
+  Blob< cnn_float_t >* input_blob = d->cnn_->input_blobs()[0];
 
-          copy_image_to_blob( roi, tmp );
-        }
-      }
-      else
-      {
-        input_image_t roi = point_view_to_region( images[e], region );
+  for( unsigned batch_start = 0; batch_start < chip_count; batch_start += d->batch_size_ )
+  {
+    const unsigned batch_count = std::min( d->batch_size_, chip_count - batch_start );
 
-        float_image_t tmp(
-          entry_start,
-          chip_ni, chip_nj,
-          nplanes, 1, chip_ni,
-          chip_ni*chip_nj );
+    LOG_DEBUG( "Converting " << batch_count << " vxl image chip(s) to caffe blob" );
 
-        copy_image_to_blob( roi, tmp );
-      }
+    input_blob->Reshape( batch_count, planes_per_entry, chip_nj, chip_ni );
 
-      // Run CNN on all inputs at once
-      LOG_DEBUG( "Running CNN on caffe blob" );
+    d->input_data_ = input_blob->mutable_cpu_data();
+    d->run_ranges( boost::bind( &cnn_detector< PixType >::fill_input_blob,
+                                this, batch_start, _1, _2 ), batch_count );
 
-      d->cnn_->ForwardPrefilled();
+    // Run CNN on all inputs at once
+    LOG_DEBUG( "Running CNN on caffe blob" );
 
-      // Retrieve descriptors from internal CNN layers
-      LOG_DEBUG( "Converting CNN output to vidtk format" );
+    d->cnn_->ForwardPrefilled();
 
-      Blob< cnn_float_t >* cnn_output = d->cnn_->output_blobs()[0];
+    // Retrieve descriptors from internal CNN layers
+    LOG_DEBUG( "Converting CNN output to vidtk format" );
 
-      for( int i = 0; i < cnn_output->num(); ++i )
-      {
-        // Create vil image view around output image
-        const cnn_float_t* start = cnn_output->cpu_data() + cnn_output->offset( i );
+    d->output_data_ = d->cnn_->output_blobs()[0]->cpu_data();
+    d->run_ranges( boost::bind( &cnn_detector< PixType >::extract_responses,
+                                this, batch_start, _1, _2 ), batch_count );
+  }
 
-        float_image_t wrapped_image( start,
-          cnn_output->width(), cnn_output->height(), cnn_output->channels(),
-          1, cnn_output->width(), cnn_output->width() * cnn_output->height() );
+  d->input_data_ = NULL;
+  d->output_data_ = NULL;
 
-        float_image_t desired_response;
+  // Format output maps, averaging must be performed in order
+  std::vector< detection_map_t > stitched_maps( entry_count );
 
-        if( d->settings_.target_channels.size() == 1 )
-        {
-          desired_response = vil_plane( wrapped_image, d->settings_.target_channels[0] );
+  d->run_ranges( boost::bind( &cnn_detector< PixType >::stitch_maps,
+                              this, &stitched_maps, _1, _2 ), entry_count );
 
-          if( d->settings_.output_option == cnn_detector_settings::PROB_DIFF &&
-              wrapped_image.nplanes() == 2 )
-          {
-            float_image_t copied_response;
-            vil_copy_deep( desired_response, copied_response );
-
-            if( d->settings_.target_channels[0] == 1 )
-            {
-              vil_math_add_image_fraction( copied_response, 1.0, vil_plane( wrapped_image, 0 ), -1.0 );
-            }
-            else
-            {
-              vil_math_add_image_fraction( copied_response, 1.0, vil_plane( wrapped_image, 1 ), -1.0 );
-            }
-
-            desired_response = copied_response;
-          }
-          else if( regions.size() > 1 )
-          {
-            // Copy since the wrapper around the caffe blob will be over-written
-            // the next time forward_prefill is called.
-            float_image_t copied_response;
-            vil_copy_deep( desired_response, copied_response );
+  d->chips_.clear();
+  d->chip_responses_.clear();
 
-            desired_response = copied_response;
-          }
+  for( unsigned m = 0; m < entry_count; ++m )
+  {
+    float_image_t& final_image = stitched_maps[m];
+
+    if( d->averager_ )
+    {
+      float_image_t average_plane = vil_plane( final_image, 0 );
+      d->averager_->process_frame( vil_plane( final_image, 1 ), average_plane );
+    }
+
+    debug_output( final_image, "net_map", m );
+    maps.push_back( final_image );
+  }
+}
+
+
+template< class PixType >
+void
+cnn_detector< PixType >
+::fill_input_blob( unsigned batch_start, unsigned first, unsigned last )
+{
+  const unsigned chip_ni = d->batch_chip_ni_;
+  const unsigned chip_nj = d->batch_chip_nj_;
+  const unsigned nplanes = d->nplanes_;
+  const unsigned entry_size = chip_ni * chip_nj * nplanes;
+
+  for( unsigned c = first; c < last; ++c )
+  {
+    const typename priv::chip_t& chip = d->chips_[ batch_start + c ];
+    cnn_float_t* entry_start = d->input_data_ + c * entry_size * chip.frames.size();
+
+    for( unsigned f = 0; f < chip.frames.size(); ++f )
+    {
+      input_image_t roi = point_view_to_region( chip.frames[f], chip.region );
+
+      float_image_t tmp(
+        entry_start + entry_size * f,
+        chip_ni, chip_nj,
+        nplanes, 1, chip_ni,
+        chip_ni*chip_nj );
+
+      copy_image_to_blob( roi, tmp );
+    }
+  }
+}
+
+
+template< class PixType >
+void
+cnn_detector< PixType >
+::extract_responses( unsigned batch_start, unsigned first, unsigned last )
+{
+  const Blob< cnn_float_t >* cnn_output = d->cnn_->output_blobs()[0];
+
+  // Responses which wrap the caffe blob must be copied if the blob will be
+  // over-written by another forward pass.
+  const bool copy_required = ( d->chips_.size() > 1 );
+
+  for( unsigned i = first; i < last; ++i )
+  {
+    // Create vil image view around output image
+    const cnn_float_t* start = d->output_data_ + cnn_output->offset( i );
+
+    float_image_t wrapped_image( start,
+      cnn_output->width(), cnn_output->height(), cnn_output->channels(),
+      1, cnn_output->width(), cnn_output->width() * cnn_output->height() );
+
+    float_image_t desired_response;
+
+    if( d->settings_.target_channels.size() == 1 )
+    {
+      desired_response = vil_plane( wrapped_image, d->settings_.target_channels[0] );
+
+      if( d->settings_.output_option == cnn_detector_settings::PROB_DIFF &&
+          wrapped_image.nplanes() == 2 )
+      {
+        float_image_t copied_response;
+        vil_copy_deep( desired_response, copied_response );
+
+        if( d->settings_.target_channels[0] == 1 )
+        {
+          vil_math_add_image_fraction( copied_response, 1.0, vil_plane( wrapped_image, 0 ), -1.0 );
         }
         else
         {
-          vil_math_image_max( vil_plane( wrapped_image, d->settings_.target_channels[0] ),
-                              vil_plane( wrapped_image, d->settings_.target_channels[1] ),
-                              desired_response );
-
-          for( unsigned j = 2; j < d->settings_.target_channels.size(); ++j )
-          {
-            vil_math_image_max( desired_response,
-                                vil_plane( wrapped_image, d->settings_.target_channels[j] ),
-                                desired_response );
-          }
+          vil_math_add_image_fraction( copied_response, 1.0, vil_plane( wrapped_image, 1 ), -1.0 );
         }
 
-        // Push back region map
-        roi_resp.push_back( desired_response );
+        desired_response = copied_response;
+      }
+      else if( copy_required )
+      {
+        float_image_t copied_response;
+        vil_copy_deep( desired_response, copied_response );
+
+        desired_response = copied_response;
+      }
+    }
+    else
+    {
+      vil_math_image_max( vil_plane( wrapped_image, d->settings_.target_channels[0] ),
+                          vil_plane( wrapped_image, d->settings_.target_channels[1] ),
+                          desired_response );
+
+      for( unsigned j = 2; j < d->settings_.target_channels.size(); ++j )
+      {
+        vil_math_image_max( desired_response,
+                            vil_plane( wrapped_image, d->settings_.target_channels[j] ),
+                            desired_response );
       }
     }
+
+    d->chip_responses_[ batch_start + i ] = desired_response;
   }
+}
 
-  // Formate output maps
-  for( unsigned m = 0; m < entry_count; ++m )
+
+template< class PixType >
+void
+cnn_detector< PixType >
+::stitch_maps( std::vector< detection_map_t >* maps,
+               unsigned first, unsigned last )
+{
+  const std::vector< image_region >& regions = d->regions_;
+
+  for( unsigned m = first; m < last; ++m )
   {
-    float_image_t final_image( ni, nj, ( d->averager_ ? 2 : 1 ) );
+    float_image_t final_image( d->ni_, d->nj_, ( d->averager_ ? 2 : 1 ) );
     vil_fill( final_image, -std::numeric_limits< cnn_float_t >::max() );
 
     for( unsigned r = 0; r < regions.size(); ++r )
     {
-      const float_image_t& region_resp = roi_resp[ m * regions.size() + r ];
+      const float_image_t& region_resp = d->chip_responses_[ m * regions.size() + r ];
       const image_region& region = regions[r];
 
       // Scale output region so that it matches the input size, if necessary
@@ -697,14 +821,7 @@ cnn_detector< PixType >
       }
     }
 
-    if( d->averager_ )
-    {
-      float_image_t average_plane = vil_plane( final_image, 0 );
-      d->averager_->process_frame( vil_plane( final_image, 1 ), average_plane );
-    }
-
-    debug_output( final_image, "net_map", m );
-    maps.push_back( final_image );
+    (*maps)[m] = final_image;
   }
 }
 
@@ -781,10 +898,57 @@ cnn_detector< PixType >
 
   batch_detect( images, maps );
 
+  // Threads are split across images when there are several, otherwise they
+  // are used within detection generation for the single image.
+  const bool thread_per_image = ( maps.size() > 1 );
+
+  d->run_ranges( boost::bind( &cnn_detector< PixType >::generate_detections,
+                              this, &maps, &masks, &detections,
+                              !thread_per_image, _1, _2 ),
+                 ( thread_per_image ? maps.size() : 1 ) );
+
   for( unsigned i = 0; i < maps.size(); ++i )
   {
-    const detection_map_t& detection_map = maps[i];
-    detection_mask_t& detection_mask = masks[i];
+    if( !maps[i] ||
+        d->settings_.detection_mode == cnn_detector_settings::DISABLED )
+    {
+      continue;
+    }
+
+    if( d->buffer_.size() > 1 )
+    {
+      if( d->settings_.detection_image_offset < 0 )
+      {
+        debug_output( d->buffer_.datum_at( ( d->buffer_.size() - 1 ) / 2 - i ),
+                      "detections", 0u, detections[i] );
+      }
+      else
+      {
+        debug_output( d->buffer_.datum_at( d->settings_.detection_image_offset ),
+                      "detections", 0u, detections[i] );
+      }
+    }
+    else
+    {
+      debug_output( images[i], "detections", 0u, detections[i] );
+    }
+  }
+}
+
+
+template< class PixType >
+void
+cnn_detector< PixType >
+::generate_detections( const std::vector< detection_map_t >* maps,
+                       std::vector< detection_mask_t >* masks,
+                       std::vector< detection_vec_t >* detections,
+                       bool use_threads,
+                       unsigned first, unsigned last )
+{
+  for( unsigned i = first; i < last && i < maps->size(); ++i )
+  {
+    const detection_map_t& detection_map = (*maps)[i];
+    detection_mask_t& detection_mask = (*masks)[i];
 
     if( !detection_map )
     {
@@ -811,29 +975,11 @@ cnn_detector< PixType >
     }
     else if( d->settings_.detection_mode == cnn_detector_settings::FIXED_SIZE )
     {
-      gen_detections_box( detection_map, detection_mask, detections[i] );
+      gen_detections_box( detection_map, detection_mask, (*detections)[i], use_threads );
     }
     else if( d->settings_.detection_mode == cnn_detector_settings::USE_BLOB )
     {
-      gen_detections_blob( detection_map, detection_mask, detections[i] );
-    }
-
-    if( d->buffer_.size() > 1 )
-    {
-      if( d->settings_.detection_image_offset < 0 )
-      {
-        debug_output( d->buffer_.datum_at( ( d->buffer_.size() - 1 ) / 2 - i ),
-                      "detections", 0u, detections[i] );
-      }
-      else
-      {
-        debug_output( d->buffer_.datum_at( d->settings_.detection_image_offset ),
-                      "detections", 0u, detections[i] );
-      }
-    }
-    else
-    {
-      debug_output( images[i], "detections", 0u, detections[i] );
+      gen_detections_blob( detection_map, detection_mask, (*detections)[i] );
     }
   }
 }
@@ -1137,51 +1283,35 @@ void
 cnn_detector< PixType >
 ::gen_detections_box( const detection_map_t& map,
                       const detection_mask_t& mask,
-                      detection_vec_t& detections )
+                      detection_vec_t& detections,
+                      bool use_threads )
 {
   LOG_DEBUG( "Generating detections via fixed method" );
 
   detection_vec_t unfiltered_detections;
 
-  const bool pixel_nms = ( d->settings_.nms_option == cnn_detector_settings::PIXEL_LEVEL ||
-                           d->settings_.nms_option == cnn_detector_settings::ALL );
   const bool box_nms = ( d->settings_.nms_option == cnn_detector_settings::BOX_LEVEL ||
                          d->settings_.nms_option == cnn_detector_settings::ALL );
 
-  const unsigned bbox_width = d->settings_.bbox_side_dims[0];
-  const unsigned bbox_height = d->settings_.bbox_side_dims[1];
-
-  unsigned ni = mask.ni(), nj = mask.nj(), np = mask.nplanes();
-  std::ptrdiff_t sistep = mask.istep(), sjstep = mask.jstep(), spstep = mask.planestep();
+  // Scan interior rows in bands, each band filling its own candidate list
+  // which are then joined in row order so results match a serial scan.
+  const unsigned row_count = ( mask.nj() > 2 ? mask.nj() - 2 : 0 );
+  std::vector< detection_vec_t > bands( row_count * mask.nplanes() );
 
-  const bool *splane = mask.top_left_ptr();
-  for( unsigned p = 0; p < np; ++p, splane += spstep )
+  if( use_threads )
   {
-    const bool *srow = splane;
-    for( unsigned j = 1; j < nj-1; ++j, srow += sjstep )
-    {
-      const bool *spixel = srow;
-      for( unsigned i = 1; i < ni-1; ++i, spixel+=sistep )
-      {
-        if( *spixel )
-        {
-          const cnn_float_t mag = map( i, j, p );
-
-          if( pixel_nms && ( map( i-1, j, p ) > mag || map( i+1, j, p ) > mag ||
-                             map( i, j-1, p ) > mag || map( i, j+1, p ) > mag ) )
-          {
-            continue;
-          }
+    d->run_ranges( boost::bind( &cnn_detector< PixType >::scan_detection_rows,
+                                this, &map, &mask, &bands, _1, _2 ), row_count );
+  }
+  else
+  {
+    scan_detection_rows( &map, &mask, &bands, 0, row_count );
+  }
 
-          unfiltered_detections.push_back(
-            std::make_pair(
-              vgl_box_2d< unsigned >(
-                ( i > bbox_width ? i - bbox_width : 0 ), i + bbox_width,
-                ( j > bbox_height ? j - bbox_height : 0 ), j + bbox_height ),
-              mag ) );
-        }
-      }
-    }
+  for( unsigned b = 0; b < bands.size(); ++b )
+  {
+    unfiltered_detections.insert( unfiltered_detections.end(),
+                                  bands[b].begin(), bands[b].end() );
   }
 
   if( box_nms )
@@ -1231,6 +1361,61 @@ cnn_detector< PixType >
 }
 
 
+template< class PixType >
+void
+cnn_detector< PixType >
+::scan_detection_rows( const detection_map_t* map,
+                       const detection_mask_t* mask,
+                       std::vector< detection_vec_t >* bands,
+                       unsigned first, unsigned last )
+{
+  const bool pixel_nms = ( d->settings_.nms_option == cnn_detector_settings::PIXEL_LEVEL ||
+                           d->settings_.nms_option == cnn_detector_settings::ALL );
+
+  const unsigned bbox_width = d->settings_.bbox_side_dims[0];
+  const unsigned bbox_height = d->settings_.bbox_side_dims[1];
+
+  const detection_map_t& scores = *map;
+
+  unsigned ni = mask->ni(), nj = mask->nj(), np = mask->nplanes();
+  std::ptrdiff_t sistep = mask->istep(), sjstep = mask->jstep(), spstep = mask->planestep();
+
+  const unsigned row_count = nj - 2;
+
+  const bool *splane = mask->top_left_ptr();
+  for( unsigned p = 0; p < np; ++p, splane += spstep )
+  {
+    const bool *srow = splane + ( first + 1 ) * sjstep;
+    for( unsigned j = first + 1; j < last + 1; ++j, srow += sjstep )
+    {
+      detection_vec_t& band = (*bands)[ p * row_count + j - 1 ];
+
+      const bool *spixel = srow + sistep;
+      for( unsigned i = 1; i < ni-1; ++i, spixel+=sistep )
+      {
+        if( *spixel )
+        {
+          const cnn_float_t mag = scores( i, j, p );
+
+          if( pixel_nms && ( scores( i-1, j, p ) > mag || scores( i+1, j, p ) > mag ||
+                             scores( i, j-1, p ) > mag || scores( i, j+1, p ) > mag ) )
+          {
+            continue;
+          }
+
+          band.push_back(
+            std::make_pair(
+              vgl_box_2d< unsigned >(
+                ( i > bbox_width ? i - bbox_width : 0 ), i + bbox_width,
+                ( j > bbox_height ? j - bbox_height : 0 ), j + bbox_height ),
+              mag ) );
+        }
+      }
+    }
+  }
+}
+
+
 template< class PixType >
 void
 cnn_detector< PixType >
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -13,6 +13,7 @@
 #include <utilities/ring_buffer.h>
 #include <utilities/timestamp.h>
 #include <utilities/homography.h>
+#include <utilities/homography_chain.h>
 
 #include <vil/vil_image_view.h>
 
@@ -38,7 +39,6 @@ public:
   typedef vgl_h_matrix_2d< double > homog_type;
   typedef ring_buffer< img_type > img_buffer_type;
   typedef ring_buffer< mask_type > mask_buffer_type;
-  typedef ring_buffer< homog_type > homog_buffer_type;
   typedef gui_frame_info::recommended_action gui_action_type;
 
   diff_buffer_process( std::string const& name );
@@ -62,7 +62,11 @@ public:
   void set_source_homog( vgl_h_matrix_2d<double> const& item );
   VIDTK_INPUT_PORT( set_source_homog, vgl_h_matrix_2d<double> const& );
 
-  /// Set the next homog item to be inserted into the buffer
+  /// \brief Set the next homog item to be inserted into the buffer.
+  ///
+  /// Unlike set_source_homog, the timestamps, validity and new reference
+  /// flag of the homography are kept, so frames across a shot break or
+  /// with an invalid homography are never differenced.
   void set_source_vidtk_homog( image_to_image_homography const& item );
   VIDTK_INPUT_PORT( set_source_vidtk_homog, image_to_image_homography const& );
 
@@ -114,6 +118,11 @@ public:
   virtual bool get_differencing_flag() const;
   VIDTK_OUTPUT_PORT( bool, get_differencing_flag );
 
+  /// Homographies of the buffered frames, which other nodes may query
+  /// for transforms between these frames instead of composing their own
+  virtual homography_chain_sptr get_homography_chain() const;
+  VIDTK_OUTPUT_PORT( homography_chain_sptr, get_homography_chain );
+
 protected:
 
   // Configuration
@@ -133,17 +142,16 @@ protected:
   // Internal Buffers
   img_buffer_type img_buffer_;
   mask_buffer_type mask_buffer_;
-  homog_buffer_type homog_buffer_;
+  homography_chain_sptr homog_chain_;
 
   // Inputs and Outputs
   vil_image_view<PixType> src_img_;
   vil_image_view<bool> src_mask_;
   vgl_h_matrix_2d<double> src_homog_;
+  image_to_image_homography src_vidtk_homog_;
+  bool src_is_vidtk_homog_;
   double input_gsd_;
 
-  vgl_h_matrix_2d<double> first_to_ref_;
-  vgl_h_matrix_2d<double> second_to_ref_;
-  vgl_h_matrix_2d<double> third_to_ref_;
   vgl_h_matrix_2d<double> third_to_first_;
   vgl_h_matrix_2d<double> third_to_second_;
   vgl_h_matrix_2d<double> first_to_third_;
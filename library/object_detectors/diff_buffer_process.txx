@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -33,6 +33,8 @@ diff_buffer_process<PixType>
     disable_capacity_error_( false ),
     reset_on_next_pass_( false ),
     check_shot_break_flags_( false ),
+    homog_chain_( new homography_chain ),
+    src_is_vidtk_homog_( false ),
     input_gsd_( 0 ),
     differencing_flag_( true ),
     requested_action_( gui_frame_info::PROCESS ),
@@ -120,7 +122,7 @@ diff_buffer_process<PixType>
     enable_min_overlap_ = min_overlap_ > 0.0001;
 
     img_buffer_.set_capacity( spacing_ + 1 );
-    homog_buffer_.set_capacity( spacing_ + 1 );
+    homog_chain_->set_capacity( spacing_ + 1 );
 
     if( masking_enabled_ )
     {
@@ -148,13 +150,10 @@ diff_buffer_process<PixType>
 {
   img_buffer_.clear();
   mask_buffer_.clear();
-  homog_buffer_.clear();
+  homog_chain_->clear();
 
   current_end_idx_ = 0;
 
-  first_to_ref_.set_identity();
-  second_to_ref_.set_identity();
-  third_to_ref_.set_identity();
   third_to_first_.set_identity();
   third_to_second_.set_identity();
   return true;
@@ -174,9 +173,10 @@ double
 diff_buffer_process<PixType>
 ::po_per_index( const unsigned index )
 {
-  first_to_ref_ = homog_buffer_.datum_at( index );
-  third_to_ref_ = homog_buffer_.datum_at( 0 );
-  first_to_third_ = third_to_ref_.get_inverse() * first_to_ref_;
+  if( !homog_chain_->transform_by_age( index, 0, first_to_third_ ) )
+  {
+    return 0.0;
+  }
 
   return percent_overlap( img_buffer_.datum_at(0).ni(),
                           img_buffer_.datum_at(0).nj(),
@@ -270,7 +270,17 @@ diff_buffer_process<PixType>
   }
 
   img_buffer_.insert( src_img_ );
-  homog_buffer_.insert( src_homog_ );
+
+  if( src_is_vidtk_homog_ && src_vidtk_homog_.get_source_reference().is_valid() )
+  {
+    homog_chain_->add( src_vidtk_homog_ );
+  }
+  else
+  {
+    homog_chain_->add( src_homog_ );
+  }
+
+  src_is_vidtk_homog_ = false;
 
   if( masking_enabled_ )
   {
@@ -283,9 +293,6 @@ diff_buffer_process<PixType>
   if( input_gsd_ < min_operating_gsd_ || input_gsd_ > max_operating_gsd_ )
   {
     current_end_idx_ = 0;
-    first_to_ref_.set_identity();
-    second_to_ref_.set_identity();
-    third_to_ref_.set_identity();
     third_to_first_.set_identity();
     third_to_second_.set_identity();
     differencing_flag_ = false;
@@ -346,11 +353,17 @@ diff_buffer_process<PixType>
     current_end_idx_ = min_allowed_;
   }
 
-  first_to_ref_ = homog_buffer_.datum_at( current_end_idx_ );
-  second_to_ref_ = homog_buffer_.datum_at( current_end_idx_ / 2 );
-  third_to_ref_ = homog_buffer_.datum_at( 0 );
-  third_to_first_ = first_to_ref_.get_inverse() * third_to_ref_;
-  third_to_second_ = second_to_ref_.get_inverse() * third_to_ref_;
+  // The frames are not related if they belong to different shots or one
+  // of their homographies is invalid, in which case nothing is differenced
+  if( !homog_chain_->transform_by_age( 0, current_end_idx_, third_to_first_ ) ||
+      !homog_chain_->transform_by_age( 0, current_end_idx_ / 2, third_to_second_ ) )
+  {
+    LOG_DEBUG( this->name() << ": Buffered frames are not related by a homography, "
+               "skipping differencing" );
+    third_to_first_.set_identity();
+    third_to_second_.set_identity();
+    differencing_flag_ = false;
+  }
 
   src_img_ = vil_image_view< PixType >();
   src_mask_ = vil_image_view< bool >();
@@ -365,7 +378,6 @@ diff_buffer_process<PixType>
   if( img_buffer_.size() > 1 )
   {
     img_type last_image = img_buffer_.datum_at( 0 );
-    homog_type last_homog = homog_buffer_.datum_at( 0 );
     mask_type last_mask;
 
     if( masking_enabled_ )
@@ -373,9 +385,15 @@ diff_buffer_process<PixType>
       last_mask = mask_buffer_.datum_at( 0 );
     }
 
-    initialize();
+    img_buffer_.clear();
+    mask_buffer_.clear();
+    homog_chain_->keep_newest();
+
+    current_end_idx_ = 0;
+    third_to_first_.set_identity();
+    third_to_second_.set_identity();
+
     img_buffer_.insert( last_image );
-    homog_buffer_.insert( last_homog );
 
     if( masking_enabled_ )
     {
@@ -429,6 +447,8 @@ diff_buffer_process<PixType>
 ::set_source_vidtk_homog( image_to_image_homography const& item )
 {
   src_homog_ = item.get_transform();
+  src_vidtk_homog_ = item;
+  src_is_vidtk_homog_ = true;
 }
 
 template <class PixType>
@@ -519,6 +539,14 @@ diff_buffer_process<PixType>
   return differencing_flag_;
 }
 
+template <class PixType>
+homography_chain_sptr
+diff_buffer_process<PixType>
+::get_homography_chain() const
+{
+  return homog_chain_;
+}
+
 bool does_intersect( const std::vector< vgl_point_2d<double> >& poly, const vgl_point_2d<double>& pt )
 {
   vgl_polygon<double> pol( &poly[0], poly.size() );
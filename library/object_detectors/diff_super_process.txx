@@ -391,6 +391,7 @@ public:
     default_config.add_parameter( proc_hash->name() + ":max_input_value", "255", "Default override" );
     default_config.add_parameter( proc_border->name() + ":side_dilation", "0", "Default override" );
     default_config.add_parameter( proc_border->name() + ":max_border_width", "50", "Default override" );
+    default_config.add_parameter( proc_border->name() + ":enable_tracking", "true", "Default override" );
 
     // Update config
     config.update( default_config );
@@ -585,8 +586,8 @@ public:
       // Connect cropped images/homographies to buffer and warp
       p->connect( proc_image_crop->cropped_image_port(),
                   proc_cropped_buffer->set_source_img_port() );
-      p->connect( proc_trans_for_cropping->bare_homography_port(),
-                  proc_cropped_buffer->set_source_homog_port() );
+      p->connect( proc_trans_for_cropping->homography_port(),
+                  proc_cropped_buffer->set_source_vidtk_homog_port() );
       p->connect( proc_cropped_buffer->get_first_image_port(),
                   proc_warp_1->set_source_image_port() );
       p->connect( proc_cropped_buffer->get_third_to_first_homog_port(),
@@ -1,13 +1,15 @@
 /*ckwg +5
- * Copyright 2010-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include <object_detectors/gmm_background_model_process.h>
+#include <object_detectors/planar_gmm_model.h>
 
 #include <vil/vil_transform.h>
 #include <vil/vil_convert.h>
+#include <vil/vil_plane.h>
 #include <vil/algo/vil_structuring_element.h>
 #include <vnl/vnl_double_3.h>
 
@@ -47,6 +49,7 @@ namespace
 
 struct gmm_params
 {
+  std::string model_type;
   std::string covar_mode;
   std::string update_algorithm;
   float init_variance;
@@ -61,6 +64,7 @@ struct gmm_params
   float match_radius;
   unsigned int num_pix_comp;
   vnl_double_3 invalid_color;
+  unsigned int num_threads;
 };
 
 template <class PixType>
@@ -211,6 +215,105 @@ private:
   boost::scoped_ptr<detector_type> detector_;
 };
 
+
+/// Adapter exposing the structure-of-arrays planar_gmm_model through
+/// the same interface as the bbgm based models.
+template <class PixType>
+class planar_gmm_model_adapter : public gmm_model_base<PixType>
+{
+public:
+  virtual void initilize( unsigned width, unsigned height, const gmm_params& p)
+  {
+    vidtk::planar_gmm_model_params mp;
+    mp.update_mode = ( p.update_algorithm == "SG" )
+                     ? vidtk::planar_gmm_model_params::UPDATE_SG
+                     : vidtk::planar_gmm_model_params::UPDATE_LM;
+    mp.covar_mode = ( p.covar_mode == "sphere" )
+                    ? vidtk::planar_gmm_model_params::COVAR_SPHERE
+                    : vidtk::planar_gmm_model_params::COVAR_INDEP;
+    mp.max_components = p.max_components;
+    mp.init_variance = p.init_variance;
+    mp.gaussian_match_thresh = p.gaussian_match_thresh;
+    mp.mininum_stdev = p.mininum_stdev;
+    mp.lm_window_size = p.lm_window_size;
+    mp.sg_learning_rate = p.sg_learning_rate;
+    mp.sg_init_weight = p.sg_init_weight;
+    mp.background_distance = p.background_distance;
+    mp.weight = p.weight;
+    mp.num_threads = p.num_threads;
+
+    model_.set_params( mp );
+    model_.initialize( width, height, 3 );
+  }
+
+  /// Clear the current background model
+  virtual void clear()
+  {
+    model_.clear();
+  }
+
+  /// Width of the background model image
+  virtual unsigned ni() const
+  {
+    return model_.ni();
+  }
+
+  /// Height of the background model image
+  virtual unsigned nj() const
+  {
+    return model_.nj();
+  }
+
+  virtual void bg_detect(const vil_image_view<PixType>& img,
+                      vil_image_view<bool>& bg_mask,
+                      const vil_structuring_element& se)
+  {
+    std::vector< std::pair<int,int> > offsets;
+    for( unsigned i = 0; i < se.p_i().size(); ++i )
+    {
+      offsets.push_back( std::make_pair( se.p_i()[i], se.p_j()[i] ) );
+    }
+
+    model_.detect( to_float( img ), bg_mask, offsets );
+  }
+
+  virtual void bg_update(const vil_image_view<PixType>& img)
+  {
+    model_.update( to_float( img ) );
+  }
+
+  virtual vil_image_view<PixType> bg_mean(const vnl_double_3& invalid_color) const
+  {
+    const float invalid[3] = { static_cast<float>( invalid_color[0] ),
+                               static_cast<float>( invalid_color[1] ),
+                               static_cast<float>( invalid_color[2] ) };
+
+    vil_image_view<float> float_image;
+    model_.background( float_image, invalid );
+
+    vil_image_view<PixType> img;
+    vil_convert_cast(float_image, img);
+
+    return img;
+  }
+
+private:
+  /// Convert to a three plane single-precision image, as the bbgm
+  /// models always operate on 3-vectors.
+  static vil_image_view<float> to_float( const vil_image_view<PixType>& img )
+  {
+    vil_image_view<float> float_image( img.ni(), img.nj(), 3 );
+    for( unsigned p = 0; p < 3; ++p )
+    {
+      vil_image_view<float> plane = vil_plane( float_image, p );
+      vil_convert_cast( vil_plane( img, std::min( p, img.nplanes() - 1 ) ), plane );
+    }
+    return float_image;
+  }
+
+  vidtk::planar_gmm_model model_;
+};
+
 } // end anonymous name space
 
 
@@ -255,6 +358,19 @@ gmm_background_model_process<PixType>
   : fg_image_process<PixType>( _name, "gmm_background_model_process" ),
     d(new priv)
 {
+  d->config_.add_parameter( "model_type", "bbgm",
+                            "Implementation of the per-pixel mixture model.  "
+                            "Takes one of the following string values: \n"
+                            "  bbgm -- One bbgm mixture object per pixel\n"
+                            "  planar -- Single-precision structure-of-arrays "
+                            "model with vectorized, row-parallel update and "
+                            "detection.  Supports the sphere and indep "
+                            "covar_modes.  Foreground masks match the bbgm "
+                            "model except for samples near the distance "
+                            "thresholds (see planar_gmm_model.h)\n");
+  d->config_.add_parameter( "num_threads", "1",
+                            "Number of threads used by the planar model.  "
+                            "Only used when model_type = planar" );
   d->config_.add_parameter( "covar_mode", "indep",
                             "Mode for modeling Gaussian covariance.  "
                             "Takes one of the following string values: \n"
@@ -319,6 +435,8 @@ gmm_background_model_process<PixType>
 {
   try
   {
+    d->params_.model_type = blk.get<std::string>( "model_type" );
+    d->params_.num_threads = blk.get<unsigned int>( "num_threads" );
     d->params_.covar_mode = blk.get<std::string>( "covar_mode" );
     d->params_.update_algorithm = blk.get<std::string>( "update_algorithm" );
     d->params_.init_variance = blk.get<float>( "initial_variance" );
@@ -348,7 +466,23 @@ gmm_background_model_process<PixType>
     return false;
   }
 
-  if( d->params_.covar_mode == "sphere" )
+  if( d->params_.model_type == "planar" )
+  {
+    if( d->params_.covar_mode != "sphere" && d->params_.covar_mode != "indep" )
+    {
+      LOG_ERROR( this->name() << ": covar_mode " << d->params_.covar_mode
+                 << " is not supported by the planar model" );
+      return false;
+    }
+    d->bg_model.reset( new planar_gmm_model_adapter<PixType>() );
+  }
+  else if( d->params_.model_type != "bbgm" )
+  {
+    LOG_ERROR( this->name() << ": unrecognized model_type: "
+               << d->params_.model_type );
+    return false;
+  }
+  else if( d->params_.covar_mode == "sphere" )
   {
     // use a spherical Gaussian with scalar variance
     typedef vpdt_gaussian< vnl_vector_fixed<float,3>, float > gauss_type;
@@ -58,6 +58,19 @@ public:
   void set_metadata_vector( vidtk::video_metadata::vector_t const& );
   VIDTK_INPUT_PORT( set_metadata_vector, vidtk::video_metadata::vector_t const& );
 
+  /// Optional shot break flags, used to invalidate the mask cache.
+  void set_shot_break_flags( vidtk::shot_break_flags const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_shot_break_flags, vidtk::shot_break_flags const& );
+
+  /// Optional processing quality tier, used to reduce detection frequency.
+  void set_quality_tier( unsigned );
+  VIDTK_OPTIONAL_INPUT_PORT( set_quality_tier, unsigned );
+
+  /// Optional native luma plane of the source image, used in place of a
+  /// greyscale conversion of the source image when supplied.
+  void set_source_luma_image( vil_image_view< PixType > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_source_luma_image, vil_image_view< PixType > const& );
+
   vil_image_view< PixType > image() const;
   VIDTK_OUTPUT_PORT( vil_image_view< PixType >, image );
 
@@ -27,6 +27,7 @@
 #include <object_detectors/osd_recognizer_process.h>
 #include <object_detectors/osd_mask_refinement_process.h>
 #include <object_detectors/metadata_text_parser_process.h>
+#include <object_detectors/osd_mask_cache.h>
 
 #ifdef USE_CAFFE
 #include <object_detectors/cnn_detector_process.h>
@@ -97,6 +98,7 @@ public:
   process_smart_pointer< image_pad > pad_source_image;
   process_smart_pointer< timestamp_pad > pad_source_timestamp;
   process_smart_pointer< metadata_pad > pad_source_metadata;
+  process_smart_pointer< image_pad > pad_source_luma_image;
 
   // Output pads (dummy processes)
   process_smart_pointer< image_pad > pad_output_image;
@@ -124,6 +126,18 @@ public:
   unsigned default_edge_capacity;
   unsigned refiner_edge_capacity;
 
+  // Reuse of detections across frames with an unchanged OSD
+  osd_mask_cache< PixType > mask_cache;
+  shot_break_flags input_shot_break_flags;
+
+  // Reduced detection frequency under high load
+  unsigned input_quality_tier;
+
+  // Native luma plane of the current frame, empty when not supplied
+  vil_image_view< PixType > input_luma_image;
+  unsigned reduced_detection_tier;
+  unsigned reduced_detection_interval;
+
   // Default constructor
   metadata_mask_super_process_impl()
   : proc_mask_reader( NULL ),
@@ -146,6 +160,7 @@ public:
     pad_source_image( NULL ),
     pad_source_timestamp( NULL ),
     pad_source_metadata( NULL ),
+    pad_source_luma_image( NULL ),
     pad_output_image( NULL ),
     pad_output_mask( NULL ),
     pad_output_mask_no_border( NULL ),
@@ -159,7 +174,10 @@ public:
     allow_template_matching( false ),
     use_border_in_osd_detection( true ),
     default_edge_capacity( 10 ),
-    refiner_edge_capacity( 10 )
+    refiner_edge_capacity( 10 ),
+    input_quality_tier( 0 ),
+    reduced_detection_tier( 0 ),
+    reduced_detection_interval( 5 )
   {
   }
 
@@ -169,6 +187,7 @@ public:
     pad_source_image = new image_pad( "source_image" );
     pad_source_timestamp = new timestamp_pad( "source_timestamp" );
     pad_source_metadata = new metadata_pad( "source_metadata" );
+    pad_source_luma_image = new image_pad( "source_luma_image" );
 
     pad_output_image = new image_pad( "output_image" );
     pad_output_mask = new mask_pad( "output_mask" );
@@ -253,11 +272,26 @@ public:
     default_config.add_parameter( proc_filter_writer->name() + ":skip_unset_images", "true", "Default override" );
     default_config.add_parameter( proc_mask_writer->name() + ":disabled", "true", "Default override" );
     default_config.add_parameter( proc_mask_writer->name() + ":pattern", "mask-%2$04d.png", "Default override" );
+    default_config.add_parameter( proc_border_det->name() + ":enable_tracking", "true", "Default override" );
+
+    config.add_subblock( osd_mask_cache_settings().config(), "mask_cache" );
 
     // Update actual config block.
     config.update( default_config );
   }
 
+  // Set all output pads from the mask cache, bypassing the pipeline.
+  void set_cached_outputs()
+  {
+    pad_output_image->set_value( pad_source_image->value() );
+    pad_output_timestamp->set_value( pad_source_timestamp->value() );
+    pad_output_metadata->set_value( pad_source_metadata->value() );
+    pad_output_mask->set_value( mask_cache.mask() );
+    pad_output_mask_no_border->set_value( mask_cache.borderless_mask() );
+    pad_output_border->set_value( mask_cache.border() );
+    pad_output_type->set_value( mask_cache.detected_type() );
+  }
+
   template < class Pipeline >
   void setup_pipeline( Pipeline * p )
   {
@@ -375,6 +409,7 @@ public:
     // Pixel classifier pipeline specific setup
     if( detection_mode == PIXEL_CLASS || detection_mode == CNN_CLASS )
     {
+      p->add( pad_source_luma_image );
       p->add( proc_greyscale );
       p->add( proc_border_det );
       p->add( proc_features );
@@ -401,6 +436,8 @@ public:
       // Connect RGB input image to required processes
       p->connect( pad_source_image->value_port(),
                   proc_greyscale->set_image_port() );
+      p->connect( pad_source_luma_image->value_port(),
+                  proc_greyscale->set_luma_image_port() );
       p->connect( pad_source_image->value_port(),
                   proc_features->set_source_color_image_port() );
       p->connect( pad_source_image->value_port(),
@@ -460,6 +497,8 @@ public:
                     proc_mask_detector->set_input_features_port() );
         p->connect( proc_features->var_image_port(),
                     proc_mask_detector->set_variance_image_port() );
+        p->connect( proc_features->roi_mask_port(),
+                    proc_mask_detector->set_roi_mask_port() );
       }
       p->connect( proc_features->feature_array_port(),
                   proc_mask_recognizer->set_input_features_port() );
@@ -510,6 +549,11 @@ public:
       p->connect( proc_mask_merge2->borderless_mask_port(),
                   pad_output_mask_no_border->set_value_port() );
 
+      // Features are computed around the OSD found on the prior frame when
+      // the feature extractor is restricted to regions of interest.
+      p->connect_without_dependency( proc_mask_merge2->borderless_mask_port(),
+                                     proc_features->set_roi_mask_port() );
+
       // Connect output border pad and output type pad
       p->set_edge_capacity( refiner_edge_capacity );
       p->connect( proc_border_det->border_port(),
@@ -682,6 +726,18 @@ metadata_mask_super_process<PixType>
     "i.e., should we look for OSD components in the entire image, or just in "
     "the area encapsulated by the image border." );
 
+  impl_->config.add_parameter( "reduced_detection_tier",
+    "0",
+    "If non-zero, on frames whose input quality tier is greater than or "
+    "equal to this value, the cached mask is reused without verification "
+    "and full detection only runs every reduced_detection_interval frames. "
+    "Requires mask_cache to be enabled." );
+
+  impl_->config.add_parameter( "reduced_detection_interval",
+    "5",
+    "Interval, in frames, between full detections when detection frequency "
+    "is reduced due to the quality tier." );
+
 }
 
 template < class PixType >
@@ -737,6 +793,43 @@ metadata_mask_super_process<PixType>
     impl_->refiner_edge_capacity = std::max( impl_->default_edge_capacity,
       std::max( refine_delay1, std::max( refine_delay2, refine_delay3 ) ) );
 
+    // The mask cache bypasses the internal pipeline on reused frames,
+    // which requires outputs to correspond to the current input.
+    osd_mask_cache_settings cache_settings( blk.subblock( "mask_cache" ) );
+
+    if( cache_settings.enabled )
+    {
+      if( impl_->detection_mode != impl_t::PIXEL_CLASS &&
+          impl_->detection_mode != impl_t::CNN_CLASS )
+      {
+        LOG_WARN( this->name() << ": mask_cache only applies to the classifier "
+                  "detection modes, disabling it" );
+        cache_settings.enabled = false;
+      }
+      else if( run_async )
+      {
+        throw config_block_parse_error( "mask_cache requires run_async to be false" );
+      }
+      else if( impl_->allow_text_parsing )
+      {
+        throw config_block_parse_error( "mask_cache cannot be used with text parsing" );
+      }
+    }
+
+    if( !impl_->mask_cache.configure( cache_settings ) )
+    {
+      throw config_block_parse_error( "Unable to configure mask cache" );
+    }
+
+    impl_->reduced_detection_tier = blk.get< unsigned >( "reduced_detection_tier" );
+    impl_->reduced_detection_interval = blk.get< unsigned >( "reduced_detection_interval" );
+
+    if( impl_->reduced_detection_tier > 0 && !cache_settings.enabled )
+    {
+      LOG_WARN( this->name() << ": reduced_detection_tier requires mask_cache, "
+                "detection will run on every frame" );
+    }
+
     impl_->config.update( blk );
 
     if( run_async )
@@ -786,6 +879,7 @@ bool
 metadata_mask_super_process<PixType>
 ::initialize()
 {
+  impl_->mask_cache.reset();
   return this->pipeline_->initialize();
 }
 
@@ -796,7 +890,52 @@ process::step_status
 metadata_mask_super_process<PixType>
 ::step2()
 {
-  return this->pipeline_->execute();
+  const bool shot_break = impl_->input_shot_break_flags.is_shot_end();
+  impl_->input_shot_break_flags = shot_break_flags();
+
+  const bool reduced_detection = impl_->reduced_detection_tier > 0 &&
+    impl_->input_quality_tier >= impl_->reduced_detection_tier;
+  impl_->input_quality_tier = 0;
+
+  // Only forward a luma plane for the frame it was supplied with
+  impl_->pad_source_luma_image->set_value( impl_->input_luma_image );
+  impl_->input_luma_image = vil_image_view< PixType >();
+
+  if( !impl_->mask_cache.enabled() )
+  {
+    return this->pipeline_->execute();
+  }
+
+  const vil_image_view< PixType > img = impl_->pad_source_image->value();
+
+  if( ( reduced_detection &&
+        impl_->mask_cache.reuse_within_interval(
+          img, shot_break, impl_->reduced_detection_interval ) ) ||
+      impl_->mask_cache.verify( img, shot_break ) )
+  {
+    impl_->set_cached_outputs();
+    return process::SUCCESS;
+  }
+
+  process::step_status status = this->pipeline_->execute();
+
+  if( status == process::SUCCESS )
+  {
+    impl_->mask_cache.store( img,
+                             impl_->pad_output_mask->value(),
+                             impl_->pad_output_mask_no_border->value(),
+                             impl_->pad_output_border->value(),
+                             impl_->pad_output_type->value() );
+
+    LOG_DEBUG( this->name() << ": mask reused on " << impl_->mask_cache.frames_reused()
+               << " frames, detected on " << impl_->mask_cache.frames_detected() );
+  }
+  else
+  {
+    impl_->mask_cache.reset();
+  }
+
+  return status;
 }
 
 
@@ -832,6 +971,30 @@ metadata_mask_super_process<PixType>
   impl_->pad_source_metadata->set_value( md );
 }
 
+template < class PixType >
+void
+metadata_mask_super_process<PixType>
+::set_shot_break_flags( vidtk::shot_break_flags const& sbf )
+{
+  impl_->input_shot_break_flags = sbf;
+}
+
+template < class PixType >
+void
+metadata_mask_super_process<PixType>
+::set_quality_tier( unsigned tier )
+{
+  impl_->input_quality_tier = tier;
+}
+
+template < class PixType >
+void
+metadata_mask_super_process<PixType>
+::set_source_luma_image( vil_image_view< PixType > const& img )
+{
+  impl_->input_luma_image = img;
+}
+
 template < class PixType >
 vil_image_view< PixType >
 metadata_mask_super_process<PixType>
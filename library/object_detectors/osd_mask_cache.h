@@ -0,0 +1,165 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_osd_mask_cache_h_
+#define vidtk_osd_mask_cache_h_
+
+#include <vil/vil_image_view.h>
+
+#include <tracking_data/image_border.h>
+
+#include <utilities/external_settings.h>
+
+#include <string>
+#include <vector>
+
+namespace vidtk
+{
+
+/// \brief Settings for the osd_mask_cache class.
+#define settings_macro( add_param ) \
+  add_param( \
+    enabled, \
+    bool, \
+    false, \
+    "Whether or not to reuse the last detected OSD mask on frames where " \
+    "the OSD is verified to be unchanged, instead of running the full " \
+    "detection chain." ); \
+  add_param( \
+    refresh_interval, \
+    unsigned, \
+    150, \
+    "Run the full detection chain at least once every this many frames, " \
+    "even when verification succeeds. This bounds how long a newly " \
+    "appearing OSD element outside of the cached mask can go undetected." ); \
+  add_param( \
+    sample_step, \
+    unsigned, \
+    4, \
+    "Spacing, in pixels, of the sampling grid used to verify the masked " \
+    "region against the frame the mask was computed on." ); \
+  add_param( \
+    min_sample_count, \
+    unsigned, \
+    32, \
+    "Minimum number of masked samples required to reuse a mask. Frames " \
+    "with smaller (or empty) masks always run full detection." ); \
+  add_param( \
+    intensity_tolerance, \
+    double, \
+    16.0, \
+    "Maximum per-channel absolute difference for a sample to be " \
+    "considered unchanged, absorbing compression noise." ); \
+  add_param( \
+    min_match_fraction, \
+    double, \
+    0.95, \
+    "Fraction of samples which must be unchanged to reuse the mask." ); \
+
+init_external_settings1( osd_mask_cache_settings, settings_macro )
+
+#undef settings_macro
+
+
+/// \brief Keeps the last OSD detection result and verifies whether it
+/// still applies to new frames.
+///
+/// On-screen displays are typically static for long stretches of video.
+/// After a full detection, the resulting mask is stored along with the
+/// values of a sparse grid of pixels under the mask. Subsequent frames
+/// are compared against those samples only; if nearly all of them are
+/// unchanged the stored result is reused. Verification fails, and the
+/// caller is expected to run full detection and call store() again, when
+/// the samples change, the frame size changes, a shot break is flagged,
+/// or refresh_interval frames have passed since the last full detection.
+template< typename PixType >
+class osd_mask_cache
+{
+public:
+
+  typedef vil_image_view< PixType > image_t;
+  typedef vil_image_view< bool > mask_t;
+
+  osd_mask_cache();
+  virtual ~osd_mask_cache() {}
+
+  /// Configure the cache with new settings, clearing any stored result.
+  bool configure( const osd_mask_cache_settings& options );
+
+  /// Is reuse enabled at all.
+  bool enabled() const { return options_.enabled; }
+
+  /// Discard the stored result.
+  void reset();
+
+  /// \brief Test if the stored result can be reused for \a img.
+  ///
+  /// This counts the frame as either reused or re-detected in the
+  /// internal statistics.
+  bool verify( const image_t& img, bool shot_break );
+
+  /// \brief Reuse the stored result for \a img without verification.
+  ///
+  /// Succeeds while fewer than \a interval frames have passed since the
+  /// last full detection and the frame is compatible with the stored
+  /// result. Only successful reuse is counted in the statistics, callers
+  /// are expected to fall back on verify() otherwise.
+  bool reuse_within_interval( const image_t& img, bool shot_break, unsigned interval );
+
+  /// Store the result of a full detection on \a img.
+  void store( const image_t& img,
+              const mask_t& mask,
+              const mask_t& borderless_mask,
+              const image_border& border,
+              const std::string& detected_type );
+
+  /// \name Stored detection results.
+  //@{
+  const mask_t& mask() const { return mask_; }
+  const mask_t& borderless_mask() const { return borderless_mask_; }
+  const image_border& border() const { return border_; }
+  const std::string& detected_type() const { return detected_type_; }
+  //@}
+
+  /// Number of frames for which the stored result was reused.
+  unsigned frames_reused() const { return frames_reused_; }
+
+  /// Number of frames which required full detection.
+  unsigned frames_detected() const { return frames_detected_; }
+
+private:
+
+  struct sample_t
+  {
+    unsigned i;
+    unsigned j;
+  };
+
+  osd_mask_cache_settings options_;
+
+  // Stored detection results
+  bool valid_;
+  mask_t mask_;
+  mask_t borderless_mask_;
+  image_border border_;
+  std::string detected_type_;
+
+  // Verification samples, values are stored plane-interleaved
+  unsigned ni_, nj_, np_;
+  std::vector< sample_t > samples_;
+  std::vector< double > sample_values_;
+
+  // Statistics
+  unsigned frames_since_detection_;
+  unsigned frames_reused_;
+  unsigned frames_detected_;
+};
+
+
+} // end namespace vidtk
+
+
+#endif // vidtk_osd_mask_cache_h_
@@ -0,0 +1,209 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "osd_mask_cache.h"
+
+#include <cmath>
+
+#include <logger/logger.h>
+
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "osd_mask_cache" );
+
+
+template< typename PixType >
+osd_mask_cache< PixType >
+::osd_mask_cache()
+  : valid_( false ),
+    ni_( 0 ),
+    nj_( 0 ),
+    np_( 0 ),
+    frames_since_detection_( 0 ),
+    frames_reused_( 0 ),
+    frames_detected_( 0 )
+{
+}
+
+
+template< typename PixType >
+bool
+osd_mask_cache< PixType >
+::configure( const osd_mask_cache_settings& options )
+{
+  if( options.sample_step == 0 )
+  {
+    LOG_ERROR( "Mask cache sample_step must be positive" );
+    return false;
+  }
+
+  if( options.min_match_fraction < 0.0 || options.min_match_fraction > 1.0 )
+  {
+    LOG_ERROR( "Mask cache min_match_fraction must be in [0,1]" );
+    return false;
+  }
+
+  options_ = options;
+  reset();
+  return true;
+}
+
+
+template< typename PixType >
+void
+osd_mask_cache< PixType >
+::reset()
+{
+  valid_ = false;
+  samples_.clear();
+  sample_values_.clear();
+  frames_since_detection_ = 0;
+}
+
+
+template< typename PixType >
+bool
+osd_mask_cache< PixType >
+::verify( const image_t& img, bool shot_break )
+{
+  bool reuse = options_.enabled &&
+               valid_ &&
+               !shot_break &&
+               frames_since_detection_ + 1 < options_.refresh_interval &&
+               img.ni() == ni_ &&
+               img.nj() == nj_ &&
+               img.nplanes() == np_;
+
+  if( reuse )
+  {
+    const double tolerance = options_.intensity_tolerance;
+    const unsigned allowed_failures = static_cast< unsigned >(
+      ( 1.0 - options_.min_match_fraction ) * samples_.size() );
+
+    unsigned failures = 0;
+    const double* ref = &sample_values_[0];
+
+    for( unsigned s = 0; s < samples_.size() && failures <= allowed_failures; ++s )
+    {
+      bool unchanged = true;
+
+      for( unsigned p = 0; p < np_; ++p, ++ref )
+      {
+        const double value = static_cast< double >( img( samples_[s].i, samples_[s].j, p ) );
+        unchanged = unchanged && std::fabs( value - *ref ) <= tolerance;
+      }
+
+      if( !unchanged )
+      {
+        ++failures;
+      }
+    }
+
+    reuse = ( failures <= allowed_failures );
+  }
+
+  if( reuse )
+  {
+    ++frames_since_detection_;
+    ++frames_reused_;
+  }
+  else
+  {
+    ++frames_detected_;
+  }
+
+  return reuse;
+}
+
+
+template< typename PixType >
+bool
+osd_mask_cache< PixType >
+::reuse_within_interval( const image_t& img, bool shot_break, unsigned interval )
+{
+  const bool reuse = options_.enabled &&
+                     valid_ &&
+                     !shot_break &&
+                     frames_since_detection_ + 1 < interval &&
+                     img.ni() == ni_ &&
+                     img.nj() == nj_ &&
+                     img.nplanes() == np_;
+
+  if( reuse )
+  {
+    ++frames_since_detection_;
+    ++frames_reused_;
+  }
+
+  return reuse;
+}
+
+
+template< typename PixType >
+void
+osd_mask_cache< PixType >
+::store( const image_t& img,
+         const mask_t& mask,
+         const mask_t& borderless_mask,
+         const image_border& border,
+         const std::string& detected_type )
+{
+  reset();
+
+  if( !options_.enabled || !mask || mask.ni() != img.ni() || mask.nj() != img.nj() )
+  {
+    return;
+  }
+
+  ni_ = img.ni();
+  nj_ = img.nj();
+  np_ = img.nplanes();
+
+  // Sample the masked region on a sparse grid
+  const unsigned step = options_.sample_step;
+
+  for( unsigned j = 0; j < nj_; j += step )
+  {
+    for( unsigned i = 0; i < ni_; i += step )
+    {
+      if( mask( i, j ) )
+      {
+        sample_t s;
+        s.i = i;
+        s.j = j;
+        samples_.push_back( s );
+
+        for( unsigned p = 0; p < np_; ++p )
+        {
+          sample_values_.push_back( static_cast< double >( img( i, j, p ) ) );
+        }
+      }
+    }
+  }
+
+  if( samples_.size() < options_.min_sample_count )
+  {
+    LOG_DEBUG( "Mask too small to verify cheaply, not caching" );
+    reset();
+    return;
+  }
+
+  // Deep copies so downstream consumers cannot alter the stored result
+  mask_.deep_copy( mask );
+  borderless_mask_ = mask_t();
+  if( borderless_mask )
+  {
+    borderless_mask_.deep_copy( borderless_mask );
+  }
+  border_ = border;
+  detected_type_ = detected_type;
+  valid_ = true;
+}
+
+
+} // end namespace vidtk
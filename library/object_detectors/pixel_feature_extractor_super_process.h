@@ -18,6 +18,7 @@
 #include <utilities/timestamp.h>
 #include <utilities/video_metadata.h>
 #include <utilities/homography.h>
+#include <utilities/point_view_to_region.h>
 
 #include <vector>
 
@@ -33,6 +34,11 @@ class pixel_feature_extractor_super_process_impl;
 /// for each individual pixel in the image describing local image structure,
 /// temporal variance, and other features. The output is a vector array
 /// of images of type OutputType, with each image corresponding to some feature.
+///
+/// Optionally, features can be computed only within a sparse set of regions
+/// of interest (see the "roi" sub-block), in which case the regions are
+/// packed together before filtering and the roi_mask output reports which
+/// pixels hold valid features.
 template< class InputType, class OutputType >
 class pixel_feature_extractor_super_process
   : public super_process
@@ -69,12 +75,27 @@ public:
   void set_auxiliary_features( feature_array_t const& );
   VIDTK_INPUT_PORT( set_auxiliary_features, feature_array_t const& );
 
+  /// Regions of interest to compute features in, if ROI mode is enabled.
+  void set_roi_regions( std::vector< image_region > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_regions, std::vector< image_region > const& );
+
+  /// A mask (e.g. the prior frame's OSD mask) whose set pixels should be
+  /// treated as regions of interest, if ROI mode is enabled.
+  void set_roi_mask( vil_image_view< bool > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_mask, vil_image_view< bool > const& );
+
   feature_array_t feature_array() const;
   VIDTK_OUTPUT_PORT( feature_array_t, feature_array );
 
   vil_image_view< double > var_image() const;
   VIDTK_OUTPUT_PORT( vil_image_view< double >, var_image );
 
+  /// Pixels for which features were computed when ROI mode is enabled,
+  /// otherwise an empty image. Features outside of this mask should be
+  /// treated as not computed.
+  vil_image_view< bool > roi_mask() const;
+  VIDTK_OUTPUT_PORT( vil_image_view< bool >, roi_mask );
+
 private:
 
   pixel_feature_extractor_super_process_impl<InputType, OutputType> * impl_;
@@ -27,6 +27,7 @@
 #include <video_transforms/kmeans_segmentation_process.h>
 
 #include <object_detectors/blob_pixel_feature_extraction_process.h>
+#include <object_detectors/pixel_feature_roi_process.h>
 
 #include <logger/logger.h>
 
@@ -56,6 +57,8 @@ public:
   typedef vidtk::super_process_pad_impl< double > gsd_pad;
   typedef vidtk::super_process_pad_impl< vil_image_view< double > > var_image_pad;
   typedef vidtk::super_process_pad_impl< image_border > border_pad;
+  typedef vidtk::super_process_pad_impl< std::vector< image_region > > regions_pad;
+  typedef vidtk::super_process_pad_impl< vil_image_view< bool > > mask_pad;
 
   // Pipeline Processes
   process_smart_pointer< frame_averaging_process< OutputType > > proc_avg;
@@ -72,6 +75,8 @@ public:
   process_smart_pointer< video_enhancement_process< OutputType > > proc_enhance;
   process_smart_pointer< image_consolidator_process< OutputType > > proc_merge;
   process_smart_pointer< floating_point_image_hash_process< double, OutputType > > proc_hash1;
+  process_smart_pointer< pixel_feature_roi_pack_process< InputType, OutputType > > proc_roi_pack;
+  process_smart_pointer< pixel_feature_roi_unpack_process< OutputType > > proc_roi_unpack;
 
   // Input Pads (dummy processes)
   process_smart_pointer< image_pad > pad_source_color_image;
@@ -81,15 +86,27 @@ public:
   process_smart_pointer< gsd_pad > pad_source_gsd;
   process_smart_pointer< feature_array_pad > pad_source_features;
 
+  // Input Pads used in place of the above when ROI packing is enabled
+  process_smart_pointer< image_pad > pad_roi_color_image;
+  process_smart_pointer< image_pad > pad_roi_grey_image;
+  process_smart_pointer< border_pad > pad_roi_border;
+  process_smart_pointer< feature_array_pad > pad_roi_features;
+  process_smart_pointer< regions_pad > pad_roi_regions;
+  process_smart_pointer< mask_pad > pad_roi_mask;
+
   // Output Pads (dummy processes)
   process_smart_pointer< feature_array_pad > pad_output_features;
   process_smart_pointer< var_image_pad > pad_output_var_image;
+  process_smart_pointer< feature_array_pad > pad_roi_output_features;
+  process_smart_pointer< var_image_pad > pad_roi_output_var_image;
+  process_smart_pointer< mask_pad > pad_roi_output_mask;
 
   // Configuration Parameters
   config_block config;
   config_block default_config;
   bool disabled;
   bool single_channel_only;
+  bool roi_enabled;
 
   // An ordered array of which features should be enabled. Note: this array
   // has a one to one correspondance of all toggleable features and is in
@@ -118,16 +135,28 @@ public:
     proc_enhance( NULL ),
     proc_merge( NULL ),
     proc_hash1( NULL ),
+    proc_roi_pack( NULL ),
+    proc_roi_unpack( NULL ),
     pad_source_color_image( NULL ),
     pad_source_grey_image( NULL ),
     pad_source_timestamp( NULL ),
     pad_source_border( NULL ),
     pad_source_gsd( NULL ),
     pad_source_features( NULL ),
+    pad_roi_color_image( NULL ),
+    pad_roi_grey_image( NULL ),
+    pad_roi_border( NULL ),
+    pad_roi_features( NULL ),
+    pad_roi_regions( NULL ),
+    pad_roi_mask( NULL ),
     pad_output_features( NULL ),
     pad_output_var_image( NULL ),
+    pad_roi_output_features( NULL ),
+    pad_roi_output_var_image( NULL ),
+    pad_roi_output_mask( NULL ),
     disabled( false ),
     single_channel_only( false ),
+    roi_enabled( false ),
     color_pad_required( false ),
     grey_pad_required( false ),
     gsd_pad_required( false ),
@@ -148,6 +177,17 @@ public:
     pad_output_features = new feature_array_pad( "output_array" );
     pad_output_var_image = new var_image_pad( "output_var_image" );
 
+    pad_roi_color_image = new image_pad( "roi_source_rgb_image" );
+    pad_roi_grey_image = new image_pad( "roi_source_grey_image" );
+    pad_roi_border = new border_pad( "roi_source_border" );
+    pad_roi_features = new feature_array_pad( "roi_source_array" );
+    pad_roi_regions = new regions_pad( "roi_source_regions" );
+    pad_roi_mask = new mask_pad( "roi_source_mask" );
+
+    pad_roi_output_features = new feature_array_pad( "roi_output_array" );
+    pad_roi_output_var_image = new var_image_pad( "roi_output_var_image" );
+    pad_roi_output_mask = new mask_pad( "roi_output_mask" );
+
 
     proc_avg = new frame_averaging_process< OutputType >( "averager" );
     config.add_subblock( proc_avg->params(),
@@ -205,6 +245,12 @@ public:
     config.add_subblock( proc_hash1->params(),
                          proc_hash1->name() );
 
+    proc_roi_pack = new pixel_feature_roi_pack_process< InputType, OutputType >( "roi" );
+    config.add_subblock( proc_roi_pack->params(),
+                         proc_roi_pack->name() );
+
+    proc_roi_unpack = new pixel_feature_roi_unpack_process< OutputType >( "roi_unpacker" );
+
     // Over-riding the process default with this super-process defaults.
     default_config.add_parameter( proc_avg->name() + ":type", "window", "Default override" );
     default_config.add_parameter( proc_avg->name() + ":window_size", "25", "Default override" );
@@ -276,6 +322,11 @@ public:
       return;
     }
 
+    if( roi_enabled )
+    {
+      setup_roi_nodes( p );
+    }
+
     // A pointer to the port assumed to contain the color image, if one is
     // available. If it is not, fallback to the grayscale image.
     image_pad* color_image_source;
@@ -374,6 +425,13 @@ public:
                   proc_avg->set_source_image_port() );
       p->connect( proc_avg->variance_image_port(),
                   proc_hash1->set_input_image_port() );
+
+      // Atlas pixels hold different scene content after a layout change
+      if( roi_enabled )
+      {
+        p->connect( proc_roi_pack->layout_changed_port(),
+                    proc_avg->set_reset_flag_port() );
+      }
       p->connect( proc_hash1->hashed_image_port(),
                   proc_merge->set_image_9_port() );
       p->connect( proc_avg->variance_image_port(),
@@ -411,6 +469,75 @@ public:
                   proc_merge->set_image_12_port() );
     }
   }
+
+  // Place the ROI packer between the external inputs and the regular input
+  // pads, and the unpacker after the regular output pads, so that all
+  // feature filters only ever see packed atlas images.
+  template <class PIPELINE>
+  void setup_roi_nodes( PIPELINE * p )
+  {
+    p->add( pad_roi_border );
+    p->add( pad_roi_features );
+    p->add( pad_roi_regions );
+    p->add( pad_roi_mask );
+    p->add( proc_roi_pack );
+    p->add( proc_roi_unpack );
+    p->add( pad_roi_output_features );
+    p->add( pad_roi_output_mask );
+
+    if( grey_pad_required )
+    {
+      p->add( pad_roi_grey_image );
+
+      p->connect( pad_roi_grey_image->value_port(),
+                  proc_roi_pack->set_source_grey_image_port() );
+      p->connect( proc_roi_pack->grey_image_port(),
+                  pad_source_grey_image->set_value_port() );
+    }
+
+    if( color_pad_required )
+    {
+      p->add( pad_roi_color_image );
+
+      p->connect( pad_roi_color_image->value_port(),
+                  proc_roi_pack->set_source_color_image_port() );
+      p->connect( proc_roi_pack->color_image_port(),
+                  pad_source_color_image->set_value_port() );
+    }
+
+    p->connect( pad_roi_border->value_port(),
+                proc_roi_pack->set_border_port() );
+    p->connect( pad_roi_features->value_port(),
+                proc_roi_pack->set_auxiliary_features_port() );
+    p->connect( pad_roi_regions->value_port(),
+                proc_roi_pack->set_roi_regions_port() );
+    p->connect( pad_roi_mask->value_port(),
+                proc_roi_pack->set_roi_mask_port() );
+
+    p->connect( proc_roi_pack->border_port(),
+                pad_source_border->set_value_port() );
+    p->connect( proc_roi_pack->auxiliary_features_port(),
+                pad_source_features->set_value_port() );
+
+    p->connect( proc_roi_pack->layout_port(),
+                proc_roi_unpack->set_layout_port() );
+    p->connect( pad_output_features->value_port(),
+                proc_roi_unpack->set_feature_array_port() );
+    p->connect( proc_roi_unpack->feature_array_port(),
+                pad_roi_output_features->set_value_port() );
+    p->connect( proc_roi_unpack->roi_mask_port(),
+                pad_roi_output_mask->set_value_port() );
+
+    if( feature_enable_flags[8] )
+    {
+      p->add( pad_roi_output_var_image );
+
+      p->connect( pad_output_var_image->value_port(),
+                  proc_roi_unpack->set_var_image_port() );
+      p->connect( proc_roi_unpack->var_image_port(),
+                  pad_roi_output_var_image->set_value_port() );
+    }
+  }
 };
 
 template < class InputType, class OutputType >
@@ -563,6 +690,10 @@ pixel_feature_extractor_super_process<InputType,OutputType>
     // If there are no features to extract or the flag is set, disable process
     impl_->disabled = ( feature_code == 0 || blk.get<bool>( "disabled" ) );
 
+    // Only compute features within regions of interest, if enabled
+    impl_->roi_enabled = !impl_->disabled &&
+      blk.subblock( impl_->proc_roi_pack->name() ).get<bool>( "enabled" );
+
     if( !impl_->disabled )
     {
       impl_->color_pad_required = ( feature_code & 0x083D ) != 0;
@@ -634,7 +765,14 @@ void
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::set_source_color_image( vil_image_view< InputType > const& img )
 {
-  impl_->pad_source_color_image->set_value( img );
+  if( impl_->roi_enabled )
+  {
+    impl_->pad_roi_color_image->set_value( img );
+  }
+  else
+  {
+    impl_->pad_source_color_image->set_value( img );
+  }
 }
 
 template < class InputType, class OutputType >
@@ -650,7 +788,14 @@ void
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::set_source_grey_image( vil_image_view< InputType > const& img )
 {
-  impl_->pad_source_grey_image->set_value( img );
+  if( impl_->roi_enabled )
+  {
+    impl_->pad_roi_grey_image->set_value( img );
+  }
+  else
+  {
+    impl_->pad_source_grey_image->set_value( img );
+  }
 }
 
 template< class InputType, class OutputType>
@@ -666,7 +811,14 @@ void
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::set_border( image_border const& border )
 {
-  impl_->pad_source_border->set_value( border );
+  if( impl_->roi_enabled )
+  {
+    impl_->pad_roi_border->set_value( border );
+  }
+  else
+  {
+    impl_->pad_source_border->set_value( border );
+  }
 }
 
 template < class InputType, class OutputType >
@@ -674,7 +826,30 @@ void
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::set_auxiliary_features( feature_array_t const& features )
 {
-  impl_->pad_source_features->set_value( features );
+  if( impl_->roi_enabled )
+  {
+    impl_->pad_roi_features->set_value( features );
+  }
+  else
+  {
+    impl_->pad_source_features->set_value( features );
+  }
+}
+
+template < class InputType, class OutputType >
+void
+pixel_feature_extractor_super_process<InputType,OutputType>
+::set_roi_regions( std::vector< image_region > const& regions )
+{
+  impl_->pad_roi_regions->set_value( regions );
+}
+
+template < class InputType, class OutputType >
+void
+pixel_feature_extractor_super_process<InputType,OutputType>
+::set_roi_mask( vil_image_view< bool > const& mask )
+{
+  impl_->pad_roi_mask->set_value( mask );
 }
 
 template < class InputType, class OutputType >
@@ -682,6 +857,11 @@ std::vector< vil_image_view< OutputType > >
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::feature_array() const
 {
+  if( impl_->roi_enabled )
+  {
+    return impl_->pad_roi_output_features->value();
+  }
+
   return impl_->pad_output_features->value();
 }
 
@@ -690,8 +870,26 @@ vil_image_view< double >
 pixel_feature_extractor_super_process<InputType,OutputType>
 ::var_image() const
 {
+  if( impl_->roi_enabled )
+  {
+    return impl_->pad_roi_output_var_image->value();
+  }
+
   return impl_->pad_output_var_image->value();
 }
 
+template < class InputType, class OutputType >
+vil_image_view< bool >
+pixel_feature_extractor_super_process<InputType,OutputType>
+::roi_mask() const
+{
+  if( impl_->roi_enabled )
+  {
+    return impl_->pad_roi_output_mask->value();
+  }
+
+  return vil_image_view< bool >();
+}
+
 
 } // end namespace vidtk
@@ -0,0 +1,386 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "pixel_feature_roi.h"
+
+#include <object_detectors/osd_template.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <logger/logger.h>
+
+namespace vidtk
+{
+
+
+VIDTK_LOGGER( "pixel_feature_roi_cxx" );
+
+
+namespace
+{
+
+// Expand a region by some amount in every direction, clipped to the frame
+image_region
+dilate_region( const image_region& r, unsigned amount, unsigned ni, unsigned nj )
+{
+  return image_region( ( r.min_x() > amount ? r.min_x() - amount : 0 ),
+                       std::min( r.max_x() + amount, ni ),
+                       ( r.min_y() > amount ? r.min_y() - amount : 0 ),
+                       std::min( r.max_y() + amount, nj ) );
+}
+
+// Do two regions overlap or touch
+bool
+regions_touch( const image_region& a, const image_region& b )
+{
+  return a.min_x() <= b.max_x() && b.min_x() <= a.max_x() &&
+         a.min_y() <= b.max_y() && b.min_y() <= a.max_y();
+}
+
+// Sort packed regions by decreasing height for shelf packing
+struct taller_region
+{
+  const std::vector< image_region >* regions;
+
+  bool operator()( unsigned a, unsigned b ) const
+  {
+    const unsigned ha = (*regions)[a].height();
+    const unsigned hb = (*regions)[b].height();
+    return ( ha != hb ? ha > hb : a < b );
+  }
+};
+
+} // end anonymous namespace
+
+
+pixel_feature_roi_layout
+::pixel_feature_roi_layout()
+  : identity_( true ),
+    ni_( 0 ),
+    nj_( 0 ),
+    atlas_ni_( 0 ),
+    atlas_nj_( 0 )
+{
+}
+
+
+void
+pixel_feature_roi_layout
+::compute( unsigned ni,
+           unsigned nj,
+           const std::vector< image_region >& rois,
+           unsigned dilation,
+           double max_area_fraction )
+{
+  ni_ = ni;
+  nj_ = nj;
+  identity_ = true;
+  atlas_ni_ = ni;
+  atlas_nj_ = nj;
+  core_.clear();
+  packed_.clear();
+  atlas_.clear();
+
+  // Clip input regions to the frame, dilate, then merge any which touch
+  // so that no frame pixel is packed twice.
+  for( unsigned r = 0; r < rois.size(); ++r )
+  {
+    image_region clipped( rois[r].min_x(), std::min( rois[r].max_x(), ni ),
+                          rois[r].min_y(), std::min( rois[r].max_y(), nj ) );
+
+    if( clipped.is_empty() || clipped.volume() == 0 )
+    {
+      continue;
+    }
+
+    core_.push_back( clipped );
+    packed_.push_back( dilate_region( clipped, dilation, ni, nj ) );
+  }
+
+  bool merged = true;
+
+  while( merged )
+  {
+    merged = false;
+
+    for( unsigned a = 0; a < packed_.size() && !merged; ++a )
+    {
+      for( unsigned b = a + 1; b < packed_.size() && !merged; ++b )
+      {
+        if( regions_touch( packed_[a], packed_[b] ) )
+        {
+          packed_[a].add( packed_[b] );
+          packed_.erase( packed_.begin() + b );
+          merged = true;
+        }
+      }
+    }
+  }
+
+  double packed_area = 0.0;
+  unsigned max_width = 0;
+
+  for( unsigned r = 0; r < packed_.size(); ++r )
+  {
+    packed_area += packed_[r].volume();
+    max_width = std::max( max_width, packed_[r].width() );
+  }
+
+  if( packed_.empty() || packed_area > max_area_fraction * ni * nj )
+  {
+    core_.clear();
+    packed_.clear();
+    return;
+  }
+
+  // Shelf pack the regions, tallest first, into an atlas roughly as wide
+  // as it is tall.
+  const unsigned shelf_width =
+    std::max( max_width, static_cast< unsigned >( std::ceil( std::sqrt( packed_area ) ) ) );
+
+  std::vector< unsigned > order( packed_.size() );
+  for( unsigned r = 0; r < order.size(); ++r )
+  {
+    order[r] = r;
+  }
+
+  taller_region cmp;
+  cmp.regions = &packed_;
+  std::sort( order.begin(), order.end(), cmp );
+
+  atlas_.resize( packed_.size() );
+  atlas_ni_ = 0;
+  atlas_nj_ = 0;
+
+  unsigned shelf_x = 0, shelf_y = 0, shelf_height = 0;
+
+  for( unsigned k = 0; k < order.size(); ++k )
+  {
+    const image_region& r = packed_[ order[k] ];
+
+    if( shelf_x + r.width() > shelf_width )
+    {
+      shelf_y += shelf_height;
+      shelf_x = 0;
+      shelf_height = 0;
+    }
+
+    atlas_[ order[k] ] = image_region( shelf_x, shelf_x + r.width(),
+                                       shelf_y, shelf_y + r.height() );
+
+    shelf_x += r.width();
+    shelf_height = std::max( shelf_height, r.height() );
+    atlas_ni_ = std::max( atlas_ni_, shelf_x );
+  }
+
+  atlas_nj_ = shelf_y + shelf_height;
+  identity_ = false;
+}
+
+
+void
+pixel_feature_roi_layout
+::fill_mask( vil_image_view< bool >& mask ) const
+{
+  mask = vil_image_view< bool >( ni_, nj_ );
+
+  if( identity_ )
+  {
+    mask.fill( true );
+    return;
+  }
+
+  mask.fill( false );
+
+  for( unsigned r = 0; r < core_.size(); ++r )
+  {
+    for( unsigned j = core_[r].min_y(); j < core_[r].max_y(); ++j )
+    {
+      for( unsigned i = core_[r].min_x(); i < core_[r].max_x(); ++i )
+      {
+        mask( i, j ) = true;
+      }
+    }
+  }
+}
+
+
+bool
+pixel_feature_roi_layout
+::operator==( const pixel_feature_roi_layout& other ) const
+{
+  return identity_ == other.identity_ &&
+         ni_ == other.ni_ &&
+         nj_ == other.nj_ &&
+         packed_ == other.packed_ &&
+         atlas_ == other.atlas_;
+}
+
+
+bool
+parse_normalized_regions( const std::string& str,
+                          std::vector< vgl_box_2d< double > >& regions )
+{
+  std::vector< std::string > rects;
+  boost::split( rects, str, boost::is_any_of( ";" ) );
+
+  for( unsigned r = 0; r < rects.size(); ++r )
+  {
+    std::string rect = boost::trim_copy( rects[r] );
+
+    if( rect.empty() )
+    {
+      continue;
+    }
+
+    std::vector< std::string > values;
+    boost::split( values, rect, boost::is_any_of( " ,\t" ), boost::token_compress_on );
+
+    if( values.size() != 4 )
+    {
+      LOG_ERROR( "Invalid region specification: " << rect );
+      return false;
+    }
+
+    try
+    {
+      regions.push_back( vgl_box_2d< double >( boost::lexical_cast< double >( values[0] ),
+                                               boost::lexical_cast< double >( values[2] ),
+                                               boost::lexical_cast< double >( values[1] ),
+                                               boost::lexical_cast< double >( values[3] ) ) );
+    }
+    catch( const boost::bad_lexical_cast& )
+    {
+      LOG_ERROR( "Invalid region specification: " << rect );
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool
+load_template_regions( const std::string& filename,
+                       std::vector< vgl_box_2d< double > >& regions )
+{
+  std::vector< osd_template > templates;
+
+  if( !read_templates_file( filename, templates ) )
+  {
+    LOG_ERROR( "Unable to read template file: " << filename );
+    return false;
+  }
+
+  for( unsigned t = 0; t < templates.size(); ++t )
+  {
+    const std::vector< osd_symbol >& symbols = templates[t].get_symbols();
+    const std::vector< osd_action_item >& actions = templates[t].get_actions();
+
+    for( unsigned s = 0; s < symbols.size(); ++s )
+    {
+      if( symbols[s].region_.volume() > 0 )
+      {
+        regions.push_back( symbols[s].region_ );
+      }
+    }
+
+    for( unsigned a = 0; a < actions.size(); ++a )
+    {
+      if( actions[a].rect_.volume() > 0 )
+      {
+        regions.push_back( actions[a].rect_ );
+      }
+    }
+  }
+
+  return true;
+}
+
+
+void
+scale_normalized_regions( const std::vector< vgl_box_2d< double > >& input,
+                          unsigned ni,
+                          unsigned nj,
+                          std::vector< image_region >& output )
+{
+  for( unsigned r = 0; r < input.size(); ++r )
+  {
+    const double x0 = std::max( 0.0, std::min( 1.0, input[r].min_x() ) );
+    const double x1 = std::max( 0.0, std::min( 1.0, input[r].max_x() ) );
+    const double y0 = std::max( 0.0, std::min( 1.0, input[r].min_y() ) );
+    const double y1 = std::max( 0.0, std::min( 1.0, input[r].max_y() ) );
+
+    output.push_back( image_region( static_cast< unsigned >( std::floor( x0 * ni ) ),
+                                    static_cast< unsigned >( std::ceil( x1 * ni ) ),
+                                    static_cast< unsigned >( std::floor( y0 * nj ) ),
+                                    static_cast< unsigned >( std::ceil( y1 * nj ) ) ) );
+  }
+}
+
+
+void
+add_border_band_regions( unsigned ni,
+                         unsigned nj,
+                         double fraction,
+                         std::vector< image_region >& output )
+{
+  if( fraction <= 0.0 )
+  {
+    return;
+  }
+
+  const unsigned bi = std::min( ni, static_cast< unsigned >( std::ceil( fraction * ni ) ) );
+  const unsigned bj = std::min( nj, static_cast< unsigned >( std::ceil( fraction * nj ) ) );
+
+  output.push_back( image_region( 0, ni, 0, bj ) );
+  output.push_back( image_region( 0, ni, nj - bj, nj ) );
+  output.push_back( image_region( 0, bi, 0, nj ) );
+  output.push_back( image_region( ni - bi, ni, 0, nj ) );
+}
+
+
+void
+add_mask_regions( const vil_image_view< bool >& mask,
+                  unsigned cell_size,
+                  std::vector< image_region >& output )
+{
+  if( !mask || cell_size == 0 )
+  {
+    return;
+  }
+
+  for( unsigned cj = 0; cj < mask.nj(); cj += cell_size )
+  {
+    const unsigned ej = std::min( cj + cell_size, mask.nj() );
+
+    for( unsigned ci = 0; ci < mask.ni(); ci += cell_size )
+    {
+      const unsigned ei = std::min( ci + cell_size, mask.ni() );
+      bool found = false;
+
+      for( unsigned j = cj; j < ej && !found; ++j )
+      {
+        for( unsigned i = ci; i < ei && !found; ++i )
+        {
+          found = mask( i, j );
+        }
+      }
+
+      if( found )
+      {
+        output.push_back( image_region( ci, ei, cj, ej ) );
+      }
+    }
+  }
+}
+
+
+} // end namespace vidtk
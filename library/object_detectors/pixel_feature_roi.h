@@ -0,0 +1,226 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_pixel_feature_roi_h_
+#define vidtk_pixel_feature_roi_h_
+
+#include <vil/vil_image_view.h>
+#include <vil/vil_crop.h>
+#include <vil/vil_copy.h>
+#include <vgl/vgl_box_2d.h>
+
+#include <utilities/external_settings.h>
+#include <utilities/point_view_to_region.h>
+
+#include <string>
+#include <vector>
+
+namespace vidtk
+{
+
+/// \brief Settings for restricting pixel feature extraction to regions of
+/// interest (ROIs) likely to contain on-screen displays.
+#define settings_macro( add_param ) \
+  add_param( \
+    enabled, \
+    bool, \
+    false, \
+    "Whether or not to compute pixel features only inside of a sparse set " \
+    "of regions of interest, as opposed to over the entire frame." ); \
+  add_param( \
+    border_band_fraction, \
+    double, \
+    0.0, \
+    "If positive, add a band of this width, as a fraction of the frame " \
+    "dimension, along each of the four frame edges to the ROI set." ); \
+  add_param( \
+    regions, \
+    std::string, \
+    "", \
+    "Additional static regions, specified as a list of normalized " \
+    "rectangles (min_x min_y max_x max_y) in the [0,1] range, with " \
+    "individual rectangles seperated by semicolons." ); \
+  add_param( \
+    template_filename, \
+    std::string, \
+    "", \
+    "If set, add the expected symbol and action regions from all OSD " \
+    "templates in this template list file to the ROI set." ); \
+  add_param( \
+    mask_cell_size, \
+    unsigned, \
+    32, \
+    "Cell size, in pixels, used when converting an input mask (such as the " \
+    "mask from the prior frame) into a set of regions." ); \
+  add_param( \
+    dilation, \
+    unsigned, \
+    32, \
+    "Amount, in pixels, to dilate each ROI by before computing features. " \
+    "This should be at least half the size of the largest filter kernel, " \
+    "otherwise features near ROI edges will differ from full frame values." ); \
+  add_param( \
+    max_area_fraction, \
+    double, \
+    0.6, \
+    "If the dilated ROIs cover more than this fraction of the frame, " \
+    "features are computed over the entire frame instead." ); \
+
+init_external_settings1( pixel_feature_roi_settings, settings_macro )
+
+#undef settings_macro
+
+
+/// \brief Describes how a sparse set of image regions are packed together
+/// into a single smaller image.
+///
+/// Regions of interest are dilated, clipped to the frame, merged when they
+/// overlap, and then packed into shelves of an "atlas" image. Filters can
+/// then be run over the atlas instead of the full frame and their outputs
+/// scattered back into the frame. When there are no regions, or they cover
+/// too large a portion of the frame, the layout is the identity and the
+/// atlas is the frame itself.
+class pixel_feature_roi_layout
+{
+public:
+
+  pixel_feature_roi_layout();
+  virtual ~pixel_feature_roi_layout() {}
+
+  /// Compute a new layout for a frame of the given size.
+  void compute( unsigned ni,
+                unsigned nj,
+                const std::vector< image_region >& rois,
+                unsigned dilation,
+                double max_area_fraction );
+
+  /// Does this layout map every frame pixel to the atlas unchanged?
+  bool is_identity() const { return identity_; }
+
+  /// Frame dimensions.
+  unsigned ni() const { return ni_; }
+  unsigned nj() const { return nj_; }
+
+  /// Atlas dimensions.
+  unsigned atlas_ni() const { return atlas_ni_; }
+  unsigned atlas_nj() const { return atlas_nj_; }
+
+  /// Dilated and merged frame regions which are packed into the atlas.
+  const std::vector< image_region >& packed_regions() const { return packed_; }
+
+  /// Upper left atlas location of each packed region.
+  const std::vector< image_region >& atlas_regions() const { return atlas_; }
+
+  /// Fill a frame-sized mask which is true for pixels inside the original
+  /// (undilated) ROIs, or everywhere for identity layouts.
+  void fill_mask( vil_image_view< bool >& mask ) const;
+
+  /// Test if two layouts would pack images identically.
+  bool operator==( const pixel_feature_roi_layout& other ) const;
+  bool operator!=( const pixel_feature_roi_layout& other ) const
+  {
+    return !( *this == other );
+  }
+
+private:
+
+  bool identity_;
+  unsigned ni_, nj_;
+  unsigned atlas_ni_, atlas_nj_;
+  std::vector< image_region > core_;
+  std::vector< image_region > packed_;
+  std::vector< image_region > atlas_;
+};
+
+
+/// Parse a string of normalized rectangles as given by the regions setting.
+bool parse_normalized_regions( const std::string& str,
+                               std::vector< vgl_box_2d< double > >& regions );
+
+/// Load all symbol and action regions from an OSD template list file.
+bool load_template_regions( const std::string& filename,
+                            std::vector< vgl_box_2d< double > >& regions );
+
+/// Convert normalized rectangles to pixel regions for a given frame size.
+void scale_normalized_regions( const std::vector< vgl_box_2d< double > >& input,
+                               unsigned ni,
+                               unsigned nj,
+                               std::vector< image_region >& output );
+
+/// Add bands of the given relative width along each frame edge.
+void add_border_band_regions( unsigned ni,
+                              unsigned nj,
+                              double fraction,
+                              std::vector< image_region >& output );
+
+/// Add one region for every cell of size cell_size containing a set pixel.
+void add_mask_regions( const vil_image_view< bool >& mask,
+                       unsigned cell_size,
+                       std::vector< image_region >& output );
+
+
+/// Copy all packed regions of a frame-sized image into an atlas image.
+///
+/// For identity layouts the output is a shallow copy of the input.
+template< typename PixType >
+void pack_roi_image( const pixel_feature_roi_layout& layout,
+                     const vil_image_view< PixType >& src,
+                     vil_image_view< PixType >& dst )
+{
+  if( layout.is_identity() || !src )
+  {
+    dst = src;
+    return;
+  }
+
+  dst = vil_image_view< PixType >( layout.atlas_ni(), layout.atlas_nj(), src.nplanes() );
+  dst.fill( PixType( 0 ) );
+
+  for( unsigned r = 0; r < layout.packed_regions().size(); ++r )
+  {
+    const image_region& from = layout.packed_regions()[r];
+    const image_region& to = layout.atlas_regions()[r];
+
+    vil_copy_to_window( vil_crop( src, from.min_x(), from.width(), from.min_y(), from.height() ),
+                        dst, to.min_x(), to.min_y() );
+  }
+}
+
+
+/// Scatter the packed regions of an atlas image back into a frame-sized
+/// image, setting all pixels outside of them to fill_value.
+///
+/// For identity layouts the output is a shallow copy of the input.
+template< typename PixType >
+void unpack_roi_image( const pixel_feature_roi_layout& layout,
+                       const vil_image_view< PixType >& src,
+                       vil_image_view< PixType >& dst,
+                       const PixType fill_value = PixType( 0 ) )
+{
+  if( layout.is_identity() || !src )
+  {
+    dst = src;
+    return;
+  }
+
+  dst = vil_image_view< PixType >( layout.ni(), layout.nj(), src.nplanes() );
+  dst.fill( fill_value );
+
+  for( unsigned r = 0; r < layout.packed_regions().size(); ++r )
+  {
+    const image_region& from = layout.atlas_regions()[r];
+    const image_region& to = layout.packed_regions()[r];
+
+    vil_copy_to_window( vil_crop( src, from.min_x(), from.width(), from.min_y(), from.height() ),
+                        dst, to.min_x(), to.min_y() );
+  }
+}
+
+
+} // end namespace vidtk
+
+
+#endif // vidtk_pixel_feature_roi_h_
@@ -0,0 +1,181 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_pixel_feature_roi_process_h_
+#define vidtk_pixel_feature_roi_process_h_
+
+#include <process_framework/process.h>
+#include <process_framework/pipeline_aid.h>
+
+#include <object_detectors/pixel_feature_roi.h>
+
+#include <tracking_data/image_border.h>
+
+#include <vil/vil_image_view.h>
+
+#include <vector>
+
+namespace vidtk
+{
+
+
+/// \brief Packs the regions of interest of all input images into smaller
+/// atlas images, so that pixel features only need to be computed there.
+///
+/// ROIs are the union of statically configured regions (border bands,
+/// normalized rectangles and OSD template regions), any regions given on
+/// the optional ROI input port, and the cells of an optional input mask,
+/// typically the OSD mask produced for the prior frame. The computed
+/// layout is passed alongside the packed images so that the matching
+/// pixel_feature_roi_unpack_process can restore frame coordinates.
+///
+/// Any change in layout, such as when dynamic regions change, moves scene
+/// content to different atlas pixels even when the atlas size is unchanged.
+/// The layout_changed output is set on such frames, and should be used to
+/// reset any temporal filters operating on the packed images.
+template< class InputType, class OutputType >
+class pixel_feature_roi_pack_process
+  : public process
+{
+public:
+
+  typedef pixel_feature_roi_pack_process self_type;
+  typedef std::vector< vil_image_view< OutputType > > feature_array_t;
+
+  pixel_feature_roi_pack_process( std::string const& name );
+  virtual ~pixel_feature_roi_pack_process() {}
+
+  virtual config_block params() const;
+  virtual bool set_params( config_block const& );
+  virtual bool initialize();
+  virtual bool step();
+
+  void set_source_color_image( vil_image_view< InputType > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_source_color_image, vil_image_view< InputType > const& );
+
+  void set_source_grey_image( vil_image_view< InputType > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_source_grey_image, vil_image_view< InputType > const& );
+
+  void set_border( image_border const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_border, image_border const& );
+
+  void set_auxiliary_features( feature_array_t const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_auxiliary_features, feature_array_t const& );
+
+  /// Additional regions of interest for the current frame.
+  void set_roi_regions( std::vector< image_region > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_regions, std::vector< image_region > const& );
+
+  /// A mask whose set pixels should be treated as regions of interest.
+  void set_roi_mask( vil_image_view< bool > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_mask, vil_image_view< bool > const& );
+
+  vil_image_view< InputType > color_image() const;
+  VIDTK_OUTPUT_PORT( vil_image_view< InputType >, color_image );
+
+  vil_image_view< InputType > grey_image() const;
+  VIDTK_OUTPUT_PORT( vil_image_view< InputType >, grey_image );
+
+  image_border border() const;
+  VIDTK_OUTPUT_PORT( image_border, border );
+
+  feature_array_t auxiliary_features() const;
+  VIDTK_OUTPUT_PORT( feature_array_t, auxiliary_features );
+
+  pixel_feature_roi_layout layout() const;
+  VIDTK_OUTPUT_PORT( pixel_feature_roi_layout, layout );
+
+  /// True if the layout differs from the one used for the prior frame.
+  bool layout_changed() const;
+  VIDTK_OUTPUT_PORT( bool, layout_changed );
+
+private:
+
+  config_block config_;
+  pixel_feature_roi_settings settings_;
+
+  // Static regions in normalized coordinates
+  std::vector< vgl_box_2d< double > > static_regions_;
+
+  // Inputs
+  vil_image_view< InputType > input_color_;
+  vil_image_view< InputType > input_grey_;
+  image_border input_border_;
+  feature_array_t input_features_;
+  std::vector< image_region > input_regions_;
+  vil_image_view< bool > input_mask_;
+
+  // Outputs
+  vil_image_view< InputType > output_color_;
+  vil_image_view< InputType > output_grey_;
+  image_border output_border_;
+  feature_array_t output_features_;
+  pixel_feature_roi_layout layout_;
+  bool layout_changed_;
+
+  void reset_inputs();
+};
+
+
+/// \brief Scatters features computed over atlas images, as produced by
+/// pixel_feature_roi_pack_process, back into full frame images.
+///
+/// Pixels outside of all packed regions are set to zero and are not
+/// computed. The ROI mask output marks which pixels fall within the
+/// original (undilated) regions, and therefore hold valid features.
+template< class OutputType >
+class pixel_feature_roi_unpack_process
+  : public process
+{
+public:
+
+  typedef pixel_feature_roi_unpack_process self_type;
+  typedef std::vector< vil_image_view< OutputType > > feature_array_t;
+
+  pixel_feature_roi_unpack_process( std::string const& name );
+  virtual ~pixel_feature_roi_unpack_process() {}
+
+  virtual config_block params() const;
+  virtual bool set_params( config_block const& );
+  virtual bool initialize();
+  virtual bool step();
+
+  void set_layout( pixel_feature_roi_layout const& );
+  VIDTK_INPUT_PORT( set_layout, pixel_feature_roi_layout const& );
+
+  void set_feature_array( feature_array_t const& );
+  VIDTK_INPUT_PORT( set_feature_array, feature_array_t const& );
+
+  void set_var_image( vil_image_view< double > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_var_image, vil_image_view< double > const& );
+
+  feature_array_t feature_array() const;
+  VIDTK_OUTPUT_PORT( feature_array_t, feature_array );
+
+  vil_image_view< double > var_image() const;
+  VIDTK_OUTPUT_PORT( vil_image_view< double >, var_image );
+
+  vil_image_view< bool > roi_mask() const;
+  VIDTK_OUTPUT_PORT( vil_image_view< bool >, roi_mask );
+
+private:
+
+  // Inputs
+  pixel_feature_roi_layout input_layout_;
+  feature_array_t input_features_;
+  vil_image_view< double > input_var_;
+
+  // Outputs
+  feature_array_t output_features_;
+  vil_image_view< double > output_var_;
+  vil_image_view< bool > output_mask_;
+};
+
+
+} // end namespace vidtk
+
+
+#endif // vidtk_pixel_feature_roi_process_h_
@@ -0,0 +1,397 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "pixel_feature_roi_process.h"
+
+#include <logger/logger.h>
+
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "pixel_feature_roi_process" );
+
+
+// ----------------------------------------------------------------
+template< class InputType, class OutputType >
+pixel_feature_roi_pack_process< InputType, OutputType >
+::pixel_feature_roi_pack_process( std::string const& _name )
+  : process( _name, "pixel_feature_roi_pack_process" ),
+    layout_changed_( false )
+{
+  config_ = settings_.config();
+}
+
+
+template< class InputType, class OutputType >
+config_block
+pixel_feature_roi_pack_process< InputType, OutputType >
+::params() const
+{
+  return config_;
+}
+
+
+template< class InputType, class OutputType >
+bool
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_params( config_block const& blk )
+{
+  try
+  {
+    settings_.read_config( blk );
+
+    if( settings_.max_area_fraction <= 0.0 )
+    {
+      throw config_block_parse_error( "max_area_fraction must be positive" );
+    }
+
+    static_regions_.clear();
+
+    if( !parse_normalized_regions( settings_.regions, static_regions_ ) )
+    {
+      throw config_block_parse_error( "Unable to parse regions" );
+    }
+
+    if( !settings_.template_filename.empty() &&
+        !load_template_regions( settings_.template_filename, static_regions_ ) )
+    {
+      throw config_block_parse_error( "Unable to load template regions" );
+    }
+  }
+  catch( const config_block_parse_error& e )
+  {
+    LOG_ERROR( this->name() << ": couldn't set parameters: " << e.what() );
+    return false;
+  }
+
+  config_.update( blk );
+  return true;
+}
+
+
+template< class InputType, class OutputType >
+bool
+pixel_feature_roi_pack_process< InputType, OutputType >
+::initialize()
+{
+  layout_ = pixel_feature_roi_layout();
+  layout_changed_ = false;
+  this->reset_inputs();
+  return true;
+}
+
+
+template< class InputType, class OutputType >
+bool
+pixel_feature_roi_pack_process< InputType, OutputType >
+::step()
+{
+  unsigned ni = 0, nj = 0;
+
+  if( input_grey_ )
+  {
+    ni = input_grey_.ni();
+    nj = input_grey_.nj();
+  }
+  else if( input_color_ )
+  {
+    ni = input_color_.ni();
+    nj = input_color_.nj();
+  }
+  else if( !input_features_.empty() )
+  {
+    ni = input_features_[0].ni();
+    nj = input_features_[0].nj();
+  }
+
+  // Assemble all regions of interest for this frame
+  std::vector< image_region > rois;
+
+  if( settings_.enabled && ni > 0 && nj > 0 )
+  {
+    scale_normalized_regions( static_regions_, ni, nj, rois );
+    add_border_band_regions( ni, nj, settings_.border_band_fraction, rois );
+    add_mask_regions( input_mask_, settings_.mask_cell_size, rois );
+    rois.insert( rois.end(), input_regions_.begin(), input_regions_.end() );
+  }
+
+  pixel_feature_roi_layout new_layout;
+  new_layout.compute( ni, nj, rois, settings_.dilation, settings_.max_area_fraction );
+
+  layout_changed_ = ( new_layout != layout_ );
+
+  if( layout_changed_ )
+  {
+    LOG_DEBUG( this->name() << ": ROI layout changed, computing features over "
+               << new_layout.atlas_ni() << "x" << new_layout.atlas_nj()
+               << " pixels for a " << ni << "x" << nj << " frame" );
+  }
+
+  layout_ = new_layout;
+
+  // Pack all inputs according to the layout
+  pack_roi_image( layout_, input_color_, output_color_ );
+  pack_roi_image( layout_, input_grey_, output_grey_ );
+
+  output_features_.resize( input_features_.size() );
+
+  for( unsigned f = 0; f < input_features_.size(); ++f )
+  {
+    pack_roi_image( layout_, input_features_[f], output_features_[f] );
+  }
+
+  // Atlas images contain only scene content selected by the layout, so the
+  // border becomes the full atlas if one was given at all.
+  if( layout_.is_identity() || input_border_.volume() <= 0 )
+  {
+    output_border_ = input_border_;
+  }
+  else
+  {
+    output_border_ = image_border( 0, layout_.atlas_ni(), 0, layout_.atlas_nj() );
+  }
+
+  this->reset_inputs();
+  return true;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::reset_inputs()
+{
+  input_color_ = vil_image_view< InputType >();
+  input_grey_ = vil_image_view< InputType >();
+  input_border_ = image_border();
+  input_features_.clear();
+  input_regions_.clear();
+  input_mask_ = vil_image_view< bool >();
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_source_color_image( vil_image_view< InputType > const& img )
+{
+  input_color_ = img;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_source_grey_image( vil_image_view< InputType > const& img )
+{
+  input_grey_ = img;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_border( image_border const& border )
+{
+  input_border_ = border;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_auxiliary_features( feature_array_t const& features )
+{
+  input_features_ = features;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_roi_regions( std::vector< image_region > const& regions )
+{
+  input_regions_ = regions;
+}
+
+
+template< class InputType, class OutputType >
+void
+pixel_feature_roi_pack_process< InputType, OutputType >
+::set_roi_mask( vil_image_view< bool > const& mask )
+{
+  input_mask_ = mask;
+}
+
+
+template< class InputType, class OutputType >
+vil_image_view< InputType >
+pixel_feature_roi_pack_process< InputType, OutputType >
+::color_image() const
+{
+  return output_color_;
+}
+
+
+template< class InputType, class OutputType >
+vil_image_view< InputType >
+pixel_feature_roi_pack_process< InputType, OutputType >
+::grey_image() const
+{
+  return output_grey_;
+}
+
+
+template< class InputType, class OutputType >
+image_border
+pixel_feature_roi_pack_process< InputType, OutputType >
+::border() const
+{
+  return output_border_;
+}
+
+
+template< class InputType, class OutputType >
+std::vector< vil_image_view< OutputType > >
+pixel_feature_roi_pack_process< InputType, OutputType >
+::auxiliary_features() const
+{
+  return output_features_;
+}
+
+
+template< class InputType, class OutputType >
+pixel_feature_roi_layout
+pixel_feature_roi_pack_process< InputType, OutputType >
+::layout() const
+{
+  return layout_;
+}
+
+
+template< class InputType, class OutputType >
+bool
+pixel_feature_roi_pack_process< InputType, OutputType >
+::layout_changed() const
+{
+  return layout_changed_;
+}
+
+
+// ----------------------------------------------------------------
+template< class OutputType >
+pixel_feature_roi_unpack_process< OutputType >
+::pixel_feature_roi_unpack_process( std::string const& _name )
+  : process( _name, "pixel_feature_roi_unpack_process" )
+{
+}
+
+
+template< class OutputType >
+config_block
+pixel_feature_roi_unpack_process< OutputType >
+::params() const
+{
+  return config_block();
+}
+
+
+template< class OutputType >
+bool
+pixel_feature_roi_unpack_process< OutputType >
+::set_params( config_block const& )
+{
+  return true;
+}
+
+
+template< class OutputType >
+bool
+pixel_feature_roi_unpack_process< OutputType >
+::initialize()
+{
+  return true;
+}
+
+
+template< class OutputType >
+bool
+pixel_feature_roi_unpack_process< OutputType >
+::step()
+{
+  output_features_.resize( input_features_.size() );
+
+  for( unsigned f = 0; f < input_features_.size(); ++f )
+  {
+    unpack_roi_image( input_layout_, input_features_[f], output_features_[f] );
+  }
+
+  unpack_roi_image( input_layout_, input_var_, output_var_ );
+
+  input_layout_.fill_mask( output_mask_ );
+
+  input_features_.clear();
+  input_var_ = vil_image_view< double >();
+  return true;
+}
+
+
+template< class OutputType >
+void
+pixel_feature_roi_unpack_process< OutputType >
+::set_layout( pixel_feature_roi_layout const& layout )
+{
+  input_layout_ = layout;
+}
+
+
+template< class OutputType >
+void
+pixel_feature_roi_unpack_process< OutputType >
+::set_feature_array( feature_array_t const& features )
+{
+  input_features_ = features;
+}
+
+
+template< class OutputType >
+void
+pixel_feature_roi_unpack_process< OutputType >
+::set_var_image( vil_image_view< double > const& img )
+{
+  input_var_ = img;
+}
+
+
+template< class OutputType >
+std::vector< vil_image_view< OutputType > >
+pixel_feature_roi_unpack_process< OutputType >
+::feature_array() const
+{
+  return output_features_;
+}
+
+
+template< class OutputType >
+vil_image_view< double >
+pixel_feature_roi_unpack_process< OutputType >
+::var_image() const
+{
+  return output_var_;
+}
+
+
+template< class OutputType >
+vil_image_view< bool >
+pixel_feature_roi_unpack_process< OutputType >
+::roi_mask() const
+{
+  return output_mask_;
+}
+
+
+} // end namespace vidtk
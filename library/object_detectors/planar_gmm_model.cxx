@@ -0,0 +1,673 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <object_detectors/planar_gmm_model.h>
+
+#include <utilities/compute_pool.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+#if VIDTK_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <logger/logger.h>
+#undef VIDTK_DEFAULT_LOGGER
+#define VIDTK_DEFAULT_LOGGER __vidtk_logger_auto_planar_gmm_model_cxx__
+VIDTK_LOGGER("planar_gmm_model_cxx");
+
+
+namespace
+{
+
+// Squared Mahalanobis distance of n consecutive samples to n consecutive
+// components.  x and mu hold one row pointer per image plane, var holds
+// one row pointer (spherical) or one per image plane (independent).
+void
+sqr_mahal_row( float const* const* x,
+               float const* const* mu,
+               float const* const* var,
+               unsigned nplanes,
+               bool indep,
+               unsigned n,
+               float* out )
+{
+  unsigned i = 0;
+
+#if VIDTK_SSE2
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128 acc = _mm_setzero_ps();
+    for( unsigned c = 0; c < nplanes; ++c )
+    {
+      __m128 diff = _mm_sub_ps( _mm_loadu_ps( x[c] + i ), _mm_loadu_ps( mu[c] + i ) );
+      __m128 sqr = _mm_mul_ps( diff, diff );
+      if( indep )
+      {
+        sqr = _mm_div_ps( sqr, _mm_loadu_ps( var[c] + i ) );
+      }
+      acc = _mm_add_ps( acc, sqr );
+    }
+    if( ! indep )
+    {
+      acc = _mm_div_ps( acc, _mm_loadu_ps( var[0] + i ) );
+    }
+    _mm_storeu_ps( out + i, acc );
+  }
+#endif
+
+  for( unsigned j = i; j < n; ++j )
+  {
+    out[j] = 0.0f;
+  }
+  for( unsigned c = 0; c < nplanes; ++c )
+  {
+    float const* xc = x[c];
+    float const* mc = mu[c];
+    float const* vc = var[ indep ? c : 0 ];
+    for( unsigned j = i; j < n; ++j )
+    {
+      float const diff = xc[j] - mc[j];
+      out[j] += indep ? diff * diff / vc[j] : diff * diff;
+    }
+  }
+  if( ! indep )
+  {
+    for( unsigned j = i; j < n; ++j )
+    {
+      out[j] /= var[0][j];
+    }
+  }
+}
+
+
+// Swap a[lo] and a[hi] in the pixels where swap is set.
+inline void
+select_swap( float* a_lo, float* a_hi, unsigned char const* swap, unsigned n )
+{
+  for( unsigned i = 0; i < n; ++i )
+  {
+    float const lo = a_lo[i];
+    float const hi = a_hi[i];
+    a_lo[i] = swap[i] ? hi : lo;
+    a_hi[i] = swap[i] ? lo : hi;
+  }
+}
+
+} // end anonymous namespace
+
+
+namespace vidtk
+{
+
+
+class planar_gmm_model::priv
+{
+public:
+  priv()
+    : nplanes_( 0 ),
+      nvar_( 0 ),
+      npix_( 0 )
+  {
+  }
+
+  typedef boost::function< void ( unsigned, unsigned ) > band_function_t;
+
+  /// Run \a func over row bands [j0,j1) covering the model.
+  void run_bands( band_function_t const& func, unsigned nj ) const;
+
+  void detect_rows( vil_image_view<float> const* img,
+                    vil_image_view<bool>* bg_mask,
+                    std::vector< std::pair<int,int> > const* offsets,
+                    unsigned ni, unsigned nj,
+                    unsigned j0, unsigned j1 ) const;
+
+  void update_rows( vil_image_view<float> const* img,
+                    unsigned ni,
+                    unsigned j0, unsigned j1 );
+
+  /// Sort the components of n pixels starting at \a p by fitness.
+  void sort_components( unsigned p, unsigned n, float* fit_scratch, unsigned char* swap );
+
+  float* weight( unsigned k ) { return &weight_[ k * npix_ ]; }
+  float const* weight( unsigned k ) const { return &weight_[ k * npix_ ]; }
+  float* mean( unsigned k, unsigned c ) { return &mean_[ ( k * nplanes_ + c ) * npix_ ]; }
+  float const* mean( unsigned k, unsigned c ) const { return &mean_[ ( k * nplanes_ + c ) * npix_ ]; }
+  float* var( unsigned k, unsigned c ) { return &var_[ ( k * nvar_ + c ) * npix_ ]; }
+  float const* var( unsigned k, unsigned c ) const { return &var_[ ( k * nvar_ + c ) * npix_ ]; }
+  float* count( unsigned k ) { return &count_[ k * npix_ ]; }
+
+  planar_gmm_model_params params_;
+
+  unsigned nplanes_;
+  unsigned nvar_;
+  unsigned npix_;
+
+  /// Component weights, one plane per component.
+  std::vector<float> weight_;
+
+  /// Component means, nplanes_ planes per component.
+  std::vector<float> mean_;
+
+  /// Component variances, nvar_ planes per component.
+  std::vector<float> var_;
+
+  /// Number of samples matched by each component (LM only).
+  std::vector<float> count_;
+
+  /// Number of samples seen by each pixel, capped at the window (LM only).
+  std::vector<float> total_;
+};
+
+
+void
+planar_gmm_model::priv
+::run_bands( band_function_t const& func, unsigned nj ) const
+{
+  if( params_.num_threads <= 1 )
+  {
+    func( 0, nj );
+    return;
+  }
+
+  // one band per thread, run on the shared compute pool
+  compute_pool::instance()->parallel_for( 0, nj, func, "planar_gmm_model",
+                                          params_.num_threads );
+}
+
+
+void
+planar_gmm_model::priv
+::detect_rows( vil_image_view<float> const* img,
+               vil_image_view<bool>* bg_mask,
+               std::vector< std::pair<int,int> > const* offsets,
+               unsigned ni, unsigned nj,
+               unsigned j0, unsigned j1 ) const
+{
+  unsigned const K = params_.max_components;
+  bool const indep = ( params_.covar_mode == planar_gmm_model_params::COVAR_INDEP );
+  float const thresh = params_.background_distance * params_.background_distance;
+  float const top_weight = params_.weight;
+
+  std::vector<float> d2( ni );
+  std::vector<float> cum( ni );
+  std::vector<unsigned char> bg( ni );
+  std::vector<float const*> x( nplanes_ );
+  std::vector<float const*> mu( nplanes_ );
+  std::vector<float const*> v( nvar_ );
+
+  for( unsigned j = j0; j < j1; ++j )
+  {
+    std::fill( bg.begin(), bg.end(), 0 );
+
+    for( unsigned o = 0; o < offsets->size(); ++o )
+    {
+      int const di = (*offsets)[o].first;
+      int const dj = (*offsets)[o].second;
+      int const jm = static_cast<int>( j ) + dj;
+      if( jm < 0 || jm >= static_cast<int>( nj ) )
+      {
+        continue;
+      }
+
+      // range of sample columns whose model neighbor is inside the image
+      unsigned const i0 = static_cast<unsigned>( std::max( 0, -di ) );
+      int const i1s = std::min( static_cast<int>( ni ), static_cast<int>( ni ) - di );
+      if( i1s <= static_cast<int>( i0 ) )
+      {
+        continue;
+      }
+      unsigned const n = static_cast<unsigned>( i1s ) - i0;
+      unsigned const pm = jm * ni + i0 + di;
+
+      for( unsigned c = 0; c < nplanes_; ++c )
+      {
+        x[c] = &(*img)( i0, j, c );
+      }
+      std::fill( cum.begin(), cum.begin() + n, 0.0f );
+      unsigned char* bgo = &bg[i0];
+
+      for( unsigned k = 0; k < K; ++k )
+      {
+        for( unsigned c = 0; c < nplanes_; ++c )
+        {
+          mu[c] = mean( k, c ) + pm;
+        }
+        for( unsigned c = 0; c < nvar_; ++c )
+        {
+          v[c] = var( k, c ) + pm;
+        }
+        sqr_mahal_row( &x[0], &mu[0], &v[0], nplanes_, indep, n, &d2[0] );
+
+        float const* w = weight( k ) + pm;
+        for( unsigned i = 0; i < n; ++i )
+        {
+          bgo[i] |= ( cum[i] < top_weight ) & ( w[i] > 0.0f ) & ( d2[i] < thresh );
+          cum[i] += w[i];
+        }
+      }
+    }
+
+    for( unsigned i = 0; i < ni; ++i )
+    {
+      (*bg_mask)( i, j ) = ( bg[i] != 0 );
+    }
+  }
+}
+
+
+void
+planar_gmm_model::priv
+::update_rows( vil_image_view<float> const* img,
+               unsigned ni,
+               unsigned j0, unsigned j1 )
+{
+  unsigned const K = params_.max_components;
+  bool const indep = ( params_.covar_mode == planar_gmm_model_params::COVAR_INDEP );
+  bool const lm = ( params_.update_mode == planar_gmm_model_params::UPDATE_LM );
+  float const thresh = params_.gaussian_match_thresh * params_.gaussian_match_thresh;
+  float const min_var = params_.mininum_stdev * params_.mininum_stdev;
+  float const init_var = params_.init_variance;
+  float const window = static_cast<float>( params_.lm_window_size );
+
+  std::vector<float> d2( ni );
+  std::vector<float> match( ni );
+  std::vector<float> alpha( ni );
+  std::vector<float> rho( ni );
+  std::vector<float> sqr( ni );
+  std::vector<float> sum( ni );
+  std::vector<float> fit( K * ni );
+  std::vector<unsigned char> swap( ni );
+  std::vector<float const*> x( nplanes_ );
+  std::vector<float const*> mu( nplanes_ );
+  std::vector<float const*> v( nvar_ );
+
+  for( unsigned j = j0; j < j1; ++j )
+  {
+    unsigned const p = j * ni;
+
+    for( unsigned c = 0; c < nplanes_; ++c )
+    {
+      x[c] = &(*img)( 0, j, c );
+    }
+
+    // Find the first (fittest) matching component, or -1.
+    std::fill( match.begin(), match.end(), -1.0f );
+    for( unsigned k = 0; k < K; ++k )
+    {
+      for( unsigned c = 0; c < nplanes_; ++c )
+      {
+        mu[c] = mean( k, c ) + p;
+      }
+      for( unsigned c = 0; c < nvar_; ++c )
+      {
+        v[c] = var( k, c ) + p;
+      }
+      sqr_mahal_row( &x[0], &mu[0], &v[0], nplanes_, indep, ni, &d2[0] );
+
+      float const* w = weight( k ) + p;
+      float const kf = static_cast<float>( k );
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        bool const hit = ( match[i] < 0.0f ) & ( w[i] > 0.0f ) & ( d2[i] < thresh );
+        match[i] = hit ? kf : match[i];
+      }
+    }
+
+    // Weight learning rate
+    if( lm )
+    {
+      float* t = &total_[p];
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        t[i] = std::min( t[i] + 1.0f, window );
+        alpha[i] = 1.0f / t[i];
+      }
+    }
+    else
+    {
+      std::fill( alpha.begin(), alpha.end(), params_.sg_learning_rate );
+    }
+
+    // Update every component, masked by whether it was the match.
+    for( unsigned k = 0; k < K; ++k )
+    {
+      float const kf = static_cast<float>( k );
+      float* w = weight( k ) + p;
+
+      if( lm )
+      {
+        float* n = count( k ) + p;
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          float const m = ( match[i] == kf ) ? 1.0f : 0.0f;
+          w[i] = w[i] * ( 1.0f - alpha[i] ) + alpha[i] * m;
+          n[i] = std::min( n[i] + m, window );
+          rho[i] = m / std::max( n[i], 1.0f );
+        }
+      }
+      else
+      {
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          float const m = ( match[i] == kf ) ? 1.0f : 0.0f;
+          w[i] = w[i] * ( 1.0f - alpha[i] ) + alpha[i] * m;
+          rho[i] = alpha[i] * m;
+        }
+      }
+
+      std::fill( sqr.begin(), sqr.end(), 0.0f );
+      for( unsigned c = 0; c < nplanes_; ++c )
+      {
+        float* mc = mean( k, c ) + p;
+        float const* xc = x[c];
+        float* vc = indep ? var( k, c ) + p : 0;
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          float const diff = xc[i] - mc[i];
+          mc[i] += rho[i] * diff;
+          if( indep )
+          {
+            float const nv = vc[i] + rho[i] * ( diff * diff - vc[i] );
+            vc[i] = std::max( nv, min_var );
+          }
+          else
+          {
+            sqr[i] += diff * diff;
+          }
+        }
+      }
+      if( ! indep )
+      {
+        float* vc = var( k, 0 ) + p;
+        float const inv_planes = 1.0f / nplanes_;
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          float const nv = vc[i] + rho[i] * ( sqr[i] * inv_planes - vc[i] );
+          vc[i] = std::max( nv, min_var );
+        }
+      }
+    }
+
+    // Replace the least fit component where nothing matched.
+    {
+      unsigned const k = K - 1;
+      float* w = weight( k ) + p;
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        float const new_w = lm ? alpha[i] : params_.sg_init_weight;
+        w[i] = ( match[i] < 0.0f ) ? new_w : w[i];
+      }
+      for( unsigned c = 0; c < nplanes_; ++c )
+      {
+        float* mc = mean( k, c ) + p;
+        float const* xc = x[c];
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          mc[i] = ( match[i] < 0.0f ) ? xc[i] : mc[i];
+        }
+      }
+      for( unsigned c = 0; c < nvar_; ++c )
+      {
+        float* vc = var( k, c ) + p;
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          vc[i] = ( match[i] < 0.0f ) ? init_var : vc[i];
+        }
+      }
+      if( lm )
+      {
+        float* n = count( k ) + p;
+        for( unsigned i = 0; i < ni; ++i )
+        {
+          n[i] = ( match[i] < 0.0f ) ? 1.0f : n[i];
+        }
+      }
+    }
+
+    // Renormalize the weights.
+    std::fill( sum.begin(), sum.end(), 0.0f );
+    for( unsigned k = 0; k < K; ++k )
+    {
+      float const* w = weight( k ) + p;
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        sum[i] += w[i];
+      }
+    }
+    for( unsigned k = 0; k < K; ++k )
+    {
+      float* w = weight( k ) + p;
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        w[i] = ( sum[i] > 0.0f ) ? w[i] / sum[i] : w[i];
+      }
+    }
+
+    sort_components( p, ni, &fit[0], &swap[0] );
+  }
+}
+
+
+void
+planar_gmm_model::priv
+::sort_components( unsigned p, unsigned n, float* fit, unsigned char* swap )
+{
+  unsigned const K = params_.max_components;
+  float const inv_nvar = 1.0f / nvar_;
+
+  // fitness = w^2 / var, using the mean variance across planes
+  for( unsigned k = 0; k < K; ++k )
+  {
+    float* f = fit + k * n;
+    float const* w = weight( k ) + p;
+    std::fill( f, f + n, 0.0f );
+    for( unsigned c = 0; c < nvar_; ++c )
+    {
+      float const* vc = var( k, c ) + p;
+      for( unsigned i = 0; i < n; ++i )
+      {
+        f[i] += vc[i];
+      }
+    }
+    for( unsigned i = 0; i < n; ++i )
+    {
+      float const v = f[i] * inv_nvar;
+      f[i] = ( v > 0.0f ) ? w[i] * w[i] / v : 0.0f;
+    }
+  }
+
+  // Only one component changes its relative fitness per update, so an
+  // upward and a downward pass of adjacent compare-and-swap steps puts
+  // it back in order.
+  for( int pass = 0; pass < 2; ++pass )
+  {
+    for( unsigned s = 1; s < K; ++s )
+    {
+      unsigned const k = ( pass == 0 ) ? K - s : s;
+      float* f_lo = fit + ( k - 1 ) * n;
+      float* f_hi = fit + k * n;
+      for( unsigned i = 0; i < n; ++i )
+      {
+        swap[i] = ( f_hi[i] > f_lo[i] );
+      }
+
+      select_swap( f_lo, f_hi, swap, n );
+      select_swap( weight( k - 1 ) + p, weight( k ) + p, swap, n );
+      for( unsigned c = 0; c < nplanes_; ++c )
+      {
+        select_swap( mean( k - 1, c ) + p, mean( k, c ) + p, swap, n );
+      }
+      for( unsigned c = 0; c < nvar_; ++c )
+      {
+        select_swap( var( k - 1, c ) + p, var( k, c ) + p, swap, n );
+      }
+      if( ! count_.empty() )
+      {
+        select_swap( count( k - 1 ) + p, count( k ) + p, swap, n );
+      }
+    }
+  }
+}
+
+
+planar_gmm_model
+::planar_gmm_model()
+  : ni_( 0 ),
+    nj_( 0 ),
+    d( new priv )
+{
+}
+
+
+planar_gmm_model
+::~planar_gmm_model()
+{
+}
+
+
+void
+planar_gmm_model
+::set_params( planar_gmm_model_params const& p )
+{
+  d->params_ = p;
+  if( d->params_.max_components == 0 )
+  {
+    LOG_WARN( "planar_gmm_model: max_components must be positive, using 1" );
+    d->params_.max_components = 1;
+  }
+}
+
+
+void
+planar_gmm_model
+::initialize( unsigned ni, unsigned nj, unsigned nplanes )
+{
+  unsigned const K = d->params_.max_components;
+
+  ni_ = ni;
+  nj_ = nj;
+  d->nplanes_ = nplanes;
+  d->nvar_ = ( d->params_.covar_mode == planar_gmm_model_params::COVAR_INDEP ) ? nplanes : 1;
+  d->npix_ = ni * nj;
+
+  // Empty components are marked by a zero weight; their variance is
+  // non-zero so distance computations stay finite.
+  d->weight_.assign( K * d->npix_, 0.0f );
+  d->mean_.assign( K * nplanes * d->npix_, 0.0f );
+  d->var_.assign( K * d->nvar_ * d->npix_, d->params_.init_variance );
+
+  if( d->params_.update_mode == planar_gmm_model_params::UPDATE_LM )
+  {
+    d->count_.assign( K * d->npix_, 0.0f );
+    d->total_.assign( d->npix_, 0.0f );
+  }
+  else
+  {
+    d->count_.clear();
+    d->total_.clear();
+  }
+}
+
+
+void
+planar_gmm_model
+::clear()
+{
+  ni_ = 0;
+  nj_ = 0;
+  d->npix_ = 0;
+  d->weight_.clear();
+  d->mean_.clear();
+  d->var_.clear();
+  d->count_.clear();
+  d->total_.clear();
+}
+
+
+void
+planar_gmm_model
+::detect( vil_image_view<float> const& img,
+          vil_image_view<bool>& bg_mask,
+          std::vector< std::pair<int,int> > const& offsets ) const
+{
+  assert( img.ni() == ni_ && img.nj() == nj_ && img.nplanes() == d->nplanes_ );
+
+  // The row kernels require unit column stride.
+  vil_image_view<float> src = img;
+  if( img.istep() != 1 )
+  {
+    src = vil_image_view<float>();
+    src.deep_copy( img );
+  }
+
+  bg_mask.set_size( ni_, nj_ );
+
+  std::vector< std::pair<int,int> > zero_offset( 1, std::make_pair( 0, 0 ) );
+  std::vector< std::pair<int,int> > const* offs = offsets.empty() ? &zero_offset : &offsets;
+
+  d->run_bands( boost::bind( &priv::detect_rows, d.get(), &src, &bg_mask, offs,
+                             ni_, nj_, _1, _2 ), nj_ );
+}
+
+
+void
+planar_gmm_model
+::update( vil_image_view<float> const& img )
+{
+  assert( img.ni() == ni_ && img.nj() == nj_ && img.nplanes() == d->nplanes_ );
+
+  vil_image_view<float> src = img;
+  if( img.istep() != 1 )
+  {
+    src = vil_image_view<float>();
+    src.deep_copy( img );
+  }
+
+  d->run_bands( boost::bind( &priv::update_rows, d.get(), &src, ni_, _1, _2 ), nj_ );
+}
+
+
+void
+planar_gmm_model
+::background( vil_image_view<float>& img, float const* invalid_color ) const
+{
+  unsigned const K = d->params_.max_components;
+
+  img.set_size( ni_, nj_, d->nplanes_ );
+  img.fill( 0.0f );
+
+  for( unsigned j = 0; j < nj_; ++j )
+  {
+    unsigned const p = j * ni_;
+    for( unsigned c = 0; c < d->nplanes_; ++c )
+    {
+      float const invalid = invalid_color ? invalid_color[ c ] : 0.0f;
+      float* out = &img( 0, j, c );
+      std::ptrdiff_t const istep = img.istep();
+      for( unsigned i = 0; i < ni_; ++i )
+      {
+        float num = 0.0f;
+        float den = 0.0f;
+        for( unsigned k = 0; k < K; ++k )
+        {
+          float const w = d->weight( k )[ p + i ];
+          num += w * d->mean( k, c )[ p + i ];
+          den += w;
+        }
+        out[ i * istep ] = ( den > 0.0f ) ? num / den : invalid;
+      }
+    }
+  }
+}
+
+
+} // end namespace vidtk
@@ -0,0 +1,162 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_planar_gmm_model_h_
+#define vidtk_planar_gmm_model_h_
+
+#include <vil/vil_image_view.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+namespace vidtk
+{
+
+/// \brief The parameters governing the planar GMM background model.
+///
+/// \sa planar_gmm_model
+struct planar_gmm_model_params
+{
+  enum update_mode_type { UPDATE_SG, UPDATE_LM };
+  enum covar_mode_type { COVAR_SPHERE, COVAR_INDEP };
+
+  planar_gmm_model_params()
+    : update_mode( UPDATE_LM ),
+      covar_mode( COVAR_INDEP ),
+      max_components( 5 ),
+      init_variance( 6502.5f ),
+      gaussian_match_thresh( 3.0f ),
+      mininum_stdev( 25.1f ),
+      lm_window_size( 100 ),
+      sg_learning_rate( 0.1f ),
+      sg_init_weight( 0.1f ),
+      background_distance( 3.0f ),
+      weight( 0.7f ),
+      num_threads( 1 )
+  {
+  }
+
+  /// Stauffer-Grimson or Leotta-Mundy update equations.
+  update_mode_type update_mode;
+
+  /// Scalar variance per component, or one variance per plane.
+  covar_mode_type covar_mode;
+
+  /// Maximum number of components in each pixel mixture.
+  unsigned max_components;
+
+  /// Variance of newly inserted components.
+  float init_variance;
+
+  /// Mahalanobis distance for a sample to match a component on update.
+  float gaussian_match_thresh;
+
+  /// Lower bound on the standard deviation of every component.
+  float mininum_stdev;
+
+  /// Temporal window size of the Leotta-Mundy learning rate.
+  unsigned lm_window_size;
+
+  /// Constant learning rate of the Stauffer-Grimson equations.
+  float sg_learning_rate;
+
+  /// Weight of new components in the Stauffer-Grimson equations.
+  float sg_init_weight;
+
+  /// Mahalanobis distance for a sample to match a component on detection.
+  float background_distance;
+
+  /// Fraction of the total weight treated as background on detection.
+  float weight;
+
+  /// Number of row bands processed concurrently.
+  unsigned num_threads;
+};
+
+
+/// \brief Structure-of-arrays Gaussian mixture background model.
+///
+/// This is a drop-in alternative to the per-pixel bbgm_image_of
+/// mixture used by gmm_background_model_process.  Rather than one
+/// heap-allocated mixture object per pixel, the model keeps one
+/// contiguous single-precision plane per component for the weights,
+/// the means (one per image plane) and the variances.  Matching,
+/// detection and the update equations are written as branchless
+/// per-row loops over these planes so that they vectorize across
+/// pixels (explicit SSE2 kernels are used when VIDTK_SSE2 is
+/// defined), and the image is split into row bands which are
+/// processed in parallel.
+///
+/// Components of each pixel are kept sorted by fitness (w^2/var),
+/// matching the ordering used by the vpdt mixture updaters, so the
+/// same top-weight detection rule applies.
+///
+/// Tolerance with respect to the bbgm path: the update equations use
+/// a constant rate of \c sg_learning_rate (SG) or 1/n_k with n_k
+/// capped at \c lm_window_size (LM) for the component statistics,
+/// and all arithmetic is single-precision.  Foreground masks are
+/// therefore expected to differ from the bbgm masks only for samples
+/// whose Mahalanobis distance lies close to \c background_distance,
+/// i.e. scattered pixels along object boundaries, and not in the
+/// detected regions themselves.
+class planar_gmm_model
+{
+public:
+  planar_gmm_model();
+  ~planar_gmm_model();
+
+  /// Set the model parameters.  Takes effect on the next initialize().
+  void set_params( planar_gmm_model_params const& p );
+
+  /// Allocate an empty model for images of the given size.
+  void initialize( unsigned ni, unsigned nj, unsigned nplanes );
+
+  /// Release the current model.
+  void clear();
+
+  /// Width of the model.
+  unsigned ni() const { return ni_; }
+
+  /// Height of the model.
+  unsigned nj() const { return nj_; }
+
+  /// \brief Classify each pixel of \a img as background or not.
+  ///
+  /// \a bg_mask is set to true where the pixel value matches one of the
+  /// top-weight components of the model at the pixel itself or at any
+  /// of the (i,j) offsets given in \a offsets.  An empty offset list is
+  /// treated as the single offset (0,0).
+  void detect( vil_image_view<float> const& img,
+               vil_image_view<bool>& bg_mask,
+               std::vector< std::pair<int,int> > const& offsets ) const;
+
+  /// Update the model with the pixels of \a img.
+  void update( vil_image_view<float> const& img );
+
+  /// \brief Render the weighted mean of each mixture into \a img.
+  ///
+  /// Pixels whose mixture has no component are set to \a invalid_color,
+  /// which holds one value per plane, or to zero if it is NULL.
+  void background( vil_image_view<float>& img,
+                   float const* invalid_color = NULL ) const;
+
+private:
+  unsigned ni_;
+  unsigned nj_;
+
+  /// private implementation class
+  class priv;
+  boost::scoped_ptr<priv> d;
+};
+
+
+} // end namespace vidtk
+
+
+#endif // vidtk_planar_gmm_model_h_
@@ -312,6 +312,8 @@ public:
     // Connect feature array to all classifiers
     p->connect( proc_features->feature_array_port(),
                 proc_classifier1->set_pixel_features_port() );
+    p->connect( proc_features->roi_mask_port(),
+                proc_classifier1->set_roi_mask_port() );
     p->connect( proc_features->feature_array_port(),
                 proc_classifier2->set_input_features_port() );
 
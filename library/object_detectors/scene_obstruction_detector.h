@@ -206,13 +206,15 @@ public:
   /// Re-configure the detector with new settings.
   bool configure( const scene_obstruction_detector_settings& options );
 
-  /// Process a new frame, given it's feature vector.
+  /// Process a new frame, given it's feature vector. If a non-empty
+  /// region of interest mask is given, only pixels within it are classified.
   void process_frame( const source_image& input_image,
                       const feature_array& input_features,
                       const image_border& input_border,
                       const variance_image& pixel_variance,
                       classified_image& output_image,
-                      properties& output_properties );
+                      properties& output_properties,
+                      const mask_type& roi_mask = mask_type() );
 
 private:
 
@@ -254,6 +256,7 @@ private:
   // Generate initial obstruction heatmap
   void perform_initial_approximation( const feature_array& features,
                                       const image_border& border,
+                                      const mask_type& roi_mask,
                                       classified_image& output_image );
 
   // Estimate obstruction properties (color, size)
@@ -144,12 +144,16 @@ scene_obstruction_detector<PixType,FeatureType>
                  const image_border& input_border,
                  const variance_image& pixel_variance,
                  classified_image& output_image,
-                 properties& output_properties )
+                 properties& output_properties,
+                 const mask_type& roi_mask )
 {
   LOG_ASSERT( is_valid_, "Internal model is not valid!" );
   LOG_ASSERT( input_features.size() > 0, "No input features provided!" );
   LOG_ASSERT( input_features[0].ni() == input_image.ni(), "Input widths do not match." );
   LOG_ASSERT( input_features[0].nj() == input_image.nj(), "Input heights do not match." );
+  LOG_ASSERT( !roi_mask || ( roi_mask.ni() == input_image.ni() &&
+                             roi_mask.nj() == input_image.nj() ),
+              "ROI mask size does not match input." );
 
   props_.break_flag_ = false;
   feature_array full_feature_array = input_features;
@@ -204,6 +208,7 @@ scene_obstruction_detector<PixType,FeatureType>
   // Generate initial per-pixel mask classification
   this->perform_initial_approximation( full_feature_array,
                                        input_border,
+                                       roi_mask,
                                        output_image );
 
   // Estimate mask properties
@@ -224,6 +229,7 @@ scene_obstruction_detector<PixType,FeatureType>
     {
       this->perform_initial_approximation( full_feature_array,
                                            input_border,
+                                           roi_mask,
                                            output_image );
     }
   }
@@ -311,6 +317,7 @@ void
 scene_obstruction_detector<PixType,FeatureType>
 ::perform_initial_approximation( const feature_array& features,
                                  const image_border& border,
+                                 const mask_type& roi_mask,
                                  classified_image& output_image )
 {
   // Formulate classifier input (vector of single plane byte images)
@@ -319,7 +326,7 @@ scene_obstruction_detector<PixType,FeatureType>
   // A small (negatively classified) value used for initially filling
   // the output classification. For the most part is not used, except
   // for pixels which don't get processed (ie those outside of the identified
-  // border).
+  // border or the region of interest mask).
   const double negative_fill_value = options_.initial_threshold_-std::numeric_limits<double>::epsilon();
 
   // Seed the output approximate
@@ -327,6 +334,7 @@ scene_obstruction_detector<PixType,FeatureType>
 
   // Create new input array to feed to classifiers
   feature_array input_array;
+  mask_type input_mask = roi_mask;
 
   // Scale views for image border if present
   if( border.volume() > 0 )
@@ -336,6 +344,11 @@ scene_obstruction_detector<PixType,FeatureType>
       input_array.push_back( point_view_to_region( features[i], border ) );
     }
     approx_output = point_view_to_region( approx_output, border );
+
+    if( input_mask )
+    {
+      input_mask = point_view_to_region( input_mask, border );
+    }
   }
   else
   {
@@ -344,13 +357,17 @@ scene_obstruction_detector<PixType,FeatureType>
 
   // Perform classification
   double offset = adaptive_threshold_contribution( frames_since_last_break_ );
-  if( !options_.use_appearance_classifier_ || frames_since_last_break_ > options_.appearance_frames_ )
+  const hashed_image_classifier< FeatureType >& clfr =
+    ( !options_.use_appearance_classifier_ || frames_since_last_break_ > options_.appearance_frames_ ?
+      initial_classifier_ : appearance_classifier_ );
+
+  if( input_mask )
   {
-    initial_classifier_.classify_images( input_array, approx_output, offset );
+    clfr.classify_images( input_array, input_mask, approx_output, offset );
   }
   else
   {
-    appearance_classifier_.classify_images( input_array, approx_output, offset );
+    clfr.classify_images( input_array, approx_output, offset );
   }
 
   // Add classification to history and copy history to output
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -72,6 +72,10 @@ public:
   void set_input_features( feature_array const& array );
   VIDTK_INPUT_PORT( set_input_features, feature_array const& );
 
+  /// Pixels with computed features, if only a region of interest is used
+  void set_roi_mask( vil_image_view<bool> const& mask );
+  VIDTK_OPTIONAL_INPUT_PORT( set_roi_mask, vil_image_view<bool> const& );
+
   vil_image_view<double> classified_image() const;
   VIDTK_OUTPUT_PORT( vil_image_view<double>, classified_image );
 
@@ -85,6 +89,7 @@ private:
   vil_image_view<PixType> rgb_; // RGB input image
   vgl_box_2d<int> border_; // Detected image border
   feature_array features_; // Calculated per-pixel features
+  vil_image_view<bool> roi_mask_; // Pixels with valid features, if set
 
   // Possible Outputs
   vil_image_view<double> output_image_; // Classified image
@@ -286,7 +286,8 @@ scene_obstruction_detector_process<PixType>
                            border_,
                            var_,
                            output_image_,
-                           output_properties_ );
+                           output_properties_,
+                           roi_mask_ );
 
   // Reset input variables
   reset_inputs();
@@ -331,6 +332,12 @@ scene_obstruction_detector_process<PixType>
     return false;
   }
 
+  if( roi_mask_ && ( roi_mask_.ni() != rgb_.ni() || roi_mask_.nj() != rgb_.nj() ) )
+  {
+    LOG_ERROR( this->name() << ": ROI mask and image sizes do not match!" );
+    return false;
+  }
+
   return true;
 }
 
@@ -341,6 +348,7 @@ scene_obstruction_detector_process<PixType>
 {
   rgb_.clear();
   features_.clear();
+  roi_mask_ = vil_image_view<bool>();
 }
 
 template <typename PixType>
@@ -408,6 +416,14 @@ scene_obstruction_detector_process<PixType>
   features_ = array;
 }
 
+template <typename PixType>
+void
+scene_obstruction_detector_process<PixType>
+::set_roi_mask( vil_image_view<bool> const& mask )
+{
+  roi_mask_ = mask;
+}
+
 template <typename PixType>
 vil_image_view<double>
 scene_obstruction_detector_process<PixType>
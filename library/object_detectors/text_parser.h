@@ -88,6 +88,13 @@ namespace vidtk
     0, \
     "If non-zero, paint detected text of the given size on the output " \
     "debug images." ); \
+  add_param( \
+    thread_count, \
+    unsigned, \
+    1, \
+    "Number of threads to use when matching character templates, with " \
+    "templates divided between threads. If 0, the core budget of the " \
+    "shared compute pool is used." ); \
 
 init_external_settings3( text_parser_settings, settings_macro );
 
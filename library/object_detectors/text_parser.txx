@@ -8,6 +8,7 @@
 
 #include <utilities/point_view_to_region.h>
 #include <utilities/folder_manipulation.h>
+#include <utilities/compute_pool.h>
 
 #ifdef USE_TESSERACT
   #include <tesseract/baseapi.h>
@@ -22,7 +23,6 @@
   #include <opencv2/imgproc/imgproc.hpp>
 #endif
 
-#include <video_transforms/ssd.h>
 #include <video_transforms/invert_image_values.h>
 
 #include <vil/vil_save.h>
@@ -38,6 +38,8 @@
 
 #include <string>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #include <logger/logger.h>
 
@@ -214,6 +216,144 @@ is_in_bounds( const position_result& result,
 }
 
 
+// Integral image of squared pixel values summed across all planes, with an
+// additional leading row and column of zeros. Stored as doubles, which hold
+// all sums exactly for integer pixel types.
+template< typename PixType >
+void
+compute_square_integral( const vil_image_view< PixType >& image,
+                         std::vector< double >& integral )
+{
+  const unsigned ni = image.ni();
+  const unsigned nj = image.nj();
+  const unsigned width = ni + 1;
+
+  integral.assign( width * ( nj + 1 ), 0.0 );
+
+  for( unsigned j = 0; j < nj; ++j )
+  {
+    double row_sum = 0.0;
+
+    for( unsigned i = 0; i < ni; ++i )
+    {
+      for( unsigned p = 0; p < image.nplanes(); ++p )
+      {
+        const double value = static_cast< double >( image( i, j, p ) );
+        row_sum += value * value;
+      }
+
+      integral[ ( j + 1 ) * width + i + 1 ] = integral[ j * width + i + 1 ] + row_sum;
+    }
+  }
+}
+
+
+// Compute the minimum mean SSD of each template against every column of the
+// region, taken over all vertical positions. The SSD is decomposed into the
+// sum of squared region pixels (from the shared integral image), the sum of
+// squared template pixels, and the cross term, which is the only part that
+// must be computed per template. Columns where a template does not fit are
+// left empty.
+template< typename PixType >
+void
+match_templates( const vil_image_view< PixType >* region,
+                 const std::vector< double >* integral,
+                 const typename text_parser_model_group< PixType >::templates_t* templates,
+                 std::vector< std::vector< double > >* column_minimums,
+                 unsigned first, unsigned last )
+{
+  const vil_image_view< PixType >& roi = *region;
+  const unsigned width = roi.ni() + 1;
+
+  const std::ptrdiff_t s_istep = roi.istep();
+  const std::ptrdiff_t s_jstep = roi.jstep();
+  const std::ptrdiff_t s_pstep = roi.planestep();
+
+  std::vector< double > cross;
+
+  for( unsigned t = first; t < last; ++t )
+  {
+    const vil_image_view< PixType >& kernel = (*templates)[t].second;
+    std::vector< double >& mins = (*column_minimums)[t];
+
+    mins.clear();
+
+    if( roi.ni() < kernel.ni() || roi.nj() < kernel.nj() )
+    {
+      continue;
+    }
+
+    const unsigned kni = kernel.ni();
+    const unsigned knj = kernel.nj();
+    const unsigned knp = kernel.nplanes();
+    const unsigned n = kni * knj * knp;
+
+    const unsigned out_ni = roi.ni() - kni + 1;
+    const unsigned out_nj = roi.nj() - knj + 1;
+
+    double kernel_sum = 0.0;
+
+    for( unsigned p = 0; p < knp; ++p )
+    {
+      for( unsigned y = 0; y < knj; ++y )
+      {
+        for( unsigned x = 0; x < kni; ++x )
+        {
+          const double value = static_cast< double >( kernel( x, y, p ) );
+          kernel_sum += value * value;
+        }
+      }
+    }
+
+    mins.assign( out_ni, std::numeric_limits< double >::max() );
+    cross.resize( out_ni );
+
+    for( unsigned j = 0; j < out_nj; ++j )
+    {
+      std::fill( cross.begin(), cross.end(), 0.0 );
+
+      // Accumulate the cross term for an entire output row at once, so that
+      // the innermost loop runs along contiguous region pixels.
+      for( unsigned p = 0; p < knp; ++p )
+      {
+        for( unsigned y = 0; y < knj; ++y )
+        {
+          const PixType* src_row = roi.top_left_ptr() + p * s_pstep + ( j + y ) * s_jstep;
+
+          for( unsigned x = 0; x < kni; ++x )
+          {
+            const double kv = static_cast< double >( kernel( x, y, p ) );
+            const PixType* sp = src_row + x * s_istep;
+
+            for( unsigned i = 0; i < out_ni; ++i, sp += s_istep )
+            {
+              cross[i] += kv * static_cast< double >( *sp );
+            }
+          }
+        }
+      }
+
+      const double* top = &(*integral)[ j * width ];
+      const double* bottom = &(*integral)[ ( j + knj ) * width ];
+
+      for( unsigned i = 0; i < out_ni; ++i )
+      {
+        const double region_sum = bottom[ i + kni ] - bottom[ i ] - top[ i + kni ] + top[ i ];
+
+        // Normalize in single precision, as get_ssd_surf does
+        float ssd = static_cast< float >( region_sum + kernel_sum - 2.0 * cross[i] );
+        ssd /= n;
+
+        if( ssd < mins[i] )
+        {
+          mins[i] = ssd;
+        }
+      }
+    }
+  }
+}
+
+
 template< typename PixType >
 void
 format_region( const vil_image_view< PixType >& roi,
@@ -324,20 +464,27 @@ text_parser< PixType >
                    scale_factor,
                    settings_.invert_image );
 
-    // Perform convolution with each template
+    // Match all templates against the region, sharing the squared pixel sums
     const templates_t& templates = models.templates;
     const unsigned template_count = templates.size();
 
-    std::vector< vil_image_view< double > > ssd_results( templates.size() );
+    std::vector< double > square_integral;
+    compute_square_integral( filtered_roi, square_integral );
+
+    std::vector< std::vector< double > > column_minimums( template_count );
+
+    compute_pool::instance()->parallel_for(
+      0, template_count,
+      boost::bind( match_templates< PixType >, &filtered_roi, &square_integral,
+                   &templates, &column_minimums, _1, _2 ),
+      "text_parser", settings_.thread_count );
+
     unsigned min_col_count = std::numeric_limits< unsigned >::max();
 
     for( unsigned t = 0; t < template_count; ++t )
     {
-      get_ssd_surf( filtered_roi,
-                    ssd_results[t],
-                    templates[t].second );
-
-      min_col_count = std::min( min_col_count, ssd_results[t].ni() );
+      min_col_count = std::min( min_col_count,
+                                static_cast< unsigned >( column_minimums[t].size() ) );
     }
 
     // Compute template normalization and overlap factors
@@ -361,14 +508,11 @@ text_parser< PixType >
 
       for( unsigned t = 0; t < template_count; ++t )
       {
-        for( unsigned j = 0; j < ssd_results[t].nj(); ++j )
+        if( column_minimums[ t ][ i ] < top_col_result.weight )
         {
-          if( ssd_results[ t ]( i, j ) < top_col_result.weight )
-          {
-            top_col_result.weight = ssd_results[ t ]( i, j );
-            top_col_result.position = i;
-            top_col_result.template_id = t;
-          }
+          top_col_result.weight = column_minimums[ t ][ i ];
+          top_col_result.position = i;
+          top_col_result.template_id = t;
         }
       }
 
@@ -10,25 +10,23 @@
 #include <vil/vil_image_view.h>
 
 #include <utilities/point_view_to_region.h>
+#include <utilities/compute_pool.h>
 
-#include <boost/thread/thread.hpp>
-#include <boost/thread/condition.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/shared_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
-#include <boost/scoped_ptr.hpp>
 
 #include <tracking_data/image_border.h>
 
 #include <vgl/vgl_intersection.h>
 
-#include <queue>
+#include <string>
+#include <vector>
 
 namespace vidtk
 {
 
 /// \brief Helper class which grids up an image and calls some function on
-/// each tile in a distributed fashion via threading.
+/// each tile in a distributed fashion via the shared compute_pool.
 ///
 /// This class is designed to accept an arbitrary number of arguments via
 /// templating both the function that processes the images, and the actual
@@ -46,48 +44,19 @@ public:
   typedef boost::function6< void, image_border, Arg1, Arg2, Arg3, Arg4, Arg5 > function_t;
   typedef threaded_detector< Arg1, Arg2, Arg3, Arg4, Arg5 > self_t;
 
-  explicit threaded_detector( unsigned tx, unsigned ty )
+  explicit threaded_detector( unsigned tx, unsigned ty,
+                              std::string const& name = "threaded_detector" )
   : tx_( tx ),
     ty_( ty ),
+    name_( name ),
     process_border_regions_( true ),
     border_pixel_ignore_count_( 0 ),
     inner_bbox_expansion_( 0 )
   {
-    thread_count_ = tx * ty;
-
-    thread_worker_queues_= new std::queue< task_t >[ thread_count_ ];
-    thread_cond_var_ = new boost::condition_variable[ thread_count_ ];
-    thread_muti_ = new boost::mutex[ thread_count_ ];
-    thread_status_ = new thread_status[ thread_count_ ];
-
-    // Launch worker threads
-    for( unsigned id = 1; id < thread_count_; id++ )
-    {
-      thread_status_[ id ] = THREAD_WAITING;
-
-      threads_.create_thread(
-        boost::bind(
-          &self_t::worker_thread,
-          this,
-          id,
-          false
-        )
-      );
-    }
   }
 
   ~threaded_detector()
   {
-    if( thread_worker_queues_ != NULL )
-    {
-      threads_.interrupt_all();
-      threads_.join_all();
-
-      delete[] thread_worker_queues_;
-      delete[] thread_cond_var_;
-      delete[] thread_muti_;
-      delete[] thread_status_;
-    }
   }
 
   void set_function( function_t f )
@@ -121,7 +90,7 @@ public:
                        Arg5 a5 = Arg5() )
   {
     // Generate tasks
-    std::vector< task_t > tasks;
+    std::vector< compute_pool::task_t > tasks;
     std::vector< image_border > required_regions;
 
     if( border.volume() > 0 )
@@ -204,172 +173,33 @@ public:
             Arg4 a4_reg = ( a4 ? point_view_to_region( a4, subregion ) : a4 );
             Arg5 a5_reg = ( a5 ? point_view_to_region( a5, subregion ) : a5 );
 
-            tasks.push_back( task_t( func_, subregion, a1_reg, a2_reg, a3_reg, a4_reg, a5_reg ) );
+            tasks.push_back( boost::bind( func_, subregion, a1_reg, a2_reg, a3_reg, a4_reg, a5_reg ) );
           }
         }
       }
     }
 
-    // Assign tasks to threads
-    for( unsigned i = 0; i < tasks.size(); i++ )
-    {
-      thread_worker_queues_[ i % thread_count_ ].push( tasks[i] );
-    }
-
-    // Start threads
-    for( unsigned thread_id = 0; thread_id < thread_count_; thread_id++ )
-    {
-      if( thread_worker_queues_[ thread_id ].size() != 0 )
-      {
-        thread_status_[ thread_id ] = THREAD_TASKED;
-        thread_cond_var_[ thread_id ].notify_one();
-      }
-      else
-      {
-        thread_status_[ thread_id ] = THREAD_FINISHED;
-      }
-    }
-
-    // Complete all tasks assigned to group 0 on the current thread
-    worker_thread( 0, true );
-
-    // Wait for all threads to finish their jobs
-    for( unsigned thread_id = 1; thread_id < thread_count_; thread_id++ )
-    {
-      boost::unique_lock<boost::mutex> lock( this->thread_muti_[ thread_id ] );
-
-      while( thread_status_[ thread_id ] != THREAD_FINISHED )
-      {
-        thread_cond_var_[ thread_id ].timed_wait( lock, boost::posix_time::milliseconds(1000) );
-      }
-
-      thread_status_[ thread_id ] = THREAD_WAITING;
-    }
+    // Run tiles on the shared compute pool, with no more tiles in flight
+    // at once than the grid size this helper was created with
+    compute_pool::instance()->run( tasks, name_, tx_ * ty_ );
   }
 
 private:
 
-  // Function to call on each thread
+  // Function to call on each tile
   function_t func_;
 
-  // Total thread counts
+  // Tile grid dimensions
   unsigned tx_;
   unsigned ty_;
 
-  unsigned thread_count_;
+  // Caller name for compute pool statistics
+  std::string name_;
 
   // Other parameters
   bool process_border_regions_;
   int border_pixel_ignore_count_;
   int inner_bbox_expansion_;
-
-  // Thread status definition
-  enum thread_status
-  {
-    THREAD_WAITING = 0,
-    THREAD_TASKED = 1,
-    THREAD_RUNNING = 2,
-    THREAD_FINISHED = 3,
-    THREAD_TERMINATED = 4
-  };
-
-  // Thread task definition
-  class task_t
-  {
-  public:
-
-    explicit task_t( function_t& fn,
-                     image_border& rg,
-                     Arg1& a1,
-                     Arg2& a2,
-                     Arg3& a3,
-                     Arg4& a4,
-                     Arg5& a5 )
-    : fn_( fn ),
-      rg_( rg ),
-      a1_( a1 ),
-      a2_( a2 ),
-      a3_( a3 ),
-      a4_( a4 ),
-      a5_( a5 )
-    {
-    }
-
-    virtual ~task_t()
-    {
-    }
-
-    virtual void execute()
-    {
-      fn_( rg_, a1_, a2_, a3_, a4_, a5_ );
-    }
-
-    function_t fn_;
-    image_border rg_;
-    Arg1 a1_;
-    Arg2 a2_;
-    Arg3 a3_;
-    Arg4 a4_;
-    Arg5 a5_;
-  };
-
-  // Each of these will have thread_count instances
-  boost::thread_group threads_;
-  boost::condition_variable *thread_cond_var_;
-  boost::mutex *thread_muti_;
-  thread_status *thread_status_;
-  std::queue< task_t > *thread_worker_queues_;
-
-  // Worker thread main execution definition
-  void worker_thread( unsigned thread_id, bool single_exec )
-  {
-    try
-    {
-      // Get pointers to required objects
-      boost::mutex *thread_mutex = &thread_muti_[thread_id];
-      std::queue< task_t > *thread_queue = &thread_worker_queues_[thread_id];
-      boost::condition_variable *thread_cond_var = &thread_cond_var_[thread_id];
-      thread_status *current_status = &thread_status_[thread_id];
-
-      // Initiate main loop which will execute until interrupted when we are shutting down
-      while( *current_status != THREAD_TERMINATED )
-      {
-        // Wait until we have new data to process
-        {
-          boost::unique_lock<boost::mutex> lock( *thread_mutex );
-          while( *current_status != THREAD_TASKED )
-          {
-            thread_cond_var->timed_wait( lock, boost::posix_time::milliseconds(1000) );
-          }
-        }
-
-        // Update thread status
-        *current_status = THREAD_RUNNING;
-
-        while( !thread_queue->empty() )
-        {
-          // Pop an entry
-          task_t to_do = thread_queue->front();
-          thread_queue->pop();
-          to_do.execute();
-        }
-
-        // Signal that processing is complete for this thread
-        *current_status = THREAD_FINISHED;
-        thread_cond_var->notify_one();
-
-        // If running in single execute mode, exit
-        if( single_exec )
-        {
-          break;
-        }
-      }
-    }
-    catch( boost::thread_interrupted const& )
-    {
-      // Shutdown gracefully
-    }
-  }
 };
 
 }
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -119,9 +119,9 @@ async_pipeline
   for( citr it = execution_order().begin(); it != execution_order().end(); ++it )
   {
     async_pipeline_node* node = dynamic_cast<async_pipeline_node*>(*it);
-    if( node->step_count_ > this->total_step_count_ )
+    if( node->step_count() > this->total_step_count_ )
     {
-      this->total_step_count_ = node->step_count_;
+      this->total_step_count_ = node->step_count();
     }
   }
 
@@ -328,9 +328,9 @@ async_pipeline
         {
           parent->set_last_execute_to_skip();
           ++this->total_step_count_;
-          ++parent->step_count_;
+          parent->increment_step_count();
           double t = timer.real();
-          parent->elapsed_ms_ += t;
+          parent->add_elapsed_ms( t );
           this->total_elapsed_ms_ += t;
           return true;
         }
@@ -388,7 +388,7 @@ async_pipeline
       }
     }
     ++this->total_step_count_;
-    ++parent->step_count_;
+    parent->increment_step_count();
   }
 
   // interrupt all running threads
@@ -412,7 +412,7 @@ async_pipeline
   }
 
   double t = timer.real();
-  parent->elapsed_ms_ += t;
+  parent->add_elapsed_ms( t );
   this->total_elapsed_ms_ += t;
 
   // send out the final FAILURE message to the downstream nodes
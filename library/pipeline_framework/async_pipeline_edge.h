@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -100,6 +100,12 @@ struct async_pipeline_edge_impl
   /// Pull the data from the source node and add push it into the async queue.
   virtual void pull_data()
   {
+    if( !this->implies_execution_dependency_ )
+    {
+      pull_feedback_data();
+      return;
+    }
+
     {
       boost::unique_lock<boost::mutex> lock(this->mut);
       if( this->from_node_last_execute_state() == process::FLUSH )
@@ -123,9 +129,59 @@ struct async_pipeline_edge_impl
   }
 
 
+  /// \brief Queue the output of the source node of a feedback edge.
+  ///
+  /// An edge without an execution dependency usually carries data from a
+  /// node back to one of the nodes it depends on, so neither end may wait
+  /// for the other. Only data is queued; the sink node receives control
+  /// statuses through its other inputs. When the queue is full the oldest
+  /// data is dropped.
+  void pull_feedback_data()
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(this->mut);
+      if( this->from_node_last_execute_state() == process::SUCCESS )
+      {
+        if( this->max_queue_size != 0 && this->status_queue_.size() > this->max_queue_size )
+        {
+          this->status_queue_.pop_back();
+          this->data_queue_.pop_back();
+        }
+        this->status_queue_.push_front( process::SUCCESS );
+        this->data_queue_.push_front( this->get_output_() );
+      }
+      last_size = this->status_queue_.size();
+    }
+    this->cond_data_available.notify_one();
+  }
+
+  /// \brief Pass the oldest queued data of a feedback edge to the sink node.
+  ///
+  /// Does not wait when no data is queued, and always succeeds.
+  process::step_status push_feedback_data()
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(this->mut);
+      if( !this->status_queue_.empty() )
+      {
+        this->status_queue_.pop_back();
+        this->last_data = this->data_queue_.back();
+        this->data_queue_.pop_back();
+        this->set_input_( this->last_data );
+      }
+      last_size = this->status_queue_.size();
+    }
+    return process::SUCCESS;
+  }
+
   /// Pop data from the async queue and push the data to the sink node.
   virtual process::step_status push_data()
   {
+    if( !this->implies_execution_dependency_ )
+    {
+      return push_feedback_data();
+    }
+
     process::step_status status;
     {
       boost::unique_lock<boost::mutex> lock(this->mut);
@@ -167,6 +223,12 @@ struct async_pipeline_edge_impl
       LOG_ERROR("Failed to reset edge with running downstream node " << to->name() );
       return false;
     }
+    if( !this->implies_execution_dependency_ )
+    {
+      // Feedback edges are not drained at the end of a run.
+      this->status_queue_.clear();
+      this->data_queue_.clear();
+    }
     if( this->status_queue_.size() > 0 || this->data_queue_.size() > 0 )
     {
       LOG_ERROR("During reset of edge, edge queue length non-zero" );
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -234,9 +234,10 @@ async_pipeline_node
     // for future inputs at the same time, we must wait until we have received
     // the flush command on all incoming edges. We know that we have already
     // received a flush command for the iterator it.
+    // Feedback edges never carry a flush, so they are skipped.
     for( itr it2 = incoming_edges_.begin(); it2 != incoming_edges_.end(); ++it2 )
     {
-      if( it2 != it )
+      if( it2 != it && (*it2)->implies_execution_dependency_ )
       {
         while( (*it2)->push_data() != process::FLUSH );
       }
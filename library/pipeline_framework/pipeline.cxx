@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -674,7 +674,8 @@ pipeline
   }
 
   // We've added a node or a connection, so (re)determine which nodes
-  // are sink nodes.
+  // are sink nodes.  Feedback connections, which carry no execution
+  // dependency, don't count.
   for( node_itr it = insert_order_.begin(); it != insert_order_.end(); ++it )
   {
     (*it)->is_sink_node_ = true;
@@ -688,7 +689,10 @@ pipeline
          eit != node->incoming_edges_.end(); ++eit )
     {
       pipeline_edge* e = *eit;
-      e->from_->is_sink_node_ = false;
+      if( e->implies_execution_dependency_ )
+      {
+        e->from_->is_sink_node_ = false;
+      }
     }
   }
 
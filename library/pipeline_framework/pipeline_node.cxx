@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -90,15 +90,77 @@ pipeline_node
 
 }
 
+pipeline_node
+::pipeline_node( pipeline_node const& other )
+  : id_( other.id_ ),
+    process_( other.process_ ),
+    name_( other.name_ ),
+    type_( other.type_ ),
+    execute_( other.execute_ ),
+    skipped_( other.skipped_ ),
+    recover_( other.recover_ ),
+    params_( other.params_ ),
+    set_params_( other.set_params_ ),
+    initialize_( other.initialize_ ),
+    incoming_edges_( other.incoming_edges_ ),
+    outgoing_edges_( other.outgoing_edges_ ),
+    connected_inputs_( other.connected_inputs_ ),
+    last_execute_state_( other.last_execute_state_ ),
+    is_sink_node_( other.is_sink_node_ ),
+    is_output_node_( other.is_output_node_ ),
+    elapsed_ms_( other.elapsed_ms() ),
+    step_count_( other.step_count() ),
+    m_event( other.m_event ),
+    is_executable_( other.is_executable_ )
+{
+}
+
 
 double
 pipeline_node
 ::steps_per_second() const
 {
+  boost::unique_lock<boost::mutex> lock( stats_mut_ );
   return double(step_count_)*1000.0 / elapsed_ms_;
 }
 
 
+double
+pipeline_node
+::elapsed_ms() const
+{
+  boost::unique_lock<boost::mutex> lock( stats_mut_ );
+  return elapsed_ms_;
+}
+
+
+unsigned long
+pipeline_node
+::step_count() const
+{
+  boost::unique_lock<boost::mutex> lock( stats_mut_ );
+  return step_count_;
+}
+
+
+void
+pipeline_node
+::increment_step_count()
+{
+  boost::unique_lock<boost::mutex> lock( stats_mut_ );
+  ++step_count_;
+}
+
+
+void
+pipeline_node
+::add_elapsed_ms( double ms )
+{
+  boost::unique_lock<boost::mutex> lock( stats_mut_ );
+  elapsed_ms_ += ms;
+}
+
+
 bool
 pipeline_node
 ::is_output_node() const
@@ -134,7 +196,7 @@ pipeline_node
 ::execute()
 {
   vul_timer t;
-  ++step_count_;
+  this->increment_step_count();
 
   if( execute_ )
   {
@@ -166,7 +228,7 @@ pipeline_node
     last_execute_state_ = process::SUCCESS;
   }
 
-  elapsed_ms_ += t.real();
+  this->add_elapsed_ms( t.real() );
 
   return last_execute_state_;
 }
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -8,6 +8,7 @@
 #define vidtk_pipeline_node_h_
 
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <pipeline_framework/pipeline_edge.h>
 #include <process_framework/process.h>
@@ -44,6 +45,8 @@ public:
 
   pipeline_node( process::pointer p );
 
+  pipeline_node( pipeline_node const& other );
+
   virtual ~pipeline_node(){};
 
   pipeline_node& set_execute_func( execute_function_type const& f )
@@ -128,6 +131,16 @@ public:
 
   double steps_per_second() const;
 
+  /// Total time, in milliseconds, spent executing this node.
+  ///
+  /// Safe to call while the node is executing on another thread.
+  double elapsed_ms() const;
+
+  /// Total number of times this node has been executed.
+  ///
+  /// Safe to call while the node is executing on another thread.
+  unsigned long step_count() const;
+
   bool is_output_node() const;
 
   config_block get_params() const;
@@ -175,6 +188,10 @@ protected:
 
   void set_print_detailed_report( bool print );
 
+  /// Update the execution statistics, which may be read concurrently.
+  void increment_step_count();
+  void add_elapsed_ms( double ms );
+
 private:
   void append_params( config_block& all_params );
 
@@ -207,8 +224,10 @@ protected:
   enum ternary_value_type { UNKNOWN, YES, NO };
   ternary_value_type is_output_node_;
 
+  /// Execution statistics, guarded by stats_mut_.
   double elapsed_ms_;
   unsigned long step_count_;
+  mutable boost::mutex stats_mut_;
 
   static unsigned unnamed_count_;
   RightTrack::BoundedEvent * m_event;
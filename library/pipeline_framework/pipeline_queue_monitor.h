@@ -46,6 +46,12 @@ public:
   /// \brief Reset the list of nodes this class is monitoring
   virtual void reset();
 
+  /// \brief Returns the list of all currently monitored nodes.
+  const std::vector< const pipeline_node* >& monitored_nodes() const
+  {
+    return nodes_to_monitor_;
+  }
+
 private:
 
   std::vector< const pipeline_node* > nodes_to_monitor_;
@@ -59,6 +59,11 @@ public:
   void set_metadata( vidtk::video_metadata const& );
   VIDTK_INPUT_PORT( set_metadata, vidtk::video_metadata const& );
 
+  /// Optional native luma plane of the input image, see
+  /// generic_frame_process::luma_image().
+  void set_luma_image( vil_image_view< PixType > const& );
+  VIDTK_OPTIONAL_INPUT_PORT( set_luma_image, vil_image_view< PixType > const& );
+
   vil_image_view< PixType > original_image() const;
   VIDTK_OUTPUT_PORT( vil_image_view< PixType >, original_image );
 
@@ -74,6 +79,11 @@ public:
   vidtk::video_metadata metadata() const;
   VIDTK_OUTPUT_PORT( vidtk::video_metadata, metadata );
 
+  /// The processing quality tier used for the current frame, where 0 is
+  /// full quality. Always 0 unless the quality governor is enabled.
+  unsigned quality_tier() const;
+  VIDTK_OUTPUT_PORT( unsigned, quality_tier );
+
 private:
 
   remove_burnin_pipeline_impl< PixType >* impl_;
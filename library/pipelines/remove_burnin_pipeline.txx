@@ -23,6 +23,8 @@
 #include <pipeline_framework/sync_pipeline.h>
 #include <pipeline_framework/async_pipeline.h>
 
+#include <utilities/quality_governor_process.h>
+
 #include <boost/lexical_cast.hpp>
 
 #include <logger/logger.h>
@@ -43,18 +45,22 @@ public:
   typedef super_process_pad_impl< vil_image_view< bool > > pad_mask_t;
   typedef super_process_pad_impl< timestamp > pad_timestamp_t;
   typedef super_process_pad_impl< video_metadata > pad_metadata_t;
+  typedef super_process_pad_impl< unsigned > pad_tier_t;
 
   process_smart_pointer< pad_image_t > pad_source_image;
   process_smart_pointer< pad_timestamp_t > pad_source_timestamp;
   process_smart_pointer< pad_metadata_t > pad_source_metadata;
+  process_smart_pointer< pad_image_t > pad_source_luma_image;
 
   process_smart_pointer< pad_image_t > pad_output_original_image;
   process_smart_pointer< pad_image_t > pad_output_inpainted_image;
   process_smart_pointer< pad_mask_t > pad_output_mask;
   process_smart_pointer< pad_timestamp_t > pad_output_timestamp;
   process_smart_pointer< pad_metadata_t > pad_output_metadata;
+  process_smart_pointer< pad_tier_t > pad_output_tier;
 
   process_smart_pointer< generic_frame_process< PixType > > proc_source;
+  process_smart_pointer< quality_governor_process > proc_governor;
   process_smart_pointer< metadata_mask_super_process< PixType > > proc_mask_sp;
   process_smart_pointer< image_list_writer_process< bool > > proc_mask_writer;
   process_smart_pointer< stabilization_super_process< PixType > > proc_stab_sp;
@@ -70,6 +76,8 @@ public:
   unsigned default_edge_capacity;
   unsigned output_pad_edge_capacity;
 
+  vil_image_view< PixType > input_luma_image;
+
   remove_burnin_pipeline_impl()
   : detection_factory( "detector_sp" ),
     default_edge_capacity( 10 ),
@@ -78,12 +86,14 @@ public:
     pad_source_image = new pad_image_t( "source_image_pad" );
     pad_source_timestamp = new pad_timestamp_t( "source_timestamp_pad" );
     pad_source_metadata = new pad_metadata_t( "source_metadata_pad" );
+    pad_source_luma_image = new pad_image_t( "source_luma_image_pad" );
 
     pad_output_original_image = new pad_image_t( "output_original_image_pad" );
     pad_output_inpainted_image = new pad_image_t( "output_inpainted_image_pad" );
     pad_output_mask = new pad_mask_t( "output_mask_pad" );
     pad_output_timestamp = new pad_timestamp_t( "output_timestamp_pad" );
     pad_output_metadata = new pad_metadata_t( "output_metadata_pad" );
+    pad_output_tier = new pad_tier_t( "output_tier_pad" );
 
     proc_mask_sp = new metadata_mask_super_process< PixType >( "md_mask_sp" );
     config.add_subblock( proc_mask_sp->params(), proc_mask_sp->name() );
@@ -102,6 +112,9 @@ public:
     proc_inpainted_writer = new image_list_writer_process< PixType >( "inpainted_writer" );
     config.add_subblock( proc_inpainted_writer->params(), proc_inpainted_writer->name() );
 
+    proc_governor = new quality_governor_process( "governor" );
+    config.add_subblock( proc_governor->params(), proc_governor->name() );
+
     default_config.add_parameter( proc_stab_sp->name() + ":masking_enabled", "true", "" );
     default_config.add_parameter( proc_stab_sp->name() + ":masking_source", "external", "" );
     default_config.add_parameter( proc_mask_writer->name() + ":disabled", "true", "" );
@@ -111,6 +124,7 @@ public:
     default_config.add_parameter( detection_factory.name() + ":run_async", "true", "" );
     default_config.add_parameter( detection_factory.name() + ":masking_enabled", "true", "" );
     default_config.add_parameter( detection_factory.name() + ":gui_feedback_enabled", "true", "" );
+    default_config.add_parameter( proc_governor->name() + ":nodes_to_monitor", "md_mask_sp inpainter", "" );
     config.update( default_config );
   }
 
@@ -124,6 +138,7 @@ public:
   {
     // Add all input pads
     p->add( pad_source_image );
+    p->add( pad_source_luma_image );
     p->add( pad_source_timestamp );
     p->add( pad_source_metadata );
 
@@ -133,8 +148,10 @@ public:
     p->add( pad_output_mask );
     p->add( pad_output_timestamp );
     p->add( pad_output_metadata );
+    p->add( pad_output_tier );
 
     // Add all processes
+    p->add( proc_governor );
     p->add( proc_mask_sp );
     p->add( proc_inpainter );
 
@@ -147,6 +164,8 @@ public:
     // Pass images through pipeline
     p->connect( pad_source_image->value_port(),
                 proc_mask_sp->set_image_port() );
+    p->connect( pad_source_luma_image->value_port(),
+                proc_mask_sp->set_source_luma_image_port() );
     p->connect( proc_mask_sp->image_port(),
                 proc_inpainter->set_source_image_port() );
     p->connect( proc_mask_sp->timestamp_port(),
@@ -161,6 +180,15 @@ public:
     p->connect( proc_inpainter->inpainted_image_port(),
                 pad_output_inpainted_image->set_value_port() );
 
+    // Select a quality tier for each frame and pass it to all processes
+    // which support reduced quality modes
+    p->connect( pad_source_timestamp->value_port(),
+                proc_governor->set_timestamp_port() );
+    p->connect( proc_governor->quality_tier_port(),
+                proc_mask_sp->set_quality_tier_port() );
+    p->connect( proc_governor->quality_tier_port(),
+                proc_inpainter->set_quality_tier_port() );
+
     // Connect auxiliary output ports
     p->set_edge_capacity( output_pad_edge_capacity );
     p->connect( proc_mask_sp->image_port(),
@@ -171,6 +199,8 @@ public:
                 pad_output_metadata->set_value_port() );
     p->connect( proc_mask_sp->mask_port(),
                 pad_output_mask->set_value_port() );
+    p->connect( proc_governor->quality_tier_port(),
+                pad_output_tier->set_value_port() );
     p->set_edge_capacity( default_edge_capacity );
 
     // Add optional stabilization processes
@@ -192,6 +222,11 @@ public:
       p->connect( proc_stab_sp->get_output_shot_break_flags_port(),
                   proc_inpainter->set_shot_break_flags_port() );
 
+      // The mask super process runs before stabilization, so it receives
+      // the shot break flags of the previous frame.
+      p->connect_without_dependency( proc_stab_sp->get_output_shot_break_flags_port(),
+                                     proc_mask_sp->set_shot_break_flags_port() );
+
       if( config.get< bool >( "use_motion" ) )
       {
         // Optionally detect a motion mask and connect it to the inpainter
@@ -328,6 +363,11 @@ remove_burnin_pipeline< PixType >
     {
       throw config_block_parse_error( "Unable to set pipeline parameters." );
     }
+
+    if( !impl_->proc_governor->set_pipeline_to_monitor( pipeline_.ptr() ) )
+    {
+      throw config_block_parse_error( "Unable to find quality governor nodes." );
+    }
   }
   catch( const config_block_parse_error& e )
   {
@@ -344,6 +384,9 @@ process::step_status
 remove_burnin_pipeline< PixType >
 ::step2()
 {
+  impl_->pad_source_luma_image->set_value( impl_->input_luma_image );
+  impl_->input_luma_image = vil_image_view< PixType >();
+
   return this->pipeline_->execute();
 }
 
@@ -384,6 +427,15 @@ remove_burnin_pipeline< PixType >
 }
 
 
+template < class PixType >
+void
+remove_burnin_pipeline< PixType >
+::set_luma_image( vil_image_view< PixType > const& img )
+{
+  impl_->input_luma_image = img;
+}
+
+
 template< class PixType >
 vil_image_view< PixType >
 remove_burnin_pipeline< PixType >
@@ -428,4 +480,13 @@ remove_burnin_pipeline< PixType >
   return this->impl_->pad_output_metadata->value();
 }
 
+
+template< class PixType >
+unsigned
+remove_burnin_pipeline< PixType >
+::quality_tier() const
+{
+  return this->impl_->pad_output_tier->value();
+}
+
 }
@@ -44,6 +44,7 @@ homography_process
     good_thresh_sqr_( 3*3 ),
     current_ts_(NULL),
     ransam_( NULL ),
+    use_parallel_ransac_( false ),
     initialized_( false ),
     unusable_frame_( false ),
     track_tail_length_( 0 )
@@ -68,6 +69,24 @@ homography_process
     "When the tails are not trimmed, process memory growth is unbounded and becomes a problem with "
     "extremely long shots. The only reason to keep track tails at all is to allow the GUI to "
     "display them." );
+
+  config_.add_parameter( "homography_estimator", "rrel",
+    "Method used to estimate the homography from the tracked points. \"rrel\" "
+    "uses rrel random sampling followed by IRLS refinement. \"parallel_ransac\" "
+    "uses an adaptive RANSAC which samples the oldest tracks first (PROSAC), "
+    "scores hypotheses in parallel and refits to the inliers with least squares. "
+    "It is considerably faster with many tracks." );
+
+  config_.add_parameter( "ransac_inlier_threshold", "2.0",
+    "parallel_ransac: largest error, in pixels of the reference frame, of a "
+    "point consistent with the homography." );
+
+  config_.add_parameter( "ransac_confidence", "0.99",
+    "parallel_ransac: required probability that an outlier free sample is drawn. "
+    "Sampling stops as soon as this is reached." );
+
+  config_.add_parameter( "ransac_max_iterations", "1000",
+    "parallel_ransac: largest number of samples drawn." );
 }
 
 
@@ -103,6 +122,27 @@ homography_process
       this->track_tail_length_ = 3;
     }
     img0_to_world_H_.set_transform( homography::transform_t( m ) );
+
+    std::string estimator = blk.get< std::string > ( "homography_estimator" );
+    if ( estimator == "parallel_ransac" )
+    {
+      use_parallel_ransac_ = true;
+    }
+    else if ( estimator == "rrel" )
+    {
+      use_parallel_ransac_ = false;
+    }
+    else
+    {
+      throw config_block_parse_error( "unknown homography_estimator \"" + estimator +
+                                      "\". Options are: rrel, parallel_ransac" );
+    }
+
+    ransac_homography_params rp;
+    rp.inlier_threshold = blk.get< double > ( "ransac_inlier_threshold" );
+    rp.confidence = blk.get< double > ( "ransac_confidence" );
+    rp.max_iterations = blk.get< unsigned > ( "ransac_max_iterations" );
+    ransac_.set_params( rp );
   }
   catch ( config_block_parse_error const& e )
   {
@@ -201,6 +241,7 @@ homography_process
 
   std::vector< vnl_vector<double> > from_pts;
   std::vector< vnl_vector<double> > to_pts;
+  std::vector< unsigned > ages;
   int drop_count(0);
   int total_count(0);
 
@@ -236,6 +277,8 @@ homography_process
         p[0] = wld[0];
         p[1] = wld[1];
         to_pts.push_back( p );
+
+        ages.push_back( it->age_ );
       }
     }
   }
@@ -284,44 +327,11 @@ homography_process
   }
 
 
-  // Step 2: estimate the homography using sampling.  This will allow
-  // a good rejection of outliers.
-  rrel_homography2d_est hg( from_pts, to_pts );
-
-  rrel_trunc_quad_obj msac;
-  ransam_->set_trace_level(0);
-
-  bool result = ransam_->estimate( &hg, &msac );
-
-  if ( ! result )
-  {
-    LOG_ERROR( name() << ": MSAC failed!!");
-  }
-  else
-  {
-    // Step 3: refine the estimate using weighted least squares.  This
-    // will allow us to estimate a homography that does not exactly
-    // fit 4 points, which will be a better estimate.  The ransam
-    // estimate from step 2 would have gotten us close enough to the
-    // correct solution for IRLS to work.
-    rrel_irls irls;
-    irls.initialize_params( ransam_->params() );
-    bool result2 = irls.estimate( &hg, &msac );
-    if( ! result2 )
-    {
-      // if the IRLS fails, fall back to the ransam estimate.
-      LOG_WARN( name() << ": IRLS failed");
-      vnl_double_3x3 m;
-      hg.params_to_homog( ransam_->params(), m.as_ref().non_const() );
-      img_to_img0_H_.set_transform( homography::transform_t(m) );
-    }
-    else
-    {
-      vnl_double_3x3 m;
-      hg.params_to_homog( irls.params(), m.as_ref().non_const() );
-      img_to_img0_H_.set_transform( homography::transform_t(m) );
-    }
-  }
+  // Step 2: estimate the homography using sampling, which rejects
+  // outliers, then refine it with (weighted) least squares.
+  bool result = ( use_parallel_ransac_
+                  ? estimate_with_ransac( from_pts, to_pts, ages )
+                  : estimate_with_rrel( from_pts, to_pts ) );
 
   if( refine_geometric_error_ && result )
   {
@@ -410,6 +420,104 @@ homography_process
 }
 
 
+// ----------------------------------------------------------------
+/** Estimate img_to_img0_H_ with rrel.
+ *
+ *
+ */
+bool
+homography_process
+::estimate_with_rrel( std::vector< vnl_vector<double> > const& from_pts,
+                      std::vector< vnl_vector<double> > const& to_pts )
+{
+  rrel_homography2d_est hg( from_pts, to_pts );
+
+  rrel_trunc_quad_obj msac;
+  ransam_->set_trace_level(0);
+
+  bool result = ransam_->estimate( &hg, &msac );
+
+  if ( ! result )
+  {
+    LOG_ERROR( name() << ": MSAC failed!!");
+  }
+  else
+  {
+    // Step 3: refine the estimate using weighted least squares.  This
+    // will allow us to estimate a homography that does not exactly
+    // fit 4 points, which will be a better estimate.  The ransam
+    // estimate from step 2 would have gotten us close enough to the
+    // correct solution for IRLS to work.
+    rrel_irls irls;
+    irls.initialize_params( ransam_->params() );
+    bool result2 = irls.estimate( &hg, &msac );
+    if( ! result2 )
+    {
+      // if the IRLS fails, fall back to the ransam estimate.
+      LOG_WARN( name() << ": IRLS failed");
+      vnl_double_3x3 m;
+      hg.params_to_homog( ransam_->params(), m.as_ref().non_const() );
+      img_to_img0_H_.set_transform( homography::transform_t(m) );
+    }
+    else
+    {
+      vnl_double_3x3 m;
+      hg.params_to_homog( irls.params(), m.as_ref().non_const() );
+      img_to_img0_H_.set_transform( homography::transform_t(m) );
+    }
+  }
+
+  return result;
+}
+
+
+// ----------------------------------------------------------------
+/** Estimate img_to_img0_H_ with the parallel RANSAC estimator.
+ *
+ * The correspondences are ordered from the oldest to the youngest
+ * track, since tracks which have survived longer are more likely to
+ * be on the ground plane.
+ */
+bool
+homography_process
+::estimate_with_ransac( std::vector< vnl_vector<double> > const& from_pts,
+                        std::vector< vnl_vector<double> > const& to_pts,
+                        std::vector< unsigned > const& ages )
+{
+  std::vector< std::pair< unsigned, unsigned > > order( ages.size() );
+  for( unsigned i = 0; i < ages.size(); ++i )
+  {
+    // Complement the age for a descending sort; ties keep the track order
+    order[i] = std::make_pair( ~ages[i], i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  std::vector< vnl_double_2 > from( order.size() );
+  std::vector< vnl_double_2 > to( order.size() );
+  for( unsigned i = 0; i < order.size(); ++i )
+  {
+    vnl_vector<double> const& f = from_pts[ order[i].second ];
+    vnl_vector<double> const& t = to_pts[ order[i].second ];
+    from[i] = vnl_double_2( f[0], f[1] );
+    to[i] = vnl_double_2( t[0], t[1] );
+  }
+
+  vnl_double_3x3 m;
+  if( ! ransac_.estimate( from, to, m ) )
+  {
+    LOG_ERROR( name() << ": RANSAC failed!!");
+    return false;
+  }
+
+  LOG_DEBUG( name() << ": RANSAC found " << ransac_.inlier_count() << " inliers of "
+             << from.size() << " points with " << ransac_.hypotheses_evaluated()
+             << " hypotheses" );
+
+  img_to_img0_H_.set_transform( homography::transform_t(m) );
+  return true;
+}
+
+
 void
 homography_process
 ::set_timestamp( timestamp const & ts )
@@ -672,6 +780,7 @@ homography_process
     {
       live_tracks.push_back( *end_teis ); // add this track to the list
       live_tracks.rbegin()->track_ = *it; // update
+      live_tracks.rbegin()->age_++;
 
       // Trim tracks here so they do not grow too long
       if ( this->track_tail_length_ > 0 ) // do not trim if length set to zero
@@ -690,6 +799,7 @@ homography_process
     tei.track_ = *it;
     tei.have_img0_loc_ = false;
     tei.good_ = true;
+    tei.age_ = 0;
 
     live_tracks.push_back( tei );
   }
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -10,12 +10,14 @@
 #include <kwklt/klt_track.h>
 
 #include <vector>
+#include <vnl/vnl_vector.h>
 #include <vil/vil_image_view.h>
 #include <vgl/algo/vgl_h_matrix_2d.h>
 #include <process_framework/process.h>
 #include <process_framework/pipeline_aid.h>
 //#include <rrel/rrel_ran_sam_search.h>
 #include <utilities/homography.h>
+#include <tracking/ransac_homography.h>
 class rrel_ran_sam_search;
 
 namespace vidtk
@@ -44,6 +46,10 @@ public:
     // Combining track with info for a compact vector representation
     // instead of map
     klt_track_ptr track_;
+
+    // Number of frames this track has been followed. Older tracks are
+    // considered more reliable when sampling correspondences.
+    unsigned age_;
   };
 
   homography_process( std::string const& name );
@@ -135,6 +141,12 @@ private:
   /// Refine the estimate to minimize the geometric error.
   void lmq_refine_homography();
 
+  bool estimate_with_rrel( std::vector< vnl_vector<double> > const& from_pts,
+                           std::vector< vnl_vector<double> > const& to_pts );
+  bool estimate_with_ransac( std::vector< vnl_vector<double> > const& from_pts,
+                             std::vector< vnl_vector<double> > const& to_pts,
+                             std::vector< unsigned > const& ages );
+
   void set_img0_locations();
   void set_good_flags();
 
@@ -164,6 +176,10 @@ private:
 
   rrel_ran_sam_search * ransam_;
 
+  // Use the native parallel RANSAC estimator instead of rrel
+  bool use_parallel_ransac_;
+  ransac_homography_estimator ransac_;
+
   // If the process is retained across two calls on intialize(), then
   // we only want to "initialize" only the first time.
   bool initialized_;
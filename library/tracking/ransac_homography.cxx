@@ -0,0 +1,731 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "ransac_homography.h"
+
+#include <utilities/compute_pool.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_random.h>
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if VIDTK_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// Number of points in a minimal sample
+const unsigned sample_size = 4;
+
+// Number of points scored between checks for abandoning a hypothesis
+const unsigned score_block = 64;
+
+// Smallest number of point evaluations in a batch worth running in parallel
+const unsigned min_parallel_work = 16384;
+
+// Smallest area of a sample triangle, in normalized coordinates
+const double min_triangle_area = 1e-5;
+
+
+// Similarity transform moving the centroid to the origin and scaling
+// the mean distance from it to sqrt(2).
+struct normalization
+{
+  void compute( std::vector< vnl_double_2 > const& pts )
+  {
+    cx = 0.0;
+    cy = 0.0;
+    for( unsigned i = 0; i < pts.size(); ++i )
+    {
+      cx += pts[i][0];
+      cy += pts[i][1];
+    }
+    cx /= pts.size();
+    cy /= pts.size();
+
+    double dist = 0.0;
+    for( unsigned i = 0; i < pts.size(); ++i )
+    {
+      dist += std::sqrt( ( pts[i][0] - cx ) * ( pts[i][0] - cx ) +
+                         ( pts[i][1] - cy ) * ( pts[i][1] - cy ) );
+    }
+    dist /= pts.size();
+
+    scale = ( dist > 0.0 ? std::sqrt( 2.0 ) / dist : 1.0 );
+  }
+
+  void apply( std::vector< vnl_double_2 > const& pts,
+              std::vector< double >& x, std::vector< double >& y ) const
+  {
+    x.resize( pts.size() );
+    y.resize( pts.size() );
+    for( unsigned i = 0; i < pts.size(); ++i )
+    {
+      x[i] = scale * ( pts[i][0] - cx );
+      y[i] = scale * ( pts[i][1] - cy );
+    }
+  }
+
+  double cx;
+  double cy;
+  double scale;
+};
+
+
+// Twice the signed area of the triangle (a, b, c).
+inline double
+triangle_area( double const* x, double const* y,
+               unsigned a, unsigned b, unsigned c )
+{
+  return ( x[b] - x[a] ) * ( y[c] - y[a] ) - ( y[b] - y[a] ) * ( x[c] - x[a] );
+}
+
+
+// A sample can only come from a homography of a real scene if no three
+// points are collinear and every triangle keeps its orientation.
+bool
+sample_is_valid( double const* fx, double const* fy,
+                 double const* tx, double const* ty,
+                 unsigned const* idx )
+{
+  static const unsigned triples[4][3] = { {0,1,2}, {0,1,3}, {0,2,3}, {1,2,3} };
+
+  for( unsigned t = 0; t < 4; ++t )
+  {
+    unsigned a = idx[ triples[t][0] ];
+    unsigned b = idx[ triples[t][1] ];
+    unsigned c = idx[ triples[t][2] ];
+
+    double from_area = triangle_area( fx, fy, a, b, c );
+    double to_area = triangle_area( tx, ty, a, b, c );
+
+    if( std::fabs( from_area ) < min_triangle_area ||
+        std::fabs( to_area ) < min_triangle_area ||
+        ( from_area > 0.0 ) != ( to_area > 0.0 ) )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// Solve for the homography (with h[8] = 1) exactly mapping four points,
+// by Gaussian elimination with partial pivoting.
+bool
+solve_minimal( double const* fx, double const* fy,
+               double const* tx, double const* ty,
+               unsigned const* idx, double* h )
+{
+  double a[8][9];
+
+  for( unsigned k = 0; k < sample_size; ++k )
+  {
+    double x = fx[ idx[k] ];
+    double y = fy[ idx[k] ];
+    double X = tx[ idx[k] ];
+    double Y = ty[ idx[k] ];
+
+    double* r0 = a[ 2 * k ];
+    double* r1 = a[ 2 * k + 1 ];
+
+    r0[0] = x;   r0[1] = y;   r0[2] = 1.0;
+    r0[3] = 0.0; r0[4] = 0.0; r0[5] = 0.0;
+    r0[6] = -x * X; r0[7] = -y * X; r0[8] = X;
+
+    r1[0] = 0.0; r1[1] = 0.0; r1[2] = 0.0;
+    r1[3] = x;   r1[4] = y;   r1[5] = 1.0;
+    r1[6] = -x * Y; r1[7] = -y * Y; r1[8] = Y;
+  }
+
+  for( unsigned c = 0; c < 8; ++c )
+  {
+    unsigned pivot = c;
+    for( unsigned r = c + 1; r < 8; ++r )
+    {
+      if( std::fabs( a[r][c] ) > std::fabs( a[pivot][c] ) )
+      {
+        pivot = r;
+      }
+    }
+
+    if( std::fabs( a[pivot][c] ) < 1e-12 )
+    {
+      return false;
+    }
+
+    if( pivot != c )
+    {
+      for( unsigned k = c; k < 9; ++k )
+      {
+        std::swap( a[c][k], a[pivot][k] );
+      }
+    }
+
+    for( unsigned r = c + 1; r < 8; ++r )
+    {
+      double f = a[r][c] / a[c][c];
+      for( unsigned k = c; k < 9; ++k )
+      {
+        a[r][k] -= f * a[c][k];
+      }
+    }
+  }
+
+  for( int r = 7; r >= 0; --r )
+  {
+    double sum = a[r][8];
+    for( unsigned k = r + 1; k < 8; ++k )
+    {
+      sum -= a[r][k] * h[k];
+    }
+    h[r] = sum / a[r][r];
+  }
+  h[8] = 1.0;
+
+  for( unsigned k = 0; k < 9; ++k )
+  {
+    if( ! ( std::fabs( h[k] ) < std::numeric_limits< double >::max() ) )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// Truncated quadratic transfer error of points [begin,end). Points
+// mapped behind the camera (w <= 0) are outliers.
+void
+score_points( double const* h,
+              double const* fx, double const* fy,
+              double const* tx, double const* ty,
+              unsigned begin, unsigned end, double thresh_sqr,
+              double& cost, unsigned& inliers )
+{
+  unsigned i = begin;
+
+#if VIDTK_SSE2
+  __m128d const h0 = _mm_set1_pd( h[0] );
+  __m128d const h1 = _mm_set1_pd( h[1] );
+  __m128d const h2 = _mm_set1_pd( h[2] );
+  __m128d const h3 = _mm_set1_pd( h[3] );
+  __m128d const h4 = _mm_set1_pd( h[4] );
+  __m128d const h5 = _mm_set1_pd( h[5] );
+  __m128d const h6 = _mm_set1_pd( h[6] );
+  __m128d const h7 = _mm_set1_pd( h[7] );
+  __m128d const h8 = _mm_set1_pd( h[8] );
+  __m128d const thr = _mm_set1_pd( thresh_sqr );
+  __m128d const zero = _mm_setzero_pd();
+  __m128d acc = _mm_setzero_pd();
+
+  for( ; i + 2 <= end; i += 2 )
+  {
+    __m128d x = _mm_loadu_pd( fx + i );
+    __m128d y = _mm_loadu_pd( fy + i );
+
+    __m128d u = _mm_add_pd( _mm_add_pd( _mm_mul_pd( h0, x ), _mm_mul_pd( h1, y ) ), h2 );
+    __m128d v = _mm_add_pd( _mm_add_pd( _mm_mul_pd( h3, x ), _mm_mul_pd( h4, y ) ), h5 );
+    __m128d w = _mm_add_pd( _mm_add_pd( _mm_mul_pd( h6, x ), _mm_mul_pd( h7, y ) ), h8 );
+
+    __m128d dx = _mm_sub_pd( _mm_div_pd( u, w ), _mm_loadu_pd( tx + i ) );
+    __m128d dy = _mm_sub_pd( _mm_div_pd( v, w ), _mm_loadu_pd( ty + i ) );
+    __m128d r2 = _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) );
+
+    __m128d ok = _mm_and_pd( _mm_cmpgt_pd( w, zero ), _mm_cmplt_pd( r2, thr ) );
+    acc = _mm_add_pd( acc, _mm_or_pd( _mm_and_pd( ok, r2 ), _mm_andnot_pd( ok, thr ) ) );
+
+    int mask = _mm_movemask_pd( ok );
+    inliers += ( mask & 1 ) + ( mask >> 1 );
+  }
+
+  double lanes[2];
+  _mm_storeu_pd( lanes, acc );
+  cost += lanes[0] + lanes[1];
+#endif
+
+  for( ; i < end; ++i )
+  {
+    double w = h[6] * fx[i] + h[7] * fy[i] + h[8];
+    double dx = ( h[0] * fx[i] + h[1] * fy[i] + h[2] ) / w - tx[i];
+    double dy = ( h[3] * fx[i] + h[4] * fy[i] + h[5] ) / w - ty[i];
+    double r2 = dx * dx + dy * dy;
+
+    if( w > 0.0 && r2 < thresh_sqr )
+    {
+      cost += r2;
+      ++inliers;
+    }
+    else
+    {
+      cost += thresh_sqr;
+    }
+  }
+}
+
+
+struct hypothesis
+{
+  unsigned sample[sample_size];
+  double h[9];
+  bool valid;
+  double cost;
+  unsigned inliers;
+};
+
+} // end anonymous namespace
+
+
+namespace vidtk
+{
+
+class ransac_homography_estimator::priv
+{
+public:
+  priv()
+    : inlier_count( 0 ),
+      hypotheses( 0 )
+  {}
+
+  void draw_sample( vnl_random& rng, unsigned n, bool include_last, unsigned* sample ) const;
+  void score_range( unsigned begin, unsigned end, double bail_cost );
+  double score( double const* h, double bail_cost, unsigned& inliers ) const;
+  unsigned adaptive_iterations( unsigned inliers ) const;
+  bool fit_inliers( double const* h_in, double* h_out ) const;
+  void classify( double const* h, std::vector< bool >& flags ) const;
+
+  ransac_homography_params params;
+
+  // Normalized coordinates, structure of arrays
+  std::vector< double > fx, fy, tx, ty;
+  double thresh_sqr;
+
+  std::vector< hypothesis > batch;
+
+  std::vector< bool > inlier_flags;
+  unsigned inlier_count;
+  unsigned hypotheses;
+};
+
+
+// ----------------------------------------------------------------
+/** Draw distinct sample points from the first \a n correspondences.
+ *
+ * When \a include_last is set, the sample holds correspondence n-1
+ * and three drawn from the first n-1, as PROSAC requires.
+ */
+void
+ransac_homography_estimator::priv
+::draw_sample( vnl_random& rng, unsigned n, bool include_last, unsigned* sample ) const
+{
+  unsigned count = 0;
+  unsigned range = n;
+
+  if( include_last )
+  {
+    sample[count++] = n - 1;
+    --range;
+  }
+
+  while( count < sample_size )
+  {
+    unsigned idx = static_cast< unsigned >( rng.lrand32( 0, static_cast< int >( range ) - 1 ) );
+
+    bool duplicate = false;
+    for( unsigned k = 0; k < count; ++k )
+    {
+      duplicate = duplicate || ( sample[k] == idx );
+    }
+
+    if( ! duplicate )
+    {
+      sample[count++] = idx;
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------
+double
+ransac_homography_estimator::priv
+::score( double const* h, double bail_cost, unsigned& inliers ) const
+{
+  const unsigned n = static_cast< unsigned >( fx.size() );
+  double cost = 0.0;
+  inliers = 0;
+
+  for( unsigned i = 0; i < n; i += score_block )
+  {
+    score_points( h, &fx[0], &fy[0], &tx[0], &ty[0],
+                  i, std::min( n, i + score_block ), thresh_sqr,
+                  cost, inliers );
+
+    // Can no longer beat the best hypothesis so far
+    if( cost > bail_cost )
+    {
+      return std::numeric_limits< double >::infinity();
+    }
+  }
+
+  return cost;
+}
+
+
+// ----------------------------------------------------------------
+void
+ransac_homography_estimator::priv
+::score_range( unsigned begin, unsigned end, double bail_cost )
+{
+  for( unsigned j = begin; j < end; ++j )
+  {
+    hypothesis& hyp = batch[j];
+
+    hyp.valid = sample_is_valid( &fx[0], &fy[0], &tx[0], &ty[0], hyp.sample ) &&
+                solve_minimal( &fx[0], &fy[0], &tx[0], &ty[0], hyp.sample, hyp.h );
+
+    if( hyp.valid )
+    {
+      hyp.cost = score( hyp.h, bail_cost, hyp.inliers );
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------
+/** Number of samples needed to draw an all-inlier one with the
+ * required confidence, given the best inlier count so far.
+ */
+unsigned
+ransac_homography_estimator::priv
+::adaptive_iterations( unsigned inliers ) const
+{
+  const double ratio = static_cast< double >( inliers ) / fx.size();
+  const double good_sample = std::pow( ratio, static_cast< double >( sample_size ) );
+
+  if( good_sample >= 1.0 - 1e-12 )
+  {
+    return 1;
+  }
+  if( good_sample <= 1e-12 )
+  {
+    return params.max_iterations;
+  }
+
+  double k = std::ceil( std::log( 1.0 - params.confidence ) / std::log( 1.0 - good_sample ) );
+  return ( k < params.max_iterations ? static_cast< unsigned >( k ) : params.max_iterations );
+}
+
+
+// ----------------------------------------------------------------
+/** Least squares (DLT) fit to the inliers of \a h_in.
+ *
+ *
+ */
+bool
+ransac_homography_estimator::priv
+::fit_inliers( double const* h_in, double* h_out ) const
+{
+  vnl_matrix< double > ata( 9, 9, 0.0 );
+  unsigned count = 0;
+
+  for( unsigned i = 0; i < fx.size(); ++i )
+  {
+    double w = h_in[6] * fx[i] + h_in[7] * fy[i] + h_in[8];
+    double dx = ( h_in[0] * fx[i] + h_in[1] * fy[i] + h_in[2] ) / w - tx[i];
+    double dy = ( h_in[3] * fx[i] + h_in[4] * fy[i] + h_in[5] ) / w - ty[i];
+
+    if( ! ( w > 0.0 && dx * dx + dy * dy < thresh_sqr ) )
+    {
+      continue;
+    }
+
+    double const r0[9] = { fx[i], fy[i], 1.0, 0.0, 0.0, 0.0,
+                           -fx[i] * tx[i], -fy[i] * tx[i], -tx[i] };
+    double const r1[9] = { 0.0, 0.0, 0.0, fx[i], fy[i], 1.0,
+                           -fx[i] * ty[i], -fy[i] * ty[i], -ty[i] };
+
+    for( unsigned r = 0; r < 9; ++r )
+    {
+      for( unsigned c = r; c < 9; ++c )
+      {
+        ata( r, c ) += r0[r] * r0[c] + r1[r] * r1[c];
+      }
+    }
+    ++count;
+  }
+
+  if( count <= sample_size )
+  {
+    return false;
+  }
+
+  for( unsigned r = 0; r < 9; ++r )
+  {
+    for( unsigned c = 0; c < r; ++c )
+    {
+      ata( r, c ) = ata( c, r );
+    }
+  }
+
+  // The eigenvector of the smallest eigenvalue comes first
+  vnl_symmetric_eigensystem< double > eig( ata );
+  vnl_vector< double > v = eig.get_eigenvector( 0 );
+
+  // Scale so that the centroid maps in front of the camera
+  if( std::fabs( v[8] ) < 1e-12 )
+  {
+    return false;
+  }
+
+  for( unsigned k = 0; k < 9; ++k )
+  {
+    h_out[k] = v[k] / v[8];
+  }
+
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+void
+ransac_homography_estimator::priv
+::classify( double const* h, std::vector< bool >& flags ) const
+{
+  flags.resize( fx.size() );
+
+  for( unsigned i = 0; i < fx.size(); ++i )
+  {
+    unsigned inlier = 0;
+    double cost = 0.0;
+    score_points( h, &fx[0], &fy[0], &tx[0], &ty[0], i, i + 1, thresh_sqr, cost, inlier );
+    flags[i] = ( inlier != 0 );
+  }
+}
+
+
+// ----------------------------------------------------------------
+ransac_homography_estimator
+::ransac_homography_estimator()
+  : d( new priv )
+{
+}
+
+
+ransac_homography_estimator
+::~ransac_homography_estimator()
+{
+}
+
+
+void
+ransac_homography_estimator
+::set_params( ransac_homography_params const& p )
+{
+  d->params = p;
+  d->params.batch_size = std::max( 1u, p.batch_size );
+  d->params.max_iterations = std::max( 1u, p.max_iterations );
+}
+
+
+ransac_homography_params const&
+ransac_homography_estimator
+::params() const
+{
+  return d->params;
+}
+
+
+std::vector< bool > const&
+ransac_homography_estimator
+::inliers() const
+{
+  return d->inlier_flags;
+}
+
+
+unsigned
+ransac_homography_estimator
+::inlier_count() const
+{
+  return d->inlier_count;
+}
+
+
+unsigned
+ransac_homography_estimator
+::hypotheses_evaluated() const
+{
+  return d->hypotheses;
+}
+
+
+// ----------------------------------------------------------------
+bool
+ransac_homography_estimator
+::estimate( std::vector< vnl_double_2 > const& from,
+            std::vector< vnl_double_2 > const& to,
+            vnl_double_3x3& H )
+{
+  d->inlier_flags.assign( from.size(), false );
+  d->inlier_count = 0;
+  d->hypotheses = 0;
+
+  const unsigned n = static_cast< unsigned >( from.size() );
+  if( n < sample_size || to.size() != from.size() )
+  {
+    return false;
+  }
+
+  normalization from_norm;
+  normalization to_norm;
+  from_norm.compute( from );
+  to_norm.compute( to );
+  from_norm.apply( from, d->fx, d->fy );
+  to_norm.apply( to, d->tx, d->ty );
+
+  const double thresh = d->params.inlier_threshold * to_norm.scale;
+  d->thresh_sqr = thresh * thresh;
+
+  vnl_random rng( d->params.seed );
+
+  // PROSAC schedule, growing the sampled subset from the first four
+  // correspondences to all of them over max_iterations samples
+  const unsigned max_iter = d->params.max_iterations;
+  double t_n = max_iter;
+  for( unsigned i = 0; i < sample_size; ++i )
+  {
+    t_n *= static_cast< double >( sample_size - i ) / ( n - i );
+  }
+  unsigned t_n_prime = 1;
+  unsigned subset = sample_size;
+
+  hypothesis best;
+  best.valid = false;
+  best.cost = std::numeric_limits< double >::infinity();
+  best.inliers = 0;
+
+  compute_pool_t pool = compute_pool::instance();
+
+  unsigned drawn = 0;
+  unsigned needed = max_iter;
+
+  while( drawn < needed )
+  {
+    const unsigned batch_count = std::min( d->params.batch_size, needed - drawn );
+    d->batch.resize( batch_count );
+
+    // Samples are drawn serially so that they do not depend on threading
+    for( unsigned j = 0; j < batch_count; ++j )
+    {
+      ++drawn;
+
+      if( drawn > t_n_prime && subset < n )
+      {
+        double t_n1 = t_n * ( subset + 1 ) / ( subset + 1 - sample_size );
+        t_n_prime += static_cast< unsigned >( std::ceil( t_n1 - t_n ) );
+        t_n = t_n1;
+        ++subset;
+      }
+
+      d->draw_sample( rng, subset, t_n_prime >= drawn && subset > sample_size,
+                      d->batch[j].sample );
+    }
+
+    if( batch_count * n >= min_parallel_work && pool->core_budget() > 1 )
+    {
+      pool->parallel_for( 0, batch_count,
+                          boost::bind( &priv::score_range, d.get(), _1, _2, best.cost ),
+                          "ransac_homography" );
+    }
+    else
+    {
+      d->score_range( 0, batch_count, best.cost );
+    }
+
+    // Keep the first of equally good hypotheses
+    for( unsigned j = 0; j < batch_count; ++j )
+    {
+      if( d->batch[j].valid && d->batch[j].cost < best.cost )
+      {
+        best = d->batch[j];
+      }
+    }
+
+    if( best.valid )
+    {
+      needed = std::max( drawn, std::min( needed, d->adaptive_iterations( best.inliers ) ) );
+    }
+  }
+
+  d->hypotheses = drawn;
+
+  if( ! best.valid )
+  {
+    return false;
+  }
+
+  // Polish with least squares, keeping each refit that lowers the cost
+  for( unsigned it = 0; it < d->params.polish_iterations; ++it )
+  {
+    hypothesis refit;
+    if( ! d->fit_inliers( best.h, refit.h ) )
+    {
+      break;
+    }
+
+    refit.cost = d->score( refit.h, std::numeric_limits< double >::infinity(), refit.inliers );
+    if( ! ( refit.cost < best.cost ) )
+    {
+      break;
+    }
+
+    std::copy( refit.h, refit.h + 9, best.h );
+    best.cost = refit.cost;
+    best.inliers = refit.inliers;
+  }
+
+  d->classify( best.h, d->inlier_flags );
+  d->inlier_count = best.inliers;
+
+  // Undo the normalization: H = inv(T_to) * Hn * T_from
+  vnl_double_3x3 hn;
+  hn.copy_in( best.h );
+
+  vnl_double_3x3 t_from;
+  t_from.set_identity();
+  t_from( 0, 0 ) = from_norm.scale;
+  t_from( 1, 1 ) = from_norm.scale;
+  t_from( 0, 2 ) = -from_norm.scale * from_norm.cx;
+  t_from( 1, 2 ) = -from_norm.scale * from_norm.cy;
+
+  vnl_double_3x3 t_to_inv;
+  t_to_inv.set_identity();
+  t_to_inv( 0, 0 ) = 1.0 / to_norm.scale;
+  t_to_inv( 1, 1 ) = 1.0 / to_norm.scale;
+  t_to_inv( 0, 2 ) = to_norm.cx;
+  t_to_inv( 1, 2 ) = to_norm.cy;
+
+  H = t_to_inv * hn * t_from;
+
+  if( std::fabs( H( 2, 2 ) ) > 1e-12 )
+  {
+    H /= H( 2, 2 );
+  }
+
+  return true;
+}
+
+} // end namespace vidtk
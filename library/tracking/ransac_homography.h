@@ -0,0 +1,111 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_ransac_homography_h_
+#define vidtk_ransac_homography_h_
+
+#include <vnl/vnl_double_2.h>
+#include <vnl/vnl_double_3x3.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <vector>
+
+namespace vidtk
+{
+
+/// Parameters of the ransac_homography_estimator.
+struct ransac_homography_params
+{
+  ransac_homography_params()
+    : inlier_threshold( 2.0 ),
+      confidence( 0.99 ),
+      max_iterations( 1000 ),
+      batch_size( 32 ),
+      polish_iterations( 3 ),
+      seed( 42 )
+  {}
+
+  /// Largest transfer error, in destination pixels, of an inlier.
+  double inlier_threshold;
+
+  /// Required probability of drawing at least one all-inlier sample.
+  double confidence;
+
+  /// Largest number of hypotheses to evaluate.
+  unsigned max_iterations;
+
+  /// Number of hypotheses generated and scored together, in parallel.
+  unsigned batch_size;
+
+  /// Number of least squares refits on the inliers of the best hypothesis.
+  unsigned polish_iterations;
+
+  /// Seed of the sample generator.
+  unsigned seed;
+};
+
+
+// ----------------------------------------------------------------
+/** Robust homography estimation from point correspondences.
+ *
+ * Hypotheses are generated from minimal four point samples and scored
+ * with a truncated quadratic (MSAC) cost of the transfer error. The
+ * estimator differs from a plain RANSAC search in several ways:
+ *
+ * - Samples are drawn progressively (PROSAC), starting with the most
+ *   reliable correspondences and growing to all of them. The
+ *   correspondences must be ordered from most to least reliable.
+ * - The number of hypotheses adapts to the best inlier ratio found so
+ *   far, so the search stops as soon as the required confidence is
+ *   reached.
+ * - Hypotheses are scored in batches on the vidtk::compute_pool. The
+ *   scoring of a hypothesis is abandoned once its cost exceeds that of
+ *   the best hypothesis of the previous batches. Since the batches and
+ *   the selection between them are fixed, the result does not depend
+ *   on the number of threads.
+ * - The best hypothesis is refined by fitting to its inliers with
+ *   least squares, and the inliers are reselected after each fit.
+ *
+ * All computation is done on coordinates normalized for conditioning.
+ */
+class ransac_homography_estimator
+{
+public:
+  ransac_homography_estimator();
+  ~ransac_homography_estimator();
+
+  void set_params( ransac_homography_params const& p );
+  ransac_homography_params const& params() const;
+
+  /// \brief Estimate the homography mapping \a from points to \a to points.
+  ///
+  /// \param from Source points, ordered from most to least reliable.
+  /// \param to Destination points, corresponding to \a from.
+  /// \param[out] H Estimated homography.
+  /// \return False if there are too few correspondences or no
+  /// non-degenerate sample was found, in which case \a H is unchanged.
+  bool estimate( std::vector< vnl_double_2 > const& from,
+                 std::vector< vnl_double_2 > const& to,
+                 vnl_double_3x3& H );
+
+  /// Inlier flags of the correspondences of the last estimate.
+  std::vector< bool > const& inliers() const;
+
+  /// Number of inliers of the last estimate.
+  unsigned inlier_count() const;
+
+  /// Number of hypotheses evaluated by the last estimate.
+  unsigned hypotheses_evaluated() const;
+
+private:
+  class priv;
+  boost::scoped_ptr< priv > d;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_ransac_homography_h_
@@ -382,6 +382,7 @@ void create_process_configs()
     {
       p->add( proc_klt_pyramid );
       p->connect( proc_convert_to_grey->copied_image_port(),    proc_klt_pyramid->set_image_port() );
+      p->connect( proc_timestamper->timestamp_port(),           proc_klt_pyramid->set_timestamp_port() );
 
       p->connect( proc_homog_from_metadata->h_prev_2_cur_port(), proc_homography_sp->set_homog_predict_port() );
 
@@ -749,6 +750,14 @@ stabilization_super_process<PixType>
     "  gpu: Require just images and uses a GPU accelerated implementation\n"
     "       of point descriptor matching with hessian corners and BRIEF\n"
     "       descriptors.  This algorithm depends on VisCL and OpenCL." );
+
+  impl_->config.add_parameter( "coarse_to_fine",
+    "false",
+    "Whether KLT tracking first estimates the motion on a coarse level of the "
+    "klt_pyramid, then tracks all features on the finest levels only. This sets "
+    "homog_sp:klt_tracking:coarse_to_fine, where the levels used and the feature "
+    "budget are configured. It pays off when klt_pyramid has more levels than the "
+    "default, such as for large frames." );
 }
 
 template< class PixType>
@@ -843,6 +852,11 @@ stabilization_super_process<PixType>
     impl_->config.set( impl_->proc_homography_sp->name() + ":tracker_type",
                        blk.get<std::string>( "tracker_type" ) );
 
+    if( blk.get<bool>( "coarse_to_fine" ) )
+    {
+      impl_->config.set( impl_->proc_homography_sp->name() + ":klt_tracking:coarse_to_fine", "true" );
+    }
+
     double scale_factor = impl_->config.template get<double>(impl_->proc_rescale->name() + ":scale_factor");
     impl_->config.set( impl_->proc_project_homography->name() + ":scale",
                        scale_factor);
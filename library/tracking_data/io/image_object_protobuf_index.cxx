@@ -0,0 +1,127 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "image_object_protobuf_index.h"
+
+#include <cstring>
+
+namespace vidtk {
+
+namespace {
+
+char const index_magic[8] = { 'K', 'W', 'P', 'C', 'I', 'D', 'X', '1' };
+
+// Serialized size of one entry and of the trailer following the entries
+std::size_t const entry_size = 2 * sizeof( boost::uint64_t ) + sizeof( unsigned ) + sizeof( double );
+std::size_t const trailer_size = sizeof( boost::uint64_t ) + sizeof( index_magic );
+
+
+template < typename T >
+void write_value( std::ostream& str, T const& value )
+{
+  str.write( reinterpret_cast< char const* >( &value ), sizeof( T ) );
+}
+
+
+template < typename T >
+void read_value( char const*& data, T& value )
+{
+  std::memcpy( &value, data, sizeof( T ) );
+  data += sizeof( T );
+}
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------
+void
+write_image_object_protobuf_index( std::ostream& str,
+                                   image_object_protobuf_index_t const& index )
+{
+  for ( std::size_t i = 0; i < index.size(); ++i )
+  {
+    write_value( str, index[i].offset );
+    write_value( str, index[i].size );
+    write_value( str, index[i].frame_number );
+    write_value( str, index[i].time );
+  }
+
+  write_value( str, static_cast< boost::uint64_t >( index.size() ) );
+  str.write( index_magic, sizeof( index_magic ) );
+}
+
+
+// ----------------------------------------------------------------
+bool
+read_image_object_protobuf_index( std::istream& str,
+                                  image_object_protobuf_index_t& index,
+                                  boost::uint64_t& data_end )
+{
+  index.clear();
+  data_end = 0;
+
+  str.clear();
+  str.seekg( 0, std::ios::end );
+  std::streamoff const file_size = str.tellg();
+
+  if ( file_size < static_cast< std::streamoff >( trailer_size ) )
+  {
+    return false;
+  }
+
+  char trailer[ trailer_size ];
+  str.seekg( file_size - static_cast< std::streamoff >( trailer_size ) );
+
+  if ( ! str.read( trailer, trailer_size ) ||
+       std::memcmp( trailer + sizeof( boost::uint64_t ), index_magic, sizeof( index_magic ) ) != 0 )
+  {
+    return false;
+  }
+
+  boost::uint64_t count;
+  char const* pos = trailer;
+  read_value( pos, count );
+
+  boost::uint64_t const available = static_cast< boost::uint64_t >( file_size ) - trailer_size;
+  if ( count > available / entry_size )
+  {
+    return false;
+  }
+
+  data_end = available - count * entry_size;
+
+  std::vector< char > entries( static_cast< std::size_t >( count * entry_size ) );
+  str.seekg( static_cast< std::streamoff >( data_end ) );
+
+  if ( ! entries.empty() && ! str.read( &entries[0], entries.size() ) )
+  {
+    data_end = 0;
+    return false;
+  }
+
+  index.resize( static_cast< std::size_t >( count ) );
+  pos = entries.empty() ? NULL : &entries[0];
+
+  for ( std::size_t i = 0; i < index.size(); ++i )
+  {
+    read_value( pos, index[i].offset );
+    read_value( pos, index[i].size );
+    read_value( pos, index[i].frame_number );
+    read_value( pos, index[i].time );
+
+    // Written so that offset + size can not overflow
+    if ( index[i].size > data_end || index[i].offset > data_end - index[i].size )
+    {
+      index.clear();
+      data_end = 0;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // end namespace
@@ -0,0 +1,76 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef _VIDTK_IMAGE_OBJECT_PROTOBUF_INDEX_H_
+#define _VIDTK_IMAGE_OBJECT_PROTOBUF_INDEX_H_
+
+#include <boost/cstdint.hpp>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace vidtk {
+
+// ----------------------------------------------------------------
+/**
+ * @brief Location of one frame record in a protobuf image object file.
+ *
+ * Image object protobuf files (.kwpc) are a sequence of serialized
+ * containers, one per frame with objects. The writer appends a footer
+ * holding one of these entries per record, so that readers can seek
+ * to a frame or read ranges of frames without parsing the whole file.
+ *
+ * Footer layout, in native byte order:
+ *   entries (offset u64, size u64, frame number u32, time f64),
+ *   entry count u64, 8 byte magic "KWPCIDX1".
+ */
+struct image_object_protobuf_index_entry
+{
+  image_object_protobuf_index_entry()
+    : offset( 0 ), size( 0 ), frame_number( no_frame_number ), time( -1.0 )
+  { }
+
+  /// Frame number of records whose timestamp has none.
+  static const unsigned no_frame_number = 0xffffffffu;
+
+  boost::uint64_t offset;   // start of the record in the file
+  boost::uint64_t size;     // serialized size of the record
+  unsigned frame_number;
+  double time;              // time in micro-seconds, -1 if not set
+};
+
+typedef std::vector< image_object_protobuf_index_entry > image_object_protobuf_index_t;
+
+
+/**
+ * @brief Append the frame index footer to a stream.
+ *
+ * @param str Stream positioned after the last record.
+ * @param index Entries for every record in the file.
+ */
+void write_image_object_protobuf_index( std::ostream& str,
+                                        image_object_protobuf_index_t const& index );
+
+
+/**
+ * @brief Read the frame index footer of a file.
+ *
+ * The stream is left in an unspecified position.
+ *
+ * @param str Stream of the whole file.
+ * @param[out] index Entries for every record in the file.
+ * @param[out] data_end Offset of the end of the records.
+ *
+ * @return \b true if the file has a valid footer.
+ */
+bool read_image_object_protobuf_index( std::istream& str,
+                                       image_object_protobuf_index_t& index,
+                                       boost::uint64_t& data_end );
+
+} // end namespace
+
+#endif /* _VIDTK_IMAGE_OBJECT_PROTOBUF_INDEX_H_ */
@@ -14,15 +14,9 @@
 #include <vul/vul_file.h>
 #include <vul/vul_file_iterator.h>
 
-#include <utilities/shell_comments_filter.h>
-#include <utilities/blank_line_filter.h>
+#include <utilities/compute_pool.h>
 #include <logger/logger.h>
-#include <boost/tokenizer.hpp>
-#include <boost/algorithm/string.hpp>
-
-#include <iostream>
-#include <fstream>
-#include <stdio.h>
+#include <boost/bind.hpp>
 
 namespace vidtk {
 namespace ns_image_object_reader {
@@ -54,6 +48,9 @@ VIDTK_LOGGER ("image_object_reader_kw18");
     COL_CONFIDENCE// 18
   };
 
+  // Amount of the file parsed at once
+  const size_t block_bytes = 64 * 1024 * 1024;
+
 } // end namepsace
 
 // ----------------------------------------------------------------
@@ -62,14 +59,14 @@ VIDTK_LOGGER ("image_object_reader_kw18");
  */
 image_object_reader_kw18
 ::image_object_reader_kw18()
-  : in_stream_(0)
+  : position_(0),
+    next_line_(0)
 { }
 
 
 image_object_reader_kw18
 ::~image_object_reader_kw18()
 {
-  delete in_stream_;
 }
 
 
@@ -78,7 +75,7 @@ bool
 image_object_reader_kw18
 ::open(std::string const& filename)
 {
-  if (0 != in_stream_) // meaning we are already open
+  if ( file_.is_open() ) // meaning we are already open
   {
     return true;
   }
@@ -91,18 +88,15 @@ image_object_reader_kw18
     return false;
   }
 
-  std::ifstream* fstr = new std::ifstream( this->filename_.c_str() );
-  if ( ! *fstr )
+  if ( ! file_.open( this->filename_ ) )
   {
     LOG_ERROR( "Couldn't open " << this->filename_ << " for reading." );
     return false;
   }
 
-  in_stream_ = new boost::iostreams::filtering_istream();
-
-  in_stream_->push (vidtk::blank_line_filter());
-  in_stream_->push (vidtk::shell_comments_filter());
-  in_stream_->push (*fstr);
+  position_ = file_.data();
+  lines_.clear();
+  next_line_ = 0;
 
   return true;
 }
@@ -113,60 +107,135 @@ bool
 image_object_reader_kw18
 ::read_next(ns_image_object_reader::datum_t& datum)
 {
-  if ( in_stream_ == NULL )
+  if ( ! file_.is_open() )
   {
     LOG_ERROR( "Stream is null." );
     return false;
   }
-  if ( in_stream_->eof() )
-  {
-    return false;
-  }
 
-  std::string line;
-  while ( std::getline(*in_stream_, line) )
+  while ( true )
   {
-    std::vector< std::string > col;
+    while ( next_line_ == lines_.size() )
+    {
+      if ( ! parse_next_block() )
+      {
+        return false;
+      }
+    }
 
-    col.clear();
-    boost::char_separator < char > sep(" ");
-    typedef boost::tokenizer < boost::char_separator<char> > tok_t;
-    tok_t tok( line, sep );
-    for(tok_t::iterator it = tok.begin(); it != tok.end(); ++it)
+    parsed_line const& line = lines_[next_line_++];
+
+    if ( line.bad_columns != 0 )
     {
-      col.push_back( *it );
+      LOG_ERROR( "This is not a kw18 kw19 or kw20 file; found " << line.bad_columns <<
+                 " columns in\n\"" << std::string( line.text.begin, line.text.end ) << "\"" );
+      return false;
     }
 
-    // skip lines suppressed by filtered stream
-    if ( col.empty() )
+    datum.first = line.ts;
+
+    if ( line.obj )
     {
-      continue;
+      datum.second = line.obj;
+      return true;
     }
 
-    if ( ( col.size() < 18 ) || ( col.size() > 20 ) )
+    LOG_DEBUG("Image X location is -1, invalid object, throwing it out");
+  }
+}
+
+
+// ----------------------------------------------------------------
+/** Parse the next block of the file.
+ *
+ * Returns false if the whole file has been parsed.
+ */
+bool
+image_object_reader_kw18
+::parse_next_block()
+{
+  char const* end = file_.data() + file_.size();
+
+  if ( position_ == end )
+  {
+    return false;
+  }
+
+  char const* block_end = kw18_text_line_end( position_, end, block_bytes );
+
+  compute_pool_t pool = compute_pool::instance();
+
+  std::vector< kw18_text_range > ranges;
+  split_kw18_text( position_, block_end, 4 * pool->core_budget(), ranges );
+
+  std::vector< std::vector< parsed_line > > parsed( ranges.size() );
+  std::vector< compute_pool::task_t > tasks;
+
+  for ( size_t i = 0; i < ranges.size(); ++i )
+  {
+    tasks.push_back( boost::bind( &image_object_reader_kw18::parse_lines,
+                                  ranges[i], &parsed[i] ) );
+  }
+
+  pool->run( tasks, "image_object_reader_kw18" );
+
+  lines_.clear();
+  next_line_ = 0;
+
+  for ( size_t i = 0; i < parsed.size(); ++i )
+  {
+    lines_.insert( lines_.end(), parsed[i].begin(), parsed[i].end() );
+  }
+
+  position_ = block_end;
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+/** Parse the image objects in a range of lines.
+ *
+ * This is called on multiple threads at once, one per range, so it
+ * must only touch objects it creates.
+ */
+void
+image_object_reader_kw18
+::parse_lines( kw18_text_range range,
+               std::vector< parsed_line >* lines )
+{
+  kw18_line line;
+  char const* pos = range.begin;
+
+  while ( line.read( pos, range.end ) )
+  {
+    lines->push_back( parsed_line() );
+    parsed_line& parsed = lines->back();
+
+    if ( ( line.size() < 18 ) || ( line.size() > 20 ) )
     {
-      LOG_ERROR( "This is not a kw18 kw19 or kw20 file; found " << col.size() <<
-                 " columns in\n\"" << line << "\"" );
-      return false;
+      parsed.bad_columns = line.size();
+      parsed.text.begin = line.begin();
+      parsed.text.end = line.end();
+      continue;
     }
 
     // get timestamp - need frame number and timestamp
-    datum.first = vidtk::timestamp( atof( col[COL_TIME].c_str() )*1e6, // timestamp in seconds
-                                    atoi( col[COL_FRAME].c_str() ));
+    parsed.ts = vidtk::timestamp( line.as_double( COL_TIME )*1e6, // timestamp in seconds
+                                  line.as_int( COL_FRAME ) );
 
-    image_object * obj = new image_object();
-    datum.second = obj;
-
-    if ( atof( col[COL_IMG_LOC_X].c_str() ) != -1.0 )
+    if ( line.as_double( COL_IMG_LOC_X ) != -1.0 )
     {
       // only pass on the object if it is 'valid'
-      obj->set_image_loc( atof( col[COL_IMG_LOC_X].c_str() ),
-                          atof( col[COL_IMG_LOC_Y].c_str() ));
+      image_object_sptr obj = new image_object();
+      parsed.obj = obj;
+
+      obj->set_image_loc( line.as_double( COL_IMG_LOC_X ),
+                          line.as_double( COL_IMG_LOC_Y ) );
 
-      int min_x = atoi( col[COL_MIN_X].c_str() );
-      int max_x = atoi( col[COL_MAX_X].c_str() );
-      int min_y = atoi( col[COL_MIN_Y].c_str() );
-      int max_y = atoi( col[COL_MAX_Y].c_str() );
+      int min_x = line.as_int( COL_MIN_X );
+      int max_x = line.as_int( COL_MAX_X );
+      int min_y = line.as_int( COL_MIN_Y );
+      int max_y = line.as_int( COL_MAX_Y );
 
       obj->set_bbox(
         ( min_x < 0 ? 0 : min_x ),
@@ -176,27 +245,22 @@ image_object_reader_kw18
 
       obj->set_image_area( obj->get_bbox().volume() );
 
-      obj->set_area( atof( col[COL_AREA].c_str() ) );
+      obj->set_area( line.as_double( COL_AREA ) );
 
-      obj->set_world_loc(atof( col[COL_WORLD_X].c_str() ), // x
-                         atof( col[COL_WORLD_Y].c_str() ), // y
-                         atof( col[COL_WORLD_Z].c_str() )); // z
+      obj->set_world_loc( line.as_double( COL_WORLD_X ), // x
+                          line.as_double( COL_WORLD_Y ), // y
+                          line.as_double( COL_WORLD_Z ) ); // z
 
-      if (atof(col[COL_CONFIDENCE].c_str()) != -1.0)
+      // kw18 files have no confidence column
+      if ( line.size() > COL_CONFIDENCE &&
+           line.as_double( COL_CONFIDENCE ) != -1.0 )
       {
-        obj->set_confidence(atof(col[COL_CONFIDENCE].c_str()));
+        obj->set_confidence( line.as_double( COL_CONFIDENCE ) );
       }
-
-      return true;
-    }
-    else
-    {
-      LOG_DEBUG("Image X location is -1, invalid object, throwing it out");
     }
   }
-
-  return false;
 }
 
+
 } // end namespace ns_image_object_reader
 } // end namespace vidtk
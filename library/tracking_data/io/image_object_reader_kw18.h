@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -8,7 +8,10 @@
 #define _IMAGE_OBJECT_READER_KW18_H_
 
 #include <tracking_data/io/image_object_reader_interface.h>
-#include <boost/iostreams/filtering_stream.hpp>
+#include <tracking_data/io/kw18_text_parser.h>
+#include <utilities/mapped_file.h>
+
+#include <vector>
 
 
 namespace vidtk {
@@ -17,6 +20,11 @@ namespace ns_image_object_reader {
 
 // ----------------------------------------------------------------
 /** kw18 image object reader
+ *
+ * The file is memory mapped and read in large blocks of lines. Each
+ * block is split into ranges which are parsed in parallel on the
+ * shared compute pool, and the objects are then returned in file
+ * order.
  */
 class image_object_reader_kw18
   : public image_object_reader_interface
@@ -29,7 +37,32 @@ public:
   virtual bool read_next( ns_image_object_reader::datum_t& datum );
 
 private:
-  boost::iostreams::filtering_istream * in_stream_;
+  // One data line parsed from the file
+  struct parsed_line
+  {
+    parsed_line()
+      : bad_columns( 0 )
+    { }
+
+    vidtk::timestamp ts;
+
+    // Object of the line, NULL if the line was skipped
+    image_object_sptr obj;
+
+    // Column count and text of a line which is not kw18
+    unsigned bad_columns;
+    kw18_text_range text;
+  };
+
+  static void parse_lines( kw18_text_range range,
+                           std::vector< parsed_line >* lines );
+  bool parse_next_block();
+
+  vidtk::mapped_file file_;
+  char const* position_;
+
+  std::vector< parsed_line > lines_;
+  size_t next_line_;
 
 }; // end class image_object_reader_kw18
 
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2014-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2014-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -13,10 +13,16 @@
 
 #include <protobuf/convert_protobuf.h>
 
+#include <utilities/compute_pool.h>
+#include <utilities/mapped_file.h>
+
 #include <vul/vul_file.h>
 
+#include <boost/bind.hpp>
+
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 
 #include <logger/logger.h>
@@ -54,6 +60,53 @@ public:
 };
 
 
+namespace {
+
+// ----------------------------------------------------------------
+// Parse the records of frames [first, last) from a mapped file.
+void
+parse_records( char const* data,
+               image_object_protobuf_index_t const* records,
+               std::vector< ts_object_vector_t >* frames,
+               std::vector< char >* parsed,
+               unsigned first, unsigned last )
+{
+  for ( unsigned i = first; i < last; ++i )
+  {
+    image_object_protobuf_index_entry const& entry = (*records)[i];
+
+    std::istringstream record( std::string( data + entry.offset,
+                                            static_cast< std::size_t >( entry.size ) ) );
+
+    protobuf_container_sptr tainer;
+    if ( ! protobuf_container::parse_from_stream( record, tainer ) )
+    {
+      continue;
+    }
+
+    extract_data xd;
+    tainer->accept_visitor( xd );
+
+    (*frames)[i].first = xd.m_timestamp;
+    (*frames)[i].second.swap( xd.m_obj_list );
+    (*parsed)[i] = 1;
+  }
+}
+
+
+// ----------------------------------------------------------------
+// Does the record lie entirely within the first length bytes?
+bool
+record_in_bounds( image_object_protobuf_index_entry const& entry,
+                  boost::uint64_t length )
+{
+  // Written so that offset + size can not overflow
+  return entry.size <= length && entry.offset <= length - entry.size;
+}
+
+} // end anonymous namespace
+
+
 
 // ----------------------------------------------------------------
 /** Constructor
@@ -62,7 +115,8 @@ public:
  */
 image_object_reader_protobuf::
 image_object_reader_protobuf()
-  : m_next_obj( m_obj_list.end() )
+  : m_data_end( 0 ),
+    m_next_obj( m_obj_list.end() )
 {
 }
 
@@ -93,13 +147,19 @@ open( std::string const& filename)
     return false;
   }
 
-  m_stream.open( this->filename_.c_str() );
+  m_stream.open( this->filename_.c_str(), std::ios::in | std::ios::binary );
   if( ! m_stream )
   {
     LOG_ERROR( "Couldn't open " << this->filename_ << " for reading." );
     return false;
   }
 
+  // Read the frame index footer, if there is one, and rewind
+  read_image_object_protobuf_index( m_stream, m_index, m_data_end );
+
+  m_stream.clear();
+  m_stream.seekg( 0 );
+
   return true;
 }
 
@@ -128,6 +188,13 @@ read_next(ns_image_object_reader::datum_t& datum)
     // objects, since there may be times where the vector is empty.
     do
     {
+      // Stop at the frame index footer
+      if ( m_data_end > 0 &&
+           static_cast< boost::uint64_t >( m_stream.tellg() ) >= m_data_end )
+      {
+        return false;
+      }
+
       protobuf_container_sptr tainer;
       if ( ! protobuf_container::parse_from_stream( m_stream, tainer ) )
       {
@@ -153,5 +220,216 @@ read_next(ns_image_object_reader::datum_t& datum)
   return true;
 }
 
+
+// ----------------------------------------------------------------
+bool
+image_object_reader_protobuf::
+has_frame_index() const
+{
+  return m_data_end > 0;
+}
+
+
+image_object_protobuf_index_t const&
+image_object_reader_protobuf::
+frame_index() const
+{
+  return m_index;
+}
+
+
+// ----------------------------------------------------------------
+bool
+image_object_reader_protobuf::
+seek_to_frame( unsigned frame_number )
+{
+  std::streamoff offset = 0;
+
+  if ( has_frame_index() )
+  {
+    std::size_t i = 0;
+    while ( i < m_index.size() &&
+            ( m_index[i].frame_number == image_object_protobuf_index_entry::no_frame_number ||
+              m_index[i].frame_number < frame_number ) )
+    {
+      ++i;
+    }
+
+    if ( i == m_index.size() )
+    {
+      return false;
+    }
+
+    offset = static_cast< std::streamoff >( m_index[i].offset );
+  }
+  else if ( ! scan_to_frame( frame_number, offset ) )
+  {
+    return false;
+  }
+
+  // Drop any buffered objects, so the next read parses this record
+  m_obj_list.clear();
+  m_next_obj = m_obj_list.end();
+
+  m_stream.clear();
+  m_stream.seekg( offset );
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+bool
+image_object_reader_protobuf::
+scan_to_frame( unsigned frame_number, std::streamoff& offset ) const
+{
+  std::ifstream str( this->filename_.c_str(), std::ios::in | std::ios::binary );
+  if ( ! str )
+  {
+    LOG_ERROR( "Couldn't open " << this->filename_ << " for reading." );
+    return false;
+  }
+
+  while ( true )
+  {
+    std::streamoff const start = str.tellg();
+
+    protobuf_container_sptr tainer;
+    if ( ! protobuf_container::parse_from_stream( str, tainer ) )
+    {
+      return false; // end of file
+    }
+
+    extract_data xd;
+    tainer->accept_visitor( xd );
+
+    if ( xd.m_timestamp.has_frame_number() &&
+         xd.m_timestamp.frame_number() >= frame_number )
+    {
+      offset = start;
+      return true;
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------
+bool
+image_object_reader_protobuf::
+read_frames( unsigned first_frame, unsigned last_frame,
+             std::vector< ts_object_vector_t >& frames,
+             unsigned max_threads )
+{
+  frames.clear();
+
+  if ( ! has_frame_index() )
+  {
+    return scan_frames( first_frame, last_frame, frames );
+  }
+
+  image_object_protobuf_index_t records;
+  for ( std::size_t i = 0; i < m_index.size(); ++i )
+  {
+    unsigned const frame = m_index[i].frame_number;
+    if ( frame != image_object_protobuf_index_entry::no_frame_number &&
+         frame >= first_frame && frame <= last_frame )
+    {
+      records.push_back( m_index[i] );
+    }
+  }
+
+  if ( records.empty() )
+  {
+    return true;
+  }
+
+  mapped_file file;
+  if ( ! file.open( this->filename_ ) )
+  {
+    return false;
+  }
+
+  // The index was checked when the file was opened, but the file may
+  // have changed since then.
+  for ( std::size_t i = 0; i < records.size(); ++i )
+  {
+    if ( ! record_in_bounds( records[i], file.size() ) )
+    {
+      LOG_WARN( "Frame index of " << this->filename_ << " does not match the file, "
+                "reading it sequentially." );
+      return scan_frames( first_frame, last_frame, frames );
+    }
+  }
+
+  std::vector< ts_object_vector_t > parsed_frames( records.size() );
+  // One flag per record, not vector<bool>, as records are parsed concurrently
+  std::vector< char > parsed( records.size(), 0 );
+
+  compute_pool::instance()->parallel_for(
+    0, static_cast< unsigned >( records.size() ),
+    boost::bind( parse_records, file.data(), &records, &parsed_frames, &parsed, _1, _2 ),
+    "image_object_reader_protobuf", max_threads );
+
+  for ( std::size_t i = 0; i < parsed.size(); ++i )
+  {
+    if ( ! parsed[i] )
+    {
+      LOG_WARN( "Unable to parse record at offset " << records[i].offset
+                << " of " << this->filename_ << ", reading it sequentially." );
+      return scan_frames( first_frame, last_frame, frames );
+    }
+  }
+
+  frames.swap( parsed_frames );
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+bool
+image_object_reader_protobuf::
+scan_frames( unsigned first_frame, unsigned last_frame,
+             std::vector< ts_object_vector_t >& frames ) const
+{
+  frames.clear();
+
+  // Use a separate stream, so that the read_next() position is unchanged
+  std::ifstream str( this->filename_.c_str(), std::ios::in | std::ios::binary );
+  if ( ! str )
+  {
+    LOG_ERROR( "Couldn't open " << this->filename_ << " for reading." );
+    return false;
+  }
+
+  while ( true )
+  {
+    // Stop at the frame index footer
+    if ( m_data_end > 0 &&
+         static_cast< boost::uint64_t >( str.tellg() ) >= m_data_end )
+    {
+      break;
+    }
+
+    protobuf_container_sptr tainer;
+    if ( ! protobuf_container::parse_from_stream( str, tainer ) )
+    {
+      break; // end of file
+    }
+
+    extract_data xd;
+    tainer->accept_visitor( xd );
+
+    if ( xd.m_timestamp.has_frame_number() &&
+         xd.m_timestamp.frame_number() >= first_frame &&
+         xd.m_timestamp.frame_number() <= last_frame )
+    {
+      frames.push_back( ts_object_vector_t() );
+      frames.back().first = xd.m_timestamp;
+      frames.back().second.swap( xd.m_obj_list );
+    }
+  }
+
+  return true;
+}
+
 } // end namespace
 } // end namespace
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2014-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -8,9 +8,11 @@
 #define _VISTK_IMAGE_OBJECT_READER_PROTOBUF_H_
 
 #include <tracking_data/io/image_object_reader_interface.h>
+#include <tracking_data/io/image_object_protobuf_index.h>
 
 #include <string>
 #include <fstream>
+#include <vector>
 
 
 namespace vidtk {
@@ -50,10 +52,65 @@ public:
   */
   virtual bool read_next(ns_image_object_reader::datum_t& datum);
 
+  /**
+   * @brief Does the file have a frame index footer?
+   *
+   * Files written by older versions of the writer, or by a writer
+   * which did not finish, have no index. Seeks and range reads then
+   * scan the file sequentially.
+   */
+  bool has_frame_index() const;
+
+  /**
+   * @brief Location and timestamp of every frame record in the file.
+   */
+  image_object_protobuf_index_t const& frame_index() const;
+
+  /**
+   * @brief Position the reader at the first record at or after a frame.
+   *
+   * The next call to read_next() returns the first object of that
+   * record. Without a frame index, the file is scanned from the start.
+   *
+   * @param frame_number Frame to seek to.
+   *
+   * @return \b true if there is a record at or after the frame.
+   */
+  bool seek_to_frame( unsigned frame_number );
+
+  /**
+   * @brief Read all records for a range of frames.
+   *
+   * The records are parsed in parallel on the shared compute pool, and
+   * returned in file order. This does not change the position used by
+   * read_next(). If the file has no frame index, or the index does not
+   * match the records, the file is scanned sequentially instead.
+   *
+   * @param first_frame First frame number to read.
+   * @param last_frame Last frame number to read (inclusive).
+   * @param[out] frames Timestamp and objects of each frame in the range.
+   * @param max_threads Maximum number of threads, 0 for the core budget
+   * of the compute pool.
+   *
+   * @return \b false if the file can not be read.
+   */
+  bool read_frames( unsigned first_frame, unsigned last_frame,
+                    std::vector< ts_object_vector_t >& frames,
+                    unsigned max_threads = 0 );
+
 
 private:
+  // Sequential fallbacks for files without a usable frame index
+  bool scan_to_frame( unsigned frame_number, std::streamoff& offset ) const;
+  bool scan_frames( unsigned first_frame, unsigned last_frame,
+                    std::vector< ts_object_vector_t >& frames ) const;
+
   std::ifstream m_stream;
 
+  // Frame index footer, if present, and the end of the records
+  image_object_protobuf_index_t m_index;
+  boost::uint64_t m_data_end;
+
   // Current batch of data we are working on
   timestamp m_timestamp;
   std::vector< image_object_sptr > m_obj_list;
@@ -53,6 +53,10 @@ image_object_writer_process
   config_.add_parameter( "format", "0", config_help );
   config_.add_parameter( "filename", "", "Output filename" );
   config_.add_parameter( "overwrite_existing", "false", "Overwrite existing file" );
+  config_.add_parameter( "flush_interval", "0",
+                         "Number of frames between flushes of the output file, for formats "
+                         "which buffer their output (protobuf). 0 only flushes when the "
+                         "buffer is full and at the end of the stream." );
 }
 
 
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2014-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2014-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -26,6 +26,9 @@ namespace vidtk
 
 VIDTK_LOGGER ("image_object_writer_protobuf");
 
+// Size at which buffered records are written to the file
+static std::streamoff const max_buffer_size = 1 << 20;
+
 // ----------------------------------------------------------------
 /** Constructor
  *
@@ -33,14 +36,17 @@ VIDTK_LOGGER ("image_object_writer_protobuf");
  */
 image_object_writer_protobuf
 ::image_object_writer_protobuf()
-  : fstr_ (0)
+  : fstr_ (0),
+    written_ (0),
+    flush_interval_ (0),
+    frames_since_flush_ (0)
 { }
 
 
 image_object_writer_protobuf
 ::~image_object_writer_protobuf()
 {
-  delete fstr_;
+  finish();
 }
 
 
@@ -55,6 +61,21 @@ image_object_writer_protobuf
     return false;
   }
 
+  try
+  {
+    // Not all users of the writer provide this parameter
+    flush_interval_ = 0;
+    if ( blk.has( "flush_interval" ) )
+    {
+      flush_interval_ = blk.get < unsigned >( "flush_interval" );
+    }
+  }
+  catch( config_block_parse_error& e)
+  {
+    LOG_ERROR ("image_object_writer_protobuf: " << e.what() );
+    return false;
+  }
+
   // Force .kwpc extension (for Kitware protobuf container
   std::string fn_only = vul_file::strip_directory( filename_ );
   // Just in case the path includes a '.', strip_extension() is being supplied
@@ -62,11 +83,15 @@ image_object_writer_protobuf
   std::string fn = vul_file::dirname( filename_ ) + "/" +
     vul_file::strip_extension(fn_only) + ".kwpc";
 
-  delete fstr_;
-  fstr_ = new std::ofstream( fn.c_str() );
+  finish();
+
+  // Binary mode, so that the offsets in the frame index are exact
+  fstr_ = new std::ofstream( fn.c_str(), std::ios::out | std::ios::binary );
   if( ! *fstr_ )
   {
     LOG_ERROR( "Couldn't open " << fn << " for writing." );
+    delete fstr_;
+    fstr_ = NULL;
     return false;
   }
 
@@ -112,10 +137,80 @@ image_object_writer_protobuf
   tainer = protobuf_container::create_message_container( tu );
   slice->add_container( tainer );
 
-  // Serialize container to stream
-  slice->serialize_to_stream(*fstr_);
+  // Serialize container to the buffer, recording where it starts
+  image_object_protobuf_index_entry entry;
+  std::streamoff const start = buffer_.tellp();
+
+  slice->serialize_to_stream( buffer_ );
+
+  entry.offset = written_ + start;
+  entry.size = buffer_.tellp() - start;
+  if ( ts.has_frame_number() )
+  {
+    entry.frame_number = ts.frame_number();
+  }
+  if ( ts.has_time() )
+  {
+    entry.time = ts.time();
+  }
+  index_.push_back( entry );
+
+  ++frames_since_flush_;
+  if ( flush_interval_ > 0 && frames_since_flush_ >= flush_interval_ )
+  {
+    write_buffer( true );
+  }
+  else if ( buffer_.tellp() >= max_buffer_size )
+  {
+    write_buffer( false );
+  }
+}
+
+
+// ----------------------------------------------------------------
+void
+image_object_writer_protobuf
+::write_buffer( bool flush )
+{
+  std::string const data = buffer_.str();
+
+  fstr_->write( data.data(), data.size() );
+  written_ += data.size();
+
+  buffer_.str( std::string() );
+
+  if ( flush )
+  {
+    fstr_->flush();
+    frames_since_flush_ = 0;
+  }
+}
+
+
+// ----------------------------------------------------------------
+void
+image_object_writer_protobuf
+::finish()
+{
+  if ( fstr_ == NULL )
+  {
+    return;
+  }
+
+  write_buffer( false );
+  write_image_object_protobuf_index( *fstr_, index_ );
+
+  if ( ! *fstr_ )
+  {
+    LOG_ERROR( "Failed writing image objects to " << filename_ );
+  }
+
+  delete fstr_;
+  fstr_ = NULL;
 
-  fstr_->flush();
+  written_ = 0;
+  frames_since_flush_ = 0;
+  index_.clear();
 }
 
 } // end namespace
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2014-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2014-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -8,14 +8,25 @@
 #define _VIDTK_IMAGE_OBJECT_WRITER_PROTOBUF_H_
 
 #include <tracking_data/io/image_object_writer.h>
+#include <tracking_data/io/image_object_protobuf_index.h>
+
 #include <fstream>
+#include <sstream>
 
 namespace vidtk {
 
 // ----------------------------------------------------------------
 /**
- * @brief
+ * @brief Write image objects in Kitware protobuf container format.
+ *
+ * Each frame with objects is serialized as one container record.
+ * Records are collected in memory and written to the file in large
+ * batches, with the file flushed every \c flush_interval frames (or
+ * only when the batch is full and at the end, if the interval is 0).
  *
+ * When the writer is destroyed, a frame index footer is appended to
+ * the file (see image_object_protobuf_index_entry), which allows the
+ * reader to seek to frames and read frame ranges in parallel.
  */
 class image_object_writer_protobuf
   : public image_object_writer
@@ -28,7 +39,21 @@ public:
   virtual void write( timestamp const& ts, std::vector< image_object_sptr > const& objs );
 
 private:
+  void write_buffer( bool flush );
+  void finish();
+
   std::ofstream * fstr_; // output file stream
+
+  // Records not yet written to the file
+  std::ostringstream buffer_;
+
+  // Bytes written to the file so far
+  boost::uint64_t written_;
+
+  image_object_protobuf_index_t index_;
+
+  unsigned flush_interval_;
+  unsigned frames_since_flush_;
 }; // end class image_object_writer_protobuf
 
 } // end namespace
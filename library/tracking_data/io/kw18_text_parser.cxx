@@ -0,0 +1,394 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "kw18_text_parser.h"
+
+#include <boost/cstdint.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace vidtk {
+
+namespace {
+
+// Smallest range worth parsing as a separate task
+const std::size_t min_range_bytes = 256 * 1024;
+
+// Largest mantissa which is exactly representable as a double
+const boost::uint64_t max_exact_mantissa = boost::uint64_t( 1 ) << 53;
+
+// Powers of ten which are exactly representable as a double
+const double exact_powers_of_ten[] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int max_exact_power = 22;
+
+
+// White space as classified by isspace() in the "C" locale
+inline bool
+is_space( char c )
+{
+  return c == ' ' || ( c >= '\t' && c <= '\r' );
+}
+
+
+inline bool
+is_digit( char c )
+{
+  return c >= '0' && c <= '9';
+}
+
+
+// Slow but exact conversions of a copy of the text
+int
+copy_and_atoi( char const* begin, char const* end )
+{
+  return std::atoi( std::string( begin, end ).c_str() );
+}
+
+
+double
+copy_and_atof( char const* begin, char const* end )
+{
+  return std::atof( std::string( begin, end ).c_str() );
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------
+char const*
+kw18_text_line_end( char const* begin, char const* end,
+                    std::size_t min_bytes )
+{
+  if( static_cast< std::size_t >( end - begin ) <= min_bytes )
+  {
+    return end;
+  }
+
+  char const* pos = begin + min_bytes;
+  char const* nl = static_cast< char const* >( std::memchr( pos, '\n', end - pos ) );
+
+  return ( nl ? nl + 1 : end );
+}
+
+
+// ----------------------------------------------------------------
+void
+split_kw18_text( char const* begin, char const* end,
+                 unsigned max_ranges,
+                 std::vector< kw18_text_range >& ranges )
+{
+  ranges.clear();
+
+  const std::size_t bytes = end - begin;
+  std::size_t range_bytes = bytes / ( max_ranges ? max_ranges : 1 );
+
+  if( range_bytes < min_range_bytes )
+  {
+    range_bytes = min_range_bytes;
+  }
+
+  char const* pos = begin;
+
+  while( pos < end )
+  {
+    kw18_text_range range;
+    range.begin = pos;
+    range.end = kw18_text_line_end( pos, end, range_bytes );
+
+    ranges.push_back( range );
+    pos = range.end;
+  }
+}
+
+
+// ----------------------------------------------------------------
+kw18_line
+::kw18_line()
+  : line_begin_( 0 ),
+    line_end_( 0 ),
+    size_( 0 )
+{
+}
+
+
+bool
+kw18_line
+::read( char const*& pos, char const* end )
+{
+  while( pos < end )
+  {
+    char const* nl = static_cast< char const* >( std::memchr( pos, '\n', end - pos ) );
+    char const* line_stop = ( nl ? nl : end );
+
+    line_begin_ = pos;
+    pos = ( nl ? nl + 1 : end );
+
+    // Drop any comment
+    char const* comment = static_cast< char const* >(
+      std::memchr( line_begin_, '#', line_stop - line_begin_ ) );
+    line_end_ = ( comment ? comment : line_stop );
+
+    // Skip lines with only white space, as blank_line_filter does
+    char const* c = line_begin_;
+    while( c < line_end_ && is_space( *c ) )
+    {
+      ++c;
+    }
+
+    if( c == line_end_ )
+    {
+      continue;
+    }
+
+    // Split on spaces only, as the tokenizer did
+    size_ = 0;
+    c = line_begin_;
+
+    while( c < line_end_ )
+    {
+      if( *c == ' ' )
+      {
+        ++c;
+        continue;
+      }
+
+      char const* col_begin = c;
+      while( c < line_end_ && *c != ' ' )
+      {
+        ++c;
+      }
+
+      if( size_ < max_columns )
+      {
+        col_begin_[size_] = col_begin;
+        col_end_[size_] = c;
+      }
+      ++size_;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
+unsigned
+kw18_line
+::size() const
+{
+  return size_;
+}
+
+
+int
+kw18_line
+::as_int( unsigned col ) const
+{
+  return kw18_parse_int( col_begin_[col], col_end_[col] );
+}
+
+
+double
+kw18_line
+::as_double( unsigned col ) const
+{
+  return kw18_parse_double( col_begin_[col], col_end_[col] );
+}
+
+
+char const*
+kw18_line
+::begin() const
+{
+  return line_begin_;
+}
+
+
+char const*
+kw18_line
+::end() const
+{
+  return line_end_;
+}
+
+
+std::string
+kw18_line
+::text() const
+{
+  return std::string( line_begin_, line_end_ );
+}
+
+
+// ----------------------------------------------------------------
+int
+kw18_parse_int( char const* begin, char const* end )
+{
+  char const* p = begin;
+
+  while( p < end && is_space( *p ) )
+  {
+    ++p;
+  }
+
+  bool negative = false;
+  if( p < end && ( *p == '-' || *p == '+' ) )
+  {
+    negative = ( *p == '-' );
+    ++p;
+  }
+
+  // Nine digits can not overflow an int
+  int value = 0;
+  unsigned digits = 0;
+
+  while( p < end && is_digit( *p ) )
+  {
+    if( ++digits > 9 )
+    {
+      return copy_and_atoi( begin, end );
+    }
+
+    value = value * 10 + ( *p - '0' );
+    ++p;
+  }
+
+  return ( negative ? -value : value );
+}
+
+
+// ----------------------------------------------------------------
+/*
+ * The value is computed directly only when the decimal mantissa and
+ * the power of ten are both exactly representable as doubles. The
+ * single multiplication or division is then correctly rounded, just
+ * as strtod() is, so the results are identical. Anything else (long
+ * mantissas, large exponents, hexadecimal, inf or nan) is converted
+ * by atof() itself.
+ */
+double
+kw18_parse_double( char const* begin, char const* end )
+{
+  char const* p = begin;
+
+  while( p < end && is_space( *p ) )
+  {
+    ++p;
+  }
+
+  bool negative = false;
+  if( p < end && ( *p == '-' || *p == '+' ) )
+  {
+    negative = ( *p == '-' );
+    ++p;
+  }
+
+  boost::uint64_t mantissa = 0;
+  unsigned digits = 0;
+  bool any_digits = false;
+  int exponent = 0;
+
+  while( p < end && is_digit( *p ) )
+  {
+    any_digits = true;
+
+    if( mantissa != 0 || *p != '0' )
+    {
+      if( ++digits > 18 )
+      {
+        return copy_and_atof( begin, end );
+      }
+      mantissa = mantissa * 10 + ( *p - '0' );
+    }
+    ++p;
+  }
+
+  if( p < end && *p == '.' )
+  {
+    ++p;
+
+    while( p < end && is_digit( *p ) )
+    {
+      any_digits = true;
+
+      if( mantissa != 0 || *p != '0' )
+      {
+        if( ++digits > 18 )
+        {
+          return copy_and_atof( begin, end );
+        }
+        mantissa = mantissa * 10 + ( *p - '0' );
+      }
+      --exponent;
+      ++p;
+    }
+  }
+
+  if( !any_digits || ( p < end && ( *p == 'x' || *p == 'X' ) ) )
+  {
+    return copy_and_atof( begin, end );
+  }
+
+  // The exponent is only part of the number if it has digits
+  if( p < end && ( *p == 'e' || *p == 'E' ) )
+  {
+    char const* e = p + 1;
+
+    bool negative_exp = false;
+    if( e < end && ( *e == '-' || *e == '+' ) )
+    {
+      negative_exp = ( *e == '-' );
+      ++e;
+    }
+
+    if( e < end && is_digit( *e ) )
+    {
+      int exp_value = 0;
+
+      while( e < end && is_digit( *e ) )
+      {
+        if( exp_value > 1000 )
+        {
+          return copy_and_atof( begin, end );
+        }
+        exp_value = exp_value * 10 + ( *e - '0' );
+        ++e;
+      }
+
+      exponent += ( negative_exp ? -exp_value : exp_value );
+    }
+  }
+
+  double value;
+
+  if( mantissa == 0 )
+  {
+    value = 0.0;
+  }
+  else if( mantissa > max_exact_mantissa ||
+           exponent > max_exact_power || exponent < -max_exact_power )
+  {
+    return copy_and_atof( begin, end );
+  }
+  else if( exponent >= 0 )
+  {
+    value = static_cast< double >( mantissa ) * exact_powers_of_ten[exponent];
+  }
+  else
+  {
+    value = static_cast< double >( mantissa ) / exact_powers_of_ten[-exponent];
+  }
+
+  return ( negative ? -value : value );
+}
+
+} // end namespace
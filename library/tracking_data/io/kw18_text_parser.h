@@ -0,0 +1,129 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef _VIDTK_KW18_TEXT_PARSER_H_
+#define _VIDTK_KW18_TEXT_PARSER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace vidtk {
+
+// ----------------------------------------------------------------
+/**
+ * @brief Part of the text of a kw18 file.
+ *
+ * The text is not copied; it points into a buffer such as a
+ * vidtk::mapped_file, which must outlive it.
+ */
+struct kw18_text_range
+{
+  char const* begin;
+  char const* end;
+};
+
+
+/**
+ * @brief Split kw18 text into ranges of whole lines.
+ *
+ * Every range except the last ends just after a newline, so the
+ * ranges can be parsed independently (e.g. on separate threads) and
+ * the results concatenated in order.
+ *
+ * @param begin Start of the text.
+ * @param end End of the text.
+ * @param max_ranges Maximum number of ranges to create. Fewer are
+ * created for small texts, so that each range holds enough lines to
+ * be worth a task of its own.
+ * @param[out] ranges Ranges covering the whole text, in order.
+ */
+void split_kw18_text( char const* begin, char const* end,
+                      unsigned max_ranges,
+                      std::vector< kw18_text_range >& ranges );
+
+
+/**
+ * @brief Find the end of the first range of whole lines.
+ *
+ * @return The position just after the first newline at or after
+ * \a begin + \a min_bytes, or \a end if there is none.
+ */
+char const* kw18_text_line_end( char const* begin, char const* end,
+                                std::size_t min_bytes );
+
+
+// ----------------------------------------------------------------
+/**
+ * @brief One data line of a kw18 file, split into columns.
+ *
+ * Lines are handled exactly as the kw18 readers did when reading
+ * through a stream filtered by vidtk::shell_comments_filter and
+ * vidtk::blank_line_filter and split with a boost::tokenizer on
+ * spaces:
+ *
+ * - everything from a '#' to the end of the line is ignored,
+ * - lines holding only white space are skipped,
+ * - columns are separated by one or more spaces (only), and
+ * - column values are converted as atoi() and atof() would in the
+ *   "C" locale, without copying or allocating for the common case.
+ */
+class kw18_line
+{
+public:
+  /// Number of columns whose text is kept. Lines may have more.
+  static const unsigned max_columns = 20;
+
+  kw18_line();
+
+  /**
+   * @brief Read the next data line.
+   *
+   * @param[in,out] pos Position to start reading at, advanced past
+   * the line that was read.
+   * @param end End of the text.
+   *
+   * @return \b false if there are no more data lines before \a end.
+   */
+  bool read( char const*& pos, char const* end );
+
+  /// Number of columns in the line.
+  unsigned size() const;
+
+  /// Value of a column, as atoi() would convert it.
+  int as_int( unsigned col ) const;
+
+  /// Value of a column, as atof() would convert it.
+  double as_double( unsigned col ) const;
+
+  /// Start of the text of the line.
+  char const* begin() const;
+
+  /// End of the text of the line, before any comment or newline.
+  char const* end() const;
+
+  /// Text of the line, without any comment or newline.
+  std::string text() const;
+
+private:
+  char const* line_begin_;
+  char const* line_end_;
+
+  char const* col_begin_[max_columns];
+  char const* col_end_[max_columns];
+  unsigned size_;
+};
+
+
+/// Convert text to an int with the same result as atoi().
+int kw18_parse_int( char const* begin, char const* end );
+
+/// Convert text to a double with the same result as atof().
+double kw18_parse_double( char const* begin, char const* end );
+
+} // end namespace
+
+#endif /* _VIDTK_KW18_TEXT_PARSER_H_ */
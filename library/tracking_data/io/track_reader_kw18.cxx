@@ -10,6 +10,7 @@
 #include <fstream>
 #include <cstdio>
 #include <tracking_data/tracking_keys.h>
+#include <tracking_data/io/kw18_text_parser.h>
 #include <vil/vil_load.h>
 #include <vil/vil_new.h>
 #include <vil/vil_image_resource.h>
@@ -20,9 +21,12 @@
 
 #include <utilities/shell_comments_filter.h>
 #include <utilities/blank_line_filter.h>
+#include <utilities/compute_pool.h>
+#include <utilities/mapped_file.h>
 #include <logger/logger.h>
-#include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 
 
 namespace vidtk {
@@ -58,6 +62,123 @@ VIDTK_LOGGER( "track_reader_kw18" );
     COL_CONFIDENCE// 18
   };
 
+  // One track state parsed from the file
+  struct kw18_track_row
+  {
+    int id;
+    vidtk::track_state_sptr state;
+    vidtk::image_object_sptr obj;
+  };
+
+  // Track states parsed from one range of lines
+  struct kw18_track_rows
+  {
+    kw18_track_rows()
+      : bad_columns( 0 )
+    { }
+
+    std::vector< kw18_track_row > rows;
+
+    // Column count and text of the line that stopped parsing, if any
+    unsigned bad_columns;
+    std::string bad_line;
+  };
+
+
+// ----------------------------------------------------------------
+/** Parse the track states in a range of lines.
+ *
+ * Parsing stops at the first line which does not have a kw18 column
+ * count. This is called on multiple threads at once, one per range,
+ * so it must only touch objects it creates.
+ */
+void
+parse_track_rows( kw18_text_range range,
+                  bool read_lat_lon_for_world,
+                  kw18_track_rows* output )
+{
+  kw18_line line;
+  char const* pos = range.begin;
+
+  std::vector< vidtk::image_object_sptr > objs( 1 );
+
+  while ( line.read( pos, range.end ) )
+  {
+    if ( ( line.size() < 18 ) || ( line.size() > 20 ) )
+    {
+      output->bad_columns = line.size();
+      output->bad_line = line.text();
+      return;
+    }
+
+    vidtk::track_state_sptr new_state = new vidtk::track_state;
+
+    new_state->time_.set_frame_number( line.as_int( COL_FRAME ) );
+    new_state->loc_[0] = line.as_double( COL_LOC_X );
+    new_state->loc_[1] = line.as_double( COL_LOC_Y );
+    new_state->loc_[2] = 0;
+
+    new_state->vel_[0] = line.as_double( COL_VEL_X );
+    new_state->vel_[1] = line.as_double( COL_VEL_Y );
+    new_state->vel_[2] = 0;
+
+    image_object_sptr obj = new image_object;
+    obj->set_image_loc( line.as_double( COL_IMG_LOC_X ),
+                        line.as_double( COL_IMG_LOC_Y ) );
+
+    int min_x = line.as_int( COL_MIN_X );
+    int max_x = line.as_int( COL_MAX_X );
+    int min_y = line.as_int( COL_MIN_Y );
+    int max_y = line.as_int( COL_MAX_Y );
+
+    obj->set_bbox(
+      ( min_x < 0 ? 0 : min_x ),
+      ( max_x < 0 ? 0 : max_x ),
+      ( min_y < 0 ? 0 : min_y ),
+      ( max_y < 0 ? 0 : max_y ) );
+
+    obj->set_area( line.as_double( COL_AREA ) );
+
+    // If specified, we need to interpret the world location as a
+    // lat/lon coordinate
+    if ( read_lat_lon_for_world )
+    {
+      new_state->set_latitude_longitude( line.as_double( COL_WORLD_Y ), // latitude
+                                         line.as_double( COL_WORLD_X ) ); // longitude
+    }
+    else
+    {
+      obj->set_world_loc( line.as_double( COL_WORLD_X ), // x
+                          line.as_double( COL_WORLD_Y ), // y
+                          line.as_double( COL_WORLD_Z ) ); // z
+    }
+
+    objs[0] = obj;
+    new_state->data_.set( tracking_keys::img_objs, objs );
+
+    new_state->amhi_bbox_.set_min_x( min_x );
+    new_state->amhi_bbox_.set_min_y( min_y );
+    new_state->amhi_bbox_.set_max_x( max_x );
+    new_state->amhi_bbox_.set_max_y( max_y );
+
+    // time_ is a timestamp which keeps time in microseconds.  All
+    // kw18 files so far have time written in seconds so, convert from
+    // seconds to microseconds.
+    new_state->time_.set_time( line.as_double( COL_TIME ) * 1e6 );
+
+    if( line.size() == 19 )
+    {
+      new_state->set_track_confidence( line.as_double( COL_CONFIDENCE ) );
+    }
+
+    kw18_track_row row;
+    row.id = line.as_int( 0 );
+    row.state = new_state;
+    row.obj = obj;
+    output->rows.push_back( row );
+  } // ...while lines
+}
+
 } // end namepsace
 
 
@@ -68,7 +189,7 @@ VIDTK_LOGGER( "track_reader_kw18" );
  */
 track_reader_kw18
 ::track_reader_kw18()
-: in_stream_(0),
+: is_open_(false),
   read_pixel_data_(false),
   been_read_(false)
 {
@@ -126,7 +247,7 @@ bool track_reader_kw18
 {
   bool status( false );
 
-  if ( 0 != in_stream_ ) // meaning we are already open
+  if ( is_open_ ) // meaning we are already open
   {
     return filename_ == filename;
   }
@@ -138,20 +259,14 @@ bool track_reader_kw18
     return false;
   }
 
-  std::ifstream fstr( this->filename_.c_str() );
-  if ( ! fstr )
+  vidtk::mapped_file file;
+  if ( ! file.open( this->filename_ ) )
   {
     LOG_ERROR( "kw18 reader could not open " << this->filename_ << " for reading." );
     return false;
   }
 
-  // build boost filter to remove comments and blank lines
-  // order is important.
-  in_stream_ = new boost::iostreams::filtering_istream();
-
-  in_stream_->push( vidtk::blank_line_filter() );
-  in_stream_->push( vidtk::shell_comments_filter() );
-  in_stream_->push( fstr );
+  is_open_ = true;
 
   // If a path to images is specified, then get images
   if ( ! this->reader_options_.get_path_to_images().empty() )
@@ -166,7 +281,7 @@ bool track_reader_kw18
   }
 
   // Read all tracks from file
-  if ( read_all_tracks() )
+  if ( read_all_tracks( file.data(), file.data() + file.size() ) )
   {
     sort_terminated( all_tracks_ );
     return true;
@@ -213,165 +328,126 @@ track_reader_kw18
 
 
 // ----------------------------------------------------------------
-/** Read all tracks from stream.
+/** Read all tracks from the file contents.
  *
  * Return false if error; true if tracks are read and vectorized.
  */
 bool
 track_reader_kw18
-::read_all_tracks()
+::read_all_tracks( char const* begin, char const* end )
 {
-  std::string line;
-  id_map_t id_to_index;
-
-  std::vector< std::string > col;
-  std::vector< image_object_sptr > objs( 1 );
-
-  while (std::getline(*in_stream_, line))
-  {
-    col.clear();
-    boost::char_separator < char > sep(" ");
-    typedef boost::tokenizer < boost::char_separator<char> > tok_t;
-    tok_t tok( line, sep );
-    for(tok_t::iterator it = tok.begin(); it != tok.end(); ++it)
-    {
-      col.push_back( *it );
-    }
-
-    // skip lines suppressed by filtered stream
-    if ( col.empty() )
-    {
-      continue;
-    }
-
-    if ( ( col.size() < 18 ) || ( col.size() > 20 ) )
-    {
-      LOG_ERROR( "This is not a kw18 kw19 or kw20 file; found " << col.size() <<
-                 " columns in\n\"" << line << "\"" );
-      return false;
-    }
-
-    /*
-     * Check to see if we have seen this track before. If we have,
-     * then retrieve the track's index into our output vector. If not
-     * seen before, add track id -> track vector index to our map and
-     * press on.
-     *
-     * This allows for track states to be written in a non-contiguous
-     * manner as may be done by streaming writers.
-     */
-    int index;
-    int id = atoi( col[0].c_str() );
-    id_map_t::iterator itr = id_to_index.find( id );
-    if ( itr == id_to_index.end() )
-    {
-      // create a new track
-      vidtk::track_sptr to_push = new vidtk::track;
-      to_push->set_id( id );
-      this->all_tracks_.push_back( to_push );
-
-      index = this->all_tracks_.size() - 1;
-      id_to_index[id] = index;
-    }
-    else
-    {
-      index = itr->second;
-    }
+  compute_pool_t pool = compute_pool::instance();
 
-    vidtk::track_state_sptr new_state = new vidtk::track_state;
-
-    new_state->time_.set_frame_number( atoi( col[COL_FRAME].c_str() ) );
-    new_state->loc_[0] = atof( col[COL_LOC_X].c_str() );
-    new_state->loc_[1] = atof( col[COL_LOC_Y].c_str() );
-    new_state->loc_[2] = 0;
+  // Use several ranges per thread, since line lengths vary
+  std::vector< kw18_text_range > ranges;
+  split_kw18_text( begin, end, 4 * pool->core_budget(), ranges );
 
-    new_state->vel_[0] = atof( col[COL_VEL_X].c_str() );
-    new_state->vel_[1] = atof( col[COL_VEL_Y].c_str() );
-    new_state->vel_[2] = 0;
+  std::vector< kw18_track_rows > parsed( ranges.size() );
+  std::vector< compute_pool::task_t > tasks;
 
-    image_object_sptr obj = new image_object;
-    obj->set_image_loc( atof( col[COL_IMG_LOC_X].c_str() ),
-                        atof( col[COL_IMG_LOC_Y].c_str() ));
+  for ( size_t i = 0; i < ranges.size(); ++i )
+  {
+    tasks.push_back( boost::bind( &parse_track_rows, ranges[i],
+                                  this->reader_options_.get_read_lat_lon_for_world(),
+                                  &parsed[i] ) );
+  }
 
-    int min_x = atoi( col[COL_MIN_X].c_str() );
-    int max_x = atoi( col[COL_MAX_X].c_str() );
-    int min_y = atoi( col[COL_MIN_Y].c_str() );
-    int max_y = atoi( col[COL_MAX_Y].c_str() );
+  pool->run( tasks, "track_reader_kw18" );
 
-    obj->set_bbox(
-      ( min_x < 0 ? 0 : min_x ),
-      ( max_x < 0 ? 0 : max_x ),
-      ( min_y < 0 ? 0 : min_y ),
-      ( max_y < 0 ? 0 : max_y ) );
+  id_map_t id_to_index;
 
-    obj->set_area( atof( col[COL_AREA].c_str() ) );
+  // Merge the states into their tracks in file order
+  for ( size_t i = 0; i < parsed.size(); ++i )
+  {
+    std::vector< kw18_track_row >& rows = parsed[i].rows;
 
-    // If specified, we need to interpret the world location as a
-    // lat/lon coordinate
-    if ( this->reader_options_.get_read_lat_lon_for_world() )
+    for ( size_t r = 0; r < rows.size(); ++r )
     {
-      new_state->set_latitude_longitude( atof( col[COL_WORLD_Y].c_str() ), // latitude
-                                         atof( col[COL_WORLD_X].c_str() ) ); // longitude
-    }
-    else
-    {
-      obj->set_world_loc(atof( col[COL_WORLD_X].c_str() ), // x
-                         atof( col[COL_WORLD_Y].c_str() ), // y
-                         atof( col[COL_WORLD_Z].c_str() )); // z
-    }
+      /*
+       * Check to see if we have seen this track before. If we have,
+       * then retrieve the track's index into our output vector. If not
+       * seen before, add track id -> track vector index to our map and
+       * press on.
+       *
+       * This allows for track states to be written in a non-contiguous
+       * manner as may be done by streaming writers.
+       */
+      int index;
+      int id = rows[r].id;
+      id_map_t::iterator itr = id_to_index.find( id );
+      if ( itr == id_to_index.end() )
+      {
+        // create a new track
+        vidtk::track_sptr to_push = new vidtk::track;
+        to_push->set_id( id );
+        this->all_tracks_.push_back( to_push );
 
-    if ( this->read_pixel_data_ )
-    {
-      if (new_state->time_.frame_number() >= this->image_names_.size())
+        index = this->all_tracks_.size() - 1;
+        id_to_index[id] = index;
+      }
+      else
       {
-        LOG_ERROR( "kw18 reader does not have image file name for this frame" );
+        index = itr->second;
       }
 
-      //Read the image from file
-      vil_image_view< vxl_byte > src_img = vil_load( this->image_names_[new_state->time_.frame_number()].c_str() );
-      if ( ! src_img )
+      if ( this->read_pixel_data_ )
       {
-        LOG_ERROR( "kw18 reader could not load image from file \""
-                   <<  this->image_names_[new_state->time_.frame_number()]
-                   << "\"" );
+        read_image_chip( rows[r].obj, rows[r].state->time_.frame_number() );
       }
 
-      const vgl_box_2d< unsigned >& obj_bbox = obj->get_bbox();
-      vil_image_view< vxl_byte > img_crop = vil_crop( src_img,
-                obj_bbox.min_x(), obj_bbox.max_x() - obj_bbox.min_x(),
-                obj_bbox.min_y(), obj_bbox.max_y() - obj_bbox.min_y() );
+      this->all_tracks_[index]->add_state( rows[r].state );
+    }
 
-      vil_image_view< vxl_byte > bbox_pxls;
-      bbox_pxls.deep_copy( img_crop );
+    // Release the parsed rows as soon as they are merged
+    std::vector< kw18_track_row >().swap( rows );
 
-      vil_image_resource_sptr data = vil_new_image_resource_of_view( bbox_pxls );
-      obj->set_image_chip( data, 0u );
-    } // end read pixel data
+    if ( parsed[i].bad_columns != 0 )
+    {
+      LOG_ERROR( "This is not a kw18 kw19 or kw20 file; found " << parsed[i].bad_columns <<
+                 " columns in\n\"" << parsed[i].bad_line << "\"" );
+      return false;
+    }
+  } // ...for ranges
 
-    objs[0] = obj;
-    new_state->data_.set( tracking_keys::img_objs, objs );
+  return true;
+} // read_all_tracks
 
-    new_state->amhi_bbox_.set_min_x( atoi( col[COL_MIN_X].c_str() ) );
-    new_state->amhi_bbox_.set_min_y( atoi( col[COL_MIN_Y].c_str() ) );
-    new_state->amhi_bbox_.set_max_x( atoi( col[COL_MAX_X].c_str() ) );
-    new_state->amhi_bbox_.set_max_y( atoi( col[COL_MAX_Y].c_str() ) );
 
-    // time_ is a timestamp which keeps time in microseconds.  All
-    // kw18 files so far have time written in seconds so, convert from
-    // seconds to microseconds.
-    new_state->time_.set_time( atof( col[COL_TIME].c_str() ) * 1e6 );
+// ----------------------------------------------------------------
+/** Read the image chip of an object.
+ *
+ * The chip is cropped from the image of the given frame, found in
+ * the images directory.
+ */
+void
+track_reader_kw18
+::read_image_chip( image_object_sptr const& obj, unsigned frame )
+{
+  if (frame >= this->image_names_.size())
+  {
+    LOG_ERROR( "kw18 reader does not have image file name for this frame" );
+  }
 
-    if( col.size() == 19 )
-    {
-      new_state->set_track_confidence( atof( col[COL_CONFIDENCE].c_str() ) );
-    }
+  //Read the image from file
+  vil_image_view< vxl_byte > src_img = vil_load( this->image_names_[frame].c_str() );
+  if ( ! src_img )
+  {
+    LOG_ERROR( "kw18 reader could not load image from file \""
+               <<  this->image_names_[frame]
+               << "\"" );
+  }
 
-    this->all_tracks_[index]->add_state( new_state );
+  const vgl_box_2d< unsigned >& obj_bbox = obj->get_bbox();
+  vil_image_view< vxl_byte > img_crop = vil_crop( src_img,
+            obj_bbox.min_x(), obj_bbox.max_x() - obj_bbox.min_x(),
+            obj_bbox.min_y(), obj_bbox.max_y() - obj_bbox.min_y() );
 
-  } // ...while !eof
+  vil_image_view< vxl_byte > bbox_pxls;
+  bbox_pxls.deep_copy( img_crop );
 
-  return true;
-} // read_all_tracks
+  vil_image_resource_sptr data = vil_new_image_resource_of_view( bbox_pxls );
+  obj->set_image_chip( data, 0u );
+}
 
 
 // ----------------------------------------------------------------
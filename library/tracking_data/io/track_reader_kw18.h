@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -9,7 +9,7 @@
 
 
 #include <tracking_data/io/track_reader_interface.h>
-#include <boost/iostreams/filtering_stream.hpp>
+#include <tracking_data/image_object.h>
 
 
 namespace vidtk {
@@ -21,6 +21,12 @@ namespace ns_track_reader {
  *
  * This class is a specialized variant of track reader that only
  * handles KW18 format tracks.
+ *
+ * The whole file is memory mapped when it is opened and split into
+ * ranges of lines, which are parsed into track states in parallel on
+ * the shared compute pool. The states are then added to their tracks
+ * in file order, so the tracks are the same as if the file had been
+ * read one line at a time.
  * @sa track_reader
  */
 class track_reader_kw18
@@ -64,12 +70,13 @@ public:
 
 
 private:
-  bool read_all_tracks ();
+  bool read_all_tracks ( char const* begin, char const* end );
+  void read_image_chip ( image_object_sptr const& obj, unsigned frame );
   bool set_path_to_images(std::string const& path);
   bool validate_file ();
 
   vidtk::track::vector_t all_tracks_;
-  boost::iostreams::filtering_istream * in_stream_;
+  bool is_open_;
   std::vector< std::string > image_names_;
   bool read_pixel_data_;
   bool been_read_;
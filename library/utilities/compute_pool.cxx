@@ -0,0 +1,678 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+
+#include "compute_pool.h"
+
+#include <utilities/thread_util.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <logger/logger.h>
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "compute_pool_cxx" );
+
+//
+// pointer to our instance
+//
+compute_pool_t compute_pool::s_instance = compute_pool_t();
+
+
+namespace
+{
+
+typedef boost::posix_time::ptime ptime_t;
+
+ptime_t now()
+{
+  return boost::posix_time::microsec_clock::universal_time();
+}
+
+double seconds_since( ptime_t const& start )
+{
+  return ( now() - start ).total_microseconds() * 1e-6;
+}
+
+
+// A set of tasks submitted by a single call.
+struct batch
+{
+  batch()
+    : next( 0 ),
+      done( 0 ),
+      active( 0 ),
+      peak( 1 ),
+      worker_limit( 0 ),
+      task_seconds( 0.0 )
+  {}
+
+  std::vector< compute_pool::task_t > tasks;
+  std::string caller;
+  ptime_t start;
+
+  unsigned next;          // index of the next task to hand out
+  unsigned done;          // number of completed tasks
+  unsigned active;        // worker threads currently executing tasks
+  unsigned peak;          // most threads executing tasks at once
+  unsigned worker_limit;  // most worker threads allowed at once
+  double task_seconds;
+  std::string error;
+
+  boost::condition_variable done_cond;
+};
+
+typedef boost::shared_ptr< batch > batch_sptr;
+
+
+#ifdef __linux__
+
+// Parse a kernel cpu list such as "0-3,8-11".
+std::vector< int > parse_cpu_list( std::string const& list )
+{
+  std::vector< int > ids;
+  std::stringstream ss( list );
+  std::string range;
+
+  while( std::getline( ss, range, ',' ) )
+  {
+    int first = 0, last = 0;
+    char dash = 0;
+    std::stringstream rs( range );
+
+    if( !( rs >> first ) )
+    {
+      continue;
+    }
+
+    last = first;
+
+    if( rs >> dash && dash == '-' )
+    {
+      rs >> last;
+    }
+
+    for( int i = first; i <= last; ++i )
+    {
+      ids.push_back( i );
+    }
+  }
+
+  return ids;
+}
+
+
+// CPUs of each NUMA node, empty if the topology is not available.
+std::vector< std::vector< int > > detect_numa_nodes()
+{
+  std::vector< std::vector< int > > nodes;
+  std::string online;
+
+  std::ifstream online_file( "/sys/devices/system/node/online" );
+
+  if( !std::getline( online_file, online ) )
+  {
+    return nodes;
+  }
+
+  std::vector< int > node_ids = parse_cpu_list( online );
+
+  for( unsigned n = 0; n < node_ids.size(); ++n )
+  {
+    std::stringstream path;
+    path << "/sys/devices/system/node/node" << node_ids[n] << "/cpulist";
+
+    std::ifstream cpu_file( path.str().c_str() );
+    std::string cpus;
+
+    if( std::getline( cpu_file, cpus ) )
+    {
+      std::vector< int > cpu_ids = parse_cpu_list( cpus );
+
+      if( !cpu_ids.empty() )
+      {
+        nodes.push_back( cpu_ids );
+      }
+    }
+  }
+
+  return nodes;
+}
+
+#endif
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------
+class compute_pool::priv
+{
+public:
+  priv()
+    : budget( default_budget() ),
+      stop( false ),
+      workers_started( false )
+  {
+#ifdef __linux__
+    numa_nodes = detect_numa_nodes();
+#endif
+  }
+
+  static unsigned default_budget()
+  {
+    char const* env = std::getenv( "VIDTK_COMPUTE_CORES" );
+
+    if( env )
+    {
+      long const cores = std::strtol( env, NULL, 10 );
+
+      if( cores > 0 )
+      {
+        return static_cast< unsigned >( cores );
+      }
+
+      LOG_WARN( "Ignoring invalid VIDTK_COMPUTE_CORES value: " << env );
+    }
+
+    return std::max( 1u, boost::thread::hardware_concurrency() );
+  }
+
+  unsigned limit_for( unsigned max_concurrency ) const
+  {
+    unsigned const limit = ( max_concurrency > 0 ? std::min( max_concurrency, budget ) : budget );
+    return std::max( 1u, limit );
+  }
+
+  // Must be called with the lock held
+  void start_workers()
+  {
+    if( workers_started )
+    {
+      return;
+    }
+
+    workers_started = true;
+
+    for( unsigned id = 0; id + 1 < budget; ++id )
+    {
+      workers.push_back( boost::shared_ptr< boost::thread >(
+        new boost::thread( boost::bind( &priv::worker_job, this, id ) ) ) );
+    }
+  }
+
+  // Stop all workers and change the budget, must be called without the
+  // lock held. Workers finish their current task before exiting.
+  // Callers of run() keep executing their own tasks in the meantime,
+  // and their remaining tasks are picked up by the new workers.
+  void resize( unsigned new_budget, bool restart )
+  {
+    boost::lock_guard< boost::mutex > resize_lock( resize_mutex );
+
+    std::vector< boost::shared_ptr< boost::thread > > to_join;
+
+    {
+      boost::lock_guard< boost::mutex > lock( mutex );
+      stop = true;
+      to_join.swap( workers );
+    }
+
+    work_cond.notify_all();
+
+    for( unsigned i = 0; i < to_join.size(); ++i )
+    {
+      to_join[i]->join();
+    }
+
+    {
+      boost::lock_guard< boost::mutex > lock( mutex );
+      stop = false;
+      workers_started = false;
+      budget = new_budget;
+
+      if( restart && !queue.empty() && budget > 1 )
+      {
+        start_workers();
+      }
+    }
+
+    work_cond.notify_all();
+  }
+
+  void bind_to_node( unsigned id )
+  {
+#ifdef __linux__
+    if( numa_nodes.size() < 2 )
+    {
+      return;
+    }
+
+    std::vector< int > const& cpus = numa_nodes[ id % numa_nodes.size() ];
+
+    cpu_set_t set;
+    CPU_ZERO( &set );
+
+    for( unsigned i = 0; i < cpus.size(); ++i )
+    {
+      CPU_SET( cpus[i], &set );
+    }
+
+    if( pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) != 0 )
+    {
+      LOG_DEBUG( "Unable to bind compute thread " << id << " to its NUMA node" );
+    }
+#else
+    (void)id;
+#endif
+  }
+
+  void remove_from_queue( batch_sptr const& b )
+  {
+    std::deque< batch_sptr >::iterator it = std::find( queue.begin(), queue.end(), b );
+
+    if( it != queue.end() )
+    {
+      queue.erase( it );
+    }
+  }
+
+  // Must be called with the lock held. Batches take turns handing out
+  // tasks, so one caller with many tasks cannot starve the others.
+  bool claim_for_worker( batch_sptr& b, unsigned& index )
+  {
+    for( std::deque< batch_sptr >::iterator it = queue.begin(); it != queue.end(); ++it )
+    {
+      batch_sptr candidate = *it;
+
+      if( candidate->next < candidate->tasks.size() &&
+          candidate->active < candidate->worker_limit )
+      {
+        index = candidate->next++;
+        ++candidate->active;
+        candidate->peak = std::max( candidate->peak, candidate->active + 1 );
+
+        queue.erase( it );
+
+        if( candidate->next < candidate->tasks.size() )
+        {
+          queue.push_back( candidate );
+        }
+
+        b = candidate;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void execute( batch_sptr const& b, unsigned index, bool on_worker )
+  {
+    ptime_t const start = now();
+    std::string error;
+
+    try
+    {
+      b->tasks[index]();
+    }
+    catch( std::exception const& e )
+    {
+      error = e.what();
+    }
+    catch( ... )
+    {
+      error = "unknown exception";
+    }
+
+    double const elapsed = seconds_since( start );
+
+    boost::lock_guard< boost::mutex > lock( mutex );
+
+    b->task_seconds += elapsed;
+    ++b->done;
+
+    if( on_worker )
+    {
+      --b->active;
+    }
+
+    if( !error.empty() && b->error.empty() )
+    {
+      b->error = error;
+    }
+
+    if( b->done == b->tasks.size() )
+    {
+      b->done_cond.notify_all();
+    }
+    else if( on_worker && b->next < b->tasks.size() )
+    {
+      // A slot of this batch has opened up again
+      work_cond.notify_one();
+    }
+  }
+
+  // Must be called with the lock held
+  void record( batch const& b )
+  {
+    compute_pool_stats& s = stats[ b.caller ];
+
+    ++s.batches;
+    s.tasks += b.tasks.size();
+    s.task_seconds += b.task_seconds;
+    s.wall_seconds += seconds_since( b.start );
+    s.peak_concurrency = std::max( s.peak_concurrency, b.peak );
+  }
+
+  void worker_job( unsigned id )
+  {
+    std::stringstream name;
+    name << "vidtk_compute_" << id;
+    name_thread( name.str() );
+
+    bind_to_node( id );
+
+    while( true )
+    {
+      batch_sptr b;
+      unsigned index = 0;
+
+      {
+        boost::unique_lock< boost::mutex > lock( mutex );
+
+        while( !stop && !claim_for_worker( b, index ) )
+        {
+          work_cond.wait( lock );
+        }
+
+        if( !b )
+        {
+          return;
+        }
+      }
+
+      execute( b, index, true );
+    }
+  }
+
+  mutable boost::mutex mutex;
+  boost::mutex resize_mutex;
+  boost::condition_variable work_cond;
+
+  std::deque< batch_sptr > queue;
+  std::vector< boost::shared_ptr< boost::thread > > workers;
+  std::vector< std::vector< int > > numa_nodes;
+  std::map< std::string, compute_pool_stats > stats;
+
+  unsigned budget;
+  bool stop;
+  bool workers_started;
+};
+
+
+// ----------------------------------------------------------------
+/** Constructor
+ *
+ * Worker threads are not started until work is first submitted.
+ */
+compute_pool::compute_pool()
+  : d( new priv )
+{
+}
+
+
+compute_pool::~compute_pool()
+{
+  d->resize( d->budget, false );
+}
+
+
+// ----------------------------------------------------------------
+/** Get the instance
+ *
+ *
+ */
+compute_pool_t compute_pool
+::instance()
+{
+  static boost::mutex local_lock;          // synchronization lock
+
+  if (s_instance)
+  {
+    return s_instance;
+  }
+
+  boost::lock_guard<boost::mutex> lock(local_lock);
+  if (!s_instance)
+  {
+    // create new object
+    s_instance = compute_pool_t(new compute_pool);
+  }
+
+  return s_instance;
+}
+
+
+// ----------------------------------------------------------------
+/** Execute a set of tasks
+ *
+ * The calling thread hands out tasks to itself until none are left,
+ * then waits for any still running on worker threads.
+ */
+void compute_pool
+::run( std::vector< task_t > const& tasks,
+       std::string const& caller,
+       unsigned max_concurrency )
+{
+  if( tasks.empty() )
+  {
+    return;
+  }
+
+  batch_sptr b( new batch );
+  b->tasks = tasks;
+  b->caller = caller;
+  b->start = now();
+
+  {
+    boost::lock_guard< boost::mutex > lock( d->mutex );
+
+    b->worker_limit = std::min( d->limit_for( max_concurrency ),
+                                static_cast< unsigned >( tasks.size() ) ) - 1;
+
+    if( b->worker_limit > 0 )
+    {
+      d->start_workers();
+      d->queue.push_back( b );
+    }
+  }
+
+  for( unsigned i = 0; i < b->worker_limit; ++i )
+  {
+    d->work_cond.notify_one();
+  }
+
+  while( true )
+  {
+    unsigned index;
+
+    {
+      boost::lock_guard< boost::mutex > lock( d->mutex );
+
+      if( b->next >= b->tasks.size() )
+      {
+        break;
+      }
+
+      index = b->next++;
+
+      if( b->next == b->tasks.size() )
+      {
+        d->remove_from_queue( b );
+      }
+    }
+
+    d->execute( b, index, false );
+  }
+
+  {
+    boost::unique_lock< boost::mutex > lock( d->mutex );
+
+    while( b->done < b->tasks.size() )
+    {
+      b->done_cond.wait( lock );
+    }
+
+    d->record( *b );
+  }
+
+  if( !b->error.empty() )
+  {
+    throw std::runtime_error( caller + ": " + b->error );
+  }
+}
+
+
+void compute_pool
+::parallel_for( unsigned begin, unsigned end,
+                range_function_t const& func,
+                std::string const& caller,
+                unsigned max_concurrency )
+{
+  if( end <= begin )
+  {
+    return;
+  }
+
+  unsigned limit;
+
+  {
+    boost::lock_guard< boost::mutex > lock( d->mutex );
+    limit = d->limit_for( max_concurrency );
+  }
+
+  unsigned const count = end - begin;
+  unsigned const ranges = std::min( count, limit );
+  unsigned const step = ( count + ranges - 1 ) / ranges;
+
+  std::vector< task_t > tasks;
+
+  for( unsigned first = begin; first < end; first += step )
+  {
+    tasks.push_back( boost::bind( func, first, std::min( first + step, end ) ) );
+  }
+
+  run( tasks, caller, max_concurrency );
+}
+
+
+void compute_pool
+::parallel_for_tiles( vgl_box_2d<int> const& region,
+                      unsigned tiles_x, unsigned tiles_y,
+                      tile_function_t const& func,
+                      std::string const& caller,
+                      unsigned max_concurrency )
+{
+  std::vector< task_t > tasks;
+
+  for( unsigned i = 0; i < tiles_x; ++i )
+  {
+    for( unsigned j = 0; j < tiles_y; ++j )
+    {
+      vgl_box_2d<int> tile( region.min_x() + i * region.width() / tiles_x,
+                            region.min_x() + ( i + 1 ) * region.width() / tiles_x,
+                            region.min_y() + j * region.height() / tiles_y,
+                            region.min_y() + ( j + 1 ) * region.height() / tiles_y );
+
+      if( tile.volume() > 0 )
+      {
+        tasks.push_back( boost::bind( func, tile ) );
+      }
+    }
+  }
+
+  run( tasks, caller, max_concurrency );
+}
+
+
+void compute_pool
+::set_core_budget( unsigned cores )
+{
+  if( cores == 0 )
+  {
+    cores = priv::default_budget();
+  }
+
+  if( cores == core_budget() )
+  {
+    return;
+  }
+
+  d->resize( cores, true );
+}
+
+
+unsigned compute_pool
+::core_budget() const
+{
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+  return d->budget;
+}
+
+
+unsigned compute_pool
+::numa_node_count() const
+{
+  return std::max( 1u, static_cast< unsigned >( d->numa_nodes.size() ) );
+}
+
+
+compute_pool_stats compute_pool
+::statistics( std::string const& caller ) const
+{
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+
+  std::map< std::string, compute_pool_stats >::const_iterator it = d->stats.find( caller );
+
+  return ( it != d->stats.end() ? it->second : compute_pool_stats() );
+}
+
+
+std::map< std::string, compute_pool_stats > compute_pool
+::all_statistics() const
+{
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+  return d->stats;
+}
+
+
+void compute_pool
+::reset_statistics()
+{
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+  d->stats.clear();
+}
+
+
+} // end namespace vidtk
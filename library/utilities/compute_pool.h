@@ -0,0 +1,155 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_compute_pool_h_
+#define vidtk_compute_pool_h_
+
+#include <vgl/vgl_box_2d.h>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vidtk
+{
+
+/// Utilization statistics of a single compute_pool caller.
+struct compute_pool_stats
+{
+  compute_pool_stats()
+    : batches( 0 ),
+      tasks( 0 ),
+      task_seconds( 0.0 ),
+      wall_seconds( 0.0 ),
+      peak_concurrency( 0 )
+  {}
+
+  /// Average number of cores kept busy while the caller had work queued.
+  double utilization() const
+  {
+    return ( wall_seconds > 0.0 ? task_seconds / wall_seconds : 0.0 );
+  }
+
+  /// Number of task sets submitted.
+  unsigned long batches;
+
+  /// Number of individual tasks executed.
+  unsigned long tasks;
+
+  /// Total time spent executing tasks, summed over all threads.
+  double task_seconds;
+
+  /// Total elapsed time from submission to completion of each task set.
+  double wall_seconds;
+
+  /// Largest number of threads which executed a single task set at once.
+  unsigned peak_concurrency;
+};
+
+
+class compute_pool;
+typedef boost::shared_ptr<compute_pool> compute_pool_t;
+
+
+// ----------------------------------------------------------------
+/** Process-wide pool of threads for intra-frame data parallelism.
+ *
+ * All helpers which split work across threads submit it to this
+ * singleton instead of owning their own threads. The pool owns one
+ * worker thread less than its core budget, no matter how many
+ * pipelines or processes are running. The budget defaults to the
+ * number of hardware threads, and can be lowered with the
+ * VIDTK_COMPUTE_CORES environment variable or set_core_budget().
+ *
+ * A thread which submits work also executes tasks of that work until
+ * none are left, so a budget of one runs everything serially on the
+ * calling threads, and nested submissions from within a task cannot
+ * deadlock. Because of this, the number of threads executing tasks
+ * at once can exceed the budget by the number of threads waiting in
+ * run(), although a single set of tasks never uses more than the
+ * budget. On Linux hosts with more than one NUMA node, worker threads
+ * are spread evenly over the nodes and bound to the CPUs of their node.
+ *
+ * The pool is meant for short tasks which the caller waits on. Long
+ * running background work should use a dedicated thread instead, so
+ * that it cannot occupy workers needed by other callers.
+ *
+ * Statistics are kept per caller name, so the load placed on the pool
+ * by each consumer can be inspected.
+ */
+class compute_pool
+{
+public:
+  typedef boost::function< void () > task_t;
+  typedef boost::function< void ( unsigned, unsigned ) > range_function_t;
+  typedef boost::function< void ( vgl_box_2d<int> const& ) > tile_function_t;
+
+  static compute_pool_t instance();
+  virtual ~compute_pool();
+
+  /// \brief Execute a set of tasks, blocking until all are complete.
+  ///
+  /// At most \a max_concurrency tasks of this set run at the same time,
+  /// including the calling thread, or up to the core budget if zero.
+  /// If any task throws, the first error is rethrown as a
+  /// std::runtime_error once the remaining tasks have completed.
+  void run( std::vector< task_t > const& tasks,
+            std::string const& caller,
+            unsigned max_concurrency = 0 );
+
+  /// \brief Split [begin,end) into contiguous ranges and process them in parallel.
+  ///
+  /// One range is created per thread which may run concurrently, and
+  /// \a func is called once with the bounds of each range.
+  void parallel_for( unsigned begin, unsigned end,
+                     range_function_t const& func,
+                     std::string const& caller,
+                     unsigned max_concurrency = 0 );
+
+  /// \brief Split a region into a grid of tiles and process them in parallel.
+  void parallel_for_tiles( vgl_box_2d<int> const& region,
+                           unsigned tiles_x, unsigned tiles_y,
+                           tile_function_t const& func,
+                           std::string const& caller,
+                           unsigned max_concurrency = 0 );
+
+  /// Set the core budget, 0 for the default.
+  void set_core_budget( unsigned cores );
+
+  /// Maximum number of threads executing a single set of tasks.
+  unsigned core_budget() const;
+
+  /// Number of NUMA nodes worker threads are distributed over.
+  unsigned numa_node_count() const;
+
+  /// Statistics of a single caller.
+  compute_pool_stats statistics( std::string const& caller ) const;
+
+  /// Statistics of all callers.
+  std::map< std::string, compute_pool_stats > all_statistics() const;
+
+  /// Clear all caller statistics.
+  void reset_statistics();
+
+
+protected:
+  compute_pool();
+
+
+private:
+  class priv;
+  boost::scoped_ptr<priv> d;
+
+  static compute_pool_t s_instance;
+}; // end class compute_pool
+
+} // end namespace vidtk
+
+#endif // vidtk_compute_pool_h_
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -466,10 +466,12 @@ void
 config_block
 ::add( std::string const& name, config_block_value const& val )
 {
-  // call this to ensure that the name doesn't already exist.
-  check_if_exists( name );
-
-  vmap_[name] = val;
+  // A single insert both checks that the name doesn't already exist
+  // and adds it, instead of searching the map twice.
+  if( ! vmap_.insert( value_map_type::value_type( name, val ) ).second )
+  {
+    check_if_exists( name );
+  }
 }
 
 
@@ -530,10 +532,26 @@ config_block
 {
   typedef value_map_type::const_iterator map_iter_type;
 
+  std::string const prefix = subblock_name + ":";
+
+  // The source entries are sorted, and so are the prefixed names, so each
+  // one is inserted right after the previous one.
+  value_map_type::iterator hint = vmap_.lower_bound( prefix );
+
   for( map_iter_type src_it = blk.vmap_.begin();
        src_it != blk.vmap_.end(); ++src_it )
   {
-    this->add( subblock_name + ":" + src_it->first, src_it->second );
+    std::string const name = prefix + src_it->first;
+    std::size_t const size = vmap_.size();
+
+    hint = vmap_.insert( hint, value_map_type::value_type( name, src_it->second ) );
+
+    if( vmap_.size() == size )
+    {
+      check_if_exists( name );
+    }
+
+    ++hint;
   }
 }
 
@@ -549,14 +567,13 @@ config_block
   std::string prefix = subblock_name + ":";
   std::string::size_type const n = prefix.length();
 
-  for( map_iter_type it = vmap_.begin();
-       it != vmap_.end(); ++it )
+  // All names with the prefix are adjacent in the map, and are added to
+  // the output block in order.
+  for( map_iter_type it = vmap_.lower_bound( prefix );
+       it != vmap_.end() && is_prefixed( it->first, prefix ); ++it )
   {
-    if( is_prefixed( it->first, prefix ) )
-    {
-      std::string suffix = it->first.substr( n );
-      out_blk.add( suffix, it->second );
-    }
+    out_blk.vmap_.insert( out_blk.vmap_.end(),
+                          value_map_type::value_type( it->first.substr( n ), it->second ) );
   }
 
   return out_blk;
@@ -616,16 +633,9 @@ config_block
 
   std::string prefix = subblock_name + ":";
 
-  for( map_iter_type it = vmap_.begin();
-       it != vmap_.end(); ++it )
-  {
-    if( is_prefixed( it->first, prefix ) )
-    {
-      return true;
-    }
-  }
+  map_iter_type it = vmap_.lower_bound( prefix );
 
-  return false;
+  return ( it != vmap_.end() && is_prefixed( it->first, prefix ) );
 }
 
 
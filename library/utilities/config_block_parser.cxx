@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -102,6 +102,7 @@ config_block_parser
     // indicate we own the file - will be deleted at EOF
     // The stack top is our file context
     include_file_stack_.push_back (file_stack_item_t(istr_, vul_file::dirname(filename_), true, 0, filename) );
+    files_read_.push_back( filename );
     return true;
   }
 }
@@ -270,6 +271,7 @@ config_block_parser
 
           // push file onto stack, we own the file
           include_file_stack_.push_back ( file_stack_item_t (inc_file, dirpath, true, 0, filename ));
+          files_read_.push_back( filename );
           istr_ = inc_file; // set to use new include file
           config_file_dir_ = dirpath;
           line_number_ = 0;
@@ -306,6 +308,16 @@ config_block_parser
 }
 
 
+// ------------------------------------------------------------------
+// Files opened by the parser, including nested includes
+std::vector< std::string > const&
+config_block_parser
+::files_read() const
+{
+  return files_read_;
+}
+
+
 // ------------------------------------------------------------------
 std::string
 config_block_parser
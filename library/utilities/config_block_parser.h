@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -64,6 +64,14 @@ public:
    */
   checked_bool parse( config_block& blk );
 
+  /**
+   * @brief Names of all files read so far.
+   *
+   * This is the file given to set_filename(), followed by every file
+   * it includes, in the order they were opened.
+   */
+  std::vector< std::string > const& files_read() const;
+
 private:
   /// @brief Read the next word from the current line.
   ///
@@ -90,6 +98,7 @@ private:
   // The 5th element is the file name with directory
   typedef boost::tuple <std::istream *, std::string, bool, int, std::string> file_stack_item_t;
   std::vector < file_stack_item_t > include_file_stack_;
+  std::vector < std::string > files_read_;
 
   /// The input stream.  May point to fstr_ if reading from a file.
   std::istream* istr_;
@@ -0,0 +1,495 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "config_snapshot.h"
+
+#include <utilities/mapped_file.h>
+
+#include <vpl/vpl.h>
+
+#include <logger/logger.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+VIDTK_LOGGER( "config_snapshot" );
+
+
+namespace // anonymous
+{
+
+char const snapshot_magic[8] = { 'V', 'I', 'D', 'T', 'K', 'C', 'S', 'S' };
+boost::uint32_t const snapshot_version = 1;
+
+// Written in native byte order, used to reject files from other hosts
+boost::uint32_t const byte_order_mark = 0x01020304;
+
+boost::mutex active_mutex;
+vidtk::config_snapshot_sptr active_snapshot;
+
+
+void write_u32( std::ostream& os, boost::uint32_t value )
+{
+  os.write( reinterpret_cast< char const* >( &value ), sizeof( value ) );
+}
+
+
+void write_u64( std::ostream& os, boost::uint64_t value )
+{
+  os.write( reinterpret_cast< char const* >( &value ), sizeof( value ) );
+}
+
+
+void write_string( std::ostream& os, std::string const& str )
+{
+  write_u64( os, str.size() );
+  os.write( str.data(), str.size() );
+}
+
+
+/// Bounds checked reading of the records of a mapped snapshot.
+class snapshot_reader
+{
+public:
+  snapshot_reader( char const* data, std::size_t size )
+    : pos_( data ),
+      end_( data + size )
+  {
+  }
+
+  bool read_bytes( void* dst, std::size_t count )
+  {
+    if( static_cast< std::size_t >( end_ - pos_ ) < count )
+    {
+      return false;
+    }
+
+    std::memcpy( dst, pos_, count );
+    pos_ += count;
+    return true;
+  }
+
+  bool read_u32( boost::uint32_t& value )
+  {
+    return read_bytes( &value, sizeof( value ) );
+  }
+
+  /// Locate a length prefixed block without copying it.
+  bool read_block( char const*& data, std::size_t& size )
+  {
+    boost::uint64_t length;
+
+    if( !read_bytes( &length, sizeof( length ) ) ||
+        static_cast< boost::uint64_t >( end_ - pos_ ) < length )
+    {
+      return false;
+    }
+
+    data = pos_;
+    size = static_cast< std::size_t >( length );
+    pos_ += size;
+    return true;
+  }
+
+  bool read_string( std::string& str )
+  {
+    char const* data;
+    std::size_t size;
+
+    if( !read_block( data, size ) )
+    {
+      return false;
+    }
+
+    str.assign( data, size );
+    return true;
+  }
+
+private:
+  char const* pos_;
+  char const* end_;
+};
+
+} // end namespace anonymous
+
+
+namespace vidtk
+{
+
+class config_snapshot::priv
+{
+public:
+  priv()
+    : recording( true ),
+      verified( false )
+  {
+  }
+
+  // A pre-parsed model, either recorded or located in the mapped file
+  struct model_entry
+  {
+    model_entry() : data( NULL ), size( 0 ) {}
+
+    std::string recorded;
+    char const* data;
+    std::size_t size;
+  };
+
+  typedef std::pair< std::string, std::string > model_key_t;
+  typedef std::map< model_key_t, model_entry > model_map_t;
+
+  bool recording;
+  bool verified;
+
+  std::string key;
+  std::map< std::string, std::string > dependencies;
+  std::vector< std::pair< std::string, std::string > > values;
+  model_map_t models;
+
+  mapped_file file;
+
+  // Model loaders may run concurrently
+  mutable boost::mutex mutex;
+};
+
+
+config_snapshot
+::config_snapshot()
+  : d( new priv )
+{
+}
+
+
+config_snapshot
+::~config_snapshot()
+{
+}
+
+
+std::string
+config_snapshot
+::file_hash( std::string const& filename )
+{
+  mapped_file file;
+
+  if( !file.open( filename ) )
+  {
+    return std::string();
+  }
+
+  // 64-bit FNV-1a
+  boost::uint64_t hash = 14695981039346656037ULL;
+  unsigned char const* data = reinterpret_cast< unsigned char const* >( file.data() );
+
+  for( std::size_t i = 0; i < file.size(); ++i )
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+
+  std::ostringstream str;
+  str << file.size() << ':' << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  return str.str();
+}
+
+
+config_snapshot_sptr
+config_snapshot
+::active()
+{
+  boost::lock_guard< boost::mutex > lock( active_mutex );
+  return active_snapshot;
+}
+
+
+void
+config_snapshot
+::set_active( config_snapshot_sptr const& snapshot )
+{
+  boost::lock_guard< boost::mutex > lock( active_mutex );
+  active_snapshot = snapshot;
+}
+
+
+bool
+config_snapshot
+::is_recording() const
+{
+  return d->recording;
+}
+
+
+void
+config_snapshot
+::set_key( std::string const& key )
+{
+  d->key = key;
+}
+
+
+void
+config_snapshot
+::set_config( config_block const& blk )
+{
+  typedef std::map< std::string, config_block_value > value_map_t;
+
+  value_map_t const all_values = blk.enumerate_values();
+
+  d->values.clear();
+
+  for( value_map_t::const_iterator it = all_values.begin(); it != all_values.end(); ++it )
+  {
+    if( it->second.has_user_value() )
+    {
+      d->values.push_back( std::make_pair( it->first, it->second.user_value() ) );
+    }
+  }
+}
+
+
+void
+config_snapshot
+::add_dependency( std::string const& filename )
+{
+  std::string const hash = file_hash( filename );
+
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+  d->dependencies[ filename ] = hash;
+}
+
+
+void
+config_snapshot
+::add_model( std::string const& kind,
+             std::string const& filename,
+             std::string const& data )
+{
+  if( !d->recording )
+  {
+    return;
+  }
+
+  this->add_dependency( filename );
+
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+  d->models[ std::make_pair( kind, filename ) ].recorded = data;
+}
+
+
+checked_bool
+config_snapshot
+::write( std::string const& filename ) const
+{
+  if( !d->recording )
+  {
+    return checked_bool( "only recorded snapshots can be written" );
+  }
+
+  // Write to a temporary file first, so that other processes never see
+  // a partially written snapshot.
+  std::ostringstream temp_name;
+  temp_name << filename << "." << vpl_getpid() << ".tmp";
+
+  {
+    std::ofstream output( temp_name.str().c_str(), std::ios::out | std::ios::binary );
+
+    if( !output )
+    {
+      return checked_bool( "unable to open " + temp_name.str() + " for writing" );
+    }
+
+    boost::lock_guard< boost::mutex > lock( d->mutex );
+
+    output.write( snapshot_magic, sizeof( snapshot_magic ) );
+    write_u32( output, snapshot_version );
+    write_u32( output, byte_order_mark );
+    write_string( output, d->key );
+
+    write_u32( output, d->dependencies.size() );
+    for( std::map< std::string, std::string >::const_iterator it = d->dependencies.begin();
+         it != d->dependencies.end(); ++it )
+    {
+      write_string( output, it->first );
+      write_string( output, it->second );
+    }
+
+    write_u32( output, d->values.size() );
+    for( unsigned i = 0; i < d->values.size(); ++i )
+    {
+      write_string( output, d->values[i].first );
+      write_string( output, d->values[i].second );
+    }
+
+    write_u32( output, d->models.size() );
+    for( priv::model_map_t::const_iterator it = d->models.begin(); it != d->models.end(); ++it )
+    {
+      write_string( output, it->first.first );
+      write_string( output, it->first.second );
+      write_string( output, it->second.recorded );
+    }
+
+    if( !output )
+    {
+      return checked_bool( "failed to write " + temp_name.str() );
+    }
+  }
+
+  boost::system::error_code error;
+  boost::filesystem::rename( temp_name.str(), filename, error );
+
+  if( error )
+  {
+    boost::filesystem::remove( temp_name.str(), error );
+    return checked_bool( "unable to replace " + filename );
+  }
+
+  return true;
+}
+
+
+checked_bool
+config_snapshot
+::load( std::string const& filename )
+{
+  d.reset( new priv );
+  d->recording = false;
+
+  if( !d->file.open( filename ) )
+  {
+    return checked_bool( "unable to map " + filename );
+  }
+
+  snapshot_reader reader( d->file.data(), d->file.size() );
+
+  char magic[ sizeof( snapshot_magic ) ];
+  boost::uint32_t version, byte_order;
+
+  if( !reader.read_bytes( magic, sizeof( magic ) ) ||
+      std::memcmp( magic, snapshot_magic, sizeof( magic ) ) != 0 ||
+      !reader.read_u32( version ) || version != snapshot_version ||
+      !reader.read_u32( byte_order ) || byte_order != byte_order_mark )
+  {
+    return checked_bool( filename + " is not a compatible config snapshot" );
+  }
+
+  boost::uint32_t count;
+  bool valid = reader.read_string( d->key ) && reader.read_u32( count );
+
+  for( boost::uint32_t i = 0; valid && i < count; ++i )
+  {
+    std::string path, hash;
+    valid = reader.read_string( path ) && reader.read_string( hash );
+    d->dependencies[ path ] = hash;
+  }
+
+  valid = valid && reader.read_u32( count );
+
+  for( boost::uint32_t i = 0; valid && i < count; ++i )
+  {
+    std::pair< std::string, std::string > value;
+    valid = reader.read_string( value.first ) && reader.read_string( value.second );
+    d->values.push_back( value );
+  }
+
+  valid = valid && reader.read_u32( count );
+
+  for( boost::uint32_t i = 0; valid && i < count; ++i )
+  {
+    priv::model_key_t key;
+    priv::model_entry entry;
+    valid = reader.read_string( key.first ) && reader.read_string( key.second ) &&
+            reader.read_block( entry.data, entry.size );
+    d->models[ key ] = entry;
+  }
+
+  if( !valid )
+  {
+    d.reset( new priv );
+    d->recording = false;
+    return checked_bool( filename + " is truncated or corrupt" );
+  }
+
+  return true;
+}
+
+
+bool
+config_snapshot
+::is_current( std::string const& key )
+{
+  if( d->recording || key != d->key )
+  {
+    return false;
+  }
+
+  for( std::map< std::string, std::string >::const_iterator it = d->dependencies.begin();
+       it != d->dependencies.end(); ++it )
+  {
+    if( file_hash( it->first ) != it->second )
+    {
+      LOG_INFO( "Config snapshot is out of date, " << it->first << " has changed" );
+      return false;
+    }
+  }
+
+  d->verified = true;
+  return true;
+}
+
+
+checked_bool
+config_snapshot
+::apply( config_block& blk ) const
+{
+  for( unsigned i = 0; i < d->values.size(); ++i )
+  {
+    checked_bool res = blk.set( d->values[i].first, d->values[i].second );
+
+    if( !res )
+    {
+      return res;
+    }
+  }
+
+  return true;
+}
+
+
+bool
+config_snapshot
+::find_model( std::string const& kind,
+              std::string const& filename,
+              std::string& data ) const
+{
+  if( !d->verified )
+  {
+    return false;
+  }
+
+  boost::lock_guard< boost::mutex > lock( d->mutex );
+
+  priv::model_map_t::const_iterator it = d->models.find( std::make_pair( kind, filename ) );
+
+  if( it == d->models.end() )
+  {
+    return false;
+  }
+
+  data.assign( it->second.data, it->second.size );
+  return true;
+}
+
+} // end namespace vidtk
@@ -0,0 +1,150 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_config_snapshot_h_
+#define vidtk_config_snapshot_h_
+
+#include <utilities/config_block.h>
+#include <utilities/checked_bool.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+
+namespace vidtk
+{
+
+class config_snapshot;
+typedef boost::shared_ptr< config_snapshot > config_snapshot_sptr;
+
+
+// ----------------------------------------------------------------
+/** Compiled form of a fully resolved configuration and its models.
+ *
+ * Building a large pipeline configuration means parsing a tree of config
+ * files and then loading every model file named in it through text
+ * parsing. A snapshot records the result of all that work: the resolved
+ * user values of the config block, plus a pre-parsed binary copy of each
+ * model, together with a content hash of every file it was derived from.
+ *
+ * A snapshot file is read with a single memory map. It is only used if
+ * its key matches and none of its source files have changed since it
+ * was written; otherwise the caller falls back to parsing the sources
+ * and records a new snapshot.
+ *
+ * Model loaders find the snapshot of the running program through
+ * active(). When loading a model, they first ask the active snapshot
+ * for a pre-parsed copy with find_model(), and after parsing a model
+ * from its source they hand a copy to a recording snapshot with
+ * add_model().
+ *
+ * Example:
+\code
+config_snapshot_sptr snapshot( new config_snapshot() );
+
+if( snapshot->load( "app.snapshot" ) && snapshot->is_current( key ) )
+{
+  snapshot->apply( config );
+}
+else
+{
+  snapshot.reset( new config_snapshot() );
+  snapshot->set_key( key );
+  config.parse( "app.conf" );
+  snapshot->set_config( config );
+  snapshot->add_dependency( "app.conf" );
+}
+
+config_snapshot::set_active( snapshot );
+pipeline.set_params( config );
+
+if( snapshot->is_recording() )
+{
+  snapshot->write( "app.snapshot" );
+}
+\endcode
+ */
+class config_snapshot
+{
+public:
+  config_snapshot();
+  ~config_snapshot();
+
+  /// Hash of the contents of a file, empty if it cannot be read.
+  static std::string file_hash( std::string const& filename );
+
+  /// Snapshot used by model loaders in this process, may be NULL.
+  static config_snapshot_sptr active();
+
+  /// Set the snapshot used by model loaders, NULL to disable.
+  static void set_active( config_snapshot_sptr const& snapshot );
+
+  /// \name Recording a snapshot
+  //@{
+
+  /// Is this snapshot being recorded, as opposed to loaded from a file?
+  bool is_recording() const;
+
+  /// \brief Set the key identifying the inputs not covered by file hashes.
+  ///
+  /// For example, configuration given on the command line.
+  void set_key( std::string const& key );
+
+  /// Record every parameter of \a blk which has a user value.
+  void set_config( config_block const& blk );
+
+  /// Record the content hash of a file the configuration depends on.
+  void add_dependency( std::string const& filename );
+
+  /// \brief Record the pre-parsed form of a model loaded from a file.
+  ///
+  /// \a kind identifies the loader and format of \a data, and the model
+  /// file is recorded as a dependency.
+  void add_model( std::string const& kind,
+                  std::string const& filename,
+                  std::string const& data );
+
+  /// Write the recorded snapshot to a file.
+  checked_bool write( std::string const& filename ) const;
+
+  //@}
+
+  /// \name Using a snapshot
+  //@{
+
+  /// Map a snapshot file written by write().
+  checked_bool load( std::string const& filename );
+
+  /// \brief Does the loaded snapshot match \a key and its source files?
+  ///
+  /// Every dependency is hashed again, so this fails as soon as any of
+  /// the config or model files used to build the snapshot changes.
+  bool is_current( std::string const& key );
+
+  /// Set the recorded user values in \a blk.
+  checked_bool apply( config_block& blk ) const;
+
+  /// \brief Find the pre-parsed form of a model file.
+  ///
+  /// Models are only returned once is_current() has succeeded.
+  bool find_model( std::string const& kind,
+                   std::string const& filename,
+                   std::string& data ) const;
+
+  //@}
+
+private:
+  config_snapshot( config_snapshot const& );
+  config_snapshot& operator=( config_snapshot const& );
+
+  class priv;
+  boost::scoped_ptr< priv > d;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_config_snapshot_h_
@@ -0,0 +1,360 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "homography_chain.h"
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <algorithm>
+#include <deque>
+
+namespace vidtk
+{
+
+namespace
+{
+
+struct chain_entry
+{
+  timestamp ts;
+  bool has_ts;
+  bool valid;
+  unsigned long shot;
+  homography_chain::transform_t src2ref;
+  homography_chain::transform_t ref2src;
+};
+
+
+bool entry_before( chain_entry const& e, timestamp const& ts )
+{
+  return e.ts < ts;
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------
+class homography_chain::priv
+{
+public:
+  typedef boost::shared_mutex mutex_t;
+  typedef boost::unique_lock< mutex_t > exclusive_lock_t;
+  typedef boost::shared_lock< mutex_t > shared_lock_t;
+
+  explicit priv( unsigned cap )
+    : capacity( cap ),
+      shot_count( 0 )
+  {
+    current_to_ref.set_identity();
+  }
+
+  void push( chain_entry& entry, transform_t const& src2dest );
+  chain_entry const* find( timestamp const& ts ) const;
+  chain_entry const* at_age( unsigned age ) const;
+  static bool relate( chain_entry const* from, chain_entry const* to,
+                      transform_t& from_to_to );
+
+  unsigned capacity;
+  std::deque< chain_entry > frames;
+
+  // Shot of the newest frame, and the transform from the destination
+  // of its homography to the reference of the shot
+  unsigned long shot_count;
+  timestamp current_dest;
+  transform_t current_to_ref;
+
+  mutable mutex_t mutex;
+};
+
+
+// ----------------------------------------------------------------
+/** Complete an entry from its homography and append it.
+ *
+ * The shot must already be set on the entry.
+ */
+void
+homography_chain::priv
+::push( chain_entry& entry, transform_t const& src2dest )
+{
+  if( entry.valid )
+  {
+    entry.src2ref = current_to_ref * src2dest;
+    entry.ref2src = entry.src2ref.get_inverse();
+  }
+
+  frames.push_back( entry );
+
+  while( capacity != 0 && frames.size() > capacity )
+  {
+    frames.pop_front();
+  }
+}
+
+
+chain_entry const*
+homography_chain::priv
+::find( timestamp const& ts ) const
+{
+  std::deque< chain_entry >::const_iterator itr =
+    std::lower_bound( frames.begin(), frames.end(), ts, entry_before );
+
+  if( itr == frames.end() || !itr->has_ts || itr->ts != ts )
+  {
+    return NULL;
+  }
+
+  return &*itr;
+}
+
+
+chain_entry const*
+homography_chain::priv
+::at_age( unsigned age ) const
+{
+  if( age >= frames.size() )
+  {
+    return NULL;
+  }
+
+  return &frames[ frames.size() - 1 - age ];
+}
+
+
+bool
+homography_chain::priv
+::relate( chain_entry const* from, chain_entry const* to, transform_t& from_to_to )
+{
+  if( !from || !to || !from->valid || !to->valid || from->shot != to->shot )
+  {
+    return false;
+  }
+
+  from_to_to = to->ref2src * from->src2ref;
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+homography_chain
+::homography_chain( unsigned capacity )
+  : d( new priv( capacity ) )
+{
+}
+
+
+homography_chain
+::~homography_chain()
+{
+}
+
+
+void
+homography_chain
+::set_capacity( unsigned capacity )
+{
+  priv::exclusive_lock_t lock( d->mutex );
+
+  d->capacity = capacity;
+
+  while( capacity != 0 && d->frames.size() > capacity )
+  {
+    d->frames.pop_front();
+  }
+}
+
+
+unsigned
+homography_chain
+::capacity() const
+{
+  priv::shared_lock_t lock( d->mutex );
+  return d->capacity;
+}
+
+
+void
+homography_chain
+::add( image_to_image_homography const& src2ref )
+{
+  priv::exclusive_lock_t lock( d->mutex );
+
+  chain_entry entry;
+  entry.ts = src2ref.get_source_reference();
+  entry.has_ts = true;
+  entry.valid = src2ref.is_valid();
+
+  if( !d->frames.empty() && ( !d->frames.back().has_ts || !( d->frames.back().ts < entry.ts ) ) )
+  {
+    d->frames.clear();
+  }
+
+  // Invalid frames can not be related to others, but do not end the shot
+  if( entry.valid )
+  {
+    const timestamp dest = src2ref.get_dest_reference();
+
+    if( d->frames.empty() || src2ref.is_new_reference() )
+    {
+      ++d->shot_count;
+      d->current_to_ref.set_identity();
+    }
+    else if( dest != d->current_dest )
+    {
+      // Continue the shot if the new reference is related to the old one
+      chain_entry const* ref = d->find( dest );
+
+      if( ref && ref->valid && ref->shot == d->shot_count )
+      {
+        d->current_to_ref = ref->src2ref;
+      }
+      else
+      {
+        ++d->shot_count;
+        d->current_to_ref.set_identity();
+      }
+    }
+
+    d->current_dest = dest;
+  }
+
+  entry.shot = d->shot_count;
+  d->push( entry, src2ref.get_transform() );
+}
+
+
+void
+homography_chain
+::add( transform_t const& src2ref, bool new_shot )
+{
+  priv::exclusive_lock_t lock( d->mutex );
+
+  if( !d->frames.empty() && d->frames.back().has_ts )
+  {
+    d->frames.clear();
+  }
+
+  if( new_shot || d->frames.empty() )
+  {
+    ++d->shot_count;
+  }
+
+  d->current_dest = timestamp();
+  d->current_to_ref.set_identity();
+
+  chain_entry entry;
+  entry.has_ts = false;
+  entry.valid = true;
+  entry.shot = d->shot_count;
+  d->push( entry, src2ref );
+}
+
+
+void
+homography_chain
+::clear()
+{
+  priv::exclusive_lock_t lock( d->mutex );
+  d->frames.clear();
+}
+
+
+void
+homography_chain
+::keep_newest()
+{
+  priv::exclusive_lock_t lock( d->mutex );
+
+  if( d->frames.size() > 1 )
+  {
+    d->frames.erase( d->frames.begin(), d->frames.end() - 1 );
+  }
+}
+
+
+unsigned
+homography_chain
+::size() const
+{
+  priv::shared_lock_t lock( d->mutex );
+  return static_cast< unsigned >( d->frames.size() );
+}
+
+
+bool
+homography_chain
+::transform( timestamp const& from, timestamp const& to,
+             transform_t& from_to_to ) const
+{
+  priv::shared_lock_t lock( d->mutex );
+  return priv::relate( d->find( from ), d->find( to ), from_to_to );
+}
+
+
+bool
+homography_chain
+::transform_by_age( unsigned from_age, unsigned to_age,
+                    transform_t& from_to_to ) const
+{
+  priv::shared_lock_t lock( d->mutex );
+  return priv::relate( d->at_age( from_age ), d->at_age( to_age ), from_to_to );
+}
+
+
+bool
+homography_chain
+::src_to_ref( timestamp const& ts, transform_t& result ) const
+{
+  priv::shared_lock_t lock( d->mutex );
+
+  chain_entry const* entry = d->find( ts );
+
+  if( !entry || !entry->valid )
+  {
+    return false;
+  }
+
+  result = entry->src2ref;
+  return true;
+}
+
+
+bool
+homography_chain
+::ref_to_src( timestamp const& ts, transform_t& result ) const
+{
+  priv::shared_lock_t lock( d->mutex );
+
+  chain_entry const* entry = d->find( ts );
+
+  if( !entry || !entry->valid )
+  {
+    return false;
+  }
+
+  result = entry->ref2src;
+  return true;
+}
+
+
+bool
+homography_chain
+::src_to_ref_by_age( unsigned age, transform_t& result ) const
+{
+  priv::shared_lock_t lock( d->mutex );
+
+  chain_entry const* entry = d->at_age( age );
+
+  if( !entry || !entry->valid )
+  {
+    return false;
+  }
+
+  result = entry->src2ref;
+  return true;
+}
+
+} // end namespace vidtk
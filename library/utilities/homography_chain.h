@@ -0,0 +1,110 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_homography_chain_h_
+#define vidtk_homography_chain_h_
+
+#include <utilities/homography.h>
+#include <utilities/timestamp.h>
+
+#include <vgl/algo/vgl_h_matrix_2d.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace vidtk
+{
+
+class homography_chain;
+typedef boost::shared_ptr< homography_chain > homography_chain_sptr;
+
+// ----------------------------------------------------------------
+/** Frame to frame transforms of a window of recent frames.
+ *
+ * Each frame is stored with its transform to the reference of its shot
+ * and the inverse of that transform, both computed once when the frame
+ * is added. The transform between any two frames of the same shot is
+ * then a single product of stored matrices.
+ *
+ * A frame starts a new shot when its homography marks a new reference.
+ * If only the reference frame changes, and the new reference is still
+ * in the chain, the frame stays in the current shot and its transform
+ * is expressed relative to the shot's original reference. Frames of
+ * different shots are never related. Frames with invalid homographies
+ * are kept, so that ages stay aligned with other buffers, but are not
+ * related to any frame.
+ *
+ * Frames must be added in timestamp order; a frame which is not newer
+ * than the last one restarts the chain, as does mixing frames with and
+ * without timestamps. Frames can be looked up by timestamp, or by age,
+ * where the newest frame has age 0.
+ *
+ * Any number of threads may query the chain while one thread adds
+ * frames to it.
+ */
+class homography_chain
+{
+public:
+  typedef vgl_h_matrix_2d< double > transform_t;
+
+  /// \brief Create a chain holding at most \a capacity frames.
+  ///
+  /// The oldest frame is dropped when a frame is added to a full
+  /// chain. A capacity of zero means the chain is unbounded.
+  explicit homography_chain( unsigned capacity = 0 );
+  ~homography_chain();
+
+  void set_capacity( unsigned capacity );
+  unsigned capacity() const;
+
+  /// Add the next frame, given its source to reference homography.
+  void add( image_to_image_homography const& src2ref );
+
+  /// \brief Add the next frame without a timestamp.
+  ///
+  /// Such frames can only be looked up by age.
+  void add( transform_t const& src2ref, bool new_shot = false );
+
+  /// Remove all frames.
+  void clear();
+
+  /// Remove all frames but the newest one.
+  void keep_newest();
+
+  /// Number of frames in the chain.
+  unsigned size() const;
+
+  /// \brief Get the transform from frame \a from to frame \a to.
+  ///
+  /// \return False if either frame is not in the chain, or the frames
+  /// are not in the same shot.
+  bool transform( timestamp const& from, timestamp const& to,
+                  transform_t& from_to_to ) const;
+
+  /// Get the transform between the frames of the given ages.
+  bool transform_by_age( unsigned from_age, unsigned to_age,
+                         transform_t& from_to_to ) const;
+
+  /// \brief Get the transform of a frame to the reference of its shot.
+  ///
+  /// \return False if the frame is not in the chain or its homography
+  /// was invalid.
+  bool src_to_ref( timestamp const& ts, transform_t& result ) const;
+
+  /// Get the transform of the reference of a frame's shot to the frame.
+  bool ref_to_src( timestamp const& ts, transform_t& result ) const;
+
+  /// Get the transform to the reference of the frame of the given age.
+  bool src_to_ref_by_age( unsigned age, transform_t& result ) const;
+
+private:
+  class priv;
+  boost::scoped_ptr< priv > d;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_homography_chain_h_
@@ -0,0 +1,176 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "mapped_file.h"
+
+#include <vcl_compiler.h>
+
+#include <logger/logger.h>
+
+#ifdef VCL_WIN32
+  #include <fstream>
+  #include <vector>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+VIDTK_LOGGER( "mapped_file" );
+
+namespace vidtk
+{
+
+class mapped_file::priv
+{
+public:
+  priv()
+    : is_open( false ),
+      data( NULL ),
+      size( 0 )
+  {
+  }
+
+  bool is_open;
+  char const* data;
+  std::size_t size;
+
+#ifdef VCL_WIN32
+  std::vector< char > buffer;
+#endif
+};
+
+
+mapped_file
+::mapped_file()
+  : d( new priv )
+{
+}
+
+
+mapped_file
+::~mapped_file()
+{
+  this->close();
+}
+
+
+bool
+mapped_file
+::open( std::string const& filename )
+{
+  this->close();
+
+#ifdef VCL_WIN32
+  std::ifstream input( filename.c_str(), std::ios::in | std::ios::binary );
+
+  if( !input )
+  {
+    LOG_ERROR( "Unable to open file: " << filename );
+    return false;
+  }
+
+  input.seekg( 0, std::ios::end );
+  d->buffer.resize( static_cast< std::size_t >( input.tellg() ) );
+  input.seekg( 0, std::ios::beg );
+
+  if( !d->buffer.empty() && !input.read( &d->buffer[0], d->buffer.size() ) )
+  {
+    LOG_ERROR( "Unable to read file: " << filename );
+    d->buffer.clear();
+    return false;
+  }
+
+  d->data = d->buffer.empty() ? NULL : &d->buffer[0];
+  d->size = d->buffer.size();
+#else
+  const int fd = ::open( filename.c_str(), O_RDONLY );
+
+  if( fd < 0 )
+  {
+    LOG_ERROR( "Unable to open file: " << filename );
+    return false;
+  }
+
+  struct stat info;
+
+  if( ::fstat( fd, &info ) != 0 )
+  {
+    LOG_ERROR( "Unable to read the size of file: " << filename );
+    ::close( fd );
+    return false;
+  }
+
+  d->size = static_cast< std::size_t >( info.st_size );
+
+  if( d->size > 0 )
+  {
+    void* addr = ::mmap( NULL, d->size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+    if( addr == MAP_FAILED )
+    {
+      LOG_ERROR( "Unable to map file: " << filename );
+      ::close( fd );
+      d->size = 0;
+      return false;
+    }
+
+    d->data = static_cast< char const* >( addr );
+  }
+
+  // The mapping remains valid after the descriptor is closed
+  ::close( fd );
+#endif
+
+  d->is_open = true;
+  return true;
+}
+
+
+void
+mapped_file
+::close()
+{
+#ifdef VCL_WIN32
+  d->buffer.clear();
+#else
+  if( d->data )
+  {
+    ::munmap( const_cast< char* >( d->data ), d->size );
+  }
+#endif
+
+  d->is_open = false;
+  d->data = NULL;
+  d->size = 0;
+}
+
+
+bool
+mapped_file
+::is_open() const
+{
+  return d->is_open;
+}
+
+
+char const*
+mapped_file
+::data() const
+{
+  return d->data;
+}
+
+
+std::size_t
+mapped_file
+::size() const
+{
+  return d->size;
+}
+
+} // end namespace vidtk
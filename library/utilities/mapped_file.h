@@ -0,0 +1,60 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_mapped_file_h_
+#define vidtk_mapped_file_h_
+
+#include <boost/scoped_ptr.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace vidtk
+{
+
+// ----------------------------------------------------------------
+/** Read-only view of the full contents of a file.
+ *
+ * On POSIX systems the file is memory mapped, so opening it is cheap
+ * no matter its size and pages are only read when they are accessed.
+ * On other systems the contents are read into memory when the file is
+ * opened. Either way, the data remain valid until the file is closed
+ * or this object is destroyed.
+ */
+class mapped_file
+{
+public:
+  mapped_file();
+  ~mapped_file();
+
+  /// \brief Map the contents of a file, closing any previous file.
+  ///
+  /// Returns false if the file could not be opened or mapped.
+  bool open( std::string const& filename );
+
+  /// Release the contents of the current file.
+  void close();
+
+  /// Is a file currently open?
+  bool is_open() const;
+
+  /// Start of the file contents, NULL if no file is open or it is empty.
+  char const* data() const;
+
+  /// Size of the file contents in bytes.
+  std::size_t size() const;
+
+private:
+  mapped_file( mapped_file const& );
+  mapped_file& operator=( mapped_file const& );
+
+  class priv;
+  boost::scoped_ptr< priv > d;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_mapped_file_h_
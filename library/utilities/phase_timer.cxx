@@ -0,0 +1,95 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "phase_timer.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <iomanip>
+
+namespace vidtk
+{
+
+phase_timer
+::phase_timer()
+  : running_( false )
+{
+}
+
+
+void
+phase_timer
+::start( std::string const& phase )
+{
+  this->stop();
+
+  current_phase_ = phase;
+  current_start_ = boost::posix_time::microsec_clock::universal_time();
+  running_ = true;
+}
+
+
+void
+phase_timer
+::stop()
+{
+  if( !running_ )
+  {
+    return;
+  }
+
+  boost::posix_time::time_duration const elapsed =
+    boost::posix_time::microsec_clock::universal_time() - current_start_;
+
+  phases_.push_back( std::make_pair( current_phase_,
+                                     elapsed.total_microseconds() / 1e6 ) );
+  running_ = false;
+}
+
+
+std::vector< std::pair< std::string, double > > const&
+phase_timer
+::phases() const
+{
+  return phases_;
+}
+
+
+double
+phase_timer
+::total_seconds() const
+{
+  double total = 0.0;
+
+  for( unsigned i = 0; i < phases_.size(); ++i )
+  {
+    total += phases_[i].second;
+  }
+
+  return total;
+}
+
+
+void
+phase_timer
+::report( std::ostream& os ) const
+{
+  double const total = this->total_seconds();
+
+  for( unsigned i = 0; i < phases_.size(); ++i )
+  {
+    double const share = ( total > 0.0 ? 100.0 * phases_[i].second / total : 0.0 );
+
+    os << "  " << std::left << std::setw( 32 ) << phases_[i].first << std::right
+       << std::fixed << std::setprecision( 3 ) << std::setw( 9 ) << phases_[i].second << " s"
+       << std::setprecision( 1 ) << std::setw( 7 ) << share << " %\n";
+  }
+
+  os << "  " << std::left << std::setw( 32 ) << "total" << std::right
+     << std::fixed << std::setprecision( 3 ) << std::setw( 9 ) << total << " s\n";
+}
+
+} // end namespace vidtk
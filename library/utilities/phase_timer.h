@@ -0,0 +1,68 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_phase_timer_h_
+#define vidtk_phase_timer_h_
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vidtk
+{
+
+// ----------------------------------------------------------------
+/** Wall clock timer for a sequence of named phases.
+ *
+ * Starting a phase ends the previous one, so instrumenting a sequence
+ * of steps only needs one call before each step.  This is used to break
+ * down where time goes during program startup.
+ *
+ * Example:
+\code
+vidtk::phase_timer timer;
+timer.start( "parse configuration" );
+...
+timer.start( "set parameters" );
+...
+timer.stop();
+timer.report( std::cout );
+\endcode
+ */
+class phase_timer
+{
+public:
+  phase_timer();
+
+  /// End the current phase, if any, and begin a new one.
+  void start( std::string const& phase );
+
+  /// End the current phase.
+  void stop();
+
+  /// Completed phases and their durations in seconds, in order.
+  std::vector< std::pair< std::string, double > > const& phases() const;
+
+  /// Total duration of all completed phases in seconds.
+  double total_seconds() const;
+
+  /// Write the duration and share of each completed phase.
+  void report( std::ostream& os ) const;
+
+private:
+  std::vector< std::pair< std::string, double > > phases_;
+
+  std::string current_phase_;
+  boost::posix_time::ptime current_start_;
+  bool running_;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_phase_timer_h_
@@ -0,0 +1,183 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "quality_governor.h"
+
+#include <logger/logger.h>
+
+#include <algorithm>
+#include <sstream>
+
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "quality_governor_cxx" );
+
+
+quality_governor
+::quality_governor()
+  : active_tier_( 0 ),
+    current_load_( 0.0 ),
+    overload_count_( 0 ),
+    underload_count_( 0 )
+{
+}
+
+
+bool
+quality_governor
+::configure( const quality_governor_settings& settings )
+{
+  if( settings.tier_count == 0 )
+  {
+    LOG_ERROR( "Quality governor tier count must be at least 1" );
+    return false;
+  }
+
+  if( settings.lower_load > settings.upper_load )
+  {
+    LOG_ERROR( "Quality governor lower load must not exceed upper load" );
+    return false;
+  }
+
+  if( settings.max_queue_length == 0 || settings.frame_budget_ms <= 0.0 )
+  {
+    LOG_ERROR( "Quality governor queue length and frame budget must be positive" );
+    return false;
+  }
+
+  settings_ = settings;
+
+  queue_monitor_.reset();
+  last_elapsed_ms_.clear();
+  last_step_count_.clear();
+
+  active_tier_ = 0;
+  current_load_ = 0.0;
+  overload_count_ = 0;
+  underload_count_ = 0;
+
+  return true;
+}
+
+
+bool
+quality_governor
+::monitor( const pipeline* p )
+{
+  queue_monitor_.reset();
+
+  std::istringstream ss( settings_.nodes_to_monitor );
+  std::string node;
+  bool ret_val = true;
+
+  while( ss >> node )
+  {
+    if( !queue_monitor_.monitor_node( node, p ) )
+    {
+      LOG_ERROR( "Quality governor unable to find node: " << node );
+      ret_val = false;
+    }
+  }
+
+  const std::vector< const pipeline_node* >& nodes = queue_monitor_.monitored_nodes();
+
+  last_elapsed_ms_.resize( nodes.size() );
+  last_step_count_.resize( nodes.size() );
+
+  for( unsigned i = 0; i < nodes.size(); ++i )
+  {
+    last_elapsed_ms_[i] = nodes[i]->elapsed_ms();
+    last_step_count_[i] = nodes[i]->step_count();
+  }
+
+  return ret_val;
+}
+
+
+unsigned
+quality_governor
+::update()
+{
+  double load = static_cast< double >( queue_monitor_.current_max_queue_length() ) /
+                settings_.max_queue_length;
+
+  const std::vector< const pipeline_node* >& nodes = queue_monitor_.monitored_nodes();
+
+  for( unsigned i = 0; i < nodes.size(); ++i )
+  {
+    const double elapsed = nodes[i]->elapsed_ms();
+    const unsigned long steps = nodes[i]->step_count();
+
+    // Only consider time spent since the last update, so that the load
+    // follows recent behavior instead of the whole run.
+    if( steps > last_step_count_[i] )
+    {
+      const double step_ms = ( elapsed - last_elapsed_ms_[i] ) /
+                             ( steps - last_step_count_[i] );
+
+      load = std::max( load, step_ms / settings_.frame_budget_ms );
+    }
+
+    last_elapsed_ms_[i] = elapsed;
+    last_step_count_[i] = steps;
+  }
+
+  return this->update( load );
+}
+
+
+unsigned
+quality_governor
+::update( double load )
+{
+  current_load_ = load;
+
+  if( !settings_.enabled )
+  {
+    return active_tier_;
+  }
+
+  overload_count_ = ( load > settings_.upper_load ? overload_count_ + 1 : 0 );
+  underload_count_ = ( load < settings_.lower_load ? underload_count_ + 1 : 0 );
+
+  if( overload_count_ >= settings_.escalate_count &&
+      active_tier_ + 1 < settings_.tier_count )
+  {
+    ++active_tier_;
+    overload_count_ = 0;
+    LOG_INFO( "Load " << load << " exceeds " << settings_.upper_load
+              << ", reducing quality to tier " << active_tier_ );
+  }
+  else if( underload_count_ >= settings_.relax_count && active_tier_ > 0 )
+  {
+    --active_tier_;
+    underload_count_ = 0;
+    LOG_INFO( "Load " << load << " below " << settings_.lower_load
+              << ", increasing quality to tier " << active_tier_ );
+  }
+
+  return active_tier_;
+}
+
+
+double
+quality_governor
+::current_load() const
+{
+  return current_load_;
+}
+
+
+unsigned
+quality_governor
+::active_tier() const
+{
+  return active_tier_;
+}
+
+} // end namespace vidtk
@@ -0,0 +1,134 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_quality_governor_h_
+#define vidtk_quality_governor_h_
+
+#include <utilities/external_settings.h>
+
+#include <pipeline_framework/pipeline.h>
+#include <pipeline_framework/pipeline_queue_monitor.h>
+
+#include <string>
+#include <vector>
+
+namespace vidtk
+{
+
+#define settings_macro( add_param ) \
+  add_param( \
+    enabled, \
+    bool, \
+    false, \
+    "Should the quality governor be enabled? When enabled, the pipeline " \
+    "load is measured every frame and processing quality is reduced " \
+    "through a set of tiers instead of dropping frames." ); \
+  add_param( \
+    tier_count, \
+    unsigned, \
+    4, \
+    "Number of quality tiers, including tier 0 (full quality). The " \
+    "governor will never report a tier greater than or equal to this." ); \
+  add_param( \
+    nodes_to_monitor, \
+    std::string, \
+    "", \
+    "A list of pipeline nodes to monitor, seperated by spaces. Both the " \
+    "outgoing queue length and the average step time of these nodes are " \
+    "used to estimate the current load." ); \
+  add_param( \
+    max_queue_length, \
+    unsigned, \
+    5, \
+    "Queue length which corresponds to a load of 1.0. Only relevant for " \
+    "asynchronous pipelines." ); \
+  add_param( \
+    frame_budget_ms, \
+    double, \
+    33.3, \
+    "Per-frame processing budget, in milliseconds, which corresponds to " \
+    "a load of 1.0 for the slowest monitored node." ); \
+  add_param( \
+    upper_load, \
+    double, \
+    1.0, \
+    "If the measured load is above this value for escalate_count " \
+    "consecutive frames, quality is reduced by one tier." ); \
+  add_param( \
+    lower_load, \
+    double, \
+    0.6, \
+    "If the measured load is below this value for relax_count " \
+    "consecutive frames, quality is increased by one tier." ); \
+  add_param( \
+    escalate_count, \
+    unsigned, \
+    5, \
+    "Number of consecutive overloaded frames before reducing quality." ); \
+  add_param( \
+    relax_count, \
+    unsigned, \
+    30, \
+    "Number of consecutive underloaded frames before increasing quality." ); \
+
+init_external_settings1( quality_governor_settings, settings_macro );
+
+#undef settings_macro
+
+
+/// \brief Selects a processing quality tier based on pipeline load.
+///
+/// Tier 0 represents full quality, with each successive tier representing
+/// a cheaper processing configuration. What each tier means is up to the
+/// consumers of the tier value. Transitions between tiers use hysteresis
+/// so that quality does not oscillate on short load spikes.
+class quality_governor
+{
+
+public:
+
+  quality_governor();
+  virtual ~quality_governor() {}
+
+  /// Set any external options for this class.
+  bool configure( const quality_governor_settings& settings );
+
+  /// Locate all nodes to monitor in the given pipeline, searching any
+  /// contained super processes. Returns false if any node is not found.
+  bool monitor( const pipeline* p );
+
+  /// Measure the current load of all monitored nodes and update the tier.
+  unsigned update();
+
+  /// Update the tier given an externally measured load value.
+  unsigned update( double load );
+
+  /// The load measured during the last call to update().
+  double current_load() const;
+
+  /// The currently active quality tier.
+  unsigned active_tier() const;
+
+private:
+
+  // Any external settings
+  quality_governor_settings settings_;
+
+  // Monitored nodes and their timing at the last update
+  pipeline_queue_monitor queue_monitor_;
+  std::vector< double > last_elapsed_ms_;
+  std::vector< unsigned long > last_step_count_;
+
+  // Hysteresis state
+  unsigned active_tier_;
+  double current_load_;
+  unsigned overload_count_;
+  unsigned underload_count_;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_quality_governor_h_
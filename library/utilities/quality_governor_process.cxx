@@ -0,0 +1,113 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "quality_governor_process.h"
+
+#include <logger/logger.h>
+
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "quality_governor_process" );
+
+quality_governor_process
+::quality_governor_process( std::string const& _name )
+  : process( _name, "quality_governor_process" ),
+    quality_tier_( 0 )
+{
+  config_ = settings_.config();
+}
+
+
+quality_governor_process
+::~quality_governor_process()
+{
+}
+
+
+vidtk::config_block
+quality_governor_process
+::params() const
+{
+  return config_;
+}
+
+
+bool
+quality_governor_process
+::set_params( config_block const& blk )
+{
+  try
+  {
+    settings_.read_config( blk );
+
+    if( !governor_.configure( settings_ ) )
+    {
+      throw config_block_parse_error( "Unable to configure quality governor." );
+    }
+  }
+  catch( const config_block_parse_error& e )
+  {
+    LOG_ERROR( this->name() << ": set_params failed: " << e.what() );
+    return false;
+  }
+
+  config_.update( blk );
+  return true;
+}
+
+
+bool
+quality_governor_process
+::initialize()
+{
+  quality_tier_ = 0;
+  return true;
+}
+
+
+bool
+quality_governor_process
+::set_pipeline_to_monitor( const vidtk::pipeline* p )
+{
+  if( !settings_.enabled )
+  {
+    return true;
+  }
+
+  return governor_.monitor( p );
+}
+
+
+bool
+quality_governor_process
+::step()
+{
+  quality_tier_ = ( settings_.enabled ? governor_.update() : 0 );
+
+  LOG_TRACE( this->name() << ": load " << governor_.current_load()
+             << ", tier " << quality_tier_ );
+
+  return true;
+}
+
+
+void
+quality_governor_process
+::set_timestamp( vidtk::timestamp const& )
+{
+}
+
+
+unsigned
+quality_governor_process
+::quality_tier() const
+{
+  return quality_tier_;
+}
+
+} // end namespace vidtk
@@ -0,0 +1,70 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_quality_governor_process_h_
+#define vidtk_quality_governor_process_h_
+
+#include <process_framework/process.h>
+#include <process_framework/pipeline_aid.h>
+
+#include <pipeline_framework/pipeline.h>
+
+#include <utilities/quality_governor.h>
+#include <utilities/timestamp.h>
+
+namespace vidtk
+{
+
+// ----------------------------------------------------------------
+/**
+ * \brief Produces a processing quality tier for every input frame.
+ *
+ * Once per input timestamp, the load of a set of monitored pipeline nodes
+ * is measured and the active quality tier is updated. Downstream processes
+ * which support reduced quality modes can consume the tier alongside the
+ * frame it was computed for, which allows the pipeline to degrade quality
+ * under load instead of dropping frames.
+ */
+class quality_governor_process
+  : public process
+{
+
+public:
+
+  typedef quality_governor_process self_type;
+
+  quality_governor_process( std::string const& );
+  virtual ~quality_governor_process();
+
+  virtual vidtk::config_block params() const;
+  virtual bool set_params( vidtk::config_block const& );
+  virtual bool initialize();
+  virtual bool step();
+
+  /// Set pipeline to monitor. This call is required when enabled and
+  /// generally points at the pipeline this node is within.
+  virtual bool set_pipeline_to_monitor( const vidtk::pipeline* p );
+
+  /// Timestamp of the current frame, used only to pace this process.
+  void set_timestamp( vidtk::timestamp const& ts );
+  VIDTK_INPUT_PORT( set_timestamp, vidtk::timestamp const& );
+
+  /// Quality tier selected for the current frame, 0 being full quality.
+  unsigned quality_tier() const;
+  VIDTK_OUTPUT_PORT( unsigned, quality_tier );
+
+private:
+
+  vidtk::config_block config_;
+  quality_governor_settings settings_;
+  quality_governor governor_;
+
+  unsigned quality_tier_;
+};
+
+}
+
+#endif // vidtk_quality_governor_process_h_
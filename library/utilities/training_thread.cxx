@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -15,65 +15,63 @@ VIDTK_LOGGER("training_thread_cxx_");
 
 training_thread
 ::training_thread()
+  : current_thread_index_( 0 ),
+    job_active_( false ),
+    job_count_( 0 )
 {
-  current_thread_index_ = 0;
-  launch_new_thread( 0 );
 }
 
 training_thread
 ::~training_thread()
 {
-  if( current_thread_->status == THREAD_RUNNING_UNTASKED ||
-      current_thread_->status == THREAD_RUNNING_TASKED )
-  {
-    current_thread_->status = THREAD_ABANDONED;
-    current_thread_->thread->interrupt();
-    current_thread_->thread->join();
-  }
+  forced_reset();
 
-  while( !old_threads_.empty() )
+  // Wait for abandoned tasks, since they still reference this object
+  lock_t lock( mutex_ );
+
+  while( job_count_ > 0 )
   {
-    if( old_threads_.front()->status != THREAD_TERMINATED )
-    {
-      old_threads_.front()->thread->join();
-    }
-    old_threads_.pop();
+    cond_var_.wait( lock );
   }
 }
 
-void
-training_thread
-::launch_new_thread( index_t id )
-{
-  current_thread_.reset( new thread_info_t() );
-  current_thread_->status = THREAD_RUNNING_UNTASKED;
-  current_thread_->index = id;
-
-  current_thread_->thread.reset(
-    new thread_t(
-      boost::bind( &training_thread::thread_job, this, current_thread_ )
-    )
-  );
-}
-
 void
 training_thread
 ::execute_if_able( training_thread_task_sptr& task )
 {
-  lock_t lock( current_thread_->mutex );
-  current_thread_->task_queue.push_back( task );
-  current_thread_->in_cond_var.notify_one();
+  index_t id;
+
+  {
+    lock_t lock( mutex_ );
+
+    pending_task_ = task;
+
+    if( job_active_ )
+    {
+      return;
+    }
+
+    job_active_ = true;
+    ++job_count_;
+    id = current_thread_index_;
+  }
+
+  // Training can take much longer than a frame, so it gets a thread of its
+  // own instead of occupying a compute pool worker. The destructor waits for
+  // job_count_ to reach zero, so the thread does not need to be joined.
+  boost::thread job( boost::bind( &training_thread::thread_job, this, id ) );
+  job.detach();
 }
 
 void
 training_thread
 ::block_until_finished()
 {
-  lock_t lock( current_thread_->mutex );
+  lock_t lock( mutex_ );
 
-  while( current_thread_->status != THREAD_RUNNING_UNTASKED )
+  while( job_active_ )
   {
-    current_thread_->out_cond_var.timed_wait( lock, boost::posix_time::milliseconds(1000) );
+    cond_var_.wait( lock );
   }
 }
 
@@ -81,84 +79,74 @@ void
 training_thread
 ::forced_reset()
 {
-  if( current_thread_->status != THREAD_RUNNING_UNTASKED )
-  {
-    lock_t lock( current_thread_->mutex );
-
-    current_thread_index_++;
+  lock_t lock( mutex_ );
 
-    task_queue_t& queue = current_thread_->task_queue;
-
-    for( task_queue_t::iterator p = queue.begin(); p != queue.end(); ++p )
-    {
-      (*p)->mark_as_invalid();
-    }
+  if( running_task_ )
+  {
+    running_task_->mark_as_invalid();
+    running_task_.reset();
+  }
 
-    current_thread_->status = THREAD_ABANDONED;
-    current_thread_->thread->interrupt();
-    launch_new_thread( current_thread_index_ );
+  if( pending_task_ )
+  {
+    pending_task_->mark_as_invalid();
+    pending_task_.reset();
   }
+
+  current_thread_index_++;
+  job_active_ = false;
+  cond_var_.notify_all();
 }
 
 void
 training_thread
-::thread_job( thread_info_sptr_t info )
+::thread_job( index_t id )
 {
-  try
+  while( true )
   {
-    // Initiate main loop which will execute until interrupted when we are shutting down
-    while( info->status != THREAD_ABANDONED ||
-           info->status != THREAD_TERMINATED )
+    training_thread_task_sptr task_ptr;
+
     {
-      training_thread_task_sptr task_ptr;
+      lock_t lock( mutex_ );
 
+      if( id != current_thread_index_ || !pending_task_ )
       {
-        lock_t lock( info->mutex );
-
-        if( info->task_queue.empty() )
-        {
-          info->status = THREAD_RUNNING_UNTASKED;
-        }
-
-        while( info->task_queue.empty() )
-        {
-          info->in_cond_var.timed_wait( lock, boost::posix_time::milliseconds(1000) );
-        }
-
-        while( info->task_queue.size() > 1 )
+        if( id == current_thread_index_ )
         {
-          info->task_queue.pop_front();
+          job_active_ = false;
         }
 
-        task_ptr = info->task_queue.front();
-        info->task_queue.pop_front();
-
-        if( info->status == THREAD_ABANDONED )
-        {
-          break;
-        }
-
-        info->status = THREAD_RUNNING_TASKED;
+        --job_count_;
+        cond_var_.notify_all();
+        return;
       }
 
+      task_ptr = pending_task_;
+      pending_task_.reset();
+      running_task_ = task_ptr;
+    }
+
+    try
+    {
       if( !task_ptr->execute() )
       {
         LOG_ERROR( "Error occured while executing training task!" );
       }
+    }
+    catch(...)
+    {
+      LOG_ERROR( "Trainer task has thrown an exception!" );
+    }
 
-      info->out_cond_var.notify_one();
+    {
+      lock_t lock( mutex_ );
+
+      if( id == current_thread_index_ )
+      {
+        running_task_.reset();
+      }
     }
   }
-  catch( boost::thread_interrupted const& )
-  {
-    LOG_DEBUG( "Trainer worker thread shutting down." );
-  }
-  catch(...)
-  {
-    LOG_ERROR( "Trainer worker thread has thrown an exception!" );
-  }
-
-  info->status = THREAD_TERMINATED;
 }
 
 } // end namespace vidtk
@@ -64,14 +64,14 @@ private:
 typedef boost::shared_ptr< training_thread_task > training_thread_task_sptr;
 
 
-/// \brief A class which contains an external thread for the purpose of training
-/// a classifier (or performing some other related task) outside of a standard
-/// sequential processing pipeline.
+/// \brief A class which runs tasks for the purpose of training a classifier
+/// (or performing some other related task) outside of a standard sequential
+/// processing pipeline.
 ///
-/// If it is able to, this class will always keep this thread busy with the most
-/// recently added task. When a hard reset is called, this class has the possibility
-/// of allocating more than 1 thread for a short period of time (as old tasks
-/// are marked as invalid and finish off).
+/// Tasks are executed one at a time on a background thread, and if several
+/// are queued while one is running only the most recent is kept. When a hard reset is called, a new task may be started before the
+/// abandoned one has finished (as old tasks are marked as invalid and finish
+/// off), so for a short period of time more than one task may be running.
 class training_thread
 {
 public:
@@ -102,50 +102,31 @@ public:
 private:
 
   typedef unsigned index_t;
-  typedef boost::thread thread_t;
-  typedef boost::shared_ptr< thread_t > thread_sptr_t;
   typedef boost::condition_variable cond_var_t;
   typedef boost::mutex mutex_t;
   typedef boost::unique_lock< mutex_t > lock_t;
-  typedef std::list< training_thread_task_sptr > task_queue_t;
-
-  enum thread_status_t
-  {
-    THREAD_RUNNING_TASKED = 0,
-    THREAD_RUNNING_UNTASKED = 1,
-    THREAD_FAILED = 2,
-    THREAD_ABANDONED = 3,
-    THREAD_TERMINATED = 4
-  };
-
-  struct thread_info_t
-  {
-    index_t index;
-    thread_sptr_t thread;
-    cond_var_t in_cond_var;
-    cond_var_t out_cond_var;
-    thread_status_t status;
-    mutex_t mutex;
-    task_queue_t task_queue;
-  };
-
-  typedef boost::shared_ptr< thread_info_t > thread_info_sptr_t;
-
-  // Current (active) thread executing inputted tasks
-  thread_info_sptr_t current_thread_;
-
-  // Latest launched thread ID
+
+  mutex_t mutex_;
+  cond_var_t cond_var_;
+
+  // Most recently inputted task which has not been started yet
+  training_thread_task_sptr pending_task_;
+
+  // Task of the current generation which is being executed
+  training_thread_task_sptr running_task_;
+
+  // Incremented on each forced reset, jobs of older generations exit
+  // as soon as their current task completes
   index_t current_thread_index_;
 
-  // Past threads which we no longer care anything about, and simply want
-  // to forget about as soon as possible
-  std::queue< thread_info_sptr_t > old_threads_;
+  // Does the current generation have a job thread?
+  bool job_active_;
 
-  // Internal thread job
-  void thread_job( thread_info_sptr_t info );
+  // Number of job threads, including abandoned ones
+  unsigned job_count_;
 
-  // Launch a new current thread
-  void launch_new_thread( index_t id );
+  // Job thread, which runs pending tasks until there are none
+  void thread_job( index_t id );
 };
 
 
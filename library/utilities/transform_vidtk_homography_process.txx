@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -232,6 +232,7 @@ transform_vidtk_homography_process< InSrcType, InDestType, OutSrcType, OutDestTy
   out_H_.set_source_reference(rSrc);
   out_H_.set_dest_reference(rDest);
   out_H_.set_valid(is_valid);
+  out_H_.set_new_reference(inp_H_->is_new_reference());
   out_inv_H_ = out_H_.get_inverse();
 
   // Mark the homography as being "used".
@@ -73,6 +73,14 @@ public:
   virtual video_metadata metadata() const;
   virtual vil_image_view<PixType> image() const = 0;
 
+  /// \brief The native intensity plane of the current frame, if any.
+  ///
+  /// Sources which decode to a luma/chroma format can return the luma
+  /// plane here, so that consumers needing only intensity do not have
+  /// to convert image() back to greyscale. The default implementation
+  /// returns an empty image.
+  virtual vil_image_view<PixType> luma_image() const;
+
   /// \brief The size of the images, if known.
   ///
   /// For image sequences of fixed size, ni() and nj() return the size
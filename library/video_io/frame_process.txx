@@ -87,6 +87,14 @@ frame_process<PixType>
   return metadata_;
 }
 
+template< class PixType >
+vil_image_view<PixType>
+frame_process<PixType>
+::luma_image() const
+{
+  return vil_image_view<PixType>();
+}
+
 }
 
 #endif
@@ -13,6 +13,10 @@
 #include <video_io/image_list_frame_metadata_process.h>
 #include <video_io/frame_metadata_super_process.h>
 
+#ifdef USE_LIBAV
+#include <video_io/libav_frame_process.h>
+#endif
+
 namespace vidtk
 {
 
@@ -48,6 +52,12 @@ generic_frame_process<vxl_byte>
                                    new vidl_ffmpeg_metadata_frame_process(
                                      this->name()+"/ffmpeg_metadata" ) ) );
 
+#ifdef USE_LIBAV
+  impls_.push_back( std::make_pair( "libav",
+                                   new libav_frame_process(
+                                     this->name()+"/libav" ) ) );
+#endif
+
   impls_.push_back( std::make_pair( "image_list",
                                    new image_list_frame_process<vxl_byte>(
                                      this->name()+"/imagelist" ) ) );
@@ -72,6 +72,11 @@ public:
   vil_image_view<PixType> copied_image() const;
   VIDTK_OUTPUT_PORT( vil_image_view<PixType>, copied_image );
 
+  /// The native luma plane of the current frame, empty when the
+  /// selected source does not provide one.
+  virtual vil_image_view<PixType> luma_image() const;
+  VIDTK_OUTPUT_PORT( vil_image_view<PixType>, luma_image );
+
   virtual vidtk::video_metadata metadata() const;
   VIDTK_OUTPUT_PORT( vidtk::video_metadata, metadata );
 
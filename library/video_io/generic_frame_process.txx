@@ -252,6 +252,18 @@ generic_frame_process<PixType>
   return copy_img_;
 }
 
+
+template<class PixType>
+vil_image_view<PixType>
+generic_frame_process<PixType>
+::luma_image() const
+{
+  LOG_ASSERT( impl_ != NULL, "no implementation selected" );
+
+  return impl_->luma_image();
+}
+
+
 template<class PixType>
 video_metadata
 generic_frame_process<PixType>
@@ -265,7 +277,8 @@ generic_frame_process<PixType>
   if (impl_name_ != "image_metadata_list"
       && impl_name_ != "tcp_frame_metadata"
       && impl_name_ != "vidl_ffmpeg_metadata"
-      && impl_name_ != "vidl_ffmpeg" )
+      && impl_name_ != "vidl_ffmpeg"
+      && impl_name_ != "libav" )
   {
     //Warn that there probably is not metadata.  The tracker can work without metadata.
     LOG_WARN(this->name() << " implementation does not supply metadata: " << impl_name_);
@@ -0,0 +1,1207 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+// Required by the libav headers when included from C++, and must be
+// defined before anything includes stdint.h
+#ifndef __STDC_CONSTANT_MACROS
+#define __STDC_CONSTANT_MACROS
+#endif
+
+#include <video_io/libav_frame_process.h>
+
+#include <vil/vil_crop.h>
+#include <vil/vil_memory_chunk.h>
+
+#include <klv/klv_key.h>
+#include <klv/klv_0601.h>
+#include <klv/klv_0601_traits.h>
+#include <klv/klv_0104.h>
+#include <klv/klv_parse.h>
+
+#include <utilities/klv_to_metadata.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include <logger/logger.h>
+
+using boost::int64_t;
+
+namespace vidtk
+{
+
+VIDTK_LOGGER("libav_frame_process_cxx");
+
+namespace
+{
+
+// avformat_open_input and avcodec_open2 are not thread safe.
+boost::mutex libav_open_lock;
+
+
+// ----------------------------------------------------------------
+/* Memory chunk which holds a reference to a decoded frame.
+ *
+ * This allows images to point directly into the decoder's output
+ * buffers, which stay valid for as long as any view refers to them.
+ */
+class libav_frame_chunk
+  : public vil_memory_chunk
+{
+public:
+  libav_frame_chunk( AVFrame const* frame )
+    : frame_( av_frame_clone( frame ) )
+  {
+  }
+
+  virtual ~libav_frame_chunk()
+  {
+    av_frame_free( &frame_ );
+  }
+
+  virtual void* data() { return frame_->data[0]; }
+  virtual void* const_data() const { return frame_->data[0]; }
+  virtual vil_pixel_format pixel_format() const { return VIL_PIXEL_FORMAT_BYTE; }
+  virtual unsigned long size() const
+  {
+    return static_cast< unsigned long >( frame_->linesize[0] ) * frame_->height;
+  }
+  virtual void set_size( unsigned long, vil_pixel_format )
+  {
+    LOG_ERROR( "Decoded frame buffers can not be resized" );
+  }
+
+private:
+  AVFrame* frame_;
+};
+
+
+// Search a video packet for an embedded MISP microsecond timestamp.
+bool find_misp_time( const unsigned char* data, int size, int64_t& ts )
+{
+  static const std::string misp( "MISPmicrosectime" );
+  const int packet_size = static_cast< int >( misp.size() ) + 13;
+
+  for( int i = 0; i + packet_size < size; ++i )
+  {
+    if( std::equal( misp.begin(), misp.end(), data + i ) )
+    {
+      // Skip the flag byte and every third "ignore" byte.
+      const unsigned char* p = data + i + misp.size() + 1;
+      const int msb[8] = { 0, 1, 3, 4, 6, 7, 9, 10 };
+
+      ts = 0;
+      for( unsigned b = 0; b < 8; ++b )
+      {
+        ts = ( ts << 8 ) | static_cast< int64_t >( p[ msb[b] ] );
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Check if the luma of a frame already spans the full 0-255 range.
+bool is_full_range( const AVFrame* frame )
+{
+  switch( frame->format )
+  {
+    case AV_PIX_FMT_GRAY8:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_YUVJ440P:
+      return true;
+
+    default:
+      return frame->color_range == AVCOL_RANGE_JPEG;
+  }
+}
+
+
+// Expand limited range (16-235) luma to the full range, so that it is
+// comparable to a greyscale conversion of the full range RGB output.
+vil_image_view< vxl_byte > expand_luma_range( const vil_image_view< vxl_byte >& src )
+{
+  static vxl_byte lut[256];
+  static bool lut_ready = false;
+  static boost::mutex lut_lock;
+
+  {
+    boost::lock_guard< boost::mutex > lock( lut_lock );
+
+    if( !lut_ready )
+    {
+      for( int v = 0; v < 256; ++v )
+      {
+        const int e = ( ( v - 16 ) * 255 + 109 ) / 219;
+        lut[v] = static_cast< vxl_byte >( std::min( 255, std::max( 0, e ) ) );
+      }
+      lut_ready = true;
+    }
+  }
+
+  const unsigned ni = src.ni();
+  const unsigned nj = src.nj();
+  vil_image_view< vxl_byte > dst( ni, nj, 1 );
+
+  for( unsigned j = 0; j < nj; ++j )
+  {
+    const vxl_byte* in = src.top_left_ptr() + j * src.jstep();
+    vxl_byte* out = dst.top_left_ptr() + j * dst.jstep();
+
+    for( unsigned i = 0; i < ni; ++i )
+    {
+      out[i] = lut[ in[i] ];
+    }
+  }
+
+  return dst;
+}
+
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------
+class libav_frame_process::priv
+{
+public:
+  priv( libav_frame_process* parent );
+  ~priv();
+
+  bool open();
+  void close();
+
+  bool read_frame();
+  bool rewind( int64_t pts, int64_t pos );
+  bool build_index();
+  bool init_timestamp();
+  bool klv_timestamp( std::deque< vxl_byte > md, double& time ) const;
+  bool read_klv( const klv_data& klv );
+  void collect_metadata( int64_t pts, std::deque< vxl_byte >& md );
+
+  unsigned frame_number_of( int64_t pts ) const;
+  double pts_seconds( int64_t pts ) const;
+
+  bool convert_frame();
+
+  libav_frame_process* parent;
+
+  // Configuration
+  std::string filename;
+  unsigned start_frame;
+  unsigned stop_after_frame;
+  int n_blank_frames_after_eoi;
+  std::string klv_type;
+  std::string time_type;
+  bool simulate_stream;
+  double ts_scaling_factor;
+  unsigned thread_count;
+  std::string thread_type;
+  std::string output_format;
+  bool index_on_open;
+
+  // libav state
+  AVFormatContext* format_ctx;
+  AVCodecContext* codec_ctx;
+  AVFrame* frame;
+  AVPacket* packet;
+  SwsContext* sws_ctx;
+  int video_index;
+  int data_index;
+  int64_t start_pts;
+  bool eof;
+  bool has_luma_plane;
+
+  // Keyframe index, frame number to (pts, byte position)
+  typedef std::map< unsigned, std::pair< int64_t, int64_t > > keyframe_index_t;
+  keyframe_index_t keyframe_index;
+
+  // KLV packets which have been read but not yet assigned to a frame
+  std::deque< std::pair< int64_t, std::vector< vxl_byte > > > pending_klv;
+
+  // Current frame
+  bool read_ahead;
+  unsigned frame_number;
+  double frame_pts;
+  std::deque< vxl_byte > current_md;
+  vil_image_view< vxl_byte > img;
+  vil_image_view< vxl_byte > luma;
+
+  unsigned ni;
+  unsigned nj;
+  unsigned nframes;
+  double frame_rate;
+  bool blank_frame_mode;
+  mutable unsigned last_frame;
+
+  // Timestamp handling
+  vidtk::timestamp meta_ts;
+  vidtk::timestamp ts;
+  double pts_of_meta_ts;
+
+  boost::posix_time::ptime start_local_time;
+  vidtk::timestamp start_source_time;
+};
+
+
+libav_frame_process::priv
+::priv( libav_frame_process* p )
+  : parent( p ),
+    start_frame( -1 ),
+    stop_after_frame( -1 ),
+    n_blank_frames_after_eoi( -1 ),
+    klv_type( "none" ),
+    time_type( "pts" ),
+    simulate_stream( false ),
+    ts_scaling_factor( 1.0 ),
+    thread_count( 0 ),
+    thread_type( "frame" ),
+    output_format( "rgb" ),
+    index_on_open( false ),
+    format_ctx( NULL ),
+    codec_ctx( NULL ),
+    frame( NULL ),
+    packet( NULL ),
+    sws_ctx( NULL ),
+    video_index( -1 ),
+    data_index( -1 ),
+    start_pts( 0 ),
+    eof( false ),
+    has_luma_plane( false ),
+    read_ahead( false ),
+    frame_number( 0 ),
+    frame_pts( 0.0 ),
+    ni( 0 ),
+    nj( 0 ),
+    nframes( 0 ),
+    frame_rate( 0.0 ),
+    blank_frame_mode( false ),
+    last_frame( 0 ),
+    meta_ts( 0.0 ),
+    ts( 0.0 ),
+    pts_of_meta_ts( 0.0 )
+{
+}
+
+
+libav_frame_process::priv
+::~priv()
+{
+  close();
+}
+
+
+void
+libav_frame_process::priv
+::close()
+{
+  sws_freeContext( sws_ctx );
+  sws_ctx = NULL;
+  av_frame_free( &frame );
+  av_packet_free( &packet );
+  avcodec_free_context( &codec_ctx );
+  avformat_close_input( &format_ctx );
+
+  video_index = -1;
+  data_index = -1;
+  eof = false;
+  keyframe_index.clear();
+  pending_klv.clear();
+}
+
+
+bool
+libav_frame_process::priv
+::open()
+{
+  close();
+
+  boost::lock_guard< boost::mutex > lock( libav_open_lock );
+
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT( 58, 9, 100 )
+  av_register_all();
+#endif
+
+  if( avformat_open_input( &format_ctx, filename.c_str(), NULL, NULL ) < 0 )
+  {
+    LOG_ERROR( parent->name() << ": failed to open video: " << filename );
+    return false;
+  }
+
+  if( avformat_find_stream_info( format_ctx, NULL ) < 0 )
+  {
+    LOG_ERROR( parent->name() << ": failed to read stream info: " << filename );
+    return false;
+  }
+
+  AVCodec* codec = NULL;
+  video_index = av_find_best_stream( format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0 );
+
+  if( video_index < 0 || !codec )
+  {
+    LOG_ERROR( parent->name() << ": no decodable video stream in: " << filename );
+    return false;
+  }
+
+  for( unsigned i = 0; i < format_ctx->nb_streams; ++i )
+  {
+    if( format_ctx->streams[i]->codecpar->codec_id == AV_CODEC_ID_SMPTE_KLV ||
+        ( format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_DATA && data_index < 0 ) )
+    {
+      data_index = static_cast< int >( i );
+    }
+  }
+
+  AVStream* stream = format_ctx->streams[video_index];
+
+  codec_ctx = avcodec_alloc_context3( codec );
+  if( !codec_ctx || avcodec_parameters_to_context( codec_ctx, stream->codecpar ) < 0 )
+  {
+    LOG_ERROR( parent->name() << ": unable to create decoder context" );
+    return false;
+  }
+
+  // A thread count of 0 lets libavcodec pick one per hardware thread.
+  codec_ctx->thread_count = static_cast< int >( thread_count );
+  codec_ctx->thread_type = ( thread_type == "slice" ? FF_THREAD_SLICE :
+                             thread_type == "frame" ? FF_THREAD_FRAME :
+                             FF_THREAD_FRAME | FF_THREAD_SLICE );
+
+  if( avcodec_open2( codec_ctx, codec, NULL ) < 0 )
+  {
+    LOG_ERROR( parent->name() << ": unable to open decoder" );
+    return false;
+  }
+
+  frame = av_frame_alloc();
+  packet = av_packet_alloc();
+
+  start_pts = ( stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0 );
+
+  AVRational rate = av_guess_frame_rate( format_ctx, stream, NULL );
+  frame_rate = ( rate.num > 0 && rate.den > 0 ? av_q2d( rate ) : 0.0 );
+
+  if( stream->nb_frames > 0 )
+  {
+    nframes = static_cast< unsigned >( stream->nb_frames );
+  }
+  else if( format_ctx->duration != AV_NOPTS_VALUE )
+  {
+    nframes = static_cast< unsigned >( format_ctx->duration * frame_rate / AV_TIME_BASE + 0.5 );
+  }
+
+  ni = codec_ctx->width;
+  nj = codec_ctx->height;
+
+  return true;
+}
+
+
+double
+libav_frame_process::priv
+::pts_seconds( int64_t pts ) const
+{
+  return pts * av_q2d( format_ctx->streams[video_index]->time_base );
+}
+
+
+unsigned
+libav_frame_process::priv
+::frame_number_of( int64_t pts ) const
+{
+  return static_cast< unsigned >( ( pts - start_pts ) *
+                                  av_q2d( format_ctx->streams[video_index]->time_base ) *
+                                  frame_rate + 0.5 );
+}
+
+
+// ----------------------------------------------------------------
+/* Decode the next frame.
+ *
+ * Packets are demuxed until the decoder produces a frame. Keyframes
+ * are added to the index, and KLV packets are queued until a frame
+ * with a later presentation time is produced, since frame threading
+ * delays the decoder output relative to the demuxer.
+ */
+bool
+libav_frame_process::priv
+::read_frame()
+{
+  while( true )
+  {
+    int ret = avcodec_receive_frame( codec_ctx, frame );
+
+    if( ret == 0 )
+    {
+      int64_t pts = frame->best_effort_timestamp;
+
+      if( pts != AV_NOPTS_VALUE )
+      {
+        frame_number = frame_number_of( pts );
+        frame_pts = pts_seconds( pts );
+      }
+      else
+      {
+        ++frame_number;
+        frame_pts += ( frame_rate > 0.0 ? 1.0 / frame_rate : 0.0 );
+      }
+
+      collect_metadata( pts, current_md );
+      return true;
+    }
+    else if( ret == AVERROR_EOF )
+    {
+      return false;
+    }
+    else if( ret != AVERROR( EAGAIN ) )
+    {
+      LOG_ERROR( parent->name() << ": decode error " << ret );
+      return false;
+    }
+
+    if( eof )
+    {
+      return false;
+    }
+
+    if( av_read_frame( format_ctx, packet ) < 0 )
+    {
+      // Drain any frames still buffered in the decoder threads.
+      eof = true;
+      avcodec_send_packet( codec_ctx, NULL );
+      continue;
+    }
+
+    if( packet->stream_index == video_index )
+    {
+      if( ( packet->flags & AV_PKT_FLAG_KEY ) && packet->pts != AV_NOPTS_VALUE )
+      {
+        keyframe_index[ frame_number_of( packet->pts ) ] = std::make_pair( packet->pts, packet->pos );
+      }
+
+      if( avcodec_send_packet( codec_ctx, packet ) < 0 )
+      {
+        LOG_WARN( parent->name() << ": dropping undecodable packet" );
+      }
+    }
+    else if( packet->stream_index == data_index && klv_type != "none" )
+    {
+      // Rescale to the video time base so that packets can be matched to frames.
+      int64_t pts = ( packet->pts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE :
+                      av_rescale_q( packet->pts,
+                                    format_ctx->streams[data_index]->time_base,
+                                    format_ctx->streams[video_index]->time_base ) );
+      pending_klv.push_back( std::make_pair( pts, std::vector< vxl_byte >(
+                                               packet->data, packet->data + packet->size ) ) );
+    }
+
+    av_packet_unref( packet );
+  }
+}
+
+
+void
+libav_frame_process::priv
+::collect_metadata( int64_t pts, std::deque< vxl_byte >& md )
+{
+  md.clear();
+
+  while( !pending_klv.empty() &&
+         ( pts == AV_NOPTS_VALUE ||
+           pending_klv.front().first == AV_NOPTS_VALUE ||
+           pending_klv.front().first <= pts ) )
+  {
+    md.insert( md.end(), pending_klv.front().second.begin(), pending_klv.front().second.end() );
+    pending_klv.pop_front();
+  }
+}
+
+
+// ----------------------------------------------------------------
+/* Reposition the demuxer and flush the decoder.
+ *
+ * A byte position is used when known and supported by the container,
+ * since it is exact and does not require a search. Otherwise the
+ * nearest keyframe at or before the given pts is used.
+ */
+bool
+libav_frame_process::priv
+::rewind( int64_t pts, int64_t pos )
+{
+  int ret = -1;
+
+  if( pos >= 0 && !( format_ctx->iformat->flags & AVFMT_NO_BYTE_SEEK ) )
+  {
+    ret = av_seek_frame( format_ctx, video_index, pos, AVSEEK_FLAG_BYTE );
+  }
+
+  if( ret < 0 )
+  {
+    ret = av_seek_frame( format_ctx, video_index, pts, AVSEEK_FLAG_BACKWARD );
+  }
+
+  if( ret < 0 )
+  {
+    return false;
+  }
+
+  avcodec_flush_buffers( codec_ctx );
+  eof = false;
+  pending_klv.clear();
+  frame_number = 0;
+  return true;
+}
+
+
+bool
+libav_frame_process::priv
+::build_index()
+{
+  while( av_read_frame( format_ctx, packet ) >= 0 )
+  {
+    if( packet->stream_index == video_index &&
+        ( packet->flags & AV_PKT_FLAG_KEY ) && packet->pts != AV_NOPTS_VALUE )
+    {
+      keyframe_index[ frame_number_of( packet->pts ) ] = std::make_pair( packet->pts, packet->pos );
+    }
+    av_packet_unref( packet );
+  }
+
+  LOG_DEBUG( parent->name() << ": indexed " << keyframe_index.size() << " keyframes" );
+
+  return rewind( start_pts, -1 );
+}
+
+
+bool
+libav_frame_process::priv
+::klv_timestamp( std::deque< vxl_byte > md, double& time ) const
+{
+  klv_data klv_packet;
+
+  while( klv_pop_next_packet( md, klv_packet ) )
+  {
+    klv_uds_key uds_key( klv_packet );
+
+    if( klv_type == "0601" && is_klv_0601_key( uds_key ) && klv_0601_checksum( klv_packet ) )
+    {
+      klv_lds_vector_t lds = parse_klv_lds( klv_packet );
+      for( klv_lds_vector_t::const_iterator itr = lds.begin(); itr != lds.end(); ++itr )
+      {
+        const klv_0601_tag tag( static_cast< klv_0601_tag >( vxl_byte( itr->first ) ) );
+        if( tag == KLV_0601_UNIX_TIMESTAMP )
+        {
+          boost::any data = klv_0601_value( tag, &itr->second[0], itr->second.size() );
+          time = static_cast< double >(
+            boost::any_cast< klv_0601_traits< KLV_0601_UNIX_TIMESTAMP >::type >( data ) );
+          return true;
+        }
+      }
+    }
+    else if( klv_type == "0104" && klv_0104::is_key( uds_key ) )
+    {
+      klv_uds_vector_t uds = parse_klv_uds( klv_packet );
+      for( klv_uds_vector_t::const_iterator itr = uds.begin(); itr != uds.end(); ++itr )
+      {
+        const klv_0104::tag tag = klv_0104::inst()->get_tag( itr->first );
+        if( tag == klv_0104::UNIX_TIMESTAMP )
+        {
+          boost::any data = klv_0104::inst()->get_value( tag, &itr->second[0], itr->second.size() );
+          time = static_cast< double >( klv_0104::inst()->get_value< vxl_uint_64 >( tag, data ) );
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+
+// ----------------------------------------------------------------
+/* Find the first metadata timestamp, if requested.
+ *
+ * Unlike vidl_ffmpeg_frame_process, the search only demuxes packets
+ * (nothing is decoded) and the stream is rewound with a seek instead
+ * of reopening the file. As before, the first timestamp found is
+ * advanced by the difference in presentation time for later frames.
+ */
+bool
+libav_frame_process::priv
+::init_timestamp()
+{
+  meta_ts.set_time( 0.0 );
+
+  if( time_type == "misp" || ( time_type == "klv" && data_index >= 0 ) )
+  {
+    while( meta_ts.time() == 0.0 && av_read_frame( format_ctx, packet ) >= 0 )
+    {
+      if( time_type == "misp" && packet->stream_index == video_index )
+      {
+        int64_t misp_ts = 0;
+        if( find_misp_time( packet->data, packet->size, misp_ts ) )
+        {
+          meta_ts.set_time( static_cast< double >( misp_ts ) * ts_scaling_factor );
+          pts_of_meta_ts = pts_seconds( packet->pts );
+          LOG_DEBUG( parent->name() << " found MISP timestamp:" << meta_ts );
+        }
+      }
+      else if( time_type == "klv" && packet->stream_index == data_index )
+      {
+        std::deque< vxl_byte > md( packet->data, packet->data + packet->size );
+        double klv_time = 0.0;
+        if( klv_timestamp( md, klv_time ) )
+        {
+          meta_ts.set_time( klv_time * ts_scaling_factor );
+          pts_of_meta_ts = ( packet->pts == AV_NOPTS_VALUE ? frame_pts :
+                             av_q2d( format_ctx->streams[data_index]->time_base ) * packet->pts );
+          LOG_DEBUG( parent->name() << " found initial klv timestamp: " << meta_ts );
+        }
+      }
+      else if( packet->stream_index == video_index && packet->pts != AV_NOPTS_VALUE )
+      {
+        frame_pts = pts_seconds( packet->pts );
+      }
+
+      av_packet_unref( packet );
+    }
+
+    // Some videos do not seek, even to the start, so reopen as a last resort.
+    if( !rewind( start_pts, -1 ) && !open() )
+    {
+      return false;
+    }
+  }
+
+  if( !read_frame() )
+  {
+    return false;
+  }
+
+  if( meta_ts.time() != 0.0 )
+  {
+    ts.set_time( meta_ts.time() );
+  }
+  else
+  {
+    if( time_type != "pts" )
+    {
+      LOG_WARN( parent->name() << " Did not find " << time_type << " time stamp, using pts." );
+    }
+    pts_of_meta_ts = frame_pts;
+    ts.set_time( 0.0 );
+  }
+
+  return true;
+}
+
+
+bool
+libav_frame_process::priv
+::read_klv( const klv_data& klv )
+{
+  bool good = false;
+  klv_uds_key uds_key( klv );
+
+  if( klv_type == "0601" && is_klv_0601_key( uds_key ) )
+  {
+    good = klv_0601_to_metadata( klv, parent->metadata_ );
+  }
+  else if( klv_type == "0104" && klv_0104::is_key( uds_key ) )
+  {
+    good = klv_0104_to_metadata( klv, parent->metadata_ );
+  }
+
+  if( good )
+  {
+    double time_diff = std::fabs( static_cast< double >( parent->metadata_.timeUTC() ) - ts.time() );
+    //warn if meta time and ts time differ by more than 10 seconds
+    if( time_diff > 1e7 )
+    {
+      LOG_WARN( "Metadata timestamp large sync difference: " << time_diff / 1e6 << " seconds." );
+    }
+  }
+
+  return good;
+}
+
+
+// ----------------------------------------------------------------
+/* Produce the output images for the decoded frame.
+ *
+ * The luma plane is wrapped without a copy when the decoder output is
+ * planar with 8-bit full range luma in the first plane, limited range
+ * luma is expanded through a lookup table. RGB output is written by
+ * swscale directly into the memory of the output image.
+ */
+bool
+libav_frame_process::priv
+::convert_frame()
+{
+  const AVPixFmtDescriptor* desc =
+    av_pix_fmt_desc_get( static_cast< AVPixelFormat >( frame->format ) );
+
+  has_luma_plane = desc &&
+    !( desc->flags & ( AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BE ) ) &&
+    desc->comp[0].plane == 0 && desc->comp[0].step == 1 &&
+    desc->comp[0].depth == 8 && desc->comp[0].shift == 0;
+
+  luma = vil_image_view< vxl_byte >();
+
+  if( has_luma_plane )
+  {
+    vil_memory_chunk_sptr chunk = new libav_frame_chunk( frame );
+    luma = vil_image_view< vxl_byte >( chunk, frame->data[0],
+                                       frame->width, frame->height, 1,
+                                       1, frame->linesize[0], frame->width * frame->height );
+
+    if( !is_full_range( frame ) )
+    {
+      luma = expand_luma_range( luma );
+    }
+  }
+
+  const bool grey = ( output_format == "grey" );
+
+  if( grey && has_luma_plane )
+  {
+    img = luma;
+    return true;
+  }
+
+  const AVPixelFormat dst_format = ( grey ? AV_PIX_FMT_GRAY8 : AV_PIX_FMT_RGB24 );
+  const unsigned nplanes = ( grey ? 1 : 3 );
+
+  sws_ctx = sws_getCachedContext( sws_ctx,
+                                  frame->width, frame->height,
+                                  static_cast< AVPixelFormat >( frame->format ),
+                                  frame->width, frame->height, dst_format,
+                                  SWS_BILINEAR, NULL, NULL, NULL );
+  if( !sws_ctx )
+  {
+    LOG_ERROR( parent->name() << ": unable to create pixel format converter" );
+    return false;
+  }
+
+  // Interleaved output, matching the layout produced by vidl_convert_to_view.
+  // Padding allows swscale's vectorized loops to overrun the last row.
+  const std::ptrdiff_t row_size = static_cast< std::ptrdiff_t >( frame->width ) * nplanes;
+  vil_memory_chunk_sptr chunk =
+    new vil_memory_chunk( row_size * frame->height + 64, VIL_PIXEL_FORMAT_BYTE );
+  vxl_byte* top_left = reinterpret_cast< vxl_byte* >( chunk->data() );
+
+  uint8_t* dst_data[4] = { top_left, NULL, NULL, NULL };
+  int dst_linesize[4] = { static_cast< int >( row_size ), 0, 0, 0 };
+
+  sws_scale( sws_ctx, frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize );
+
+  img = vil_image_view< vxl_byte >( chunk, top_left, frame->width, frame->height, nplanes,
+                                    nplanes, row_size, 1 );
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+libav_frame_process
+::libav_frame_process( std::string const& _name )
+  : frame_process<vxl_byte>( _name, "libav_frame_process" ),
+    d( new priv( this ) )
+{
+}
+
+
+libav_frame_process
+::~libav_frame_process()
+{
+}
+
+
+config_block
+libav_frame_process
+::params() const
+{
+  config_block blk;
+  std::stringstream uintmax;
+  uintmax << std::numeric_limits<unsigned int>::max();
+
+  blk.add_parameter( "filename", "Name of video file" );
+  blk.add_parameter( "start_at_frame", "-1", "-1 to start at beginning of video" );
+  blk.add_parameter( "stop_after_frame", uintmax.str(), "Index of the last frame to read" );
+  blk.add_parameter( "n_blank_frames_after_eoi", "0", "Number of blank frames after input to terminate active tracks" );
+  blk.add_parameter( "klv_type", "none", "Type of klv metadata to use: [0601, 0104, none]" );
+  blk.add_parameter( "time_type", "pts", "Source of timestamp to use: [misp, klv, pts]" );
+  blk.add_parameter( "simulate_stream", "false", "Simulate a streaming source" );
+  blk.add_parameter( "ts_scaling_factor", "1.0", "Multiply each of the timestamp by this factor."
+    " This is useful as the timestamps encoded in some videos (with MISP sources notably) might not be"
+    " in the correct unit. In this case, the ts_scaling_factor can be used to scale the time to the"
+    " correct unit." );
+  blk.add_parameter( "thread_count", "0",
+    "Number of decoder threads, 0 lets the decoder use one per hardware thread." );
+  blk.add_parameter( "thread_type", "frame",
+    "Decoder threading model: [frame, slice, both]. Frame threading scales best but adds "
+    "one frame of latency per thread, slice threading has no added latency but depends "
+    "on how the stream was encoded." );
+  blk.add_parameter( "output_format", "rgb",
+    "Output image format: [rgb, grey]. When grey is selected and the video is planar YUV, "
+    "the decoder's luma plane is output directly, with no copy for full range video." );
+  blk.add_parameter( "index_on_open", "false",
+    "Index all keyframes in the file when it is opened, so that any seek goes directly to "
+    "the nearest keyframe. Otherwise keyframes are indexed as they are read." );
+
+  return blk;
+}
+
+
+bool
+libav_frame_process
+::set_params( config_block const& blk )
+{
+  try
+  {
+    d->filename = blk.get<std::string>( "filename" );
+
+    // See vidl_ffmpeg_frame_process, "-1" does not parse as unsigned on all platforms
+    d->start_frame =
+      ( blk.get< std::string >( "start_at_frame" ) == "-1" )
+      ? static_cast< unsigned >( -1 )
+      : blk.get< unsigned >( "start_at_frame" );
+
+    d->stop_after_frame = blk.get<unsigned>( "stop_after_frame" );
+    d->n_blank_frames_after_eoi = blk.get<int>( "n_blank_frames_after_eoi" );
+    d->klv_type = blk.get<std::string>( "klv_type" );
+    d->time_type = blk.get<std::string>( "time_type" );
+    d->simulate_stream = blk.get<bool>( "simulate_stream" );
+    d->ts_scaling_factor = blk.get<double>( "ts_scaling_factor" );
+    d->thread_count = blk.get<unsigned>( "thread_count" );
+    d->thread_type = blk.get<std::string>( "thread_type" );
+    d->output_format = blk.get<std::string>( "output_format" );
+    d->index_on_open = blk.get<bool>( "index_on_open" );
+  }
+  catch( config_block_parse_error const& e )
+  {
+    LOG_ERROR( this->name() << ": set_params failed: "
+               << e.what() );
+    return false;
+  }
+
+  if( d->klv_type != "none" && d->klv_type != "0104" && d->klv_type != "0601" )
+  {
+    LOG_ERROR( this->name() << " klv_type: " << d->klv_type << " is not 0104, 0601, or none." );
+    return false;
+  }
+
+  if( d->time_type != "pts" && d->time_type != "klv" && d->time_type != "misp" )
+  {
+    LOG_ERROR( this->name() << " time_type: " << d->time_type << " is not misp, klv, or pts." );
+    return false;
+  }
+
+  if( d->klv_type == "none" && d->time_type == "klv" )
+  {
+    LOG_ERROR( this->name() << " klv_type is none yet time_type is set to klv." );
+    return false;
+  }
+
+  if( d->thread_type != "frame" && d->thread_type != "slice" && d->thread_type != "both" )
+  {
+    LOG_ERROR( this->name() << " thread_type: " << d->thread_type << " is not frame, slice, or both." );
+    return false;
+  }
+
+  if( d->output_format != "rgb" && d->output_format != "grey" )
+  {
+    LOG_ERROR( this->name() << " output_format: " << d->output_format << " is not rgb or grey." );
+    return false;
+  }
+
+  return true;
+}
+
+
+bool
+libav_frame_process
+::initialize()
+{
+  if( !d->open() )
+  {
+    return false;
+  }
+
+  if( d->data_index < 0 && d->klv_type != "none" )
+  {
+    LOG_WARN( this->name() << " requested klv metadata but no metadata is in the video." );
+    d->klv_type = "none";
+  }
+
+  if( d->index_on_open && !d->build_index() )
+  {
+    LOG_WARN( this->name() << " unable to rewind after indexing, reopening " << d->filename );
+    if( !d->open() )
+    {
+      return false;
+    }
+  }
+
+  metadata_.is_valid( false );
+
+  // Leaves the first frame decoded and ready for the first step
+  if( !d->init_timestamp() )
+  {
+    LOG_ERROR( this->name() << " failed to initialize the timestamp for: " << d->filename );
+    return false;
+  }
+
+  d->read_ahead = true;
+  d->ni = d->frame->width;
+  d->nj = d->frame->height;
+
+  if( d->start_frame != unsigned(-1) && d->start_frame > 0 )
+  {
+    return this->seek( d->start_frame );
+  }
+
+  return true;
+}
+
+
+bool
+libav_frame_process
+::step()
+{
+  LOG_ASSERT( d->format_ctx != NULL, "Input video stream is not open" );
+
+  if( d->read_ahead )
+  {
+    d->read_ahead = false;
+  }
+  else if( !d->read_frame() )
+  {
+    // optionally return blank frames after input, to hack a termination of active tracks
+    if( --d->n_blank_frames_after_eoi >= 0 )
+    {
+      d->blank_frame_mode = true;
+
+      LOG_ERROR( "Advance failed; returned blank frame " << ( d->n_blank_frames_after_eoi + 1 ) );
+
+      d->img = vil_image_view<vxl_byte>( d->ni, d->nj, d->output_format == "grey" ? 1 : 3 );
+      d->img.fill( 0 );
+      d->luma = vil_image_view<vxl_byte>();
+
+      return true;
+    }
+
+    return false;
+  }
+
+  if( d->stop_after_frame < d->frame_number )
+  {
+    return false;
+  }
+
+  bool result = d->convert_frame();
+
+  // Read klv metadata
+  if( d->klv_type != "none" )
+  {
+    std::deque<vxl_byte> curr_md = d->current_md;
+    klv_data klv_packet;
+    metadata_.is_valid( false );
+    while( klv_pop_next_packet( curr_md, klv_packet ) )
+    {
+      if( d->read_klv( klv_packet ) )
+      {
+        break;
+      }
+    }
+  }
+
+  // Metadata packets may not exist for each frame, so use the diff in
+  // presentation time stamps to foward the first metadata time stamp.
+  double pts_diff = ( d->frame_pts - d->pts_of_meta_ts ) * 1e6;
+  d->ts.set_time( d->meta_ts.time() + pts_diff );
+
+  if( has_roi_ )
+  {
+    d->img = vil_crop( d->img, roi_x_, roi_width_, roi_y_, roi_height_ );
+    if( d->luma )
+    {
+      d->luma = vil_crop( d->luma, roi_x_, roi_width_, roi_y_, roi_height_ );
+    }
+  }
+
+  if( d->simulate_stream )
+  {
+    if( !d->start_source_time.has_time() )
+    {
+      d->start_source_time = d->ts;
+      d->start_local_time = boost::posix_time::microsec_clock::local_time();
+    }
+    else
+    {
+      boost::posix_time::ptime current_time = boost::posix_time::microsec_clock::local_time();
+      boost::posix_time::time_duration diff = current_time - d->start_local_time;
+
+      double local_elapsed_ms = static_cast<double>( diff.total_milliseconds() );
+      double source_elapsed_ms = ( d->ts.time() - d->start_source_time.time() ) / 1000;
+
+      if( local_elapsed_ms < source_elapsed_ms )
+      {
+        local_elapsed_ms = ( source_elapsed_ms - local_elapsed_ms );
+        boost::this_thread::sleep( boost::posix_time::milliseconds( local_elapsed_ms ) );
+      }
+    }
+  }
+
+  // Hack for bad data with bad timestamps
+  while( result && d->ts.time() < 0 )
+  {
+    result = this->step();
+  }
+
+  return result;
+}
+
+
+// ----------------------------------------------------------------
+/* Seek to a frame.
+ *
+ * The demuxer is positioned at the closest indexed keyframe at or
+ * before the requested frame, or at the container's choice of
+ * keyframe when the index does not yet cover it, and frames are then
+ * decoded and dropped up to the requested frame.
+ */
+bool
+libav_frame_process
+::seek( unsigned frame_number )
+{
+  if( !d->format_ctx || d->frame_rate <= 0.0 )
+  {
+    return false;
+  }
+
+  AVStream* stream = d->format_ctx->streams[d->video_index];
+
+  int64_t pts = d->start_pts +
+    static_cast< int64_t >( frame_number / ( d->frame_rate * av_q2d( stream->time_base ) ) );
+  int64_t pos = -1;
+
+  priv::keyframe_index_t::const_iterator it = d->keyframe_index.upper_bound( frame_number );
+  if( it != d->keyframe_index.begin() )
+  {
+    --it;
+    pts = it->second.first;
+    pos = it->second.second;
+  }
+
+  if( !d->rewind( pts, pos ) )
+  {
+    LOG_ERROR( this->name() << ": unable to seek to frame " << frame_number );
+    return false;
+  }
+
+  while( d->read_frame() )
+  {
+    if( d->frame_number >= frame_number )
+    {
+      d->read_ahead = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+unsigned
+libav_frame_process
+::nframes() const
+{
+  return d->nframes;
+}
+
+
+double
+libav_frame_process
+::frame_rate() const
+{
+  return d->frame_rate;
+}
+
+
+timestamp
+libav_frame_process
+::timestamp() const
+{
+  vidtk::timestamp ts = d->ts;
+
+  if( d->blank_frame_mode )
+  {
+    d->last_frame++;
+  }
+  else
+  {
+    d->last_frame = d->frame_number;
+  }
+
+  ts.set_frame_number( d->last_frame );
+  return ts;
+}
+
+
+vil_image_view<vxl_byte>
+libav_frame_process
+::image() const
+{
+  return d->img;
+}
+
+
+vil_image_view<vxl_byte>
+libav_frame_process
+::luma_image() const
+{
+  return d->luma;
+}
+
+
+unsigned
+libav_frame_process
+::ni() const
+{
+  return d->ni;
+}
+
+
+unsigned
+libav_frame_process
+::nj() const
+{
+  return d->nj;
+}
+
+
+} // end namespace vidtk
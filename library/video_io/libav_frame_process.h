@@ -0,0 +1,73 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_libav_frame_process_h_
+#define vidtk_libav_frame_process_h_
+
+#include <video_io/frame_process.h>
+
+#include <boost/scoped_ptr.hpp>
+
+namespace vidtk
+{
+
+// ----------------------------------------------------------------
+/*! \brief Video source which drives libavformat/libavcodec directly.
+ *
+ * This is a replacement for vidl_ffmpeg_frame_process which avoids the
+ * vidl layer. Decoding uses the codec's frame and/or slice threading,
+ * and frames are converted with swscale directly into the memory of
+ * the output image, without an intermediate vidl frame. For planar
+ * YUV and greyscale sources, the native luma plane can be output
+ * without any conversion or copy.
+ *
+ * Keyframes are indexed as packets are read, optionally for the whole
+ * file during initialization, so that seeks go directly to the nearest
+ * preceding keyframe instead of reopening the file.
+ *
+ * KLV metadata and the klv/misp/pts time sources are handled the same
+ * way as in vidl_ffmpeg_frame_process.
+ */
+class libav_frame_process
+  : public frame_process<vxl_byte>
+{
+public:
+  libav_frame_process( std::string const& name );
+  virtual ~libav_frame_process();
+
+  virtual config_block params() const;
+  virtual bool set_params( config_block const& );
+  virtual bool initialize();
+  virtual bool step();
+
+  virtual bool seek( unsigned frame_number );
+  virtual unsigned nframes() const;
+  virtual double frame_rate() const;
+
+  virtual vidtk::timestamp timestamp() const;
+  virtual vil_image_view<vxl_byte> image() const;
+
+  /// \brief The native luma plane of the current frame.
+  ///
+  /// This is only available when the source is planar YUV or greyscale
+  /// with 8-bit samples, otherwise an empty image is returned. Full
+  /// range luma shares memory with the decoder output, limited range
+  /// luma is expanded to the full range.
+  virtual vil_image_view<vxl_byte> luma_image() const;
+
+  virtual unsigned ni() const;
+  virtual unsigned nj() const;
+
+private:
+  class priv;
+  boost::scoped_ptr<priv> d;
+};
+
+
+} // end namespace vidtk
+
+
+#endif // vidtk_libav_frame_process_h_
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -14,6 +14,12 @@ template void vidtk::detect_solid_borders( const vil_image_view< Type >& color_i
                                            const vil_image_view< Type >& gray_image, \
                                            const vidtk::border_detection_settings< Type >& settings, \
                                            image_border& output ); \
+template bool vidtk::track_solid_borders( const vil_image_view< Type >& color_image, \
+                                          const vil_image_view< Type >& gray_image, \
+                                          const vidtk::border_detection_settings< Type >& settings, \
+                                          const unsigned band_width, \
+                                          image_border& seed, \
+                                          image_border& output ); \
 template void vidtk::detect_bw_nonrect_borders( const vil_image_view< Type >& img, \
                                                 image_border_mask& output, \
                                                 const Type tolerance ); \
@@ -104,6 +104,22 @@ void detect_solid_borders( const vil_image_view< PixType >& color_image,
                            image_border& output );
 
 
+/// Tracking variant of the solid border detector, for borders which rarely
+/// change between frames. The seed holds the border detected by the prior call,
+/// before any edge refinement or dilation. If valid, only rows and columns within
+/// band_width pixels of each edge of the seed are scanned, and a full scan is only
+/// run if an edge cannot be verified within its band. An empty seed always forces
+/// a full scan. The seed is updated on output, and true is returned if the full
+/// scan was avoided.
+template< typename PixType >
+bool track_solid_borders( const vil_image_view< PixType >& color_image,
+                          const vil_image_view< PixType >& gray_image,
+                          const border_detection_settings< PixType >& settings,
+                          const unsigned band_width,
+                          image_border& seed,
+                          image_border& output );
+
+
 /// An alternative border detection function specialized for detecting a specific
 /// type of image border, one which can't be described by a rectangle and where all
 /// pure black or white pixels touching the image boundaries are considered border
@@ -92,18 +92,71 @@ inline double scan_line_single( const T* start,
   return static_cast<double>(count) / length;
 }
 
+// Scan lines inwards from one side of an image, starting at the given offset
+// from the side and stopping before the end offset, or once invalid_count
+// lines which are not near the given color are found. Returns the border
+// extent from the side of the image, which is the start offset if no valid
+// lines are found.
+//
+// Inputs: side_start - pointer to the first pixel of the outermost line
+//         line_step - pointer step between consecutive lines moving inwards
+//         pixel_step - pointer step between pixels within a line
+//         length - number of pixels in each line
+//
+template< typename PixType >
+inline unsigned scan_border_side( const PixType* side_start,
+                                  const std::ptrdiff_t line_step,
+                                  const std::ptrdiff_t pixel_step,
+                                  const int length,
+                                  const unsigned start_offset,
+                                  const unsigned end_offset,
+                                  const PixType color,
+                                  const PixType allowed_variance,
+                                  const double percent_threshold,
+                                  const unsigned invalid_count )
+{
+  unsigned extent = start_offset;
+  unsigned invalid_counter = 0;
+
+  for( unsigned k = start_offset; k < end_offset; k++ )
+  {
+    const PixType* line_start = side_start + static_cast< std::ptrdiff_t >( k ) * line_step;
+
+    if( scan_line_single( line_start, pixel_step, length, color, allowed_variance ) > percent_threshold )
+    {
+      extent = k+1;
+    }
+    else
+    {
+      invalid_counter++;
+
+      if( invalid_counter >= invalid_count )
+      {
+        break;
+      }
+    }
+  }
+
+  return extent;
+}
+
 // Detect some border of a certain color. Will exit quickly if the detected
 // border is not found. The color pointer must point to a valid color, with
 // the same number of planes as the input image. Threshold is the percentage
 // of pixels required to be near the color in order for a row/col to be
 // considered a border.
+//
+// If specified, search windows limit the scan on each side to the given
+// range of offsets from that side, in the order { left, right, top, bottom }.
+// Each window is clipped to the outer quarter of the image.
 template <typename PixType>
 void detect_colored_border( const vil_image_view< PixType >& src,
                             const PixType* color,
                             const PixType allowed_variance,
                             const double percent_threshold,
                             const unsigned invalid_count,
-                            image_border& output )
+                            image_border& output,
+                            const unsigned (*search_windows)[2] = NULL )
 {
   // Retrieve image properties
   const unsigned ni = src.ni();
@@ -120,6 +173,17 @@ void detect_colored_border( const vil_image_view< PixType >& src,
     return;
   }
 
+  // Maximum extent of each side, { left, right, top, bottom }
+  const unsigned limits[4] = { ni/4, ni - 3*ni/4, nj/4, nj - 3*nj/4 };
+
+  unsigned windows[4][2];
+
+  for( unsigned s = 0; s < 4; s++ )
+  {
+    windows[s][0] = ( search_windows ? std::min( search_windows[s][0], limits[s] ) : 0 );
+    windows[s][1] = ( search_windows ? std::min( search_windows[s][1], limits[s] ) : limits[s] );
+  }
+
   // Currently, the image is expected to be a 1 channel image, however it
   // will also function on multi-channeled ones by averaging the estimation
   // from each channel. Could be further improved but functions good enough
@@ -129,91 +193,28 @@ void detect_colored_border( const vil_image_view< PixType >& src,
 
   for( unsigned p = 0; p < np; p++ )
   {
-    unsigned borders[4] = { 0, ni, 0, nj };  // { left, right, top, bottom }
-
-    // Handle left
-    unsigned invalid_counter = 0;
-
-    for( unsigned i = 0; i < ni/4; i++ )
-    {
-      const PixType* col_start = &src(i,0,p);
-      if( scan_line_single( col_start, jstep, nj, color[p], allowed_variance ) > percent_threshold )
-      {
-        borders[0] = i+1;
-      }
-      else
-      {
-        invalid_counter++;
-
-        if( invalid_counter >= invalid_count )
-        {
-          break;
-        }
-      }
-    }
-    // Handle right
-    invalid_counter = 0;
-
-    for( unsigned i = ni-1; i >= 3*ni/4; i-- )
-    {
-      const PixType* col_start = &src(i,0,p);
-      if( scan_line_single( col_start, jstep, nj, color[p], allowed_variance ) > percent_threshold )
-      {
-        borders[1] = i;
-      }
-      else
-      {
-        invalid_counter++;
-
-        if( invalid_counter >= invalid_count )
-        {
-          break;
-        }
-      }
-    }
-    // Handle top
-    invalid_counter = 0;
-
-    for( unsigned j = 0; j < nj/4; j++ )
-    {
-      const PixType* row_start = &src(0,j,p);
-      if( scan_line_single( row_start, istep, ni, color[p], allowed_variance ) > percent_threshold )
-      {
-        borders[2] = j+1;
-      }
-      else
-      {
-        invalid_counter++;
+    const unsigned left = scan_border_side( &src(0,0,p), istep, jstep, nj,
+                                            windows[0][0], windows[0][1],
+                                            color[p], allowed_variance,
+                                            percent_threshold, invalid_count );
 
-        if( invalid_counter >= invalid_count )
-        {
-          break;
-        }
-      }
-    }
-    // Handle bottom
-    invalid_counter = 0;
+    const unsigned right = scan_border_side( &src(ni-1,0,p), -istep, jstep, nj,
+                                             windows[1][0], windows[1][1],
+                                             color[p], allowed_variance,
+                                             percent_threshold, invalid_count );
 
-    for( unsigned j = nj-1; j >= 3*nj/4; j-- )
-    {
-      const PixType* row_start = &src(0,j,p);
-      if( scan_line_single( row_start, istep, ni, color[p], allowed_variance ) > percent_threshold )
-      {
-        borders[3] = j;
-      }
-      else
-      {
-        invalid_counter++;
+    const unsigned top = scan_border_side( &src(0,0,p), jstep, istep, ni,
+                                           windows[2][0], windows[2][1],
+                                           color[p], allowed_variance,
+                                           percent_threshold, invalid_count );
 
-        if( invalid_counter >= invalid_count )
-        {
-          break;
-        }
-      }
-    }
+    const unsigned bottom = scan_border_side( &src(0,nj-1,p), -jstep, istep, ni,
+                                              windows[3][0], windows[3][1],
+                                              color[p], allowed_variance,
+                                              percent_threshold, invalid_count );
 
     // Formulate inner area estimate and intersect with other channels
-    image_border planar_border_est( borders[0], borders[1], borders[2], borders[3] );
+    image_border planar_border_est( left, ni - right, top, nj - bottom );
     net_border = vgl_intersection( planar_border_est, net_border );
   }
 
@@ -378,18 +379,13 @@ void edge_refinement( const vil_image_view< PixType >& image,
   }
 }
 
-// Core function to try and detect solid coloured image borders.
+// Estimate desired border colors to scan for.
 template< typename PixType >
-void detect_solid_borders( const vil_image_view< PixType >& color_image,
-                           const vil_image_view< PixType >& gray_image,
-                           const border_detection_settings< PixType >& settings,
-                           image_border& output )
+void estimate_border_colors( const vil_image_view< PixType >& color_image,
+                             const border_detection_settings< PixType >& settings,
+                             std::vector< std::vector< PixType > >& colors_to_use )
 {
-  // Store property for later
-  const bool is_hd = ( color_image.nj() > 480 );
-
-  // Estimate desired border colors to scan for
-  std::vector< std::vector< PixType > > colors_to_use;
+  colors_to_use.clear();
   colors_to_use.resize( 1, std::vector< PixType >( color_image.nplanes() ) );
 
   switch( settings.detection_method_ )
@@ -485,6 +481,18 @@ void detect_solid_borders( const vil_image_view< PixType >& color_image,
       }
     }
   }
+}
+
+// Detect borders of every given color, and take their intersection.
+template< typename PixType >
+void scan_colored_borders( const vil_image_view< PixType >& color_image,
+                           const std::vector< std::vector< PixType > >& colors_to_use,
+                           const border_detection_settings< PixType >& settings,
+                           image_border& output,
+                           const unsigned (*search_windows)[2] = NULL )
+{
+  // Store property for later
+  const bool is_hd = ( color_image.nj() > 480 );
 
   output = image_border( 0, color_image.ni(), 0, color_image.nj() );
 
@@ -498,11 +506,20 @@ void detect_solid_borders( const vil_image_view< PixType >& color_image,
                                    : settings.default_variance_ ),
                            settings.required_percentage_,
                            settings.invalid_count_,
-                           detected_border );
+                           detected_border,
+                           search_windows );
 
     output = vgl_intersection( output, detected_border );
   }
+}
 
+// Run the optional edge refinement and dilation steps on a border which was
+// detected by scanning for solid colors.
+template< typename PixType >
+void refine_and_dilate_border( const vil_image_view< PixType >& gray_image,
+                               const border_detection_settings< PixType >& settings,
+                               image_border& output )
+{
   // Run edge refinement on detected border
   if( settings.edge_refinement_ )
   {
@@ -522,6 +539,97 @@ void detect_solid_borders( const vil_image_view< PixType >& color_image,
   }
 }
 
+// Core function to try and detect solid coloured image borders.
+template< typename PixType >
+void detect_solid_borders( const vil_image_view< PixType >& color_image,
+                           const vil_image_view< PixType >& gray_image,
+                           const border_detection_settings< PixType >& settings,
+                           image_border& output )
+{
+  std::vector< std::vector< PixType > > colors_to_use;
+
+  estimate_border_colors( color_image, settings, colors_to_use );
+  scan_colored_borders( color_image, colors_to_use, settings, output );
+  refine_and_dilate_border( gray_image, settings, output );
+}
+
+template< typename PixType >
+bool track_solid_borders( const vil_image_view< PixType >& color_image,
+                          const vil_image_view< PixType >& gray_image,
+                          const border_detection_settings< PixType >& settings,
+                          const unsigned band_width,
+                          image_border& seed,
+                          image_border& output )
+{
+  const unsigned ni = color_image.ni();
+  const unsigned nj = color_image.nj();
+
+  std::vector< std::vector< PixType > > colors_to_use;
+  estimate_border_colors( color_image, settings, colors_to_use );
+
+  bool tracked = false;
+
+  if( ni >= 3 && nj >= 3 && !seed.is_empty() &&
+      seed.min_x() >= 0 && seed.max_x() <= static_cast<int>( ni ) &&
+      seed.min_y() >= 0 && seed.max_y() <= static_cast<int>( nj ) )
+  {
+    // Border extents from each side, { left, right, top, bottom }
+    const unsigned extents[4] = { static_cast<unsigned>( seed.min_x() ),
+                                  ni - static_cast<unsigned>( seed.max_x() ),
+                                  static_cast<unsigned>( seed.min_y() ),
+                                  nj - static_cast<unsigned>( seed.max_y() ) };
+
+    const unsigned limits[4] = { ni/4, ni - 3*ni/4, nj/4, nj - 3*nj/4 };
+
+    unsigned windows[4][2];
+
+    for( unsigned s = 0; s < 4; s++ )
+    {
+      windows[s][0] = std::min( extents[s] > band_width ? extents[s] - band_width : 0, limits[s] );
+      windows[s][1] = std::min( extents[s] + band_width, limits[s] );
+    }
+
+    image_border candidate;
+    scan_colored_borders( color_image, colors_to_use, settings, candidate, windows );
+
+    const unsigned found[4] = { static_cast<unsigned>( candidate.min_x() ),
+                                ni - static_cast<unsigned>( candidate.max_x() ),
+                                static_cast<unsigned>( candidate.min_y() ),
+                                nj - static_cast<unsigned>( candidate.max_y() ) };
+
+    // The border is verified if every edge was found strictly within its
+    // band. An edge found at the inner end of a band may continue further
+    // into the image, while no valid lines at all in a band which does not
+    // touch the side of the image means the border has shrunk past it.
+    tracked = !candidate.is_empty();
+
+    for( unsigned s = 0; s < 4 && tracked; s++ )
+    {
+      if( ( found[s] >= windows[s][1] && windows[s][1] < limits[s] ) ||
+          ( found[s] <= windows[s][0] && windows[s][0] > 0 ) )
+      {
+        tracked = false;
+      }
+    }
+
+    if( tracked )
+    {
+      output = candidate;
+    }
+  }
+
+  if( !tracked )
+  {
+    scan_colored_borders( color_image, colors_to_use, settings, output );
+  }
+
+  seed = output;
+
+  refine_and_dilate_border( gray_image, settings, output );
+
+  return tracked;
+}
+
 template< typename PixType >
 void detect_solid_borders( const vil_image_view< PixType >& input_image,
                            const border_detection_settings< PixType >& settings,
@@ -58,6 +58,12 @@ public:
   image_border border() const;
   VIDTK_OUTPUT_PORT( image_border, border );
 
+  /// Number of frames where border tracking verified the prior border.
+  unsigned tracked_frame_count() const;
+
+  /// Number of frames where a full border scan was required.
+  unsigned full_scan_count() const;
+
 private:
 
   // Numerical definitions of operating mode of filter - detect_solid_rect
@@ -85,6 +91,8 @@ private:
   unsigned history_length_;
   bool fix_border_;
   unsigned initial_hold_count_;
+  bool enable_tracking_;
+  unsigned tracking_band_;
 
   // Internal buffers allocated as necessary
   ring_buffer< image_border > history_;
@@ -92,6 +100,11 @@ private:
   bool frame_hold_;
   unsigned hold_count_;
 
+  // Border tracking state and statistics
+  image_border tracking_seed_;
+  unsigned tracked_count_;
+  unsigned full_scan_count_;
+
   // Internal helper functions
   void historic_smooth( image_border& border );
   void set_square_mask( const image_border& borders );
@@ -36,8 +36,12 @@ border_detection_process<PixType>
     disabled_( false ),
     use_history_( true ),
     history_length_( 5 ),
+    enable_tracking_( false ),
+    tracking_band_( 8 ),
     frame_hold_( true ),
-    hold_count_( 0 )
+    hold_count_( 0 ),
+    tracked_count_( 0 ),
+    full_scan_count_( 0 )
 {
   config_.add_parameter( "disabled",
                          "false",
@@ -117,6 +121,16 @@ border_detection_process<PixType>
                          "0",
                          "Number of frames to delay at the beginning of a video for using "
                          "the history to come up with a better border approximation." );
+  config_.add_parameter( "enable_tracking",
+                         "false",
+                         "Whether or not to track solid borders between frames. When "
+                         "enabled, only a narrow band around each edge of the previously "
+                         "detected border is verified, and the full scan is only run when "
+                         "verification fails or the reset flag is set." );
+  config_.add_parameter( "tracking_band",
+                         "8",
+                         "Width in pixels of the band scanned on either side of each "
+                         "previously detected border edge when tracking is enabled." );
 }
 
 
@@ -124,6 +138,11 @@ template <typename PixType>
 border_detection_process<PixType>
 ::~border_detection_process()
 {
+  if( enable_tracking_ && tracked_count_ + full_scan_count_ > 0 )
+  {
+    LOG_INFO( this->name() << ": Border tracking verified " << tracked_count_
+              << " of " << tracked_count_ + full_scan_count_ << " frames" );
+  }
 }
 
 
@@ -193,6 +212,8 @@ border_detection_process<PixType>
     history_length_ = blk.get<unsigned>( "history_length" );
     fix_border_ = blk.get<bool>( "fix_border" );
     initial_hold_count_ = blk.get<unsigned>( "initial_hold_count" );
+    enable_tracking_ = blk.get<bool>( "enable_tracking" );
+    tracking_band_ = blk.get<unsigned>( "tracking_band" );
 
     algorithm_settings_.side_dilation_ = blk.get<unsigned>( "side_dilation" );
     algorithm_settings_.default_variance_ = blk.get<PixType>( "default_variance" );
@@ -218,6 +239,12 @@ border_detection_process<PixType>
     return false;
   }
 
+  if( enable_tracking_ && tracking_band_ == 0 )
+  {
+    LOG_ERROR( this->name() << ": set params failed: tracking band must be positive" );
+    return false;
+  }
+
   // Configure historic buffer if required
   if( use_history_ )
   {
@@ -225,6 +252,11 @@ border_detection_process<PixType>
     history_.clear();
   }
 
+  // Reset any tracking state
+  tracking_seed_ = image_border();
+  tracked_count_ = 0;
+  full_scan_count_ = 0;
+
   // Set internal config block
   config_.update( blk );
 
@@ -281,6 +313,13 @@ border_detection_process<PixType>
     history_.clear();
   }
 
+  if( reset_flag_ ||
+      tracking_seed_.max_x() > static_cast<int>( color_image_.ni() ) ||
+      tracking_seed_.max_y() > static_cast<int>( color_image_.nj() ) )
+  {
+    tracking_seed_ = image_border();
+  }
+
   // Check fixed flag
   if( fix_border_ &&
       detected_border_.volume() > 0 &&
@@ -297,7 +336,23 @@ border_detection_process<PixType>
   {
     // Detect border
     image_border detected_border;
-    detect_solid_borders( color_image_, gray_image_, algorithm_settings_, detected_border );
+
+    if( enable_tracking_ )
+    {
+      if( track_solid_borders( color_image_, gray_image_, algorithm_settings_,
+                               tracking_band_, tracking_seed_, detected_border ) )
+      {
+        tracked_count_++;
+      }
+      else
+      {
+        full_scan_count_++;
+      }
+    }
+    else
+    {
+      detect_solid_borders( color_image_, gray_image_, algorithm_settings_, detected_border );
+    }
 
     // Utilize history if specified
     if( use_history_ )
@@ -481,4 +536,20 @@ border_detection_process<PixType>
   return detected_border_;
 }
 
+template <typename PixType>
+unsigned
+border_detection_process<PixType>
+::tracked_frame_count() const
+{
+  return tracked_count_;
+}
+
+template <typename PixType>
+unsigned
+border_detection_process<PixType>
+::full_scan_count() const
+{
+  return full_scan_count_;
+}
+
 } // end namespace vidtk
@@ -0,0 +1,10 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <video_transforms/color_lut.txx>
+
+template class vidtk::color_lut< vxl_byte >;
+template class vidtk::color_lut< vxl_uint_16 >;
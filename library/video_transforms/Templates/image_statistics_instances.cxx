@@ -0,0 +1,20 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <video_transforms/image_statistics.txx>
+
+#define INSTANTIATE( TYPE ) \
+template class vidtk::image_order_statistics< TYPE >; \
+template double vidtk::image_plane_median( vil_image_view< TYPE > const& src, \
+                                           unsigned plane, \
+                                           unsigned max_threads );
+
+INSTANTIATE( vxl_byte );
+INSTANTIATE( vxl_uint_16 );
+INSTANTIATE( float );
+INSTANTIATE( double );
+
+#undef INSTANTIATE
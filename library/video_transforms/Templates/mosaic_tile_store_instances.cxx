@@ -0,0 +1,11 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <video_transforms/mosaic_tile_store.txx>
+
+template class vidtk::mosaic_tile_store< vxl_byte >;
+template class vidtk::mosaic_tile_store< vxl_uint_16 >;
+template class vidtk::mosaic_tile_store< double >;
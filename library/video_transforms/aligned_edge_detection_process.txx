@@ -93,11 +93,11 @@ aligned_edge_detection_process<PixType>
 
     if( max_thread_count < 3 )
     {
-      threads_.reset( new thread_sys_t( 1, 1 ) );
+      threads_.reset( new thread_sys_t( 1, 1, this->name() ) );
     }
     else
     {
-      threads_.reset( new thread_sys_t( 1, 3 ) );
+      threads_.reset( new thread_sys_t( 1, 3, this->name() ) );
     }
 
     threads_->set_function(
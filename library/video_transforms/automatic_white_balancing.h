@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -97,6 +97,18 @@ public:
     }
   }
 
+  bool operator==( const awb_reference_point& other ) const
+  {
+    for( unsigned int i = 0; i < Channels; i++ )
+    {
+      if( loc_[i] != other.loc_[i] || vec_[i] != other.vec_[i] )
+      {
+        return false;
+      }
+    }
+    return weight_ == other.weight_;
+  }
+
   PixType loc_[Channels];
   double vec_[Channels];
   double weight_;
@@ -104,7 +116,8 @@ public:
 
 
 // Given multiple reference points, compute a correction matrix by interpolating
-// an estimated shift for each bin in the color space
+// an estimated shift for each bin in the color space. Bins are computed in
+// parallel on the shared compute pool.
 template <typename PixType>
 void compute_correction_matrix( std::vector< awb_reference_point< PixType > >& ref,
                                 const unsigned& resolution_per_chan,
@@ -118,6 +131,10 @@ void compute_correction_matrix( std::vector< awb_reference_point< PixType > >& r
 // what colors they should ideally map to, and then by interpolating an approx
 // shift (a 3D vector) for each bin in this correction matrix sampling the color
 // space.
+//
+// The estimation (update) and application of a correction matrix can also be
+// performed separately, so that the correction can be compiled into a
+// color_lut along with other per-pixel color operations.
 template <typename PixType>
 class auto_white_balancer
 {
@@ -144,6 +161,21 @@ public:
   // it to the first input image
   void apply( input_type& image, const input_type& reference );
 
+  // Creates a correction matrix from the image without applying it, returning
+  // false if no correction could be estimated. If inverted is set, the matrix
+  // is estimated for the inverted image instead (see invert_image).
+  bool update( const input_type& image, bool inverted = false );
+
+  // Creates a correction matrix from some reference image without applying it
+  bool update_from_reference( const input_type& reference );
+
+  // Adjust a single color using the current correction matrix, interpolating
+  // the shifts of the surrounding bins
+  void correct_color( double* color ) const;
+
+  // Counter which is incremented each time the current correction matrix changes
+  unsigned revision() const;
+
 private:
 
   // Stored variables
@@ -152,8 +184,21 @@ private:
   matrix_type temp_matrix_;
   input_type downsized_image_;
   input_type smoothed_image_;
+  input_type inverted_image_;
   bool is_first_matrix_;
 
+  // Reference points used for the last computed matrix, which is only
+  // recomputed when they change
+  std::vector< awb_reference_point< PixType > > last_references_;
+  unsigned revision_;
+
+  // The white point used for the current settings
+  PixType white_point() const;
+
+  // The matrix which is currently applied to images
+  matrix_type& current_matrix();
+  const matrix_type& current_matrix() const;
+
   // Apply a correction matrix to some image using the internal settings
   void apply_correction_matrix( input_type& image, matrix_type& matrix );
 
@@ -1,14 +1,22 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include "automatic_white_balancing.h"
 
+#include <video_transforms/invert_image_values.h>
+
+#include <utilities/compute_pool.h>
+
 #include <vil/vil_resample_bilin.h>
 #include <vil/algo/vil_gauss_reduce.h>
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
 #include <limits>
 #include <cmath>
 #include <cstdlib>
@@ -30,27 +38,25 @@ inline double awb_point_to_ref_dist( double *pt, const awb_reference_point< PixT
   return std::sqrt( dist );
 }
 
-// Given multiple reference points, compute a correction matrix by interpolating
-// an estimated shift for each bin in the color space
+// Compute the bins of a correction matrix with a first channel index in [i0,i1)
 template <typename PixType>
-void compute_correction_matrix( std::vector< awb_reference_point< PixType > >& ref,
-                                const unsigned& resolution_per_chan,
+void compute_correction_slices( const std::vector< awb_reference_point< PixType > >& ref,
+                                const unsigned resolution_per_chan,
                                 std::vector< double >& output,
-                                const double& white_point )
+                                const double white_point,
+                                unsigned i0, unsigned i1 )
 {
   const int c3step = 3;
   const int c2step = c3step * resolution_per_chan;
   const int c1step = c2step * resolution_per_chan;
 
-  assert( output.size() == c1step * resolution_per_chan );
-
   double max_dist = std::sqrt( 3 * white_point * white_point );
   double min_contrib = 0.05 * white_point;
 
   const double bin_spacing = white_point / resolution_per_chan;
   const double bin_half_width = bin_spacing / 2.0;
 
-  for( unsigned i = 0; i < resolution_per_chan; i++ )
+  for( unsigned i = i0; i < i1; i++ )
   {
     for( unsigned j = 0; j < resolution_per_chan; j++ )
     {
@@ -100,10 +106,29 @@ void compute_correction_matrix( std::vector< awb_reference_point< PixType > >& r
   }
 }
 
+// Given multiple reference points, compute a correction matrix by interpolating
+// an estimated shift for each bin in the color space
+template <typename PixType>
+void compute_correction_matrix( std::vector< awb_reference_point< PixType > >& ref,
+                                const unsigned& resolution_per_chan,
+                                std::vector< double >& output,
+                                const double& white_point )
+{
+  assert( output.size() == 3 * resolution_per_chan * resolution_per_chan * resolution_per_chan );
+
+  // Each slice of the first channel is independent
+  compute_pool::instance()->parallel_for(
+    0, resolution_per_chan,
+    boost::bind( &compute_correction_slices< PixType >, boost::cref( ref ),
+                 resolution_per_chan, boost::ref( output ), white_point, _1, _2 ),
+    "auto_white_balancer" );
+}
+
 // Definition of video awb averaging class
 template <typename PixType>
 auto_white_balancer<PixType>
 ::auto_white_balancer()
+  : revision_( 0 )
 {
   this->configure( options_ );
 }
@@ -119,6 +144,7 @@ void auto_white_balancer<PixType>
 ::reset()
 {
   is_first_matrix_ = true;
+  last_references_.clear();
 }
 
 template <typename PixType>
@@ -143,9 +169,38 @@ void auto_white_balancer<PixType>
 template <typename PixType>
 void auto_white_balancer<PixType>
 ::apply( input_type& image )
+{
+  if( this->update( image ) )
+  {
+    this->apply_correction_matrix( image, this->current_matrix() );
+  }
+}
+
+template <typename PixType>
+void auto_white_balancer<PixType>
+::apply( input_type& image, const input_type& reference )
+{
+  // Validate images, restrict to 3 channel ones for now
+  if( !image || image.nplanes() != 3 )
+  {
+    this->reset();
+    return;
+  }
+
+  if( this->update_from_reference( reference ) )
+  {
+    this->apply_correction_matrix( image, this->current_matrix() );
+  }
+}
+
+template <typename PixType>
+bool auto_white_balancer<PixType>
+::update( const input_type& image, bool inverted )
 {
   // Validate input
-  if( !image || image.nplanes() != 3 ) return;
+  if( !image || image.nplanes() != 3 ) return false;
+
+  const input_type* reference = &image;
 
   // Create a downsized, smoothed image to estimate correction mat from
   double pixel_area = static_cast<double>( image.ni() * image.nj() );
@@ -157,45 +212,36 @@ void auto_white_balancer<PixType>
     unsigned new_ni = static_cast<unsigned>(resize_factor * image.ni() + 0.5);
     unsigned new_nj = static_cast<unsigned>(resize_factor * image.nj() + 0.5);
 
-    if( new_ni < 5 || new_nj < 5 ) return;
+    if( new_ni < 5 || new_nj < 5 ) return false;
 
     vil_resample_bilin( image, downsized_image_, new_ni, new_nj );
     vil_gauss_reduce_121( downsized_image_, smoothed_image_ );
-    this->apply( image, smoothed_image_ );
+    reference = &smoothed_image_;
   }
-  else
+
+  // Only the small reference image needs to be inverted
+  if( inverted )
   {
-    this->apply( image, image );
+    inverted_image_.deep_copy( *reference );
+    invert_image( inverted_image_ );
+    reference = &inverted_image_;
   }
+
+  return this->update_from_reference( *reference );
 }
 
 template <typename PixType>
-void auto_white_balancer<PixType>
-::apply( input_type& image, const input_type& reference )
+bool auto_white_balancer<PixType>
+::update_from_reference( const input_type& reference )
 {
-  // Validate images, restrict to 3 channel ones for now
-  if( !image || image.nplanes() != 3 )
-  {
-    this->reset();
-    return;
-  }
   if( !reference || reference.nplanes() != 3 )
   {
     this->reset();
-    return;
+    return false;
   }
 
   // Identify potential reference points
-  PixType white_point;
-
-  if( options_.white_point_value_ != 0 )
-  {
-    white_point = static_cast<PixType>(options_.white_point_value_);
-  }
-  else
-  {
-    white_point = default_white_point<PixType>::value();
-  }
+  PixType white_point = this->white_point();
 
   PixType black[3] = { 0, 0, 0 };
   PixType white[3] = { white_point, white_point, white_point };
@@ -222,20 +268,24 @@ void auto_white_balancer<PixType>
   ref_list.push_back( black_ref );
   ref_list.push_back( white_ref );
 
-  // Create correction matrix
-  compute_correction_matrix( ref_list, options_.correction_matrix_res, temp_matrix_, white_point );
+  // Create correction matrix, unless the reference points are unchanged
+  bool matrix_changed = false;
 
-  // Average correction matrix and apply it if required
-  if( options_.exp_averaging_factor == 1.0 )
+  if( !( ref_list == last_references_ ) )
   {
-    this->apply_correction_matrix( image, temp_matrix_ );
+    compute_correction_matrix( ref_list, options_.correction_matrix_res, temp_matrix_, white_point );
+    last_references_ = ref_list;
+    matrix_changed = true;
   }
-  else
+
+  // Average correction matrix if required
+  if( options_.exp_averaging_factor != 1.0 )
   {
     if( is_first_matrix_ )
     {
       correction_matrix_ = temp_matrix_;
       is_first_matrix_ = false;
+      matrix_changed = true;
     }
     else
     {
@@ -244,11 +294,119 @@ void auto_white_balancer<PixType>
 
       for( unsigned i = 0; i < correction_matrix_.size(); i++ )
       {
-        correction_matrix_[i] = exp * temp_matrix_[i] + invexp * correction_matrix_[i];
+        const double averaged = exp * temp_matrix_[i] + invexp * correction_matrix_[i];
+
+        if( averaged != correction_matrix_[i] )
+        {
+          correction_matrix_[i] = averaged;
+          matrix_changed = true;
+        }
       }
     }
-    this->apply_correction_matrix( image, correction_matrix_ );
   }
+
+  if( matrix_changed )
+  {
+    ++revision_;
+  }
+
+  return true;
+}
+
+template <typename PixType>
+void auto_white_balancer<PixType>
+::correct_color( double* color ) const
+{
+  const matrix_type& matrix = this->current_matrix();
+  const unsigned res = options_.correction_matrix_res;
+
+  if( matrix.empty() || res == 0 )
+  {
+    return;
+  }
+
+  const double max_value = static_cast<double>( default_white_point<PixType>::value() );
+  const double bin_spacing = static_cast<double>( this->white_point() ) / res;
+
+  const unsigned c3step = 3;
+  const unsigned c2step = c3step * res;
+  const unsigned c1step = c2step * res;
+
+  // Position of the color relative to the bin centers
+  unsigned lower[3];
+  unsigned upper[3];
+  double frac[3];
+
+  for( unsigned c = 0; c < 3; c++ )
+  {
+    double pos = color[c] / bin_spacing - 0.5;
+    pos = std::min( std::max( pos, 0.0 ), static_cast<double>( res - 1 ) );
+
+    lower[c] = static_cast<unsigned>( pos );
+    upper[c] = std::min( lower[c] + 1, res - 1 );
+    frac[c] = pos - lower[c];
+  }
+
+  double shift[3] = { 0.0, 0.0, 0.0 };
+
+  for( unsigned corner = 0; corner < 8; corner++ )
+  {
+    const bool ui = ( corner & 4 ) != 0;
+    const bool uj = ( corner & 2 ) != 0;
+    const bool uk = ( corner & 1 ) != 0;
+
+    const double weight = ( ui ? frac[0] : 1.0 - frac[0] ) *
+                          ( uj ? frac[1] : 1.0 - frac[1] ) *
+                          ( uk ? frac[2] : 1.0 - frac[2] );
+
+    const double* adj_vector = &matrix[0] +
+                               c1step * ( ui ? upper[0] : lower[0] ) +
+                               c2step * ( uj ? upper[1] : lower[1] ) +
+                               c3step * ( uk ? upper[2] : lower[2] );
+
+    shift[0] += weight * adj_vector[0];
+    shift[1] += weight * adj_vector[1];
+    shift[2] += weight * adj_vector[2];
+  }
+
+  for( unsigned c = 0; c < 3; c++ )
+  {
+    color[c] = std::min( std::max( color[c] + shift[c], 0.0 ), max_value );
+  }
+}
+
+template <typename PixType>
+unsigned auto_white_balancer<PixType>
+::revision() const
+{
+  return revision_;
+}
+
+template <typename PixType>
+PixType auto_white_balancer<PixType>
+::white_point() const
+{
+  if( options_.white_point_value_ != 0 )
+  {
+    return static_cast<PixType>(options_.white_point_value_);
+  }
+  return default_white_point<PixType>::value();
+}
+
+template <typename PixType>
+typename auto_white_balancer<PixType>::matrix_type&
+auto_white_balancer<PixType>
+::current_matrix()
+{
+  return ( options_.exp_averaging_factor == 1.0 ? temp_matrix_ : correction_matrix_ );
+}
+
+template <typename PixType>
+const typename auto_white_balancer<PixType>::matrix_type&
+auto_white_balancer<PixType>
+::current_matrix() const
+{
+  return ( options_.exp_averaging_factor == 1.0 ? temp_matrix_ : correction_matrix_ );
 }
 
 // Cast and threshold double variables to some pixel type range
@@ -0,0 +1,99 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_color_lut_h_
+#define vidtk_color_lut_h_
+
+#include <vil/vil_image_view.h>
+
+#include <boost/function.hpp>
+
+#include <vector>
+
+namespace vidtk
+{
+
+
+/// \brief A 3D lookup table mapping 3-channel colors to new colors.
+///
+/// Any chain of per-pixel color operations can be compiled into the
+/// table by evaluating it once at each node of a regular grid spanning
+/// [0,max_value] in every channel. The table is then applied to an image
+/// in a single pass using trilinear interpolation between the nodes,
+/// with the rows of the image split across the shared compute pool.
+///
+/// For integer pixel types, the node index and interpolation weight of
+/// every possible channel value are precomputed, so that the inner loop
+/// only contains table lookups and multiply-adds.
+template <typename PixType>
+class color_lut
+{
+public:
+
+  /// A color operation, which modifies a 3-channel color in place.
+  typedef boost::function< void ( double* color ) > color_function_t;
+
+  color_lut();
+  ~color_lut();
+
+  /// \brief Set the number of nodes per channel and the maximum pixel value.
+  ///
+  /// This resets the table to the identity mapping.
+  void configure( unsigned resolution, double max_value );
+
+  /// Number of nodes per channel.
+  unsigned resolution() const;
+
+  /// Set every node to map to itself.
+  void set_identity();
+
+  /// \brief Evaluate a color operation at every node of the table.
+  ///
+  /// The operation may be called from multiple threads at once, and
+  /// the colors it produces are clamped to [0,max_value].
+  void compile( color_function_t const& func );
+
+  /// \brief Apply the table to a 3-channel image.
+  ///
+  /// The interpolated color is multiplied by \a gain, clamped to the
+  /// range of the pixel type and rounded for integer types. The output
+  /// is reallocated if its size does not match the input, and may be
+  /// the same image as the input.
+  void apply( vil_image_view< PixType > const& src,
+              vil_image_view< PixType >& dst,
+              double gain = 1.0 ) const;
+
+  /// Interpolate the table at a single color.
+  void map( double const* color, double* output ) const;
+
+private:
+
+  void apply_rows( vil_image_view< PixType > const& src,
+                   vil_image_view< PixType >& dst,
+                   double gain,
+                   unsigned j0, unsigned j1 ) const;
+
+  void compile_slices( color_function_t const& func,
+                       unsigned r0, unsigned r1 );
+
+  void axis_position( double value, unsigned& index, float& weight ) const;
+
+  unsigned resolution_;
+  double max_value_;
+  double node_scale_;
+
+  // Node colors, stored as [r][g][b][channel]
+  std::vector< float > table_;
+
+  // Precomputed node index and weight for every integer channel value
+  std::vector< unsigned > value_index_;
+  std::vector< float > value_weight_;
+};
+
+
+} // end namespace vidtk
+
+#endif // vidtk_color_lut_h_
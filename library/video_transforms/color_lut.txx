@@ -0,0 +1,353 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "color_lut.h"
+
+#include <utilities/compute_pool.h>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace vidtk
+{
+
+
+namespace
+{
+
+// Largest integer range for which per-value axis tables are built
+const double max_tabulated_value = 65535.0;
+
+// Convert an output value to the pixel type, clamping and rounding as needed
+template <typename PixType>
+inline PixType lut_output_value( double value, double max_value )
+{
+  if( value <= 0.0 )
+  {
+    return PixType( 0 );
+  }
+  if( value >= max_value )
+  {
+    return static_cast< PixType >( max_value );
+  }
+  if( std::numeric_limits< PixType >::is_integer )
+  {
+    return static_cast< PixType >( value + 0.5 );
+  }
+  return static_cast< PixType >( value );
+}
+
+} // end anonymous namespace
+
+
+template <typename PixType>
+color_lut< PixType >
+::color_lut()
+  : resolution_( 0 ),
+    max_value_( 0.0 ),
+    node_scale_( 0.0 )
+{
+}
+
+
+template <typename PixType>
+color_lut< PixType >
+::~color_lut()
+{
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::configure( unsigned resolution, double max_value )
+{
+  resolution_ = std::max( resolution, 2u );
+  max_value_ = max_value;
+  node_scale_ = ( max_value > 0.0 ? ( resolution_ - 1 ) / max_value : 0.0 );
+
+  table_.resize( 3 * resolution_ * resolution_ * resolution_ );
+
+  value_index_.clear();
+  value_weight_.clear();
+
+  if( std::numeric_limits< PixType >::is_integer && max_value_ <= max_tabulated_value )
+  {
+    const unsigned values = static_cast< unsigned >( max_value_ ) + 1;
+
+    value_index_.resize( values );
+    value_weight_.resize( values );
+
+    for( unsigned v = 0; v < values; ++v )
+    {
+      this->axis_position( v, value_index_[v], value_weight_[v] );
+    }
+  }
+
+  this->set_identity();
+}
+
+
+template <typename PixType>
+unsigned
+color_lut< PixType >
+::resolution() const
+{
+  return resolution_;
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::axis_position( double value, unsigned& index, float& weight ) const
+{
+  double pos = value * node_scale_;
+
+  if( pos <= 0.0 )
+  {
+    index = 0;
+    weight = 0.0f;
+    return;
+  }
+
+  const double last = static_cast< double >( resolution_ - 2 );
+  const double base = std::min( std::floor( pos ), last );
+
+  index = static_cast< unsigned >( base );
+  weight = static_cast< float >( std::min( pos - base, 1.0 ) );
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::set_identity()
+{
+  const double spacing = ( resolution_ > 1 ? max_value_ / ( resolution_ - 1 ) : 0.0 );
+
+  float* node = table_.empty() ? NULL : &table_[0];
+
+  for( unsigned r = 0; r < resolution_; ++r )
+  {
+    for( unsigned g = 0; g < resolution_; ++g )
+    {
+      for( unsigned b = 0; b < resolution_; ++b, node += 3 )
+      {
+        node[0] = static_cast< float >( r * spacing );
+        node[1] = static_cast< float >( g * spacing );
+        node[2] = static_cast< float >( b * spacing );
+      }
+    }
+  }
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::compile_slices( color_function_t const& func, unsigned r0, unsigned r1 )
+{
+  const double spacing = max_value_ / ( resolution_ - 1 );
+  const unsigned slice_size = 3 * resolution_ * resolution_;
+
+  float* node = &table_[0] + r0 * slice_size;
+
+  for( unsigned r = r0; r < r1; ++r )
+  {
+    for( unsigned g = 0; g < resolution_; ++g )
+    {
+      for( unsigned b = 0; b < resolution_; ++b, node += 3 )
+      {
+        double color[3] = { r * spacing, g * spacing, b * spacing };
+
+        func( color );
+
+        for( unsigned c = 0; c < 3; ++c )
+        {
+          node[c] = static_cast< float >( std::min( std::max( color[c], 0.0 ), max_value_ ) );
+        }
+      }
+    }
+  }
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::compile( color_function_t const& func )
+{
+  if( table_.empty() )
+  {
+    return;
+  }
+
+  compute_pool::instance()->parallel_for(
+    0, resolution_,
+    boost::bind( &color_lut< PixType >::compile_slices, this, boost::cref( func ), _1, _2 ),
+    "color_lut" );
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::map( double const* color, double* output ) const
+{
+  unsigned idx[3];
+  float w[3];
+
+  for( unsigned c = 0; c < 3; ++c )
+  {
+    this->axis_position( color[c], idx[c], w[c] );
+  }
+
+  const std::ptrdiff_t bstep = 3;
+  const std::ptrdiff_t gstep = bstep * resolution_;
+  const std::ptrdiff_t rstep = gstep * resolution_;
+
+  const float* n000 = &table_[0] + idx[0] * rstep + idx[1] * gstep + idx[2] * bstep;
+
+  for( unsigned c = 0; c < 3; ++c )
+  {
+    const float* n = n000 + c;
+
+    const double c00 = n[0] + w[2] * ( n[bstep] - n[0] );
+    const double c01 = n[gstep] + w[2] * ( n[gstep+bstep] - n[gstep] );
+    const double c10 = n[rstep] + w[2] * ( n[rstep+bstep] - n[rstep] );
+    const double c11 = n[rstep+gstep] + w[2] * ( n[rstep+gstep+bstep] - n[rstep+gstep] );
+
+    const double c0 = c00 + w[1] * ( c01 - c00 );
+    const double c1 = c10 + w[1] * ( c11 - c10 );
+
+    output[c] = c0 + w[0] * ( c1 - c0 );
+  }
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::apply_rows( vil_image_view< PixType > const& src,
+              vil_image_view< PixType >& dst,
+              double gain,
+              unsigned j0, unsigned j1 ) const
+{
+  const unsigned ni = src.ni();
+
+  const std::ptrdiff_t s_istep = src.istep();
+  const std::ptrdiff_t s_jstep = src.jstep();
+  const std::ptrdiff_t s_pstep = src.planestep();
+
+  const std::ptrdiff_t d_istep = dst.istep();
+  const std::ptrdiff_t d_jstep = dst.jstep();
+  const std::ptrdiff_t d_pstep = dst.planestep();
+
+  const std::ptrdiff_t bstep = 3;
+  const std::ptrdiff_t gstep = bstep * resolution_;
+  const std::ptrdiff_t rstep = gstep * resolution_;
+
+  const bool tabulated = !value_index_.empty();
+  const float* table = &table_[0];
+
+  const PixType* s_row = src.top_left_ptr() + j0 * s_jstep;
+  PixType* d_row = dst.top_left_ptr() + j0 * d_jstep;
+
+  for( unsigned j = j0; j < j1; ++j, s_row += s_jstep, d_row += d_jstep )
+  {
+    const PixType* s_pixel = s_row;
+    PixType* d_pixel = d_row;
+
+    for( unsigned i = 0; i < ni; ++i, s_pixel += s_istep, d_pixel += d_istep )
+    {
+      unsigned idx[3];
+      float w[3];
+
+      if( tabulated )
+      {
+        for( unsigned c = 0; c < 3; ++c )
+        {
+          const unsigned v = static_cast< unsigned >( s_pixel[c * s_pstep] );
+          idx[c] = value_index_[v];
+          w[c] = value_weight_[v];
+        }
+      }
+      else
+      {
+        for( unsigned c = 0; c < 3; ++c )
+        {
+          this->axis_position( static_cast< double >( s_pixel[c * s_pstep] ), idx[c], w[c] );
+        }
+      }
+
+      const float* n000 = table + idx[0] * rstep + idx[1] * gstep + idx[2] * bstep;
+
+      // Weights of the 8 surrounding nodes, shared by all channels
+      const float wr1 = w[0], wr0 = 1.0f - w[0];
+      const float wg1 = w[1], wg0 = 1.0f - w[1];
+      const float wb1 = w[2], wb0 = 1.0f - w[2];
+
+      const float w000 = wr0 * wg0 * wb0;
+      const float w001 = wr0 * wg0 * wb1;
+      const float w010 = wr0 * wg1 * wb0;
+      const float w011 = wr0 * wg1 * wb1;
+      const float w100 = wr1 * wg0 * wb0;
+      const float w101 = wr1 * wg0 * wb1;
+      const float w110 = wr1 * wg1 * wb0;
+      const float w111 = wr1 * wg1 * wb1;
+
+      for( unsigned c = 0; c < 3; ++c )
+      {
+        const float* n = n000 + c;
+
+        const float value = w000 * n[0] +
+                            w001 * n[bstep] +
+                            w010 * n[gstep] +
+                            w011 * n[gstep+bstep] +
+                            w100 * n[rstep] +
+                            w101 * n[rstep+bstep] +
+                            w110 * n[rstep+gstep] +
+                            w111 * n[rstep+gstep+bstep];
+
+        d_pixel[c * d_pstep] = lut_output_value< PixType >( gain * value, max_value_ );
+      }
+    }
+  }
+}
+
+
+template <typename PixType>
+void
+color_lut< PixType >
+::apply( vil_image_view< PixType > const& src,
+         vil_image_view< PixType >& dst,
+         double gain ) const
+{
+  if( !src || src.nplanes() != 3 || table_.empty() )
+  {
+    return;
+  }
+
+  if( dst.ni() != src.ni() || dst.nj() != src.nj() || dst.nplanes() != 3 )
+  {
+    dst.set_size( src.ni(), src.nj(), 3 );
+  }
+
+  compute_pool::instance()->parallel_for(
+    0, src.nj(),
+    boost::bind( &color_lut< PixType >::apply_rows, this,
+                 boost::cref( src ), boost::ref( dst ), gain, _1, _2 ),
+    "color_lut" );
+}
+
+
+} // end namespace vidtk
@@ -1,11 +1,20 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include "dual_rof_denoise.h"
 
+#include <utilities/compute_pool.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 namespace vidtk
 {
 
@@ -107,6 +116,368 @@ dual_rof_weighted_denoise(const vil_image_view<T>& src,
 }
 
 
+namespace
+{
+
+// Minimum number of rows in each strip processed by the fused solver
+const unsigned min_rows_per_strip = 32;
+
+
+// A row of an image plane, or of a contiguous buffer
+template <typename T>
+struct rof_row
+{
+  rof_row() : ptr(NULL), step(1) {}
+  rof_row(T* p, std::ptrdiff_t s) : ptr(p), step(s) {}
+
+  T& operator[](unsigned i) const { return ptr[i*step]; }
+
+  T* ptr;
+  std::ptrdiff_t step;
+};
+
+
+/// Update one row of the dual variable, vec += scale*grad(src), then truncate
+/// the vectors to the weights, or to unit length if there are no weights.
+/// The gradient uses the same stencil as add_scaled_gradient so that the
+/// results match the unfused solver. \a next is empty on the last row.
+template <typename T>
+void
+rof_dual_row(const rof_row<const T>& cur,
+             const rof_row<const T>& next,
+             const rof_row<T>& vx,
+             const rof_row<T>& vy,
+             const rof_row<const T>& weights,
+             unsigned ni, T scale)
+{
+  for (unsigned i=0; i+2<ni; ++i)
+  {
+    vx[i] += scale*(cur[i+1] - cur[i]);
+  }
+
+  if (next.ptr)
+  {
+    for (unsigned i=0; i+1<ni; ++i)
+    {
+      vy[i] += scale*(next[i] - cur[i]);
+    }
+  }
+
+  // Branch free truncation, dividing or multiplying by one leaves the
+  // vectors that are short enough unchanged.
+  if (weights.ptr)
+  {
+    for (unsigned i=0; i<ni; ++i)
+    {
+      const T mag = std::sqrt(vx[i]*vx[i] + vy[i]*vy[i]);
+      const T s = (mag > weights[i]) ? weights[i] / mag : T(1);
+      vx[i] *= s;
+      vy[i] *= s;
+    }
+  }
+  else
+  {
+    for (unsigned i=0; i<ni; ++i)
+    {
+      const T mag = std::sqrt(vx[i]*vx[i] + vy[i]*vy[i]);
+      const T d = (mag > T(1)) ? mag : T(1);
+      vx[i] /= d;
+      vy[i] /= d;
+    }
+  }
+}
+
+
+/// Compute one row of dest = src + scale*div(vec) from the x components
+/// of the vectors and the y components of the vectors on this row and the
+/// row above. The terms are combined in the same order as in
+/// add_scaled_divergence so that the results match the unfused solver.
+template <typename T>
+void
+rof_divergence_row(const rof_row<const T>& vx,
+                   const rof_row<const T>& vy,
+                   const rof_row<const T>& vy_up,
+                   const rof_row<const T>& src,
+                   const rof_row<T>& dest,
+                   unsigned ni, T scale)
+{
+  dest[0] = src[0] + scale*(vx[0] + vy[0] - vy_up[0]);
+  for (unsigned i=1; i<ni-1; ++i)
+  {
+    dest[i] = src[i] + scale*(-vx[i-1] + (vx[i] + vy[i] - vy_up[i]));
+  }
+  dest[ni-1] = src[ni-1] + scale*(-vx[ni-2] + vy[ni-1] - vy_up[ni-1]);
+}
+
+
+/// Fused, strip-parallel solver for the (weighted) dual ROF model.
+///
+/// Iterating over the rows in order, dual row j only depends on the previous
+/// dual row j and the previous destination rows j and j+1, while destination
+/// row j only depends on the new dual rows j and j-1.  Both can therefore be
+/// updated in a single sweep.  When the rows are split into strips, the
+/// destination rows on either side of each strip boundary and the dual row
+/// above it are saved before every iteration, and each strip recomputes the
+/// new dual row just above it from the saved rows.
+template <typename T>
+class rof_fused_solver
+{
+public:
+  rof_fused_solver(const vil_image_view<T>& src,
+                   const vil_image_view<T>* weights,
+                   vil_image_view<T>& dest,
+                   vil_image_view<T>& dual,
+                   T theta, T step,
+                   unsigned max_threads)
+    : src_(src),
+      weights_(weights),
+      dest_(dest),
+      dual_(dual),
+      ni_(src.ni()),
+      nj_(src.nj()),
+      theta_(theta),
+      scale_(step/theta),
+      zeros_(src.ni(), T(0))
+  {
+    unsigned strips = 1;
+    if (max_threads != 1)
+    {
+      strips = max_threads ? max_threads : compute_pool::instance()->core_budget();
+      strips = std::max(1u, std::min(strips, nj_ / min_rows_per_strip));
+    }
+
+    for (unsigned s=0; s<=strips; ++s)
+    {
+      strip_start_.push_back((nj_ * s) / strips);
+    }
+
+    if (strips > 1)
+    {
+      saved_dest_.resize(2*ni_*strips);
+      saved_dual_.resize(2*ni_*strips);
+      halo_.resize(2*ni_*strips);
+
+      for (unsigned s=0; s<strips; ++s)
+      {
+        tasks_.push_back(boost::bind(&rof_fused_solver<T>::process_strip, this, s));
+      }
+    }
+  }
+
+  void iterate(unsigned iterations)
+  {
+    for (unsigned it=0; it<iterations; ++it)
+    {
+      if (tasks_.empty())
+      {
+        process_strip(0);
+      }
+      else
+      {
+        save_boundaries();
+        compute_pool::instance()->run(tasks_, "dual_rof_denoise", tasks_.size());
+      }
+    }
+  }
+
+private:
+
+  rof_row<T> dest_row(unsigned j) const
+  {
+    return rof_row<T>(dest_.top_left_ptr() + j*dest_.jstep(), dest_.istep());
+  }
+
+  rof_row<T> dual_row(unsigned j, unsigned p) const
+  {
+    return rof_row<T>(dual_.top_left_ptr() + j*dual_.jstep() + p*dual_.planestep(),
+                      dual_.istep());
+  }
+
+  rof_row<const T> weight_row(unsigned j) const
+  {
+    if (!weights_)
+    {
+      return rof_row<const T>();
+    }
+    return rof_row<const T>(weights_->top_left_ptr() + j*weights_->jstep(),
+                            weights_->istep());
+  }
+
+  rof_row<T> buffer_row(std::vector<T>& buffer, unsigned s, unsigned r)
+  {
+    return rof_row<T>(&buffer[(2*s + r)*ni_], 1);
+  }
+
+  static rof_row<const T> in(const rof_row<T>& row)
+  {
+    return rof_row<const T>(row.ptr, row.step);
+  }
+
+  /// Save the rows around each strip boundary before they are overwritten
+  void save_boundaries()
+  {
+    for (unsigned s=1; s+1<strip_start_.size(); ++s)
+    {
+      const unsigned j = strip_start_[s];
+      const rof_row<T> rows[4] = { dest_row(j-1), dest_row(j),
+                                   dual_row(j-1, 0), dual_row(j-1, 1) };
+      const rof_row<T> saved[4] = { buffer_row(saved_dest_, s, 0),
+                                    buffer_row(saved_dest_, s, 1),
+                                    buffer_row(saved_dual_, s, 0),
+                                    buffer_row(saved_dual_, s, 1) };
+      for (unsigned r=0; r<4; ++r)
+      {
+        for (unsigned i=0; i<ni_; ++i)
+        {
+          saved[r][i] = rows[r][i];
+        }
+      }
+    }
+  }
+
+  /// Perform one iteration on the rows of a strip
+  void process_strip(unsigned s)
+  {
+    const unsigned j0 = strip_start_[s];
+    const unsigned j1 = strip_start_[s+1];
+    const rof_row<const T> zeros(&zeros_[0], 1);
+
+    // The new dual row above the strip
+    rof_row<T> halo_x, halo_y;
+    if (j0 > 0)
+    {
+      halo_x = buffer_row(halo_, s, 0);
+      halo_y = buffer_row(halo_, s, 1);
+      const rof_row<T> old_x = buffer_row(saved_dual_, s, 0);
+      const rof_row<T> old_y = buffer_row(saved_dual_, s, 1);
+      for (unsigned i=0; i<ni_; ++i)
+      {
+        halo_x[i] = old_x[i];
+        halo_y[i] = old_y[i];
+      }
+      rof_dual_row(in(buffer_row(saved_dest_, s, 0)), in(buffer_row(saved_dest_, s, 1)),
+                   halo_x, halo_y, weight_row(j0-1), ni_, scale_);
+    }
+
+    for (unsigned j=j0; j<j1; ++j)
+    {
+      const rof_row<T> cur = dest_row(j);
+
+      rof_row<const T> next;
+      if (j+1 < j1)
+      {
+        next = in(dest_row(j+1));
+      }
+      else if (j+1 < nj_)
+      {
+        next = in(buffer_row(saved_dest_, s+1, 1));
+      }
+
+      rof_dual_row(in(cur), next, dual_row(j, 0), dual_row(j, 1),
+                   weight_row(j), ni_, scale_);
+
+      const rof_row<const T> above_x = in(j > j0 ? dual_row(j-1, 0) : halo_x);
+      const rof_row<const T> above_y = in(j > j0 ? dual_row(j-1, 1) : halo_y);
+
+      // As in add_scaled_divergence, the last row uses the x components of
+      // the row above it.
+      const bool last = (j+1 == nj_);
+      rof_divergence_row(last ? above_x : in(dual_row(j, 0)),
+                         last ? zeros : in(dual_row(j, 1)),
+                         j > 0 ? above_y : zeros,
+                         rof_row<const T>(src_.top_left_ptr() + j*src_.jstep(), src_.istep()),
+                         cur, ni_, theta_);
+    }
+  }
+
+  const vil_image_view<T>& src_;
+  const vil_image_view<T>* weights_;
+  vil_image_view<T>& dest_;
+  vil_image_view<T>& dual_;
+
+  const unsigned ni_;
+  const unsigned nj_;
+  const T theta_;
+  const T scale_;
+
+  std::vector<unsigned> strip_start_;
+  std::vector<compute_pool::task_t> tasks_;
+
+  // Two rows for each strip boundary or strip
+  std::vector<T> saved_dest_;
+  std::vector<T> saved_dual_;
+  std::vector<T> halo_;
+  std::vector<T> zeros_;
+};
+
+
+template <typename T>
+void
+rof_fused_denoise(const vil_image_view<T>& src,
+                  const vil_image_view<T>* weights,
+                  vil_image_view<T>& dest,
+                  vil_image_view<T>& dual,
+                  unsigned iterations,
+                  T theta, T step,
+                  bool warm_start,
+                  unsigned max_threads)
+{
+  const unsigned ni = src.ni(), nj = src.nj();
+  assert(src.nplanes() == 1);
+  assert(ni > 1 && nj > 1);
+  assert(!weights || (weights->ni() == ni && weights->nj() == nj));
+
+  if (!warm_start ||
+      dest.ni() != ni || dest.nj() != nj || dest.nplanes() != 1 ||
+      dual.ni() != ni || dual.nj() != nj || dual.nplanes() != 2)
+  {
+    dest.deep_copy(src);
+    dual.set_size(ni,nj,2);
+    dual.fill(0.0);
+  }
+
+  rof_fused_solver<T> solver(src, weights, dest, dual, theta, step, max_threads);
+  solver.iterate(iterations);
+}
+
+} // end anonymous namespace
+
+
+/// Apply several iterations of the dual Rudin, Osher and Fatemi model
+/// using a fused, strip-parallel solver.
+template <typename T>
+void
+dual_rof_denoise_fused(const vil_image_view<T>& src,
+                       vil_image_view<T>& dest,
+                       vil_image_view<T>& dual,
+                       unsigned iterations,
+                       T theta, T step,
+                       bool warm_start,
+                       unsigned max_threads)
+{
+  rof_fused_denoise<T>(src, NULL, dest, dual, iterations, theta, step,
+                       warm_start, max_threads);
+}
+
+
+/// Apply several iterations of the weighted dual Rudin, Osher and Fatemi model
+/// using the fused, strip-parallel solver of dual_rof_denoise_fused.
+template <typename T>
+void
+dual_rof_weighted_denoise_fused(const vil_image_view<T>& src,
+                                const vil_image_view<T>& weights,
+                                vil_image_view<T>& dest,
+                                vil_image_view<T>& dual,
+                                unsigned iterations,
+                                T theta, T step,
+                                bool warm_start,
+                                unsigned max_threads)
+{
+  rof_fused_denoise<T>(src, &weights, dest, dual, iterations, theta, step,
+                       warm_start, max_threads);
+}
+
+
 /// Add the scaled divergence of a vector field to the source image.
 /// Compute dest = src + scale*div(vec)
 /// \param vec The vector field (x,y in planes 0,1)
@@ -344,7 +715,26 @@ dual_rof_weighted_denoise(const vil_image_view<T >& src,     \
                           const vil_image_view<T >& weights, \
                           vil_image_view<T >& dest,          \
                           unsigned iterations,               \
-                          T theta, T step)
+                          T theta, T step);                  \
+template                                                     \
+void                                                         \
+dual_rof_denoise_fused(const vil_image_view<T >& src,        \
+                       vil_image_view<T >& dest,             \
+                       vil_image_view<T >& dual,             \
+                       unsigned iterations,                  \
+                       T theta, T step,                      \
+                       bool warm_start,                      \
+                       unsigned max_threads);                \
+template                                                     \
+void                                                         \
+dual_rof_weighted_denoise_fused(const vil_image_view<T >& src,     \
+                                const vil_image_view<T >& weights, \
+                                vil_image_view<T >& dest,          \
+                                vil_image_view<T >& dual,          \
+                                unsigned iterations,               \
+                                T theta, T step,                   \
+                                bool warm_start,                   \
+                                unsigned max_threads)
 
 INSTANTIATE_ROF_DENOISE(float);
 INSTANTIATE_ROF_DENOISE(double);
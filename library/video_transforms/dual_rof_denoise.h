@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -91,6 +91,64 @@ dual_rof_weighted_denoise(const vil_image_view<T>& src,
                           T theta, T step = 0.25);
 
 
+/// Apply several iterations of the dual Rudin, Osher and Fatemi model
+/// using a fused, strip-parallel solver.
+/// Each iteration updates the dual variable and the destination image in a
+/// single sweep over the rows instead of three passes over whole images.
+/// Horizontal strips of the image are processed in parallel on the shared
+/// compute pool, with the rows at strip boundaries exchanged between
+/// iterations. The result is the same as dual_rof_denoise, and the solver
+/// is intended to be used with float images when speed matters most.
+/// \param src The source image
+/// \retval dest The destination image
+/// \retval dual The dual variable
+/// \param iterations The number of iterations
+/// \param theta A tuning parameter to control amount of smoothing.
+///              Larger values produce more smoothing.
+/// \param step The step size for each iteration
+/// \param warm_start If true and \a dest and \a dual have the size of \a src,
+///                   start from them (e.g. the result for the previous frame
+///                   of a video) instead of from \a src and a zero dual.
+/// \param max_threads The maximum number of strips processed at once,
+///                    0 for the core budget of the compute pool.
+template <typename T>
+void
+dual_rof_denoise_fused(const vil_image_view<T>& src,
+                       vil_image_view<T>& dest,
+                       vil_image_view<T>& dual,
+                       unsigned iterations,
+                       T theta, T step = 0.25,
+                       bool warm_start = false,
+                       unsigned max_threads = 0);
+
+
+/// Apply several iterations of the weighted dual Rudin, Osher and Fatemi model
+/// using the fused, strip-parallel solver of dual_rof_denoise_fused.
+/// The result is the same as dual_rof_weighted_denoise.
+/// \param src The source image
+/// \param weights An image of weights in [0,1].  A value of 1 results in denoising
+///                as usual.  Smaller values reduce the denoising amount
+/// \retval dest The destination image
+/// \retval dual The dual variable
+/// \param iterations The number of iterations
+/// \param theta A tuning parameter to control amount of smoothing.
+///              Larger values produce more smoothing.
+/// \param step The step size for each iteration
+/// \param warm_start If true, start from the existing \a dest and \a dual
+/// \param max_threads The maximum number of strips processed at once,
+///                    0 for the core budget of the compute pool.
+template <typename T>
+void
+dual_rof_weighted_denoise_fused(const vil_image_view<T>& src,
+                                const vil_image_view<T>& weights,
+                                vil_image_view<T>& dest,
+                                vil_image_view<T>& dual,
+                                unsigned iterations,
+                                T theta, T step = 0.25,
+                                bool warm_start = false,
+                                unsigned max_threads = 0);
+
+
 /// Add the scaled divergence of a vector field to the source image.
 /// Compute dest = src + scale*div(vec)
 /// \param vec The vector field (x,y in planes 0,1)
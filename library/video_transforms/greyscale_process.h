@@ -35,6 +35,16 @@ public:
   void set_image( vil_image_view<PixType> const& img );
   VIDTK_INPUT_PORT( set_image, vil_image_view<PixType> const& );
 
+  /// \brief Optional single-plane intensity image of the current frame.
+  ///
+  /// When supplied (e.g. the native luma plane from the video decoder)
+  /// and its size matches the input image, it is passed through as the
+  /// output instead of converting the color image. The provider must not
+  /// reuse the memory of this image for later frames, since it is also
+  /// output as the copied image without a deep copy.
+  void set_luma_image( vil_image_view<PixType> const& img );
+  VIDTK_OPTIONAL_INPUT_PORT( set_luma_image, vil_image_view<PixType> const& );
+
   vil_image_view<PixType> image() const;
   VIDTK_OUTPUT_PORT( vil_image_view<PixType>, image );
 
@@ -46,6 +56,7 @@ private:
   config_block config_;
 
   vil_image_view< PixType > const* in_img_;
+  vil_image_view< PixType > luma_img_;
   vil_image_view< PixType > out_img_;
   mutable vil_image_view< PixType > copied_out_img_;
 
@@ -82,6 +82,19 @@ greyscale_process<PixType>
 {
   LOG_ASSERT( in_img_ != NULL, "Input image not set" );
 
+  // Use the supplied luma plane, if any, in place of a conversion
+  if( !disabled_ && in_img_->nplanes() == 3 &&
+      luma_img_ && luma_img_.nplanes() == 1 &&
+      luma_img_.ni() == in_img_->ni() && luma_img_.nj() == in_img_->nj() )
+  {
+    out_img_ = luma_img_;
+    copied_out_img_ = luma_img_;
+    luma_img_ = vil_image_view< PixType >();
+    return true;
+  }
+
+  luma_img_ = vil_image_view< PixType >();
+
   if( disabled_ || in_img_->nplanes() == 1 )
   {
     out_img_ = *in_img_;
@@ -113,6 +126,15 @@ greyscale_process<PixType>
 }
 
 
+template <class PixType>
+void
+greyscale_process<PixType>
+::set_luma_image( vil_image_view<PixType> const& img )
+{
+  luma_img_ = img;
+}
+
+
 template <class PixType>
 vil_image_view<PixType>
 greyscale_process<PixType>
@@ -163,7 +163,7 @@ high_pass_filter_process<PixType>
       }
     }
 
-    threads_.reset( new thread_sys_t( 1, 1 ) );
+    threads_.reset( new thread_sys_t( 1, 1, this->name() ) );
     threads_->set_function( boost::bind( &self_type::process_region, this, _1, _2 ) );
     threads_->set_border_mode( true, blk.get<int>("border_ignore_factor") );
   }
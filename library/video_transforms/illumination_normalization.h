@@ -1,12 +1,12 @@
 /*ckwg +5
- * Copyright 2012-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include <vil/vil_image_view.h>
 
-#include <utilities/ring_buffer.h>
+#include <video_transforms/image_statistics.h>
 
 /// @file illumination_normalization.h
 /// @brief Functions for performing simple frame-to-frame illumination normalization
@@ -42,7 +42,8 @@ public:
 /**Normalizes the illumination of an image based on the median of the pixel values.
  * This assumes the background makes up the majority of the intensity data and that
  * background content does not change much.  This assumption allows us to assume
- * the difference medians is related to differences in illumination.*/
+ * the difference medians is related to differences in illumination.  Medians are
+ * computed exactly with image_order_statistics.*/
 template < class PixType >
 class median_illumination_normalization : public illumination_normalization< PixType >
 {
@@ -109,6 +110,19 @@ public:
 
   double calculate_mean( vil_image_view<PixType> const& img ) const;
 
+  /** Returns a downsampled view (not a copy) of the pixels used to estimate
+   * the mean illumination of an image. */
+  vil_image_view<PixType> sampled_view( vil_image_view<PixType> const& img ) const;
+
+  /** Calculate the mean illumination of an already downsampled image. */
+  double calculate_sampled_mean( vil_image_view<PixType> const& samples ) const;
+
+  /** Add the illumination of a new image to the history, and return the
+   * scale factor which should be applied to it. A factor of 1 is returned
+   * when the normalizer is reset due to an empty image.
+   * @param est The mean illumination of the new image */
+  double update_scale( double est );
+
 protected:
 
   unsigned window_length_;
@@ -116,7 +130,7 @@ protected:
   double min_illum_allowed_;
   double max_illum_allowed_;
 
-  ring_buffer< double > illum_history_;
+  windowed_mean illum_history_;
 
 };
 
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -25,10 +25,12 @@ double
 median_illumination_normalization<PixType>
 ::calculate_median( vil_image_view<PixType> const & img ) const
 {
+  // Medians are truncated to the pixel type, as vil_math_median does, so
+  // that the normalization is unchanged from the sorting implementation.
   std::vector<PixType> medians(img.nplanes(),0);
   for(unsigned int i = 0; i < img.nplanes(); ++i)
   {
-    vil_math_median(medians[i], img, i);
+    medians[i] = static_cast<PixType>(image_plane_median(img, i, 0));
   }
   double m = 0;
   if(medians.size() == 3) //assuming RGB image
@@ -91,19 +93,32 @@ median_illumination_normalization<PixType>
 
 // Mean normalizer
 template<class PixType>
-double
+vil_image_view<PixType>
 mean_illumination_normalization<PixType>
-::calculate_mean( vil_image_view<PixType> const & img ) const
+::sampled_view( vil_image_view<PixType> const & img ) const
 {
+  // Special case for very small images, ignore them.
+  if( img.size() == 0 )
+  {
+    return vil_image_view<PixType>();
+  }
+
   // Downsample the image
-  vil_image_view<PixType> downsampled( img.top_left_ptr(),
-                                       1+(img.ni()-1)/sampling_rate_,
-                                       1+(img.nj()-1)/sampling_rate_,
-                                       img.nplanes(),
-                                       sampling_rate_ * img.istep(),
-                                       sampling_rate_ * img.jstep(),
-                                       img.planestep() );
+  return vil_image_view<PixType>( img.memory_chunk(),
+                                  img.top_left_ptr(),
+                                  1+(img.ni()-1)/sampling_rate_,
+                                  1+(img.nj()-1)/sampling_rate_,
+                                  img.nplanes(),
+                                  sampling_rate_ * img.istep(),
+                                  sampling_rate_ * img.jstep(),
+                                  img.planestep() );
+}
 
+template<class PixType>
+double
+mean_illumination_normalization<PixType>
+::calculate_sampled_mean( vil_image_view<PixType> const & downsampled ) const
+{
   // Special case for very small images, ignore them.
   if( downsampled.size() == 0 )
   {
@@ -114,51 +129,42 @@ mean_illumination_normalization<PixType>
 
   std::vector< double > chan_avg( downsampled.nplanes(), 0.0 );
 
-  for( unsigned p=0;p<img.nplanes();++p )
+  for( unsigned p=0;p<downsampled.nplanes();++p )
   {
     vil_math_sum( chan_avg[p], downsampled, p );
   }
 
   // Special case for RGB, use standard intensity
-  if( img.nplanes() == 3 )
+  if( downsampled.nplanes() == 3 )
   {
     return vil_rgb<double>(chan_avg[0], chan_avg[1], chan_avg[2]).grey() / pixels_per_plane;
   }
 
   // For all other channel amounts average each channel
-  for( unsigned p=1; p<img.nplanes(); ++p )
+  for( unsigned p=1; p<downsampled.nplanes(); ++p )
   {
     chan_avg[0] += chan_avg[p];
   }
-  return chan_avg[0] / ( pixels_per_plane*img.nplanes() );
+  return chan_avg[0] / ( pixels_per_plane*downsampled.nplanes() );
 }
 
 template<class PixType>
-vil_image_view<PixType>
+double
 mean_illumination_normalization<PixType>
-::operator()( vil_image_view<PixType> const & img, bool deep_copy )
+::calculate_mean( vil_image_view<PixType> const & img ) const
 {
-  vil_image_view<PixType> result;
-  if( deep_copy )
-  {
-    result.deep_copy(img);
-  }
-  else
-  {
-    result = img;
-  }
+  return this->calculate_sampled_mean( this->sampled_view( img ) );
+}
 
-  // Calculate current illumination
-  double est = this->calculate_mean( img );
+template<class PixType>
+double
+mean_illumination_normalization<PixType>
+::update_scale( double est )
+{
   illum_history_.insert( est );
 
   // Calculate desired average illumination
-  double avg = 0.0;
-  for( unsigned i = 0; i < illum_history_.size(); i++ )
-  {
-    avg += illum_history_.datum_at( i );
-  }
-  avg = avg / illum_history_.size();
+  double avg = illum_history_.mean();
 
   // Threshold average illumination based on type
   double min_threshold = min_illum_allowed_ * default_white_point<PixType>::value();
@@ -173,10 +179,38 @@ mean_illumination_normalization<PixType>
     avg = max_threshold;
   }
 
-  // If empty frames received, simply reset and exit
+  // If empty frames received, simply reset
   if( avg == 0.0 || est == 0.0 )
   {
     this->reset();
+    return 1.0;
+  }
+
+  return avg / est;
+}
+
+template<class PixType>
+vil_image_view<PixType>
+mean_illumination_normalization<PixType>
+::operator()( vil_image_view<PixType> const & img, bool deep_copy )
+{
+  vil_image_view<PixType> result;
+  if( deep_copy )
+  {
+    result.deep_copy(img);
+  }
+  else
+  {
+    result = img;
+  }
+
+  // Calculate current illumination
+  double est = this->calculate_mean( img );
+
+  // If empty frames received, the normalizer is reset and the image is unchanged
+  double scale = this->update_scale( est );
+  if( scale == 1.0 )
+  {
     return result;
   }
 
@@ -184,7 +218,7 @@ mean_illumination_normalization<PixType>
   // great approach when the variance between the current and average
   // illumination is large, in which case it will result in over/under
   // saturation and greater error in normalization.
-  vil_transform( result, illum_scale_functor(avg/est) );
+  vil_transform( result, illum_scale_functor(scale) );
   return result;
 }
 
@@ -193,8 +227,7 @@ void
 mean_illumination_normalization<PixType>
 ::reset()
 {
-  illum_history_.clear();
-  illum_history_.set_capacity( window_length_ );
+  illum_history_.set_window_length( window_length_ );
 }
 
 }
@@ -0,0 +1,86 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "image_statistics.h"
+
+#include <algorithm>
+
+namespace vidtk
+{
+
+
+windowed_mean
+::windowed_mean( unsigned window_length )
+  : sum_( 0.0 ),
+    inserts_since_refresh_( 0 )
+{
+  this->set_window_length( window_length );
+}
+
+
+void
+windowed_mean
+::set_window_length( unsigned window_length )
+{
+  history_.set_capacity( std::max( window_length, 1u ) );
+  this->clear();
+}
+
+
+void
+windowed_mean
+::insert( double value )
+{
+  if( history_.size() == history_.capacity() )
+  {
+    sum_ -= history_.datum_at( history_.size() - 1 );
+  }
+
+  history_.insert( value );
+  sum_ += value;
+
+  // Recompute the sum once per window length to bound rounding error
+  if( ++inserts_since_refresh_ >= history_.capacity() )
+  {
+    sum_ = 0.0;
+
+    for( unsigned i = 0; i < history_.size(); ++i )
+    {
+      sum_ += history_.datum_at( i );
+    }
+
+    inserts_since_refresh_ = 0;
+  }
+}
+
+
+double
+windowed_mean
+::mean() const
+{
+  return ( history_.size() > 0 ? sum_ / history_.size() : 0.0 );
+}
+
+
+unsigned
+windowed_mean
+::size() const
+{
+  return history_.size();
+}
+
+
+void
+windowed_mean
+::clear()
+{
+  history_.clear();
+  sum_ = 0.0;
+  inserts_since_refresh_ = 0;
+}
+
+
+} // end namespace vidtk
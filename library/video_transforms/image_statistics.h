@@ -0,0 +1,150 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_image_statistics_h_
+#define vidtk_image_statistics_h_
+
+#include <vil/vil_image_view.h>
+
+#include <utilities/ring_buffer.h>
+
+#include <vxl_config.h>
+
+#include <vector>
+
+/// @file image_statistics.h
+/// @brief Shared engine for image medians, percentiles and running means.
+
+namespace vidtk
+{
+
+
+/// Pixel types with a value range small enough to be counted exactly in
+/// a histogram. Order statistics of all other types use selection.
+template <typename PixType>
+struct exact_histogram_traits
+{
+  static const bool enabled = false;
+  static const unsigned bins = 0;
+};
+
+template <>
+struct exact_histogram_traits< vxl_byte >
+{
+  static const bool enabled = true;
+  static const unsigned bins = 256;
+};
+
+template <>
+struct exact_histogram_traits< vxl_uint_16 >
+{
+  static const bool enabled = true;
+  static const unsigned bins = 65536;
+};
+
+
+/** Exact order statistics (medians and percentiles) of an image plane.
+ *
+ * For 8 and 16-bit unsigned images the values are counted in a histogram
+ * in a single pass, which may be split across threads of the shared
+ * compute pool with one partial histogram per thread. For all other
+ * types, or when only a few samples are taken, the values are copied and
+ * the requested ranks are found with std::nth_element. Both paths give
+ * identical results.
+ *
+ * Percentiles use the nearest rank, i.e. the value at sorted index
+ * round( (count-1) * percentile ), which matches the definition used by
+ * get_image_percentiles.
+ */
+template <typename PixType>
+class image_order_statistics
+{
+public:
+
+  /** Constructor.
+   * @param max_threads Maximum number of threads used when building a
+   * histogram of a large image, 0 for the compute pool's core budget. */
+  explicit image_order_statistics( unsigned max_threads = 1 );
+
+  /** Gather the values of a single image plane.
+   * @param src The input image
+   * @param plane The plane to gather values from
+   * @param sampling_points If non-zero, only this many evenly spaced pixels
+   * are used instead of every pixel in the plane. */
+  void compute( vil_image_view< PixType > const& src,
+                unsigned plane = 0,
+                unsigned sampling_points = 0 );
+
+  /// Number of values gathered by the last call to compute.
+  unsigned count() const;
+
+  /// Value at the given percentile, in the range [0,1].
+  PixType percentile( double fraction );
+
+  /// Values at each of the given percentiles, in the range [0,1].
+  void percentiles( std::vector< double > const& fractions,
+                    std::vector< PixType >& dst );
+
+  /// Median value, averaging the two central values for an even count.
+  double median();
+
+private:
+
+  PixType value_at_rank( unsigned rank );
+
+  unsigned max_threads_;
+  unsigned count_;
+  bool use_histogram_;
+
+  std::vector< unsigned > histogram_;
+  std::vector< PixType > values_;
+  unsigned values_ordered_from_;
+};
+
+
+/// Convenience function returning the exact median of one image plane.
+template <typename PixType>
+double image_plane_median( vil_image_view< PixType > const& src,
+                           unsigned plane = 0,
+                           unsigned max_threads = 1 );
+
+
+/** Mean of the last N values inserted, updated in constant time.
+ *
+ * The running sum is periodically recomputed from the stored values so
+ * that floating point error does not build up over long sequences. */
+class windowed_mean
+{
+public:
+
+  explicit windowed_mean( unsigned window_length = 1 );
+
+  /// Change the window length, clearing all stored values.
+  void set_window_length( unsigned window_length );
+
+  /// Add a new value, removing the oldest one if the window is full.
+  void insert( double value );
+
+  /// Mean of the values currently in the window, 0 if empty.
+  double mean() const;
+
+  /// Number of values currently in the window.
+  unsigned size() const;
+
+  /// Remove all stored values.
+  void clear();
+
+private:
+
+  ring_buffer< double > history_;
+  double sum_;
+  unsigned inserts_since_refresh_;
+};
+
+
+} // end namespace vidtk
+
+#endif // vidtk_image_statistics_h_
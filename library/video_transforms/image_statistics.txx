@@ -0,0 +1,314 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "image_statistics.h"
+
+#include <utilities/compute_pool.h>
+
+#include <logger/logger.h>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace vidtk
+{
+
+
+VIDTK_LOGGER("image_statistics_txx");
+
+
+namespace
+{
+
+// Minimum number of pixels counted by each thread when building a histogram
+const unsigned min_pixels_per_task = 1 << 16;
+
+// Count the values of rows [j0,j1) of one plane into a histogram
+template <typename PixType>
+void count_rows( vil_image_view< PixType > const& src,
+                 unsigned plane, unsigned j0, unsigned j1,
+                 std::vector< unsigned >* histogram )
+{
+  std::vector< unsigned >& hist = *histogram;
+  hist.assign( exact_histogram_traits< PixType >::bins, 0 );
+
+  const unsigned ni = src.ni();
+  const std::ptrdiff_t istep = src.istep();
+  const std::ptrdiff_t jstep = src.jstep();
+
+  const PixType* row = src.top_left_ptr() + plane * src.planestep() + j0 * jstep;
+
+  for( unsigned j = j0; j < j1; ++j, row += jstep )
+  {
+    const PixType* pixel = row;
+    for( unsigned i = 0; i < ni; ++i, pixel += istep )
+    {
+      ++hist[ static_cast< unsigned >( *pixel ) ];
+    }
+  }
+}
+
+} // end anonymous namespace
+
+
+template <typename PixType>
+image_order_statistics< PixType >
+::image_order_statistics( unsigned max_threads )
+  : max_threads_( max_threads ),
+    count_( 0 ),
+    use_histogram_( false ),
+    values_ordered_from_( 0 )
+{
+}
+
+
+template <typename PixType>
+void
+image_order_statistics< PixType >
+::compute( vil_image_view< PixType > const& src,
+           unsigned plane,
+           unsigned sampling_points )
+{
+  LOG_ASSERT( plane < src.nplanes() || src.size() == 0, "Invalid plane index" );
+
+  count_ = 0;
+  values_ordered_from_ = 0;
+  histogram_.clear();
+  values_.clear();
+
+  const unsigned ni = src.ni();
+  const unsigned nj = src.nj();
+  const unsigned plane_size = ni * nj;
+
+  if( plane_size == 0 )
+  {
+    return;
+  }
+
+  const bool sampled = ( sampling_points > 0 && sampling_points < plane_size );
+  count_ = ( sampled ? sampling_points : plane_size );
+
+  // Clearing and scanning a histogram is only worth it when there are
+  // enough values to fill a reasonable portion of its bins.
+  use_histogram_ = exact_histogram_traits< PixType >::enabled &&
+                   count_ >= exact_histogram_traits< PixType >::bins / 4;
+
+  if( sampled )
+  {
+    // Same sampling pattern as sample_and_sort_image
+    const unsigned pixel_step = plane_size / sampling_points;
+    unsigned position = 0;
+
+    if( use_histogram_ )
+    {
+      histogram_.assign( exact_histogram_traits< PixType >::bins, 0 );
+    }
+    else
+    {
+      values_.resize( count_ );
+    }
+
+    for( unsigned pt = 0; pt < sampling_points; ++pt, position += pixel_step )
+    {
+      const PixType value = src( position % ni, ( position / ni ) % nj, plane );
+
+      if( use_histogram_ )
+      {
+        ++histogram_[ static_cast< unsigned >( value ) ];
+      }
+      else
+      {
+        values_[pt] = value;
+      }
+    }
+  }
+  else if( use_histogram_ )
+  {
+    unsigned task_count = 1;
+
+    if( max_threads_ != 1 )
+    {
+      compute_pool_t pool = compute_pool::instance();
+
+      task_count = ( max_threads_ ? max_threads_ : pool->core_budget() );
+      task_count = std::min( task_count, nj );
+      task_count = std::min( task_count, plane_size / min_pixels_per_task );
+    }
+
+    if( task_count <= 1 )
+    {
+      count_rows( src, plane, 0, nj, &histogram_ );
+    }
+    else
+    {
+      std::vector< std::vector< unsigned > > partials( task_count );
+      std::vector< compute_pool::task_t > tasks;
+
+      for( unsigned t = 0; t < task_count; ++t )
+      {
+        const unsigned j0 = ( nj * t ) / task_count;
+        const unsigned j1 = ( nj * ( t + 1 ) ) / task_count;
+
+        tasks.push_back( boost::bind( &count_rows< PixType >, boost::cref( src ),
+                                      plane, j0, j1, &partials[t] ) );
+      }
+
+      compute_pool::instance()->run( tasks, "image_order_statistics", task_count );
+
+      histogram_.swap( partials[0] );
+
+      for( unsigned t = 1; t < task_count; ++t )
+      {
+        for( unsigned b = 0; b < histogram_.size(); ++b )
+        {
+          histogram_[b] += partials[t][b];
+        }
+      }
+    }
+  }
+  else
+  {
+    values_.reserve( count_ );
+
+    for( unsigned j = 0; j < nj; ++j )
+    {
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        values_.push_back( src( i, j, plane ) );
+      }
+    }
+  }
+}
+
+
+template <typename PixType>
+unsigned
+image_order_statistics< PixType >
+::count() const
+{
+  return count_;
+}
+
+
+template <typename PixType>
+PixType
+image_order_statistics< PixType >
+::value_at_rank( unsigned rank )
+{
+  if( use_histogram_ )
+  {
+    unsigned cumulative = 0;
+
+    for( unsigned b = 0; b < histogram_.size(); ++b )
+    {
+      cumulative += histogram_[b];
+
+      if( cumulative > rank )
+      {
+        return static_cast< PixType >( b );
+      }
+    }
+
+    return static_cast< PixType >( histogram_.size() - 1 );
+  }
+
+  // Every value before values_ordered_from_ is no greater than any value
+  // after it, so increasing ranks only need to search the remainder.
+  typename std::vector< PixType >::iterator first = values_.begin();
+
+  if( rank >= values_ordered_from_ )
+  {
+    first += values_ordered_from_;
+  }
+
+  std::nth_element( first, values_.begin() + rank, values_.end() );
+  values_ordered_from_ = rank;
+
+  return values_[rank];
+}
+
+
+template <typename PixType>
+PixType
+image_order_statistics< PixType >
+::percentile( double fraction )
+{
+  LOG_ASSERT( fraction >= 0 && fraction <= 1.0, "Percentile must be in range [0,1]" );
+
+  if( count_ == 0 )
+  {
+    return PixType( 0 );
+  }
+
+  return value_at_rank( static_cast< unsigned >( ( count_ - 1 ) * fraction + 0.5 ) );
+}
+
+
+template <typename PixType>
+void
+image_order_statistics< PixType >
+::percentiles( std::vector< double > const& fractions,
+               std::vector< PixType >& dst )
+{
+  dst.resize( fractions.size() );
+
+  // Query in increasing order so that selection only partitions the
+  // remaining values each time.
+  std::vector< std::pair< double, unsigned > > order( fractions.size() );
+
+  for( unsigned i = 0; i < fractions.size(); ++i )
+  {
+    order[i] = std::make_pair( fractions[i], i );
+  }
+
+  std::sort( order.begin(), order.end() );
+
+  for( unsigned i = 0; i < order.size(); ++i )
+  {
+    dst[ order[i].second ] = this->percentile( order[i].first );
+  }
+}
+
+
+template <typename PixType>
+double
+image_order_statistics< PixType >
+::median()
+{
+  if( count_ == 0 )
+  {
+    return 0.0;
+  }
+
+  if( count_ % 2 == 1 )
+  {
+    return static_cast< double >( value_at_rank( count_ / 2 ) );
+  }
+
+  const double lower = static_cast< double >( value_at_rank( count_ / 2 - 1 ) );
+  const double upper = static_cast< double >( value_at_rank( count_ / 2 ) );
+
+  return ( lower + upper ) / 2.0;
+}
+
+
+template <typename PixType>
+double
+image_plane_median( vil_image_view< PixType > const& src,
+                    unsigned plane,
+                    unsigned max_threads )
+{
+  image_order_statistics< PixType > stats( max_threads );
+  stats.compute( src, plane );
+  return stats.median();
+}
+
+
+} // end namespace vidtk
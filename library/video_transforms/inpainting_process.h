@@ -77,6 +77,10 @@ public:
   void set_type( std::string const& s );
   VIDTK_INPUT_PORT( set_type, std::string const& );
 
+  /// \brief Set the processing quality tier for the current frame.
+  void set_quality_tier( unsigned tier );
+  VIDTK_OPTIONAL_INPUT_PORT( set_quality_tier, unsigned );
+
   /// \brief The inpainted output image.
   image_t inpainted_image() const;
   VIDTK_OUTPUT_PORT( image_t, inpainted_image );
@@ -86,7 +90,7 @@ private:
   // Parameters
   config_block config_;
   bool disabled_;
-  enum{ NEAREST, TELEA, NAVIER, NONE } algorithm_;
+  enum algorithm_t{ NEAREST, TELEA, NAVIER, NONE } algorithm_;
   enum{ FILL_SOLID, INPAINT } border_method_;
   double radius_;
   double stab_image_factor_;
@@ -99,6 +103,8 @@ private:
   unsigned min_size_for_hist_;
   double flush_trigger_;
   double illum_trigger_;
+  unsigned nearest_tier_;
+  unsigned unstabilized_tier_;
 
   // Internal algorithm helpers
   boost::scoped_ptr< thread_sys_t > threads_;
@@ -118,6 +124,10 @@ private:
   homography_t input_homography_;
   shot_break_flags input_sbf_;
   std::string input_type_;
+  unsigned input_tier_;
+
+  // Algorithm used for the current frame, given the quality tier
+  algorithm_t frame_algorithm_;
 
   // Internal buffers
   image_t last_input_image_;
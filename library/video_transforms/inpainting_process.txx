@@ -49,6 +49,10 @@ inpainting_process<PixType>
     min_size_for_hist_( 0 ),
     flush_trigger_( 0.90 ),
     illum_trigger_( 0.00 ),
+    nearest_tier_( 0 ),
+    unstabilized_tier_( 0 ),
+    input_tier_( 0 ),
+    frame_algorithm_( NEAREST ),
     buffering_enabled_( false ),
     is_buffering_( false )
 {
@@ -91,9 +95,10 @@ inpainting_process<PixType>
   config_.add_parameter(
     "core_count",
     "8",
-    "This parameter will attempt to optimize the internal threading system "
-    "for a CPU containing this number of cores. Setting the parameter to 1 "
-    "will disable multi-threading." );
+    "This parameter will attempt to optimize the internal tiling for a CPU "
+    "containing this number of cores. Setting the parameter to 1 will disable "
+    "multi-threading. Tiles are run on the shared compute pool, so fewer "
+    "threads are used if the pool's core budget is lower." );
 
   config_.add_parameter(
     "border_method",
@@ -140,6 +145,20 @@ inpainting_process<PixType>
     "untouched, and w for width (e.g. a value of 0.5:0.5 will leave the inner "
     "half of the image unmodified)." );
 
+  config_.add_parameter(
+    "nearest_tier",
+    "0",
+    "If non-zero, the nearest neighbor algorithm will be used instead of "
+    "the configured algorithm on any frame whose input quality tier is "
+    "greater than or equal to this value." );
+
+  config_.add_parameter(
+    "unstabilized_tier",
+    "0",
+    "If non-zero, warped prior frames will not be merged into the "
+    "inpainted output on any frame whose input quality tier is greater than "
+    "or equal to this value. Not applicable when using a mosaic." );
+
   config_.merge( moving_mosaic_settings().config() );
 }
 
@@ -246,7 +265,7 @@ inpainting_process<PixType>
       if( algorithm_ != NONE )
       {
         int boundary_adj = ( algorithm_ != NEAREST && core_count > 1 ? 1 : 0 );
-        threads_.reset( new thread_sys_t( thread_grid_width, thread_grid_height ) );
+        threads_.reset( new thread_sys_t( thread_grid_width, thread_grid_height, this->name() ) );
         threads_->set_function( boost::bind( &self_type::inpaint, this, _1, _2, _3 ) );
         threads_->set_border_mode( ( border_method_ != FILL_SOLID ), 0, boundary_adj );
       }
@@ -256,6 +275,8 @@ inpainting_process<PixType>
       min_size_for_hist_ = blk.get< unsigned >( "min_size_for_hist" );
       flush_trigger_ = blk.get< double >( "flush_trigger" );
       illum_trigger_ = blk.get< double >( "illum_trigger" );
+      nearest_tier_ = blk.get< unsigned >( "nearest_tier" );
+      unstabilized_tier_ = blk.get< unsigned >( "unstabilized_tier" );
 
       if( use_mosaic_ )
       {
@@ -577,8 +598,23 @@ inpainting_process<PixType>
     point_view_to_region( inpaint_mask, center_region ).fill( false );
   }
 
+  // Reduce quality if requested for this frame
+  const bool use_stab_image = stab_image_factor_ > 0.0 &&
+    ( use_mosaic_ || unstabilized_tier_ == 0 || input_tier_ < unstabilized_tier_ );
+
+  if( algorithm_ != NONE && nearest_tier_ > 0 && input_tier_ >= nearest_tier_ )
+  {
+    frame_algorithm_ = NEAREST;
+  }
+  else
+  {
+    frame_algorithm_ = algorithm_;
+  }
+
+  input_tier_ = 0;
+
   // Perform actual inpainting
-  if( stab_image_factor_ > 0.0 )
+  if( use_stab_image )
   {
     if( algorithm_ != NONE )
     {
@@ -600,7 +636,7 @@ inpainting_process<PixType>
   }
 
   // Average in warped image if set
-  if( stab_image_factor_ > 0.0 && warped_mask_.size() > 0 && !is_buffering_ )
+  if( use_stab_image && warped_mask_.size() > 0 && !is_buffering_ )
   {
     if( adj_motion_mask_.size() > 0 )
     {
@@ -740,19 +776,19 @@ inpainting_process<PixType>
 ::inpaint( const image_t input, const mask_t mask, image_t output ) const
 {
   // Validate input image
-  if( !input || input.size() == 0 || algorithm_ == NONE )
+  if( !input || input.size() == 0 || frame_algorithm_ == NONE )
   {
     return;
   }
 
   // Perform algorithm
-  if( algorithm_ == NEAREST )
+  if( frame_algorithm_ == NEAREST )
   {
     vil_copy_reformat( input, output );
     nn_inpaint( output, mask );
   }
 #ifdef USE_OPENCV
-  else if( algorithm_ == TELEA || algorithm_ == NAVIER )
+  else if( frame_algorithm_ == TELEA || frame_algorithm_ == NAVIER )
   {
     // Convert image and mask to opencv format
     image_t copied_input = image_t( input.ni(),
@@ -785,7 +821,7 @@ inpainting_process<PixType>
                             output.jstep() * sizeof( PixType ) );
 
     // Run opencv inpaint
-    int method = ( algorithm_ == TELEA ? CV_INPAINT_TELEA : CV_INPAINT_NS );
+    int method = ( frame_algorithm_ == TELEA ? CV_INPAINT_TELEA : CV_INPAINT_NS );
     cv::inpaint( ocv_input, ocv_mask, output_wrapper, radius_, method );
   }
 #endif
@@ -1033,6 +1069,14 @@ inpainting_process<PixType>
   input_sbf_ = sbf;
 }
 
+template <typename PixType>
+void
+inpainting_process<PixType>
+::set_quality_tier( unsigned tier )
+{
+  input_tier_ = tier;
+}
+
 template <typename PixType>
 typename inpainting_process<PixType>::image_t
 inpainting_process<PixType>
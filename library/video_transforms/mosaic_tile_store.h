@@ -0,0 +1,107 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#ifndef vidtk_mosaic_tile_store_h_
+#define vidtk_mosaic_tile_store_h_
+
+#include <vil/vil_image_view.h>
+#include <vgl/vgl_box_2d.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace vidtk
+{
+
+// ----------------------------------------------------------------
+/** Sparse, tiled storage of an unbounded mosaic image.
+ *
+ * The mosaic is split into square tiles which are kept in a hash map
+ * keyed by tile coordinates. Tiles are only allocated when written to,
+ * and pixels of tiles which do not exist are zero. Pixel coordinates
+ * may be negative, so moving the region of interest over the mosaic
+ * only changes which coordinates are used, and never moves pixels.
+ *
+ * When the tiles held in memory exceed the memory budget, the least
+ * recently used ones are written to a spill directory and read back on
+ * their next use. Tiles are only spilled by enforce_budget(), so tile
+ * pointers stay valid until then, or until the store is cleared.
+ *
+ * The store is not thread safe.
+ */
+template< typename PixType >
+class mosaic_tile_store
+{
+public:
+
+  typedef vil_image_view< PixType > tile_t;
+
+  mosaic_tile_store();
+  ~mosaic_tile_store();
+
+  /// \brief Set the tile layout and memory budget, removing all tiles.
+  ///
+  /// \param tile_size Side length of a tile in pixels.
+  /// \param nplanes Number of planes of each tile.
+  /// \param memory_budget Largest number of bytes of tiles kept in memory.
+  /// \param spill_dir Directory in which spilled tiles are written, the
+  /// system temporary directory is used if empty.
+  /// \return False if the tile size or plane count is zero.
+  bool configure( unsigned tile_size,
+                  unsigned nplanes,
+                  size_t memory_budget,
+                  const std::string& spill_dir );
+
+  unsigned tile_size() const;
+  unsigned nplanes() const;
+
+  /// Index of the tile row or column containing pixel coordinate \a p.
+  int tile_index( int p ) const;
+
+  /// Get a tile for writing, allocating a zero filled tile if needed.
+  tile_t* writable_tile( int tx, int ty );
+
+  /// Get a tile for reading, or null if the tile has never been written.
+  const tile_t* find_tile( int tx, int ty );
+
+  /// Pixel extent of all tiles, empty if there are none.
+  vgl_box_2d< int > bounds() const;
+
+  /// Copy the region whose top left pixel is at (\a i0, \a j0) into
+  /// \a image, which must be sized already.
+  void copy_to( int i0, int j0, tile_t& image );
+
+  /// Write \a image into the mosaic with its top left pixel at (\a i0,
+  /// \a j0). Tiles which do not exist are only created if the part of
+  /// \a image covering them is not all zero.
+  void copy_from( int i0, int j0, const tile_t& image );
+
+  /// Spill the least recently used tiles until the budget is met.
+  void enforce_budget();
+
+  /// Remove all tiles, including spilled ones, which do not overlap the
+  /// pixel region \a keep.
+  void remove_outside( const vgl_box_2d< int >& keep );
+
+  /// Remove all tiles, including spilled ones.
+  void clear();
+
+  /// Number of tiles, in memory or spilled.
+  size_t tile_count() const;
+
+  /// Number of tiles held in memory.
+  size_t resident_count() const;
+
+private:
+  class priv;
+  boost::scoped_ptr< priv > d;
+};
+
+} // end namespace vidtk
+
+#endif // vidtk_mosaic_tile_store_h_
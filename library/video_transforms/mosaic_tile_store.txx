@@ -0,0 +1,628 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <video_transforms/mosaic_tile_store.h>
+
+#include <vil/vil_copy.h>
+#include <vil/vil_crop.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <logger/logger.h>
+
+namespace vidtk
+{
+
+VIDTK_LOGGER( "mosaic_tile_store" );
+
+template< typename PixType >
+class mosaic_tile_store< PixType >::priv
+{
+public:
+
+  struct tile_key
+  {
+    tile_key( int x, int y ) : tx( x ), ty( y ) {}
+
+    bool operator==( const tile_key& other ) const
+    {
+      return tx == other.tx && ty == other.ty;
+    }
+
+    int tx;
+    int ty;
+  };
+
+  struct tile_key_hash
+  {
+    size_t operator()( const tile_key& k ) const
+    {
+      size_t seed = 0;
+      boost::hash_combine( seed, k.tx );
+      boost::hash_combine( seed, k.ty );
+      return seed;
+    }
+  };
+
+  struct tile_entry
+  {
+    tile_entry() : dirty( true ), on_disk( false ), last_use( 0 ) {}
+
+    // Empty while the tile is spilled
+    tile_t image;
+
+    // Whether the image differs from the spilled copy
+    bool dirty;
+    bool on_disk;
+    unsigned long last_use;
+  };
+
+  typedef boost::unordered_map< tile_key, tile_entry, tile_key_hash > tile_map_t;
+
+  priv()
+    : tile_size( 256 ),
+      nplanes( 1 ),
+      memory_budget( 0 ),
+      use_clock( 0 ),
+      resident( 0 )
+  {}
+
+  size_t tile_bytes() const
+  {
+    return static_cast< size_t >( tile_size ) * tile_size * nplanes * sizeof( PixType );
+  }
+
+  tile_entry* lookup( int tx, int ty );
+  tile_entry& insert( int tx, int ty );
+  bool load( const tile_key& key, tile_entry& entry );
+  bool spill( const tile_key& key, tile_entry& entry );
+  std::string tile_fn( const tile_key& key ) const;
+  bool make_spill_dir();
+  void remove_spill_dir();
+
+  unsigned tile_size;
+  unsigned nplanes;
+  size_t memory_budget;
+  std::string spill_root;
+
+  // Created on the first spill, removed when the store is cleared
+  boost::filesystem::path spill_dir;
+
+  tile_map_t tiles;
+  unsigned long use_clock;
+  size_t resident;
+};
+
+
+// ----------------------------------------------------------------
+/** Find a tile, reading it back in if it was spilled.
+ *
+ * Returns null if the tile does not exist.
+ */
+template< typename PixType >
+typename mosaic_tile_store< PixType >::priv::tile_entry*
+mosaic_tile_store< PixType >::priv
+::lookup( int tx, int ty )
+{
+  typename tile_map_t::iterator itr = tiles.find( tile_key( tx, ty ) );
+
+  if( itr == tiles.end() )
+  {
+    return NULL;
+  }
+
+  tile_entry& entry = itr->second;
+
+  if( !entry.image )
+  {
+    load( itr->first, entry );
+  }
+
+  entry.last_use = ++use_clock;
+  return &entry;
+}
+
+
+template< typename PixType >
+typename mosaic_tile_store< PixType >::priv::tile_entry&
+mosaic_tile_store< PixType >::priv
+::insert( int tx, int ty )
+{
+  tile_entry& entry = tiles[ tile_key( tx, ty ) ];
+
+  entry.image = tile_t( tile_size, tile_size, nplanes );
+  entry.image.fill( static_cast< PixType >( 0 ) );
+  entry.last_use = ++use_clock;
+  ++resident;
+
+  return entry;
+}
+
+
+template< typename PixType >
+bool
+mosaic_tile_store< PixType >::priv
+::load( const tile_key& key, tile_entry& entry )
+{
+  entry.image = tile_t( tile_size, tile_size, nplanes );
+  ++resident;
+
+  std::ifstream fin( tile_fn( key ).c_str(), std::ios::binary );
+  fin.read( reinterpret_cast< char* >( entry.image.top_left_ptr() ), tile_bytes() );
+
+  if( !fin )
+  {
+    LOG_ERROR( "Unable to read spilled mosaic tile " << tile_fn( key )
+               << ", its pixels are lost" );
+    entry.image.fill( static_cast< PixType >( 0 ) );
+    entry.dirty = true;
+    entry.on_disk = false;
+    return false;
+  }
+
+  entry.dirty = false;
+  return true;
+}
+
+
+// ----------------------------------------------------------------
+/** Release the memory of a tile, writing it out first if modified.
+ *
+ * The tile is kept in memory if it can not be written.
+ */
+template< typename PixType >
+bool
+mosaic_tile_store< PixType >::priv
+::spill( const tile_key& key, tile_entry& entry )
+{
+  if( entry.dirty || !entry.on_disk )
+  {
+    if( !make_spill_dir() )
+    {
+      return false;
+    }
+
+    std::ofstream fout( tile_fn( key ).c_str(), std::ios::binary );
+    fout.write( reinterpret_cast< const char* >( entry.image.top_left_ptr() ), tile_bytes() );
+    fout.close();
+
+    if( !fout )
+    {
+      LOG_ERROR( "Unable to write mosaic tile " << tile_fn( key ) );
+      return false;
+    }
+
+    entry.on_disk = true;
+    entry.dirty = false;
+  }
+
+  entry.image = tile_t();
+  --resident;
+  return true;
+}
+
+
+template< typename PixType >
+std::string
+mosaic_tile_store< PixType >::priv
+::tile_fn( const tile_key& key ) const
+{
+  std::string fn = "tile_" + boost::lexical_cast< std::string >( key.tx ) + "_"
+                 + boost::lexical_cast< std::string >( key.ty ) + ".raw";
+
+  return ( spill_dir / fn ).string();
+}
+
+
+template< typename PixType >
+bool
+mosaic_tile_store< PixType >::priv
+::make_spill_dir()
+{
+  if( !spill_dir.empty() )
+  {
+    return true;
+  }
+
+  boost::system::error_code ec;
+
+  boost::filesystem::path root( spill_root );
+
+  if( root.empty() )
+  {
+    root = boost::filesystem::temp_directory_path( ec );
+  }
+
+  boost::filesystem::path dir =
+    root / boost::filesystem::unique_path( "vidtk_mosaic_%%%%-%%%%-%%%%", ec );
+
+  if( ec || !boost::filesystem::create_directories( dir, ec ) )
+  {
+    LOG_ERROR( "Unable to create mosaic spill directory " << dir.string()
+               << ", keeping all tiles in memory" );
+    return false;
+  }
+
+  spill_dir = dir;
+  return true;
+}
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >::priv
+::remove_spill_dir()
+{
+  if( spill_dir.empty() )
+  {
+    return;
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::remove_all( spill_dir, ec );
+  spill_dir.clear();
+}
+
+
+// ----------------------------------------------------------------
+template< typename PixType >
+mosaic_tile_store< PixType >
+::mosaic_tile_store()
+  : d( new priv )
+{
+}
+
+
+template< typename PixType >
+mosaic_tile_store< PixType >
+::~mosaic_tile_store()
+{
+  d->remove_spill_dir();
+}
+
+
+template< typename PixType >
+bool
+mosaic_tile_store< PixType >
+::configure( unsigned tile_size,
+             unsigned nplanes,
+             size_t memory_budget,
+             const std::string& spill_dir )
+{
+  clear();
+
+  if( tile_size == 0 || nplanes == 0 )
+  {
+    LOG_ERROR( "Mosaic tiles must have a non-zero size and plane count" );
+    return false;
+  }
+
+  d->tile_size = tile_size;
+  d->nplanes = nplanes;
+  d->memory_budget = memory_budget;
+  d->spill_root = spill_dir;
+
+  return true;
+}
+
+
+template< typename PixType >
+unsigned
+mosaic_tile_store< PixType >
+::tile_size() const
+{
+  return d->tile_size;
+}
+
+
+template< typename PixType >
+unsigned
+mosaic_tile_store< PixType >
+::nplanes() const
+{
+  return d->nplanes;
+}
+
+
+template< typename PixType >
+int
+mosaic_tile_store< PixType >
+::tile_index( int p ) const
+{
+  const int ts = static_cast< int >( d->tile_size );
+  return ( p >= 0 ? p / ts : -( ( ts - 1 - p ) / ts ) );
+}
+
+
+template< typename PixType >
+typename mosaic_tile_store< PixType >::tile_t*
+mosaic_tile_store< PixType >
+::writable_tile( int tx, int ty )
+{
+  typename priv::tile_entry* entry = d->lookup( tx, ty );
+
+  if( !entry )
+  {
+    entry = &d->insert( tx, ty );
+  }
+
+  entry->dirty = true;
+  return &entry->image;
+}
+
+
+template< typename PixType >
+const typename mosaic_tile_store< PixType >::tile_t*
+mosaic_tile_store< PixType >
+::find_tile( int tx, int ty )
+{
+  typename priv::tile_entry* entry = d->lookup( tx, ty );
+  return ( entry ? &entry->image : NULL );
+}
+
+
+template< typename PixType >
+vgl_box_2d< int >
+mosaic_tile_store< PixType >
+::bounds() const
+{
+  vgl_box_2d< int > box;
+
+  if( d->tiles.empty() )
+  {
+    return box;
+  }
+
+  const int ts = static_cast< int >( d->tile_size );
+
+  int min_tx = d->tiles.begin()->first.tx;
+  int min_ty = d->tiles.begin()->first.ty;
+  int max_tx = min_tx;
+  int max_ty = min_ty;
+
+  for( typename priv::tile_map_t::const_iterator itr = d->tiles.begin();
+       itr != d->tiles.end(); ++itr )
+  {
+    min_tx = std::min( min_tx, itr->first.tx );
+    min_ty = std::min( min_ty, itr->first.ty );
+    max_tx = std::max( max_tx, itr->first.tx );
+    max_ty = std::max( max_ty, itr->first.ty );
+  }
+
+  box.add( vgl_point_2d< int >( min_tx * ts, min_ty * ts ) );
+  box.add( vgl_point_2d< int >( ( max_tx + 1 ) * ts - 1, ( max_ty + 1 ) * ts - 1 ) );
+  return box;
+}
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >
+::copy_to( int i0, int j0, tile_t& image )
+{
+  image.fill( static_cast< PixType >( 0 ) );
+
+  if( image.ni() == 0 || image.nj() == 0 )
+  {
+    return;
+  }
+
+  const int ts = static_cast< int >( d->tile_size );
+  const int i1 = i0 + static_cast< int >( image.ni() );
+  const int j1 = j0 + static_cast< int >( image.nj() );
+
+  for( int ty = tile_index( j0 ); ty <= tile_index( j1 - 1 ); ++ty )
+  {
+    const int lo_j = std::max( j0, ty * ts );
+    const int hi_j = std::min( j1, ( ty + 1 ) * ts );
+
+    for( int tx = tile_index( i0 ); tx <= tile_index( i1 - 1 ); ++tx )
+    {
+      const tile_t* tile = find_tile( tx, ty );
+
+      if( !tile )
+      {
+        continue;
+      }
+
+      const int lo_i = std::max( i0, tx * ts );
+      const int hi_i = std::min( i1, ( tx + 1 ) * ts );
+
+      tile_t dest = vil_crop( image, lo_i - i0, hi_i - lo_i, lo_j - j0, hi_j - lo_j );
+      vil_copy_reformat( vil_crop( *tile, lo_i - tx * ts, hi_i - lo_i,
+                                   lo_j - ty * ts, hi_j - lo_j ), dest );
+    }
+  }
+}
+
+
+namespace
+{
+
+template< typename PixType >
+bool
+is_all_zero( const vil_image_view< PixType >& image )
+{
+  for( unsigned p = 0; p < image.nplanes(); ++p )
+  {
+    for( unsigned j = 0; j < image.nj(); ++j )
+    {
+      for( unsigned i = 0; i < image.ni(); ++i )
+      {
+        if( image( i, j, p ) != 0 )
+        {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+
+struct less_first
+{
+  template< typename T >
+  bool operator()( const T& a, const T& b ) const
+  {
+    return a.first < b.first;
+  }
+};
+
+} // end anonymous namespace
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >
+::copy_from( int i0, int j0, const tile_t& image )
+{
+  if( image.ni() == 0 || image.nj() == 0 )
+  {
+    return;
+  }
+
+  const int ts = static_cast< int >( d->tile_size );
+  const int i1 = i0 + static_cast< int >( image.ni() );
+  const int j1 = j0 + static_cast< int >( image.nj() );
+
+  for( int ty = tile_index( j0 ); ty <= tile_index( j1 - 1 ); ++ty )
+  {
+    const int lo_j = std::max( j0, ty * ts );
+    const int hi_j = std::min( j1, ( ty + 1 ) * ts );
+
+    for( int tx = tile_index( i0 ); tx <= tile_index( i1 - 1 ); ++tx )
+    {
+      const int lo_i = std::max( i0, tx * ts );
+      const int hi_i = std::min( i1, ( tx + 1 ) * ts );
+
+      tile_t src = vil_crop( image, lo_i - i0, hi_i - lo_i, lo_j - j0, hi_j - lo_j );
+
+      if( d->tiles.find( typename priv::tile_key( tx, ty ) ) == d->tiles.end() &&
+          is_all_zero( src ) )
+      {
+        continue;
+      }
+
+      tile_t dest = vil_crop( *writable_tile( tx, ty ), lo_i - tx * ts, hi_i - lo_i,
+                              lo_j - ty * ts, hi_j - lo_j );
+      vil_copy_reformat( src, dest );
+    }
+  }
+}
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >
+::enforce_budget()
+{
+  if( d->resident * d->tile_bytes() <= d->memory_budget )
+  {
+    return;
+  }
+
+  std::vector< std::pair< unsigned long, typename priv::tile_map_t::iterator > > candidates;
+
+  for( typename priv::tile_map_t::iterator itr = d->tiles.begin();
+       itr != d->tiles.end(); ++itr )
+  {
+    if( itr->second.image )
+    {
+      candidates.push_back( std::make_pair( itr->second.last_use, itr ) );
+    }
+  }
+
+  // Least recently used first; uses are unique, so iterators are never compared
+  std::sort( candidates.begin(), candidates.end(), less_first() );
+
+  for( size_t i = 0; i < candidates.size() &&
+         d->resident * d->tile_bytes() > d->memory_budget; ++i )
+  {
+    if( !d->spill( candidates[i].second->first, candidates[i].second->second ) )
+    {
+      break;
+    }
+  }
+}
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >
+::remove_outside( const vgl_box_2d< int >& keep )
+{
+  const int ts = static_cast< int >( d->tile_size );
+
+  typename priv::tile_map_t::iterator itr = d->tiles.begin();
+
+  while( itr != d->tiles.end() )
+  {
+    const int min_i = itr->first.tx * ts;
+    const int min_j = itr->first.ty * ts;
+
+    if( !keep.is_empty() &&
+        min_i <= keep.max_x() && min_i + ts - 1 >= keep.min_x() &&
+        min_j <= keep.max_y() && min_j + ts - 1 >= keep.min_y() )
+    {
+      ++itr;
+      continue;
+    }
+
+    if( itr->second.on_disk )
+    {
+      boost::system::error_code ec;
+      boost::filesystem::remove( d->tile_fn( itr->first ), ec );
+    }
+
+    if( itr->second.image )
+    {
+      --d->resident;
+    }
+
+    itr = d->tiles.erase( itr );
+  }
+}
+
+
+template< typename PixType >
+void
+mosaic_tile_store< PixType >
+::clear()
+{
+  d->tiles.clear();
+  d->resident = 0;
+  d->remove_spill_dir();
+}
+
+
+template< typename PixType >
+size_t
+mosaic_tile_store< PixType >
+::tile_count() const
+{
+  return d->tiles.size();
+}
+
+
+template< typename PixType >
+size_t
+mosaic_tile_store< PixType >
+::resident_count() const
+{
+  return d->resident;
+}
+
+} // end namespace vidtk
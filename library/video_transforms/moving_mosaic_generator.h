@@ -16,6 +16,8 @@
 #include <utilities/external_settings.h>
 #include <utilities/homography.h>
 
+#include <video_transforms/mosaic_tile_store.h>
+
 namespace vidtk
 {
 
@@ -25,6 +27,32 @@ namespace vidtk
     unsigned, 3, \
     "3000 3000 3", \
     "Maximum resolution per mosaic page." ); \
+  add_param( \
+    mosaic_tile_size, \
+    unsigned, \
+    256, \
+    "Side length, in pixels, of the tiles the mosaic is stored in. Only " \
+    "tiles which images are added to are allocated." ); \
+  add_param( \
+    mosaic_memory_budget, \
+    unsigned, \
+    512, \
+    "Largest amount of memory, in megabytes, used by mosaic tiles. The " \
+    "least recently used tiles beyond it are written to disk." ); \
+  add_param( \
+    mosaic_spill_dir, \
+    std::string, \
+    "", \
+    "Directory to write mosaic tiles beyond the memory budget to. The " \
+    "system temporary directory is used if empty." ); \
+  add_param( \
+    mosaic_retain_margin, \
+    unsigned, \
+    3000, \
+    "Distance, in pixels, outside of the current mosaic page within which " \
+    "tiles are kept when the page moves. Tiles further away are discarded, " \
+    "which bounds the memory and disk used by long shots. If 0, all tiles " \
+    "are kept." ); \
   add_param( \
     mosaic_output_dir, \
     std::string, \
@@ -56,6 +84,12 @@ init_external_settings3( moving_mosaic_settings, settings_macro )
 #undef settings_macro
 
 /// \brief Generates image mosaics for a moving image sequence.
+///
+/// The mosaic is kept in a mosaic_tile_store, in which each shot has a
+/// fixed coordinate system. A mosaic page of mosaic_resolution pixels
+/// follows the camera; moving the page only moves its origin within the
+/// store, and pixels near it are retained for when the camera returns.
+/// Only a change of scale requires the page to be re-warped.
 template< typename PixType=vxl_byte, typename MosaicType=PixType >
 class moving_mosaic_generator
 {
@@ -90,7 +124,9 @@ private:
   moving_mosaic_settings settings;
 
   // Stored variables
-  mosaic_t mosaic;
+  mosaic_tile_store< MosaicType > tiles;
+  int origin_i;
+  int origin_j;
   transform_t ref_to_mosaic;
   unsigned mosaic_id;
   bool is_first;
@@ -100,12 +136,14 @@ private:
 
   // Helper functions
   mosaic_t new_mosaic();
+  mosaic_t current_page();
+  transform_t mosaic_to_page() const;
+  void discard_distant_tiles();
 
   void increment_mosaic_id();
   std::string get_mosaic_fn( bool with_path=true );
   void inpaint_mosaic( mosaic_t& image );
-  void output_mosaic( mosaic_t& image );
-  void reset_mosaic( mosaic_t& image );
+  void output_mosaic();
 };
 
 
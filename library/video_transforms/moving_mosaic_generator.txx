@@ -8,8 +8,6 @@
 #include <video_transforms/warp_image.h>
 #include <video_transforms/nearest_neighbor_inpaint.h>
 
-#include <utilities/point_view_to_region.h>
-
 #include <string>
 #include <algorithm>
 #include <map>
@@ -18,7 +16,6 @@
 #include <vector>
 #include <limits>
 
-#include <vil/vil_fill.h>
 #include <vil/vil_save.h>
 #include <vil/vil_copy.h>
 #include <vil/vil_plane.h>
@@ -53,6 +50,8 @@ moving_mosaic_generator< PixType, MosaicType >
 ::moving_mosaic_generator()
 {
   active_scene = false;
+  origin_i = 0;
+  origin_j = 0;
 }
 
 template< typename PixType, typename MosaicType >
@@ -61,7 +60,7 @@ moving_mosaic_generator< PixType, MosaicType >
 {
   if( active_scene )
   {
-    output_mosaic( mosaic );
+    output_mosaic();
   }
 }
 
@@ -72,14 +71,27 @@ moving_mosaic_generator< PixType, MosaicType >
 {
   if( active_scene )
   {
-    output_mosaic( mosaic );
+    output_mosaic();
   }
 
   settings = s;
-  mosaic = new_mosaic();
-  reset_mosaic( mosaic );
+
+  const unsigned planes = settings.mosaic_resolution[2] +
+    ( settings.mosaic_method == moving_mosaic_settings::CUM_AVERAGE ? 1 : 0 );
+
+  if( !tiles.configure( settings.mosaic_tile_size,
+                        planes,
+                        static_cast< size_t >( settings.mosaic_memory_budget ) << 20,
+                        settings.mosaic_spill_dir ) )
+  {
+    return false;
+  }
+
+  reset_mosaic();
   increment_mosaic_id();
 
+  origin_i = 0;
+  origin_j = 0;
   ref_to_mosaic.set_identity();
   active_scene = false;
   is_first = true;
@@ -411,15 +423,15 @@ moving_mosaic_generator< PixType, MosaicType >
   // Only reset mosaic image when required for efficiency
   if( new_shot && active_scene )
   {
-    output_mosaic( mosaic );
+    output_mosaic();
     increment_mosaic_id();
-    reset_mosaic( mosaic );
+    reset_mosaic();
     active_scene = false;
   }
 
   // On first image of new shot compute initial translation ref_to_mosaic
-  const unsigned mi = mosaic.ni();
-  const unsigned mj = mosaic.nj();
+  const unsigned mi = settings.mosaic_resolution[0];
+  const unsigned mj = settings.mosaic_resolution[1];
 
   if( new_shot )
   {
@@ -429,6 +441,9 @@ moving_mosaic_generator< PixType, MosaicType >
     ref_to_mosaic.set_identity();
     ref_to_mosaic.set_translation( oi, oj );
 
+    origin_i = 0;
+    origin_j = 0;
+
     is_first = true;
   }
   else
@@ -460,7 +475,8 @@ moving_mosaic_generator< PixType, MosaicType >
     point_t p = transform * cnrs[i];
     src_on_mosaic_bbox.add( p );
 
-    if( p.x() < 0 || p.x() > mi || p.y() < 0 || p.y() > mj )
+    if( p.x() < origin_i || p.x() > origin_i + static_cast< int >( mi ) ||
+        p.y() < origin_j || p.y() > origin_j + static_cast< int >( mj ) )
     {
       adjustment_required = true;
     }
@@ -496,75 +512,55 @@ moving_mosaic_generator< PixType, MosaicType >
       cur_to_new.set_identity();
       cur_to_new.set_translation( oi, oj );
 
-      // Generate old mosaic to new mosaic homography
-      transform_t cur_to_old = transform;
+      // Generate old page to new page homography
+      transform_t cur_to_old = mosaic_to_page() * transform;
       transform_t new_to_old = cur_to_old * cur_to_new.get_inverse();
+      transform_t mosaic_to_new = new_to_old.get_inverse() * mosaic_to_page();
 
       // Output old mosaic
-      output_mosaic( mosaic );
+      output_mosaic();
       increment_mosaic_id();
 
-      // Warp old mosaic to new mosaic
-      mosaic_t updated_mosaic = new_mosaic();
+      // Warp old page to new page, pixels outside of the old page are
+      // dropped since they can not be re-indexed at the new scale
+      mosaic_t old_page = current_page();
+      mosaic_t updated_page = new_mosaic();
 
       warp_image_parameters param;
       param.set_fill_unmapped( true );
       param.set_unmapped_value( 0.0 );
       param.set_interpolator( warp_image_parameters::NEAREST );
 
-      warp_image( mosaic, updated_mosaic, new_to_old, param );
-      mosaic = updated_mosaic;
+      warp_image( old_page, updated_page, new_to_old, param );
+
+      reset_mosaic();
+      origin_i = 0;
+      origin_j = 0;
+      tiles.copy_from( origin_i, origin_j, updated_page );
 
       // Update stored transform, ref_to_mosaic is ref to mosaic before
-      ref_to_mosaic = new_to_old.get_inverse() * ref_to_mosaic;
+      ref_to_mosaic = mosaic_to_new * ref_to_mosaic;
       transform = ref_to_mosaic * homog.get_transform();
       transform_updated = true;
     }
-    else // Standard case, we are doing a simple optimized translation
-    {    // of the old mosaic
+    else // Standard case, we are doing a simple translation of the page,
+    {    // which only moves its origin within the tile store
 
       // Estimate optimal translation values
       point_t centroid = transform * homog_point_t( si / 2, sj / 2 );
 
-      int oi = mi / 2 - centroid.x();
-      int oj = mj / 2 - centroid.y();
+      int oi = origin_i + static_cast< int >( mi / 2 ) - centroid.x();
+      int oj = origin_j + static_cast< int >( mj / 2 ) - centroid.y();
 
       if( oi != 0 || oj != 0 )
       {
-        output_mosaic( mosaic );
+        output_mosaic();
         increment_mosaic_id();
 
-        mosaic_t trnsl_mosaic = new_mosaic();
-        reset_mosaic( trnsl_mosaic );
-
-        // Update matrices
-        transform_t new_ref_to_mosaic;
-        new_ref_to_mosaic.set_identity();
-        new_ref_to_mosaic.set_translation( oi, oj );
-        transform = new_ref_to_mosaic * transform;
-        ref_to_mosaic = new_ref_to_mosaic * ref_to_mosaic;
-
-        // Switch to use new mosaic
-        vgl_box_2d< int > boundaries( 0, mosaic.ni(), 0, mosaic.nj() );
-        vgl_box_2d< int > old_box( 0, mosaic.ni(), 0, mosaic.nj() );
-        vgl_box_2d< int > new_box( 0, mosaic.ni(), 0, mosaic.nj() );
+        origin_i -= oi;
+        origin_j -= oj;
 
-        old_box.set_centroid_x( old_box.centroid_x() - oi );
-        old_box.set_centroid_y( old_box.centroid_y() - oj );
-
-        new_box.set_centroid_x( new_box.centroid_x() + oi );
-        new_box.set_centroid_y( new_box.centroid_y() + oj );
-
-        old_box = vgl_intersection( boundaries, old_box );
-        new_box = vgl_intersection( boundaries, new_box );
-
-        mosaic_t old_region = point_view_to_region( mosaic, old_box );
-        mosaic_t new_region = point_view_to_region( trnsl_mosaic, new_box );
-
-        vil_copy_reformat( old_region, new_region );
-        mosaic = trnsl_mosaic;
-
-        transform_updated = true;
+        discard_distant_tiles();
       }
     }
 
@@ -591,7 +587,7 @@ moving_mosaic_generator< PixType, MosaicType >
     fout << ts.frame_number() << " " << ts.time() << std::endl;
     fout << get_mosaic_fn( false ) << std::endl;
     fout.precision( 20 );
-    fout << transform << std::endl;
+    fout << mosaic_to_page() * transform << std::endl;
 
     fout.close();
   }
@@ -618,7 +614,8 @@ moving_mosaic_generator< PixType, MosaicType >
     return -1.0;
   }
 
-  box_t mosaic_boundaries( 0, mi - 1, 0, mj - 1 );
+  box_t mosaic_boundaries( origin_i, origin_i + static_cast< int >( mi ) - 1,
+                          origin_j, origin_j + static_cast< int >( mj ) - 1 );
   box_t intersection = vgl_intersection( src_on_mosaic_bbox, mosaic_boundaries );
 
   bool point_intercept = false;
@@ -644,15 +641,6 @@ moving_mosaic_generator< PixType, MosaicType >
   const int end_j   = static_cast<int>( std::floor( intersection.max_y() + 1 ) );
   const int end_i   = static_cast<int>( std::floor( intersection.max_x() + 1 ) );
 
-  // Get pointers to image data and retrieve required step values
-  MosaicType* row_start              = mosaic.top_left_ptr();
-  const std::ptrdiff_t mosaic_j_step = mosaic.jstep();
-  const std::ptrdiff_t mosaic_i_step = mosaic.istep();
-  const std::ptrdiff_t mosaic_p_step = mosaic.planestep();
-
-  // Adjust mosaicination itr position to start of bounding box
-  row_start = row_start + start_j * mosaic_j_step + mosaic_i_step * start_i;
-
   // Precompute partial column homography values
   int factor_size = end_i - start_i;
 
@@ -669,42 +657,67 @@ moving_mosaic_generator< PixType, MosaicType >
     col_factors[ i ] = col * homog_col_1 + homog_col_3;
   }
 
-  // Perform scan of boxed region
-  for( int j = start_j; j < end_j; j++, row_start += mosaic_j_step )
+  const int tile_size = static_cast< int >( tiles.tile_size() );
+
+  // Perform scan of boxed region, one tile wide segment of a row at a time
+  for( int j = start_j; j < end_j; j++ )
   {
-    // mosaic_col_ptr now points to the start of the BB region for this row
-    MosaicType* mosaic_col_ptr = row_start;
+    const int ty = tiles.tile_index( j );
+    const int tile_j = j - ty * tile_size;
 
     // Precompute row homography partials for this row
     const vnl_double_3 row_factor = homog_col_2 * static_cast<double>( j );
 
-    // Get pointer to start of precomputed column values
-    vnl_double_3* col_factor_ptr = &col_factors[0];
-
-    // Iterate through each column in the BB
-    for( int i = start_i; i < end_i; i++, col_factor_ptr++, mosaic_col_ptr += mosaic_i_step )
+    for( int seg_start = start_i; seg_start < end_i; )
     {
-      // Compute homography mapping for this point (mosaic->src)
-      vnl_double_3 pt = row_factor + (*col_factor_ptr);
+      const int tx = tiles.tile_index( seg_start );
+      const int seg_end = std::min( end_i, ( tx + 1 ) * tile_size );
 
-      // Normalize by dividing out third term
-      double& x = pt[0];
-      double& y = pt[1];
-      double& w = pt[2];
+      // Tiles are only allocated once a pixel maps into the source image
+      MosaicType* tile_row = NULL;
+      std::ptrdiff_t mosaic_i_step = 0;
+      std::ptrdiff_t mosaic_p_step = 0;
 
-      x /= w;
-      y /= w;
+      // Get pointer to start of precomputed column values
+      vnl_double_3* col_factor_ptr = &col_factors[ seg_start - start_i ];
 
-      // Check if we can perform interp at this point
-      if( x >= src_ni_low_bound && y >= src_nj_low_bound && x <= src_ni_up_bound && y <= src_nj_up_bound )
+      // Iterate through each column in the segment
+      for( int i = seg_start; i < seg_end; i++, col_factor_ptr++ )
       {
-        (*interp)( mosaic_col_ptr, src_start,
-                   x, y, src_i_step, src_j_step,
-                   sp, src_p_step, mosaic_p_step );
+        // Compute homography mapping for this point (mosaic->src)
+        vnl_double_3 pt = row_factor + (*col_factor_ptr);
+
+        // Normalize by dividing out third term
+        double& x = pt[0];
+        double& y = pt[1];
+        double& w = pt[2];
+
+        x /= w;
+        y /= w;
+
+        // Check if we can perform interp at this point
+        if( x >= src_ni_low_bound && y >= src_nj_low_bound && x <= src_ni_up_bound && y <= src_nj_up_bound )
+        {
+          if( !tile_row )
+          {
+            mosaic_t* tile = tiles.writable_tile( tx, ty );
+            mosaic_i_step = tile->istep();
+            mosaic_p_step = tile->planestep();
+            tile_row = tile->top_left_ptr() + tile_j * tile->jstep();
+          }
+
+          (*interp)( tile_row + ( i - tx * tile_size ) * mosaic_i_step, src_start,
+                     x, y, src_i_step, src_j_step,
+                     sp, src_p_step, mosaic_p_step );
+        }
       }
+
+      seg_start = seg_end;
     }
   }
 
+  tiles.enforce_budget();
+
   // Set active scene flag if homography is non-identity
   if( !homog.get_transform().is_identity() )
   {
@@ -739,20 +752,27 @@ moving_mosaic_generator< PixType, MosaicType >
   unsigned const dni = output_image.ni();
   unsigned const dnj = output_image.nj();
 
-  unsigned const sni = mosaic.ni();
-  unsigned const snj = mosaic.nj();
   unsigned const snp = settings.mosaic_resolution[2];
 
+  // The source is every tile written so far, which includes pixels
+  // outside of the current page
+  const vgl_box_2d< int > stored = tiles.bounds();
+
+  if( stored.is_empty() )
+  {
+    return false;
+  }
+
   typedef vgl_homg_point_2d<double> homog_point_t;
   typedef vgl_point_2d<double> point_t;
   typedef vgl_box_2d<double> box_t;
 
   box_t src_on_dest_bounding_box;
 
-  homog_point_t cnrs[4] = { homog_point_t( 0, 0 ),
-                            homog_point_t( sni - 1, 0 ),
-                            homog_point_t( sni - 1, snj - 1 ),
-                            homog_point_t( 0, snj - 1 ) };
+  homog_point_t cnrs[4] = { homog_point_t( stored.min_x(), stored.min_y() ),
+                            homog_point_t( stored.max_x(), stored.min_y() ),
+                            homog_point_t( stored.max_x(), stored.max_y() ),
+                            homog_point_t( stored.min_x(), stored.max_y() ) };
 
   for( unsigned i = 0; i < 4; ++i )
   {
@@ -776,10 +796,10 @@ moving_mosaic_generator< PixType, MosaicType >
     return false;
   }
 
-  int src_ni_low_bound = 0;
-  int src_nj_low_bound = 0;
-  int src_ni_up_bound  = sni - 1;
-  int src_nj_up_bound  = snj - 1;
+  int src_ni_low_bound = stored.min_x();
+  int src_nj_low_bound = stored.min_y();
+  int src_ni_up_bound  = stored.max_x();
+  int src_nj_up_bound  = stored.max_y();
 
   const int start_j = static_cast<int>( std::floor( intersection.min_y() ) );
   const int start_i = static_cast<int>( std::floor( intersection.min_x() ) );
@@ -788,15 +808,18 @@ moving_mosaic_generator< PixType, MosaicType >
 
   const bool* mask_row             = input_mask.top_left_ptr();
   PixType* dest_row                = output_image.top_left_ptr();
-  const MosaicType* src_start      = mosaic.top_left_ptr();
   const std::ptrdiff_t mask_j_step = input_mask.jstep();
   const std::ptrdiff_t dest_j_step = output_image.jstep();
-  const std::ptrdiff_t src_j_step  = mosaic.jstep();
   const std::ptrdiff_t mask_i_step = input_mask.istep();
   const std::ptrdiff_t dest_i_step = output_image.istep();
-  const std::ptrdiff_t src_i_step  = mosaic.istep();
   const std::ptrdiff_t dest_p_step = output_image.planestep();
-  const std::ptrdiff_t src_p_step  = mosaic.planestep();
+
+  // Tile of the last source pixel, neighboring pixels usually share it
+  const int tile_size = static_cast< int >( tiles.tile_size() );
+  const mosaic_t* tile = NULL;
+  int tile_x = 0;
+  int tile_y = 0;
+  bool have_tile = false;
 
   // Adjust destination itr position to start of bounding box
   dest_row = dest_row + start_j * dest_j_step + dest_i_step * start_i;
@@ -854,12 +877,31 @@ moving_mosaic_generator< PixType, MosaicType >
       // Check if we can perform interp at this point
       if( x >= src_ni_low_bound && y >= src_nj_low_bound && x <= src_ni_up_bound && y <= src_nj_up_bound )
       {
+        const int ix = static_cast<int>( std::floor( x + 0.5 ) );
+        const int iy = static_cast<int>( std::floor( y + 0.5 ) );
+        const int tx = tiles.tile_index( ix );
+        const int ty = tiles.tile_index( iy );
+
+        if( !have_tile || tx != tile_x || ty != tile_y )
+        {
+          tile = tiles.find_tile( tx, ty );
+          tile_x = tx;
+          tile_y = ty;
+          have_tile = true;
+        }
+
+        if( !tile )
+        {
+          continue;
+        }
+
         // For each channel interpolate from src
         PixType* dest_ptr = dest_col_ptr;
 
         const MosaicType* src_ptr =
-          src_start + static_cast<int>( x + 0.5 ) * src_i_step
-                    + static_cast<int>( y + 0.5 ) * src_j_step;
+          tile->top_left_ptr() + ( ix - tx * tile_size ) * tile->istep()
+                               + ( iy - ty * tile_size ) * tile->jstep();
+        const std::ptrdiff_t src_p_step = tile->planestep();
 
         if( *src_ptr != 0 )
         {
@@ -874,6 +916,8 @@ moving_mosaic_generator< PixType, MosaicType >
     }
   }
 
+  tiles.enforce_budget();
+
   return true;
 }
 
@@ -889,12 +933,45 @@ moving_mosaic_generator< PixType, MosaicType >
        moving_mosaic_settings::CUM_AVERAGE ? 1 : 0 ) );
 }
 
+template< typename PixType, typename MosaicType >
+vil_image_view< MosaicType >
+moving_mosaic_generator< PixType, MosaicType >
+::current_page()
+{
+  mosaic_t page = new_mosaic();
+  tiles.copy_to( origin_i, origin_j, page );
+  return page;
+}
+
+template< typename PixType, typename MosaicType >
+vgl_h_matrix_2d< double >
+moving_mosaic_generator< PixType, MosaicType >
+::mosaic_to_page() const
+{
+  transform_t result;
+  result.set_identity();
+  result.set_translation( -origin_i, -origin_j );
+  return result;
+}
+
 template< typename PixType, typename MosaicType >
 void
 moving_mosaic_generator< PixType, MosaicType >
-::reset_mosaic( mosaic_t& image )
+::discard_distant_tiles()
 {
-  vil_fill( image, static_cast< MosaicType>( 0 ) );
+  const int margin = static_cast< int >( settings.mosaic_retain_margin );
+
+  if( margin == 0 )
+  {
+    return;
+  }
+
+  vgl_box_2d< int > keep( origin_i - margin,
+                          origin_i + static_cast< int >( settings.mosaic_resolution[0] ) - 1 + margin,
+                          origin_j - margin,
+                          origin_j + static_cast< int >( settings.mosaic_resolution[1] ) - 1 + margin );
+
+  tiles.remove_outside( keep );
 }
 
 template< typename PixType, typename MosaicType >
@@ -935,19 +1012,23 @@ moving_mosaic_generator< PixType, MosaicType >
 template< typename PixType, typename MosaicType >
 void
 moving_mosaic_generator< PixType, MosaicType >
-::output_mosaic( mosaic_t& image )
+::output_mosaic()
 {
   if( settings.mosaic_output_dir.empty() )
   {
     return;
   }
 
+  mosaic_t page = current_page();
+
   if( settings.inpaint_output_mosaics )
   {
-    inpaint_mosaic( image );
+    inpaint_mosaic( page );
+    tiles.copy_from( origin_i, origin_j, page );
+    tiles.enforce_budget();
   }
 
-  vil_save( image, get_mosaic_fn( true ).c_str() );
+  vil_save( page, get_mosaic_fn( true ).c_str() );
 }
 
 void
@@ -1087,7 +1168,15 @@ void
 moving_mosaic_generator< PixType, MosaicType >
 ::inpaint_mosaic()
 {
-  inpaint_mosaic( mosaic );
+  if( tiles.tile_count() == 0 )
+  {
+    return;
+  }
+
+  mosaic_t page = current_page();
+  inpaint_mosaic( page );
+  tiles.copy_from( origin_i, origin_j, page );
+  tiles.enforce_budget();
 }
 
 template< typename PixType, typename MosaicType >
@@ -1183,7 +1272,7 @@ void
 moving_mosaic_generator< PixType, MosaicType >
 ::reset_mosaic()
 {
-  reset_mosaic( mosaic );
+  tiles.clear();
 }
 
 } // end namespace vidtk
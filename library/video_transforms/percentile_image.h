@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -23,7 +23,9 @@ void sample_and_sort_image( const vil_image_view< PixType >& src,
                             unsigned sampling_points = 1000 );
 
 
-/// Returns the specified image by sampling a certain number of points in it.
+/// Returns the specified image percentiles by sampling a certain number of
+/// points in it, or from every pixel if sampling_points is 0. Results are
+/// exact for the sampled points, see image_order_statistics.
 template <typename PixType>
 void get_image_percentiles( const vil_image_view< PixType >& src,
                             const std::vector< double >& percentiles,
@@ -32,7 +34,8 @@ void get_image_percentiles( const vil_image_view< PixType >& src,
 
 
 /// Calculate the specified percentiles from the input image and generate
-/// binary output masks for each percentile.
+/// binary output masks for each percentile. If sampling_points is 0, the
+/// percentiles are computed from every pixel.
 template<typename PixType>
 void percentile_threshold_above( const vil_image_view< PixType >& src,
                                  const std::vector< double >& percentiles,
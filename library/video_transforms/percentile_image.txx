@@ -1,11 +1,13 @@
 /*ckwg +5
- * Copyright 2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include "percentile_image.h"
 
+#include <video_transforms/image_statistics.h>
+
 #include <vil/vil_math.h>
 #include <vil/vil_plane.h>
 #include <vil/algo/vil_threshold.h>
@@ -59,20 +61,11 @@ void get_image_percentiles( const vil_image_view< PixType >& src,
 {
   LOG_ASSERT( percentiles.size() > 0, "No percentiles provided" );
   LOG_ASSERT( src.size() > 0, "Image is empty" );
+  LOG_ASSERT( src.nplanes() == 1, "Input must contain a single plane" );
 
-  std::vector< PixType > sorted_samples;
-  sample_and_sort_image( src, sorted_samples, sampling_points );
-  dst.resize( percentiles.size() );
-
-  double sampling_points_m1 = static_cast<double>(sorted_samples.size()-1);
-
-  for( unsigned i = 0; i < percentiles.size(); i++ )
-  {
-    LOG_ASSERT( percentiles[i] >= 0 && percentiles[i] <= 1.0, "Percentile must be in range [0,1]" );
-
-    unsigned ind = static_cast<unsigned>( sampling_points_m1 * percentiles[i] + 0.5 );
-    dst[i] = sorted_samples[ind];
-  }
+  image_order_statistics< PixType > stats;
+  stats.compute( src, 0, sampling_points );
+  stats.percentiles( percentiles, dst );
 }
 
 template<typename PixType>
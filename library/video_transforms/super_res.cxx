@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -8,8 +8,17 @@
 #include "super_res.h"
 #include "adjoint_image_derivs.h"
 
+#include <utilities/compute_pool.h>
+
 #include <vil/vil_math.h>
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
 namespace vidtk
 {
 
@@ -18,23 +27,63 @@ namespace vidtk
 //A Convex Approach for Variational Super-Resolution.
 //DAGM-Symposium, volume 6376 of Lecture Notes in Computer Science, page 313-322. Springer, (2010)
 
-/// Gradient ascent and projection on the dual variable p
-void dual_step_p(const vil_image_view<double> &u_bar,
-                 vil_image_view<double> &p,
-                 const super_res_params &srp)
+namespace
+{
+
+// Minimum number of rows of the super resolved image updated by each task
+const unsigned min_rows_per_task = 16;
+
+
+/// Split the rows of the super resolved image into ranges for each task
+std::vector<unsigned> row_strips(unsigned nj)
+{
+  const unsigned budget = compute_pool::instance()->core_budget();
+  const unsigned strips = std::max(1u, std::min(budget, nj / min_rows_per_task));
+
+  std::vector<unsigned> starts;
+  for (unsigned s = 0; s <= strips; s++)
+  {
+    starts.push_back((nj * s) / strips);
+  }
+  return starts;
+}
+
+
+/// Gradient ascent and projection on rows [j0,j1) of the dual variable p.
+/// The forward gradient, the update and the truncation are fused in one pass.
+void dual_step_p_rows(const vil_image_view<double> &u_bar,
+                      vil_image_view<double> &p,
+                      const super_res_params &srp,
+                      unsigned j0, unsigned j1)
 {
   const double denom = 1.0 + (srp.sigma * srp.epsilon_reg) / srp.lambda;
-  vil_image_view<double> work;
-  forward_gradient(u_bar, work);
-  vil_math_add_image_fraction(p, 1.0/denom, work, srp.sigma/denom);
+  const double p_scale = 1.0/denom;
+  const double grad_scale = srp.sigma/denom;
+
+  const unsigned ni = u_bar.ni(), nj = u_bar.nj();
+  const std::ptrdiff_t istepU = u_bar.istep(), jstepU = u_bar.jstep();
+  const std::ptrdiff_t istepP = p.istep(), jstepP = p.jstep(), pstepP = p.planestep();
 
-  for (unsigned int j = 0; j < srp.s_nj; j++)
+  for (unsigned k = 0; k < u_bar.nplanes(); k++)
   {
-    for (unsigned int i = 0; i < srp.s_ni; i++)
+    const double *rowU = u_bar.top_left_ptr() + k * u_bar.planestep() + j0 * jstepU;
+    double *rowX = p.top_left_ptr() + 2 * k * pstepP + j0 * jstepP;
+    double *rowY = rowX + pstepP;
+
+    for (unsigned j = j0; j < j1; j++, rowU += jstepU, rowX += jstepP, rowY += jstepP)
     {
-      for (unsigned int k = 0; k < u_bar.nplanes(); k++)
+      // the gradient is zero across the last row and column
+      const std::ptrdiff_t below = (j + 1 < nj) ? jstepU : 0;
+
+      for (unsigned i = 0; i < ni; i++)
       {
-        double &x = p(i,j,2*k), &y = p(i,j,2*k+1);
+        const double *pixelU = rowU + i * istepU;
+        const double gx = (i + 1 < ni) ? pixelU[istepU] - *pixelU : 0.0;
+        const double gy = pixelU[below] - *pixelU;
+
+        double &x = rowX[i * istepP], &y = rowY[i * istepP];
+        x = p_scale * x + grad_scale * gx;
+        y = p_scale * y + grad_scale * gy;
 
         //truncate vectors
         const double mag = sqrt(x*x + y*y)/srp.lambda;
@@ -49,6 +98,97 @@ void dual_step_p(const vil_image_view<double> &u_bar,
 }
 
 
+/// Gradient descent on rows [j0,j1) of the primal variable u.
+/// The backward divergence of p, the data term and the extrapolation of
+/// u_bar are fused in one pass, and u is updated in place. The squared norms
+/// of the change in u and of the new u are added to \a change and \a norm.
+void primal_step_u_rows(const vil_image_view<double> &sum_super_q,
+                        const vil_image_view<double> &p,
+                        vil_image_view<double> &u,
+                        vil_image_view<double> &u_bar,
+                        const super_res_params &srp,
+                        unsigned j0, unsigned j1,
+                        double *change, double *norm)
+{
+  const double sf_2 = 1.0/(srp.scale_factor * srp.scale_factor);
+  const double q_scale = -srp.tau * sf_2;
+
+  const unsigned ni = u.ni(), nj = u.nj();
+  const std::ptrdiff_t istepP = p.istep(), jstepP = p.jstep(), pstepP = p.planestep();
+  const std::ptrdiff_t istepQ = sum_super_q.istep(), jstepQ = sum_super_q.jstep();
+  const std::ptrdiff_t istepU = u.istep(), jstepU = u.jstep();
+  const std::ptrdiff_t istepB = u_bar.istep(), jstepB = u_bar.jstep();
+
+  double sum_change = 0.0, sum_norm = 0.0;
+
+  for (unsigned k = 0; k < u.nplanes(); k++)
+  {
+    const double *rowX = p.top_left_ptr() + 2 * k * pstepP + j0 * jstepP;
+    const double *rowY = rowX + pstepP;
+    const double *rowQ = sum_super_q.top_left_ptr() + k * sum_super_q.planestep() + j0 * jstepQ;
+    double *rowU = u.top_left_ptr() + k * u.planestep() + j0 * jstepU;
+    double *rowB = u_bar.top_left_ptr() + k * u_bar.planestep() + j0 * jstepB;
+
+    for (unsigned j = j0; j < j1; j++,
+         rowX += jstepP, rowY += jstepP, rowQ += jstepQ, rowU += jstepU, rowB += jstepB)
+    {
+      for (unsigned i = 0; i < ni; i++)
+      {
+        const double *pixelX = rowX + i * istepP;
+        const double *pixelY = rowY + i * istepP;
+
+        double d;
+        if (i == 0)
+          d = *pixelX;
+        else if (i < ni - 1)
+          d = *pixelX - pixelX[-istepP];
+        else
+          d = -pixelX[-istepP];
+        if (j == 0)
+          d += *pixelY;
+        else if (j < nj - 1)
+          d += *pixelY - pixelY[-jstepP];
+        else
+          d += -pixelY[-jstepP];
+
+        const double step = srp.tau * d + q_scale * rowQ[i * istepQ];
+        double &pixelU = rowU[i * istepU];
+        const double updated = pixelU + step;
+
+        rowB[i * istepB] = 2.0 * updated - pixelU;
+        pixelU = updated;
+
+        sum_change += step * step;
+        sum_norm += updated * updated;
+      }
+    }
+  }
+
+  *change = sum_change;
+  *norm = sum_norm;
+}
+
+} // end anonymous namespace
+
+
+/// Gradient ascent and projection on the dual variable p
+void dual_step_p(const vil_image_view<double> &u_bar,
+                 vil_image_view<double> &p,
+                 const super_res_params &srp)
+{
+  const std::vector<unsigned> strips = row_strips(u_bar.nj());
+
+  std::vector<compute_pool::task_t> tasks;
+  for (unsigned s = 0; s + 1 < strips.size(); s++)
+  {
+    tasks.push_back(boost::bind(dual_step_p_rows, boost::cref(u_bar), boost::ref(p),
+                                boost::cref(srp), strips[s], strips[s+1]));
+  }
+
+  compute_pool::instance()->run(tasks, "super_res");
+}
+
+
 /// Gradient ascent and projection on the dual variables q
 void dual_step_q(const std::vector<vil_image_view<double> > &frames,
                  const std::vector<vidtk::adjoint_image_ops_func<double> > &warps,
@@ -88,14 +228,14 @@ void dual_step_q(const std::vector<vil_image_view<double> > &frames,
 
 
 /// Perform a gradient descent step on the primal variable u
-void primal_step_u(const std::vector<vil_image_view<double> > &q,
-                   const std::vector<adjoint_image_ops_func<double> > &warps,
-                   const vil_image_view<double> &p,
-                   vil_image_view<double> &u,
-                   vil_image_view<double> &u_bar,
-                   const super_res_params &srp)
+/// \returns the norm of the change in u relative to the norm of the new u
+double primal_step_u(const std::vector<vil_image_view<double> > &q,
+                     const std::vector<adjoint_image_ops_func<double> > &warps,
+                     const vil_image_view<double> &p,
+                     vil_image_view<double> &u,
+                     vil_image_view<double> &u_bar,
+                     const super_res_params &srp)
 {
-  const double sf_2 = 1.0/(srp.scale_factor * srp.scale_factor);
   vil_image_view<double> sum_super_q(srp.s_ni, srp.s_nj, u.nplanes());
   sum_super_q.fill(0.0);
   vil_image_view<double> super_q(srp.s_ni, srp.s_nj, u.nplanes()), temp;
@@ -106,13 +246,27 @@ void primal_step_u(const std::vector<vil_image_view<double> > &q,
     vil_math_image_sum(sum_super_q, super_q, sum_super_q);
   }
 
-  vil_image_view<double> work;
-  backward_divergence(p, work);
-  vil_math_add_image_fraction(work, srp.tau, sum_super_q, -srp.tau * sf_2);
-  vil_math_image_sum(u, work, work);
-  u_bar.deep_copy(work);
-  vil_math_add_image_fraction(u_bar, 2.0, u, -1.0);
-  std::swap(u, work);
+  const std::vector<unsigned> strips = row_strips(u.nj());
+  std::vector<double> change(strips.size() - 1), norm(strips.size() - 1);
+
+  std::vector<compute_pool::task_t> tasks;
+  for (unsigned s = 0; s + 1 < strips.size(); s++)
+  {
+    tasks.push_back(boost::bind(primal_step_u_rows, boost::cref(sum_super_q), boost::cref(p),
+                                boost::ref(u), boost::ref(u_bar), boost::cref(srp),
+                                strips[s], strips[s+1], &change[s], &norm[s]));
+  }
+
+  compute_pool::instance()->run(tasks, "super_res");
+
+  double total_change = 0.0, total_norm = 0.0;
+  for (unsigned s = 0; s < change.size(); s++)
+  {
+    total_change += change[s];
+    total_norm += norm[s];
+  }
+
+  return (total_norm > 0.0) ? std::sqrt(total_change / total_norm) : 0.0;
 }
 
 
@@ -200,7 +354,7 @@ super_resolve(const std::vector<vil_image_view<double> > &frames,
       }
 
       boost::lock_guard<boost::mutex> lock(srm->m_data_);
-      primal_step_u(q, warps, p, u, u_bar, srp);
+      srm->relative_change_ = primal_step_u(q, warps, p, u, u_bar, srp);
       (*itr)++;
     }
     else
@@ -224,6 +378,7 @@ void super_resolution_monitor::get_update(update_data &update)
   boost::lock_guard<boost::mutex> lock(m_data_);
   update.current_result.deep_copy(*current_result_);
   update.num_iterations = *num_iterations_;
+  update.relative_change = relative_change_;
 }
 
 
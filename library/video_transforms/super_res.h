@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -50,6 +50,8 @@ void super_resolve(const std::vector<vil_image_view<double> > &frames,
 /// will be called every specified number of iterations (interval) with the current
 /// super resolution result and iteration number.  Intermediate results can also be
 /// asynchronously accessed by the get_update function whenever desired.
+/// Each update also reports the relative change of the result in the last
+/// iteration, which can be used to follow the convergence of the solver.
 class super_resolution_monitor
 {
 public:
@@ -58,6 +60,10 @@ public:
   {
     vil_image_view<double> current_result;
     unsigned int num_iterations;
+
+    /// Norm of the change in the result in the last iteration,
+    /// relative to the norm of the result
+    double relative_change;
   };
 
   super_resolution_monitor(boost::function<void (update_data)> callback,
@@ -65,7 +71,8 @@ public:
                            boost::shared_ptr<bool> interrupted) : callback_(callback),
                                                                   interval_(interval),
                                                                   interrupted_(interrupted),
-                                                                  current_result_(NULL) {}
+                                                                  current_result_(NULL),
+                                                                  relative_change_(0.0) {}
 
   /// Get deep copy of the current image and iteration
   void get_update(update_data &update);
@@ -93,6 +100,7 @@ private:
   //Cannot rely on internal pointers because data is swapped in u's update
   vil_image_view<double> *current_result_;
   boost::shared_ptr<unsigned int> num_iterations_;
+  double relative_change_;
 };
 
 
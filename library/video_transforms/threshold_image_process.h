@@ -59,6 +59,7 @@ private:
   threshold_condition condition_;
   bool persist_output_;
   std::vector<double> percentiles_;
+  unsigned percentile_sampling_points_;
 
   vil_image_view<bool> output_image_;
 };
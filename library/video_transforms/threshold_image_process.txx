@@ -31,7 +31,8 @@ threshold_image_process<PixType>
     src_image_( NULL ),
     type_( ABSOLUTE ),
     condition_ ( ABOVE ),
-    persist_output_( true )
+    persist_output_( true ),
+    percentile_sampling_points_( 1000 )
 {
   config_.add_parameter( "persist_output",
                          "false",
@@ -61,6 +62,10 @@ threshold_image_process<PixType>
                          "",
                          "A comma seperated list of percentile thresholds in the range "
                          "0.0 to 1.0." );
+  config_.add_parameter( "percentile_sampling_points",
+                         "1000",
+                         "Number of evenly spaced pixels used to estimate the percentile "
+                         "thresholds. If 0, the exact percentiles of all pixels are used." );
 }
 
 
@@ -116,6 +121,7 @@ threshold_image_process<PixType>
 
       std::string percentile_list;
       percentile_list = blk.get<std::string>( "percentiles" );
+      percentile_sampling_points_ = blk.get<unsigned>( "percentile_sampling_points" );
       std::stringstream parser( percentile_list );
       double entry;
       while( parser >> entry )
@@ -208,7 +214,8 @@ threshold_image_process<PixType>
         switch( condition_ )
         {
         case ABOVE:
-          percentile_threshold_above( *src_image_, percentiles_, output_image_ );
+          percentile_threshold_above( *src_image_, percentiles_, output_image_,
+                                      percentile_sampling_points_ );
           break;
         case BELOW:
           LOG_ERROR( this->name() << ": percentiles below thresholding not yet implemented!" );
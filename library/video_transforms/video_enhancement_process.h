@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -14,6 +14,7 @@
 
 #include <video_transforms/automatic_white_balancing.h>
 #include <video_transforms/illumination_normalization.h>
+#include <video_transforms/color_lut.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -28,6 +29,11 @@ namespace vidtk
 ///
 /// Includes toggleable smoothing, contrast enhancement, automatic white
 /// balancing and brightness normalization
+///
+/// For 3-channel images, inversion, white balancing and sampled mean
+/// brightness normalization are compiled into a single 3D color lookup
+/// table, which is applied to the image in one pass. The table is only
+/// rebuilt when the white balancing correction changes.
 template <typename PixType>
 class video_enhancement_process
   : public process
@@ -68,6 +74,12 @@ public:
 
 private:
 
+  // Apply all per-pixel color operations to a 3-channel image in one pass
+  void apply_color_lut();
+
+  // The chain of color operations compiled into the color lookup table
+  void color_operations( double* color, bool apply_awb ) const;
+
   // Inputs
   /// @todo Remove pointers to input data
   vil_image_view<PixType> const* src_image_;
@@ -102,6 +114,16 @@ private:
   // Illumination Norm Options
   enum { MEAN, MEDIAN, NONE, INVALID } illumination_mode_;
   normalizer_sptr illum_function_;
+  mean_illumination_normalization<PixType>* mean_function_;
+
+  // Fused color lookup table
+  unsigned lut_resolution_;
+  color_lut<PixType> lut_;
+  bool lut_valid_;
+  bool lut_awb_applied_;
+  unsigned lut_awb_revision_;
+  vil_image_view<PixType> smoothed_image_;
+  vil_image_view<PixType> sampled_output_;
 };
 
 
@@ -15,6 +15,7 @@
 
 #include <limits>
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <logger/logger.h>
@@ -41,7 +42,12 @@ video_enhancement_process<PixType>
     inversion_enabled_( false ),
     awb_enabled_( true ),
     awb_settings_(),
-    illumination_mode_(INVALID)
+    illumination_mode_(INVALID),
+    mean_function_( NULL ),
+    lut_resolution_( 0 ),
+    lut_valid_( false ),
+    lut_awb_applied_( false ),
+    lut_awb_revision_( 0 )
 {
   // General process settings (which filters to enable)
   config_.add_parameter( "disabled",
@@ -57,6 +63,15 @@ video_enhancement_process<PixType>
   config_.add_parameter( "auto_white_balance",
                          "true",
                          "Whether or not auto-white balancing is enabled" );
+  config_.add_parameter( "color_lut_resolution",
+                         "0",
+                         "For 3-channel images, the number of nodes per channel of the "
+                         "lookup table which inversion, white balancing and sampled_mean "
+                         "brightness normalization are compiled into, so that they are "
+                         "applied in a single pass. The table interpolates the white "
+                         "balancing correction, so its output differs slightly from the "
+                         "separate passes. If 0, each operation is applied as a separate "
+                         "pass over the image. 33 is a good value when enabled." );
   config_.add_parameter( "normalize_brightness",
                          "true",
                          "If enabled, will attempt to stabilize video illumination" );
@@ -166,6 +181,13 @@ video_enhancement_process<PixType>
       // Load inversion options
       inversion_enabled_ = blk.get<bool>("inversion_enabled");
 
+      // Load color lookup table options
+      lut_resolution_ = blk.get<unsigned>("color_lut_resolution");
+      if( lut_resolution_ == 1 || lut_resolution_ > 256 )
+      {
+        throw config_block_parse_error( "Color lookup table resolution must be 0 or in [2,256]" );
+      }
+
       // Load white balancing options
       awb_enabled_ = blk.get<bool>("auto_white_balance");
       if( awb_enabled_ )
@@ -206,14 +228,16 @@ video_enhancement_process<PixType>
             throw config_block_parse_error( "Invalid sampling rate!" );
           }
 
-          illum_function_.reset( new mean_illumination_normalization<PixType>( in_avg_length,
-                                                                               sampling_rate,
-                                                                               per_illum_min,
-                                                                               per_illum_max ) );
+          mean_function_ = new mean_illumination_normalization<PixType>( in_avg_length,
+                                                                         sampling_rate,
+                                                                         per_illum_min,
+                                                                         per_illum_max );
+          illum_function_.reset( mean_function_ );
         }
         else if( mode == "median" )
         {
           illumination_mode_ = MEDIAN;
+          mean_function_ = NULL;
           std::string median_mode = blk.get<std::string>("reference_median_mode");
           PixType value = blk.get<PixType>("fixed_reference_median");
           illum_function_.reset( new median_illumination_normalization<PixType>(median_mode == "fixed", value) );
@@ -227,6 +251,12 @@ video_enhancement_process<PixType>
       {
         illumination_mode_ = NONE;
       }
+
+      if( lut_resolution_ > 0 )
+      {
+        lut_.configure( lut_resolution_, std::numeric_limits<PixType>::max() );
+      }
+      lut_valid_ = false;
     }
   }
   catch( const config_block_parse_error& e )
@@ -273,15 +303,6 @@ video_enhancement_process<PixType>
     return false;
   }
 
-  // Make sure output image is allocated and is seperate from the input
-  // (Due to having the enable flag, output_image and src_image could poententially
-  // point to the same buffer and we don't want to overwrite the input contents)
-  if( *src_image_ == output_image_ )
-  {
-    output_image_.clear();
-  }
-  output_image_.deep_copy( *src_image_ );
-
   // Handle resets
   if( reset_flag_ == true )
   {
@@ -295,28 +316,52 @@ video_enhancement_process<PixType>
     }
   }
 
-  // Perform any optional inverting
-  if( inversion_enabled_ )
-  {
-    invert_image( output_image_ );
-  }
+  const bool use_lut = ( lut_resolution_ > 0 && src_image_->nplanes() == 3 );
 
-  // Perform any optional smoothing
-  if( smoothing_enabled_ )
+  if( use_lut )
   {
-    vil_gauss_filter_2d( output_image_, output_image_, std_dev_, half_width_ );
+    this->apply_color_lut();
   }
-
-  // Perform any optional white balancing
-  if( awb_enabled_ && src_image_->nplanes() == 3 )
+  else
   {
-    awb_engine_.apply( output_image_ );
+    // Make sure output image is allocated and is seperate from the input
+    // (Due to having the enable flag, output_image and src_image could poententially
+    // point to the same buffer and we don't want to overwrite the input contents)
+    if( *src_image_ == output_image_ )
+    {
+      output_image_.clear();
+    }
+    output_image_.deep_copy( *src_image_ );
+
+    // Perform any optional inverting
+    if( inversion_enabled_ )
+    {
+      invert_image( output_image_ );
+    }
+
+    // Perform any optional smoothing
+    if( smoothing_enabled_ )
+    {
+      vil_gauss_filter_2d( output_image_, output_image_, std_dev_, half_width_ );
+    }
+
+    // Perform any optional white balancing
+    if( awb_enabled_ && src_image_->nplanes() == 3 )
+    {
+      awb_engine_.apply( output_image_ );
+    }
   }
 
   // Perform any optional illumination/brightness normalization
   switch(illumination_mode_)
   {
     case MEAN:
+      // Already folded into the color lookup table when it is used
+      if( !use_lut )
+      {
+        output_image_ = (*illum_function_)(output_image_);
+      }
+      break;
     case MEDIAN:
       output_image_ = (*illum_function_)(output_image_);
       break;
@@ -340,6 +385,75 @@ video_enhancement_process<PixType>
   return true;
 }
 
+template <typename PixType>
+void
+video_enhancement_process<PixType>
+::color_operations( double* color, bool apply_awb ) const
+{
+  if( inversion_enabled_ )
+  {
+    const double max_value = std::numeric_limits<PixType>::max();
+
+    color[0] = max_value - color[0];
+    color[1] = max_value - color[1];
+    color[2] = max_value - color[2];
+  }
+
+  if( apply_awb )
+  {
+    awb_engine_.correct_color( color );
+  }
+}
+
+template <typename PixType>
+void
+video_enhancement_process<PixType>
+::apply_color_lut()
+{
+  // Smoothing is the only spatial operation, so it is performed first as a
+  // separate pass. Since it is linear, it commutes with inversion.
+  const vil_image_view<PixType>* base = src_image_;
+
+  if( smoothing_enabled_ )
+  {
+    vil_gauss_filter_2d( *src_image_, smoothed_image_, std_dev_, half_width_ );
+    base = &smoothed_image_;
+  }
+
+  // Estimate the white balancing correction without applying it
+  const bool apply_awb = awb_enabled_ && awb_engine_.update( *base, inversion_enabled_ );
+
+  // Only recompile the table when the operations it contains change
+  if( !lut_valid_ ||
+      apply_awb != lut_awb_applied_ ||
+      ( apply_awb && awb_engine_.revision() != lut_awb_revision_ ) )
+  {
+    lut_.compile( boost::bind( &self_type::color_operations, this, _1, apply_awb ) );
+
+    lut_valid_ = true;
+    lut_awb_applied_ = apply_awb;
+    lut_awb_revision_ = awb_engine_.revision();
+  }
+
+  // The mean brightness is estimated from the corrected values of the
+  // sampled pixels only, and applied as a gain on the table output.
+  double gain = 1.0;
+
+  if( illumination_mode_ == MEAN )
+  {
+    lut_.apply( mean_function_->sampled_view( *base ), sampled_output_ );
+    gain = mean_function_->update_scale( mean_function_->calculate_sampled_mean( sampled_output_ ) );
+  }
+
+  // Make sure output image is allocated and is seperate from the input
+  if( *base == output_image_ )
+  {
+    output_image_.clear();
+  }
+
+  lut_.apply( *base, output_image_, gain );
+}
+
 // Accessor functions
 template <typename PixType>
 void
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2013-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -12,6 +12,11 @@
 
 #include <descriptors/bag_of_words_model.h>
 
+#include <vnl/vnl_random.h>
+
+#include <cmath>
+#include <iomanip>
+
 // Put everything in an anonymous namespace so that different tests
 // won't conflict.
 namespace
@@ -50,6 +55,204 @@ void test_bag_of_words_model()
   TEST( "Output descriptor value 3", output_descriptor[2], 0.7 );
 }
 
+
+void test_small_vocabulary()
+{
+  // Fewer words than top matches voted for
+  vcl_vector< vcl_vector< double > > model( 2, vcl_vector< double >( 2, 0.0 ) );
+  model[0][0] = 1;
+  model[1][1] = 1;
+
+  bag_of_words_model< double, double > bow_vocab;
+  bow_vocab.set_model( model );
+
+  bow_mapping_settings options;
+  options.norm_type_ = bow_mapping_settings::NONE;
+
+  vcl_vector< double > input_features( 2 );
+  input_features[0] = 0.8;
+  input_features[1] = 0.6;
+  vcl_vector< double > output_descriptor;
+
+  bow_vocab.map_to_model( input_features, options, output_descriptor );
+  TEST_NEAR( "Two word vocabulary, first vote", output_descriptor[0], 0.8, 1e-12 );
+  TEST_NEAR( "Two word vocabulary, second vote", output_descriptor[1], 0.3, 1e-12 );
+}
+
+
+// Unit length vectors mixing a few of a set of nonnegative parts, so that
+// like SIFT words they lie near a low dimensional subset of the space
+vcl_vector< float > random_word( const vcl_vector< vcl_vector< float > >& parts,
+                                 vnl_random& rng )
+{
+  const unsigned length = parts[0].size();
+  vcl_vector< float > word( length, 0.0f );
+
+  for( unsigned p = 0; p < 4; ++p )
+  {
+    const vcl_vector< float >& part = parts[ rng.lrand32( 0, parts.size() - 1 ) ];
+    const float weight = static_cast< float >( rng.drand64( 0.2, 1.0 ) );
+
+    for( unsigned d = 0; d < length; ++d )
+    {
+      word[d] += weight * part[d];
+    }
+  }
+
+  double norm = 0;
+  for( unsigned d = 0; d < length; ++d )
+  {
+    word[d] = std::max( 0.0f, word[d] + static_cast< float >( rng.normal() * 0.02 ) );
+    norm += word[d] * word[d];
+  }
+  for( unsigned d = 0; d < length; ++d )
+  {
+    word[d] /= std::sqrt( norm );
+  }
+  return word;
+}
+
+
+// Compare the approximate and exhaustive searches on a synthetic
+// vocabulary of the size used by the BoW descriptors, reporting the
+// recall of the approximate search for several budgets. Timings are
+// reported by the bag_of_words_benchmark tool.
+void test_approximate_search()
+{
+  const unsigned length = 128;
+  const unsigned word_count = 2048;
+  const unsigned feature_count = 2000;
+
+  vnl_random rng( 1234 );
+
+  vcl_vector< vcl_vector< float > > parts( 64, vcl_vector< float >( length ) );
+  for( unsigned p = 0; p < parts.size(); ++p )
+  {
+    for( unsigned d = 0; d < length; ++d )
+    {
+      parts[p][d] = static_cast< float >( std::max( 0.0, rng.normal() ) );
+    }
+  }
+
+  vcl_vector< vcl_vector< float > > model( word_count );
+  for( unsigned i = 0; i < word_count; ++i )
+  {
+    model[i] = random_word( parts, rng );
+  }
+
+  vcl_vector< vcl_vector< float > > features( feature_count );
+  for( unsigned i = 0; i < feature_count; ++i )
+  {
+    features[i] = random_word( parts, rng );
+  }
+
+  bag_of_words_model< float, double > bow_vocab;
+  bow_vocab.set_model( model );
+
+  const bag_of_words_index< float >& index = bow_vocab.index();
+  TEST( "Index built on set_model", index.word_count() == word_count &&
+                                    index.tree_count() == 4, true );
+
+  // Exhaustive nearest words
+  vcl_vector< unsigned > nearest( feature_count );
+  vcl_vector< unsigned > best_match( feature_count );
+
+  for( unsigned i = 0; i < feature_count; ++i )
+  {
+    double min_dist = 1e30, max_dot = -1e30;
+    for( unsigned j = 0; j < word_count; ++j )
+    {
+      double dist = 0, dot = 0;
+      for( unsigned d = 0; d < length; ++d )
+      {
+        dist += ( features[i][d] - model[j][d] ) * ( features[i][d] - model[j][d] );
+        dot += features[i][d] * model[j][d];
+      }
+      if( dist < min_dist )
+      {
+        min_dist = dist;
+        nearest[i] = j;
+      }
+      if( dot > max_dot )
+      {
+        max_dot = dot;
+        best_match[i] = j;
+      }
+    }
+  }
+
+  bag_of_words_index< float >::search_buffer buffer;
+  unsigned found[3];
+
+  unsigned all_checks = 0;
+  for( unsigned i = 0; i < feature_count; ++i )
+  {
+    index.find_nearest( &features[i][0], bag_of_words_index< float >::EUCLIDEAN,
+                        1, word_count, found, buffer );
+    all_checks += ( found[0] == nearest[i] );
+  }
+  TEST( "Searching every word finds the nearest word", all_checks, feature_count );
+
+  const unsigned budgets[] = { 32, 64, 128, 256, 512 };
+  double recall_256 = 0.0;
+
+  vcl_cout << "\n  checks  recall  inner product recall\n";
+  for( unsigned b = 0; b < 5; ++b )
+  {
+    unsigned hits = 0, dot_hits = 0;
+
+    for( unsigned i = 0; i < feature_count; ++i )
+    {
+      index.find_nearest( &features[i][0], bag_of_words_index< float >::EUCLIDEAN,
+                          1, budgets[b], found, buffer );
+      hits += ( found[0] == nearest[i] );
+    }
+
+    for( unsigned i = 0; i < feature_count; ++i )
+    {
+      index.find_nearest( &features[i][0], bag_of_words_index< float >::INNER_PRODUCT,
+                          3, budgets[b], found, buffer );
+      dot_hits += ( found[0] == best_match[i] );
+    }
+
+    const double recall = static_cast< double >( hits ) / feature_count;
+    vcl_cout << "  " << std::setw( 6 ) << budgets[b]
+             << "  " << std::setw( 6 ) << recall
+             << "  " << std::setw( 20 ) << static_cast< double >( dot_hits ) / feature_count << "\n";
+
+    if( budgets[b] == 256 )
+    {
+      recall_256 = recall;
+    }
+  }
+  TEST( "Recall with 256 checks", recall_256 > 0.8, true );
+
+  // Descriptors computed both ways
+  bow_mapping_settings exact_options;
+  bow_mapping_settings approx_options;
+  approx_options.search_method_ = bow_mapping_settings::APPROXIMATE;
+
+  vcl_vector< double > exact_output, approx_output;
+
+  bow_vocab.map_to_model( features, exact_options, exact_output );
+  bow_vocab.map_to_model( features, approx_options, approx_output );
+
+  double difference = 0.0;
+  for( unsigned j = 0; j < word_count; ++j )
+  {
+    difference += std::fabs( exact_output[j] - approx_output[j] );
+  }
+  TEST( "Approximate descriptor close to exhaustive one", difference < 0.5, true );
+
+  // Enough checks to compare every word falls back to the exhaustive search
+  approx_options.max_checks_ = word_count;
+  bow_vocab.map_to_model( features, approx_options, approx_output );
+  TEST( "Exhaustive fallback", approx_output == exact_output, true );
+
+  bow_vocab.set_index_tree_count( 2 );
+  TEST( "Index rebuilt", bow_vocab.index().tree_count(), 2 );
+}
+
 } // end anonymous namespace
 
 int test_bag_of_words_model( int /*argc*/, char* /*argv*/[] )
@@ -57,6 +260,8 @@ int test_bag_of_words_model( int /*argc*/, char* /*argv*/[] )
   testlib_test_start( "test_bag_of_words_model" );
 
   test_bag_of_words_model();
+  test_small_vocabulary();
+  test_approximate_search();
 
   return testlib_test_summary();
 }
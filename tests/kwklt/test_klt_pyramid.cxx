@@ -6,6 +6,7 @@
 
 #include <testlib/testlib_test.h>
 
+#include <kwklt/klt_pyramid_cache.h>
 #include <kwklt/klt_pyramid_process.h>
 #include <kwklt/klt_util.h>
 
@@ -122,6 +123,71 @@ test_klt_pyramid_process()
   }
 }
 
+
+void
+test_shared_pyramid_cache()
+{
+  klt_pyramid_cache::instance()->clear();
+
+  vil_image_view<vxl_byte> img(320, 240);
+  for (unsigned j = 0; j < img.nj(); ++j)
+  {
+    for (unsigned i = 0; i < img.ni(); ++i)
+    {
+      img(i, j) = static_cast<vxl_byte>((i * 7 + j * 13) % 256);
+    }
+  }
+
+  klt_pyramid_process<vxl_byte> kpp1("pyramid1");
+  klt_pyramid_process<vxl_byte> kpp2("pyramid2");
+  config_block blk = kpp1.params();
+  blk.set("use_shared_cache", "true");
+  TEST("Set params 1", kpp1.set_params(blk), true);
+  TEST("Set params 2", kpp2.set_params(blk), true);
+  TEST("Init 1", kpp1.initialize(), true);
+  TEST("Init 2", kpp2.initialize(), true);
+
+  kpp1.set_image(img);
+  kpp1.set_timestamp(timestamp(1.0, 1));
+  TEST("Step 1", kpp1.step(), true);
+
+  kpp2.set_image(img);
+  kpp2.set_timestamp(timestamp(1.0, 1));
+  TEST("Step 2", kpp2.step(), true);
+
+  TEST_EQUAL("Pyramid built once", klt_pyramid_cache::instance()->build_count(), 1);
+  TEST_EQUAL("Pyramid reused", klt_pyramid_cache::instance()->hit_count(), 1);
+  TEST("Levels are shared",
+       kpp1.image_pyramid()(1u).top_left_ptr() == kpp2.image_pyramid()(1u).top_left_ptr(), true);
+
+  // Same timestamp, different pixels, must not be shared
+  vil_image_view<vxl_byte> other(320, 240);
+  other.fill(17);
+  kpp2.set_image(other);
+  kpp2.set_timestamp(timestamp(1.0, 1));
+  TEST("Step other", kpp2.step(), true);
+  TEST_EQUAL("Different image rebuilt", klt_pyramid_cache::instance()->build_count(), 2);
+
+  // Without a timestamp the cache is bypassed
+  kpp1.set_image(img);
+  TEST("Step without timestamp", kpp1.step(), true);
+  TEST_EQUAL("No timestamp bypasses cache", klt_pyramid_cache::instance()->build_count(), 2);
+
+  vil_pyramid_image_view<float> direct = create_klt_pyramid(img, 2, 4, 0.9f, 0.7f);
+  vil_image_view<float> cached = kpp1.image_pyramid()(1u);
+  bool equal = true;
+  for (unsigned j = 0; j < cached.nj(); ++j)
+  {
+    for (unsigned i = 0; i < cached.ni(); ++i)
+    {
+      equal = equal && (cached(i, j) == direct(1u)(i, j));
+    }
+  }
+  TEST("Cached pyramid matches direct build", equal, true);
+
+  klt_pyramid_cache::instance()->clear();
+}
+
 } // end namespace
 
 // ----------------------------------------------------------------
@@ -136,6 +202,7 @@ int test_klt_pyramid(int /*argc*/, char * /*argv*/[])
   test_pyramid_creation();
   test_klt_pyramid_process<vxl_byte>();
   test_klt_pyramid_process<vxl_uint_16>();
+  test_shared_pyramid_cache();
 
   return testlib_test_summary();
 }
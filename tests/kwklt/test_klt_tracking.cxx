@@ -1,11 +1,12 @@
 /*ckwg +5
- * Copyright 2010-2014 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include <testlib/testlib_test.h>
 
+#include <vcl_algorithm.h>
 #include <vcl_iomanip.h>
 
 #include <pipeline_framework/sync_pipeline.h>
@@ -196,6 +197,135 @@ void test_real_images( vcl_string const& dir )
   TEST_NEAR("Average distance between points is as expected", average_distance/count, 14.0927232874901538, 1e-5);
 }
 
+//real images of fixed translation, tracked coarse to fine
+void test_coarse_to_fine( vcl_string const& dir )
+{
+  sync_pipeline p;
+
+  klt_pyramid_process<vxl_byte> pyr("pyramid");
+  p.add(&pyr);
+
+  klt_tracking_process trk("tracking");
+  p.add(&trk);
+
+  p.connect(pyr.image_pyramid_port(),
+            trk.set_image_pyramid_port());
+  p.connect(pyr.image_pyramid_gradx_port(),
+            trk.set_image_pyramid_gradx_port());
+  p.connect(pyr.image_pyramid_grady_port(),
+            trk.set_image_pyramid_grady_port());
+
+  config_block c = p.params();
+  c.set("tracking:impl", "klt");
+  c.set("tracking:feature_count", "1000");
+  c.set("tracking:coarse_to_fine", "true");
+  c.set("tracking:compare_single_scale", "true");
+
+  TEST("set_params", p.set_params(c), true);
+  TEST("initialize", p.initialize(), true);
+
+  timestamp ts;
+  vil_image_view<vxl_byte> img = vil_load( (dir + "/fix_movement_0.png").c_str() );
+  ts.set_frame_number(1);
+
+  pyr.set_image(img);
+  trk.set_timestamp(ts);
+
+  TEST("execute", p.execute(), process::SUCCESS);
+  TEST_EQUAL("created_tracks", trk.created_tracks().size(), 1000);
+
+  img = vil_load( (dir + "/fix_movement_1.png").c_str() );
+  ts.set_frame_number(2);
+
+  pyr.set_image(img);
+  trk.set_timestamp(ts);
+
+  TEST("execute", p.execute(), process::SUCCESS);
+  TEST_EQUAL("Sum of active and terminated is correct", trk.active_tracks().size() + trk.terminated_tracks().size(), 1000);
+  TEST("Most features are tracked", trk.active_tracks().size() > 900, true);
+
+  double average_distance = 0.;
+  double count = 0.;
+  {
+    vcl_vector<klt_track_ptr> const& trks =  trk.active_tracks();
+    for(vcl_vector<klt_track_ptr>::const_iterator iter = trks.begin(); iter != trks.end(); ++iter)
+    {
+      klt_track::point_t hpt = (*iter)->point();
+      klt_track::point_t tpt = (*iter)->tail()->point();
+      average_distance += vcl_sqrt((hpt.x-tpt.x)*(hpt.x-tpt.x) + (hpt.y-tpt.y)*(hpt.y-tpt.y));
+      count++;
+    }
+  }
+  TEST_NEAR("Average distance is close to single scale tracking", average_distance/count, 14.0927232874901538, 0.5);
+}
+
+// Largest number of features in a cell of a 4x4 grid over the image
+unsigned most_features_per_cell( vcl_vector<klt_track_ptr> const& trks,
+                                 unsigned width, unsigned height )
+{
+  unsigned counts[16] = { 0 };
+  unsigned most = 0;
+  for(vcl_vector<klt_track_ptr>::const_iterator iter = trks.begin(); iter != trks.end(); ++iter)
+  {
+    klt_track::point_t pt = (*iter)->point();
+    unsigned cell = static_cast<unsigned>(4 * pt.y / height) * 4 + static_cast<unsigned>(4 * pt.x / width);
+    most = vcl_max( most, ++counts[cell] );
+  }
+  return most;
+}
+
+vcl_vector<klt_track_ptr> select_features( vil_image_view<vxl_byte> const& img,
+                                           vcl_string const& selection )
+{
+  sync_pipeline p;
+
+  klt_pyramid_process<vxl_byte> pyr("pyramid");
+  p.add(&pyr);
+
+  klt_tracking_process trk("tracking");
+  p.add(&trk);
+
+  p.connect(pyr.image_pyramid_port(),
+            trk.set_image_pyramid_port());
+  p.connect(pyr.image_pyramid_gradx_port(),
+            trk.set_image_pyramid_gradx_port());
+  p.connect(pyr.image_pyramid_grady_port(),
+            trk.set_image_pyramid_grady_port());
+
+  config_block c = p.params();
+  c.set("tracking:impl", "klt");
+  c.set("tracking:feature_count", "500");
+  c.set("tracking:feature_selection", selection);
+
+  TEST("set_params", p.set_params(c), true);
+  TEST("initialize", p.initialize(), true);
+
+  timestamp ts;
+  ts.set_frame_number(1);
+  pyr.set_image(img);
+  trk.set_timestamp(ts);
+
+  TEST("execute", p.execute(), process::SUCCESS);
+
+  return trk.created_tracks();
+}
+
+void test_grid_selection( vcl_string const& dir )
+{
+  vil_image_view<vxl_byte> img = vil_load( (dir + "/fix_movement_0.png").c_str() );
+
+  vcl_vector<klt_track_ptr> full = select_features( img, "full" );
+  vcl_vector<klt_track_ptr> grid = select_features( img, "grid" );
+
+  unsigned full_most = most_features_per_cell( full, img.ni(), img.nj() );
+  unsigned grid_most = most_features_per_cell( grid, img.ni(), img.nj() );
+  vcl_cout << "Most features in a cell: " << full_most << " full, "
+           << grid_most << " grid\n";
+
+  TEST("Grid selection finds enough features", grid.size() >= 0.9 * full.size(), true);
+  TEST("Grid selection spreads features", grid_most <= full_most, true);
+}
+
 void test_klt_track()
 {
   klt_track::point_ pt1;
@@ -256,6 +386,28 @@ void test_process_error_checking()
     c.set("window_height", "10");
     TEST("set_params test even windows size", trk.set_params(c), true);
     TEST("set_params test even windows size", trk.initialize(), true);
+    c.set("feature_selection", "BAD");
+    TEST("set_params set bad feature_selection", trk.set_params(c), false);
+    c.set("feature_selection", "grid");
+    c.set("selection_grid_cols", "0");
+    TEST("set_params checks the selection grid", trk.set_params(c), false);
+    c.set("selection_grid_cols", "8");
+    TEST("set_params works with grid feature_selection", trk.set_params(c), true);
+    c.set("coarse_to_fine", "true");
+    c.set("coarse_feature_count", "3");
+    TEST("set_params checks coarse_feature_count", trk.set_params(c), false);
+    c.set("coarse_feature_count", "50");
+    c.set("refine_levels", "0");
+    TEST("set_params checks refine_levels", trk.set_params(c), false);
+    c.set("refine_levels", "1");
+    TEST("set_params works with coarse_to_fine", trk.set_params(c), true);
+    c.set("frame_time_target", "-1");
+    TEST("set_params checks frame_time_target", trk.set_params(c), false);
+    c.set("frame_time_target", "0.01");
+    c.set("min_feature_budget", "5000");
+    TEST("set_params checks min_feature_budget", trk.set_params(c), false);
+    c.set("min_feature_budget", "50");
+    TEST("set_params works with frame_time_target", trk.set_params(c), true);
   }
   //test disable
   {
@@ -289,6 +441,8 @@ int test_klt_tracking(int argc, char * argv[])
 
   test_drop_after_find();
   test_real_images(argv[1]);
+  test_grid_selection(argv[1]);
+  test_coarse_to_fine(argv[1]);
   test_klt_track();
   test_process_error_checking();
 
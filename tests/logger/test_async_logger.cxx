@@ -0,0 +1,181 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <logger/logger.h>
+#include <logger/vidtk_logger_mini_logger.h>
+#include <logger/vidtk_mini_logger_formatter_basic.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <sstream>
+#include <string>
+
+using vidtk::logger_ns::vidtk_logger_mini_logger;
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+const unsigned thread_count = 4;
+const unsigned message_count = 2000;
+
+
+void log_messages( vidtk::vidtk_logger* logger, unsigned id )
+{
+  for ( unsigned i = 0; i < message_count; ++i )
+  {
+    std::ostringstream msg;
+    msg << "Async-Message " << id << " " << i;
+    logger->log_info( msg.str(), VIDTK_LOGGER_SITE );
+  }
+}
+
+
+size_t count_lines( std::string const& text, std::string const& tag )
+{
+  std::istringstream str( text );
+  std::string line;
+  size_t count = 0;
+
+  while ( std::getline( str, line ) )
+  {
+    if ( line.find( tag ) != std::string::npos )
+    {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+
+// Messages from one thread must stay in order, though some may be missing
+bool in_order( std::string const& text, std::string const& tag )
+{
+  std::istringstream str( text );
+  std::string line;
+  int last = -1;
+
+  while ( std::getline( str, line ) )
+  {
+    size_t pos = line.find( tag );
+    if ( pos != std::string::npos )
+    {
+      int index = -1;
+      std::istringstream( line.substr( pos + tag.size() ) ) >> index;
+      if ( index <= last )
+      {
+        return false;
+      }
+      last = index;
+    }
+  }
+
+  return true;
+}
+
+
+void log_from_threads( vidtk::vidtk_logger_sptr logger )
+{
+  boost::thread_group threads;
+  for ( unsigned t = 0; t < thread_count; ++t )
+  {
+    threads.create_thread( boost::bind( &log_messages, logger.ptr(), t ) );
+  }
+  threads.join_all();
+}
+
+
+void test_all_written( vidtk_logger_mini_logger* lptr, vidtk::vidtk_logger_sptr logger )
+{
+  std::ostringstream sstr;
+  lptr->set_output_stream( &sstr );
+
+  const unsigned long dropped_before = vidtk_logger_mini_logger::dropped_message_count();
+
+  log_from_threads( logger );
+  vidtk_logger_mini_logger::flush_async_output();
+
+  const std::string text = sstr.str();
+  const size_t written = count_lines( text, "Async-Message" );
+  const unsigned long dropped =
+    vidtk_logger_mini_logger::dropped_message_count() - dropped_before;
+
+  TEST( "Every message written or counted as dropped",
+        written + dropped, thread_count * message_count );
+
+  TEST( "Messages in order", in_order( text, "Async-Message 0 " ), true );
+
+  if ( dropped != 0 )
+  {
+    TEST( "Dropped messages reported",
+          text.find( "dropped" ) != std::string::npos, true );
+  }
+}
+
+
+void test_formatter( vidtk_logger_mini_logger* lptr, vidtk::vidtk_logger_sptr logger )
+{
+  std::ostringstream sstr;
+  lptr->set_output_stream( &sstr );
+
+  vidtk::set_mini_logger_formatter(
+    logger, new vidtk::logger_ns::vidtk_mini_logger_formatter_basic );
+
+  logger->log_warn( "Formatted-Message", VIDTK_LOGGER_SITE );
+  vidtk_logger_mini_logger::flush_async_output();
+
+  const std::string text = sstr.str();
+  TEST( "Formatted message written",
+        text.find( "Formatted-Message" ) != std::string::npos, true );
+  TEST( "Formatter has location",
+        text.find( "test_async_logger.cxx" ) != std::string::npos, true );
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------
+/** Main test driver for this file.
+ *
+ *
+ */
+int test_async_logger( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "asynchronous logger" );
+
+  // Must be enabled before anything is logged. Use small queues so
+  // that both writing and dropping are exercised.
+  const bool async = vidtk_logger_mini_logger::enable_async_output( 256 );
+
+  vidtk::vidtk_logger_sptr logger =
+    vidtk::logger_manager::instance()->get_logger( "main.async_logger" );
+
+  vidtk_logger_mini_logger* lptr =
+    dynamic_cast< vidtk_logger_mini_logger* >( logger.ptr() );
+
+  // Return if mini logger not the active back end
+  if ( ! lptr )
+  {
+    return testlib_test_summary();
+  }
+
+  if ( ! async )
+  {
+    TEST( "No drops when synchronous",
+          vidtk_logger_mini_logger::dropped_message_count(), 0 );
+  }
+
+  test_all_written( lptr, logger );
+  test_formatter( lptr, logger );
+
+  lptr->set_output_stream( &std::cerr );
+
+  return testlib_test_summary();
+}
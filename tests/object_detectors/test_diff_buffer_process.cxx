@@ -0,0 +1,198 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <object_detectors/diff_buffer_process.h>
+
+#include <vnl/vnl_double_3x3.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <iostream>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+typedef diff_buffer_process< vxl_byte > buffer_t;
+typedef homography_chain::transform_t transform_t;
+
+
+// Frame f is translated 5 pixels further right in the reference frame r
+image_to_image_homography
+make_homog( unsigned f, unsigned r, bool valid = true )
+{
+  transform_t transform;
+  transform.set_identity();
+  transform.set_translation( 5.0 * f - 5.0 * r, 0.0 );
+
+  image_to_image_homography homog;
+  homog.set_transform( transform );
+  homog.set_source_reference( timestamp( f * 0.5, f ) );
+  homog.set_dest_reference( timestamp( r * 0.5, r ) );
+  homog.set_valid( valid );
+  homog.set_new_reference( f == r );
+  return homog;
+}
+
+
+bool
+is_translation( transform_t const& t, double tx )
+{
+  vnl_double_3x3 m = t.get_matrix();
+  m /= m( 2, 2 );
+
+  vnl_double_3x3 expected;
+  expected.set_identity();
+  expected( 0, 2 ) = tx;
+
+  return ( m - expected ).frobenius_norm() < 1e-9;
+}
+
+
+bool
+step_frame( buffer_t& buffer, image_to_image_homography const& homog )
+{
+  vil_image_view< vxl_byte > img( 16, 16 );
+  img.fill( 0 );
+
+  buffer.set_source_img( img );
+  buffer.set_source_vidtk_homog( homog );
+  return buffer.step2() == process::SUCCESS;
+}
+
+
+void
+configure( buffer_t& buffer )
+{
+  config_block blk = buffer.params();
+  blk.set( "spacing", "2" );
+
+  TEST( "Set params", buffer.set_params( blk ), true );
+  TEST( "Initialize", buffer.initialize(), true );
+}
+
+
+void
+test_shot_breaks()
+{
+  std::cout << "\nShot breaks and invalid homographies\n";
+
+  buffer_t buffer( "buffer" );
+  configure( buffer );
+
+  for( unsigned f = 0; f < 4; ++f )
+  {
+    step_frame( buffer, make_homog( f, 0 ) );
+  }
+
+  TEST( "Frames of one shot are differenced", buffer.get_differencing_flag(), true );
+  TEST( "Third to first", is_translation( buffer.get_third_to_first_homog(), 10.0 ), true );
+  TEST( "Third to second", is_translation( buffer.get_third_to_second_homog(), 5.0 ), true );
+
+  // Frame 4 starts a new shot
+  step_frame( buffer, make_homog( 4, 4 ) );
+  TEST( "Not differenced across a shot break", buffer.get_differencing_flag(), false );
+  TEST( "Identity across a shot break",
+        is_translation( buffer.get_third_to_first_homog(), 0.0 ), true );
+
+  step_frame( buffer, make_homog( 5, 4 ) );
+  step_frame( buffer, make_homog( 6, 4 ) );
+  TEST( "New shot is differenced", buffer.get_differencing_flag(), true );
+  TEST( "New shot third to first",
+        is_translation( buffer.get_third_to_first_homog(), 10.0 ), true );
+
+  step_frame( buffer, make_homog( 7, 4, false ) );
+  TEST( "Invalid homography is not differenced", buffer.get_differencing_flag(), false );
+
+  step_frame( buffer, make_homog( 8, 4 ) );
+  TEST( "Not differenced against an invalid frame", buffer.get_differencing_flag(), false );
+}
+
+
+void
+read_chain( homography_chain_sptr chain, unsigned* checks, unsigned* failures )
+{
+  transform_t result;
+
+  for( unsigned i = 0; i < 2000; ++i )
+  {
+    // All frames are in one shot, and the chain only grows
+    if( chain->size() >= 2 )
+    {
+      ++( *checks );
+
+      if( !chain->transform_by_age( 1, 0, result ) || !is_translation( result, -5.0 ) )
+      {
+        ++( *failures );
+      }
+    }
+  }
+}
+
+
+void
+test_shared_chain()
+{
+  std::cout << "\nSharing the buffered homographies\n";
+
+  buffer_t buffer( "buffer" );
+  configure( buffer );
+
+  homography_chain_sptr chain = buffer.get_homography_chain();
+  TEST( "Chain is available", chain.get() != NULL, true );
+  TEST( "Chain is kept across initialize",
+        buffer.initialize() && buffer.get_homography_chain() == chain, true );
+
+  step_frame( buffer, make_homog( 0, 0 ) );
+
+  unsigned checks[2] = { 0, 0 };
+  unsigned failures[2] = { 0, 0 };
+
+  boost::thread_group readers;
+  for( unsigned t = 0; t < 2; ++t )
+  {
+    readers.create_thread( boost::bind( read_chain, chain, &checks[t], &failures[t] ) );
+  }
+
+  bool steps_ok = true;
+  for( unsigned f = 1; f < 500; ++f )
+  {
+    steps_ok = step_frame( buffer, make_homog( f, 0 ) ) && steps_ok;
+  }
+
+  readers.join_all();
+
+  TEST( "Buffer stepped", steps_ok, true );
+  TEST( "Readers found the latest frames related",
+        failures[0] + failures[1], 0 );
+  std::cout << "Reader checks: " << checks[0] << ", " << checks[1] << "\n";
+
+  transform_t result;
+  TEST( "Chain holds the buffered frames", chain->size(), 3 );
+  TEST( "Reader sees the buffer's transforms",
+        chain->transform_by_age( 0, 2, result ) &&
+        is_translation( result, 10.0 ) &&
+        is_translation( buffer.get_third_to_first_homog(), 10.0 ), true );
+}
+
+} // end anonymous namespace
+
+
+int test_diff_buffer_process( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "diff_buffer_process" );
+
+  test_shot_breaks();
+  test_shared_chain();
+
+  return testlib_test_summary();
+}
@@ -0,0 +1,147 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <iostream>
+#include <testlib/testlib_test.h>
+#include <vil/vil_image_view.h>
+#include <vxl_config.h>
+
+#include <vnl/vnl_random.h>
+
+#include <object_detectors/gmm_background_model_process.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+// Noisy static background with a bright square entering at frame 30
+// and moving one pixel per frame.
+void
+make_frame( vil_image_view<vxl_byte>& img, unsigned frame, vnl_random& rng )
+{
+  img = vil_image_view<vxl_byte>( 64, 48, 3 );
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < img.nj(); ++j )
+    {
+      for( unsigned i = 0; i < img.ni(); ++i )
+      {
+        double v = 80 + 20*p + rng.normal() * 3;
+        unsigned const x0 = frame - 30 + 5;
+        if( frame >= 30 && i >= x0 && i < x0 + 12 && j >= 18 && j < 30 )
+        {
+          v = 230;
+        }
+        img( i, j, p ) = static_cast<vxl_byte>( v + 0.5 );
+      }
+    }
+  }
+}
+
+
+unsigned
+count_foreground( vil_image_view<bool> const& fg, unsigned i0, unsigned i1,
+                  unsigned j0, unsigned j1 )
+{
+  unsigned count = 0;
+  for( unsigned j = j0; j < j1; ++j )
+  {
+    for( unsigned i = i0; i < i1; ++i )
+    {
+      count += fg( i, j ) ? 1 : 0;
+    }
+  }
+  return count;
+}
+
+
+bool
+configure( gmm_background_model_process<vxl_byte>& proc,
+           std::string const& model_type, std::string const& covar_mode,
+           std::string const& update_algorithm )
+{
+  config_block blk = proc.params();
+  blk.set( "model_type", model_type );
+  blk.set( "covar_mode", covar_mode );
+  blk.set( "update_algorithm", update_algorithm );
+  blk.set( "num_mixture_components", "3" );
+  blk.set( "initial_variance", "100" );
+  blk.set( "mininum_stdev", "5" );
+  blk.set( "lm_window_size", "20" );
+  blk.set( "search_radius", "1" );
+  return proc.set_params( blk ) && proc.initialize();
+}
+
+
+// The planar model is a replacement for the bbgm model, so both must
+// produce the same foreground masks up to pixels whose distance to the
+// model is close to the detection threshold (see planar_gmm_model.h).
+// At most 1% of the pixels of a frame may differ on average.
+void
+test_mask_agreement( std::string const& covar_mode, std::string const& update_algorithm )
+{
+  std::cout << "Test bbgm and planar masks agree with covar_mode " << covar_mode
+            << " and update_algorithm " << update_algorithm << "\n";
+
+  gmm_background_model_process<vxl_byte> bbgm( "bbgm" );
+  gmm_background_model_process<vxl_byte> planar( "planar" );
+  TEST( "Configure bbgm model", configure( bbgm, "bbgm", covar_mode, update_algorithm ), true );
+  TEST( "Configure planar model", configure( planar, "planar", covar_mode, update_algorithm ), true );
+
+  vnl_random rng( 11 );
+  vil_image_view<vxl_byte> img;
+
+  unsigned differing = 0;
+  unsigned pixels = 0;
+  unsigned object_bbgm = 0;
+  unsigned object_planar = 0;
+
+  for( unsigned f = 0; f < 60; ++f )
+  {
+    make_frame( img, f, rng );
+    bbgm.set_source_image( img );
+    planar.set_source_image( img );
+    TEST( "Step bbgm model", bbgm.step(), true );
+    TEST( "Step planar model", planar.step(), true );
+
+    vil_image_view<bool> fg1 = bbgm.fg_image();
+    vil_image_view<bool> fg2 = planar.fg_image();
+
+    for( unsigned j = 0; j < img.nj(); ++j )
+    {
+      for( unsigned i = 0; i < img.ni(); ++i )
+      {
+        differing += ( fg1( i, j ) != fg2( i, j ) ) ? 1 : 0;
+      }
+    }
+    pixels += img.ni() * img.nj();
+
+    if( f == 31 )
+    {
+      object_bbgm = count_foreground( fg1, 6, 18, 18, 30 );
+      object_planar = count_foreground( fg2, 6, 18, 18, 30 );
+    }
+  }
+
+  std::cout << "Masks differ at " << differing << " of " << pixels << " pixels\n";
+  TEST( "Masks agree within 1%", differing * 100 <= pixels, true );
+  TEST( "bbgm model detects the object", object_bbgm >= 130, true );
+  TEST( "planar model detects the object", object_planar >= 130, true );
+}
+
+} // end anonymous namespace
+
+int test_gmm_background_model_process( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "GMM background model process" );
+
+  test_mask_agreement( "indep", "LM" );
+  test_mask_agreement( "sphere", "SG" );
+
+  return testlib_test_summary();
+}
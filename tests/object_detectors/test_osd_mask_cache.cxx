@@ -0,0 +1,119 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <iostream>
+#include <testlib/testlib_test.h>
+#include <vil/vil_image_view.h>
+
+#include <object_detectors/osd_mask_cache.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+void
+make_frame( vil_image_view<vxl_byte>& img, vxl_byte osd_value, vxl_byte scene_value )
+{
+  img.set_size( 64, 48, 3 );
+  img.fill( scene_value );
+
+  // a static OSD bar along the top of the frame
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < 8; ++j )
+    {
+      for( unsigned i = 0; i < 64; ++i )
+      {
+        img( i, j, p ) = osd_value;
+      }
+    }
+  }
+}
+
+
+void
+test_reuse_and_invalidation()
+{
+  std::cout << "Test mask reuse and invalidation\n";
+
+  osd_mask_cache_settings settings;
+  settings.enabled = true;
+  settings.refresh_interval = 5;
+  settings.sample_step = 2;
+  settings.min_sample_count = 16;
+
+  osd_mask_cache<vxl_byte> cache;
+  TEST( "Configure", cache.configure( settings ), true );
+
+  vil_image_view<vxl_byte> img;
+  make_frame( img, 250, 10 );
+
+  vil_image_view<bool> mask( 64, 48 );
+  mask.fill( false );
+  for( unsigned j = 0; j < 8; ++j )
+  {
+    for( unsigned i = 0; i < 64; ++i )
+    {
+      mask( i, j ) = true;
+    }
+  }
+
+  TEST( "Nothing stored yet", cache.verify( img, false ), false );
+  cache.store( img, mask, mask, image_border(), "test_osd" );
+
+  // Scene changes but the OSD does not
+  make_frame( img, 248, 120 );
+  TEST( "Unchanged OSD is reused", cache.verify( img, false ), true );
+  TEST( "Stored type", cache.detected_type(), "test_osd" );
+
+  TEST( "Shot break forces detection", cache.verify( img, true ), false );
+
+  // Re-store, then change the OSD itself
+  cache.store( img, mask, mask, image_border(), "test_osd" );
+  make_frame( img, 30, 120 );
+  TEST( "Changed OSD is detected", cache.verify( img, false ), false );
+
+  // Periodic refresh
+  cache.store( img, mask, mask, image_border(), "test_osd" );
+  unsigned reused = 0;
+  for( unsigned f = 0; f < 10; ++f )
+  {
+    reused += cache.verify( img, false ) ? 1 : 0;
+  }
+  TEST( "Refresh interval bounds reuse", reused, settings.refresh_interval - 1 );
+
+  // Unverified reuse under reduced detection frequency
+  cache.store( img, mask, mask, image_border(), "test_osd" );
+  make_frame( img, 30, 120 );
+  reused = 0;
+  for( unsigned f = 0; f < 5; ++f )
+  {
+    reused += cache.reuse_within_interval( img, false, 3 ) ? 1 : 0;
+  }
+  TEST( "Interval bounds unverified reuse", reused, 2 );
+  TEST( "Shot break prevents unverified reuse",
+        cache.reuse_within_interval( img, true, 100 ), false );
+
+  // Empty masks cannot be verified
+  vil_image_view<bool> empty( 64, 48 );
+  empty.fill( false );
+  cache.store( img, empty, empty, image_border(), "" );
+  TEST( "Empty mask is not reused", cache.verify( img, false ), false );
+}
+
+
+} // end anonymous namespace
+
+int test_osd_mask_cache( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "OSD mask cache" );
+
+  test_reuse_and_invalidation();
+
+  return testlib_test_summary();
+}
@@ -69,6 +69,31 @@ void test_pixel_feature_extraction()
     TEST( info.c_str(), output[i].ni() == 20 && output[i].nj() == 20, true );
   }
 
+  // Test ROI restricted case
+  blk.set( "roi:enabled", "true" );
+  blk.set( "roi:regions", "0 0 0.25 0.25" );
+  blk.set( "roi:dilation", "2" );
+
+  TEST( "Configure ROI", feature_proc.set_params( blk ), true );
+
+  feature_proc.set_source_color_image( input_color );
+  feature_proc.set_source_grey_image( input_intensity );
+  feature_proc.set_border( input_border );
+
+  feature_proc.step2();
+
+  output = feature_proc.feature_array();
+  vil_image_view<bool> roi_mask = feature_proc.roi_mask();
+
+  TEST( "Output Array Total Size ROI", output.size() > 0, true );
+  TEST( "Output Size ROI", output[0].ni() == 20 && output[0].nj() == 20, true );
+  TEST( "ROI Mask Size", roi_mask.ni() == 20 && roi_mask.nj() == 20, true );
+  TEST( "ROI Mask Inside", roi_mask( 2, 2 ), true );
+  TEST( "ROI Mask Outside", roi_mask( 15, 15 ), false );
+  TEST( "Features Inside ROI", output[0]( 2, 2 ), 100 );
+
+  blk.set( "roi:enabled", "false" );
+
   // Test disabled flag
   blk.set( "disabled", "true" );
 
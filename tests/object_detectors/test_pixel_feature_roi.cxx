@@ -0,0 +1,204 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <iostream>
+#include <testlib/testlib_test.h>
+#include <vil/vil_image_view.h>
+
+#include <object_detectors/pixel_feature_roi.h>
+#include <object_detectors/pixel_feature_roi_process.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+void
+test_layout()
+{
+  std::cout << "Test ROI layout computation\n";
+
+  std::vector< image_region > rois;
+  rois.push_back( image_region( 10, 30, 10, 20 ) );
+  rois.push_back( image_region( 150, 190, 100, 110 ) );
+  rois.push_back( image_region( 12, 28, 15, 25 ) ); // overlaps the first
+
+  pixel_feature_roi_layout layout;
+  layout.compute( 200, 120, rois, 4, 0.6 );
+
+  TEST( "Layout is not identity", layout.is_identity(), false );
+  TEST( "Overlapping regions are merged", layout.packed_regions().size(), 2 );
+  TEST( "Atlas is smaller than frame",
+        layout.atlas_ni() * layout.atlas_nj() < 200u * 120u, true );
+
+  const image_region& merged = layout.packed_regions()[0];
+  TEST( "Merged region is dilated", merged.min_x() == 6 && merged.max_x() == 34 &&
+                                    merged.min_y() == 6 && merged.max_y() == 29, true );
+
+  vil_image_view< bool > mask;
+  layout.fill_mask( mask );
+  TEST( "Mask inside ROI", mask( 20, 18 ) && mask( 160, 105 ), true );
+  TEST( "Mask in dilated margin", mask( 8, 8 ), false );
+  TEST( "Mask outside ROIs", mask( 100, 60 ), false );
+
+  pixel_feature_roi_layout large;
+  rois.push_back( image_region( 0, 200, 0, 100 ) );
+  large.compute( 200, 120, rois, 4, 0.6 );
+  TEST( "Large ROIs fall back to full frame", large.is_identity(), true );
+
+  pixel_feature_roi_layout none;
+  none.compute( 200, 120, std::vector< image_region >(), 4, 0.6 );
+  TEST( "No ROIs fall back to full frame", none.is_identity(), true );
+  none.fill_mask( mask );
+  TEST( "Full frame mask", mask( 100, 60 ), true );
+}
+
+
+void
+test_pack_unpack()
+{
+  std::cout << "Test packing and unpacking images\n";
+
+  vil_image_view< vxl_byte > frame( 64, 48, 3 );
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < 48; ++j )
+    {
+      for( unsigned i = 0; i < 64; ++i )
+      {
+        frame( i, j, p ) = static_cast< vxl_byte >( 1 + ( i + 2 * j + 5 * p ) % 250 );
+      }
+    }
+  }
+
+  std::vector< image_region > rois;
+  add_border_band_regions( 64, 48, 0.05, rois );
+  TEST( "Four border bands", rois.size(), 4 );
+  rois.clear();
+  rois.push_back( image_region( 0, 8, 0, 4 ) );
+  rois.push_back( image_region( 50, 64, 40, 48 ) );
+
+  pixel_feature_roi_layout layout;
+  layout.compute( 64, 48, rois, 2, 0.6 );
+
+  vil_image_view< vxl_byte > atlas, restored;
+  pack_roi_image( layout, frame, atlas );
+  TEST( "Atlas size", atlas.ni() == layout.atlas_ni() && atlas.nj() == layout.atlas_nj(), true );
+  TEST( "Atlas planes", atlas.nplanes(), 3 );
+
+  unpack_roi_image( layout, atlas, restored );
+
+  bool inside_equal = true, outside_zero = true;
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < 48; ++j )
+    {
+      for( unsigned i = 0; i < 64; ++i )
+      {
+        const bool packed = ( i < 10 && j < 6 ) || ( i >= 48 && j >= 38 );
+        if( packed )
+        {
+          inside_equal = inside_equal && restored( i, j, p ) == frame( i, j, p );
+        }
+        else
+        {
+          outside_zero = outside_zero && restored( i, j, p ) == 0;
+        }
+      }
+    }
+  }
+  TEST( "Packed regions round trip", inside_equal, true );
+  TEST( "Other pixels are not computed", outside_zero, true );
+}
+
+
+void
+test_region_sources()
+{
+  std::cout << "Test region sources\n";
+
+  std::vector< vgl_box_2d< double > > normalized;
+  TEST( "Parse regions", parse_normalized_regions( "0 0 0.5 0.1; 0.5,0.9,1,1", normalized ), true );
+  TEST( "Parsed count", normalized.size(), 2 );
+  TEST( "Reject bad regions", parse_normalized_regions( "0 0 1", normalized ), false );
+
+  std::vector< image_region > rois;
+  scale_normalized_regions( normalized, 100, 50, rois );
+  TEST( "Scaled region", rois[0].max_x() == 50 && rois[0].max_y() == 5, true );
+  TEST( "Scaled region clipped", rois[1].max_x() == 100 && rois[1].min_y() == 45, true );
+
+  vil_image_view< bool > mask( 64, 64 );
+  mask.fill( false );
+  mask( 5, 5 ) = true;
+  mask( 40, 50 ) = true;
+  rois.clear();
+  add_mask_regions( mask, 16, rois );
+  TEST( "Mask cells", rois.size(), 2 );
+  TEST( "Mask cell extent", rois[1].min_x() == 32 && rois[1].max_y() == 64, true );
+}
+
+
+void
+test_layout_changed()
+{
+  std::cout << "Test ROI layout change signal\n";
+
+  pixel_feature_roi_pack_process< vxl_byte, vxl_byte > pack( "roi" );
+  config_block blk = pack.params();
+  blk.set( "enabled", "true" );
+  blk.set( "mask_cell_size", "16" );
+  blk.set( "dilation", "4" );
+
+  TEST( "Set params", pack.set_params( blk ), true );
+  TEST( "Initialize", pack.initialize(), true );
+
+  vil_image_view< vxl_byte > img( 128, 96 );
+  img.fill( 0 );
+
+  vil_image_view< bool > mask( 128, 96 );
+  mask.fill( false );
+  mask( 37, 37 ) = true;
+
+  pack.set_source_grey_image( img );
+  pack.set_roi_mask( mask );
+  TEST( "Step", pack.step(), true );
+  TEST( "First layout is a change", pack.layout_changed(), true );
+
+  const unsigned atlas_ni = pack.layout().atlas_ni();
+  const unsigned atlas_nj = pack.layout().atlas_nj();
+
+  pack.set_source_grey_image( img );
+  pack.set_roi_mask( mask );
+  TEST( "Step", pack.step(), true );
+  TEST( "Same regions keep the layout", pack.layout_changed(), false );
+
+  // A region of the same size elsewhere gives an atlas of the same size
+  mask.fill( false );
+  mask( 69, 37 ) = true;
+
+  pack.set_source_grey_image( img );
+  pack.set_roi_mask( mask );
+  TEST( "Step", pack.step(), true );
+  TEST( "Same atlas size", pack.layout().atlas_ni() == atlas_ni &&
+                           pack.layout().atlas_nj() == atlas_nj, true );
+  TEST( "Moved region changes the layout", pack.layout_changed(), true );
+}
+
+
+} // end anonymous namespace
+
+int test_pixel_feature_roi( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "Pixel feature ROI packing" );
+
+  test_layout();
+  test_pack_unpack();
+  test_region_sources();
+  test_layout_changed();
+
+  return testlib_test_summary();
+}
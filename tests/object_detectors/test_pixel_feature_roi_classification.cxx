@@ -0,0 +1,141 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <object_detectors/pixel_feature_extractor_super_process.h>
+
+#include <classifier/hashed_image_classifier.h>
+#include <classifier/hashed_image_classifier_process.h>
+
+#include <vil/vil_image_view.h>
+#include <vil/vil_load.h>
+#include <vil/vil_plane.h>
+#include <vil/vil_convert.h>
+
+#include <testlib/testlib_test.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+
+void test_roi_classification( const std::string& data_dir )
+{
+  std::string img_path = data_dir + "/obstruction_img_1.png";
+  std::string model_path = data_dir + "/simple_hashed_img_classifier.clfr";
+
+  vil_image_view<vxl_byte> loaded = vil_load( img_path.c_str() );
+  vil_image_view<vxl_byte> input_color = vil_planes( loaded, 0, 1, 3 );
+  vil_image_view<vxl_byte> input_grey;
+  vil_convert_planes_to_grey( input_color, input_grey );
+  image_border input_border( 0, input_color.ni(), 0, input_color.nj() );
+
+  // Compute raw color features over the top left region only
+  pixel_feature_extractor_super_process<vxl_byte,vxl_byte> feature_proc( "feature_sp" );
+
+  config_block feature_blk = feature_proc.params();
+  feature_blk.set( "run_async", "false" );
+  feature_blk.set( "enable_raw_color_image", "true" );
+  feature_blk.set( "roi:enabled", "true" );
+  feature_blk.set( "roi:regions", "0 0 0.4 0.4" );
+  feature_blk.set( "roi:dilation", "2" );
+
+  TEST( "Configure features", feature_proc.set_params( feature_blk ), true );
+
+  feature_proc.set_source_color_image( input_color );
+  feature_proc.set_source_grey_image( input_grey );
+  feature_proc.set_border( input_border );
+  feature_proc.step2();
+
+  std::vector< vil_image_view<vxl_byte> > features = feature_proc.feature_array();
+  vil_image_view<bool> roi_mask = feature_proc.roi_mask();
+
+  TEST( "Feature count", features.size(), 3 );
+  TEST( "ROI mask size", roi_mask.ni() == input_color.ni() &&
+                         roi_mask.nj() == input_color.nj(), true );
+
+  if( features.size() != 3 || !roi_mask )
+  {
+    return;
+  }
+
+  // Classify using the ROI mask, as connected in the super processes
+  hashed_image_classifier_process<vxl_byte> classifier_proc( "classifier" );
+
+  config_block clfr_blk = classifier_proc.params();
+  clfr_blk.set( "default_filename", model_path );
+  clfr_blk.set( "roi_fill_value", "-1" );
+
+  TEST( "Configure classifier", classifier_proc.set_params( clfr_blk ), true );
+  TEST( "Initialize classifier", classifier_proc.initialize(), true );
+
+  classifier_proc.set_pixel_features( features );
+  classifier_proc.set_roi_mask( roi_mask );
+
+  TEST( "Classify", classifier_proc.step(), true );
+
+  vil_image_view<double> output = classifier_proc.classified_image();
+
+  // Full frame classification of the same features for reference
+  hashed_image_classifier<vxl_byte,double> reference_clfr;
+  reference_clfr.load_from_file( model_path );
+
+  std::vector< vil_image_view<vxl_byte> > full_features;
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    full_features.push_back( vil_plane( input_color, p ) );
+  }
+
+  vil_image_view<double> reference;
+  reference_clfr.classify_images( full_features, reference );
+
+  unsigned inside = 0, outside = 0;
+  bool outside_skipped = true, inside_matches = true;
+
+  for( unsigned j = 0; j < output.nj(); ++j )
+  {
+    for( unsigned i = 0; i < output.ni(); ++i )
+    {
+      if( roi_mask( i, j ) )
+      {
+        ++inside;
+        inside_matches = inside_matches && output( i, j ) == reference( i, j );
+      }
+      else
+      {
+        ++outside;
+        outside_skipped = outside_skipped && output( i, j ) == -1.0;
+      }
+    }
+  }
+
+  TEST( "ROI covers part of the frame", inside > 0 && outside > 0, true );
+  TEST( "Pixels outside ROI are not classified", outside_skipped, true );
+  TEST( "Pixels inside ROI match full classification", inside_matches, true );
+}
+
+} // end anonymous namespace
+
+int test_pixel_feature_roi_classification( int argc, char* argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Need the data directory as an argument" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  testlib_test_start( "pixel_feature_roi_classification" );
+
+  test_roi_classification( argv[1] );
+
+  return testlib_test_summary();
+}
@@ -0,0 +1,197 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <iostream>
+#include <testlib/testlib_test.h>
+#include <vil/vil_image_view.h>
+
+#include <vnl/vnl_random.h>
+
+#include <object_detectors/planar_gmm_model.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+// Noisy static background with a bright square appearing at frame 40.
+void
+make_frame( vil_image_view<float>& img, unsigned frame, vnl_random& rng )
+{
+  img.set_size( 40, 30, 3 );
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < img.nj(); ++j )
+    {
+      for( unsigned i = 0; i < img.ni(); ++i )
+      {
+        float v = static_cast<float>( 60 + 20*p + rng.normal() * 3 );
+        if( frame >= 40 && i >= 10 && i < 20 && j >= 10 && j < 20 )
+        {
+          v = 250.0f;
+        }
+        img( i, j, p ) = v;
+      }
+    }
+  }
+}
+
+
+unsigned
+count_foreground( vil_image_view<bool> const& bg )
+{
+  unsigned count = 0;
+  for( unsigned j = 0; j < bg.nj(); ++j )
+  {
+    for( unsigned i = 0; i < bg.ni(); ++i )
+    {
+      count += bg( i, j ) ? 0 : 1;
+    }
+  }
+  return count;
+}
+
+
+void
+test_detection_and_absorption( vidtk::planar_gmm_model_params::update_mode_type update,
+                               vidtk::planar_gmm_model_params::covar_mode_type covar )
+{
+  std::cout << "Test detection with update mode " << update
+            << " and covariance mode " << covar << "\n";
+
+  vidtk::planar_gmm_model_params p;
+  p.update_mode = update;
+  p.covar_mode = covar;
+  p.init_variance = 100.0f;
+  p.mininum_stdev = 5.0f;
+  p.lm_window_size = 20;
+  p.sg_learning_rate = 0.05f;
+
+  vidtk::planar_gmm_model model;
+  model.set_params( p );
+  model.initialize( 40, 30, 3 );
+
+  vnl_random rng( 42 );
+  vil_image_view<float> img;
+  vil_image_view<bool> bg;
+  std::vector< std::pair<int,int> > offsets;
+
+  for( unsigned f = 0; f < 40; ++f )
+  {
+    make_frame( img, f, rng );
+    model.update( img );
+  }
+
+  make_frame( img, 40, rng );
+  model.detect( img, bg, offsets );
+  TEST( "New object is detected", count_foreground( bg ) >= 100, true );
+  TEST( "Background is not detected", count_foreground( bg ) <= 110, true );
+
+  for( unsigned f = 40; f < 200; ++f )
+  {
+    make_frame( img, f, rng );
+    model.update( img );
+  }
+  make_frame( img, 200, rng );
+  model.detect( img, bg, offsets );
+  TEST( "Stationary object is absorbed", count_foreground( bg ) <= 10, true );
+
+  vil_image_view<float> mean;
+  model.background( mean );
+  TEST_NEAR( "Background mean", mean( 0, 0, 2 ), 100.0, 3.0 );
+}
+
+
+void
+test_threads_agree()
+{
+  std::cout << "Test that row-parallel execution matches a single thread\n";
+
+  vidtk::planar_gmm_model_params p;
+  vidtk::planar_gmm_model single;
+  vidtk::planar_gmm_model multi;
+  single.set_params( p );
+  p.num_threads = 4;
+  multi.set_params( p );
+  single.initialize( 40, 30, 3 );
+  multi.initialize( 40, 30, 3 );
+
+  std::vector< std::pair<int,int> > offsets;
+  offsets.push_back( std::make_pair( 0, 0 ) );
+  offsets.push_back( std::make_pair( 1, 0 ) );
+  offsets.push_back( std::make_pair( 0, -1 ) );
+
+  vnl_random rng( 7 );
+  vil_image_view<float> img;
+  vil_image_view<bool> bg1, bg2;
+  bool same = true;
+  for( unsigned f = 0; f < 60; ++f )
+  {
+    make_frame( img, f, rng );
+    single.detect( img, bg1, offsets );
+    multi.detect( img, bg2, offsets );
+    for( unsigned j = 0; j < img.nj(); ++j )
+    {
+      for( unsigned i = 0; i < img.ni(); ++i )
+      {
+        same = same && ( bg1( i, j ) == bg2( i, j ) );
+      }
+    }
+    single.update( img );
+    multi.update( img );
+  }
+  TEST( "Masks are identical", same, true );
+}
+
+
+
+void
+test_invalid_background()
+{
+  std::cout << "Test the background of pixels without components\n";
+
+  vidtk::planar_gmm_model model;
+  model.initialize( 8, 6, 3 );
+
+  float const invalid[3] = { 0.0f, 255.0f, 0.0f };
+  vil_image_view<float> mean;
+  model.background( mean, invalid );
+  TEST( "Empty model has the invalid color",
+        mean( 3, 2, 0 ) == 0.0f && mean( 3, 2, 1 ) == 255.0f && mean( 7, 5, 2 ) == 0.0f, true );
+
+  vnl_random rng( 3 );
+  vil_image_view<float> img;
+  make_frame( img, 0, rng );
+  vil_image_view<float> small( 8, 6, 3 );
+  for( unsigned p = 0; p < 3; ++p )
+  {
+    for( unsigned j = 0; j < 6; ++j )
+    {
+      for( unsigned i = 0; i < 8; ++i )
+      {
+        small( i, j, p ) = img( i, j, p );
+      }
+    }
+  }
+  model.update( small );
+  model.background( mean, invalid );
+  TEST_NEAR( "Updated pixel has its mean", mean( 3, 2, 1 ), small( 3, 2, 1 ), 1e-3 );
+}
+
+} // end anonymous namespace
+
+int test_planar_gmm_model( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "Planar Gaussian Mixture Model" );
+
+  test_detection_and_absorption( vidtk::planar_gmm_model_params::UPDATE_LM,
+                                 vidtk::planar_gmm_model_params::COVAR_INDEP );
+  test_detection_and_absorption( vidtk::planar_gmm_model_params::UPDATE_SG,
+                                 vidtk::planar_gmm_model_params::COVAR_SPHERE );
+  test_threads_agree();
+  test_invalid_background();
+
+  return testlib_test_summary();
+}
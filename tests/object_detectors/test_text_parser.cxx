@@ -59,6 +59,26 @@ void test_text_parser( std::string template_dir, std::string image_path )
     TEST( "TM - Output size", output.size(), 7 );
     TEST( "TM - Output contents", output, "ABADBED" );
   }
+
+  // Test parser class with templates matched on multiple threads
+  {
+    text_parser<vxl_byte> parser;
+    text_parser_settings settings;
+
+    settings.model_directory = template_dir;
+    settings.algorithm = text_parser_settings::TEMPLATE_MATCHING;
+    settings.vertical_jitter = 1;
+    settings.thread_count = 3;
+
+    TEST( "TM Threaded - Test initial configure", parser.configure( settings ), true );
+
+    text_parser_instruction<vxl_byte> instruction;
+    instruction.region = text_parser_instruction<vxl_byte>::region_t( 0, 1, 0, 1 );
+
+    std::string output = parser.parse_text( image, instruction );
+
+    TEST( "TM Threaded - Output contents", output, "ABADBED" );
+  }
 }
 
 } // end anonymous namespace
@@ -0,0 +1,200 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include "sample_nodes.h"
+
+#include <pipeline_framework/sync_pipeline.h>
+#include <pipeline_framework/async_pipeline.h>
+#include <testlib/testlib_test.h>
+#include <iostream>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+
+// Passes its input through and records the feedback received on each
+// step.
+struct feedback_sink
+  : public process
+{
+  typedef feedback_sink self_type;
+
+  feedback_sink( std::string const& _name )
+    : process( _name, "feedback_sink" ),
+      value_( 0 ),
+      has_feedback_( false ),
+      feedback_( 0 )
+  {
+  }
+
+  config_block params() const
+  {
+    return config_block();
+  }
+
+  bool set_params( config_block const& )
+  {
+    return true;
+  }
+
+  bool initialize()
+  {
+    inputs_.clear();
+    received_.clear();
+    feedback_values_.clear();
+    return true;
+  }
+
+  bool step()
+  {
+    inputs_.push_back( value_ );
+    received_.push_back( has_feedback_ );
+    feedback_values_.push_back( feedback_ );
+    has_feedback_ = false;
+    return true;
+  }
+
+  void set_value( unsigned d )
+  {
+    value_ = d;
+  }
+
+  VIDTK_INPUT_PORT( set_value, unsigned );
+
+  void set_feedback( unsigned d )
+  {
+    has_feedback_ = true;
+    feedback_ = d;
+  }
+
+  VIDTK_OPTIONAL_INPUT_PORT( set_feedback, unsigned );
+
+  unsigned value() const
+  {
+    return value_;
+  }
+
+  VIDTK_OUTPUT_PORT( unsigned, value );
+
+  unsigned value_;
+  bool has_feedback_;
+  unsigned feedback_;
+  std::vector< unsigned > inputs_;
+  std::vector< bool > received_;
+  std::vector< unsigned > feedback_values_;
+};
+
+
+template< class P >
+void
+build_feedback_pipeline( P& p,
+                         process_smart_pointer< feedback_sink > const& sink )
+{
+  process_smart_pointer< numbers > nums( new numbers( "numbers", 7, 1 ) );
+  process_smart_pointer< add > sum( new add( "sum" ) );
+
+  p.add( nums );
+  p.add( sink );
+  p.add( sum );
+
+  p.connect( nums->value_port(),
+             sink->set_value_port() );
+  p.connect( sink->value_port(),
+             sum->set_value1_port() );
+  p.connect( sink->value_port(),
+             sum->set_value2_port() );
+
+  // The sum is computed after the sink executes, so this would be a
+  // cycle with a regular connection.
+  p.connect_without_dependency( sum->sum_port(),
+                                sink->set_feedback_port() );
+}
+
+
+void
+test_sync_feedback()
+{
+  std::cout << "Testing feedback on sync_pipeline\n";
+
+  sync_pipeline p;
+  process_smart_pointer< feedback_sink > sink( new feedback_sink( "sink" ) );
+  build_feedback_pipeline( p, sink );
+
+  TEST( "Pipeline initialize", p.initialize(), true );
+  TEST( "Run", p.run(), true );
+  TEST( "Number of steps", sink->inputs_.size(), 7 );
+
+  bool good = true;
+  for( unsigned i = 1; i < sink->inputs_.size(); ++i )
+  {
+    if( !sink->received_[i] ||
+        sink->feedback_values_[i] != 2 * sink->inputs_[i-1] )
+    {
+      std::cout << "Step " << i << ": received feedback "
+                << sink->feedback_values_[i] << ", expected "
+                << 2 * sink->inputs_[i-1] << "\n";
+      good = false;
+    }
+  }
+  TEST( "Feedback is the output of the previous step", good, true );
+}
+
+
+void
+test_async_feedback()
+{
+  std::cout << "Testing feedback on async_pipeline\n";
+
+  async_pipeline p;
+  process_smart_pointer< feedback_sink > sink( new feedback_sink( "sink" ) );
+  build_feedback_pipeline( p, sink );
+
+  // The feedback edge must not block either node, so the pipeline
+  // has to terminate regardless of how the threads interleave.
+  TEST( "Pipeline initialize", p.initialize(), true );
+  TEST( "Run", p.run(), true );
+  TEST( "Number of steps", sink->inputs_.size(), 7 );
+
+  // Feedback arrives late or not at all, but only ever comes from an
+  // earlier step, in order.
+  bool good = true;
+  unsigned last_feedback = 0;
+  for( unsigned i = 0; i < sink->inputs_.size(); ++i )
+  {
+    if( !sink->received_[i] )
+    {
+      continue;
+    }
+    unsigned fb = sink->feedback_values_[i];
+    if( i == 0 || fb % 2 != 0 || fb < 2 || fb > 2 * sink->inputs_[i-1] ||
+        fb < last_feedback )
+    {
+      std::cout << "Step " << i << ": unexpected feedback " << fb << "\n";
+      good = false;
+    }
+    last_feedback = fb;
+  }
+  TEST( "Feedback comes from earlier steps", good, true );
+
+  // Data left on the feedback edge must not prevent a reset.
+  TEST( "Pipeline reset", p.reset(), true );
+}
+
+
+} // end anonymous namespace
+
+int test_connect_feedback( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "test_connect_feedback" );
+
+  test_sync_feedback();
+  test_async_feedback();
+
+  return testlib_test_summary();
+}
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -95,9 +95,19 @@ test_translation( vidtk::homography_process const& hp,
 
 
 void
-test_expected_translation()
+set_estimator( vidtk::homography_process& hp, std::string const& estimator )
 {
-  std::cout << "\n\n\nTest estimation under image translation\n\n";
+  vidtk::config_block blk = hp.params();
+  blk.set( "homography_estimator", estimator );
+  TEST( ("Set " + estimator + " estimator").c_str(), hp.set_params( blk ), true );
+}
+
+
+void
+test_expected_translation( std::string const& estimator )
+{
+  std::cout << "\n\n\nTest estimation under image translation ("
+            << estimator << ")\n\n";
 
   using namespace vidtk;
 
@@ -115,7 +125,7 @@ test_expected_translation()
   TEST( "Initialize", tp.initialize(), true );
 
   std::cout << "Homography\n";
-  //TEST( "Set parameters", hp.set_params( blk ), true );
+  set_estimator( hp, estimator );
   TEST( "Initialize", hp.initialize(), true );
 
   // For verification
@@ -165,9 +175,10 @@ test_expected_translation()
 
 
 void
-test_expected_translation_with_mask( bool use_mask )
+test_expected_translation_with_mask( bool use_mask, std::string const& estimator )
 {
-  std::cout << "\n\n\nTest estimation with a provided mask\n\n";
+  std::cout << "\n\n\nTest estimation with a provided mask ("
+            << estimator << ")\n\n";
 
   using namespace vidtk;
 
@@ -190,7 +201,7 @@ test_expected_translation_with_mask( bool use_mask )
   TEST( "Initialize", tp.initialize(), true );
 
   std::cout << "Homography\n";
-  //TEST( "Set parameters", hp.set_params( blk ), true );
+  set_estimator( hp, estimator );
   TEST( "Initialize", hp.initialize(), true );
 
   // For verification
@@ -242,9 +253,13 @@ int test_homography_process( int argc, char* argv[] )
     g_data_dir = argv[1];
     g_data_dir += "/";
 
-    test_expected_translation();
-    test_expected_translation_with_mask( false );
-    test_expected_translation_with_mask( true );
+    test_expected_translation( "rrel" );
+    test_expected_translation_with_mask( false, "rrel" );
+    test_expected_translation_with_mask( true, "rrel" );
+
+    test_expected_translation( "parallel_ransac" );
+    test_expected_translation_with_mask( false, "parallel_ransac" );
+    test_expected_translation_with_mask( true, "parallel_ransac" );
   }
 
   return testlib_test_summary();
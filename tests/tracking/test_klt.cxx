@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -11,6 +11,10 @@
 
 #include <klt/klt.h>
 
+#include <utilities/compute_pool.h>
+
+#include <boost/bind.hpp>
+
 // Put everything in an anonymous namespace so that different tests
 // won't conflict.
 namespace {
@@ -99,6 +103,70 @@ test_expected_translation()
 }
 
 
+void
+track_range( KLT_RangeFunction func, void* func_data, unsigned begin, unsigned end )
+{
+  func( func_data, static_cast<int>(begin), static_cast<int>(end) );
+}
+
+
+void
+pool_parallel_for( void* /*user_data*/, int begin, int end,
+                   KLT_RangeFunction func, void* func_data )
+{
+  vidtk::compute_pool::instance()->parallel_for(
+    begin, end, boost::bind( &track_range, func, func_data, _1, _2 ), "test_klt" );
+}
+
+
+void
+test_parallel_tracking()
+{
+  std::cout << "Test tracking on several threads\n";
+
+  vil_image_view<vxl_byte> img0 = vil_load( (g_data_dir+"/ocean_city.png").c_str() );
+  vil_image_view<vxl_byte> img1 = vil_load( (g_data_dir+"/ocean_city_trans+16+6.png").c_str() );
+
+  int nFeatures = 1000;
+  KLT_TrackingContext tc = KLTCreateTrackingContext();
+  KLT_FeatureList serial_fl = KLTCreateFeatureList(nFeatures);
+  KLT_FeatureList parallel_fl = KLTCreateFeatureList(nFeatures);
+
+  KLTSelectGoodFeatures(tc, img0.top_left_ptr(), img0.ni(), img0.nj(), serial_fl);
+  KLTSelectGoodFeatures(tc, img0.top_left_ptr(), img0.ni(), img0.nj(), parallel_fl);
+
+  KLTTrackFeatures(tc, img0.top_left_ptr(), img1.top_left_ptr(),
+                   img0.ni(), img0.nj(), NULL, serial_fl);
+
+  vidtk::compute_pool_t pool = vidtk::compute_pool::instance();
+  const unsigned budget = pool->core_budget();
+  pool->set_core_budget( 4 );
+
+  tc->parallel_for = &pool_parallel_for;
+  KLTTrackFeatures(tc, img0.top_left_ptr(), img1.top_left_ptr(),
+                   img0.ni(), img0.nj(), NULL, parallel_fl);
+
+  pool->set_core_budget( budget );
+
+  int differ = 0;
+  for (int i = 0 ; i < nFeatures ; i++)
+  {
+    if( serial_fl->feature[i]->val != parallel_fl->feature[i]->val ||
+        serial_fl->feature[i]->x != parallel_fl->feature[i]->x ||
+        serial_fl->feature[i]->y != parallel_fl->feature[i]->y )
+    {
+      ++differ;
+    }
+  }
+
+  TEST( "Same result as tracking on one thread", differ, 0 );
+
+  KLTFreeTrackingContext(tc);
+  KLTFreeFeatureList(serial_fl);
+  KLTFreeFeatureList(parallel_fl);
+}
+
+
 } // end anonymous namespace
 
 int test_klt( int argc, char* argv[] )
@@ -114,6 +182,7 @@ int test_klt( int argc, char* argv[] )
     g_data_dir = argv[1];
 
     test_expected_translation();
+    test_parallel_tracking();
   }
 
   return testlib_test_summary();
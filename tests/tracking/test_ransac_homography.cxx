@@ -0,0 +1,289 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <tracking/ransac_homography.h>
+#include <utilities/compute_pool.h>
+
+#include <vnl/vnl_double_3x3.h>
+#include <vnl/vnl_random.h>
+#include <vnl/vnl_vector.h>
+
+#include <rrel/rrel_homography2d_est.h>
+#include <rrel/rrel_irls.h>
+#include <rrel/rrel_ran_sam_search.h>
+#include <rrel/rrel_trunc_quad_obj.h>
+
+#include <vul/vul_timer.h>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+
+vnl_double_2
+apply( vnl_double_3x3 const& H, vnl_double_2 const& p )
+{
+  double w = H( 2, 0 ) * p[0] + H( 2, 1 ) * p[1] + H( 2, 2 );
+  return vnl_double_2( ( H( 0, 0 ) * p[0] + H( 0, 1 ) * p[1] + H( 0, 2 ) ) / w,
+                       ( H( 1, 0 ) * p[0] + H( 1, 1 ) * p[1] + H( 1, 2 ) ) / w );
+}
+
+
+// Largest distance between the images of the frame corners under two homographies
+double
+corner_difference( vnl_double_3x3 const& H1, vnl_double_3x3 const& H2 )
+{
+  double const corners[4][2] = { {0, 0}, {1279, 0}, {1279, 719}, {0, 719} };
+  double worst = 0.0;
+
+  for( unsigned i = 0; i < 4; ++i )
+  {
+    vnl_double_2 c( corners[i][0], corners[i][1] );
+    vnl_double_2 a = apply( H1, c );
+    vnl_double_2 b = apply( H2, c );
+    double dist = std::sqrt( ( a[0] - b[0] ) * ( a[0] - b[0] ) +
+                             ( a[1] - b[1] ) * ( a[1] - b[1] ) );
+    worst = std::max( worst, dist );
+  }
+
+  return worst;
+}
+
+
+vnl_double_3x3
+true_homography()
+{
+  vnl_double_3x3 H;
+  double angle = 0.02;
+  H( 0, 0 ) = 1.01 * std::cos( angle ); H( 0, 1 ) = -std::sin( angle ); H( 0, 2 ) = 12.5;
+  H( 1, 0 ) = std::sin( angle );        H( 1, 1 ) = 0.99 * std::cos( angle ); H( 1, 2 ) = -7.25;
+  H( 2, 0 ) = 2e-5;                     H( 2, 1 ) = -1e-5;                H( 2, 2 ) = 1.0;
+  return H;
+}
+
+
+// Tracked features with noise; outliers are spread through the
+// ordering, but rarer among the first (oldest) correspondences.
+void
+make_correspondences( unsigned count, double outlier_fraction,
+                      std::vector< vnl_double_2 >& from,
+                      std::vector< vnl_double_2 >& to,
+                      std::vector< bool >& is_inlier )
+{
+  vnl_random rng( 1234 );
+  vnl_double_3x3 H = true_homography();
+
+  from.clear();
+  to.clear();
+  is_inlier.clear();
+
+  for( unsigned i = 0; i < count; ++i )
+  {
+    vnl_double_2 p( rng.drand64( 0, 1279 ), rng.drand64( 0, 719 ) );
+    vnl_double_2 q = apply( H, p );
+
+    double rank = static_cast< double >( i ) / count;
+    bool outlier = rng.drand64( 0, 1 ) < outlier_fraction * 2.0 * rank;
+
+    if( outlier )
+    {
+      q = vnl_double_2( rng.drand64( 0, 1279 ), rng.drand64( 0, 719 ) );
+    }
+    else
+    {
+      q[0] += rng.drand64( -0.3, 0.3 );
+      q[1] += rng.drand64( -0.3, 0.3 );
+    }
+
+    from.push_back( p );
+    to.push_back( q );
+    is_inlier.push_back( ! outlier );
+  }
+}
+
+
+bool
+estimate_with_rrel( std::vector< vnl_double_2 > const& from,
+                    std::vector< vnl_double_2 > const& to,
+                    vnl_double_3x3& H )
+{
+  std::vector< vnl_vector< double > > from_pts;
+  std::vector< vnl_vector< double > > to_pts;
+  vnl_vector< double > p( 3, 1.0 );
+
+  for( unsigned i = 0; i < from.size(); ++i )
+  {
+    p[0] = from[i][0];
+    p[1] = from[i][1];
+    from_pts.push_back( p );
+    p[0] = to[i][0];
+    p[1] = to[i][1];
+    to_pts.push_back( p );
+  }
+
+  rrel_homography2d_est hg( from_pts, to_pts );
+  rrel_trunc_quad_obj msac;
+  rrel_ran_sam_search ransam( 42 );
+  ransam.set_trace_level( 0 );
+
+  if( ! ransam.estimate( &hg, &msac ) )
+  {
+    return false;
+  }
+
+  rrel_irls irls;
+  irls.initialize_params( ransam.params() );
+  if( irls.estimate( &hg, &msac ) )
+  {
+    hg.params_to_homog( irls.params(), H.as_ref().non_const() );
+  }
+  else
+  {
+    hg.params_to_homog( ransam.params(), H.as_ref().non_const() );
+  }
+  H /= H( 2, 2 );
+
+  return true;
+}
+
+
+void
+test_accuracy()
+{
+  std::cout << "\nAccuracy with outliers\n";
+
+  std::vector< vnl_double_2 > from, to;
+  std::vector< bool > truth;
+  make_correspondences( 1500, 0.3, from, to, truth );
+
+  ransac_homography_estimator est;
+  vnl_double_3x3 H;
+
+  TEST( "Estimate succeeds", est.estimate( from, to, H ), true );
+  TEST_NEAR( "Corners agree with true homography",
+             corner_difference( H, true_homography() ), 0.0, 0.5 );
+
+  unsigned wrong = 0;
+  for( unsigned i = 0; i < truth.size(); ++i )
+  {
+    wrong += ( est.inliers()[i] != truth[i] ? 1 : 0 );
+  }
+  std::cout << wrong << " inliers misclassified, "
+            << est.hypotheses_evaluated() << " hypotheses\n";
+  TEST( "Few inliers misclassified", wrong < truth.size() / 100, true );
+  TEST( "Search terminated early",
+        est.hypotheses_evaluated() < est.params().max_iterations, true );
+}
+
+
+void
+test_thread_independence()
+{
+  std::cout << "\nResults independent of the core budget\n";
+
+  std::vector< vnl_double_2 > from, to;
+  std::vector< bool > truth;
+  make_correspondences( 2000, 0.4, from, to, truth );
+
+  compute_pool_t pool = compute_pool::instance();
+  const unsigned budget = pool->core_budget();
+
+  ransac_homography_estimator est;
+  vnl_double_3x3 H1, H4;
+
+  pool->set_core_budget( 1 );
+  est.estimate( from, to, H1 );
+  unsigned hyp1 = est.hypotheses_evaluated();
+
+  pool->set_core_budget( 4 );
+  est.estimate( from, to, H4 );
+  unsigned hyp4 = est.hypotheses_evaluated();
+
+  pool->set_core_budget( budget );
+
+  TEST( "Same number of hypotheses", hyp1, hyp4 );
+  TEST_NEAR( "Same homography", ( H1 - H4 ).frobenius_norm(), 0.0, 1e-12 );
+}
+
+
+void
+test_agrees_with_rrel()
+{
+  std::cout << "\nAgreement with rrel estimation\n";
+
+  std::vector< vnl_double_2 > from, to;
+  std::vector< bool > truth;
+  make_correspondences( 1500, 0.3, from, to, truth );
+
+  vul_timer rrel_timer;
+  vnl_double_3x3 H_rrel;
+  bool rrel_ok = estimate_with_rrel( from, to, H_rrel );
+  long rrel_ms = rrel_timer.real();
+
+  vul_timer native_timer;
+  ransac_homography_estimator est;
+  vnl_double_3x3 H;
+  bool native_ok = est.estimate( from, to, H );
+  long native_ms = native_timer.real();
+
+  std::cout << from.size() << " correspondences: rrel " << rrel_ms
+            << " ms, parallel ransac " << native_ms << " ms\n";
+
+  TEST( "Both estimates succeed", rrel_ok && native_ok, true );
+  TEST_NEAR( "Corners agree with rrel", corner_difference( H, H_rrel ), 0.0, 0.5 );
+}
+
+
+void
+test_degenerate()
+{
+  std::cout << "\nDegenerate input\n";
+
+  ransac_homography_estimator est;
+  vnl_double_3x3 H;
+
+  std::vector< vnl_double_2 > from, to;
+  for( unsigned i = 0; i < 3; ++i )
+  {
+    from.push_back( vnl_double_2( i, i * i ) );
+    to.push_back( vnl_double_2( i, i * i ) );
+  }
+  TEST( "Too few points", est.estimate( from, to, H ), false );
+
+  // All points on a line
+  from.clear();
+  to.clear();
+  for( unsigned i = 0; i < 50; ++i )
+  {
+    from.push_back( vnl_double_2( i, 2 * i ) );
+    to.push_back( vnl_double_2( i + 1, 2 * i + 1 ) );
+  }
+  TEST( "Collinear points", est.estimate( from, to, H ), false );
+}
+
+} // end anonymous namespace
+
+
+int test_ransac_homography( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "ransac_homography" );
+
+  test_accuracy();
+  test_thread_independence();
+  test_agrees_with_rrel();
+  test_degenerate();
+
+  return testlib_test_summary();
+}
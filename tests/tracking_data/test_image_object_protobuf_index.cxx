@@ -0,0 +1,244 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <vul/vul_temp_filename.h>
+#include <vul/vul_file.h>
+#include <testlib/testlib_test.h>
+
+#include <tracking_data/image_object.h>
+#include <tracking_data/io/image_object_writer_process.h>
+#include <tracking_data/io/image_object_reader_protobuf.h>
+
+#include <boost/cstdint.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include <string>
+
+
+using namespace vidtk;
+using namespace vidtk::ns_image_object_reader;
+
+// put everything in an anonymous namespace to avoid conflicts with
+// other tests
+namespace
+{
+
+unsigned const num_frames = 6;
+
+// Serialized size of one footer entry and of the trailer after them
+std::size_t const entry_size = 2 * sizeof( boost::uint64_t ) + sizeof( unsigned ) + sizeof( double );
+std::size_t const trailer_size = sizeof( boost::uint64_t ) + 8;
+
+
+// Frame i holds a single object whose area is 10 * i.
+void
+write_frames( std::string const& fn )
+{
+  image_object_writer_process wr( "wr" );
+  config_block blk = wr.params();
+  blk.set( "disabled", "false" );
+  blk.set( "format", "protobuf" );
+  blk.set( "filename", fn );
+  blk.set( "overwrite_existing", "true" );
+
+  TEST( "Set params", wr.set_params( blk ), true );
+  TEST( "Initialize", wr.initialize(), true );
+
+  for ( unsigned i = 1; i <= num_frames; ++i )
+  {
+    image_object_sptr o = new image_object;
+    o->set_area( 10.0 * i );
+    o->set_image_loc( 1, 1 );
+
+    std::vector< image_object_sptr > objs( 1, o );
+    wr.set_timestamp( timestamp( i * 1.0e5, i ) );
+    wr.set_image_objects( objs );
+    wr.step();
+  }
+
+  // The footer is written when the writer is destroyed
+}
+
+
+std::vector< char >
+read_file( std::string const& fn )
+{
+  std::ifstream str( fn.c_str(), std::ios::in | std::ios::binary );
+  return std::vector< char >( std::istreambuf_iterator< char >( str ),
+                              std::istreambuf_iterator< char >() );
+}
+
+
+void
+write_file( std::string const& fn, std::vector< char > const& data )
+{
+  std::ofstream str( fn.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  str.write( &data[0], data.size() );
+}
+
+
+// Check frames [2,4] through seeking and range reads.
+void
+test_reader( std::string const& fn, bool expect_index )
+{
+  {
+    image_object_reader_protobuf rd;
+    TEST( "Open", rd.open( fn ), true );
+    TEST( "Has frame index", rd.has_frame_index(), expect_index );
+
+    datum_t datum;
+    TEST( "Seek to middle frame", rd.seek_to_frame( 4 ), true );
+    TEST( "Read after seek", rd.read_next( datum ), true );
+    TEST( "Frame after seek", datum.first.frame_number(), 4 );
+    TEST( "Object after seek", datum.second && datum.second->get_area() == 40.0, true );
+    TEST( "Read next frame", rd.read_next( datum ), true );
+    TEST( "Next frame", datum.first.frame_number(), 5 );
+
+    TEST( "Seek back", rd.seek_to_frame( 1 ), true );
+    TEST( "Read after seeking back", rd.read_next( datum ), true );
+    TEST( "Frame after seeking back", datum.first.frame_number(), 1 );
+
+    TEST( "Seek past the end", rd.seek_to_frame( num_frames + 1 ), false );
+  }
+
+  {
+    image_object_reader_protobuf rd;
+    TEST( "Open", rd.open( fn ), true );
+
+    std::vector< ts_object_vector_t > frames;
+    TEST( "Read frame range", rd.read_frames( 2, 4, frames ), true );
+    TEST( "Frame range size", frames.size(), 3 );
+
+    bool good = ( frames.size() == 3 );
+    for ( unsigned i = 0; good && i < frames.size(); ++i )
+    {
+      good = frames[i].first.frame_number() == i + 2 &&
+             frames[i].second.size() == 1 &&
+             frames[i].second[0]->get_area() == 10.0 * ( i + 2 );
+    }
+    TEST( "Frame range contents", good, true );
+
+    // Range reads do not move the sequential position
+    datum_t datum;
+    TEST( "Read from start", rd.read_next( datum ), true );
+    TEST( "First frame", datum.first.frame_number(), 1 );
+
+    TEST( "Empty frame range", rd.read_frames( num_frames + 1, num_frames + 5, frames ), true );
+    TEST( "Empty frame range size", frames.size(), 0 );
+  }
+}
+
+
+void
+test_with_footer( std::string const& fn )
+{
+  std::cout << "\n\nReading with frame index\n\n";
+
+  test_reader( fn, true );
+
+  image_object_reader_protobuf rd;
+  rd.open( fn );
+  TEST( "Index entries", rd.frame_index().size(), num_frames );
+}
+
+
+void
+test_without_footer( std::string const& fn, std::string const& out_fn )
+{
+  std::cout << "\n\nReading without frame index\n\n";
+
+  std::vector< char > data = read_file( fn );
+
+  image_object_reader_protobuf rd;
+  rd.open( fn );
+  image_object_protobuf_index_t const& index = rd.frame_index();
+  if ( index.empty() )
+  {
+    TEST( "Source file has a frame index", false, true );
+    return;
+  }
+
+  // Keep the records only, as written by older writers
+  data.resize( static_cast< std::size_t >( index.back().offset + index.back().size ) );
+  write_file( out_fn, data );
+
+  test_reader( out_fn, false );
+}
+
+
+void
+test_bad_footer( std::string const& fn, std::string const& out_fn )
+{
+  std::vector< char > data = read_file( fn );
+  if ( data.size() < trailer_size + num_frames * entry_size )
+  {
+    TEST( "Source file has a frame index", false, true );
+    return;
+  }
+
+  std::size_t const data_end = data.size() - trailer_size - num_frames * entry_size;
+  boost::uint64_t value;
+
+  std::cout << "\n\nReading with an overflowing record offset\n\n";
+
+  {
+    std::vector< char > bad = data;
+
+    // offset + size of the first record wraps around
+    value = ~static_cast< boost::uint64_t >( 0 ) - 4;
+    std::memcpy( &bad[data_end], &value, sizeof( value ) );
+    write_file( out_fn, bad );
+
+    test_reader( out_fn, false );
+  }
+
+  std::cout << "\n\nReading with a record past the end of the data\n\n";
+
+  {
+    std::vector< char > bad = data;
+
+    // Third record runs into the footer
+    value = data_end;
+    std::memcpy( &bad[data_end + 2 * entry_size + sizeof( value )], &value, sizeof( value ) );
+    write_file( out_fn, bad );
+
+    test_reader( out_fn, false );
+  }
+}
+
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------
+/** Main test driver.
+ *
+ *
+ */
+int test_image_object_protobuf_index( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "image object protobuf index" );
+
+  std::string fn = vul_temp_filename();
+  std::cout << "Using temp file " << fn << "\n";
+
+  write_frames( fn );
+
+  std::string const kwpc = fn + ".kwpc";
+  std::string const out_kwpc = fn + "_modified.kwpc";
+
+  test_with_footer( kwpc );
+  test_without_footer( kwpc, out_kwpc );
+  test_bad_footer( kwpc, out_kwpc );
+
+  TEST( "Delete temp files", vul_file::delete_file_glob( fn + "*.kwpc" ), true );
+
+  return testlib_test_summary();
+}
@@ -1,13 +1,16 @@
 /*ckwg +5
- * Copyright 2010-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 
 #include <tracking_data/io/track_reader.h>
+#include <tracking_data/io/kw18_text_parser.h>
 #include <testlib/testlib_test.h>
 #include <vul/vul_temp_filename.h>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <stdio.h>
 
@@ -360,6 +363,109 @@ void test_next_terminated( char * path )
   TEST("Frame count", count, 263 );
 }
 
+
+// ----------------------------------------------------------------
+// The fast number conversions must match atoi() and atof() exactly
+void test_number_parsing()
+{
+  char const* values[] = {
+    "0", "-0", "+0", "17", "-17", "007", "2147483647", "-2147483648",
+    "12.5", "-12.5", ".5", "-.5", "5.", "0.1", "0.3", "123.456789",
+    "197.768", "0.31962200000000002", "1e3", "1E-3", "-2.5e+10", "1e",
+    "1e+", "3.14abc", "1e400", "1e-400", "123456789012345678901234",
+    "0.000000000000000000000000123", "9007199254740993", "0x1A",
+    "inf", "-nan", "abc", "", "-", "\t42", "1.7976931348623157e308",
+    "4.9e-324", "1444000000.123456", "-1"
+  };
+
+  for ( unsigned i = 0; i < sizeof( values ) / sizeof( values[0] ); ++i )
+  {
+    char const* begin = values[i];
+    char const* end = begin + std::strlen( begin );
+
+    const double expected = std::atof( begin );
+    const double found = vidtk::kw18_parse_double( begin, end );
+
+    std::ostringstream oss;
+    oss << "Parse \"" << values[i] << "\"";
+
+    // Compare the bits, so that nan and -0 are checked too
+    TEST( ( oss.str() + " as double" ).c_str(),
+          std::memcmp( &expected, &found, sizeof( double ) ), 0 );
+    TEST( ( oss.str() + " as int" ).c_str(),
+          vidtk::kw18_parse_int( begin, end ), std::atoi( begin ) );
+  }
+}
+
+
+// ----------------------------------------------------------------
+// Test reading a file large enough to be parsed in several ranges,
+// with comments, blank lines and interleaved tracks.
+void test_5( char* /*path*/ )
+{
+  scoped_file track_file;
+  if ( ! track_file ) { return; }
+
+  const unsigned num_frames = 2000;
+  const unsigned num_tracks = 10;
+
+  track_file() << "# kw18 file with interleaved tracks\n";
+
+  for ( unsigned f = 0; f < num_frames; ++f )
+  {
+    for ( unsigned t = 0; t < num_tracks; ++t )
+    {
+      // Tracks start in reverse id order on the first frame
+      const unsigned id = 100 + ( num_tracks - 1 - t );
+
+      track_file() << id << " " << num_frames << " " << f << " "
+                   << f * 0.25 << " " << t + 0.125 << " 0.5 -0.5 "
+                   << f * 0.25 << " " << t + 0.125 << " "
+                   << t << " " << f << " " << t + 10 << " " << f + 10 << " "
+                   << 100 << " 0 0 0 " << f * 0.1 << "  # comment\n";
+
+      if ( t == 3 )
+      {
+        track_file() << "   \t \n\n# whole line comment\n";
+      }
+    }
+  }
+  track_file.close();
+
+  vidtk::track_reader reader( track_file.filename() );
+
+  if ( ! reader.open() )
+  {
+    TEST( "Open large kw18 file", false, true );
+    return;
+  }
+
+  vidtk::track::vector_t tracks;
+  TEST( "Read large kw18 file", reader.read_all( tracks ), num_tracks );
+
+  bool ids_ok = true;
+  bool states_ok = true;
+
+  for ( unsigned t = 0; t < tracks.size(); ++t )
+  {
+    ids_ok = ids_ok && ( tracks[t]->id() == 100 + ( num_tracks - 1 - t ) );
+
+    std::vector< vidtk::track_state_sptr > const& hist = tracks[t]->history();
+    states_ok = states_ok && ( hist.size() == num_frames );
+
+    for ( unsigned f = 0; states_ok && f < hist.size(); ++f )
+    {
+      states_ok = ( hist[f]->time_.frame_number() == f ) &&
+                  ( hist[f]->loc_[0] == f * 0.25 ) &&
+                  ( hist[f]->loc_[1] == t + 0.125 ) &&
+                  ( hist[f]->amhi_bbox_.max_y() == static_cast< int >( f + 10 ) );
+    }
+  }
+
+  TEST( "Tracks are in order of first appearance", ids_ok, true );
+  TEST( "States are in file order", states_ok, true );
+}
+
 } // end anon ns
 
 
@@ -386,6 +492,9 @@ int test_kw18_reader( int argc, char *argv[] )
   test_4a( argv[1] );
   test_4b( argv[1] );
 
+  test_number_parsing();
+  test_5( argv[1] );
+
   test_clif( argv[1] );
   test_next_terminated( argv[1] );
 
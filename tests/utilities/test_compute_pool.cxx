@@ -0,0 +1,285 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <utilities/compute_pool.h>
+#include <utilities/training_thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace vidtk;
+
+namespace
+{
+
+void mark_range( std::vector< int >* hits, unsigned first, unsigned last )
+{
+  for( unsigned i = first; i < last; ++i )
+  {
+    ++(*hits)[i];
+  }
+}
+
+void nested_range( std::vector< int >* hits, unsigned first, unsigned last )
+{
+  // Each outer range is itself split across the pool
+  compute_pool::instance()->parallel_for(
+    first, last, boost::bind( mark_range, hits, _1, _2 ), "test_inner" );
+}
+
+void mark_tile( std::vector< int >* hits, unsigned width, vgl_box_2d<int> const& tile )
+{
+  for( int j = tile.min_y(); j < tile.max_y(); ++j )
+  {
+    for( int i = tile.min_x(); i < tile.max_x(); ++i )
+    {
+      ++(*hits)[ j * width + i ];
+    }
+  }
+}
+
+void throw_error()
+{
+  throw std::runtime_error( "task failure" );
+}
+
+void record_thread( boost::thread::id* id )
+{
+  *id = boost::this_thread::get_id();
+}
+
+struct signal_flag
+{
+  signal_flag() : set( false ) {}
+
+  void notify()
+  {
+    boost::lock_guard< boost::mutex > lock( mutex );
+    set = true;
+    cond.notify_all();
+  }
+
+  bool wait()
+  {
+    boost::unique_lock< boost::mutex > lock( mutex );
+
+    while( !set )
+    {
+      if( !cond.timed_wait( lock, boost::posix_time::seconds( 10 ) ) )
+      {
+        return set;
+      }
+    }
+
+    return true;
+  }
+
+  bool set;
+  boost::mutex mutex;
+  boost::condition_variable cond;
+};
+
+
+bool all_hit_once( std::vector< int > const& hits )
+{
+  for( unsigned i = 0; i < hits.size(); ++i )
+  {
+    if( hits[i] != 1 )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void test_parallel_for()
+{
+  std::cout << "Testing parallel_for" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 4 );
+  pool->reset_statistics();
+
+  std::vector< int > hits( 1001, 0 );
+  pool->parallel_for( 0, hits.size(), boost::bind( mark_range, &hits, _1, _2 ), "test_outer" );
+  TEST( "Every index is processed once", all_hit_once( hits ), true );
+
+  compute_pool_stats stats = pool->statistics( "test_outer" );
+  TEST( "One batch is recorded", stats.batches, 1u );
+  TEST( "One task per core", stats.tasks, 4u );
+  TEST( "Concurrency is within budget", stats.peak_concurrency <= 4, true );
+
+  std::vector< int > limited( 100, 0 );
+  pool->parallel_for( 0, limited.size(), boost::bind( mark_range, &limited, _1, _2 ),
+                      "test_limited", 2 );
+  TEST( "Limited parallel_for processes every index", all_hit_once( limited ), true );
+  TEST( "Limited parallel_for uses two ranges", pool->statistics( "test_limited" ).tasks, 2u );
+  TEST( "Limited parallel_for respects limit",
+        pool->statistics( "test_limited" ).peak_concurrency <= 2, true );
+}
+
+
+void test_nested()
+{
+  std::cout << "Testing nested submissions" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 3 );
+
+  std::vector< int > hits( 5000, 0 );
+  pool->parallel_for( 0, hits.size(), boost::bind( nested_range, &hits, _1, _2 ), "test_nested" );
+  TEST( "Nested parallel_for processes every index", all_hit_once( hits ), true );
+}
+
+
+void test_tiles()
+{
+  std::cout << "Testing parallel_for_tiles" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 4 );
+
+  unsigned const width = 37;
+  unsigned const height = 23;
+  std::vector< int > hits( width * height, 0 );
+
+  pool->parallel_for_tiles( vgl_box_2d<int>( 0, width, 0, height ), 3, 4,
+                            boost::bind( mark_tile, &hits, width, _1 ), "test_tiles" );
+  TEST( "Every pixel is processed once", all_hit_once( hits ), true );
+  TEST( "One task per tile", pool->statistics( "test_tiles" ).tasks, 12u );
+}
+
+
+void test_errors()
+{
+  std::cout << "Testing task errors" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 2 );
+
+  std::vector< compute_pool::task_t > tasks( 3, throw_error );
+  bool thrown = false;
+
+  try
+  {
+    pool->run( tasks, "test_errors" );
+  }
+  catch( std::runtime_error const& )
+  {
+    thrown = true;
+  }
+
+  TEST( "Task errors are rethrown", thrown, true );
+  TEST( "All failing tasks are counted", pool->statistics( "test_errors" ).tasks, 3u );
+}
+
+
+void test_serial_budget()
+{
+  std::cout << "Testing a budget of one core" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 1 );
+  TEST( "Budget is set", pool->core_budget(), 1u );
+
+  std::vector< boost::thread::id > ids( 4 );
+  std::vector< compute_pool::task_t > tasks;
+
+  for( unsigned i = 0; i < ids.size(); ++i )
+  {
+    tasks.push_back( boost::bind( record_thread, &ids[i] ) );
+  }
+
+  pool->run( tasks, "test_serial" );
+
+  bool all_local = true;
+
+  for( unsigned i = 0; i < ids.size(); ++i )
+  {
+    all_local = all_local && ( ids[i] == boost::this_thread::get_id() );
+  }
+
+  TEST( "Tasks run on the calling thread", all_local, true );
+}
+
+
+// Training task which blocks until released
+struct blocking_task
+  : public training_thread_task
+{
+  blocking_task( signal_flag* started, signal_flag* release, boost::thread::id* id )
+    : started_( started ), release_( release ), id_( id )
+  {}
+
+  bool execute()
+  {
+    *id_ = boost::this_thread::get_id();
+    started_->notify();
+    return release_->wait();
+  }
+
+  signal_flag* started_;
+  signal_flag* release_;
+  boost::thread::id* id_;
+};
+
+
+void test_training_thread()
+{
+  std::cout << "Testing training thread with a budget of one" << std::endl;
+
+  compute_pool_t pool = compute_pool::instance();
+  pool->set_core_budget( 1 );
+
+  signal_flag started, release;
+  boost::thread::id task_id;
+
+  training_thread trainer;
+  training_thread_task_sptr task( new blocking_task( &started, &release, &task_id ) );
+
+  trainer.execute_if_able( task );
+
+  TEST( "Training task starts", started.wait(), true );
+  TEST( "Training task runs on its own thread",
+        task_id != boost::this_thread::get_id(), true );
+
+  // The pool stays usable while training is in progress
+  std::vector< int > hits( 100, 0 );
+  pool->parallel_for( 0, 100, boost::bind( mark_range, &hits, _1, _2 ), "test_training" );
+  TEST( "Pool runs during training", all_hit_once( hits ), true );
+
+  release.notify();
+  trainer.block_until_finished();
+}
+
+} // end anonymous namespace
+
+
+int test_compute_pool( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "compute_pool" );
+
+  test_parallel_for();
+  test_nested();
+  test_tiles();
+  test_errors();
+  test_serial_budget();
+  test_training_thread();
+
+  compute_pool::instance()->set_core_budget( 0 );
+
+  return testlib_test_summary();
+}
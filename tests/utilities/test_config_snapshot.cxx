@@ -0,0 +1,168 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <utilities/config_snapshot.h>
+#include <utilities/mapped_file.h>
+#include <utilities/phase_timer.h>
+
+#include <vul/vul_temp_filename.h>
+#include <vpl/vpl.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace vidtk;
+
+namespace
+{
+
+void write_file( std::string const& filename, std::string const& contents )
+{
+  std::ofstream output( filename.c_str(), std::ios::out | std::ios::binary );
+  output << contents;
+}
+
+
+void test_mapped_file()
+{
+  std::cout << "Testing mapped_file" << std::endl;
+
+  std::string const filename = vul_temp_filename();
+  write_file( filename, "mapped contents" );
+
+  mapped_file file;
+  TEST( "File is mapped", file.open( filename ), true );
+  TEST( "Mapped size is correct", file.size(), 15u );
+  TEST( "Mapped data is correct", std::string( file.data(), file.size() ), "mapped contents" );
+
+  file.close();
+  TEST( "File is closed", file.is_open(), false );
+  TEST( "Missing file is not mapped", file.open( filename + ".missing" ), false );
+
+  vpl_unlink( filename.c_str() );
+}
+
+
+void test_phase_timer()
+{
+  std::cout << "Testing phase_timer" << std::endl;
+
+  phase_timer timer;
+  timer.start( "first" );
+  timer.start( "second" );
+  timer.stop();
+
+  TEST( "Two phases are recorded", timer.phases().size(), 2u );
+  TEST( "Phases are in order", timer.phases()[1].first, "second" );
+  TEST( "Total is non-negative", timer.total_seconds() >= 0.0, true );
+
+  std::ostringstream report;
+  timer.report( report );
+  TEST( "Report names each phase",
+        report.str().find( "first" ) != std::string::npos &&
+        report.str().find( "second" ) != std::string::npos, true );
+}
+
+
+void test_round_trip()
+{
+  std::cout << "Testing snapshot round trip" << std::endl;
+
+  std::string const config_file = vul_temp_filename();
+  std::string const model_file = vul_temp_filename();
+  std::string const snapshot_file = vul_temp_filename();
+
+  write_file( config_file, "alpha = 1\n" );
+  write_file( model_file, "model text" );
+
+  config_block blk;
+  blk.add_parameter( "alpha", "0", "first parameter" );
+  blk.add_parameter( "block:beta", "0", "second parameter" );
+  blk.set( "alpha", "1" );
+  blk.set( "block:beta", "two" );
+
+  {
+    config_snapshot_sptr recorder( new config_snapshot() );
+    recorder->set_key( "key" );
+    recorder->set_config( blk );
+    recorder->add_dependency( config_file );
+    recorder->add_model( "test", model_file, std::string( "binary\0model", 12 ) );
+
+    TEST( "Recorder is recording", recorder->is_recording(), true );
+    TEST( "Snapshot is written", recorder->write( snapshot_file ), true );
+  }
+
+  config_snapshot loaded;
+  std::string data;
+
+  TEST( "Snapshot is loaded", loaded.load( snapshot_file ), true );
+  TEST( "Loaded snapshot is not recording", loaded.is_recording(), false );
+  TEST( "Models are hidden until verified", loaded.find_model( "test", model_file, data ), false );
+  TEST( "Different key is not current", loaded.is_current( "other" ), false );
+  TEST( "Same key is current", loaded.is_current( "key" ), true );
+
+  config_block target;
+  target.add_parameter( "alpha", "0", "first parameter" );
+  target.add_parameter( "block:beta", "0", "second parameter" );
+
+  TEST( "Values are applied", loaded.apply( target ), true );
+  TEST( "First value is restored", target.get< std::string >( "alpha" ), "1" );
+  TEST( "Second value is restored", target.get< std::string >( "block:beta" ), "two" );
+
+  TEST( "Model is found", loaded.find_model( "test", model_file, data ), true );
+  TEST( "Model data is intact", data, std::string( "binary\0model", 12 ) );
+  TEST( "Other kinds are not found", loaded.find_model( "other", model_file, data ), false );
+
+  // Changing any source file invalidates the snapshot
+  write_file( model_file, "changed model text" );
+
+  config_snapshot stale;
+  TEST( "Stale snapshot is loaded", stale.load( snapshot_file ), true );
+  TEST( "Changed model makes snapshot stale", stale.is_current( "key" ), false );
+
+  write_file( snapshot_file, "VIDTKCSS" );
+
+  config_snapshot truncated;
+  TEST( "Truncated snapshot is rejected", truncated.load( snapshot_file ), false );
+
+  vpl_unlink( config_file.c_str() );
+  vpl_unlink( model_file.c_str() );
+  vpl_unlink( snapshot_file.c_str() );
+}
+
+
+void test_active()
+{
+  std::cout << "Testing active snapshot" << std::endl;
+
+  TEST( "No snapshot is active by default", !config_snapshot::active(), true );
+
+  config_snapshot_sptr snapshot( new config_snapshot() );
+  config_snapshot::set_active( snapshot );
+  TEST( "Snapshot is activated", config_snapshot::active() == snapshot, true );
+
+  config_snapshot::set_active( config_snapshot_sptr() );
+  TEST( "Snapshot is deactivated", !config_snapshot::active(), true );
+}
+
+} // end anonymous namespace
+
+
+int test_config_snapshot( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "config_snapshot" );
+
+  test_mapped_file();
+  test_phase_timer();
+  test_round_trip();
+  test_active();
+
+  return testlib_test_summary();
+}
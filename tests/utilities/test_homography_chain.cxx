@@ -0,0 +1,254 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <utilities/homography_chain.h>
+
+#include <vnl/vnl_double_3x3.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <iostream>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+typedef homography_chain::transform_t transform_t;
+
+
+transform_t
+make_transform( double scale, double tx, double ty )
+{
+  vnl_double_3x3 m;
+  m.set_identity();
+  m( 0, 0 ) = scale;
+  m( 1, 1 ) = scale;
+  m( 0, 2 ) = tx;
+  m( 1, 2 ) = ty;
+  return transform_t( m );
+}
+
+
+bool
+near_equal( transform_t const& a, transform_t const& b )
+{
+  vnl_double_3x3 ma = a.get_matrix();
+  vnl_double_3x3 mb = b.get_matrix();
+  ma /= ma( 2, 2 );
+  mb /= mb( 2, 2 );
+  return ( ma - mb ).frobenius_norm() < 1e-9;
+}
+
+
+// Frame f maps to reference frame r with a transform depending on f
+image_to_image_homography
+make_homog( unsigned f, unsigned r, bool new_ref = false )
+{
+  image_to_image_homography h;
+  h.set_transform( make_transform( 1.0 + 0.01 * f, 3.0 * f, -2.0 * f ) );
+  h.set_source_reference( timestamp( f * 0.5, f ) );
+  h.set_dest_reference( timestamp( r * 0.5, r ) );
+  h.set_valid( true );
+  h.set_new_reference( new_ref );
+  return h;
+}
+
+
+timestamp
+ts( unsigned f )
+{
+  return timestamp( f * 0.5, f );
+}
+
+
+void
+test_pairs()
+{
+  std::cout << "\nPair transforms\n";
+
+  homography_chain chain;
+  for( unsigned f = 0; f < 10; ++f )
+  {
+    chain.add( make_homog( f, 0, f == 0 ) );
+  }
+
+  TEST( "Size", chain.size(), 10 );
+
+  transform_t result;
+  TEST( "Transform found", chain.transform( ts( 2 ), ts( 7 ), result ), true );
+
+  transform_t expected = make_homog( 7, 0 ).get_transform().get_inverse() *
+                         make_homog( 2, 0 ).get_transform();
+  TEST( "Transform is the explicit product", near_equal( result, expected ), true );
+
+  transform_t by_age;
+  chain.transform_by_age( 7, 2, by_age );
+  TEST( "Lookup by age matches lookup by timestamp", near_equal( result, by_age ), true );
+
+  TEST( "Self transform is identity",
+        chain.transform( ts( 4 ), ts( 4 ), result ) &&
+        near_equal( result, make_transform( 1.0, 0.0, 0.0 ) ), true );
+
+  TEST( "Missing frame", chain.transform( ts( 2 ), ts( 12 ), result ), false );
+  TEST( "Age out of range", chain.transform_by_age( 0, 10, result ), false );
+
+  chain.src_to_ref( ts( 5 ), result );
+  TEST( "Source to reference", near_equal( result, make_homog( 5, 0 ).get_transform() ), true );
+}
+
+
+void
+test_reference_change()
+{
+  std::cout << "\nReference changes and shots\n";
+
+  homography_chain chain;
+  for( unsigned f = 0; f < 5; ++f )
+  {
+    chain.add( make_homog( f, 0, f == 0 ) );
+  }
+
+  // Frames 5 to 7 are registered to frame 4
+  for( unsigned f = 5; f < 8; ++f )
+  {
+    chain.add( make_homog( f, 4 ) );
+  }
+
+  transform_t result;
+  TEST( "Frames across a reference change are related",
+        chain.transform( ts( 6 ), ts( 1 ), result ), true );
+
+  transform_t expected = make_homog( 1, 0 ).get_transform().get_inverse() *
+                         make_homog( 4, 0 ).get_transform() *
+                         make_homog( 6, 4 ).get_transform();
+  TEST( "Transform through the old reference", near_equal( result, expected ), true );
+
+  // Frame 8 starts a new shot
+  chain.add( make_homog( 8, 8, true ) );
+  chain.add( make_homog( 9, 8 ) );
+  TEST( "Frames of different shots are not related",
+        chain.transform( ts( 9 ), ts( 7 ), result ), false );
+  TEST( "Frames of the new shot are related",
+        chain.transform( ts( 9 ), ts( 8 ), result ), true );
+
+  // Reference to a frame no longer in the chain also starts a new shot
+  chain.add( make_homog( 10, 3 ) );
+  TEST( "Unknown reference starts a shot",
+        chain.transform( ts( 10 ), ts( 9 ), result ), false );
+
+  image_to_image_homography invalid = make_homog( 11, 3 );
+  invalid.set_valid( false );
+  chain.add( invalid );
+  TEST( "Invalid frame kept", chain.size(), 12 );
+  TEST( "Invalid frame not related", chain.transform( ts( 11 ), ts( 10 ), result ), false );
+
+  chain.add( make_homog( 2, 0 ) );
+  TEST( "Older frame restarts the chain", chain.size(), 1 );
+}
+
+
+void
+test_capacity()
+{
+  std::cout << "\nCapacity\n";
+
+  homography_chain chain( 4 );
+  for( unsigned f = 0; f < 10; ++f )
+  {
+    chain.add( make_homog( f, 0, f == 0 ) );
+  }
+
+  transform_t result;
+  TEST( "Size limited", chain.size(), 4 );
+  TEST( "Oldest frames dropped", chain.transform( ts( 5 ), ts( 9 ), result ), false );
+  TEST( "Newest frames kept", chain.transform( ts( 6 ), ts( 9 ), result ), true );
+
+  chain.keep_newest();
+  TEST( "Keep newest", chain.size() == 1 && chain.src_to_ref( ts( 9 ), result ), true );
+
+  chain.add( make_homog( 10, 0 ) );
+  TEST( "Shot continues after keep newest",
+        chain.transform( ts( 10 ), ts( 9 ), result ), true );
+
+  // Frames without timestamps
+  chain.clear();
+  chain.set_capacity( 3 );
+  for( unsigned f = 0; f < 5; ++f )
+  {
+    chain.add( make_homog( f, 0 ).get_transform() );
+  }
+  TEST( "Untimestamped size", chain.size(), 3 );
+
+  transform_t expected = make_homog( 2, 0 ).get_transform().get_inverse() *
+                         make_homog( 4, 0 ).get_transform();
+  TEST( "Untimestamped by age",
+        chain.transform_by_age( 0, 2, result ) && near_equal( result, expected ), true );
+  TEST( "Untimestamped frames have no timestamp",
+        chain.transform( ts( 4 ), ts( 2 ), result ), false );
+}
+
+
+void
+read_chain( homography_chain const* chain, unsigned* failures )
+{
+  transform_t result;
+  for( unsigned i = 0; i < 2000; ++i )
+  {
+    // The chain only grows here, and all frames are in one shot
+    if( chain->size() >= 2 && !chain->transform_by_age( 0, 1, result ) )
+    {
+      ++( *failures );
+    }
+  }
+}
+
+
+void
+test_concurrent_readers()
+{
+  std::cout << "\nConcurrent readers\n";
+
+  homography_chain chain( 16 );
+  unsigned failures[4] = { 0, 0, 0, 0 };
+
+  boost::thread_group readers;
+  for( unsigned t = 0; t < 4; ++t )
+  {
+    readers.create_thread( boost::bind( read_chain, &chain, &failures[t] ) );
+  }
+
+  for( unsigned f = 0; f < 2000; ++f )
+  {
+    chain.add( make_homog( f, 0, f == 0 ) );
+  }
+
+  readers.join_all();
+
+  TEST( "Readers always saw related frames",
+        failures[0] + failures[1] + failures[2] + failures[3], 0 );
+  TEST( "Writer finished", chain.size(), 16 );
+}
+
+} // end anonymous namespace
+
+
+int test_homography_chain( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "homography_chain" );
+
+  test_pairs();
+  test_reference_change();
+  test_capacity();
+  test_concurrent_readers();
+
+  return testlib_test_summary();
+}
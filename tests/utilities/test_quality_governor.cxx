@@ -0,0 +1,206 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <testlib/testlib_test.h>
+
+#include <utilities/quality_governor.h>
+#include <utilities/quality_governor_process.h>
+
+#include <pipeline_framework/sync_pipeline.h>
+
+#include <boost/thread/thread.hpp>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+
+// Produces an increasing timestamp every step.
+struct frame_source
+  : public process
+{
+  typedef frame_source self_type;
+
+  frame_source( std::string const& _name )
+    : process( _name, "frame_source" ),
+      frame_( 0 )
+  {
+  }
+
+  config_block params() const { return config_block(); }
+  bool set_params( config_block const& ) { return true; }
+  bool initialize() { frame_ = 0; return true; }
+
+  bool step()
+  {
+    ts_ = vidtk::timestamp( frame_ * 1e5, frame_ );
+    ++frame_;
+    return true;
+  }
+
+  vidtk::timestamp timestamp() const { return ts_; }
+  VIDTK_OUTPUT_PORT( vidtk::timestamp, timestamp );
+
+  unsigned frame_;
+  vidtk::timestamp ts_;
+};
+
+
+// A node whose step takes an adjustable amount of time.
+struct slow_node
+  : public process
+{
+  typedef slow_node self_type;
+
+  slow_node( std::string const& _name )
+    : process( _name, "slow_node" ),
+      delay_ms_( 0 )
+  {
+  }
+
+  config_block params() const { return config_block(); }
+  bool set_params( config_block const& ) { return true; }
+  bool initialize() { return true; }
+
+  bool step()
+  {
+    if( delay_ms_ > 0 )
+    {
+      boost::this_thread::sleep( boost::posix_time::milliseconds( delay_ms_ ) );
+    }
+    return true;
+  }
+
+  void set_timestamp( vidtk::timestamp const& ) {}
+  VIDTK_INPUT_PORT( set_timestamp, vidtk::timestamp const& );
+
+  unsigned delay_ms_;
+};
+
+
+void
+test_hysteresis()
+{
+  std::cout << "Test tier hysteresis\n";
+
+  quality_governor_settings settings;
+  settings.enabled = true;
+  settings.tier_count = 3;
+  settings.upper_load = 1.0;
+  settings.lower_load = 0.5;
+  settings.escalate_count = 2;
+  settings.relax_count = 3;
+
+  quality_governor governor;
+  TEST( "Configure", governor.configure( settings ), true );
+
+  TEST( "Single overload is ignored", governor.update( 2.0 ), 0 );
+  TEST( "Sustained overload escalates", governor.update( 2.0 ), 1 );
+  TEST( "Load between thresholds holds", governor.update( 0.8 ), 1 );
+  TEST( "Overload count was reset", governor.update( 2.0 ), 1 );
+  TEST( "Escalate again", governor.update( 2.0 ), 2 );
+  governor.update( 2.0 );
+  TEST( "Tier is bounded by tier count", governor.update( 2.0 ), 2 );
+  governor.update( 0.1 );
+  TEST( "Short underload is ignored", governor.update( 0.1 ), 2 );
+  TEST( "Sustained underload relaxes", governor.update( 0.1 ), 1 );
+  TEST( "Active tier", governor.active_tier(), 1 );
+
+  settings.lower_load = 2.0;
+  TEST( "Reject inverted thresholds", governor.configure( settings ), false );
+
+  settings.lower_load = 0.5;
+  settings.enabled = false;
+  TEST( "Configure disabled", governor.configure( settings ), true );
+  governor.update( 5.0 );
+  governor.update( 5.0 );
+  TEST( "Disabled governor stays at full quality", governor.update( 5.0 ), 0 );
+}
+
+
+void
+test_slow_node()
+{
+  std::cout << "Test governor with an artificially slow node\n";
+
+  process_smart_pointer< frame_source > source( new frame_source( "source" ) );
+  process_smart_pointer< quality_governor_process > governor(
+    new quality_governor_process( "governor" ) );
+  process_smart_pointer< slow_node > slow( new slow_node( "slow" ) );
+
+  sync_pipeline p;
+  p.add( source );
+  p.add( governor );
+  p.add( slow );
+
+  p.connect( source->timestamp_port(), governor->set_timestamp_port() );
+  p.connect( source->timestamp_port(), slow->set_timestamp_port() );
+
+  config_block blk = governor->params();
+  blk.set( "enabled", "true" );
+  blk.set( "tier_count", "3" );
+  blk.set( "nodes_to_monitor", "slow" );
+  blk.set( "frame_budget_ms", "10" );
+  blk.set( "upper_load", "1.0" );
+  blk.set( "lower_load", "0.5" );
+  blk.set( "escalate_count", "3" );
+  blk.set( "relax_count", "5" );
+
+  TEST( "Set governor parameters", governor->set_params( blk ), true );
+
+  blk.set( "nodes_to_monitor", "not_a_node" );
+  TEST( "Set invalid node", governor->set_params( blk ), true );
+  TEST( "Invalid node is reported", governor->set_pipeline_to_monitor( &p ), false );
+
+  blk.set( "nodes_to_monitor", "slow" );
+  TEST( "Reset governor parameters", governor->set_params( blk ), true );
+  TEST( "Monitor pipeline", governor->set_pipeline_to_monitor( &p ), true );
+  TEST( "Initialize", p.initialize(), true );
+
+  bool tiers_valid = true;
+
+  for( unsigned f = 0; f < 5; ++f )
+  {
+    p.execute();
+    tiers_valid = tiers_valid && governor->quality_tier() == 0;
+  }
+  TEST( "Full quality while fast", tiers_valid, true );
+
+  slow->delay_ms_ = 25;
+  unsigned max_tier = 0;
+
+  for( unsigned f = 0; f < 10; ++f )
+  {
+    p.execute();
+    max_tier = std::max( max_tier, governor->quality_tier() );
+  }
+  TEST( "Quality reduced while slow", max_tier, 2 );
+
+  slow->delay_ms_ = 0;
+
+  for( unsigned f = 0; f < 20; ++f )
+  {
+    p.execute();
+  }
+  TEST( "Full quality restored", governor->quality_tier(), 0 );
+}
+
+
+} // end anonymous namespace
+
+int test_quality_governor( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "Quality governor" );
+
+  test_hysteresis();
+  test_slow_node();
+
+  return testlib_test_summary();
+}
@@ -0,0 +1,147 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <iostream>
+#include <vil/vil_image_view.h>
+#include <testlib/testlib_test.h>
+
+#ifdef USE_LIBAV
+
+#include <video_io/libav_frame_process.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+// Same synthetic video as test_vidl_ffmpeg_frame_process
+int expectedTop[21] = { 36, 39, 43, 46, 49, 53, 56, 60, 63, 67,
+                        70, 74, 77, 80, 84, 87, 91, 94, 98, 101 };
+
+int expectedBot[21] = { 202, 199, 195, 192, 189, 185, 182, 178, 175, 171,
+                        168, 165, 161, 158, 154, 151, 147, 144, 140, 137 };
+
+
+void
+test_frame_reading( std::string const& dir, std::string const& filename,
+                    std::string const& thread_type )
+{
+  std::cout << "\n\nTesting frame reading on " << filename
+            << " with " << thread_type << " threading\n\n";
+
+  libav_frame_process src( "src" );
+
+  config_block blk = src.params();
+  blk.set( "filename", dir+"/" + filename );
+  blk.set( "thread_type", thread_type );
+
+  TEST( "Set params", src.set_params( blk ), true );
+  TEST( "Initialize", src.initialize(), true );
+
+  unsigned frame_cnt = 0;
+  for( frame_cnt = 0; frame_cnt < 21 && src.step(); ++frame_cnt )
+  {
+    timestamp ts = src.timestamp();
+    TEST_EQUAL( "Frame number", ts.frame_number(), frame_cnt );
+    TEST( "Has timestamp", ts.has_time(), true );
+    TEST_NEAR( "Correct time", ts.time(), ts.frame_number()*40000, 1e6 );
+
+    vil_image_view<vxl_byte> const& img = src.image();
+    TEST( "Has image", bool(img), true );
+    TEST_EQUAL( "RGB image", img.nplanes(), 3 );
+
+    for( unsigned p = 0; p < 3; ++p )
+    {
+      TEST_EQUAL( "Top pixel", img(0, 0, p), expectedTop[frame_cnt] );
+      TEST_EQUAL( "Bottom pixel", img(15, 15, p), expectedBot[frame_cnt] );
+    }
+  }
+
+  TEST( "Last frame was frame 19", frame_cnt, 20 );
+}
+
+
+void
+test_seek( std::string const& dir, std::string const& filename )
+{
+  libav_frame_process src( "src" );
+
+  config_block blk = src.params();
+  blk.set( "filename", dir+"/" + filename );
+  blk.set( "index_on_open", "true" );
+
+  TEST( "Set params", src.set_params( blk ), true );
+  TEST( "Initialize", src.initialize(), true );
+
+  TEST( "Seek forward", src.seek( 12 ), true );
+  TEST( "Step after seek", src.step(), true );
+  TEST_EQUAL( "Frame number after seek", src.timestamp().frame_number(), 12 );
+  TEST_EQUAL( "Pixel after seek", src.image()(0, 0, 0), expectedTop[12] );
+
+  TEST( "Seek backward", src.seek( 3 ), true );
+  TEST( "Step after seek", src.step(), true );
+  TEST_EQUAL( "Frame number after seek", src.timestamp().frame_number(), 3 );
+  TEST_EQUAL( "Pixel after seek", src.image()(0, 0, 0), expectedTop[3] );
+}
+
+
+void
+test_grey_output( std::string const& dir, std::string const& filename )
+{
+  libav_frame_process src( "src" );
+
+  config_block blk = src.params();
+  blk.set( "filename", dir+"/" + filename );
+  blk.set( "output_format", "grey" );
+
+  TEST( "Set params", src.set_params( blk ), true );
+  TEST( "Initialize", src.initialize(), true );
+  TEST( "Step", src.step(), true );
+
+  vil_image_view<vxl_byte> img = src.image();
+  vil_image_view<vxl_byte> luma = src.luma_image();
+
+  TEST_EQUAL( "Single plane", img.nplanes(), 1 );
+  TEST_EQUAL( "Width", img.ni(), src.ni() );
+  TEST_EQUAL( "Height", img.nj(), src.nj() );
+  TEST( "Luma plane available", bool(luma), true );
+  TEST( "Luma plane is not copied", img.top_left_ptr() == luma.top_left_ptr(), true );
+  TEST( "Uniform region", img(0, 0) == img(3, 4), true );
+}
+
+
+} // end anonymous namespace
+
+int test_libav_frame_process( int argc, char* argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Need the data directory as an argument\n";
+    return EXIT_FAILURE;
+  }
+
+  testlib_test_start( "libav_frame_process" );
+
+  test_frame_reading( argv[1], "small_synthetic.mpg", "frame" );
+  test_frame_reading( argv[1], "small_synthetic.avi", "frame" );
+  test_frame_reading( argv[1], "small_synthetic.mpg", "slice" );
+  test_seek( argv[1], "small_synthetic.mpg" );
+  test_grey_output( argv[1], "small_synthetic.mpg" );
+
+  return testlib_test_summary();
+}
+
+#else // USE_LIBAV
+
+int test_libav_frame_process( int /*argc*/, char* /*argv*/[] )
+{
+  std::cout << "libav support is not enabled. Not testing video reading"
+           << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#endif // USE_LIBAV
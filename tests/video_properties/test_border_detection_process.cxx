@@ -149,6 +149,60 @@ run_border_tests( const std::string& data_dir )
     TEST( "Border Detection Test: White Border Value 4", mask(4,18), false );
   }
 
+  // Test border tracking across frames (black letterbox)
+  {
+    vil_image_view<vxl_byte> letterbox( 60, 40 );
+
+    for( unsigned j = 0; j < 40; j++ )
+    {
+      for( unsigned i = 0; i < 60; i++ )
+      {
+        letterbox( i, j ) = ( j < 5 || j >= 35 ? 0 : 40 + ( i * 37 + j * 91 ) % 200 );
+      }
+    }
+
+    config_block test_setup = default_params;
+    test_setup.set( "type", "black" );
+    test_setup.set( "min_border_left", "0" );
+    test_setup.set( "min_border_right", "0" );
+    test_setup.set( "min_border_top", "0" );
+    test_setup.set( "min_border_bottom", "0" );
+    test_setup.set( "side_dilation", "0" );
+    test_setup.set( "use_history", "false" );
+    test_setup.set( "enable_tracking", "true" );
+    border_process.initialize();
+
+    TEST( "Border Tracking Test: Configure", border_process.set_params( test_setup ), true );
+
+    image_border first_border;
+
+    for( unsigned f = 0; f < 3; f++ )
+    {
+      border_process.set_source_gray_image( letterbox );
+      border_process.step();
+
+      if( f == 0 )
+      {
+        first_border = border_process.border();
+      }
+    }
+
+    vil_image_view< bool > mask = border_process.border_mask();
+
+    TEST( "Border Tracking Test: Top Border", mask(10,2), true );
+    TEST( "Border Tracking Test: Bottom Border", mask(10,37), true );
+    TEST( "Border Tracking Test: Interior", mask(10,20), false );
+    TEST( "Border Tracking Test: Border Unchanged", border_process.border() == first_border, true );
+    TEST( "Border Tracking Test: Tracked Frames", border_process.tracked_frame_count(), 2 );
+    TEST( "Border Tracking Test: Full Scans", border_process.full_scan_count(), 1 );
+
+    border_process.set_source_gray_image( letterbox );
+    border_process.set_reset_flag( true );
+    border_process.step();
+
+    TEST( "Border Tracking Test: Full Scan After Reset", border_process.full_scan_count(), 2 );
+  }
+
   // Test non-rectilinear black and white border detection
   {
     config_block test_setup = default_params;
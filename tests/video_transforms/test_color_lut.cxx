@@ -0,0 +1,159 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <video_transforms/color_lut.h>
+#include <video_transforms/automatic_white_balancing.h>
+
+#include <vil/vil_image_view.h>
+
+#include <boost/bind.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+
+void invert_and_darken( double* color, double max_value )
+{
+  for( unsigned c = 0; c < 3; ++c )
+  {
+    color[c] = 0.5 * ( max_value - color[c] );
+  }
+}
+
+
+template <typename PixType>
+void fill_pattern( vil_image_view<PixType>& img, unsigned ni, unsigned nj, unsigned step )
+{
+  img.set_size( ni, nj, 3 );
+
+  for( unsigned j = 0; j < nj; ++j )
+  {
+    for( unsigned i = 0; i < ni; ++i )
+    {
+      img( i, j, 0 ) = static_cast<PixType>( ( i * step ) % ( step * ni ) );
+      img( i, j, 1 ) = static_cast<PixType>( ( j * step ) % ( step * nj ) );
+      img( i, j, 2 ) = static_cast<PixType>( ( ( i + j ) * step / 2 ) );
+    }
+  }
+}
+
+
+template <typename PixType>
+void test_linear_operations( char const* type_name, double max_value, unsigned step )
+{
+  std::cout << "Testing linear color operations for " << type_name << std::endl;
+
+  vil_image_view<PixType> img;
+  fill_pattern( img, 64, 48, step );
+
+  color_lut<PixType> lut;
+  lut.configure( 17, max_value );
+
+  vil_image_view<PixType> out;
+  lut.apply( img, out );
+
+  bool identical = ( out.ni() == img.ni() && out.nj() == img.nj() && out.nplanes() == 3 );
+  for( unsigned j = 0; j < img.nj() && identical; ++j )
+  {
+    for( unsigned i = 0; i < img.ni() && identical; ++i )
+    {
+      for( unsigned p = 0; p < 3; ++p )
+      {
+        identical = identical && ( out( i, j, p ) == img( i, j, p ) );
+      }
+    }
+  }
+  TEST( "Identity table leaves the image unchanged", identical, true );
+
+  // Linear operations are reproduced exactly by trilinear interpolation
+  lut.compile( boost::bind( invert_and_darken, _1, max_value ) );
+  lut.apply( img, out, 2.0 );
+
+  int max_error = 0;
+  for( unsigned j = 0; j < img.nj(); ++j )
+  {
+    for( unsigned i = 0; i < img.ni(); ++i )
+    {
+      for( unsigned p = 0; p < 3; ++p )
+      {
+        int expected = static_cast<int>( max_value ) - static_cast<int>( img( i, j, p ) );
+        max_error = std::max( max_error, std::abs( expected - static_cast<int>( out( i, j, p ) ) ) );
+      }
+    }
+  }
+  TEST( "Compiled operations with gain match direct evaluation", max_error <= 1, true );
+
+  // Output may be the same image as the input
+  vil_image_view<PixType> in_place;
+  in_place.deep_copy( img );
+  lut.apply( in_place, in_place, 2.0 );
+  TEST( "In place application matches", in_place( 10, 20, 1 ), out( 10, 20, 1 ) );
+}
+
+
+void test_white_balancing()
+{
+  std::cout << "Testing white balancing through a lookup table" << std::endl;
+
+  vil_image_view<vxl_byte> blue_tint( 2, 2, 3 );
+
+  // Perceptually red, green, blue, and light blue pixels with a blue tint
+  blue_tint(0,0,0) = 104; blue_tint(0,0,1) = 147; blue_tint(0,0,2) = 215;
+  blue_tint(0,1,0) = 47; blue_tint(0,1,1) = 90; blue_tint(0,1,2) = 147;
+  blue_tint(1,0,0) = 90; blue_tint(1,0,1) = 90; blue_tint(1,0,2) = 147;
+  blue_tint(1,1,0) = 40; blue_tint(1,1,1) = 106; blue_tint(1,1,2) = 147;
+
+  auto_white_balancer<vxl_byte> awb;
+  TEST( "Correction is estimated", awb.update( blue_tint ), true );
+
+  unsigned revision = awb.revision();
+  awb.update( blue_tint );
+  TEST( "Unchanged references do not change the correction", awb.revision(), revision );
+
+  color_lut<vxl_byte> lut;
+  lut.configure( 33, 255.0 );
+  lut.compile( boost::bind( &auto_white_balancer<vxl_byte>::correct_color, &awb, _1 ) );
+
+  vil_image_view<vxl_byte> out;
+  lut.apply( blue_tint, out );
+
+  // The brightest pixel should be closer to pure white
+  double dist1 = 255-blue_tint(0,0,0)+255-blue_tint(0,0,1)+255-blue_tint(0,0,2);
+  double dist2 = 255-out(0,0,0)+255-out(0,0,1)+255-out(0,0,2);
+  TEST( "White reference point", dist1 > dist2, true );
+
+  // The green pixel should be greener
+  double rat1 = static_cast<double>(blue_tint(1,1,1))/blue_tint(1,1,2);
+  double rat2 = static_cast<double>(out(1,1,1))/out(1,1,2);
+  TEST( "Green reference point", rat2 > rat1, true );
+
+  // The red pixel should be redder
+  rat1 = static_cast<double>(blue_tint(1,0,1))/blue_tint(1,0,2);
+  rat2 = static_cast<double>(out(1,0,1))/out(1,0,2);
+  TEST( "Red reference point", rat2 > rat1, true );
+}
+
+} // end anonymous namespace
+
+
+int test_color_lut( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "color_lut" );
+
+  test_linear_operations<vxl_byte>( "vxl_byte", 255.0, 3 );
+  test_linear_operations<vxl_uint_16>( "vxl_uint_16", 65535.0, 700 );
+  test_white_balancing();
+
+  return testlib_test_summary();
+}
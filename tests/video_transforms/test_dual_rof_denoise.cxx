@@ -1,10 +1,11 @@
 /*ckwg +5
- * Copyright 2010-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2010-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include <vcl_iostream.h>
+#include <vcl_sstream.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_math.h>
 #include <vil/vil_save.h>
@@ -113,6 +114,59 @@ test_weighted_denoising( const vil_image_view<vxl_byte>& input,
 }
 
 
+
+// test that the fused solver matches the separate pass solver, with both a
+// single strip and several strips processed in parallel, and that warm
+// starting continues the iterations where they left off.
+template <typename T>
+void
+test_fused_denoising( const vil_image_view<vxl_byte>& input,
+                      double eps )
+{
+  vil_image_view<T> float_input;
+  vil_convert_cast(input, float_input);
+
+  const unsigned ni=input.ni(), nj=input.nj();
+  vil_image_view<T> weights(ni, nj, 1);
+  for( unsigned j=0; j<nj; ++j )
+  {
+    for( unsigned i=0; i<ni; ++i )
+    {
+      weights(i,j) = T((i + j) % 5) / 4;
+    }
+  }
+
+  vil_image_view<T> expected, expected_weighted;
+  dual_rof_denoise(float_input, expected, 100, T(10.0));
+  dual_rof_weighted_denoise(float_input, weights, expected_weighted, 100, T(100.0));
+
+  const unsigned thread_counts[2] = { 1, 4 };
+  for( unsigned t=0; t<2; ++t )
+  {
+    vcl_ostringstream desc;
+    desc << traits<T>::name() << " with " << thread_counts[t] << " thread(s)";
+
+    vil_image_view<T> output, dual;
+    dual_rof_denoise_fused(float_input, output, dual, 100, T(10.0), T(0.25),
+                           false, thread_counts[t]);
+    TEST_NEAR( ("Fused denoised image " + desc.str()).c_str(),
+               vil_math_image_abs_difference(output, expected) / (ni*nj), 0.0, eps);
+
+    dual_rof_denoise_fused(float_input, output, dual, 40, T(10.0), T(0.25),
+                           false, thread_counts[t]);
+    dual_rof_denoise_fused(float_input, output, dual, 60, T(10.0), T(0.25),
+                           true, thread_counts[t]);
+    TEST_NEAR( ("Warm started fused denoised image " + desc.str()).c_str(),
+               vil_math_image_abs_difference(output, expected) / (ni*nj), 0.0, eps);
+
+    dual_rof_weighted_denoise_fused(float_input, weights, output, dual, 100, T(100.0),
+                                    T(0.25), false, thread_counts[t]);
+    TEST_NEAR( ("Fused weighted denoised image " + desc.str()).c_str(),
+               vil_math_image_abs_difference(output, expected_weighted) / (ni*nj), 0.0, eps);
+  }
+}
+
+
 } // end anonymous namespace
 
 int test_dual_rof_denoise( int argc, char* argv[] )
@@ -144,5 +198,9 @@ int test_dual_rof_denoise( int argc, char* argv[] )
   test_weighted_denoising<double>(input, weight_denoise_truth, 0.0);
   test_weighted_denoising<float>(input, weight_denoise_truth, 1e-5);
 
+  vcl_cout << "\n\nTesting fused denoising on " << src_path << "\n\n";
+  test_fused_denoising<double>(input, 1e-10);
+  test_fused_denoising<float>(input, 1e-3);
+
   return testlib_test_summary();
 }
@@ -0,0 +1,88 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <vcl_iostream.h>
+#include <vil/vil_image_view.h>
+#include <testlib/testlib_test.h>
+
+#include <video_transforms/greyscale_process.h>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+
+void
+test_conversion()
+{
+  vcl_cout << "\n\nTest color conversion\n\n\n";
+
+  greyscale_process< vxl_byte > proc( "proc" );
+  TEST( "Initialize", proc.initialize(), true );
+
+  vil_image_view<vxl_byte> img( 4, 3, 3 );
+  img.fill( 100 );
+
+  proc.set_image( img );
+  TEST( "Step", proc.step(), true );
+  TEST( "Output has one plane", proc.image().nplanes(), 1 );
+  TEST( "Output is grey", proc.image()(1,1), 100 );
+
+  img(1,1,0) = 0;
+  TEST( "Copied output is a deep copy", proc.copied_image()(1,1), 100 );
+}
+
+
+void
+test_luma_passthrough()
+{
+  vcl_cout << "\n\nTest luma passthrough\n\n\n";
+
+  greyscale_process< vxl_byte > proc( "proc" );
+  TEST( "Initialize", proc.initialize(), true );
+
+  vil_image_view<vxl_byte> img( 4, 3, 3 );
+  img.fill( 100 );
+
+  vil_image_view<vxl_byte> luma( 4, 3, 1 );
+  luma.fill( 42 );
+
+  proc.set_image( img );
+  proc.set_luma_image( luma );
+  TEST( "Step with luma", proc.step(), true );
+  TEST( "Output is the luma plane", proc.image()(1,1), 42 );
+  TEST( "Output shares luma memory", proc.image().top_left_ptr(), luma.top_left_ptr() );
+  TEST( "Copied output is the luma plane", proc.copied_image()(1,1), 42 );
+
+  // The luma plane only applies to the step it was supplied for
+  proc.set_image( img );
+  TEST( "Step without luma", proc.step(), true );
+  TEST( "Output is converted", proc.image()(1,1), 100 );
+
+  // A luma plane of the wrong size is ignored
+  vil_image_view<vxl_byte> small_luma( 2, 2, 1 );
+  small_luma.fill( 42 );
+
+  proc.set_image( img );
+  proc.set_luma_image( small_luma );
+  TEST( "Step with mismatched luma", proc.step(), true );
+  TEST( "Mismatched luma is ignored", proc.image()(1,1), 100 );
+}
+
+
+} // end anonymous namespace
+
+int test_greyscale_process( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "greyscale_process" );
+
+  test_conversion();
+  test_luma_passthrough();
+
+  return testlib_test_summary();
+}
@@ -0,0 +1,244 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <video_transforms/image_statistics.h>
+#include <video_transforms/illumination_normalization.h>
+#include <video_transforms/percentile_image.h>
+
+#include <vil/vil_image_view.h>
+#include <vnl/vnl_random.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace {
+
+using namespace vidtk;
+
+
+template <typename PixType>
+void fill_random( vil_image_view<PixType>& img, unsigned ni, unsigned nj,
+                  unsigned nplanes, double max_value )
+{
+  vnl_random rnd( 4357 );
+  img.set_size( ni, nj, nplanes );
+
+  for( unsigned p = 0; p < nplanes; ++p )
+  {
+    for( unsigned j = 0; j < nj; ++j )
+    {
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        img( i, j, p ) = static_cast<PixType>( rnd.drand64( 0.0, max_value ) );
+      }
+    }
+  }
+}
+
+
+// Reference implementation using a full sort
+template <typename PixType>
+std::vector<PixType> sorted_plane( vil_image_view<PixType> const& img, unsigned p )
+{
+  std::vector<PixType> values;
+  for( unsigned j = 0; j < img.nj(); ++j )
+  {
+    for( unsigned i = 0; i < img.ni(); ++i )
+    {
+      values.push_back( img( i, j, p ) );
+    }
+  }
+  std::sort( values.begin(), values.end() );
+  return values;
+}
+
+
+template <typename PixType>
+double reference_median( std::vector<PixType> const& sorted )
+{
+  unsigned n = sorted.size();
+  if( n % 2 == 1 )
+  {
+    return sorted[n/2];
+  }
+  return ( static_cast<double>( sorted[n/2-1] ) + sorted[n/2] ) / 2.0;
+}
+
+
+template <typename PixType>
+void test_exact( char const* type_name, double max_value, unsigned max_threads )
+{
+  std::cout << "Testing exact statistics for " << type_name
+            << " with " << max_threads << " threads" << std::endl;
+
+  vil_image_view<PixType> img;
+  fill_random( img, 641, 479, 2, max_value );
+
+  std::vector<double> fractions;
+  fractions.push_back( 0.9 );
+  fractions.push_back( 0.0 );
+  fractions.push_back( 0.5 );
+  fractions.push_back( 1.0 );
+  fractions.push_back( 0.25 );
+
+  for( unsigned p = 0; p < img.nplanes(); ++p )
+  {
+    std::vector<PixType> sorted = sorted_plane( img, p );
+
+    image_order_statistics<PixType> stats( max_threads );
+    stats.compute( img, p );
+    TEST( "Every pixel is counted", stats.count(), sorted.size() );
+
+    std::vector<PixType> values;
+    stats.percentiles( fractions, values );
+
+    bool all_equal = ( values.size() == fractions.size() );
+    for( unsigned i = 0; i < fractions.size() && all_equal; ++i )
+    {
+      unsigned rank = static_cast<unsigned>( ( sorted.size() - 1 ) * fractions[i] + 0.5 );
+      all_equal = ( values[i] == sorted[rank] );
+    }
+    TEST( "Percentiles match sorted values", all_equal, true );
+
+    TEST_NEAR( "Median matches sorted values", stats.median(),
+               reference_median( sorted ), 1e-9 );
+    TEST_NEAR( "Plane median matches sorted values",
+               image_plane_median( img, p, max_threads ),
+               reference_median( sorted ), 1e-9 );
+  }
+}
+
+
+template <typename PixType>
+void test_sampled( char const* type_name, double max_value )
+{
+  std::cout << "Testing sampled percentiles for " << type_name << std::endl;
+
+  vil_image_view<PixType> img;
+  fill_random( img, 320, 240, 1, max_value );
+
+  std::vector<double> fractions;
+  fractions.push_back( 0.1 );
+  fractions.push_back( 0.5 );
+  fractions.push_back( 0.95 );
+
+  std::vector<PixType> sorted;
+  sample_and_sort_image( img, sorted, 1000 );
+
+  std::vector<PixType> values;
+  get_image_percentiles( img, fractions, values, 1000 );
+
+  bool all_equal = ( values.size() == fractions.size() );
+  for( unsigned i = 0; i < fractions.size() && all_equal; ++i )
+  {
+    unsigned rank = static_cast<unsigned>( ( sorted.size() - 1 ) * fractions[i] + 0.5 );
+    all_equal = ( values[i] == sorted[rank] );
+  }
+  TEST( "Sampled percentiles match sorted samples", all_equal, true );
+}
+
+
+void test_small_images()
+{
+  std::cout << "Testing small and empty images" << std::endl;
+
+  vil_image_view<vxl_byte> img( 2, 1 );
+  img( 0, 0 ) = 3;
+  img( 1, 0 ) = 8;
+  TEST_NEAR( "Even count median is averaged", image_plane_median( img ), 5.5, 1e-9 );
+
+  vil_image_view<vxl_byte> empty;
+  image_order_statistics<vxl_byte> stats;
+  stats.compute( empty );
+  TEST( "Empty image has no values", stats.count(), 0u );
+  TEST_NEAR( "Empty image median is zero", stats.median(), 0.0, 1e-9 );
+}
+
+
+void test_windowed_mean()
+{
+  std::cout << "Testing windowed mean" << std::endl;
+
+  windowed_mean window( 3 );
+  TEST_NEAR( "Empty window mean is zero", window.mean(), 0.0, 1e-9 );
+
+  window.insert( 1.0 );
+  window.insert( 2.0 );
+  TEST_NEAR( "Partial window mean", window.mean(), 1.5, 1e-9 );
+
+  window.insert( 3.0 );
+  window.insert( 10.0 );
+  TEST( "Window is full", window.size(), 3u );
+  TEST_NEAR( "Oldest value is dropped", window.mean(), 5.0, 1e-9 );
+
+  for( unsigned i = 0; i < 100; ++i )
+  {
+    window.insert( 0.1 * i );
+  }
+  TEST_NEAR( "Mean after many updates", window.mean(), 0.1 * 98, 1e-9 );
+
+  window.clear();
+  TEST( "Window is cleared", window.size(), 0u );
+}
+
+void test_illumination_median()
+{
+  std::cout << "Testing illumination normalization median" << std::endl;
+
+  // The normalizer truncates plane medians to the pixel type before
+  // combining them, matching the historical vil_math_median results.
+  median_illumination_normalization<vxl_byte> normalizer;
+
+  vil_image_view<vxl_byte> grey( 2, 1 );
+  grey( 0, 0 ) = 3;
+  grey( 1, 0 ) = 8;
+  TEST_NEAR( "Single plane median is truncated",
+             normalizer.calculate_median( grey ), 5.0, 1e-9 );
+
+  vil_image_view<vxl_byte> rgb( 2, 1, 3 );
+  rgb( 0, 0, 0 ) = 3;  rgb( 1, 0, 0 ) = 8;
+  rgb( 0, 0, 1 ) = 10; rgb( 1, 0, 1 ) = 11;
+  rgb( 0, 0, 2 ) = 0;  rgb( 1, 0, 2 ) = 1;
+  TEST_NEAR( "RGB median is the grey value of truncated medians",
+             normalizer.calculate_median( rgb ), 7.0, 1e-9 );
+
+  median_illumination_normalization<vxl_uint_16> normalizer16;
+
+  vil_image_view<vxl_uint_16> grey16( 2, 2 );
+  grey16( 0, 0 ) = 1000;
+  grey16( 1, 0 ) = 2001;
+  grey16( 0, 1 ) = 7;
+  grey16( 1, 1 ) = 60000;
+  TEST_NEAR( "16-bit median is truncated",
+             normalizer16.calculate_median( grey16 ), 1500.0, 1e-9 );
+}
+
+} // end anonymous namespace
+
+
+int test_image_statistics( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "image_statistics" );
+
+  test_exact<vxl_byte>( "vxl_byte", 256.0, 1 );
+  test_exact<vxl_byte>( "vxl_byte", 256.0, 4 );
+  test_exact<vxl_uint_16>( "vxl_uint_16", 65536.0, 1 );
+  test_exact<vxl_uint_16>( "vxl_uint_16", 65536.0, 3 );
+  test_exact<float>( "float", 1.0, 1 );
+  test_sampled<vxl_byte>( "vxl_byte", 256.0 );
+  test_sampled<vxl_uint_16>( "vxl_uint_16", 65536.0 );
+  test_sampled<float>( "float", 1.0 );
+  test_small_images();
+  test_windowed_mean();
+  test_illumination_median();
+
+  return testlib_test_summary();
+}
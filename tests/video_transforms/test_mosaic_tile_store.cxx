@@ -0,0 +1,227 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <video_transforms/mosaic_tile_store.h>
+
+#include <vil/vil_image_view.h>
+#include <vgl/vgl_box_2d.h>
+
+#include <iostream>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+typedef mosaic_tile_store< vxl_byte > store_t;
+
+
+vxl_byte
+pattern( int i, int j, unsigned p )
+{
+  return static_cast< vxl_byte >( 1 + ( ( i * 7 + j * 13 + p * 5 ) & 0x7F ) );
+}
+
+
+// Region of the mosaic filled with pattern(), top left pixel at (i0, j0)
+vil_image_view< vxl_byte >
+make_region( int i0, int j0, unsigned ni, unsigned nj, unsigned np )
+{
+  vil_image_view< vxl_byte > region( ni, nj, np );
+
+  for( unsigned p = 0; p < np; ++p )
+  {
+    for( unsigned j = 0; j < nj; ++j )
+    {
+      for( unsigned i = 0; i < ni; ++i )
+      {
+        region( i, j, p ) = pattern( i0 + i, j0 + j, p );
+      }
+    }
+  }
+
+  return region;
+}
+
+
+bool
+matches_pattern( const vil_image_view< vxl_byte >& region, int i0, int j0 )
+{
+  for( unsigned p = 0; p < region.nplanes(); ++p )
+  {
+    for( unsigned j = 0; j < region.nj(); ++j )
+    {
+      for( unsigned i = 0; i < region.ni(); ++i )
+      {
+        if( region( i, j, p ) != pattern( i0 + i, j0 + j, p ) )
+        {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+
+void
+test_indexing()
+{
+  std::cout << "\nTile indexing\n";
+
+  store_t store;
+  TEST( "Configure", store.configure( 64, 3, 1 << 20, "" ), true );
+  TEST( "Zero tile size rejected", store.configure( 0, 3, 1 << 20, "" ), false );
+
+  store.configure( 64, 3, 1 << 20, "" );
+
+  TEST( "Index of 0", store.tile_index( 0 ), 0 );
+  TEST( "Index of 63", store.tile_index( 63 ), 0 );
+  TEST( "Index of 64", store.tile_index( 64 ), 1 );
+  TEST( "Index of -1", store.tile_index( -1 ), -1 );
+  TEST( "Index of -64", store.tile_index( -64 ), -1 );
+  TEST( "Index of -65", store.tile_index( -65 ), -2 );
+
+  TEST( "Missing tile", store.find_tile( 3, -2 ) == NULL, true );
+  TEST( "Empty bounds", store.bounds().is_empty(), true );
+
+  store_t::tile_t* tile = store.writable_tile( 3, -2 );
+  TEST( "Tile created", tile != NULL && tile->ni() == 64 && tile->nplanes() == 3, true );
+  TEST( "Tile zeroed", ( *tile )( 5, 5, 2 ), 0 );
+  TEST( "Tile found", store.find_tile( 3, -2 ) == tile, true );
+  TEST( "Tile count", store.tile_count(), 1 );
+  TEST( "Bounds", store.bounds().min_x() == 192 && store.bounds().max_x() == 255 &&
+                  store.bounds().min_y() == -128 && store.bounds().max_y() == -65, true );
+}
+
+
+void
+test_copy()
+{
+  std::cout << "\nCopying regions across tiles\n";
+
+  store_t store;
+  store.configure( 64, 3, 1 << 20, "" );
+
+  // Straddles tile boundaries and the origin
+  vil_image_view< vxl_byte > region = make_region( -100, -30, 150, 90, 3 );
+  store.copy_from( -100, -30, region );
+
+  TEST( "Only touched tiles allocated", store.tile_count(), 3 * 2 );
+
+  vil_image_view< vxl_byte > inner( 40, 40, 3 );
+  store.copy_to( -70, -10, inner );
+  TEST( "Inner region read back", matches_pattern( inner, -70, -10 ), true );
+
+  vil_image_view< vxl_byte > outer( 300, 300, 3 );
+  store.copy_to( -150, -150, outer );
+  TEST( "Pixels outside the written region are zero",
+        outer( 0, 0, 0 ) == 0 && outer( 299, 299, 2 ) == 0, true );
+  TEST( "Written pixel", outer( 50, 120, 1 ), pattern( -100, -30, 1 ) );
+
+  // All zero regions do not create tiles
+  vil_image_view< vxl_byte > zeros( 128, 128, 3 );
+  zeros.fill( 0 );
+  store.copy_from( 1000, 1000, zeros );
+  TEST( "Zero region not stored", store.tile_count(), 3 * 2 );
+}
+
+
+void
+test_spilling()
+{
+  std::cout << "\nSpilling tiles beyond the memory budget\n";
+
+  const unsigned tile_bytes = 64 * 64 * 3;
+
+  store_t store;
+  store.configure( 64, 3, 2 * tile_bytes, "" );
+
+  vil_image_view< vxl_byte > region = make_region( 0, 0, 64 * 4, 64 * 2, 3 );
+  store.copy_from( 0, 0, region );
+
+  TEST( "All tiles resident before budget enforced", store.resident_count(), 8 );
+
+  store.enforce_budget();
+  TEST( "Resident tiles within budget", store.resident_count(), 2 );
+  TEST( "No tiles lost", store.tile_count(), 8 );
+
+  // Most recently written tiles stay in memory
+  TEST( "Last tile resident", store.find_tile( 3, 1 ) != NULL, true );
+  TEST( "Still within budget", store.resident_count(), 2 );
+
+  vil_image_view< vxl_byte > readback( 64 * 4, 64 * 2, 3 );
+  store.copy_to( 0, 0, readback );
+  TEST( "Spilled tiles read back", matches_pattern( readback, 0, 0 ), true );
+
+  // Modify a tile after it was read back, spill it, and read it again
+  store.enforce_budget();
+  ( *store.writable_tile( 0, 0 ) )( 1, 2, 0 ) = 0;
+  store.enforce_budget();
+  store.writable_tile( 3, 0 );
+  store.writable_tile( 2, 0 );
+  store.enforce_budget();
+  TEST( "Modified tile spilled", store.resident_count(), 2 );
+  TEST( "Modification kept", ( *store.find_tile( 0, 0 ) )( 1, 2, 0 ), 0 );
+
+  store.clear();
+  TEST( "Cleared", store.tile_count() == 0 && store.resident_count() == 0, true );
+}
+
+void
+test_remove_outside()
+{
+  std::cout << "\nRemoving tiles outside of a region\n";
+
+  const unsigned tile_bytes = 64 * 64 * 3;
+
+  store_t store;
+  store.configure( 64, 3, 2 * tile_bytes, "" );
+
+  vil_image_view< vxl_byte > region = make_region( -128, 0, 64 * 6, 64, 3 );
+  store.copy_from( -128, 0, region );
+  store.enforce_budget();
+
+  TEST( "Tiles before removal", store.tile_count(), 6 );
+  TEST( "Some tiles spilled", store.resident_count(), 2 );
+
+  // Partially overlaps tiles -1 and 1, so tiles -1 to 1 are kept
+  store.remove_outside( vgl_box_2d< int >( -10, 70, 10, 20 ) );
+
+  TEST( "Tiles after removal", store.tile_count(), 3 );
+  // Only the two most recently written tiles, 2 and 3, were resident
+  TEST( "Resident count updated", store.resident_count(), 0 );
+  TEST( "Removed spilled tile", store.find_tile( -2, 0 ) == NULL, true );
+  TEST( "Removed resident tile", store.find_tile( 3, 0 ) == NULL, true );
+
+  vil_image_view< vxl_byte > kept( 64 * 3, 64, 3 );
+  store.copy_to( -64, 0, kept );
+  TEST( "Kept tiles intact", matches_pattern( kept, -64, 0 ), true );
+
+  store.remove_outside( vgl_box_2d< int >() );
+  TEST( "Empty region removes everything",
+        store.tile_count() == 0 && store.resident_count() == 0, true );
+}
+
+} // end anonymous namespace
+
+
+int test_mosaic_tile_store( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "mosaic_tile_store" );
+
+  test_indexing();
+  test_copy();
+  test_spilling();
+  test_remove_outside();
+
+  return testlib_test_summary();
+}
@@ -0,0 +1,260 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <testlib/testlib_test.h>
+
+#include <video_transforms/moving_mosaic_generator.h>
+
+#include <vil/vil_image_view.h>
+#include <vil/vil_load.h>
+#include <vul/vul_file.h>
+#include <vul/vul_temp_filename.h>
+#include <vpl/vpl.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Put everything in an anonymous namespace so that different tests
+// won't conflict.
+namespace
+{
+
+using namespace vidtk;
+
+typedef moving_mosaic_generator< vxl_byte > generator_t;
+
+// Each frame is a 40x40 image, translated 60 pixels further right in the
+// reference frame than the previous one, on a 200x200 mosaic page.
+const unsigned image_size = 40;
+const unsigned page_size = 200;
+const double frame_step = 60.0;
+
+
+vxl_byte
+frame_value( unsigned k )
+{
+  return static_cast< vxl_byte >( 10 + 20 * k );
+}
+
+
+image_to_image_homography
+frame_homography( unsigned k )
+{
+  vgl_h_matrix_2d< double > transform;
+  transform.set_identity();
+  transform.set_translation( frame_step * k, 0.0 );
+
+  image_to_image_homography homog;
+  homog.set_transform( transform );
+  homog.set_source_reference( timestamp( k * 1.0e5, k ) );
+  homog.set_dest_reference( timestamp( 0.0, 0 ) );
+  homog.set_valid( true );
+  homog.set_new_reference( k == 0 );
+  return homog;
+}
+
+
+void
+add_frame( generator_t& generator, unsigned k )
+{
+  vil_image_view< vxl_byte > image( image_size, image_size, 1 );
+  image.fill( frame_value( k ) );
+
+  vil_image_view< bool > mask( image_size, image_size );
+  mask.fill( false );
+
+  generator.add_image( image, mask, frame_homography( k ) );
+}
+
+
+// Read the pixels of frame k's footprint back from the mosaic. Returns
+// the number of pixels found, which all have to equal \a expected.
+unsigned
+pixels_at_frame( generator_t& generator, unsigned k, vxl_byte expected, bool& matches )
+{
+  vil_image_view< bool > roi( image_size, image_size );
+  roi.fill( true );
+
+  vil_image_view< vxl_byte > pixels;
+  vil_image_view< bool > missing;
+
+  matches = true;
+
+  if( !generator.get_pixels( roi, frame_homography( k ), pixels, missing ) )
+  {
+    return 0;
+  }
+
+  unsigned found = 0;
+
+  for( unsigned j = 0; j < image_size; ++j )
+  {
+    for( unsigned i = 0; i < image_size; ++i )
+    {
+      if( !missing( i, j ) )
+      {
+        ++found;
+        matches = matches && pixels( i, j ) == expected;
+      }
+    }
+  }
+
+  return found;
+}
+
+
+struct homog_record
+{
+  unsigned frame;
+  std::string mosaic_fn;
+  double page_i;
+  double page_j;
+};
+
+
+std::vector< homog_record >
+read_homographies( const std::string& fn )
+{
+  std::vector< homog_record > records;
+  std::ifstream fin( fn.c_str() );
+
+  homog_record rec;
+  double time;
+  double m[9];
+
+  while( fin >> rec.frame >> time >> rec.mosaic_fn &&
+         fin >> m[0] >> m[1] >> m[2] >> m[3] >> m[4] >> m[5] >> m[6] >> m[7] >> m[8] )
+  {
+    rec.page_i = m[2];
+    rec.page_j = m[5];
+    records.push_back( rec );
+  }
+
+  return records;
+}
+
+
+void
+test_moving_page( const std::string& output_dir )
+{
+  std::cout << "\nMoving the mosaic page\n";
+
+  moving_mosaic_settings settings;
+  config_block blk = settings.config();
+  blk.set( "mosaic_resolution", "200 200 1" );
+  blk.set( "mosaic_tile_size", "32" );
+  blk.set( "mosaic_memory_budget", "0" );
+  blk.set( "mosaic_retain_margin", "200" );
+  blk.set( "mosaic_output_dir", output_dir );
+  blk.set( "mosaic_homog_file", "homogs.txt" );
+  blk.set( "mosaic_method", "use_latest" );
+  blk.set( "inpaint_output_mosaics", "false" );
+  settings.read_config( blk );
+
+  generator_t generator;
+  TEST( "Configure", generator.configure( settings ), true );
+
+  // Frames 0 and 1 fit on the first page, frames 2 and 4 move it
+  for( unsigned k = 0; k < 6; ++k )
+  {
+    add_frame( generator, k );
+  }
+
+  std::vector< homog_record > records = read_homographies( output_dir + "/homogs.txt" );
+  TEST( "Homography per frame", records.size(), 6 );
+
+  if( records.size() != 6 )
+  {
+    return;
+  }
+
+  // Every time the page moves, the image is re-centered on it
+  const double first = ( page_size - image_size ) / 2;
+  bool on_page = true;
+
+  for( unsigned k = 0; k < records.size(); ++k )
+  {
+    const double expected_i = first + ( k % 2 ) * frame_step;
+
+    if( records[k].frame != k || records[k].page_i != expected_i || records[k].page_j != first )
+    {
+      std::cout << "Frame " << records[k].frame << " at " << records[k].page_i << ", "
+                << records[k].page_j << ", expected " << expected_i << ", " << first << "\n";
+      on_page = false;
+    }
+  }
+  TEST( "Page origin follows the camera", on_page, true );
+
+  TEST( "Same page before moving", records[0].mosaic_fn == records[1].mosaic_fn, true );
+  TEST( "New page after moving", records[2].mosaic_fn != records[1].mosaic_fn, true );
+  TEST( "Same page after moving", records[3].mosaic_fn == records[2].mosaic_fn, true );
+  TEST( "New page after moving again", records[4].mosaic_fn != records[3].mosaic_fn, true );
+
+  // Pages are written out when the page moves
+  const unsigned c = static_cast< unsigned >( first ) + image_size / 2;
+
+  vil_image_view< vxl_byte > page1 = vil_load( ( output_dir + "/" + records[1].mosaic_fn ).c_str() );
+  TEST( "First page written", page1.ni() == page_size && page1.nj() == page_size, true );
+
+  if( page1 )
+  {
+    TEST( "First page, frame 0", page1( c, c ), frame_value( 0 ) );
+    TEST( "First page, frame 1", page1( c + 60, c ), frame_value( 1 ) );
+  }
+
+  vil_image_view< vxl_byte > page2 = vil_load( ( output_dir + "/" + records[3].mosaic_fn ).c_str() );
+  TEST( "Second page written", page2.ni() == page_size && page2.nj() == page_size, true );
+
+  if( page2 )
+  {
+    TEST( "Second page, frame 2", page2( c, c ), frame_value( 2 ) );
+    TEST( "Second page, frame 3", page2( c + 60, c ), frame_value( 3 ) );
+    TEST( "Second page keeps frame 1", page2( c - 60, c ), frame_value( 1 ) );
+    TEST( "Second page, frame 0 outside", page2( 0, c ), 0 );
+  }
+
+  // Frame 0 is no longer on the page, and its tiles were spilled, but
+  // its pixels are kept for when the camera returns
+  bool matches = false;
+  unsigned found = pixels_at_frame( generator, 0, frame_value( 0 ), matches );
+  TEST( "Pixels found off the page", found, image_size * image_size );
+  TEST( "Pixels off the page are correct", matches, true );
+
+  found = pixels_at_frame( generator, 3, frame_value( 3 ), matches );
+  TEST( "Pixels found on the page", found, image_size * image_size );
+  TEST( "Pixels on the page are correct", matches, true );
+
+  // Moving the page further discards tiles beyond the retain margin
+  add_frame( generator, 6 );
+  add_frame( generator, 7 );
+
+  found = pixels_at_frame( generator, 0, frame_value( 0 ), matches );
+  TEST( "Distant pixels discarded", found, 0 );
+
+  found = pixels_at_frame( generator, 5, frame_value( 5 ), matches );
+  TEST( "Nearby pixels kept", found, image_size * image_size );
+  TEST( "Nearby pixels are correct", matches, true );
+}
+
+} // end anonymous namespace
+
+
+int test_moving_mosaic_generator( int /*argc*/, char* /*argv*/[] )
+{
+  testlib_test_start( "moving_mosaic_generator" );
+
+  std::string output_dir = vul_temp_filename();
+  vul_file::make_directory( output_dir );
+
+  test_moving_page( output_dir );
+
+  vul_file::delete_file_glob( output_dir + "/*" );
+  vpl_rmdir( output_dir.c_str() );
+
+  return testlib_test_summary();
+}
@@ -1,5 +1,5 @@
 /*ckwg +5
- * Copyright 2012-2013 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
@@ -26,6 +26,7 @@ namespace
 using namespace vidtk;
 
 bool callback_called = false;
+double last_relative_change = -1.0;
 
 //Create the warps for downsampled images
 vcl_vector<adjoint_image_ops_func<double> >
@@ -109,14 +110,19 @@ void test_super_res(const vil_image_view<double> &img,
 
   TEST_NEAR( "Super Resolved Image", diff, 0.0, eps);
   TEST( "Callback Called", callback_called, srm != NULL);
+  if (srm)
+  {
+    TEST( "Convergence Reported", last_relative_change >= 0.0 && last_relative_change < 1.0, true);
+  }
   callback_called = false;
 }
 
 } // end anonymous namespace
 
-void super_res_callback(super_resolution_monitor::update_data)
+void super_res_callback(super_resolution_monitor::update_data data)
 {
   callback_called = true;
+  last_relative_change = data.relative_change;
 }
 
 
@@ -1,11 +1,12 @@
 /*ckwg +5
- * Copyright 2012-2015 by Kitware, Inc. All Rights Reserved. Please refer to
+ * Copyright 2012-2016 by Kitware, Inc. All Rights Reserved. Please refer to
  * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
  * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
  */
 
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
 #include <vil/vil_image_view.h>
 #include <vil/vil_save.h>
 #include <vil/vil_rgb.h>
@@ -254,6 +255,88 @@ test_simple_median_illumination()
   }
 }
 
+void
+test_color_lut_agreement()
+{
+  // Smooth, tinted color gradient with some texture for the smoothing
+  vil_image_view<vxl_byte> input( 64, 48, 3 );
+
+  for( unsigned j = 0; j < input.nj(); ++j )
+  {
+    for( unsigned i = 0; i < input.ni(); ++i )
+    {
+      const unsigned texture = ( ( i + j ) % 3 ) * 4;
+      input(i,j,0) = static_cast<vxl_byte>( 20 + 2 * i + texture );
+      input(i,j,1) = static_cast<vxl_byte>( 30 + 3 * j + texture );
+      input(i,j,2) = static_cast<vxl_byte>( 90 + i + j );
+    }
+  }
+
+  video_enhancement_process< vxl_byte > separate("separate_proc");
+  video_enhancement_process< vxl_byte > fused("fused_proc");
+
+  config_block test_setup = separate.params();
+  test_setup.set( "smoothing_enabled", "true" );
+  test_setup.set( "auto_white_balance", "true" );
+  test_setup.set( "inversion_enabled", "true" );
+  test_setup.set( "normalize_brightness", "false" );
+
+  TEST( "Default LUT resolution keeps separate passes",
+        test_setup.get<unsigned>( "color_lut_resolution" ), 0 );
+
+  TEST( "Configure separate passes", separate.set_params( test_setup ), true );
+  TEST( "Initialize separate passes", separate.initialize(), true );
+
+  test_setup.set( "color_lut_resolution", "33" );
+
+  TEST( "Configure color LUT", fused.set_params( test_setup ), true );
+  TEST( "Initialize color LUT", fused.initialize(), true );
+
+  double max_mean_diff = 0.0;
+
+  // Several frames, so that the averaged white balancing correction is
+  // compared after it is updated as well.
+  for( unsigned frame = 0; frame < 3; ++frame )
+  {
+    separate.set_source_image( input );
+    fused.set_source_image( input );
+
+    TEST( "Step separate passes", separate.step(), true );
+    TEST( "Step color LUT", fused.step(), true );
+
+    vil_image_view< vxl_byte > out1 = separate.output_image();
+    vil_image_view< vxl_byte > out2 = fused.output_image();
+
+    if( out1.ni() != out2.ni() || out1.nj() != out2.nj() ||
+        out1.nplanes() != out2.nplanes() )
+    {
+      TEST( "Output sizes match", false, true );
+      return;
+    }
+
+    double diff_sum = 0.0;
+
+    for( unsigned p = 0; p < out1.nplanes(); ++p )
+    {
+      for( unsigned j = 0; j < out1.nj(); ++j )
+      {
+        for( unsigned i = 0; i < out1.ni(); ++i )
+        {
+          diff_sum += std::abs( static_cast<int>( out1(i,j,p) ) -
+                                static_cast<int>( out2(i,j,p) ) );
+        }
+      }
+    }
+
+    const double mean_diff = diff_sum / out1.size();
+    max_mean_diff = std::max( max_mean_diff, mean_diff );
+  }
+
+  // The table interpolates the white balancing correction between its bin
+  // centers, and rounds once instead of after each pass.
+  TEST( "Color LUT output is close to separate passes", max_mean_diff < 4.0, true );
+}
+
 } // end anonymous namespace
 
 int test_video_enhancement_process( int /*argc*/, char* /*argv*/[] )
@@ -263,6 +346,7 @@ int test_video_enhancement_process( int /*argc*/, char* /*argv*/[] )
   test_config();
   test_simple_balancing();
   test_simple_median_illumination();
+  test_color_lut_agreement();
 
   return testlib_test_summary();
 }
@@ -0,0 +1,244 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <descriptors/bag_of_words_model.h>
+
+#include <vnl/vnl_random.h>
+
+#include <vul/vul_arg.h>
+#include <vul/vul_timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <logger/logger.h>
+
+VIDTK_LOGGER( "bag_of_words_benchmark_cxx" );
+
+using namespace vidtk;
+
+typedef std::vector< std::vector< float > > word_vector_t;
+
+
+// Unit length vectors mixing a few of a set of nonnegative parts, so that
+// like SIFT words they lie near a low dimensional subset of the space
+std::vector< float >
+random_word( const word_vector_t& parts, vnl_random& rng )
+{
+  const unsigned length = parts[0].size();
+  std::vector< float > word( length, 0.0f );
+
+  for( unsigned p = 0; p < 4; ++p )
+  {
+    const std::vector< float >& part = parts[ rng.lrand32( 0, parts.size() - 1 ) ];
+    const float weight = static_cast< float >( rng.drand64( 0.2, 1.0 ) );
+
+    for( unsigned d = 0; d < length; ++d )
+    {
+      word[d] += weight * part[d];
+    }
+  }
+
+  double norm = 0;
+  for( unsigned d = 0; d < length; ++d )
+  {
+    word[d] = std::max( 0.0f, word[d] + static_cast< float >( rng.normal() * 0.02 ) );
+    norm += word[d] * word[d];
+  }
+  for( unsigned d = 0; d < length; ++d )
+  {
+    word[d] /= std::sqrt( norm );
+  }
+  return word;
+}
+
+
+// Nearest word of every feature with plain loops over the vocabulary, as
+// the mapping was done before the distance kernels and index were added
+void
+scalar_nearest_words( const word_vector_t& model,
+                      const word_vector_t& features,
+                      std::vector< unsigned >& nearest )
+{
+  nearest.resize( features.size() );
+
+  for( unsigned i = 0; i < features.size(); ++i )
+  {
+    double min_dist = std::numeric_limits< double >::max();
+
+    for( unsigned j = 0; j < model.size(); ++j )
+    {
+      double dist = 0;
+      for( unsigned d = 0; d < model[j].size(); ++d )
+      {
+        const double diff = static_cast< double >( features[i][d] ) - model[j][d];
+        dist += diff * diff;
+      }
+      if( dist < min_dist )
+      {
+        min_dist = dist;
+        nearest[i] = j;
+      }
+    }
+  }
+}
+
+
+// Average time of mapping all features in milliseconds
+double
+time_mapping( const bag_of_words_model< float, double >& bow_vocab,
+              const word_vector_t& features,
+              const bow_mapping_settings& options,
+              unsigned repeats )
+{
+  std::vector< double > output;
+  vul_timer timer;
+
+  for( unsigned r = 0; r < repeats; ++r )
+  {
+    bow_vocab.map_to_model( features, options, output );
+  }
+
+  return static_cast< double >( timer.real() ) / repeats;
+}
+
+
+int main( int argc, char** argv )
+{
+  vul_arg< unsigned > word_count(
+    "--words",
+    "Number of words in the synthetic vocabulary.",
+    2048 );
+  vul_arg< unsigned > length(
+    "--length",
+    "Number of bins per word.",
+    128 );
+  vul_arg< unsigned > feature_count(
+    "--features",
+    "Number of features mapped onto the vocabulary.",
+    2000 );
+  vul_arg< unsigned > max_checks(
+    "--max-checks",
+    "Largest search budget of the approximate search. Budgets double "
+    "from 32 up to this value.",
+    512 );
+  vul_arg< unsigned > repeats(
+    "--repeats",
+    "Number of times each mapping is repeated.",
+    5 );
+  vul_arg< bool > single_vote(
+    "--single-vote",
+    "Vote for the nearest word only, instead of the top 3 weighted matches.",
+    false );
+
+  vul_arg_parse( argc, argv );
+
+  if( word_count() == 0 || length() == 0 || feature_count() == 0 || repeats() == 0 )
+  {
+    LOG_ERROR( "Word count, length, feature count and repeats must be positive" );
+    return EXIT_FAILURE;
+  }
+
+  vnl_random rng( 1234 );
+
+  word_vector_t parts( 64, std::vector< float >( length() ) );
+  for( unsigned p = 0; p < parts.size(); ++p )
+  {
+    for( unsigned d = 0; d < length(); ++d )
+    {
+      parts[p][d] = static_cast< float >( std::max( 0.0, rng.normal() ) );
+    }
+  }
+
+  word_vector_t model( word_count() );
+  for( unsigned i = 0; i < word_count(); ++i )
+  {
+    model[i] = random_word( parts, rng );
+  }
+
+  word_vector_t features( feature_count() );
+  for( unsigned i = 0; i < feature_count(); ++i )
+  {
+    features[i] = random_word( parts, rng );
+  }
+
+  vul_timer build_timer;
+
+  bag_of_words_model< float, double > bow_vocab;
+  bow_vocab.set_model( model );
+
+  std::cout << "Built index of " << word_count() << " x " << length()
+            << " words in " << build_timer.real() << " ms" << std::endl;
+
+  // Nearest words for the recall of the approximate search
+  std::vector< unsigned > nearest;
+  vul_timer scalar_timer;
+  scalar_nearest_words( model, features, nearest );
+  const double scalar_ms = scalar_timer.real();
+
+  bow_mapping_settings options;
+  if( single_vote() )
+  {
+    options.voting_method_ = bow_mapping_settings::SINGLE_VOTE_UNWEIGHTED;
+  }
+
+  const double us_per_ms = 1000.0 / feature_count();
+
+  std::cout << std::setw( 20 ) << "search"
+            << std::setw( 12 ) << "checks"
+            << std::setw( 12 ) << "ms"
+            << std::setw( 14 ) << "us/feature"
+            << std::setw( 10 ) << "recall" << std::endl;
+
+  std::cout << std::setw( 20 ) << "scalar nearest"
+            << std::setw( 12 ) << word_count()
+            << std::setw( 12 ) << scalar_ms
+            << std::setw( 14 ) << scalar_ms * us_per_ms
+            << std::setw( 10 ) << 1.0 << std::endl;
+
+  options.search_method_ = bow_mapping_settings::EXACT;
+  const double exact_ms = time_mapping( bow_vocab, features, options, repeats() );
+
+  std::cout << std::setw( 20 ) << "EXACT"
+            << std::setw( 12 ) << word_count()
+            << std::setw( 12 ) << exact_ms
+            << std::setw( 14 ) << exact_ms * us_per_ms
+            << std::setw( 10 ) << 1.0 << std::endl;
+
+  options.search_method_ = bow_mapping_settings::APPROXIMATE;
+
+  const bag_of_words_index< float >& index = bow_vocab.index();
+  bag_of_words_index< float >::search_buffer buffer;
+  unsigned found;
+
+  for( unsigned checks = 32; checks <= max_checks(); checks *= 2 )
+  {
+    unsigned hits = 0;
+    for( unsigned i = 0; i < feature_count(); ++i )
+    {
+      index.find_nearest( &features[i][0], bag_of_words_index< float >::EUCLIDEAN,
+                          1, checks, &found, buffer );
+      hits += ( found == nearest[i] );
+    }
+
+    options.max_checks_ = checks;
+    const double approx_ms = time_mapping( bow_vocab, features, options, repeats() );
+
+    std::cout << std::setw( 20 ) << "APPROXIMATE"
+              << std::setw( 12 ) << checks
+              << std::setw( 12 ) << approx_ms
+              << std::setw( 14 ) << approx_ms * us_per_ms
+              << std::setw( 10 ) << static_cast< double >( hits ) / feature_count()
+              << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -10,6 +10,9 @@
 #include <process_framework/process.h>
 
 #include <utilities/folder_manipulation.h>
+#include <utilities/config_block_parser.h>
+#include <utilities/config_snapshot.h>
+#include <utilities/phase_timer.h>
 
 #include <pipelines/remove_burnin_pipeline.h>
 
@@ -241,6 +244,16 @@ int main( int argc, char** argv )
     "A pointer to the root config_mappings.ini file. This only needs "
     "to be specified if the file can't be found in a default location.",
     "" );
+  vul_arg< std::string > config_snapshot_file(
+    "--config-snapshot",
+    "An optional file caching the parsed configuration and models. It is "
+    "created on the first run and reused by later runs, as long as the "
+    "configuration, model files and extra arguments stay the same.",
+    "" );
+  vul_arg< bool > show_startup_timing(
+    "--show-startup-timing",
+    "Print how long each phase of pipeline startup took.",
+    false );
 
   if( argc == 1 )
   {
@@ -290,6 +303,9 @@ int main( int argc, char** argv )
     return EXIT_FAILURE;
   }
 
+  phase_timer startup_timer;
+  startup_timer.start( "pipeline construction" );
+
   // Setup pipeline
   async_pipeline p;
 
@@ -313,6 +329,8 @@ int main( int argc, char** argv )
                burnin_remover->set_image_port() );
     p.connect( frame_source->timestamp_port(),
                burnin_remover->set_timestamp_port() );
+    p.connect( frame_source->luma_image_port(),
+               burnin_remover->set_luma_image_port() );
   }
   else
   {
@@ -345,6 +363,8 @@ int main( int argc, char** argv )
                image_writer->set_timestamp_port() );
   }
 
+  startup_timer.start( "configuration" );
+
   config_block config = p.params();
 
   // Disable inpainted writer by default
@@ -414,12 +434,58 @@ int main( int argc, char** argv )
     return EXIT_FAILURE;
   }
 
-  // Read config file
+  // Read config file, or the snapshot of a previous run using the same
+  // config files and the same remaining (non-option) arguments
   fs::path config_fn( "remove_burnin_" + sensor_mappings[ sensor_type_lc ] + ".conf" );
-  config.parse( ( config_dir / config_fn ).string() );
+  std::string const config_path = ( config_dir / config_fn ).string();
+
+  config_snapshot_sptr snapshot;
 
-  // Parse the remaining arguments as additions to the config file
-  config.parse_arguments( argc, argv );
+  if( !config_snapshot_file().empty() )
+  {
+    std::string snapshot_key = config_path;
+
+    for( int i = 1; i < argc; ++i )
+    {
+      snapshot_key += std::string( "\n" ) + argv[i];
+    }
+
+    snapshot.reset( new config_snapshot() );
+
+    if( !snapshot->load( config_snapshot_file() ) ||
+        !snapshot->is_current( snapshot_key ) ||
+        !snapshot->apply( config ) )
+    {
+      snapshot.reset( new config_snapshot() );
+      snapshot->set_key( snapshot_key );
+    }
+  }
+
+  if( !snapshot || snapshot->is_recording() )
+  {
+    config_block_parser parser;
+
+    if( !parser.set_filename( config_path ) || !parser.parse( config ) )
+    {
+      LOG_ERROR( "Unable to parse config file " << config_path );
+    }
+
+    // Parse the remaining arguments as additions to the config file
+    config.parse_arguments( argc, argv );
+
+    if( snapshot )
+    {
+      snapshot->set_config( config );
+
+      for( unsigned i = 0; i < parser.files_read().size(); ++i )
+      {
+        snapshot->add_dependency( parser.files_read()[i] );
+      }
+    }
+  }
+
+  // Model loaders pick up pre-parsed models from, or record them into, the snapshot
+  config_snapshot::set_active( snapshot );
 
   // Apply all of our special command line options
   double video_fr;
@@ -710,18 +776,43 @@ int main( int argc, char** argv )
   }
 
   // Run the pipeline normally
+  startup_timer.start( "set_params" );
+
   if( !p.set_params( config ) )
   {
     std::cerr << "Failed to set pipeline parameters" << std::endl;
     return EXIT_FAILURE;
   }
 
+  startup_timer.start( "initialize" );
+
   if( !p.initialize() )
   {
     std::cout << "Failed to initialize pipeline" << std::endl;
     return EXIT_FAILURE;
   }
 
+  if( snapshot && snapshot->is_recording() )
+  {
+    startup_timer.start( "snapshot writing" );
+
+    checked_bool written = snapshot->write( config_snapshot_file() );
+
+    if( !written )
+    {
+      LOG_WARN( "Unable to write config snapshot: " << written.message() );
+    }
+  }
+
+  config_snapshot::set_active( config_snapshot_sptr() );
+  startup_timer.stop();
+
+  if( show_startup_timing() )
+  {
+    std::cout << std::endl << "Startup Timing" << std::endl;
+    startup_timer.report( std::cout );
+  }
+
   std::cout << std::endl << "Processing Video Data" << std::endl << std::endl;
 
   video_writer->set_frame_count( frame_source->nframes() / downsampling_rate );
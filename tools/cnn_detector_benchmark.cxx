@@ -0,0 +1,166 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <utilities/string_to_vector.h>
+
+#include <object_detectors/cnn_detector.h>
+
+#include <vil/vil_image_view.h>
+#include <vil/vil_load.h>
+#include <vil/vil_convert.h>
+
+#include <vul/vul_arg.h>
+#include <vul/vul_timer.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <logger/logger.h>
+
+VIDTK_LOGGER( "cnn_detector_benchmark_cxx" );
+
+using namespace vidtk;
+
+
+typedef std::string string_t;
+typedef std::vector< unsigned > unsigned_vec_t;
+typedef cnn_detector< vxl_byte > detector_t;
+
+
+int main( int argc, char** argv )
+{
+  // Input options and parsing
+  vul_arg< string_t > model_definition(
+    0,
+    "CNN model definition file.",
+    "" );
+  vul_arg< string_t > model_weights(
+    0,
+    "CNN model weights file.",
+    "" );
+  vul_arg< string_t > input_image(
+    0,
+    "Input image to run the detector on.",
+    "" );
+  vul_arg< string_t > chip_sizes_str(
+    "--chip-sizes",
+    "Comma seperated list of square chip sizes to test, 0 processes the "
+    "full image as a single chip.",
+    "0" );
+  vul_arg< string_t > batch_sizes_str(
+    "--batch-sizes",
+    "Comma seperated list of chip batch sizes to test.",
+    "1,2,4,8" );
+  vul_arg< string_t > thread_counts_str(
+    "--thread-counts",
+    "Comma seperated list of CPU thread counts to test, 0 uses all "
+    "hardware threads.",
+    "1,0" );
+  vul_arg< unsigned > frame_count(
+    "--frame-count",
+    "Number of copies of the input image given to each batch detect call.",
+    1 );
+  vul_arg< unsigned > iterations(
+    "--iterations",
+    "Number of timed iterations per configuration.",
+    10 );
+  vul_arg< bool > use_gpu(
+    "--use-gpu",
+    "Use a GPU if one is available.",
+    false );
+
+  if( argc < 4 )
+  {
+    vul_arg_base::display_usage_and_exit( "Invalid input provided." );
+    return EXIT_FAILURE;
+  }
+
+  vul_arg_parse( argc, argv );
+
+  unsigned_vec_t chip_sizes, batch_sizes, thread_counts;
+
+  if( !string_to_vector( chip_sizes_str(), chip_sizes ) ||
+      !string_to_vector( batch_sizes_str(), batch_sizes ) ||
+      !string_to_vector( thread_counts_str(), thread_counts ) )
+  {
+    LOG_ERROR( "Unable to parse chip size, batch size or thread count list" );
+    return EXIT_FAILURE;
+  }
+
+  vil_image_view< vxl_byte > image;
+  vil_convert_cast( vil_load( input_image().c_str() ), image );
+
+  if( !image )
+  {
+    LOG_ERROR( "Unable to load image: " << input_image() );
+    return EXIT_FAILURE;
+  }
+
+  const std::vector< vil_image_view< vxl_byte > > frames(
+    std::max( 1u, frame_count() ), image );
+
+  std::cout << std::setw( 10 ) << "chip"
+            << std::setw( 10 ) << "batch"
+            << std::setw( 10 ) << "threads"
+            << std::setw( 14 ) << "ms/call"
+            << std::setw( 14 ) << "ms/frame" << std::endl;
+
+  for( unsigned c = 0; c < chip_sizes.size(); ++c )
+  {
+    for( unsigned b = 0; b < batch_sizes.size(); ++b )
+    {
+      for( unsigned t = 0; t < thread_counts.size(); ++t )
+      {
+        cnn_detector_settings settings;
+
+        settings.model_definition = model_definition();
+        settings.model_weights = model_weights();
+        settings.use_gpu = ( use_gpu() ? cnn_detector_settings::AUTO : cnn_detector_settings::NO );
+        settings.detection_mode = cnn_detector_settings::FIXED_SIZE;
+        settings.nms_option = cnn_detector_settings::ALL;
+        settings.chip_ni = chip_sizes[c];
+        settings.chip_nj = chip_sizes[c];
+        settings.batch_size = batch_sizes[b];
+        settings.thread_count = thread_counts[t];
+
+        detector_t detector;
+
+        if( !detector.configure( settings ) )
+        {
+          LOG_ERROR( "Unable to configure detector" );
+          return EXIT_FAILURE;
+        }
+
+        std::vector< detector_t::detection_map_t > maps;
+        std::vector< detector_t::detection_mask_t > masks;
+        std::vector< detector_t::detection_vec_t > detections;
+
+        // Untimed warm-up call, for any lazy allocations in the network
+        detector.batch_detect( frames, maps, masks, detections );
+
+        vul_timer timer;
+
+        for( unsigned i = 0; i < iterations(); ++i )
+        {
+          detector.batch_detect( frames, maps, masks, detections );
+        }
+
+        const double ms_per_call = timer.real() / static_cast< double >( std::max( 1u, iterations() ) );
+
+        std::cout << std::setw( 10 ) << chip_sizes[c]
+                  << std::setw( 10 ) << batch_sizes[b]
+                  << std::setw( 10 ) << thread_counts[t]
+                  << std::setw( 14 ) << ms_per_call
+                  << std::setw( 14 ) << ms_per_call / frames.size() << std::endl;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
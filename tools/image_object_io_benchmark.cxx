@@ -0,0 +1,179 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <tracking_data/image_object.h>
+#include <tracking_data/io/image_object_reader.h>
+#include <tracking_data/io/image_object_writer_process.h>
+
+#include <utilities/string_to_vector.h>
+
+#include <vul/vul_arg.h>
+#include <vul/vul_file.h>
+#include <vul/vul_timer.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <logger/logger.h>
+
+VIDTK_LOGGER( "image_object_io_benchmark_cxx" );
+
+using namespace vidtk;
+
+
+typedef std::vector< std::string > string_vec_t;
+
+
+// Synthetic detections for one frame
+std::vector< image_object_sptr >
+make_objects( unsigned frame, unsigned count )
+{
+  std::vector< image_object_sptr > objs;
+
+  for( unsigned i = 0; i < count; ++i )
+  {
+    const unsigned x = ( 37 * i + 11 * frame ) % 1900;
+    const unsigned y = ( 53 * i + 7 * frame ) % 1060;
+
+    image_object_sptr obj = new image_object;
+    obj->set_bbox( x, x + 20, y, y + 20 );
+    obj->set_image_loc( x + 10.0, y + 10.0 );
+    obj->set_world_loc( x + 10.0, y + 10.0, 0.0 );
+    obj->set_area( 400.0 );
+    obj->set_confidence( 0.5 + ( i % 50 ) / 100.0 );
+    objs.push_back( obj );
+  }
+
+  return objs;
+}
+
+
+int main( int argc, char** argv )
+{
+  vul_arg< std::string > output_dir(
+    "--output-dir",
+    "Directory to write the benchmark files into.",
+    "." );
+  vul_arg< std::string > formats_str(
+    "--formats",
+    "Comma seperated list of image object writer formats to test.",
+    "kw18,vsl,protobuf" );
+  vul_arg< unsigned > frame_count(
+    "--frame-count",
+    "Number of frames to write.",
+    1000 );
+  vul_arg< unsigned > object_count(
+    "--object-count",
+    "Number of image objects per frame.",
+    200 );
+  vul_arg< unsigned > flush_interval(
+    "--flush-interval",
+    "Frames between flushes, for writers which buffer their output.",
+    0 );
+
+  vul_arg_parse( argc, argv );
+
+  string_vec_t formats;
+
+  if( !string_to_vector( formats_str(), formats ) )
+  {
+    LOG_ERROR( "Unable to parse format list" );
+    return EXIT_FAILURE;
+  }
+
+  // Writers force their own file extension
+  std::map< std::string, std::string > extensions;
+  extensions[ "kw18" ] = ".kw18";
+  extensions[ "vsl" ] = ".vsl";
+  extensions[ "protobuf" ] = ".kwpc";
+
+  // Generate all input up front, so only writing is timed
+  std::vector< std::vector< image_object_sptr > > frames( frame_count() );
+
+  for( unsigned f = 0; f < frames.size(); ++f )
+  {
+    frames[f] = make_objects( f, object_count() );
+  }
+
+  std::cout << std::setw( 12 ) << "format"
+            << std::setw( 14 ) << "write ms"
+            << std::setw( 14 ) << "ms/frame"
+            << std::setw( 14 ) << "read ms"
+            << std::setw( 14 ) << "objects" << std::endl;
+
+  for( unsigned i = 0; i < formats.size(); ++i )
+  {
+    if( extensions.find( formats[i] ) == extensions.end() )
+    {
+      LOG_ERROR( "Unknown format " << formats[i] );
+      return EXIT_FAILURE;
+    }
+
+    const std::string filename =
+      output_dir() + "/image_object_benchmark" + extensions[ formats[i] ];
+
+    vul_timer write_timer;
+
+    {
+      image_object_writer_process writer( "writer" );
+
+      config_block blk = writer.params();
+      blk.set( "disabled", "false" );
+      blk.set( "format", formats[i] );
+      blk.set( "filename", filename );
+      blk.set( "overwrite_existing", "true" );
+      blk.set( "flush_interval", flush_interval() );
+
+      // Formats may be provided by optional plugins
+      if( !writer.set_params( blk ) || !writer.initialize() )
+      {
+        LOG_WARN( "Skipping format " << formats[i] << ", no writer is available" );
+        continue;
+      }
+
+      for( unsigned f = 0; f < frames.size(); ++f )
+      {
+        writer.set_timestamp( timestamp( f * 1e5, f ) );
+        writer.set_image_objects( frames[f] );
+        writer.step();
+      }
+
+      // Buffered output is completed when the writer is destroyed
+    }
+
+    const double write_ms = write_timer.real();
+
+    vul_timer read_timer;
+
+    image_object_reader reader( filename );
+    image_object_reader::object_vector_t objects;
+
+    if( !reader.open() )
+    {
+      LOG_ERROR( "Unable to read back " << filename );
+      return EXIT_FAILURE;
+    }
+
+    reader.read_all( objects );
+
+    const double read_ms = read_timer.real();
+
+    std::cout << std::setw( 12 ) << formats[i]
+              << std::setw( 14 ) << write_ms
+              << std::setw( 14 ) << write_ms / std::max( 1u, frame_count() )
+              << std::setw( 14 ) << read_ms
+              << std::setw( 14 ) << objects.size() << std::endl;
+
+    vul_file::delete_file_glob( filename );
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,222 @@
+/*ckwg +5
+ * Copyright 2016 by Kitware, Inc. All Rights Reserved. Please refer to
+ * KITWARE_LICENSE.TXT for licensing information, or contact General Counsel,
+ * Kitware, Inc., 28 Corporate Drive, Clifton Park, NY 12065.
+ */
+
+#include <tracking_data/track.h>
+#include <tracking_data/io/image_object_reader.h>
+#include <tracking_data/io/track_reader.h>
+
+#include <utilities/blank_line_filter.h>
+#include <utilities/compute_pool.h>
+#include <utilities/shell_comments_filter.h>
+
+#include <vul/vul_arg.h>
+#include <vul/vul_file.h>
+#include <vul/vul_timer.h>
+
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/tokenizer.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <logger/logger.h>
+
+VIDTK_LOGGER( "kw18_reader_benchmark_cxx" );
+
+using namespace vidtk;
+
+
+// Write a synthetic kw18 file with interleaved tracks
+bool
+write_kw18( std::string const& filename, unsigned rows, unsigned track_count )
+{
+  FILE* out = std::fopen( filename.c_str(), "w" );
+
+  if( !out )
+  {
+    return false;
+  }
+
+  std::fprintf( out, "# 1:Track-id 2:Track-length 3:Frame-number 4-5:Tracking-plane-loc(x,y) "
+                "6-7:velocity(x,y) 8-9:Image-loc(x,y) 10-13:Img-bbox(TL_x,TL_y,BR_x,BR_y) "
+                "14:Area 15-17:World-loc(x,y,z) 18:timestamp 19:object-type-id "
+                "20:activity-type-id\n" );
+
+  for( unsigned r = 0; r < rows; ++r )
+  {
+    const unsigned frame = r / track_count;
+    const unsigned id = r % track_count;
+    const double x = ( 37 * id + 3 * frame ) % 1900 + 0.25;
+    const double y = ( 53 * id + 2 * frame ) % 1060 + 0.75;
+
+    std::fprintf( out, "%u %u %u %.3f %.3f %.4f %.4f %.3f %.3f %d %d %d %d %.1f "
+                  "%.6f %.6f 0 %.6f -1 -1\n",
+                  id, 1u, frame, x, y, 3.0, -2.0, x, y,
+                  int( x ) - 10, int( y ) - 10, int( x ) + 10, int( y ) + 10, 400.0,
+                  -73.75 + x * 1e-5, 42.85 + y * 1e-5, frame / 30.0 );
+  }
+
+  return std::fclose( out ) == 0;
+}
+
+
+// Tokenize and convert every line through a filtered stream, as the
+// readers used to, to give a reference for the parsing cost alone
+size_t
+read_with_stream( std::string const& filename )
+{
+  std::ifstream fstr( filename.c_str() );
+
+  boost::iostreams::filtering_istream in_stream;
+  in_stream.push( vidtk::blank_line_filter() );
+  in_stream.push( vidtk::shell_comments_filter() );
+  in_stream.push( fstr );
+
+  typedef boost::tokenizer< boost::char_separator< char > > tok_t;
+  boost::char_separator< char > sep( " " );
+
+  std::string line;
+  size_t rows = 0;
+  double sum = 0;
+
+  while( std::getline( in_stream, line ) )
+  {
+    tok_t tok( line, sep );
+    for( tok_t::iterator it = tok.begin(); it != tok.end(); ++it )
+    {
+      sum += std::atof( it->c_str() );
+    }
+    ++rows;
+  }
+
+  LOG_DEBUG( "Checksum " << sum );
+  return rows;
+}
+
+
+int main( int argc, char** argv )
+{
+  vul_arg< std::string > input(
+    "--input",
+    "Existing kw18 file to read. If not set, a synthetic file is generated.",
+    "" );
+  vul_arg< std::string > output_dir(
+    "--output-dir",
+    "Directory to write the synthetic file into.",
+    "." );
+  vul_arg< unsigned > row_count(
+    "--rows",
+    "Number of rows in the synthetic file.",
+    10000000 );
+  vul_arg< unsigned > track_count(
+    "--tracks",
+    "Number of tracks in the synthetic file, one row per track per frame.",
+    1000 );
+  vul_arg< unsigned > threads(
+    "--threads",
+    "Core budget of the compute pool, 0 for the default.",
+    0 );
+  vul_arg< bool > compare_stream(
+    "--compare-stream",
+    "Also time tokenizing the file through a filtered stream.",
+    false );
+
+  vul_arg_parse( argc, argv );
+
+  compute_pool::instance()->set_core_budget( threads() );
+
+  std::string filename = input();
+  const bool generated = filename.empty();
+
+  if( generated )
+  {
+    filename = output_dir() + "/kw18_reader_benchmark.kw18";
+
+    vul_timer write_timer;
+
+    if( !write_kw18( filename, row_count(), std::max( 1u, track_count() ) ) )
+    {
+      LOG_ERROR( "Unable to write " << filename );
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Wrote " << row_count() << " rows in "
+              << write_timer.real() << " ms" << std::endl;
+  }
+
+  std::cout << "Core budget " << compute_pool::instance()->core_budget() << std::endl;
+  std::cout << std::setw( 16 ) << "reader"
+            << std::setw( 14 ) << "read ms"
+            << std::setw( 14 ) << "items" << std::endl;
+
+  {
+    vul_timer timer;
+
+    track_reader reader( filename );
+    track::vector_t tracks;
+
+    if( !reader.open() )
+    {
+      LOG_ERROR( "Unable to read tracks from " << filename );
+      return EXIT_FAILURE;
+    }
+
+    reader.read_all( tracks );
+
+    size_t states = 0;
+    for( size_t i = 0; i < tracks.size(); ++i )
+    {
+      states += tracks[i]->history().size();
+    }
+
+    std::cout << std::setw( 16 ) << "tracks"
+              << std::setw( 14 ) << timer.real()
+              << std::setw( 14 ) << states << std::endl;
+  }
+
+  {
+    vul_timer timer;
+
+    image_object_reader reader( filename );
+    image_object_reader::object_vector_t objects;
+
+    if( !reader.open() )
+    {
+      LOG_ERROR( "Unable to read image objects from " << filename );
+      return EXIT_FAILURE;
+    }
+
+    reader.read_all( objects );
+
+    std::cout << std::setw( 16 ) << "image objects"
+              << std::setw( 14 ) << timer.real()
+              << std::setw( 14 ) << objects.size() << std::endl;
+  }
+
+  if( compare_stream() )
+  {
+    vul_timer timer;
+
+    const size_t rows = read_with_stream( filename );
+
+    std::cout << std::setw( 16 ) << "stream tokenize"
+              << std::setw( 14 ) << timer.real()
+              << std::setw( 14 ) << rows << std::endl;
+  }
+
+  if( generated )
+  {
+    vul_file::delete_file_glob( filename );
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -41,6 +41,8 @@ void construct_pipeline( async_pipeline& p )
              burnin_remover->set_image_port() );
   p.connect( frame_source->timestamp_port(),
              burnin_remover->set_timestamp_port() );
+  p.connect( frame_source->luma_image_port(),
+             burnin_remover->set_luma_image_port() );
 }
 
 int run_pipeline( async_pipeline& p, config_block& config )